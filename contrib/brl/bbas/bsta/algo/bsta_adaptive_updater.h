@@ -78,6 +78,8 @@ class bsta_mg_adaptive_updater
   }
 
   //: A model for new Gaussians inserted
+  //  Its mean is set to each sample inserted, so const calls change it and
+  //  an updater must not be shared between threads; give each thread a copy.
   mutable obs_gaussian_ init_gaussian_;
   //: The maximum number of components in the mixture
   unsigned int max_components_;
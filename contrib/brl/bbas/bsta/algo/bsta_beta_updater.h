@@ -196,6 +196,7 @@ class bsta_mix_beta_updater
   }
 
   //: A model for new beta inserted
+  //  Set for each sample inserted, so give each thread its own updater
   mutable obs_dist_ init_dist_;
   //: The maximum number of components in the mixture
   unsigned int max_components_;
@@ -17,6 +17,7 @@
 
 #include "bbgm_image_of.h"
 #include "bbgm_planes_to_sample.h"
+#include "bbgm_parallel.h"
 #include <vpdl/vpdt/vpdt_field_traits.h>
 
 //: Apply the functor at every pixel
@@ -29,6 +30,16 @@ struct bbgm_apply_no_data
                            const functor_& functor,
                            vil_image_view<T>& result,
                            const T* fail_val = 0 )
+  {
+    apply(dimg, functor, result, fail_val, vil_parallel_policy(1));
+  }
+
+  //: Apply the functor, splitting the rows between threads
+  static inline void apply(const bbgm_image_of<dist_>& dimg,
+                           const functor_& functor,
+                           vil_image_view<T>& result,
+                           const T* fail_val,
+                           const vil_parallel_policy& policy)
   {
     typedef typename functor_::return_type return_T;
 
@@ -40,15 +51,33 @@ struct bbgm_apply_no_data
       return;
 
     result.set_size(ni,nj,np);
+    bbgm_run_rows(bbgm_apply_no_data(dimg,functor,result,fail_val), nj, 0, policy);
+  }
+
+  bbgm_apply_no_data(const bbgm_image_of<dist_>& d, const functor_& f,
+                     vil_image_view<T>& r, const T* fv)
+    : dimg_(d), functor_obj_(f), result_(r), fail_val_(fv) {}
+
+  //: Apply the functor to rows [j0,j1), the result having its size already
+  void operator()(unsigned j0, unsigned j1) const
+  {
+    typedef typename functor_::return_type return_T;
 
-    const std::ptrdiff_t planestep = result.planestep();
-    const std::ptrdiff_t istep = result.istep();
-    const std::ptrdiff_t jstep = result.jstep();
+    const unsigned ni = dimg_.ni();
+    const unsigned np = vpdt_field_traits<return_T>::dimension;
+    if (ni==0 || j0>=j1)
+      return;
+
+    const functor_& functor = functor_obj_;
+    const T* fail_val = fail_val_;
+    const std::ptrdiff_t planestep = result_.planestep();
+    const std::ptrdiff_t istep = result_.istep();
+    const std::ptrdiff_t jstep = result_.jstep();
 
     return_T temp_val;
-    typename bbgm_image_of<dist_>::const_iterator itr = dimg.begin();
-    T* row = result.top_left_ptr();
-    for (unsigned int j=0; j<nj; ++j, row+=jstep) {
+    typename bbgm_image_of<dist_>::const_iterator itr(&dimg_(0,j0));
+    T* row = result_.top_left_ptr() + std::ptrdiff_t(j0)*jstep;
+    for (unsigned int j=j0; j<j1; ++j, row+=jstep) {
       T* col = row;
       for (unsigned int i=0; i<ni; ++i, col+=istep, ++itr) {
         T* data = col;
@@ -67,6 +96,11 @@ struct bbgm_apply_no_data
       }
     }
   }
+
+  const bbgm_image_of<dist_>& dimg_;
+  const functor_& functor_obj_;
+  vil_image_view<T>& result_;
+  const T* fail_val_;
 };
 
 
@@ -78,8 +112,16 @@ struct bbgm_apply_no_data<dist_,functor_,T,true>
                            vil_image_view<T>& result,
                            const T* fail_val = 0 )
   {
-    typedef typename functor_::return_type return_T;
+    apply(dimg, functor, result, fail_val, vil_parallel_policy(1));
+  }
 
+  //: Apply the functor, splitting the rows between threads
+  static inline void apply(const bbgm_image_of<dist_>& dimg,
+                           const functor_& functor,
+                           vil_image_view<T>& result,
+                           const T* fail_val,
+                           const vil_parallel_policy& policy)
+  {
     const unsigned ni = dimg.ni();
     const unsigned nj = dimg.nj();
 
@@ -87,13 +129,31 @@ struct bbgm_apply_no_data<dist_,functor_,T,true>
       return;
 
     result.set_size(ni,nj,1);
-    const std::ptrdiff_t istep = result.istep();
-    const std::ptrdiff_t jstep = result.jstep();
+    bbgm_run_rows(bbgm_apply_no_data(dimg,functor,result,fail_val), nj, 0, policy);
+  }
+
+  bbgm_apply_no_data(const bbgm_image_of<dist_>& d, const functor_& f,
+                     vil_image_view<T>& r, const T* fv)
+    : dimg_(d), functor_obj_(f), result_(r), fail_val_(fv) {}
+
+  //: Apply the functor to rows [j0,j1), the result having its size already
+  void operator()(unsigned j0, unsigned j1) const
+  {
+    typedef typename functor_::return_type return_T;
+
+    const unsigned ni = dimg_.ni();
+    if (ni==0 || j0>=j1)
+      return;
+
+    const functor_& functor = functor_obj_;
+    const T* fail_val = fail_val_;
+    const std::ptrdiff_t istep = result_.istep();
+    const std::ptrdiff_t jstep = result_.jstep();
 
     return_T temp_val = return_T(0); // dummy initialisation, to avoid compiler warning; return_T could be bool, though...
-    typename bbgm_image_of<dist_>::const_iterator itr = dimg.begin();
-    T* row = result.top_left_ptr();
-    for (unsigned int j=0; j<nj; ++j, row+=jstep) {
+    typename bbgm_image_of<dist_>::const_iterator itr(&dimg_(0,j0));
+    T* row = result_.top_left_ptr() + std::ptrdiff_t(j0)*jstep;
+    for (unsigned int j=j0; j<j1; ++j, row+=jstep) {
       T* col = row;
       for (unsigned int i=0; i<ni; ++i, col+=istep, ++itr) {
         if (functor(*itr, temp_val))
@@ -103,6 +163,11 @@ struct bbgm_apply_no_data<dist_,functor_,T,true>
       }
     }
   }
+
+  const bbgm_image_of<dist_>& dimg_;
+  const functor_& functor_obj_;
+  vil_image_view<T>& result_;
+  const T* fail_val_;
 };
 
 //: Apply without data
@@ -117,6 +182,19 @@ void bbgm_apply(const bbgm_image_of<dist_>& dimg,
       apply(dimg,functor,result,fail_val);
 }
 
+//: Apply without data, splitting the rows between threads
+template <class dist_, class functor_, class T>
+void bbgm_apply(const bbgm_image_of<dist_>& dimg,
+                const functor_& functor,
+                vil_image_view<T>& result,
+                const T* fail_val,
+                const vil_parallel_policy& policy)
+{
+  typedef vpdt_field_traits<typename functor_::return_type> return_traits;
+  bbgm_apply_no_data<dist_,functor_,T,return_traits::dimension == 1>::
+      apply(dimg,functor,result,fail_val,policy);
+}
+
 
 //: Apply the functor at every pixel
 //  \returns an image of results, each vector component in a separate plane
@@ -129,6 +207,17 @@ struct bbgm_apply_data
                            const vil_image_view<dT>& data,
                            vil_image_view<rT>& result,
                            const rT* fail_val = 0 )
+  {
+    apply(dimg, functor, data, result, fail_val, vil_parallel_policy(1));
+  }
+
+  //: Apply the functor, splitting the rows between threads
+  static inline void apply(const bbgm_image_of<dist_>& dimg,
+                           const functor_& functor,
+                           const vil_image_view<dT>& data,
+                           vil_image_view<rT>& result,
+                           const rT* fail_val,
+                           const vil_parallel_policy& policy)
   {
     typedef typename functor_::return_type return_T;
     typedef typename dist_::field_type F;
@@ -142,19 +231,40 @@ struct bbgm_apply_data
     assert(data.nplanes() == d_np);
 
     result.set_size(ni,nj,r_np);
-    const std::ptrdiff_t r_istep = result.istep();
-    const std::ptrdiff_t r_jstep = result.jstep();
-    const std::ptrdiff_t r_pstep = result.planestep();
-    const std::ptrdiff_t d_istep = data.istep();
-    const std::ptrdiff_t d_jstep = data.jstep();
-    const std::ptrdiff_t d_pstep = data.planestep();
+    bbgm_run_rows(bbgm_apply_data(dimg,functor,data,result,fail_val), nj, 0, policy);
+  }
+
+  bbgm_apply_data(const bbgm_image_of<dist_>& d, const functor_& f,
+                  const vil_image_view<dT>& dt, vil_image_view<rT>& r, const rT* fv)
+    : dimg_(d), functor_obj_(f), data_(dt), result_(r), fail_val_(fv) {}
+
+  //: Apply the functor to rows [j0,j1), the result having its size already
+  void operator()(unsigned j0, unsigned j1) const
+  {
+    typedef typename functor_::return_type return_T;
+    typedef typename dist_::field_type F;
+
+    const unsigned ni = dimg_.ni();
+    const unsigned d_np = vpdt_field_traits<F>::dimension;
+    const unsigned r_np = vpdt_field_traits<return_T>::dimension;
+    if (ni==0 || j0>=j1)
+      return;
+
+    const functor_& functor = functor_obj_;
+    const rT* fail_val = fail_val_;
+    const std::ptrdiff_t r_istep = result_.istep();
+    const std::ptrdiff_t r_jstep = result_.jstep();
+    const std::ptrdiff_t r_pstep = result_.planestep();
+    const std::ptrdiff_t d_istep = data_.istep();
+    const std::ptrdiff_t d_jstep = data_.jstep();
+    const std::ptrdiff_t d_pstep = data_.planestep();
 
     return_T temp_val;
     F sample;
-    typename bbgm_image_of<dist_>::const_iterator itr = dimg.begin();
-    rT* r_row = result.top_left_ptr();
-    const dT* d_row = data.top_left_ptr();
-    for (unsigned int j=0; j<nj; ++j, d_row+=d_jstep, r_row+=r_jstep) {
+    typename bbgm_image_of<dist_>::const_iterator itr(&dimg_(0,j0));
+    rT* r_row = result_.top_left_ptr() + std::ptrdiff_t(j0)*r_jstep;
+    const dT* d_row = data_.top_left_ptr() + std::ptrdiff_t(j0)*d_jstep;
+    for (unsigned int j=j0; j<j1; ++j, d_row+=d_jstep, r_row+=r_jstep) {
       rT* r_col = r_row;
       const dT* d_col = d_row;
       for (unsigned int i=0; i<ni; ++i, d_col+=d_istep, r_col+=r_istep, ++itr) {
@@ -173,6 +283,12 @@ struct bbgm_apply_data
       }
     }
   }
+
+  const bbgm_image_of<dist_>& dimg_;
+  const functor_& functor_obj_;
+  const vil_image_view<dT>& data_;
+  vil_image_view<rT>& result_;
+  const rT* fail_val_;
 };
 
 
@@ -185,7 +301,17 @@ struct bbgm_apply_data<dist_,functor_,dT,rT,true>
                            vil_image_view<rT>& result,
                            const rT* fail_val = 0 )
   {
-    typedef typename functor_::return_type return_T;
+    apply(dimg, functor, data, result, fail_val, vil_parallel_policy(1));
+  }
+
+  //: Apply the functor, splitting the rows between threads
+  static inline void apply(const bbgm_image_of<dist_>& dimg,
+                           const functor_& functor,
+                           const vil_image_view<dT>& data,
+                           vil_image_view<rT>& result,
+                           const rT* fail_val,
+                           const vil_parallel_policy& policy)
+  {
     typedef typename dist_::field_type F;
     const unsigned int data_dim = vpdt_field_traits<F>::dimension;
 
@@ -197,18 +323,37 @@ struct bbgm_apply_data<dist_,functor_,dT,rT,true>
     assert(data.nplanes() == d_np);
 
     result.set_size(ni,nj,1);
-    const std::ptrdiff_t r_istep = result.istep();
-    const std::ptrdiff_t r_jstep = result.jstep();
-    const std::ptrdiff_t d_istep = data.istep();
-    const std::ptrdiff_t d_jstep = data.jstep();
-    const std::ptrdiff_t d_pstep = data.planestep();
+    bbgm_run_rows(bbgm_apply_data(dimg,functor,data,result,fail_val), nj, 0, policy);
+  }
+
+  bbgm_apply_data(const bbgm_image_of<dist_>& d, const functor_& f,
+                  const vil_image_view<dT>& dt, vil_image_view<rT>& r, const rT* fv)
+    : dimg_(d), functor_obj_(f), data_(dt), result_(r), fail_val_(fv) {}
+
+  //: Apply the functor to rows [j0,j1), the result having its size already
+  void operator()(unsigned j0, unsigned j1) const
+  {
+    typedef typename functor_::return_type return_T;
+    typedef typename dist_::field_type F;
+
+    const unsigned ni = dimg_.ni();
+    if (ni==0 || j0>=j1)
+      return;
+
+    const functor_& functor = functor_obj_;
+    const rT* fail_val = fail_val_;
+    const std::ptrdiff_t r_istep = result_.istep();
+    const std::ptrdiff_t r_jstep = result_.jstep();
+    const std::ptrdiff_t d_istep = data_.istep();
+    const std::ptrdiff_t d_jstep = data_.jstep();
+    const std::ptrdiff_t d_pstep = data_.planestep();
 
     return_T temp_val;
     F sample;
-    typename bbgm_image_of<dist_>::const_iterator itr = dimg.begin();
-    rT* r_row = result.top_left_ptr();
-    const dT* d_row = data.top_left_ptr();
-    for (unsigned int j=0; j<nj; ++j, d_row+=d_jstep, r_row+=r_jstep) {
+    typename bbgm_image_of<dist_>::const_iterator itr(&dimg_(0,j0));
+    rT* r_row = result_.top_left_ptr() + std::ptrdiff_t(j0)*r_jstep;
+    const dT* d_row = data_.top_left_ptr() + std::ptrdiff_t(j0)*d_jstep;
+    for (unsigned int j=j0; j<j1; ++j, d_row+=d_jstep, r_row+=r_jstep) {
       rT* r_col = r_row;
       const dT* d_col = d_row;
       for (unsigned int i=0; i<ni; ++i, d_col+=d_istep, r_col+=r_istep, ++itr) {
@@ -221,6 +366,12 @@ struct bbgm_apply_data<dist_,functor_,dT,rT,true>
       }
     }
   }
+
+  const bbgm_image_of<dist_>& dimg_;
+  const functor_& functor_obj_;
+  const vil_image_view<dT>& data_;
+  vil_image_view<rT>& result_;
+  const rT* fail_val_;
 };
 
 
@@ -237,5 +388,19 @@ void bbgm_apply(const bbgm_image_of<dist_>& dimg,
       apply(dimg,functor,data,result,fail_val);
 }
 
+//: Apply with data, splitting the rows between threads
+template <class dist_, class functor_, class dT, class rT>
+void bbgm_apply(const bbgm_image_of<dist_>& dimg,
+                const functor_& functor,
+                const vil_image_view<dT>& data,
+                vil_image_view<rT>& result,
+                const rT* fail_val,
+                const vil_parallel_policy& policy)
+{
+  typedef vpdt_field_traits<typename functor_::return_type> return_traits;
+  bbgm_apply_data<dist_,functor_,dT,rT,return_traits::dimension == 1>::
+      apply(dimg,functor,data,result,fail_val,policy);
+}
+
 
 #endif // bbgm_apply_h_
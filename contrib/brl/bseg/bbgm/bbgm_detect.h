@@ -17,19 +17,102 @@
 #include <vil/vil_image_view.h>
 #include "bbgm_image_of.h"
 #include "bbgm_planes_to_sample.h"
+#include "bbgm_parallel.h"
 #include <bsta/bsta_detector_mixture.h>
 #include <vcl_cassert.h>
 
-//: For each pixel, detect at all \a se neighbors in bbgm_image
+//: Detects at rows [j0,j1) at all \a se neighbors in a distribution image
+//  Only where mask(i,j), if a mask is given.
+template <class dist_, class detector_, class dT>
+struct bbgm_detect_se_rows
+{
+  bbgm_detect_se_rows(bbgm_image_of<dist_>& d, const vil_image_view<dT>& dt,
+                      vil_image_view<bool>& r, const detector_& det,
+                      const vil_structuring_element& se, const vil_image_view<bool>* m)
+    : dimg_(d), data_(dt), result_(r), detector_obj_(det), se_(se), mask_(m) {}
+
+  void operator()(unsigned j0, unsigned j1) const
+  {
+    typedef typename dist_::field_type F;
+
+    const unsigned ni = dimg_.ni();
+    const unsigned nj = dimg_.nj();
+    const unsigned d_np = vpdt_field_traits<F>::dimension;
+    if (ni==0 || j0>=j1)
+      return;
+
+    const detector_& detector = detector_obj_;
+    const vil_structuring_element& se = se_;
+    const std::ptrdiff_t r_istep = result_.istep();
+    const std::ptrdiff_t r_jstep = result_.jstep();
+    const std::ptrdiff_t d_istep = data_.istep();
+    const std::ptrdiff_t d_jstep = data_.jstep();
+    const std::ptrdiff_t d_pstep = data_.planestep();
+    const std::ptrdiff_t m_istep = mask_ ? mask_->istep() : 0;
+    const std::ptrdiff_t m_jstep = mask_ ? mask_->jstep() : 0;
+
+    const unsigned size_se = se.p_i().size();
+
+    bool temp_val;
+    F sample;
+    bool* r_row = result_.top_left_ptr() + std::ptrdiff_t(j0)*r_jstep;
+    const dT* d_row = data_.top_left_ptr() + std::ptrdiff_t(j0)*d_jstep;
+    const bool* m_row = mask_ ? mask_->top_left_ptr() + std::ptrdiff_t(j0)*m_jstep : VXL_NULLPTR;
+    for (unsigned int j=j0; j<j1; ++j, d_row+=d_jstep, r_row+=r_jstep, m_row+=m_jstep){
+      bool* r_col = r_row;
+      const dT* d_col = d_row;
+      const bool* m_col = m_row;
+      for (unsigned int i=0; i<ni; ++i, d_col+=d_istep, r_col+=r_istep, m_col+=m_istep){
+        if (m_col && !*m_col)
+          continue;
+        bool& detected = *r_col;
+        const dT* d_plane = d_col;
+        for (unsigned int k=0; k<d_np; ++k, d_plane+=d_pstep)
+          sample[k] = *d_plane;
+        detected = false;
+        for (unsigned int k=0; k<size_se; ++k){
+          int ri = static_cast<int>(i)+se.p_i()[k];
+          int rj = static_cast<int>(j)+se.p_j()[k];
+          if (ri < 0 || ri >= static_cast<int>(ni) ||
+              rj < 0 || rj >= static_cast<int>(nj) )
+            continue;
+          if (detector(dimg_(ri,rj), sample, temp_val) && temp_val){
+            detected = true;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  //: The number of rows above or below a pixel at which it is detected
+  static unsigned halo(const vil_structuring_element& se)
+  {
+    const int h = se.max_j() > -se.min_j() ? se.max_j() : -se.min_j();
+    return h > 0 ? unsigned(h) : 0;
+  }
+
+  bbgm_image_of<dist_>& dimg_;
+  const vil_image_view<dT>& data_;
+  vil_image_view<bool>& result_;
+  const detector_& detector_obj_;
+  const vil_structuring_element& se_;
+  const vil_image_view<bool>* mask_;
+};
+
+
+//: For each pixel, detect at all \a se neighbors in bbgm_image, splitting the rows between threads
 //  \returns true if detection succeeds at any neighbor
 template <class dist_, class detector_, class dT>
 void detect(bbgm_image_of<dist_>& dimg,
             const vil_image_view<dT>& data,
             vil_image_view<bool>& result,
             const detector_& detector,
-            const vil_structuring_element& se)
+            const vil_structuring_element& se,
+            const vil_parallel_policy& policy)
 {
   typedef typename dist_::field_type F;
+  typedef bbgm_detect_se_rows<dist_,detector_,dT> rows_op;
 
   const unsigned ni = dimg.ni();
   const unsigned nj = dimg.nj();
@@ -39,43 +122,25 @@ void detect(bbgm_image_of<dist_>& dimg,
   assert(data.nplanes() == d_np);
 
   result.set_size(ni,nj,1);
-  const std::ptrdiff_t r_istep = result.istep();
-  const std::ptrdiff_t r_jstep = result.jstep();
-  const std::ptrdiff_t d_istep = data.istep();
-  const std::ptrdiff_t d_jstep = data.jstep();
-  const std::ptrdiff_t d_pstep = data.planestep();
-
-  const unsigned size_se = se.p_i().size();
-
-  bool temp_val;
-  F sample;
-  bool* r_row = result.top_left_ptr();
-  const dT* d_row = data.top_left_ptr();
-  for (unsigned int j=0; j<nj; ++j, d_row+=d_jstep, r_row+=r_jstep){
-    bool* r_col = r_row;
-    const dT* d_col = d_row;
-    for (unsigned int i=0; i<ni; ++i, d_col+=d_istep, r_col+=r_istep){
-      bool& detected = *r_col;
-      const dT* d_plane = d_col;
-      for (unsigned int k=0; k<d_np; ++k, d_plane+=d_pstep)
-        sample[k] = *d_plane;
-      detected = false;
-      for (unsigned int k=0; k<size_se; ++k){
-        int ri = static_cast<int>(i)+se.p_i()[k];
-        int rj = static_cast<int>(j)+se.p_j()[k];
-        if (ri < 0 || ri >= static_cast<int>(ni) ||
-            rj < 0 || rj >= static_cast<int>(nj) )
-          continue;
-        if (detector(dimg(ri,rj), sample, temp_val) && temp_val){
-          detected = true;
-          break;
-        }
-      }
-    }
-  }
+  bbgm_run_rows(rows_op(dimg,data,result,detector,se,VXL_NULLPTR),
+                nj, rows_op::halo(se), policy);
 }
 
-//: For each masked pixel, detect at all \a se neighbors in bbgm_image
+
+//: For each pixel, detect at all \a se neighbors in bbgm_image
+//  \returns true if detection succeeds at any neighbor
+template <class dist_, class detector_, class dT>
+void detect(bbgm_image_of<dist_>& dimg,
+            const vil_image_view<dT>& data,
+            vil_image_view<bool>& result,
+            const detector_& detector,
+            const vil_structuring_element& se)
+{
+  detect(dimg, data, result, detector, se, vil_parallel_policy(1));
+}
+
+
+//: For each masked pixel, detect at all \a se neighbors in bbgm_image, splitting the rows between threads
 // \returns true if detection succeeds at any neighbor
 template <class dist_, class detector_, class dT>
 void detect_masked(bbgm_image_of<dist_>& dimg,
@@ -83,9 +148,11 @@ void detect_masked(bbgm_image_of<dist_>& dimg,
                    vil_image_view<bool>& result,
                    const detector_& detector,
                    const vil_structuring_element& se,
-                   const vil_image_view<bool>& mask)
+                   const vil_image_view<bool>& mask,
+                   const vil_parallel_policy& policy)
 {
   typedef typename dist_::field_type F;
+  typedef bbgm_detect_se_rows<dist_,detector_,dT> rows_op;
 
   const unsigned ni = dimg.ni();
   const unsigned nj = dimg.nj();
@@ -97,58 +164,139 @@ void detect_masked(bbgm_image_of<dist_>& dimg,
   assert(mask.nj() == nj);
 
   result.set_size(ni,nj,1);
-  const std::ptrdiff_t r_istep = result.istep();
-  const std::ptrdiff_t r_jstep = result.jstep();
-  const std::ptrdiff_t d_istep = data.istep();
-  const std::ptrdiff_t d_jstep = data.jstep();
-  const std::ptrdiff_t d_pstep = data.planestep();
-  const std::ptrdiff_t m_istep = mask.istep();
-  const std::ptrdiff_t m_jstep = mask.jstep();
-
-  const unsigned size_se = se.p_i().size();
-
-  bool temp_val;
-  F sample;
-  bool* r_row = result.top_left_ptr();
-  const dT* d_row = data.top_left_ptr();
-  const bool* m_row = mask.top_left_ptr();
-  for (unsigned int j=0; j<nj; ++j, d_row+=d_jstep, r_row+=r_jstep, m_row+=m_jstep){
-    bool* r_col = r_row;
-    const dT* d_col = d_row;
-    const bool* m_col = m_row;
-    for (unsigned int i=0; i<ni; ++i, d_col+=d_istep, r_col+=r_istep, m_col+=m_istep){
-      if (!*m_col)
-        continue;
-      bool& detected = *r_col;
-      const dT* d_plane = d_col;
-      for (unsigned int k=0; k<d_np; ++k, d_plane+=d_pstep)
-        sample[k] = *d_plane;
-      detected = false;
-      for (unsigned int k=0; k<size_se; ++k){
-        int ri = static_cast<int>(i)+se.p_i()[k];
-        int rj = static_cast<int>(j)+se.p_j()[k];
-        if (ri < 0 || ri >= ni || rj < 0 || rj >= nj)
-          continue;
-        if (detector(dimg(ri,rj), sample, temp_val) && temp_val){
-          detected = true;
-          break;
+  bbgm_run_rows(rows_op(dimg,data,result,detector,se,&mask),
+                nj, rows_op::halo(se), policy);
+}
+
+
+//: For each masked pixel, detect at all \a se neighbors in bbgm_image
+// \returns true if detection succeeds at any neighbor
+template <class dist_, class detector_, class dT>
+void detect_masked(bbgm_image_of<dist_>& dimg,
+                   const vil_image_view<dT>& data,
+                   vil_image_view<bool>& result,
+                   const detector_& detector,
+                   const vil_structuring_element& se,
+                   const vil_image_view<bool>& mask)
+{
+  detect_masked(dimg, data, result, detector, se, mask, vil_parallel_policy(1));
+}
+
+
+//: Detects at rows [j0,j1) with the samples within \a rad of each pixel
+//  Where a mask is given, only masked samples are used, and the result
+//  is true at pixels which are not masked.
+template <class dist_, class detector_>
+struct bbgm_detect_rad_rows
+{
+  typedef typename dist_::math_type T;
+
+  bbgm_detect_rad_rows(bbgm_image_of<dist_>& d, const vil_image_view<T>& im,
+                       vil_image_view<bool>& r, const detector_& det, int rad,
+                       const vil_image_view<bool>* m)
+    : dimg_(d), image_(im), result_(r), detector_obj_(det), rad_(rad), mask_(m) {}
+
+  void operator()(unsigned j0, unsigned j1) const
+  {
+    typedef typename dist_::vector_type vector_;
+
+    const unsigned ni = dimg_.ni();
+    const unsigned nj = dimg_.nj();
+    if (ni==0 || j0>=j1)
+      return;
+
+    const detector_& detector = detector_obj_;
+    const vil_image_view<T>& image = image_;
+    const int rad = rad_;
+    const std::ptrdiff_t r_istep = result_.istep();
+    const std::ptrdiff_t r_jstep = result_.jstep();
+    const std::ptrdiff_t d_pstep = image.planestep();
+
+    bool temp_val;
+    vector_ sample;
+
+    typename bbgm_image_of<dist_>::iterator itr(&dimg_(0,j0));
+    bool* r_row = result_.top_left_ptr() + std::ptrdiff_t(j0)*r_jstep;
+    if (!mask_) {
+      for ( int j=j0; j<int(j1); ++j, r_row+=r_jstep){
+        bool* r_col = r_row;
+        for ( int i=0; i<int(ni); ++i, r_col+=r_istep, ++itr){
+          bool flag=false;
+          for (int l=-rad;l<=rad;l++)
+          {
+            for (int k=-rad;k<=rad;k++)
+            {
+              if (l+i>=0 && l+i<int(ni) && k+j>=0 && k+j<int(nj))
+              {
+                const T * d_plane=&image(l+i,k+j);
+                bbgm_planes_to_sample<T,vector_,dist_::dimension>::apply(d_plane,sample,d_pstep);
+                if (detector(*itr, sample, temp_val))
+                  if (temp_val)
+                    flag=true;
+              }
+            }
+          }
+          *r_col=flag;
+        }
+      }
+      return;
+    }
+
+    const vil_image_view<bool>& mask = *mask_;
+    const std::ptrdiff_t m_istep = mask.istep();
+    const std::ptrdiff_t m_jstep = mask.jstep();
+    const bool* m_row = mask.top_left_ptr() + std::ptrdiff_t(j0)*m_jstep;
+    for ( int j=j0; j<int(j1); ++j, r_row+=r_jstep, m_row+=m_jstep){
+      bool* r_col = r_row;
+      const bool* m_col = m_row;
+      for ( int i=0; i<int(ni); ++i, r_col+=r_istep, m_col+=m_istep, ++itr)
+      {
+        if (*m_col)
+        {
+          bool flag=false;
+          for (int l=-rad;l<=rad;l++)
+          {
+            for (int k=-rad;k<=rad;k++)
+            {
+              if (l+i>=0 && l+i<int(ni) && k+j>=0 && k+j<int(nj))
+              {
+                if (mask(l+i,k+j))
+                {
+                  const T * d_plane=&image(l+i,k+j);
+                  bbgm_planes_to_sample<T,vector_,dist_::dimension>::apply(d_plane,sample,d_pstep);
+                  if (detector(*itr, sample, temp_val))
+                    if (temp_val)
+                      flag=true;
+                }
+              }
+            }
+          }
+          *r_col=flag;
         }
+        else
+          *r_col=true;
       }
     }
   }
-}
+
+  bbgm_image_of<dist_>& dimg_;
+  const vil_image_view<T>& image_;
+  vil_image_view<bool>& result_;
+  const detector_& detector_obj_;
+  int rad_;
+  const vil_image_view<bool>* mask_;
+};
 
 
+//: For each pixel, detect with the samples within \a rad of it, splitting the rows between threads
 template <class dist_, class detector_>
 void detect(bbgm_image_of<dist_>& dimg,
             const vil_image_view<typename dist_::math_type>& image,
             vil_image_view<bool>& result,
             const detector_& detector,
-            int rad)
+            int rad,
+            const vil_parallel_policy& policy)
 {
-    typedef typename dist_::vector_type vector_;
-    typedef typename dist_::math_type T;
-
     const unsigned ni = dimg.ni();
     const unsigned nj = dimg.nj();
     const unsigned d_np = dist_::dimension;
@@ -157,54 +305,31 @@ void detect(bbgm_image_of<dist_>& dimg,
     assert(image.nplanes() == d_np);
 
     result.set_size(ni,nj,1);
+    bbgm_run_rows(bbgm_detect_rad_rows<dist_,detector_>(dimg,image,result,detector,rad,VXL_NULLPTR),
+                  nj, 0, policy);
+}
 
-    const std::ptrdiff_t r_istep = result.istep();
-    const std::ptrdiff_t r_jstep = result.jstep();
-    const std::ptrdiff_t d_istep = image.istep();
-    const std::ptrdiff_t d_jstep = image.jstep();
-    const std::ptrdiff_t d_pstep = image.planestep();
-
-    bool temp_val;
-    vector_ sample;
 
-    typename bbgm_image_of<dist_>::iterator itr = dimg.begin();
-    bool* r_row = result.top_left_ptr();
-    const T* d_row = image.top_left_ptr();
-    for ( int j=0; j<nj; ++j, d_row+=d_jstep, r_row+=r_jstep){
-        bool* r_col = r_row;
-        const T* d_col = d_row;
-        for ( int i=0; i<ni; ++i, d_col+=d_istep, r_col+=r_istep, ++itr){
-            bool flag=false;
-            for (int l=-rad;l<=rad;l++)
-            {
-                for (int k=-rad;k<=rad;k++)
-                {
-                    if (l+i>=0 && l+i<ni && k+j>=0 && k+j<nj)
-                    {
-                        const T * d_plane=&image(l+i,k+j);
-                        bbgm_planes_to_sample<T,vector_,dist_::dimension>::apply(d_plane,sample,d_pstep);
-                        if (detector(*itr, sample, temp_val))
-                            if (temp_val)
-                                flag=true;
-                    }
-                }
-            }
-            *r_col=flag;
-        }
-    }
+template <class dist_, class detector_>
+void detect(bbgm_image_of<dist_>& dimg,
+            const vil_image_view<typename dist_::math_type>& image,
+            vil_image_view<bool>& result,
+            const detector_& detector,
+            int rad)
+{
+    detect(dimg, image, result, detector, rad, vil_parallel_policy(1));
 }
 
 
+//: For each masked pixel, detect with the masked samples within \a rad of it, splitting the rows between threads
 template <class dist_, class detector_>
 void detect_masked(bbgm_image_of<dist_>& dimg,
                    const vil_image_view<typename dist_::math_type>& image,
                    vil_image_view<bool>& result,
                    const detector_& detector,
-                   int rad,vil_image_view<bool>& mask)
+                   int rad,vil_image_view<bool>& mask,
+                   const vil_parallel_policy& policy)
 {
-    typedef typename dist_::vector_type vector_;
-    typedef typename dist_::math_type T;
-
     const unsigned ni = dimg.ni();
     const unsigned nj = dimg.nj();
     const unsigned d_np = dist_::dimension;
@@ -213,72 +338,92 @@ void detect_masked(bbgm_image_of<dist_>& dimg,
     assert(image.nplanes() == d_np);
 
     result.set_size(ni,nj,1);
+    bbgm_run_rows(bbgm_detect_rad_rows<dist_,detector_>(dimg,image,result,detector,rad,&mask),
+                  nj, 0, policy);
+}
 
-    const std::ptrdiff_t r_istep = result.istep();
-    const std::ptrdiff_t r_jstep = result.jstep();
-    const std::ptrdiff_t d_istep = image.istep();
-    const std::ptrdiff_t d_jstep = image.jstep();
-    const std::ptrdiff_t d_pstep = image.planestep();
 
-    const std::ptrdiff_t m_istep = mask.istep();
-    const std::ptrdiff_t m_jstep = mask.jstep();
+template <class dist_, class detector_>
+void detect_masked(bbgm_image_of<dist_>& dimg,
+                   const vil_image_view<typename dist_::math_type>& image,
+                   vil_image_view<bool>& result,
+                   const detector_& detector,
+                   int rad,vil_image_view<bool>& mask)
+{
+    detect_masked(dimg, image, result, detector, rad, mask, vil_parallel_policy(1));
+}
 
 
-    bool temp_val;
-    vector_ sample;
+//: Detects at rows [j0,j1) where mask(i,j), leaving the result unchanged where detection fails
+template <class dist_, class detector_, class rT>
+struct bbgm_detect_masked_rows
+{
+  typedef typename dist_::math_type T;
 
-    typename bbgm_image_of<dist_>::iterator itr = dimg.begin();
-    bool* r_row = result.top_left_ptr();
-    const T* d_row = image.top_left_ptr();
-    bool * m_row = mask.top_left_ptr();
+  bbgm_detect_masked_rows(bbgm_image_of<dist_>& d, const vil_image_view<T>& im,
+                          vil_image_view<rT>& r, const vil_image_view<rT>& m,
+                          const detector_& det)
+    : dimg_(d), image_(im), result_(r), mask_(m), detector_obj_(det) {}
 
-    for ( int j=0; j<nj; ++j, d_row+=d_jstep, r_row+=r_jstep,m_row+=m_jstep){
-        bool* r_col = r_row;
-        const T* d_col = d_row;
-        bool * m_col = m_row;
+  void operator()(unsigned j0, unsigned j1) const
+  {
+    typedef typename dist_::vector_type vector_;
 
-        for ( int i=0; i<ni; ++i, d_col+=d_istep, r_col+=r_istep,m_col+=m_istep, ++itr)
+    const unsigned ni = dimg_.ni();
+    if (ni==0 || j0>=j1)
+      return;
+
+    const detector_& detector = detector_obj_;
+    const std::ptrdiff_t r_istep = result_.istep();
+    const std::ptrdiff_t r_jstep = result_.jstep();
+
+    const std::ptrdiff_t m_istep = mask_.istep();
+    const std::ptrdiff_t m_jstep = mask_.jstep();
+
+    const std::ptrdiff_t d_istep = image_.istep();
+    const std::ptrdiff_t d_jstep = image_.jstep();
+    const std::ptrdiff_t d_pstep = image_.planestep();
+
+    rT temp_val;
+    vector_ sample;
+
+    typename bbgm_image_of<dist_>::iterator itr(&dimg_(0,j0));
+    rT* r_row = result_.top_left_ptr() + std::ptrdiff_t(j0)*r_jstep;
+    const rT* m_row = mask_.top_left_ptr() + std::ptrdiff_t(j0)*m_jstep;
+    const T* d_row = image_.top_left_ptr() + std::ptrdiff_t(j0)*d_jstep;
+    for (unsigned int j=j0; j<j1; ++j, d_row+=d_jstep, r_row+=r_jstep,m_row+=m_jstep){
+      rT* r_col = r_row;
+      const rT* m_col = m_row;
+      const T* d_col = d_row;
+      for (unsigned int i=0; i<ni; ++i, d_col+=d_istep, r_col+=r_istep,m_col+=m_istep, ++itr){
+        const T* d_plane = d_col;
+        if (*m_col)
         {
-            if (*m_col)
-            {
-            bool flag=false;
-            for (int l=-rad;l<=rad;l++)
-            {
-                for (int k=-rad;k<=rad;k++)
-                {
-                    if (l+i>=0 && l+i<ni && k+j>=0 && k+j<nj)
-                    {
-                        if (mask(l+i,k+j))
-                        {
-                        const T * d_plane=&image(l+i,k+j);
-
-                        bbgm_planes_to_sample<T,vector_,dist_::dimension>::apply(d_plane,sample,d_pstep);
-                        if (detector(*itr, sample, temp_val))
-                            if (temp_val)
-                                flag=true;
-                        }
-                    }
-                }
-            }
-            *r_col=flag;
-        }
-            else
-                *r_col=true;
+          bbgm_planes_to_sample<T,vector_,dist_::dimension>::apply(d_plane,sample,d_pstep);
+          if (detector(*itr, sample, temp_val))
+            *r_col =temp_val;
         }
+      }
     }
-}
+  }
 
+  bbgm_image_of<dist_>& dimg_;
+  const vil_image_view<T>& image_;
+  vil_image_view<rT>& result_;
+  const vil_image_view<rT>& mask_;
+  const detector_& detector_obj_;
+};
 
+
+//: Detect where mask(i,j), splitting the rows between threads
 template <class dist_, class detector_, class rT>
 void detect_masked(bbgm_image_of<dist_>& dimg,
                    const vil_image_view<typename dist_::math_type>& image,
                    vil_image_view<rT>& result,
                    vil_image_view<rT>& mask,
-                   const detector_& detector)
+                   const detector_& detector,
+                   const vil_parallel_policy& policy)
 {
-    typedef typename dist_::vector_type vector_;
-    typedef typename dist_::math_type T;
-
     const unsigned ni = dimg.ni();
     const unsigned nj = dimg.nj();
     const unsigned d_np = dist_::dimension;
@@ -287,38 +432,19 @@ void detect_masked(bbgm_image_of<dist_>& dimg,
     assert(image.nplanes() == d_np);
 
     result.set_size(ni,nj,1);
+    bbgm_run_rows(bbgm_detect_masked_rows<dist_,detector_,rT>(dimg,image,result,mask,detector),
+                  nj, 0, policy);
+}
 
-    const std::ptrdiff_t r_istep = result.istep();
-    const std::ptrdiff_t r_jstep = result.jstep();
-
-    const std::ptrdiff_t m_istep = mask.istep();
-    const std::ptrdiff_t m_jstep = mask.jstep();
-
-    const std::ptrdiff_t d_istep = image.istep();
-    const std::ptrdiff_t d_jstep = image.jstep();
-    const std::ptrdiff_t d_pstep = image.planestep();
-
-    rT temp_val;
-    vector_ sample;
 
-    typename bbgm_image_of<dist_>::iterator itr = dimg.begin();
-    rT* r_row = result.top_left_ptr();
-    rT* m_row = mask.top_left_ptr();
-    const T* d_row = image.top_left_ptr();
-    for (unsigned int j=0; j<nj; ++j, d_row+=d_jstep, r_row+=r_jstep,m_row+=m_jstep){
-        rT* r_col = r_row;
-        rT* m_col = m_row;
-        const T* d_col = d_row;
-        for (unsigned int i=0; i<ni; ++i, d_col+=d_istep, r_col+=r_istep,m_col+=m_istep, ++itr){
-            const T* d_plane = d_col;
-            if (*m_col)
-            {
-            bbgm_planes_to_sample<T,vector_,dist_::dimension>::apply(d_plane,sample,d_pstep);
-            if (detector(*itr, sample, temp_val))
-                *r_col =temp_val;
-            }
-    }
-  }
+template <class dist_, class detector_, class rT>
+void detect_masked(bbgm_image_of<dist_>& dimg,
+                   const vil_image_view<typename dist_::math_type>& image,
+                   vil_image_view<rT>& result,
+                   vil_image_view<rT>& mask,
+                   const detector_& detector)
+{
+    detect_masked(dimg, image, result, mask, detector, vil_parallel_policy(1));
 }
 
 #endif // bbgm_detect_h_
@@ -233,7 +233,7 @@ class fless
  public:
   fless() {}
   bool operator ()(bbgm_mask_pair_feature const& fa,
-                   bbgm_mask_pair_feature const& fb) {
+                   bbgm_mask_pair_feature const& fb) const {
     unsigned short ica, jca, icb, jcb;
     fa.center(ica, jca);
     fb.center(icb, jcb);
@@ -0,0 +1,80 @@
+// This is brl/bseg/bbgm/bbgm_parallel.h
+#ifndef bbgm_parallel_h_
+#define bbgm_parallel_h_
+//:
+// \file
+// \brief Splitting operations on distribution images into bands of rows for several threads
+//
+// The update, apply and detect functions of bbgm_update.h, bbgm_apply.h and
+// bbgm_detect.h have overloads taking a vil_parallel_policy, which work on
+// bands of rows in parallel using vil_parallel_run():
+// \code
+//   update(model, frame, updater, vil_parallel_policy());
+//   bbgm_apply(model, functor, frame, result, fail_val, vil_parallel_policy());
+// \endcode
+// Each pixel is computed exactly as by the serial functions, which are the
+// same code run on one band, so the results do not depend on the number of
+// threads.  Updaters are copied for each band; functors and detectors are
+// shared, and must be safe to call from several threads at once.
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <vil/vil_parallel.h>
+#include <vxl_config.h>
+#include <vcl_compiler.h>
+
+//: Calls op(j0,j1) for bands first, first+stride, ... of n_bands bands of rows [0,nj)
+template <class rows_op_>
+class bbgm_rows_job : public vil_parallel_job
+{
+ public:
+  bbgm_rows_job(const rows_op_& op, unsigned nj, unsigned n_bands,
+                unsigned first = 0, unsigned stride = 1)
+    : op_(op), nj_(nj), n_bands_(n_bands), first_(first), stride_(stride) {}
+
+  virtual void run(unsigned k) VXL_OVERRIDE
+  {
+    const vxl_uint_64 b = first_ + stride_*k;
+    op_(unsigned(vxl_uint_64(nj_)*b/n_bands_), unsigned(vxl_uint_64(nj_)*(b+1)/n_bands_));
+  }
+
+ private:
+  const rows_op_& op_;
+  unsigned nj_;
+  unsigned n_bands_;
+  unsigned first_;
+  unsigned stride_;
+};
+
+//: Calls op(j0,j1) on bands of rows [j0,j1) which together cover rows [0,nj)
+//  op(j0,j1) may read the distributions of up to \p halo rows above and below
+//  its band.  Reading a distribution is not always thread safe (some cache
+//  their inverse covariance), so bands sharing such rows are run in turn.
+template <class rows_op_>
+void bbgm_run_rows(const rows_op_& op, unsigned nj, unsigned halo,
+                   const vil_parallel_policy& policy)
+{
+  const unsigned n_threads = policy.n_threads > 0 ? policy.n_threads : vil_parallel_max_threads();
+  // A few bands per thread, since the cost of a pixel depends on its distribution.
+  const unsigned n_bands = n_threads > 1 ?
+      vil_parallel_n_bands(nj, halo, vil_parallel_policy(4*n_threads, policy.min_band_rows)) : 1;
+  if (n_bands <= 1) {
+    op(0, nj);
+    return;
+  }
+  if (halo == 0) {
+    bbgm_rows_job<rows_op_> job(op, nj, n_bands);
+    vil_parallel_run(job, n_bands, policy.n_threads);
+    return;
+  }
+  // Bands have at least 2*halo+1 rows, so the rows read by the even bands
+  // are all different, and likewise for the odd bands.
+  bbgm_rows_job<rows_op_> even(op, nj, n_bands, 0, 2);
+  vil_parallel_run(even, (n_bands+1)/2, policy.n_threads);
+  bbgm_rows_job<rows_op_> odd(op, nj, n_bands, 1, 2);
+  vil_parallel_run(odd, n_bands/2, policy.n_threads);
+}
+
+#endif // bbgm_parallel_h_
@@ -19,6 +19,7 @@
 
 #include "bbgm_planes_to_sample.h"
 #include "bbgm_image_of.h"
+#include "bbgm_parallel.h"
 
 //: Update with no data
 template <class dist_, class updater_>
@@ -30,44 +31,102 @@ void update(bbgm_image_of<dist_>& dimg,
     updater(*itr);
 }
 
-//: Update with a new sample image
+//: Updates rows [j0,j1) of a distribution image with a sample image
+//  Only where mask(i,j), if a mask is given.
+template <class dist_, class T, class updater_>
+struct bbgm_update_rows
+{
+  bbgm_update_rows(bbgm_image_of<dist_>& d, const vil_image_view<T>& im,
+                   const updater_& u, const vil_image_view<bool>* m)
+    : dimg_(d), image_(im), updater_obj_(u), mask_(m) {}
+
+  void operator()(unsigned j0, unsigned j1) const
+  {
+    typedef typename updater_::field_type F;
+    const unsigned ni = image_.ni();
+    if (ni==0 || j0>=j1)
+      return;
+
+    // see bsta_mg_adaptive_updater::init_gaussian_
+    const updater_ updater(updater_obj_);
+
+    const std::ptrdiff_t planestep = image_.planestep();
+    const std::ptrdiff_t istep = image_.istep();
+    const std::ptrdiff_t jstep = image_.jstep();
+
+    typename bbgm_image_of<dist_>::iterator itr(&dimg_(0,j0));
+    const T* row = image_.top_left_ptr() + std::ptrdiff_t(j0)*jstep;
+    if (!mask_) {
+      for (unsigned int j=j0; j<j1; ++j, row+=jstep){
+        const T* col = row;
+        for (unsigned int i=0; i<ni; ++i, col+=istep, ++itr){
+          const T* data = col;
+          F sample;
+          bbgm_planes_to_sample<T,F,vpdt_field_traits<F>::dimension>::apply(data,sample,planestep);
+          updater(*itr,sample);
+        }
+      }
+      return;
+    }
+
+    const std::ptrdiff_t m_istep = mask_->istep();
+    const std::ptrdiff_t m_jstep = mask_->jstep();
+    const bool* m_row = mask_->top_left_ptr() + std::ptrdiff_t(j0)*m_jstep;
+    for (unsigned int j=j0; j<j1; ++j, row+=jstep, m_row+=m_jstep){
+      const T* col = row;
+      const bool* m_col = m_row;
+      for (unsigned int i=0; i<ni; ++i, col+=istep, m_col+=m_istep, ++itr){
+        if (*m_col) {
+          const T* data = col;
+          F sample;
+          bbgm_planes_to_sample<T,F,vpdt_field_traits<F>::dimension>::apply(data,sample,planestep);
+          updater(*itr,sample);
+        }
+      }
+    }
+  }
+
+  bbgm_image_of<dist_>& dimg_;
+  const vil_image_view<T>& image_;
+  const updater_& updater_obj_;
+  const vil_image_view<bool>* mask_;
+};
+
+
+//: Update with a new sample image, splitting the rows between threads
 template <class dist_, class T, class updater_>
 void update(bbgm_image_of<dist_>& dimg,
             const vil_image_view<T>& image,
-            const updater_& updater)
+            const updater_& updater,
+            const vil_parallel_policy& policy)
 {
   typedef typename updater_::field_type F;
   assert(dimg.ni() == image.ni());
   assert(dimg.nj() == image.nj());
   assert(vpdt_field_traits<F>::dimension == image.nplanes());
 
-  const unsigned ni = image.ni();
-  const unsigned nj = image.nj();
-
-  const std::ptrdiff_t planestep = image.planestep();
-  const std::ptrdiff_t istep = image.istep();
-  const std::ptrdiff_t jstep = image.jstep();
-
-  typename bbgm_image_of<dist_>::iterator itr = dimg.begin();
-  const T* row = image.top_left_ptr();
-  for (unsigned int j=0; j<nj; ++j, row+=jstep){
-    const T* col = row;
-    for (unsigned int i=0; i<ni; ++i, col+=istep, ++itr){
-      const T* data = col;
-      F sample;
-      bbgm_planes_to_sample<T,F,vpdt_field_traits<F>::dimension>::apply(data,sample,planestep);
-      updater(*itr,sample);
-    }
-  }
+  bbgm_run_rows(bbgm_update_rows<dist_,T,updater_>(dimg,image,updater,VXL_NULLPTR),
+                image.nj(), 0, policy);
 }
 
 
-//: Update with a new sample image only where mask(i,j)
+//: Update with a new sample image
+template <class dist_, class T, class updater_>
+void update(bbgm_image_of<dist_>& dimg,
+            const vil_image_view<T>& image,
+            const updater_& updater)
+{
+  update(dimg, image, updater, vil_parallel_policy(1));
+}
+
+
+//: Update with a new sample image only where mask(i,j), splitting the rows between threads
 template <class dist_, class T, class updater_>
 void update_masked(bbgm_image_of<dist_>& dimg,
                    const vil_image_view<T>& image,
                    const updater_& updater,
-                   const vil_image_view<bool>& mask)
+                   const vil_image_view<bool>& mask,
+                   const vil_parallel_policy& policy)
 {
   typedef typename updater_::field_type F;
   assert(dimg.ni() == image.ni());
@@ -76,30 +135,19 @@ void update_masked(bbgm_image_of<dist_>& dimg,
   assert(dimg.nj() == mask.nj());
   assert(vpdt_field_traits<F>::dimension == image.nplanes());
 
-  const unsigned ni = image.ni();
-  const unsigned nj = image.nj();
-
-  const std::ptrdiff_t planestep = image.planestep();
-  const std::ptrdiff_t istep = image.istep();
-  const std::ptrdiff_t jstep = image.jstep();
-  const std::ptrdiff_t m_istep = mask.istep();
-  const std::ptrdiff_t m_jstep = mask.jstep();
-
-  typename bbgm_image_of<dist_>::iterator itr = dimg.begin();
-  const bool* m_row = mask.top_left_ptr();
-  const T* row = image.top_left_ptr();
-  for (unsigned int j=0; j<nj; ++j, row+=jstep, m_row+=m_jstep){
-    const T* col = row;
-    const bool* m_col = m_row;
-    for (unsigned int i=0; i<ni; ++i, col+=istep, m_col+=m_istep, ++itr){
-      if (*m_col) {
-        const T* data = col;
-        F sample;
-        bbgm_planes_to_sample<T,F,vpdt_field_traits<F>::dimension>::apply(data,sample,planestep);
-        updater(*itr,sample);
-      }
-    }
-  }
+  bbgm_run_rows(bbgm_update_rows<dist_,T,updater_>(dimg,image,updater,&mask),
+                image.nj(), 0, policy);
+}
+
+
+//: Update with a new sample image only where mask(i,j)
+template <class dist_, class T, class updater_>
+void update_masked(bbgm_image_of<dist_>& dimg,
+                   const vil_image_view<T>& image,
+                   const updater_& updater,
+                   const vil_image_view<bool>& mask)
+{
+  update_masked(dimg, image, updater, mask, vil_parallel_policy(1));
 }
 
 
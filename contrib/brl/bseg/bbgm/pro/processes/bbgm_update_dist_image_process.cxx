@@ -17,6 +17,7 @@
 #include <vil/vil_image_view.h>
 #include <vil/vil_convert.h>
 #include <vil/vil_math.h>
+#include <vil/vil_parallel.h>
 
 
 bool bbgm_update_dist_image_process_cons(bprb_func_process& pro)
@@ -105,7 +106,7 @@ bool bbgm_update_dist_image_process(bprb_func_process& pro)
                                                             min_stdev,
                                                             window_size);
 
-    update(*model,img,updater);
+    update(*model,img,updater,vil_parallel_policy());
 
     brdb_value_sptr output = new brdb_value_t<bbgm_image_sptr>(model);
     pro.set_output(0, output);
@@ -137,7 +138,7 @@ bool bbgm_update_dist_image_process(bprb_func_process& pro)
                                                             min_stdev,
                                                             window_size);
 
-    update(*model,img,updater);
+    update(*model,img,updater,vil_parallel_policy());
 
     brdb_value_sptr output = new brdb_value_t<bbgm_image_sptr>(model);
     pro.set_output(0, output);
@@ -14,6 +14,7 @@
 #include <brdb/brdb_value.h>
 #include <vbl/io/vbl_io_smart_ptr.h>
 #include <vil/vil_math.h>
+#include <vil/vil_parallel.h>
 #include <vil/vil_convert.h>
 #include <vidl/vidl_istream_sptr.h>
 #include <vidl/vidl_frame.h>
@@ -148,7 +149,7 @@ bool bbgm_update_dist_image_stream_process(bprb_func_process& pro)
       if (fb->pixel_format() == VIL_PIXEL_FORMAT_BYTE)
         vil_math_scale_values(frame,1.0/255.0);
 
-      update(*model,frame,updater);
+      update(*model,frame,updater,vil_parallel_policy());
       std::cout << "updated frame # "<< istr->frame_number()
                << " format " << fb->pixel_format() << " nplanes "
                << fb->nplanes()<< '\n';
@@ -11,8 +11,15 @@
 #include <bsta/algo/bsta_adaptive_updater.h>
 
 #include <bbgm/bbgm_update.h>
+#include <bbgm/bbgm_apply.h>
+#include <bbgm/bbgm_detect.h>
 #include <bsta/bsta_gaussian_indep.h>
+#include <bsta/bsta_basic_functors.h>
+#include <bsta/bsta_detector_gaussian.h>
+#include <bsta/bsta_detector_mixture.h>
 #include <vil/vil_image_view.h>
+#include <vil/vil_parallel.h>
+#include <vil/algo/vil_structuring_element.h>
 #include <vul/vul_timer.h>
 #include <vnl/vnl_random.h>
 
@@ -104,6 +111,58 @@ static void test_bg_model_speed()
       std::cout << " updated in " << up_time << " sec" <<std::endl;
     }
   }
+
+  std::cout << "testing threaded speeds, " << vil_parallel_max_threads() << " threads" << std::endl;
+  {
+    typedef bsta_num_obs<bsta_gauss_if3> gauss_type;
+    typedef bsta_mixture<gauss_type> mix_gauss_type;
+    typedef bsta_num_obs<mix_gauss_type> obs_mix_gauss_type;
+    typedef bsta_g_mdist_detector<gauss_type> g_detector;
+
+    bsta_gauss_if3 init_gauss( init_mean, init_covar );
+    bsta_mg_grimson_window_updater<mix_gauss_type> updater(init_gauss,
+                                                           max_components,
+                                                           3.0f, 0.02f,
+                                                           window_size);
+    bsta_top_weight_detector<mix_gauss_type, g_detector> detector(g_detector(2.5f), 0.7f);
+    bsta_mixture_data_functor<mix_gauss_type, bsta_prob_density_functor<gauss_type> >
+      functor(bsta_prob_density_functor<gauss_type>(), 0);
+    vil_structuring_element se;
+    se.set_to_disk(1.5);
+    const float fail_val = 0.0f;
+
+    bbgm_image_of<obs_mix_gauss_type> serial(ni,nj,obs_mix_gauss_type());
+    bbgm_image_of<obs_mix_gauss_type> threaded(ni,nj,obs_mix_gauss_type());
+    const vil_parallel_policy policy;
+
+    double times[2][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+    bool same = true;
+    for (unsigned int t=0; t<images.size(); ++t){
+      vil_image_view<float> prob[2];
+      vil_image_view<bool> fg[2];
+      vul_timer time;
+      update(serial,images[t],updater);
+      times[0][0] += time.real();  time.mark();
+      bbgm_apply(serial,functor,images[t],prob[0],&fail_val);
+      times[0][1] += time.real();  time.mark();
+      detect(serial,images[t],fg[0],detector,se);
+      times[0][2] += time.real();  time.mark();
+      update(threaded,images[t],updater,policy);
+      times[1][0] += time.real();  time.mark();
+      bbgm_apply(threaded,functor,images[t],prob[1],&fail_val,policy);
+      times[1][1] += time.real();  time.mark();
+      detect(threaded,images[t],fg[1],detector,se,policy);
+      times[1][2] += time.real();
+      for (unsigned int j=0; j<nj; ++j)
+        for (unsigned int i=0; i<ni; ++i)
+          same = same && prob[0](i,j) == prob[1](i,j) && fg[0](i,j) == fg[1](i,j);
+    }
+    const char* names[3] = { "update", "apply", "detect" };
+    for (unsigned int k=0; k<3; ++k)
+      std::cout << ' ' << names[k] << " per frame: serial " << times[0][k]/images.size()
+                << " ms, threaded " << times[1][k]/images.size() << " ms" << std::endl;
+    TEST("threaded results same as serial", same, true);
+  }
 }
 
 TESTMAIN(test_bg_model_speed);
@@ -3,11 +3,13 @@
 
 DECLARE( test_bg_model_speed );
 DECLARE( test_measure );
+DECLARE( test_parallel_update );
 void
 register_tests()
 {
   REGISTER( test_bg_model_speed );
   REGISTER( test_measure );
+  REGISTER( test_parallel_update );
 }
 
 DEFINE_MAIN;
@@ -0,0 +1,175 @@
+#include <iostream>
+#include <vector>
+#include <testlib/testlib_test.h>
+#include <vcl_compiler.h>
+
+#include <bbgm/bbgm_image_of.h>
+#include <bbgm/bbgm_update.h>
+#include <bbgm/bbgm_apply.h>
+#include <bbgm/bbgm_detect.h>
+#include <bsta/bsta_attributes.h>
+#include <bsta/bsta_mixture.h>
+#include <bsta/bsta_gauss_if3.h>
+#include <bsta/bsta_basic_functors.h>
+#include <bsta/bsta_detector_gaussian.h>
+#include <bsta/bsta_detector_mixture.h>
+#include <bsta/algo/bsta_adaptive_updater.h>
+#include <vil/vil_image_view.h>
+#include <vil/vil_parallel.h>
+#include <vil/algo/vil_structuring_element.h>
+#include <vnl/vnl_random.h>
+
+namespace {
+
+typedef bsta_num_obs<bsta_gauss_if3> gauss_type;
+typedef bsta_mixture<gauss_type> mix_gauss_type;
+typedef bsta_num_obs<mix_gauss_type> obs_mix_gauss_type;
+typedef bbgm_image_of<obs_mix_gauss_type> model_type;
+
+//: Frame t of a noisy background with a bright square moving across it
+void make_frame(unsigned t, vil_image_view<float>& img, vnl_random& rand)
+{
+  for (unsigned int j=0; j<img.nj(); ++j)
+    for (unsigned int i=0; i<img.ni(); ++i) {
+      const bool fg = i >= 4*t && i < 4*t+12 && j >= 3*t && j < 3*t+40;
+      for (unsigned int p=0; p<img.nplanes(); ++p)
+        img(i,j,p) = fg ? 0.9f : static_cast<float>(0.2+0.1*p+0.02*rand.normal());
+    }
+}
+
+bool same_model(const model_type& a, const model_type& b)
+{
+  if (a.ni() != b.ni() || a.nj() != b.nj())
+    return false;
+  for (unsigned int j=0; j<a.nj(); ++j)
+    for (unsigned int i=0; i<a.ni(); ++i) {
+      const obs_mix_gauss_type& ma = a(i,j);
+      const obs_mix_gauss_type& mb = b(i,j);
+      if (ma.num_observations != mb.num_observations ||
+          ma.num_components() != mb.num_components())
+        return false;
+      for (unsigned int c=0; c<ma.num_components(); ++c)
+        if (ma.weight(c) != mb.weight(c) ||
+            ma.distribution(c).mean() != mb.distribution(c).mean() ||
+            ma.distribution(c).diag_covar() != mb.distribution(c).diag_covar() ||
+            ma.distribution(c).num_observations != mb.distribution(c).num_observations)
+          return false;
+    }
+  return true;
+}
+
+template <class T>
+bool same_image(const vil_image_view<T>& a, const vil_image_view<T>& b)
+{
+  if (a.ni() != b.ni() || a.nj() != b.nj() || a.nplanes() != b.nplanes())
+    return false;
+  for (unsigned int p=0; p<a.nplanes(); ++p)
+    for (unsigned int j=0; j<a.nj(); ++j)
+      for (unsigned int i=0; i<a.ni(); ++i)
+        if (a(i,j,p) != b(i,j,p))
+          return false;
+  return true;
+}
+
+} // namespace
+
+static void test_parallel_update()
+{
+  const unsigned int ni = 80, nj = 150;
+  const vil_parallel_policy threads(4);
+
+  bsta_gauss_if3 init_gauss(vnl_vector_fixed<float,3>(0.0f), vnl_vector_fixed<float,3>(0.01f));
+  bsta_mg_grimson_window_updater<mix_gauss_type> updater(init_gauss, 3, 3.0f, 0.02f, 50);
+
+  model_type serial(ni,nj,obs_mix_gauss_type());
+  model_type parallel(ni,nj,obs_mix_gauss_type());
+  vil_image_view<float> frame(ni,nj,3);
+  vnl_random rand(9667566);
+  bool same = true;
+  for (unsigned t=0; t<12; ++t) {
+    make_frame(t, frame, rand);
+    update(serial, frame, updater);
+    update(parallel, frame, updater, threads);
+    same = same && same_model(serial, parallel);
+  }
+  TEST("update", same, true);
+
+  // update a transposed view, so that the rows of the image are not contiguous
+  vil_image_view<float> frame_t(nj,ni,3);
+  make_frame(12, frame_t, rand);
+  vil_image_view<float> strided(frame_t.memory_chunk(), frame_t.top_left_ptr(),
+                                ni, nj, 3, frame_t.jstep(), frame_t.istep(), frame_t.planestep());
+  vil_image_view<bool> mask(ni,nj);
+  for (unsigned int j=0; j<nj; ++j)
+    for (unsigned int i=0; i<ni; ++i)
+      mask(i,j) = (i+2*j) % 3 != 0;
+  update_masked(serial, strided, updater, mask);
+  update_masked(parallel, strided, updater, mask, threads);
+  TEST("update_masked", same_model(serial, parallel), true);
+
+  make_frame(13, frame, rand);
+
+  {
+    typedef bsta_mixture_functor<mix_gauss_type, bsta_mean_functor<gauss_type> > functor_type;
+    functor_type functor(bsta_mean_functor<gauss_type>(), 1);
+    const float fail_val[3] = { -1.0f, -1.0f, -1.0f };
+    vil_image_view<float> r_serial, r_parallel;
+    bbgm_apply(serial, functor, r_serial, fail_val);
+    bbgm_apply(serial, functor, r_parallel, fail_val, threads);
+    TEST("apply without data", same_image(r_serial, r_parallel), true);
+  }
+  {
+    bsta_mixture_size_functor<mix_gauss_type> functor;
+    vil_image_view<unsigned int> r_serial, r_parallel;
+    bbgm_apply(serial, functor, r_serial);
+    bbgm_apply(serial, functor, r_parallel, static_cast<const unsigned int*>(VXL_NULLPTR), threads);
+    TEST("apply without data, one plane", same_image(r_serial, r_parallel), true);
+  }
+  {
+    typedef bsta_mixture_data_functor<mix_gauss_type, bsta_prob_density_functor<gauss_type> > functor_type;
+    functor_type functor(bsta_prob_density_functor<gauss_type>(), 0);
+    const float fail_val = -1.0f;
+    vil_image_view<float> r_serial, r_parallel;
+    bbgm_apply(serial, functor, frame, r_serial, &fail_val);
+    bbgm_apply(serial, functor, frame, r_parallel, &fail_val, threads);
+    TEST("apply with data", same_image(r_serial, r_parallel), true);
+  }
+
+  typedef bsta_g_mdist_detector<gauss_type> g_detector;
+  typedef bsta_top_weight_detector<mix_gauss_type, g_detector> detector_type;
+  detector_type detector(g_detector(2.5f), 0.7f);
+  {
+    vil_structuring_element se;
+    se.set_to_disk(2.5);
+    vil_image_view<bool> r_serial, r_parallel;
+    detect(serial, frame, r_serial, detector, se);
+    detect(serial, frame, r_parallel, detector, se, threads);
+    TEST("detect with structuring element", same_image(r_serial, r_parallel), true);
+
+    r_serial.fill(false);
+    r_parallel.fill(false);
+    detect_masked(serial, frame, r_serial, detector, se, mask);
+    detect_masked(serial, frame, r_parallel, detector, se, mask, threads);
+    TEST("detect_masked with structuring element", same_image(r_serial, r_parallel), true);
+  }
+  {
+    vil_image_view<bool> r_serial, r_parallel;
+    detect(serial, frame, r_serial, detector, 1);
+    detect(serial, frame, r_parallel, detector, 1, threads);
+    TEST("detect with radius", same_image(r_serial, r_parallel), true);
+
+    detect_masked(serial, frame, r_serial, detector, 1, mask);
+    detect_masked(serial, frame, r_parallel, detector, 1, mask, threads);
+    TEST("detect_masked with radius", same_image(r_serial, r_parallel), true);
+  }
+  {
+    vil_image_view<bool> r_serial(ni,nj), r_parallel(ni,nj);
+    r_serial.fill(false);
+    r_parallel.fill(false);
+    detect_masked(serial, frame, r_serial, mask, detector);
+    detect_masked(serial, frame, r_parallel, mask, detector, threads);
+    TEST("detect_masked into mask type", same_image(r_serial, r_parallel), true);
+  }
+}
+
+TESTMAIN(test_parallel_update);
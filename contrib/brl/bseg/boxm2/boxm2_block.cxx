@@ -31,6 +31,34 @@ boxm2_block::boxm2_block(boxm2_block_id const& id, boxm2_block_metadata const& d
   n_cells_ =this->recompute_num_cells();
 }
 
+boxm2_block::boxm2_block(boxm2_block_id const& id, vil_memory_chunk_sptr const& mapping)
+: mapping_(mapping), version_(1)
+{
+  block_id_ = id;
+  buffer_ = static_cast<char*>(mapping->data());
+  this->b_read(buffer_);
+  read_only_ = true;
+  n_cells_ =this->recompute_num_cells();
+}
+
+boxm2_block::boxm2_block(boxm2_block_id const& id, boxm2_block_metadata const& data,
+                         vil_memory_chunk_sptr const& mapping)
+: mapping_(mapping)
+{
+  version_ = data.version_;
+  init_level_ = data.init_level_;
+  max_level_  = data.max_level_;
+  max_mb_     = int(data.max_mb_);
+  sub_block_dim_ = data.sub_block_dim_;
+  sub_block_num_ = data.sub_block_num_;
+  local_origin_ = data.local_origin_;
+  block_id_ = id;
+  buffer_ = static_cast<char*>(mapping->data());
+  this->b_read(buffer_);
+  read_only_ = true;
+  n_cells_ =this->recompute_num_cells();
+}
+
 boxm2_block::boxm2_block(boxm2_block_metadata const& data)
 {
   version_ = data.version_;
@@ -166,6 +194,7 @@ bool boxm2_block::init_empty_block(boxm2_block_metadata const& data)
   max_level_  = data.max_level_;
   max_mb_     = int(data.max_mb_);
   local_origin_ = data.local_origin_;
+  mapping_ = VXL_NULLPTR; // the new buffer is owned by the block
   buffer_ = new char[byte_count_];
 
   //get member variable metadata straight, then write to the buffer
@@ -8,7 +8,8 @@
 //  like boxm2_data, a boxm2_block will construct itself from a simple, flat
 //  char stream, allocating no extra memory for itself.  This flat char stream
 //  will then be owned by the block, and the block will destroy it upon calling
-//  its destructor.
+//  its destructor.  Alternatively the stream can be a block file mapped into
+//  memory, in which case the block keeps the mapping alive instead.
 //
 // \author Andrew Miller
 // \date   26 Oct 2010
@@ -22,6 +23,7 @@
 #include <boxm2/basic/boxm2_array_3d.h>
 #include <vnl/vnl_vector_fixed.h>
 #include <vgl/vgl_vector_3d.h>
+#include <vil/vil_memory_chunk.h>
 #include <vcl_compiler.h>
 
 //smart pointer stuff
@@ -49,6 +51,10 @@ class boxm2_block : public vbl_ref_count
 
   boxm2_block(boxm2_block_id const& id, boxm2_block_metadata const& data, char* buffer);
 
+  //: construct from a block file mapped into memory, e.g. a vil_mapped_memory_chunk
+  boxm2_block(boxm2_block_id const& id, vil_memory_chunk_sptr const& mapping);
+  boxm2_block(boxm2_block_id const& id, boxm2_block_metadata const& data, vil_memory_chunk_sptr const& mapping);
+
   //: creates empty block from metadata
   boxm2_block(boxm2_block_metadata const& data);
 
@@ -56,7 +62,7 @@ class boxm2_block : public vbl_ref_count
   bool init_empty_block(boxm2_block_metadata const& data);
 
   //: default destructor
-  virtual ~boxm2_block() { if (buffer_) delete[] buffer_; }
+  virtual ~boxm2_block() { if (buffer_ && !mapping_) delete[] buffer_; }
 
   //: all IO manipulates char buffers
   bool b_read(char* buffer);
@@ -68,6 +74,8 @@ class boxm2_block : public vbl_ref_count
   //: accessors
   boxm2_block_id&           block_id()          { return block_id_; }         //somehow make this a const return..
   char*                     buffer()            { return buffer_; }
+  //: true if the buffer is a file mapped into memory rather than owned memory
+  bool                      is_mapped()         const { return mapping_.ptr() != VXL_NULLPTR; }
 // User has only write access to a copy of the current trees  via trees_copy(); Use the set_trees method to put them back in the block
 // this way, n_cells_ will always remain up to date.
   const boxm2_array_3d<uchar16>&  trees()       { return trees_; }
@@ -156,6 +164,8 @@ class boxm2_block : public vbl_ref_count
 
   //: byte buffer
   char*                   buffer_;
+  //: if set, the mapping that holds buffer_
+  vil_memory_chunk_sptr   mapping_;
 
   //: number of bytes this block takes up (on disk and ram)
   long                    byte_count_;
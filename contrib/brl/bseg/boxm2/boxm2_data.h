@@ -12,6 +12,7 @@
 #include <boxm2/boxm2_data_base.h>
 #include <boxm2/basic/boxm2_array_1d.h>
 #include <boxm2/boxm2_data_traits.h>
+#include <boxm2/boxm2_data_soa.h>
 #include <vcl_compiler.h>
 
 //: Specific, templated derived class for data blocks
@@ -31,6 +32,9 @@ class boxm2_data: public boxm2_data_base
     //: data array accessor
     boxm2_array_1d<datatype>& data() { return data_array_; }
 
+    //: accessor for data stored as a structure of arrays (see boxm2_data_soa.h)
+    boxm2_data_soa<T> soa() { return boxm2_data_soa<T>(data_buffer_, buffer_length_); }
+
  protected:
     boxm2_array_1d<datatype> data_array_;
 };
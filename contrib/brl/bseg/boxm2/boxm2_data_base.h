@@ -20,6 +20,7 @@
 
 //
 #include <vsl/vsl_binary_io.h>
+#include <vil/vil_memory_chunk.h>
 
 
 //: Generic, untemplated base class for data blocks
@@ -30,13 +31,19 @@ class boxm2_data_base : public vbl_ref_count
     boxm2_data_base(char * data_buffer, std::size_t length, boxm2_block_id id, bool read_only = true)
     : read_only_(read_only), id_(id), data_buffer_(data_buffer), buffer_length_(length) {}
 
+    //: Constructor - the data buffer is the memory of the mapping, which is kept alive by this class
+    //  Use a private (copy-on-write) mapping, e.g. vil_mapped_memory_chunk, if the data may be changed.
+    boxm2_data_base(vil_memory_chunk_sptr const& mapping, boxm2_block_id id, bool read_only = true)
+    : read_only_(read_only), id_(id), data_buffer_(static_cast<char*>(mapping->data())),
+      buffer_length_(mapping->size()), mapping_(mapping) {}
+
     //: initializes empty data buffer
     boxm2_data_base(boxm2_block_metadata data, std::string type, bool read_only = true);
 
     void set_default_value(std::string data_type, boxm2_block_metadata data);
 
     //: This destructor is correct - by our design the original data_buffer becomes OWNED by the data_base class
-    virtual ~boxm2_data_base() { if (data_buffer_) delete [] data_buffer_; }
+    virtual ~boxm2_data_base() { if (data_buffer_ && !mapping_) delete [] data_buffer_; }
 
     //: accessor for low level byte buffer kept by the data_base
     char *            data_buffer()    { return data_buffer_; }
@@ -44,6 +51,8 @@ class boxm2_data_base : public vbl_ref_count
     boxm2_block_id&   block_id()       { return id_; }
     //: accessor to a portion of the byte buffer
     char *            cell_buffer(int i, std::size_t cell_size);
+    //: true if the data buffer is a file mapped into memory rather than owned memory
+    bool              is_mapped()      const { return mapping_.ptr() != VXL_NULLPTR; }
 
     //: setter for swapping out data buffer
 
@@ -59,6 +68,9 @@ class boxm2_data_base : public vbl_ref_count
     //: byte buffer and its size
     char * data_buffer_;
     std::size_t buffer_length_;
+
+    //: if set, the mapping that holds data_buffer_
+    vil_memory_chunk_sptr mapping_;
 };
 
 //: Smart_Pointer typedef for boxm2_data_base
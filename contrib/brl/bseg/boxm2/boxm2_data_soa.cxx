@@ -0,0 +1,30 @@
+#include <iostream>
+#include "boxm2_data_soa.h"
+//:
+// \file
+
+bool boxm2_data_convert_layout(std::string const& prefix, char const* src, char* dst,
+                               std::size_t length, bool to_soa)
+{
+  switch (boxm2_data_info::data_type(prefix))
+  {
+#define X(enum_val, string_val, datatype_val) \
+    case enum_val: \
+      if (to_soa) boxm2_data_to_soa<enum_val>(src, dst, length); \
+      else        boxm2_data_from_soa<enum_val>(src, dst, length); \
+      return true;
+    BOXM2_DATATYPE_TABLE
+#undef X
+    default:
+      return false;
+  }
+}
+
+bool boxm2_data_reject_soa(std::string const& prefix, std::string const& process)
+{
+  if (!boxm2_data_is_soa(prefix))
+    return false;
+  std::cout << process << " ERROR: " << prefix << " is stored as a structure of arrays, which this process cannot read;"
+            << " convert it back with boxm2ConvertDataLayoutProcess first" << std::endl;
+  return true;
+}
@@ -0,0 +1,158 @@
+#ifndef boxm2_data_soa_h
+#define boxm2_data_soa_h
+//:
+// \file
+// \brief Structure-of-arrays storage for multi-component data types
+//
+//  Data such as BOXM2_MOG3_GREY are normally stored as an array of
+//  structures: the components of each cell lie next to each other.  Stored
+//  as a structure of arrays, component 0 of every cell comes first, then
+//  component 1 of every cell, and so on; so code that needs only some of the
+//  components of a cell, e.g. the means and weights of a mixture, reads only
+//  those bytes.  The buffer is the same size in either layout.
+//
+//  Data in this layout are named by appending "_soa" to the usual prefix,
+//  e.g. "boxm2_mog3_grey_soa", so boxm2_data_info still finds the type (and
+//  cell size) from the name, just as for any other identifier.
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <boxm2/boxm2_data_traits.h>
+#include <vnl/vnl_vector_fixed.h>
+#include <vcl_compiler.h>
+
+//: The components of a data type.  Anything but a vnl_vector_fixed has just one.
+template <class V>
+struct boxm2_data_components
+{
+  typedef V component_type;
+  static const unsigned n = 1;
+  static V& get(V& v, unsigned) { return v; }
+  static V const& get(V const& v, unsigned) { return v; }
+};
+
+template <class C, unsigned K>
+struct boxm2_data_components<vnl_vector_fixed<C, K> >
+{
+  typedef C component_type;
+  static const unsigned n = K;
+  static C& get(vnl_vector_fixed<C, K>& v, unsigned k) { return v[k]; }
+  static C const& get(vnl_vector_fixed<C, K> const& v, unsigned k) { return v[k]; }
+};
+
+//: Accessor for a data buffer stored as a structure of arrays.
+//  Does not own the buffer.
+template <boxm2_data_type T>
+class boxm2_data_soa
+{
+ public:
+  typedef typename boxm2_data_traits<T>::datatype datatype;
+  typedef boxm2_data_components<datatype> components;
+  typedef typename components::component_type component_type;
+
+  boxm2_data_soa() : buffer_(VXL_NULLPTR), size_(0) {}
+
+  boxm2_data_soa(char * data_buffer, std::size_t length)
+  : buffer_(reinterpret_cast<component_type*>(data_buffer)), size_(length/sizeof(datatype)) {}
+
+  //: number of cells
+  std::size_t size() const { return size_; }
+
+  //: component k of every cell
+  component_type* component(unsigned k) const { return buffer_ + k*size_; }
+
+  //: component k of cell i
+  component_type& operator()(std::size_t i, unsigned k) const { return buffer_[k*size_ + i]; }
+
+  //: all the components of cell i
+  datatype get(std::size_t i) const
+  {
+    datatype v;
+    for (unsigned k=0; k<components::n; ++k)
+      components::get(v, k) = buffer_[k*size_ + i];
+    return v;
+  }
+
+  //: the components of cell i selected by mask (bit k for component k); the others are zero
+  datatype get(std::size_t i, unsigned mask) const
+  {
+    datatype v;
+    for (unsigned k=0; k<components::n; ++k)
+      components::get(v, k) = ((mask>>k) & 1) ? buffer_[k*size_ + i] : component_type(0);
+    return v;
+  }
+
+  //: set all the components of cell i
+  void set(std::size_t i, datatype const& v) const
+  {
+    for (unsigned k=0; k<components::n; ++k)
+      buffer_[k*size_ + i] = components::get(v, k);
+  }
+
+ private:
+  component_type* buffer_;
+  std::size_t size_;
+};
+
+//: Copy length bytes of data from the usual layout (aos) to a structure of arrays (soa).
+template <boxm2_data_type T>
+void boxm2_data_to_soa(char const* aos, char* soa, std::size_t length)
+{
+  typedef typename boxm2_data_traits<T>::datatype datatype;
+  typedef boxm2_data_components<datatype> components;
+  if (components::n == 1) {
+    std::memcpy(soa, aos, length);
+    return;
+  }
+  datatype const* cells = reinterpret_cast<datatype const*>(aos);
+  boxm2_data_soa<T> out(soa, length);
+  for (unsigned k=0; k<components::n; ++k) {
+    typename components::component_type* dst = out.component(k);
+    for (std::size_t i=0; i<out.size(); ++i)
+      dst[i] = components::get(cells[i], k);
+  }
+}
+
+//: Copy length bytes of data from a structure of arrays (soa) to the usual layout (aos).
+template <boxm2_data_type T>
+void boxm2_data_from_soa(char const* soa, char* aos, std::size_t length)
+{
+  typedef typename boxm2_data_traits<T>::datatype datatype;
+  typedef boxm2_data_components<datatype> components;
+  if (components::n == 1) {
+    std::memcpy(aos, soa, length);
+    return;
+  }
+  datatype* cells = reinterpret_cast<datatype*>(aos);
+  boxm2_data_soa<T> in(const_cast<char*>(soa), length);
+  for (unsigned k=0; k<components::n; ++k) {
+    typename components::component_type const* src = in.component(k);
+    for (std::size_t i=0; i<in.size(); ++i)
+      components::get(cells[i], k) = src[i];
+  }
+}
+
+//: Copy length bytes of the data type named by prefix to (to_soa) or from a structure of arrays.
+//  src and dst must not overlap.  Returns false if the data type is unknown.
+bool boxm2_data_convert_layout(std::string const& prefix, char const* src, char* dst,
+                               std::size_t length, bool to_soa);
+
+//: name of data of type prefix stored as a structure of arrays
+inline std::string boxm2_data_soa_prefix(std::string const& prefix) { return prefix + "_soa"; }
+
+//: true if data named prefix are stored as a structure of arrays
+inline bool boxm2_data_is_soa(std::string const& prefix)
+{
+  return prefix.size() > 4 && prefix.compare(prefix.size()-4, 4, "_soa") == 0;
+}
+
+//: true, after printing an error from process, if data named prefix are stored as a structure of arrays
+//  For the processes whose functors read only arrays of structures.
+bool boxm2_data_reject_soa(std::string const& prefix, std::string const& process);
+
+#endif // boxm2_data_soa_h
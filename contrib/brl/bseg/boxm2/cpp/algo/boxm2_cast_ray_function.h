@@ -5,6 +5,9 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
 #include <vgl/vgl_ray_3d.h>
 
 #include <vcl_cassert.h>
@@ -17,7 +20,11 @@
 #include <boct/boct_bit_tree.h>
 
 #include <vcl_compiler.h>
+#include <vil/vil_parallel.h>
+#include <vnl/vnl_inverse.h>
+#include <vnl/vnl_matrix_fixed.h>
 #include <vpgl/vpgl_generic_camera.h>
+#include <vpgl/vpgl_perspective_camera.h>
 
 #define BLOCK_EPSILON .006125f
 #define TREE_EPSILON  .005f
@@ -167,6 +174,472 @@ void boxm2_cast_ray_function(vgl_ray_3d<double> & ray_ij,
   }
 }
 
+//: Number of rays cast together by boxm2_cast_ray_packet_function().
+const unsigned boxm2_cast_ray_packet_size = 4;
+
+//: A bit tree unpacked once for all the rays of a packet that enter its block.
+// Gives the same cells as boct_bit_tree::traverse() and get_data_index(),
+// without copying the bits to the heap for every block a ray visits.
+struct boxm2_cast_ray_tree
+{
+  unsigned char bits[16];
+  int data_ptr;
+
+  void load(const unsigned char* tree)
+  {
+    std::memcpy(bits, tree, 16);
+    data_ptr = (int)(bits[13]<<24) | (bits[12]<<16) | (bits[11]<<8) | (bits[10]);
+  }
+
+  //: Bit index of the leaf containing (x,y,z), in [0,1)^3, and its depth.
+  int traverse(float x, float y, float z, int& depth) const
+  {
+    int curr_bit = bits[0];
+    int child_offset = 0;
+    int bit_index = 0;
+    depth = 0;
+    while (curr_bit && depth < 3)
+    {
+      x += x; y += y; z += z;
+      const int c_index = (((int)std::floor(x)) & 1) + ((((int)std::floor(y)) & 1)<<1) + ((((int)std::floor(z)) & 1)<<2);
+      bit_index = (8*bit_index + 1) + c_index;
+      curr_bit = (1<<c_index) & bits[depth+1 + child_offset];
+      child_offset = c_index;
+      ++depth;
+    }
+    return bit_index;
+  }
+
+  //: Index of the data of the cell at bit_index.
+  int data_index(int bit_index) const
+  {
+    if (bit_index < 9)
+      return data_ptr + bit_index;
+    const unsigned char oneuplevel = (bit_index-1)>>3;
+    const unsigned char byte_index = ((oneuplevel-1)>>3) + 1;
+    int count = 0;
+    for (int i=0; i<byte_index; ++i)
+      count += boct_bit_tree::bit_lookup[bits[i]];
+    const unsigned char sub_bit_index = 8-((oneuplevel-1)&(8-1));
+    const unsigned char temp = bits[byte_index]<<sub_bit_index;
+    count += boct_bit_tree::bit_lookup[temp];
+    return data_ptr + 8*count + 1 + ((bit_index-1)&(8-1));
+  }
+};
+
+//: Cast up to boxm2_cast_ray_packet_size neighbouring rays through a block together.
+// The rays step through the block grid in lock step, so rays that enter the
+// same tree share its lookup and unpacking, and the per-ray arithmetic runs
+// over short arrays the compiler can vectorise.  Each ray visits the same
+// cells, in the same order and with the same lengths, as
+// boxm2_cast_ray_function(), but the calls for different rays are
+// interleaved; so this is only correct for functors whose step_cell()
+// writes to nothing but pixel (i,j), and the functor is shared by all rays.
+template<class F>
+void boxm2_cast_ray_packet_function(const vgl_ray_3d<double>* rays,
+                                    const unsigned* pi, const unsigned* pj, unsigned n,
+                                    boxm2_scene_info * linfo,
+                                    boxm2_block * blk_sptr,
+                                    F& functor)
+{
+  assert(n <= boxm2_cast_ray_packet_size);
+  const unsigned N = boxm2_cast_ray_packet_size;
+  const float thresh = std::exp(-12.0f);
+  const float dims[3] = { float(linfo->scene_dims[0]), float(linfo->scene_dims[1]), float(linfo->scene_dims[2]) };
+  static const float cell_lens[4] = { 1.0f, 0.5f, 0.25f, 0.125f };
+
+  float ox[N], oy[N], oz[N], dx[N], dy[N], dz[N];
+  float tblock[N], tfar[N], texit[N], ttree[N], lx[N], ly[N], lz[N];
+  bool active[N], in_tree[N];
+  int tree_of[N];
+  unsigned short bx[N], by[N], bz[N];
+  boxm2_cast_ray_tree trees[N];
+
+  unsigned n_active = 0;
+  for (unsigned k=0; k<N; ++k)
+  {
+    active[k] = false;
+    in_tree[k] = false;
+    if (k >= n) continue;
+    vgl_point_3d<float> block_origin(float(rays[k].origin().x()-linfo->scene_origin[0])/linfo->block_len,
+                                     float(rays[k].origin().y()-linfo->scene_origin[1])/linfo->block_len,
+                                     float(rays[k].origin().z()-linfo->scene_origin[2])/linfo->block_len);
+    float rdx = float(rays[k].direction().x()),
+          rdy = float(rays[k].direction().y()),
+          rdz = float(rays[k].direction().z());
+    if (std::fabs(rdx) < thresh) rdx = (rdx>0)?thresh:-thresh;
+    if (std::fabs(rdy) < thresh) rdy = (rdy>0)?thresh:-thresh;
+    if (std::fabs(rdz) < thresh) rdz = (rdz>0)?thresh:-thresh;
+    // as in boxm2_cast_ray_function(), which renormalises the thresholded direction
+    vgl_ray_3d<float> ray(block_origin, vgl_vector_3d<float>(rdx,rdy,rdz));
+    ox[k] = ray.origin().x();     oy[k] = ray.origin().y();     oz[k] = ray.origin().z();
+    dx[k] = ray.direction().x();  dy[k] = ray.direction().y();  dz[k] = ray.direction().z();
+
+    const float max_facex = (dx[k] > 0.0f) ? dims[0] : 0.0f;
+    const float max_facey = (dy[k] > 0.0f) ? dims[1] : 0.0f;
+    const float max_facez = (dz[k] > 0.0f) ? dims[2] : 0.0f;
+    float tf = std::min(std::min( (max_facex-ox[k])*(1.0f/dx[k]), (max_facey-oy[k])*(1.0f/dy[k])), (max_facez-oz[k])*(1.0f/dz[k]));
+    const float min_facex = (dx[k] < 0.0f) ? dims[0] : 0.0f;
+    const float min_facey = (dy[k] < 0.0f) ? dims[1] : 0.0f;
+    const float min_facez = (dz[k] < 0.0f) ? dims[2] : 0.0f;
+    float tb = std::max(std::max( (min_facex-ox[k])*(1.0f/dx[k]), (min_facey-oy[k])*(1.0f/dy[k])), (min_facez-oz[k])*(1.0f/dz[k]));
+    if (tf <= tb || tf < 0)
+      continue;
+    tblock[k] = (tb > 0.0f) ? tb : 0.0f;
+    tfar[k] = tf - BLOCK_EPSILON;
+    active[k] = true;
+    ++n_active;
+  }
+
+  while (n_active)
+  {
+    // Enter the next block of every ray, unpacking each tree only once.
+    unsigned n_trees = 0;
+    for (unsigned k=0; k<N; ++k)
+    {
+      if (!active[k]) continue;
+      if (!(tblock[k] < tfar[k])) { active[k] = false; --n_active; continue; }
+      const float posx = (ox[k] + (tblock[k] + TREE_EPSILON)*dx[k]);
+      const float posy = (oy[k] + (tblock[k] + TREE_EPSILON)*dy[k]);
+      const float posz = (oz[k] + (tblock[k] + TREE_EPSILON)*dz[k]);
+      float cell_minx = boxm2_util::clamp(std::floor(posx), 0.0f, dims[0]-1.0f);
+      float cell_miny = boxm2_util::clamp(std::floor(posy), 0.0f, dims[1]-1.0f);
+      float cell_minz = boxm2_util::clamp(std::floor(posz), 0.0f, dims[2]-1.0f);
+      bx[k] = (unsigned short)cell_minx;
+      by[k] = (unsigned short)cell_miny;
+      bz[k] = (unsigned short)cell_minz;
+      lx[k] = (posx - cell_minx);
+      ly[k] = (posy - cell_miny);
+      lz[k] = (posz - cell_minz);
+
+      cell_minx = (dx[k] > 0) ? cell_minx+1.0f : cell_minx;
+      cell_miny = (dy[k] > 0) ? cell_miny+1.0f : cell_miny;
+      cell_minz = (dz[k] > 0) ? cell_minz+1.0f : cell_minz;
+      const float te = std::min(std::min( (cell_minx-ox[k])*(1.0f/dx[k]), (cell_miny-oy[k])*(1.0f/dy[k])), (cell_minz-oz[k])*(1.0f/dz[k]));
+      if (te <= tblock[k]) { active[k] = false; --n_active; continue; }
+      texit[k] = (te - tblock[k] - BLOCK_EPSILON);
+      ttree[k] = 0.0f;
+      in_tree[k] = true;
+
+      int t = -1;
+      for (unsigned m=0; m<k && t<0; ++m)
+        if (in_tree[m] && bx[m]==bx[k] && by[m]==by[k] && bz[m]==bz[k])
+          t = tree_of[m];
+      if (t < 0)
+      {
+        t = int(n_trees++);
+        trees[t].load(blk_sptr->trees()(bx[k],by[k],bz[k]).data_block());
+      }
+      tree_of[k] = t;
+    }
+
+    // Step all the rays through their trees, one cell each per pass.
+    bool any_in_tree = n_active > 0;
+    while (any_in_tree)
+    {
+      any_in_tree = false;
+      for (unsigned k=0; k<N; ++k)
+      {
+        if (!in_tree[k]) continue;
+        if (!(ttree[k] < texit[k])) { in_tree[k] = false; continue; }
+        const float posx = (lx[k] + (ttree[k] + TREE_EPSILON)*dx[k]);
+        const float posy = (ly[k] + (ttree[k] + TREE_EPSILON)*dy[k]);
+        const float posz = (lz[k] + (ttree[k] + TREE_EPSILON)*dz[k]);
+        const boxm2_cast_ray_tree& tree = trees[tree_of[k]];
+        int depth;
+        const int bit_index = tree.traverse(posx, posy, posz, depth);
+        const float cell_len = cell_lens[depth];
+
+        float cell_minx = std::floor(posx/cell_len)* cell_len;
+        float cell_miny = std::floor(posy/cell_len)* cell_len;
+        float cell_minz = std::floor(posz/cell_len)* cell_len;
+        cell_minx = (dx[k] > 0.0f) ? cell_minx+cell_len : cell_minx;
+        cell_miny = (dy[k] > 0.0f) ? cell_miny+cell_len : cell_miny;
+        cell_minz = (dz[k] > 0.0f) ? cell_minz+cell_len : cell_minz;
+        const float t1 = std::min(std::min( (cell_minx-lx[k])*(1.0f/dx[k]), (cell_miny-ly[k])*(1.0f/dy[k])), (cell_minz-lz[k])*(1.0f/dz[k]));
+        if (t1 <= ttree[k]) { in_tree[k] = false; continue; }
+
+        const float d = (t1-ttree[k]) * linfo->block_len;
+        ttree[k] = t1;
+        functor.step_cell(d, tree.data_index(bit_index), pi[k], pj[k], (ttree[k] + tblock[k]) * linfo->block_len);
+        any_in_tree = true;
+      }
+    }
+
+    for (unsigned k=0; k<N; ++k)
+      if (active[k])
+        tblock[k] = texit[k] + tblock[k] + BLOCK_EPSILON;
+  }
+}
+
+//: How cast_ray_per_block() may share the pixels of a functor between threads.
+enum boxm2_cast_ray_parallelism
+{
+  //: Rays are cast one after another, in the order of the pixels.
+  boxm2_cast_ray_serial,
+  //: step_cell() writes only to data belonging to pixel (i,j).
+  // Tiles of pixels are cast concurrently, each with its own copy of the functor.
+  boxm2_cast_ray_per_pixel,
+  //: As boxm2_cast_ray_per_pixel, but step_cell() also adds into per-cell sums.
+  // The functor must provide
+  // \code
+  //   float* accumulator() const;             // the sums, e.g. the aux data
+  //   std::size_t accumulator_size() const;   // number of floats in the sums
+  //   void set_accumulator(float* sums);      // add into sums instead
+  // \endcode
+  // Each thread adds into a zeroed copy of the sums; the copies are then
+  // added to the functor's accumulator in a fixed order, so the result only
+  // depends on the number of threads, not on their timing.
+  boxm2_cast_ray_reduce
+};
+
+//: Declares how a functor may be used by several threads.
+// Specialise this next to the functor to make cast_ray_per_block() parallel.
+template <class F>
+struct boxm2_cast_ray_traits
+{
+  static const boxm2_cast_ray_parallelism parallelism = boxm2_cast_ray_serial;
+};
+
+//: Side of the square tiles of pixels handed to each thread.
+const unsigned boxm2_cast_ray_tile_size = 16;
+
+//: The cameras cast_ray_per_block() can cast rays from.
+struct boxm2_cast_ray_camera
+{
+  vpgl_generic_camera<double>* gcam;
+  vpgl_perspective_camera<double>* pcam;
+  //: Camera centre and inverse of the left 3x3 part of the perspective camera matrix.
+  vgl_point_3d<double> centre;
+  vnl_matrix_fixed<double,3,3> inv_m;
+
+  void set_perspective(vpgl_perspective_camera<double>* cam)
+  {
+    pcam = cam;
+    centre = cam->get_camera_center();
+    vnl_matrix_fixed<double,3,3> m;
+    for (unsigned r=0; r<3; ++r)
+      for (unsigned c=0; c<3; ++c)
+        m(r,c) = cam->get_matrix()(r,c);
+    inv_m = vnl_inverse(m);
+  }
+
+  //: The ray through pixel (i,j).
+  // For a perspective camera this is the same ray as backproject(), whose
+  // point in front of the camera is inv_m*(i,j,1) away from the centre
+  // (the matrix is normalised to a positive determinant), without solving
+  // for it pixel by pixel.
+  vgl_ray_3d<double> ray(unsigned i, unsigned j) const
+  {
+    if (gcam)
+      return gcam->ray(i,j);
+    const double u = i, v = j;
+    return vgl_ray_3d<double>(centre, vgl_vector_3d<double>(inv_m(0,0)*u + inv_m(0,1)*v + inv_m(0,2),
+                                                           inv_m(1,0)*u + inv_m(1,1)*v + inv_m(1,2),
+                                                           inv_m(2,0)*u + inv_m(2,1)*v + inv_m(2,2)));
+  }
+};
+
+//: Whether cast_ray_per_block() casts the rays of boxm2_cast_ray_per_pixel functors in packets.
+// On by default; the images are the same either way.
+inline bool& boxm2_cast_ray_use_packets()
+{
+  static bool use_packets = true;
+  return use_packets;
+}
+
+//: Tiles of the region [ni0,ni)x[nj0,nj).
+struct boxm2_cast_ray_tiles
+{
+  unsigned ni0, nj0, ni, nj;
+  unsigned n_tiles_i;
+
+  boxm2_cast_ray_tiles(unsigned roi_ni0, unsigned roi_nj0, unsigned roi_ni, unsigned roi_nj)
+    : ni0(roi_ni0), nj0(roi_nj0), ni(roi_ni), nj(roi_nj),
+      n_tiles_i(roi_ni > roi_ni0 ? (roi_ni-roi_ni0 + boxm2_cast_ray_tile_size-1)/boxm2_cast_ray_tile_size : 0) {}
+
+  unsigned size() const
+  {
+    return nj > nj0 ? n_tiles_i * ((nj-nj0 + boxm2_cast_ray_tile_size-1)/boxm2_cast_ray_tile_size) : 0;
+  }
+
+  //: Cast the rays through the pixels of tile t.
+  template <class F>
+  void cast(unsigned t, const F& functor, boxm2_scene_info* linfo, boxm2_block* blk,
+            const boxm2_cast_ray_camera& cam) const
+  {
+    const unsigned i0 = ni0 + (t % n_tiles_i) * boxm2_cast_ray_tile_size;
+    const unsigned j0 = nj0 + (t / n_tiles_i) * boxm2_cast_ray_tile_size;
+    const unsigned i1 = std::min(ni, i0 + boxm2_cast_ray_tile_size);
+    const unsigned j1 = std::min(nj, j0 + boxm2_cast_ray_tile_size);
+    for (unsigned i=i0;i<i1;++i)
+      for (unsigned j=j0;j<j1;++j)
+      {
+        vgl_ray_3d<double> ray_ij = cam.ray(i,j);
+        boxm2_cast_ray_function<F>(ray_ij,linfo,blk,i,j,functor);
+      }
+  }
+
+  //: Cast the rays through the pixels of tile t in packets of 2x2 pixels.
+  template <class F>
+  void cast_packets(unsigned t, F& functor, boxm2_scene_info* linfo, boxm2_block* blk,
+                    const boxm2_cast_ray_camera& cam) const
+  {
+    const unsigned i0 = ni0 + (t % n_tiles_i) * boxm2_cast_ray_tile_size;
+    const unsigned j0 = nj0 + (t / n_tiles_i) * boxm2_cast_ray_tile_size;
+    const unsigned i1 = std::min(ni, i0 + boxm2_cast_ray_tile_size);
+    const unsigned j1 = std::min(nj, j0 + boxm2_cast_ray_tile_size);
+    vgl_ray_3d<double> rays[boxm2_cast_ray_packet_size];
+    unsigned pi[boxm2_cast_ray_packet_size], pj[boxm2_cast_ray_packet_size];
+    for (unsigned j=j0;j<j1;j+=2)
+      for (unsigned i=i0;i<i1;i+=2)
+      {
+        unsigned n = 0;
+        for (unsigned dj=0; dj<2 && j+dj<j1; ++dj)
+          for (unsigned di=0; di<2 && i+di<i1; ++di, ++n)
+          {
+            pi[n] = i+di;  pj[n] = j+dj;
+            rays[n] = cam.ray(pi[n],pj[n]);
+          }
+        boxm2_cast_ray_packet_function<F>(rays,pi,pj,n,linfo,blk,functor);
+      }
+  }
+};
+
+//: Casts each tile with a copy of the functor, in whatever order threads take them.
+// The rays of a tile are cast in packets when \p packets is set.
+template <class F>
+class boxm2_cast_ray_tile_job : public vil_parallel_job
+{
+ public:
+  boxm2_cast_ray_tile_job(const F& functor, boxm2_scene_info* linfo, boxm2_block* blk,
+                          const boxm2_cast_ray_camera& cam, const boxm2_cast_ray_tiles& tiles,
+                          bool packets)
+    : functor_(functor), linfo_(linfo), blk_(blk), cam_(cam), tiles_(tiles), packets_(packets) {}
+
+  virtual void run(unsigned t) VXL_OVERRIDE
+  {
+    if (packets_)
+    {
+      F functor(functor_);
+      tiles_.cast_packets(t, functor, linfo_, blk_, cam_);
+    }
+    else
+      tiles_.cast(t, functor_, linfo_, blk_, cam_);
+  }
+
+ private:
+  const F& functor_;
+  boxm2_scene_info* linfo_;
+  boxm2_block* blk_;
+  boxm2_cast_ray_camera cam_;
+  boxm2_cast_ray_tiles tiles_;
+  bool packets_;
+};
+
+//: Casts tiles s, s+n_slots, s+2*n_slots, ... into the accumulator of slot s.
+template <class F>
+class boxm2_cast_ray_reduce_job : public vil_parallel_job
+{
+ public:
+  boxm2_cast_ray_reduce_job(const std::vector<F>& functors, boxm2_scene_info* linfo, boxm2_block* blk,
+                            const boxm2_cast_ray_camera& cam, const boxm2_cast_ray_tiles& tiles)
+    : functors_(functors), linfo_(linfo), blk_(blk), cam_(cam), tiles_(tiles) {}
+
+  virtual void run(unsigned s) VXL_OVERRIDE
+  {
+    const unsigned n_tiles = tiles_.size();
+    for (unsigned t = s; t < n_tiles; t += unsigned(functors_.size()))
+      tiles_.cast(t, functors_[s], linfo_, blk_, cam_);
+  }
+
+ private:
+  const std::vector<F>& functors_;
+  boxm2_scene_info* linfo_;
+  boxm2_block* blk_;
+  boxm2_cast_ray_camera cam_;
+  boxm2_cast_ray_tiles tiles_;
+};
+
+//: Adds the slots' sums into the functor's accumulator, one range of cells per call.
+class boxm2_cast_ray_sum_job : public vil_parallel_job
+{
+ public:
+  boxm2_cast_ray_sum_job(float* sums, const std::vector<std::vector<float> >& slots, unsigned n_ranges)
+    : sums_(sums), slots_(slots), n_ranges_(n_ranges) {}
+
+  virtual void run(unsigned r) VXL_OVERRIDE
+  {
+    const std::size_t n = slots_[0].size();
+    const std::size_t b = n * r / n_ranges_, e = n * (r+1) / n_ranges_;
+    for (std::size_t s = 0; s < slots_.size(); ++s)
+    {
+      const float* slot = &slots_[s][0];
+      for (std::size_t k = b; k < e; ++k)
+        sums_[k] += slot[k];
+    }
+  }
+
+ private:
+  float* sums_;
+  const std::vector<std::vector<float> >& slots_;
+  unsigned n_ranges_;
+};
+
+template <boxm2_cast_ray_parallelism P> struct boxm2_cast_ray_mode {};
+
+template <class F>
+void boxm2_cast_rays(const F& functor, boxm2_scene_info* linfo, boxm2_block* blk,
+                     const boxm2_cast_ray_camera& cam, const boxm2_cast_ray_tiles& tiles,
+                     boxm2_cast_ray_mode<boxm2_cast_ray_serial>)
+{
+  for (unsigned i=tiles.ni0;i<tiles.ni;++i)
+  {
+    if (cam.pcam && i%10==0) std::cout<<'.'<<std::flush;
+    for (unsigned j=tiles.nj0;j<tiles.nj;++j)
+    {
+      vgl_ray_3d<double> ray_ij = cam.ray(i,j);
+      boxm2_cast_ray_function<F>(ray_ij,linfo,blk,i,j,functor);
+    }
+  }
+}
+
+template <class F>
+void boxm2_cast_rays(const F& functor, boxm2_scene_info* linfo, boxm2_block* blk,
+                     const boxm2_cast_ray_camera& cam, const boxm2_cast_ray_tiles& tiles,
+                     boxm2_cast_ray_mode<boxm2_cast_ray_per_pixel>)
+{
+  boxm2_cast_ray_tile_job<F> job(functor, linfo, blk, cam, tiles, boxm2_cast_ray_use_packets());
+  vil_parallel_run(job, tiles.size());
+}
+
+template <class F>
+void boxm2_cast_rays(const F& functor, boxm2_scene_info* linfo, boxm2_block* blk,
+                     const boxm2_cast_ray_camera& cam, const boxm2_cast_ray_tiles& tiles,
+                     boxm2_cast_ray_mode<boxm2_cast_ray_reduce>)
+{
+  const unsigned n_slots = std::min(vil_parallel_max_threads(), tiles.size());
+  if (n_slots <= 1)
+  {
+    boxm2_cast_rays(functor, linfo, blk, cam, tiles, boxm2_cast_ray_mode<boxm2_cast_ray_serial>());
+    return;
+  }
+  std::vector<std::vector<float> > sums(n_slots, std::vector<float>(functor.accumulator_size(), 0.0f));
+  std::vector<F> functors(n_slots, functor);
+  for (unsigned s = 0; s < n_slots; ++s)
+    functors[s].set_accumulator(&sums[s][0]);
+  boxm2_cast_ray_reduce_job<F> job(functors, linfo, blk, cam, tiles);
+  vil_parallel_run(job, n_slots, n_slots);
+
+  const unsigned n_ranges = n_slots * 4;
+  boxm2_cast_ray_sum_job sum_job(functor.accumulator(), sums, n_ranges);
+  vil_parallel_run(sum_job, n_ranges);
+}
+
+//: Cast a ray through every pixel of the region of interest, through one block.
+// The pixels are shared between vil_parallel_max_threads() threads when
+// boxm2_cast_ray_traits<functor_type> allows it; the rays of per-pixel
+// functors are also cast in packets, see boxm2_cast_ray_packet_function().
 template <class functor_type>
 bool cast_ray_per_block(functor_type functor,
                         boxm2_scene_info * linfo,
@@ -177,32 +650,22 @@ bool cast_ray_per_block(functor_type functor,
                         unsigned int roi_ni0=0,
                         unsigned int roi_nj0=0)
 {
-  if (vpgl_generic_camera<double>* gcam =
-      dynamic_cast<vpgl_generic_camera<double>*>(cam.ptr()))
+  boxm2_cast_ray_camera ray_cam;
+  ray_cam.gcam = dynamic_cast<vpgl_generic_camera<double>*>(cam.ptr());
+  ray_cam.pcam = VXL_NULLPTR;
+  if (!ray_cam.gcam)
   {
-    for (unsigned i=roi_ni0;i<roi_ni;++i)
-    {
-      for (unsigned j=roi_nj0;j<roi_nj;++j)
-      {
-        vgl_ray_3d<double> ray_ij = gcam->ray(i,j);
-        boxm2_cast_ray_function<functor_type>(ray_ij,linfo,blk_sptr,i,j,functor);
-      }
-    }
-    return true;
-  }
-  else if (cam->type_name()== "vpgl_perspective_camera") {
-    for (unsigned i=roi_ni0;i<roi_ni;++i) {
-      if (i%10==0) std::cout<<'.'<<std::flush;
-      for (unsigned j=roi_nj0;j<roi_nj;++j) {
-        vgl_ray_3d<double> ray_ij =  ((vpgl_perspective_camera<double>*) cam.ptr())->backproject(i,j);
-        boxm2_cast_ray_function<functor_type>(ray_ij,linfo,blk_sptr,i,j,functor);
-      }
+    if (cam->type_name()!= "vpgl_perspective_camera") {
+      std::cout<<"boxm2_cast_ray_function cannot dynamic cast camera"<<std::endl;
+      return false;
     }
-    return true;
+    ray_cam.set_perspective((vpgl_perspective_camera<double>*) cam.ptr());
   }
 
-  std::cout<<"boxm2_cast_ray_function cannot dynamic cast camera"<<std::endl;
-  return false;
+  boxm2_cast_ray_tiles tiles(roi_ni0, roi_nj0, roi_ni, roi_nj);
+  const boxm2_cast_ray_parallelism parallelism = boxm2_cast_ray_traits<functor_type>::parallelism;
+  boxm2_cast_rays(functor, linfo, blk_sptr, ray_cam, tiles, boxm2_cast_ray_mode<parallelism>());
+  return true;
 }
 
 
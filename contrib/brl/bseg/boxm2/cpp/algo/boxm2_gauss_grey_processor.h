@@ -23,6 +23,8 @@ class  boxm2_gauss_grey_processor
 {
  public:
      static float expected_color( vnl_vector_fixed<unsigned char, 2> apm);
+     //: the components expected_color() reads: just the mean
+     static const unsigned expected_color_components = 0x1;
      static float prob_density( const vnl_vector_fixed<unsigned char, 2> & apm, float x);
      static float gauss_prob_density(float x, float mu, float sigma);
      static void  update_app_model(vnl_vector_fixed<unsigned char, 2> & apm,
@@ -26,6 +26,8 @@ class  boxm2_mog3_grey_processor
 {
  public:
      static float expected_color( vnl_vector_fixed<unsigned char, 8> mog3);
+     //: the components expected_color() reads: the means and the two stored weights
+     static const unsigned expected_color_components = 0x6d;
      static float prob_density( const vnl_vector_fixed<unsigned char, 8> & mog3, float x);
      static float gauss_prob_density(float x, float mu, float sigma);
      static void  update_gauss_mixture_3(vnl_vector_fixed<unsigned char, 8> & mog3,
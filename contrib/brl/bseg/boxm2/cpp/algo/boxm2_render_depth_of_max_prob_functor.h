@@ -49,4 +49,10 @@ class boxm2_render_depth_of_max_prob_functor
   vil_image_view<float> *max_prob_img_;
 };
 
+template <>
+struct boxm2_cast_ray_traits<boxm2_render_depth_of_max_prob_functor>
+{
+  static const boxm2_cast_ray_parallelism parallelism = boxm2_cast_ray_per_pixel;
+};
+
 #endif
@@ -44,4 +44,10 @@ class boxm2_render_exp_depth_functor
   vil_image_view<float> *len_img_;
 };
 
+template <>
+struct boxm2_cast_ray_traits<boxm2_render_exp_depth_functor>
+{
+  static const boxm2_cast_ray_parallelism parallelism = boxm2_cast_ray_per_pixel;
+};
+
 #endif
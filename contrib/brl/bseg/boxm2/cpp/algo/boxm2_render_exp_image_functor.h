@@ -36,6 +36,12 @@ class boxm2_render_vis_image_functor
   vil_image_view<float> *vis_img_;
 };
 
+template <>
+struct boxm2_cast_ray_traits<boxm2_render_vis_image_functor>
+{
+  static const boxm2_cast_ray_parallelism parallelism = boxm2_cast_ray_per_pixel;
+};
+
 template <boxm2_data_type APM_TYPE>
 class boxm2_render_exp_image_functor
 {
@@ -43,10 +49,15 @@ class boxm2_render_exp_image_functor
   // "default" constructor
   boxm2_render_exp_image_functor() {}
 
-  inline bool init_data(std::vector<boxm2_data_base*> & datas, vil_image_view<float> * expected, vil_image_view<float>* vis_img)
+  //: if soa, the appearance data are stored as a structure of arrays, and only the components needed are read
+  inline bool init_data(std::vector<boxm2_data_base*> & datas, vil_image_view<float> * expected, vil_image_view<float>* vis_img,
+                        bool soa = false)
   {
     alpha_data_=new boxm2_data<BOXM2_ALPHA>(datas[0]->data_buffer(),datas[0]->buffer_length(),datas[0]->block_id());
     mog3_data_=new boxm2_data<APM_TYPE>(datas[1]->data_buffer(),datas[1]->buffer_length(),datas[1]->block_id());
+    soa_ = soa;
+    if (soa_)
+      mog3_soa_ = mog3_data_->soa();
     expected_img_=expected;
     vis_img_     =vis_img;
     return true;
@@ -58,7 +69,9 @@ class boxm2_render_exp_image_functor
     float vis=(*vis_img_)(i,j);
     float exp_int=(*expected_img_)(i,j);
     float curr_p=(1-std::exp(-alpha*seg_len))*vis;
-    float exp_color = boxm2_processor_type<APM_TYPE>::type::expected_color(mog3_data_->data()[index]);
+    typedef typename boxm2_processor_type<APM_TYPE>::type processor;
+    float exp_color = processor::expected_color(soa_ ? mog3_soa_.get(index, processor::expected_color_components)
+                                                     : mog3_data_->data()[index]);
     exp_int += curr_p * exp_color;
     (*expected_img_)(i,j)=exp_int;
     vis*=std::exp(-alpha*seg_len);
@@ -69,10 +82,18 @@ class boxm2_render_exp_image_functor
  private:
   boxm2_data<BOXM2_ALPHA> * alpha_data_;
   boxm2_data<APM_TYPE> * mog3_data_;
+  boxm2_data_soa<APM_TYPE> mog3_soa_;
+  bool soa_;
   vil_image_view<float> *expected_img_;
   vil_image_view<float> *vis_img_;
 };
 
+template <boxm2_data_type APM_TYPE>
+struct boxm2_cast_ray_traits<boxm2_render_exp_image_functor<APM_TYPE> >
+{
+  static const boxm2_cast_ray_parallelism parallelism = boxm2_cast_ray_per_pixel;
+};
+
 //: Functor class to normalize expected image
 class normalize_intensity
 {
@@ -18,14 +18,14 @@ void boxm2_render_expected_image( boxm2_scene_info * linfo,
   if ( data_type.find(boxm2_data_traits<BOXM2_MOG3_GREY>::prefix()) != std::string::npos )
   {
     boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> render_functor;
-    render_functor.init_data(datas,expected,vis);
+    render_functor.init_data(datas,expected,vis,boxm2_data_is_soa(data_type));
     cast_ray_per_block<boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> >
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
   }
   else if (data_type.find(boxm2_data_traits<BOXM2_GAUSS_GREY>::prefix()) != std::string::npos )
   {
     boxm2_render_exp_image_functor<BOXM2_GAUSS_GREY> render_functor;
-    render_functor.init_data(datas,expected,vis);
+    render_functor.init_data(datas,expected,vis,boxm2_data_is_soa(data_type));
     cast_ray_per_block<boxm2_render_exp_image_functor<BOXM2_GAUSS_GREY> >
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
   }
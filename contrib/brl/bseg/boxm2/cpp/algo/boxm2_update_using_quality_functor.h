@@ -24,6 +24,7 @@ class boxm2_update_using_quality_pass2_functor
                  vil_image_view<float> * norm_img, vil_image_view<float> * quality_img)
   {
     aux_data_=new boxm2_data<BOXM2_AUX>(datas[0]->data_buffer(),datas[0]->buffer_length(),datas[0]->block_id());
+    sums_=accumulator();
     alpha_data_=new boxm2_data<BOXM2_ALPHA>(datas[1]->data_buffer(),datas[1]->buffer_length(),datas[1]->block_id());
     mog3_data_=new boxm2_data<APM_TYPE>(datas[2]->data_buffer(),datas[2]->buffer_length(),datas[2]->block_id());
     pre_img_=pre_img;
@@ -35,8 +36,9 @@ class boxm2_update_using_quality_pass2_functor
 
   inline bool step_cell(float seg_len,int index,unsigned i,unsigned j, float abs_depth=0.0f)
   {
-    boxm2_data<BOXM2_AUX>::datatype & aux=aux_data_->data()[index];
+    const boxm2_data<BOXM2_AUX>::datatype & aux=aux_data_->data()[index];
     if (aux[0]<1e-10f)return true;
+    float* sums=sums_+4*index;
     float mean_obs=aux[1]/aux[0];
     float PI=boxm2_processor_type<APM_TYPE>::type::prob_density(mog3_data_->data()[index], mean_obs);
 
@@ -47,9 +49,9 @@ class boxm2_update_using_quality_pass2_functor
     float omega=(1-std::exp(-seg_len*alpha));
     if ((*norm_img_)(i,j)>1e-10f)
     {
-      aux[2]+=( ((pre+vis*PI)*(*quality_img_)(i,j) + (1.0f - (*quality_img_)(i,j)) ) / ((*norm_img_)(i,j)*(*quality_img_)(i,j) + (1.0f - (*quality_img_)(i,j))) * seg_len);
+      sums[2]+=( ((pre+vis*PI)*(*quality_img_)(i,j) + (1.0f - (*quality_img_)(i,j)) ) / ((*norm_img_)(i,j)*(*quality_img_)(i,j) + (1.0f - (*quality_img_)(i,j))) * seg_len);
       //aux[3]+=vis*(*quality_img_)(i,j)*seg_len;
-      aux[3] += ( (pre+vis*PI)*(*quality_img_)(i,j) / ( (pre+vis*PI)*(*quality_img_)(i,j) + (1.0f - (*quality_img_)(i,j)) ) )*seg_len;
+      sums[3] += ( (pre+vis*PI)*(*quality_img_)(i,j) / ( (pre+vis*PI)*(*quality_img_)(i,j) + (1.0f - (*quality_img_)(i,j)) ) )*seg_len;
     }
     pre+=vis*omega*PI;
     vis=vis*(1-omega);
@@ -57,8 +59,14 @@ class boxm2_update_using_quality_pass2_functor
     (*pre_img_)(i,j)=pre;
     return true;
   }
+
+  //: The per-cell sums, as floats; see boxm2_cast_ray_reduce.
+  float* accumulator() const { return reinterpret_cast<float*>(aux_data_->data_buffer()); }
+  std::size_t accumulator_size() const { return aux_data_->buffer_length()/sizeof(float); }
+  void set_accumulator(float* sums) { sums_ = sums; }
  private:
   boxm2_data<BOXM2_AUX> * aux_data_;
+  float * sums_;
   boxm2_data<BOXM2_ALPHA> * alpha_data_;
   boxm2_data<APM_TYPE> * mog3_data_;
   vil_image_view<float> * pre_img_;
@@ -67,6 +75,12 @@ class boxm2_update_using_quality_pass2_functor
   vil_image_view<float> * quality_img_;
 };
 
+template <boxm2_data_type APM_TYPE>
+struct boxm2_cast_ray_traits<boxm2_update_using_quality_pass2_functor<APM_TYPE> >
+{
+  static const boxm2_cast_ray_parallelism parallelism = boxm2_cast_ray_reduce;
+};
+
 template <boxm2_data_type APM_TYPE>
 class boxm2_update_using_quality_functor
 {
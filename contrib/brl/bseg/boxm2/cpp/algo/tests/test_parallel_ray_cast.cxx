@@ -0,0 +1,205 @@
+//:
+// \file
+// \brief Check that casting rays on several threads gives the serial results.
+
+#include <cmath>
+#include <cstring>
+#include <testlib/testlib_test.h>
+#include <vgl/vgl_point_3d.h>
+#include <vpgl/vpgl_perspective_camera.h>
+#include <vil/vil_image_view.h>
+#include <vil/vil_parallel.h>
+
+#include <boct/boct_bit_tree.h>
+
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/boxm2_data_soa.h>
+#include <boxm2/boxm2_block_metadata.h>
+#include <boxm2/io/boxm2_lru_cache.h>
+#include <boxm2/cpp/algo/boxm2_render_functions.h>
+#include <boxm2/cpp/algo/boxm2_update_image_functor.h>
+
+//: A camera 10 units above the unit square, looking down.
+static vpgl_camera_double_sptr parallel_test_camera(unsigned ni, unsigned nj)
+{
+  vpgl_calibration_matrix<double> K(ni * 8.0, vgl_point_2d<double>(ni/2.0, nj/2.0));
+  vnl_matrix_fixed<double, 3, 3> mr(0.0);
+  mr[0][0]=1.0; mr[1][1]=-1.0; mr[2][2]=-1.0;
+  vgl_rotation_3d<double> R(mr);
+  return new vpgl_perspective_camera<double>(K, vgl_point_3d<double>(0.45,0.55,10), R);
+}
+
+static bool same_image(const vil_image_view<float>& a, const vil_image_view<float>& b)
+{
+  for (unsigned j=0; j<a.nj(); ++j)
+    for (unsigned i=0; i<a.ni(); ++i)
+      if (a(i,j) != b(i,j))
+        return false;
+  return true;
+}
+
+void test_parallel_ray_cast()
+{
+  boxm2_scene_sptr scene = new boxm2_scene();
+  scene->set_local_origin( vgl_point_3d<double>(0,0,0) );
+  std::map<boxm2_block_id, boxm2_block_metadata> blocks;
+  boxm2_block_id id(0,0,0);
+  boxm2_block_metadata data(id,
+                            vgl_point_3d<double>(0,0,0),
+                            vgl_vector_3d<double>(1.0/16.0, 1.0/16.0, 1.0/16.0),
+                            vgl_vector_3d<unsigned>(16,16,4),
+                            1, 1, 100,0.0);
+  blocks[id] = data;
+  scene->set_blocks(blocks);
+  std::vector<std::string> appearances;
+  appearances.push_back(boxm2_data_traits<BOXM2_MOG3_GREY>::prefix());
+  scene->set_appearances(appearances);
+  boxm2_scene_info* info = scene->get_blk_metadata(id);
+
+  boxm2_lru_cache::create(scene);
+  boxm2_block* blk = boxm2_cache::instance()->get_block(scene,id);
+  boxm2_data_base * alph = boxm2_cache::instance()->get_data_base(scene,id,boxm2_data_traits<BOXM2_ALPHA>::prefix());
+  boxm2_data_base * mog  = boxm2_cache::instance()->get_data_base(scene,id,boxm2_data_traits<BOXM2_MOG3_GREY>::prefix());
+  // These share the cache's buffers, so are never deleted.
+  boxm2_data<BOXM2_ALPHA>& alpha_data = *new boxm2_data<BOXM2_ALPHA>(alph->data_buffer(),alph->buffer_length(),alph->block_id());
+  boxm2_data<BOXM2_MOG3_GREY>& mog3_data = *new boxm2_data<BOXM2_MOG3_GREY>(mog->data_buffer(),mog->buffer_length(),mog->block_id());
+
+  // Semi-transparent cells of varying colour
+  typedef vnl_vector_fixed<vxl_byte, 16> uchar16;
+  for (int x=0; x<16; ++x)
+    for (int y=0; y<16; ++y)
+      for (int z=0; z<4; ++z)
+      {
+        uchar16 tree = blk->trees()(x,y,z);
+        boct_bit_tree bit_tree( (unsigned char*)tree.data_block(), info->root_level+1);
+        int data_ptr = bit_tree.get_data_ptr();
+        alpha_data.data()[data_ptr] = float((x*7 + y*3 + z*5) % 11) * 2.0f;
+        mog3_data.data()[data_ptr] = boxm2_data<BOXM2_MOG3_GREY>::datatype( (vxl_byte) ((x*37 + y*11 + z*59) % 256));
+      }
+
+  std::vector<boxm2_data_base*> datas;
+  datas.push_back(alph); datas.push_back(mog);
+  const unsigned ni=100, nj=90;
+  vpgl_camera_double_sptr cam = parallel_test_camera(ni, nj);
+
+  // Rendering writes only to the ray's own pixel, so any number of threads
+  // gives exactly the same image.
+  vil_image_view<float> expected[2], vis[2];
+  for (unsigned t=0; t<2; ++t)
+  {
+    vil_parallel_set_max_threads(t == 0 ? 1 : 4);
+    expected[t].set_size(ni,nj);  expected[t].fill(0.0f);
+    vis[t].set_size(ni,nj);       vis[t].fill(1.0f);
+    boxm2_render_expected_image(info, blk, datas, cam, &expected[t], &vis[t], ni, nj);
+  }
+  TEST("Something was rendered", vis[0](ni/2,nj/2) < 1.0f && expected[0](ni/2,nj/2) > 0.0f, true);
+  TEST("Expected image is the same on 4 threads", same_image(expected[0], expected[1]), true);
+  TEST("Visibility image is the same on 4 threads", same_image(vis[0], vis[1]), true);
+
+  // A sub-region only touches its own pixels
+  vil_image_view<float> roi_expected(ni,nj), roi_vis(ni,nj);
+  roi_expected.fill(0.0f);  roi_vis.fill(1.0f);
+  boxm2_render_expected_image(info, blk, datas, cam, &roi_expected, &roi_vis, 70, 60, 13, 21);
+  bool roi_ok = true;
+  for (unsigned j=0; j<nj; ++j)
+    for (unsigned i=0; i<ni; ++i)
+    {
+      bool inside = i>=13 && i<70 && j>=21 && j<60;
+      roi_ok = roi_ok && roi_expected(i,j) == (inside ? expected[0](i,j) : 0.0f);
+    }
+  TEST("Region of interest", roi_ok, true);
+
+  // Rays cast in packets visit the same cells as rays cast one at a time.
+  // (The images above were cast in packets, which is the default.)
+  boxm2_cast_ray_use_packets() = false;
+  vil_parallel_set_max_threads(1);
+  vil_image_view<float> single_expected(ni,nj), single_vis(ni,nj);
+  single_expected.fill(0.0f);  single_vis.fill(1.0f);
+  boxm2_render_expected_image(info, blk, datas, cam, &single_expected, &single_vis, ni, nj);
+  boxm2_cast_ray_use_packets() = true;
+  TEST("Expected image is the same when cast in packets", same_image(expected[0], single_expected), true);
+  TEST("Visibility image is the same when cast in packets", same_image(vis[0], single_vis), true);
+
+  // Appearance stored as a structure of arrays renders the same
+  const std::string mog3_prefix = boxm2_data_traits<BOXM2_MOG3_GREY>::prefix();
+  char* soa_buffer = new char[mog->buffer_length()];
+  boxm2_data_convert_layout(mog3_prefix, mog->data_buffer(), soa_buffer, mog->buffer_length(), true);
+  boxm2_data_base soa_mog(soa_buffer, mog->buffer_length(), id);
+  std::vector<boxm2_data_base*> soa_datas;
+  soa_datas.push_back(alph); soa_datas.push_back(&soa_mog);
+  vil_image_view<float> soa_expected(ni,nj), soa_vis(ni,nj);
+  soa_expected.fill(0.0f);  soa_vis.fill(1.0f);
+  boxm2_render_expected_image(info, blk, soa_datas, cam, &soa_expected, &soa_vis, ni, nj, 0, 0, boxm2_data_soa_prefix(mog3_prefix));
+  TEST("Expected image is the same from a structure of arrays", same_image(expected[0], soa_expected), true);
+
+  // Rays are generated without back-projecting each pixel
+  boxm2_cast_ray_camera ray_cam;
+  ray_cam.gcam = VXL_NULLPTR;
+  ray_cam.set_perspective((vpgl_perspective_camera<double>*)cam.ptr());
+  double max_ray_diff = 0.0;
+  for (unsigned j=0; j<nj; j+=7)
+    for (unsigned i=0; i<ni; i+=5)
+    {
+      vgl_ray_3d<double> a = ray_cam.ray(i,j), b = ((vpgl_perspective_camera<double>*)cam.ptr())->backproject(i,j);
+      max_ray_diff = std::max(max_ray_diff, (a.origin()-b.origin()).length() + (a.direction()-b.direction()).length());
+    }
+  TEST_NEAR("Rays match backproject()", max_ray_diff, 0.0, 1e-12);
+
+  // A packet of rays that leave the scene at different blocks, or miss it
+  boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> render;
+  vil_image_view<float> packet_expected(4,1), packet_vis(4,1), ray_expected(4,1), ray_vis(4,1);
+  packet_expected.fill(0.0f);  packet_vis.fill(1.0f);
+  ray_expected.fill(0.0f);     ray_vis.fill(1.0f);
+  vgl_ray_3d<double> rays[4] = {
+    vgl_ray_3d<double>(vgl_point_3d<double>(0.5,0.5,10), vgl_vector_3d<double>(0,0,-1)),
+    vgl_ray_3d<double>(vgl_point_3d<double>(-0.5,0.3,0.1), vgl_vector_3d<double>(1,0.2,0.05)),
+    vgl_ray_3d<double>(vgl_point_3d<double>(0.2,0.9,0.2), vgl_vector_3d<double>(0.3,-1,0)),
+    vgl_ray_3d<double>(vgl_point_3d<double>(5,5,5), vgl_vector_3d<double>(1,1,1)) };
+  unsigned pi[4] = { 0, 1, 2, 3 }, pj[4] = { 0, 0, 0, 0 };
+  render.init_data(datas, &packet_expected, &packet_vis);
+  boxm2_cast_ray_packet_function(rays, pi, pj, 4, info, blk, render);
+  render.init_data(datas, &ray_expected, &ray_vis);
+  for (unsigned k=0; k<4; ++k)
+    boxm2_cast_ray_function(rays[k], info, blk, pi[k], pj[k], render);
+  TEST("Diverging rays in a packet", same_image(packet_expected, ray_expected) && same_image(packet_vis, ray_vis), true);
+  TEST("Rays in the packet hit cells", packet_vis(1,0) < 1.0f && packet_vis(2,0) < 1.0f && packet_vis(3,0) == 1.0f, true);
+
+  // Update pass 0 adds into per-cell sums; on several threads the sums are
+  // reduced in a fixed order, so only rounding differs from one thread.
+  vil_image_view<float> input(ni,nj);
+  for (unsigned j=0; j<nj; ++j)
+    for (unsigned i=0; i<ni; ++i)
+      input(i,j) = float((i*13 + j*7) % 17) / 17.0f;
+  const std::size_t aux_len = alph->buffer_length() / sizeof(float) * sizeof(boxm2_data_traits<BOXM2_AUX>::datatype);
+  std::vector<std::vector<float> > sums;
+  const unsigned threads[] = { 1, 4, 4, 3 };
+  for (unsigned t=0; t<4; ++t)
+  {
+    vil_parallel_set_max_threads(threads[t]);
+    char* buffer = new char[aux_len];
+    std::memset(buffer, 0, aux_len);
+    boxm2_data_base aux(buffer, aux_len, id, false);
+    std::vector<boxm2_data_base*> aux_datas(1, &aux);
+    boxm2_update_pass0_functor pass0;
+    pass0.init_data(aux_datas, &input);
+    cast_ray_per_block<boxm2_update_pass0_functor>(pass0, info, blk, cam, ni, nj);
+    const float* p = reinterpret_cast<const float*>(aux.data_buffer());
+    sums.push_back(std::vector<float>(p, p + aux_len/sizeof(float)));
+  }
+  vil_parallel_set_max_threads(0);
+
+  double total = 0.0, max_diff = 0.0;
+  for (std::size_t k=0; k<sums[0].size(); ++k)
+  {
+    total += sums[0][k];
+    for (unsigned t=1; t<4; ++t)
+      max_diff = std::max(max_diff, (double)std::fabs(sums[t][k] - sums[0][k]) / (1.0 + std::fabs(sums[0][k])));
+  }
+  TEST("Rays reached the cells", total > 0.0, true);
+  TEST_NEAR("Parallel sums match serial sums", max_diff, 0.0, 1e-5);
+  TEST("Parallel sums are repeatable", sums[1] == sums[2], true);
+}
+
+TESTMAIN(test_parallel_ray_cast);
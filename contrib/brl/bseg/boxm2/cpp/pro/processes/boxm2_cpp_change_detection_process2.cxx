@@ -11,6 +11,7 @@
 
 #include <vcl_compiler.h>
 #include <boxm2/io/boxm2_cache.h>
+#include <boxm2/boxm2_data_soa.h>
 #include <boxm2/boxm2_scene.h>
 #include <boxm2/boxm2_block.h>
 #include <boxm2/boxm2_data_base.h>
@@ -93,6 +94,8 @@ bool boxm2_cpp_change_detection_process2(bprb_func_process& pro)
   if (identifier.size() > 0) {
     data_type += "_" + identifier;
   }
+  if (boxm2_data_reject_soa(data_type, pro.name()))
+    return false;
 
   vil_image_view_base_sptr in_float_img=boxm2_util::prepare_input_image(input_img);
   if (vil_image_view<float> * in_img=dynamic_cast<vil_image_view<float> *> ( in_float_img.ptr()))
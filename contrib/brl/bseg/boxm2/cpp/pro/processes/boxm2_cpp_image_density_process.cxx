@@ -11,6 +11,7 @@
 
 #include <vcl_compiler.h>
 #include <boxm2/io/boxm2_cache.h>
+#include <boxm2/boxm2_data_soa.h>
 #include <boxm2/boxm2_scene.h>
 #include <boxm2/boxm2_block.h>
 #include <boxm2/boxm2_data_base.h>
@@ -104,6 +105,8 @@ bool boxm2_cpp_image_density_process(bprb_func_process& pro)
   if (identifier.size() > 0) {
     data_type += "_" + identifier;
   }
+  if (boxm2_data_reject_soa(data_type, pro.name()))
+    return false;
   if (vil_image_view<float> * input_image=dynamic_cast<vil_image_view<float> * > (float_image.ptr()))
   {
     std::vector<boxm2_block_id> vis_order=scene->get_vis_blocks(reinterpret_cast<vpgl_generic_camera<double>*>(cam.ptr()));
@@ -249,6 +252,8 @@ bool boxm2_cpp_image_density_masked_process(bprb_func_process& pro)
   if (identifier.size() > 0) {
     data_type += "_" + identifier;
   }
+  if (boxm2_data_reject_soa(data_type, pro.name()))
+    return false;
   if (vil_image_view<float> * input_image=dynamic_cast<vil_image_view<float> * > (float_image.ptr()))
   {
     std::vector<boxm2_block_id> vis_order=scene->get_vis_blocks(reinterpret_cast<vpgl_generic_camera<double>*>(cam.ptr()));
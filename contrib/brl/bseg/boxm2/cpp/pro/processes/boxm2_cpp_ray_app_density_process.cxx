@@ -11,6 +11,7 @@
 
 #include <vcl_compiler.h>
 #include <boxm2/io/boxm2_cache.h>
+#include <boxm2/boxm2_data_soa.h>
 #include <boxm2/boxm2_scene.h>
 #include <boxm2/boxm2_block.h>
 #include <boxm2/boxm2_data_base.h>
@@ -99,6 +100,8 @@ bool boxm2_cpp_ray_app_density_process(bprb_func_process& pro)
     if (identifier.size() > 0) {
         data_type += "_" + identifier;
     }
+    if (boxm2_data_reject_soa(data_type, pro.name()))
+        return false;
 
     std::vector<boxm2_block_id> vis_order=scene->get_vis_blocks((vpgl_generic_camera<double>*)(cam.ptr()));
     std::vector<boxm2_block_id>::iterator id;
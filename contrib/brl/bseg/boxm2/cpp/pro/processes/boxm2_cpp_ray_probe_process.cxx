@@ -11,6 +11,7 @@
 
 #include <vcl_compiler.h>
 #include <boxm2/io/boxm2_cache.h>
+#include <boxm2/boxm2_data_soa.h>
 #include <boxm2/boxm2_scene.h>
 #include <boxm2/boxm2_block.h>
 #include <boxm2/boxm2_data_base.h>
@@ -94,6 +95,8 @@ bool boxm2_cpp_ray_probe_process(bprb_func_process& pro)
     if (identifier.size() > 0) {
         data_type += "_" + identifier;
     }
+    if (boxm2_data_reject_soa(data_type, pro.name()))
+        return false;
 
     std::vector<boxm2_block_id> vis_order=scene->get_vis_blocks((vpgl_perspective_camera<double>*)(cam.ptr()));
     double cone_half_angle, solid_angle;vgl_ray_3d<double> ray_ij;
@@ -11,6 +11,7 @@
 
 #include <vcl_compiler.h>
 #include <boxm2/io/boxm2_cache.h>
+#include <boxm2/boxm2_data_soa.h>
 #include <boxm2/boxm2_scene.h>
 #include <boxm2/boxm2_block.h>
 #include <boxm2/boxm2_data_base.h>
@@ -88,6 +89,8 @@ bool boxm2_cpp_refine_process2(bprb_func_process& pro)
     data_type += "_" + identifier;
     num_obs_type += "_" + identifier;
   }
+  if (boxm2_data_reject_soa(data_type, pro.name()))
+    return false;
 
   std::map<boxm2_block_id, boxm2_block_metadata> blocks = scene->blocks();
   std::map<boxm2_block_id, boxm2_block_metadata>::iterator blk_iter;
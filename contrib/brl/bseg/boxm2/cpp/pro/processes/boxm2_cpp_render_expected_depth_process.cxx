@@ -75,6 +75,8 @@ bool boxm2_cpp_render_expected_depth_process(bprb_func_process& pro)
   vis_img->fill(1.0f);
   len_img->fill(0.0f);
   std::vector<boxm2_block_id> vis_order=scene->get_vis_blocks((vpgl_generic_camera<double>*)(cam.ptr()));
+  // load the blocks further back while the nearer ones are rendered
+  cache->prefetch(scene, vis_order, std::vector<std::string>(1, boxm2_data_traits<BOXM2_ALPHA>::prefix()));
   std::vector<boxm2_block_id>::iterator id;
   for (id = vis_order.begin(); id != vis_order.end(); ++id)
   {
@@ -117,6 +117,11 @@ bool boxm2_cpp_render_expected_image_process(bprb_func_process& pro)
   {
     vis_order=scene->get_vis_blocks(reinterpret_cast<vpgl_generic_camera<double>*>(cam.ptr()));
   }
+  // load the blocks further back while the nearer ones are rendered
+  std::vector<std::string> prefetch_types;
+  prefetch_types.push_back(boxm2_data_traits<BOXM2_ALPHA>::prefix());
+  prefetch_types.push_back(data_type);
+  cache->prefetch(scene, vis_order, prefetch_types);
   std::vector<boxm2_block_id>::iterator id;
   for (id = vis_order.begin(); id != vis_order.end(); ++id)
   {
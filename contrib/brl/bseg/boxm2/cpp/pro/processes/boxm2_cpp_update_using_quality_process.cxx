@@ -12,6 +12,7 @@
 
 #include <vcl_compiler.h>
 #include <boxm2/io/boxm2_cache.h>
+#include <boxm2/boxm2_data_soa.h>
 #include <boxm2/boxm2_scene.h>
 #include <boxm2/boxm2_block.h>
 #include <boxm2/boxm2_data_base.h>
@@ -121,6 +122,8 @@ bool boxm2_cpp_update_using_quality_process(bprb_func_process& pro)
           if (foundNumObsType)
             num_obs_type += "_" + identifier;
         }
+        if (boxm2_data_reject_soa(data_type, pro.name()))
+          return false;
 
         std::cout<<"Update"<<std::endl;
         return boxm2_update_using_quality(scene,
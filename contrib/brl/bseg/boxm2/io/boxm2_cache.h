@@ -65,6 +65,11 @@ class boxm2_cache: public vbl_ref_count
   // -- generic method: does not do anything; see specialisations
   virtual void disable_write() {}
 
+  //: start loading blocks, and the given types of data, that will be needed soon
+  // -- generic method: does not do anything; see specialisations
+  virtual void prefetch(boxm2_scene_sptr & /*scene*/, std::vector<boxm2_block_id> const& /*ids*/,
+                        std::vector<std::string> const& /*types*/) {}
+
   virtual bool add_scene(boxm2_scene_sptr & scene) = 0;
 
   virtual bool remove_scene(boxm2_scene_sptr & scene) = 0;
@@ -18,8 +18,15 @@ void boxm2_lru_cache::create(boxm2_scene_sptr scene, BOXM2_IO_FS_TYPE fs_type)
 }
 
 //: constructor, set the directory path
-boxm2_lru_cache::boxm2_lru_cache(boxm2_scene_sptr scene, BOXM2_IO_FS_TYPE fs_type) : boxm2_cache(fs_type)
+boxm2_lru_cache::boxm2_lru_cache(boxm2_scene_sptr scene, BOXM2_IO_FS_TYPE fs_type)
+  : boxm2_cache(fs_type), bytes_(0), max_bytes_(0), generation_(0)
 {
+#if VXL_FULLCXX11SUPPORT
+  stop_prefetcher_ = false;
+  prefetching_ = false;
+#else
+  mutex_ = 0;
+#endif
   cached_blocks_[scene] = std::map<boxm2_block_id, boxm2_block*>();
   cached_data_[scene] = std::map<std::string, std::map<boxm2_block_id, boxm2_data_base*> >();
 }
@@ -28,6 +35,7 @@ boxm2_lru_cache::boxm2_lru_cache(boxm2_scene_sptr scene, BOXM2_IO_FS_TYPE fs_typ
 //: return list of scenes with data in the cache
 std::vector<boxm2_scene_sptr> boxm2_lru_cache::get_scenes()
 {
+  lock_type lock(mutex_);
   std::set<boxm2_scene_sptr > scenes;
   for (std::map< boxm2_scene_sptr, std::map<boxm2_block_id, boxm2_block*>,ltstr1 >::const_iterator it=cached_blocks_.begin();
        it != cached_blocks_.end(); ++it) {
@@ -46,13 +54,31 @@ std::vector<boxm2_scene_sptr> boxm2_lru_cache::get_scenes()
 //: destructor flushes the memory for currently ongoing asynchronous requests
 boxm2_lru_cache::~boxm2_lru_cache()
 {
-    this->clear_cache();
+#if VXL_FULLCXX11SUPPORT
+  {
+    lock_type lock(mutex_);
+    stop_prefetcher_ = true;
+    prefetch_queue_.clear();
+    prefetch_cond_.notify_all();
+  }
+  if (prefetcher_.joinable())
+    prefetcher_.join();
+#endif
+  this->clear_cache();
 }
 
 //: delete all the memory
 //  Caution: make sure to call write to disk methods not to loose writable data
 void boxm2_lru_cache::clear_cache()
 {
+  lock_type lock(mutex_);
+  // loads in progress are dropped when they finish
+  ++generation_;
+  prefetch_queue_.clear();
+  lru_.clear();
+  lru_pos_.clear();
+  pins_.clear();
+  bytes_ = 0;
   std::map<boxm2_scene_sptr, std::map<std::string, std::map<boxm2_block_id, boxm2_data_base*> >,ltstr1 >::iterator scene_iter = cached_data_.begin();
   for(;scene_iter!=cached_data_.end(); scene_iter++)
   {
@@ -87,59 +113,91 @@ void boxm2_lru_cache::clear_cache()
 //: realization of abstract "get_block(block_id)"
 boxm2_block* boxm2_lru_cache::get_block(boxm2_scene_sptr & scene, boxm2_block_id id)
 {
-  boxm2_block_metadata mdata = scene->get_block_metadata(id);
+  lock_type lock(mutex_);
+  return this->get_block(lock, scene, id);
+}
 
-  //: add a scene
-  if(cached_blocks_.find(scene) == cached_blocks_.end() ) {
-    this->add_scene(scene);
-  }
-#if 0
-    if(!this->add_scene(scene))
-        return NULL;
-#endif
+boxm2_block* boxm2_lru_cache::get_block(lock_type & lock, boxm2_scene_sptr & scene, boxm2_block_id id)
+{
+  boxm2_block_metadata mdata = scene->get_block_metadata(id);
+  boxm2_lru_cache_key key(scene.ptr(), "", id);
+  this->wait_for_load(lock, key);
 
   //: add a block
-  if ( cached_blocks_[scene].find(id) == cached_blocks_[scene].end() )
+  std::map<boxm2_block_id, boxm2_block*>::iterator iter = cached_blocks_[scene].find(id);
+  if ( iter != cached_blocks_[scene].end() )
   {
-      boxm2_block* loaded = boxm2_sio_mgr::load_block(scene->data_path(), id, mdata );
+    this->touch(key);
+    return iter->second;
+  }
 
-      // if the block is null then initialize an empty one
-      if (!loaded && scene->block_exists(id)) {
-          std::cout<<"boxm2_lru_cache::initializing empty block "<<id<<std::endl;
-          loaded = new boxm2_block(mdata);
-      }
-      // update cache before returning the block
-      cached_blocks_[scene][id] = loaded;
+  // read the file without blocking other threads
+  loading_.insert(key);
+  lock.unlock();
+  boxm2_block* loaded = boxm2_sio_mgr::load_block(scene->data_path(), id, mdata );
+  lock.lock();
+  loading_.erase(key);
+#if VXL_FULLCXX11SUPPORT
+  prefetch_cond_.notify_all();
+#endif
+
+  // if the block is null then initialize an empty one
+  if (!loaded && scene->block_exists(id)) {
+    std::cout<<"boxm2_lru_cache::initializing empty block "<<id<<std::endl;
+    loaded = new boxm2_block(mdata);
+  }
+  // update cache before returning the block
+  cached_blocks_[scene][id] = loaded;
+  if (loaded) {
+    this->added(key, loaded->byte_count());
+    this->evict(key);
   }
-  return cached_blocks_[scene][id];
+  return loaded;
 }
 
 //: get data by type and id
 boxm2_data_base* boxm2_lru_cache::get_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes, bool read_only)
 {
-  // grab a reference to the map of cached_data_
-  std::map<boxm2_block_id, boxm2_data_base*>& data_map =this->cached_data_map(scene, type);
+  lock_type lock(mutex_);
+  return this->get_data_base(lock, scene, id, type, num_bytes, read_only);
+}
+
+boxm2_data_base* boxm2_lru_cache::get_data_base(lock_type & lock, boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes, bool read_only)
+{
   std::size_t data_size  = boxm2_data_info::datasize(type);
   if (!scene->block_exists(id)){
     return VXL_NULLPTR;
   }
-  boxm2_block* blk = this->get_block(scene,id);
+  boxm2_block* blk = this->get_block(lock, scene, id);
   unsigned n_cells = blk->num_cells();
   std::size_t byte_length = n_cells * data_size; // override the num_bytes passed parameter
+  boxm2_lru_cache_key key(scene.ptr(), type, id);
+  this->wait_for_load(lock, key);
   // then look for the block you're requesting
-  std::map<boxm2_block_id, boxm2_data_base*>::iterator iter = data_map.find(id);
-  if ( iter != data_map.end() )
+  std::map<boxm2_block_id, boxm2_data_base*>::iterator iter = this->cached_data_map(scene, type).find(id);
+  if ( iter != this->cached_data_map(scene, type).end() )
   {
     // congrats you've found the data block in cache, update cache and return block
     if (!read_only)  // write-enable is enforced
       iter->second->enable_write();
+    this->touch(key);
     return iter->second;
   }
 
-  // grab from disk
+  // grab from disk, without blocking other threads
+  loading_.insert(key);
+  lock.unlock();
   boxm2_data_base* loaded = boxm2_sio_mgr::load_block_data_generic(scene->data_path(), id, type, filesystem_);
+  lock.lock();
+  loading_.erase(key);
+#if VXL_FULLCXX11SUPPORT
+  prefetch_cond_.notify_all();
+#endif
   boxm2_block_metadata data = scene->get_block_metadata(id);
 
+  // grab a reference to the map of cached_data_
+  std::map<boxm2_block_id, boxm2_data_base*>& data_map =this->cached_data_map(scene, type);
+
   // if num_bytes is greater than zero, then you're guaranteed to return a data size with that many bytes
   if (num_bytes > 0) {
     if (num_bytes != byte_length){
@@ -155,6 +213,8 @@ boxm2_data_base* boxm2_lru_cache::get_data_base(boxm2_scene_sptr & scene, boxm2_
       data_map[id] = loaded;
       if (!read_only)  // write-enable is enforced
         loaded->enable_write();
+      this->added(key, loaded->buffer_length());
+      this->evict(key);
       return loaded;
     }
 
@@ -176,9 +236,11 @@ boxm2_data_base* boxm2_lru_cache::get_data_base(boxm2_scene_sptr & scene, boxm2_
 
   // update data map
   data_map[id] = loaded;
+  if (loaded) {
+    this->added(key, loaded->buffer_length());
+    this->evict(key);
+  }
   return loaded;
-
-
 }
 
 //: returns a data_base pointer which is initialized to the default value of the type.
@@ -186,6 +248,9 @@ boxm2_data_base* boxm2_lru_cache::get_data_base(boxm2_scene_sptr & scene, boxm2_
 //  This method does not check whether a block of this type already exists on the disk nor writes it to the disk
 boxm2_data_base* boxm2_lru_cache::get_data_base_new(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes, bool read_only)
 {
+  lock_type lock(mutex_);
+  boxm2_lru_cache_key key(scene.ptr(), type, id);
+  this->wait_for_load(lock, key);
   boxm2_data_base* block_data;
   if (num_bytes > 0)   {
     boxm2_block_metadata data = scene->get_block_metadata(id);
@@ -213,20 +278,25 @@ boxm2_data_base* boxm2_lru_cache::get_data_base_new(boxm2_scene_sptr & scene, bo
   if ( iter != data_map.end() )
   {
     // congrats you've found the data block in cache, now throw it away
+    if (iter->second)
+      this->removed(key, iter->second->buffer_length());
     delete iter->second;
     data_map.erase(iter);
   }
 
   // now store the block in the cache
   data_map[id] = block_data;
+  this->added(key, block_data->buffer_length());
+  this->evict(key);
   return block_data;
-
-
 }
 
 //: removes data from this cache (may or may not write to disk first)
 void boxm2_lru_cache::remove_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, bool write_out)
 {
+  lock_type lock(mutex_);
+  boxm2_lru_cache_key key(scene.ptr(), type, id);
+  this->wait_for_load(lock, key);
   // grab a reference to the map of cached_data_
   std::map<boxm2_block_id, boxm2_data_base*>& data_map = this->cached_data_map(scene,type);
   // then look for the block you're requesting
@@ -244,6 +314,8 @@ void boxm2_lru_cache::remove_data_base(boxm2_scene_sptr & scene, boxm2_block_id
     //else
     //  std::cout<<"boxm2_lru_cache::remove_data_base "<<type<<':'<<id<<"; not saving to disk"<<std::endl;
     // now throw it away
+    if (litter)
+      this->removed(key, litter->buffer_length());
     delete litter;
     data_map.erase(rem);
   }
@@ -252,6 +324,9 @@ void boxm2_lru_cache::remove_data_base(boxm2_scene_sptr & scene, boxm2_block_id
 //: replaces data in the cache with one here
 void boxm2_lru_cache::replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, boxm2_data_base* replacement)
 {
+  lock_type lock(mutex_);
+  boxm2_lru_cache_key key(scene.ptr(), type, id);
+  this->wait_for_load(lock, key);
   // grab a reference to the map of cached_data_
   std::map<boxm2_block_id, boxm2_data_base*>& data_map =
     this->cached_data_map(scene, type);
@@ -264,6 +339,8 @@ void boxm2_lru_cache::replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id
     boxm2_data_base* litter = data_map[id];
     replacement->read_only_ = litter->read_only_;
     // now throw it away
+    if (litter)
+      this->removed(key, litter->buffer_length());
     delete litter;
     data_map.erase(rem);
   }
@@ -271,7 +348,10 @@ void boxm2_lru_cache::replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id
   // this->remove_data_base(id, type);
   // put the new one in there
   data_map[id] = replacement;
-
+  if (replacement) {
+    this->added(key, replacement->buffer_length());
+    this->evict(key);
+  }
 }
 
 //: helper method returns a reference to correct data map (ensures one exists)
@@ -308,6 +388,7 @@ bool boxm2_lru_cache::is_valid_id(boxm2_scene_sptr & scene, boxm2_block_id id)
 //: Summarizes this cache's data
 std::string boxm2_lru_cache::to_string()
 {
+    lock_type lock(mutex_);
 
     std::stringstream stream;
     std::map< boxm2_scene_sptr, std::map<boxm2_block_id, boxm2_block*>,ltstr1 >::iterator scene_block_iter =cached_blocks_.begin();
@@ -344,6 +425,7 @@ std::string boxm2_lru_cache::to_string()
 //: dumps all data onto disk
 void boxm2_lru_cache::write_to_disk()
 {
+  lock_type lock(mutex_);
    // save the data and delete
   std::map<boxm2_scene_sptr, std::map<std::string, std::map<boxm2_block_id, boxm2_data_base*> >,ltstr1 >::iterator scene_iter =cached_data_.begin();
   for(;scene_iter!=cached_data_.end(); scene_iter++)
@@ -374,6 +456,7 @@ void boxm2_lru_cache::write_to_disk()
 //: dumps all data onto disk
 void boxm2_lru_cache::write_to_disk(boxm2_scene_sptr & scene)
 {
+  lock_type lock(mutex_);
    // save the data and delete
   std::map<boxm2_scene_sptr, std::map<std::string, std::map<boxm2_block_id, boxm2_data_base*> >,ltstr1 >::iterator scene_iter =cached_data_.begin();
   for(;scene_iter!=cached_data_.end(); scene_iter++)
@@ -407,6 +490,7 @@ void boxm2_lru_cache::write_to_disk(boxm2_scene_sptr & scene)
 //: add a new scene to the cache
 bool boxm2_lru_cache::add_scene(boxm2_scene_sptr & scene)
 {
+    lock_type lock(mutex_);
     if(cached_blocks_.find(scene) == cached_blocks_.end() && cached_data_.find(scene) == cached_data_.end())
     {
         cached_blocks_[scene] = std::map<boxm2_block_id, boxm2_block*>();
@@ -432,3 +516,234 @@ std::ostream& operator<<(std::ostream &s, boxm2_lru_cache& scene)
 {
   return s << scene.to_string();
 }
+
+//: set the most bytes of blocks and data to keep; 0 means no limit
+void boxm2_lru_cache::set_max_bytes(std::size_t max_bytes)
+{
+  lock_type lock(mutex_);
+  max_bytes_ = max_bytes;
+  this->evict(boxm2_lru_cache_key(VXL_NULLPTR, "", boxm2_block_id()));
+}
+
+std::size_t boxm2_lru_cache::max_bytes() const
+{
+  lock_type lock(mutex_);
+  return max_bytes_;
+}
+
+std::size_t boxm2_lru_cache::bytes() const
+{
+  lock_type lock(mutex_);
+  return bytes_;
+}
+
+//: keep the block and its data in the cache until unpin_block()
+void boxm2_lru_cache::pin_block(boxm2_scene_sptr & scene, boxm2_block_id id)
+{
+  lock_type lock(mutex_);
+  ++pins_[boxm2_lru_cache_key(scene.ptr(), "", id)];
+}
+
+//: allow the block and its data to be removed again
+void boxm2_lru_cache::unpin_block(boxm2_scene_sptr & scene, boxm2_block_id id)
+{
+  lock_type lock(mutex_);
+  std::map<boxm2_lru_cache_key, unsigned>::iterator pin = pins_.find(boxm2_lru_cache_key(scene.ptr(), "", id));
+  if (pin != pins_.end() && --pin->second == 0)
+    pins_.erase(pin);
+  this->evict(boxm2_lru_cache_key(VXL_NULLPTR, "", boxm2_block_id()));
+}
+
+//: record that a block or data was just used
+void boxm2_lru_cache::touch(boxm2_lru_cache_key const& key)
+{
+  std::map<boxm2_lru_cache_key, std::list<boxm2_lru_cache_key>::iterator>::iterator pos = lru_pos_.find(key);
+  if (pos != lru_pos_.end())
+    lru_.splice(lru_.begin(), lru_, pos->second);
+}
+
+//: record that a block or data of the given size was added
+void boxm2_lru_cache::added(boxm2_lru_cache_key const& key, std::size_t bytes)
+{
+  lru_.push_front(key);
+  lru_pos_[key] = lru_.begin();
+  bytes_ += bytes;
+}
+
+//: stop tracking a block or data that is being deleted
+void boxm2_lru_cache::removed(boxm2_lru_cache_key const& key, std::size_t bytes)
+{
+  std::map<boxm2_lru_cache_key, std::list<boxm2_lru_cache_key>::iterator>::iterator pos = lru_pos_.find(key);
+  if (pos == lru_pos_.end())
+    return;
+  lru_.erase(pos->second);
+  lru_pos_.erase(pos);
+  bytes_ -= bytes;
+}
+
+//: remove least recently used blocks and data until under the ceiling
+void boxm2_lru_cache::evict(boxm2_lru_cache_key const& keep)
+{
+  while (max_bytes_ > 0 && bytes_ > max_bytes_ && this->evict_one(keep))
+    ;
+}
+
+//: delete (after writing back, if writable) the least recently used entry that may go
+bool boxm2_lru_cache::evict_one(boxm2_lru_cache_key const& keep)
+{
+  for (std::list<boxm2_lru_cache_key>::reverse_iterator it = lru_.rbegin(); it != lru_.rend(); ++it)
+  {
+    boxm2_lru_cache_key key = *it;
+    if (key.scene == keep.scene && key.id == keep.id)
+      continue;
+    if (pins_.find(boxm2_lru_cache_key(key.scene, "", key.id)) != pins_.end())
+      continue;
+
+    boxm2_scene_sptr scene = key.scene;
+    if (key.type.empty())
+    {
+      std::map<boxm2_block_id, boxm2_block*>& blocks = cached_blocks_[scene];
+      boxm2_block* blk = blocks[key.id];
+      if (!blk->read_only())
+        boxm2_sio_mgr::save_block(scene->data_path(), blk);
+      this->removed(key, blk->byte_count());
+      delete blk;
+      blocks.erase(key.id);
+    }
+    else
+    {
+      std::map<boxm2_block_id, boxm2_data_base*>& data_map = this->cached_data_map(scene, key.type);
+      boxm2_data_base* data = data_map[key.id];
+      if (!data->read_only_)
+        boxm2_sio_mgr::save_block_data_base(scene->data_path(), key.id, data, key.type);
+      this->removed(key, data->buffer_length());
+      delete data;
+      data_map.erase(key.id);
+    }
+    return true;
+  }
+  return false;
+}
+
+//: start loading blocks, and the given types of data, in the background
+void boxm2_lru_cache::prefetch(boxm2_scene_sptr & scene, std::vector<boxm2_block_id> const& ids,
+                               std::vector<std::string> const& types)
+{
+#if VXL_FULLCXX11SUPPORT
+  lock_type lock(mutex_);
+  prefetch_queue_.clear();
+  for (std::vector<boxm2_block_id>::const_iterator id = ids.begin(); id != ids.end(); ++id)
+  {
+    if (!scene->block_exists(*id))
+      continue;
+    prefetch_request request;
+    request.scene = scene;
+    request.id = *id;
+    request.types = types;
+    prefetch_queue_.push_back(request);
+  }
+  if (!prefetcher_.joinable())
+    prefetcher_ = std::thread(&boxm2_lru_cache::run_prefetcher, this);
+  prefetch_cond_.notify_all();
+#endif
+}
+
+//: wait until all the prefetched blocks and data have been loaded
+void boxm2_lru_cache::wait_for_prefetch()
+{
+#if VXL_FULLCXX11SUPPORT
+  lock_type lock(mutex_);
+  while (!prefetch_queue_.empty() || prefetching_)
+    prefetch_cond_.wait(lock);
+#endif
+}
+
+//: wait while another thread loads the block or data
+void boxm2_lru_cache::wait_for_load(lock_type & lock, boxm2_lru_cache_key const& key)
+{
+#if VXL_FULLCXX11SUPPORT
+  while (loading_.find(key) != loading_.end())
+    prefetch_cond_.wait(lock);
+#endif
+}
+
+#if VXL_FULLCXX11SUPPORT
+//: the size the data of a cached block should have, or 0 if the block is not cached
+std::size_t boxm2_lru_cache::data_bytes(boxm2_scene_sptr const& scene, boxm2_block_id const& id, std::string const& type)
+{
+  if (cached_blocks_.find(scene) == cached_blocks_.end())
+    return 0;
+  std::map<boxm2_block_id, boxm2_block*>& blocks = cached_blocks_[scene];
+  std::map<boxm2_block_id, boxm2_block*>::iterator blk = blocks.find(id);
+  if (blk == blocks.end() || !blk->second)
+    return 0;
+  return std::size_t(blk->second->num_cells()) * boxm2_data_info::datasize(type);
+}
+
+//: the prefetch thread: loads the queued blocks and data, one file at a time
+void boxm2_lru_cache::run_prefetcher()
+{
+  lock_type lock(mutex_);
+  while (true)
+  {
+    while (!stop_prefetcher_ && prefetch_queue_.empty())
+      prefetch_cond_.wait(lock);
+    if (stop_prefetcher_)
+      return;
+
+    prefetch_request request = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    prefetching_ = true;
+    const unsigned generation = generation_;
+
+    // the block first, as get_data_base() needs it, then each type of data
+    for (std::size_t t = 0; t <= request.types.size(); ++t)
+    {
+      boxm2_lru_cache_key key(request.scene.ptr(), t == 0 ? std::string() : request.types[t-1], request.id);
+      if (lru_pos_.find(key) != lru_pos_.end() || loading_.find(key) != loading_.end())
+        continue;
+
+      loading_.insert(key);
+      lock.unlock();
+      boxm2_block* blk = VXL_NULLPTR;
+      boxm2_data_base* data = VXL_NULLPTR;
+      if (t == 0)
+        blk = boxm2_sio_mgr::load_block(request.scene->data_path(), request.id,
+                                        request.scene->get_block_metadata(request.id));
+      else
+        data = boxm2_sio_mgr::load_block_data_generic(request.scene->data_path(), request.id, key.type, filesystem_);
+      lock.lock();
+      loading_.erase(key);
+      prefetch_cond_.notify_all();
+
+      if (data && data->buffer_length() != this->data_bytes(request.scene, request.id, key.type)) {
+        // get_data_base() checks the size of the data it loads, so leave
+        // these for it to load or initialise when asked
+        delete data;
+        data = VXL_NULLPTR;
+      }
+
+      const std::size_t n_bytes = blk ? std::size_t(blk->byte_count()) : data ? data->buffer_length() : 0;
+      if (generation != generation_ || (max_bytes_ > 0 && bytes_ + n_bytes > max_bytes_))
+      {
+        // the cache was cleared, or is full: the rest of the prefetch is not wanted
+        delete blk;
+        delete data;
+        if (generation == generation_)
+          prefetch_queue_.clear();
+        break;
+      }
+      if (blk) {
+        cached_blocks_[request.scene][request.id] = blk;
+        this->added(key, n_bytes);
+      }
+      else if (data) {
+        this->cached_data_map(request.scene, key.type)[request.id] = data;
+        this->added(key, n_bytes);
+      }
+    }
+    prefetching_ = false;
+    prefetch_cond_.notify_all();
+  }
+}
+#endif
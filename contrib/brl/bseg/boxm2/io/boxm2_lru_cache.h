@@ -5,8 +5,16 @@
 // \brief boxm2_lru_cache (least recently used) is a singleton, derived from abstract class boxm2_cache
 
 #include <iostream>
+#include <list>
+#include <set>
+#include <deque>
 #include <boxm2/io/boxm2_cache.h>
 #include <vcl_compiler.h>
+#if VXL_FULLCXX11SUPPORT
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
 
 #define MAX_BYTES 1024*1024*1024*4 // 4 gigs of memory is max...
 struct ltstr1
@@ -16,9 +24,40 @@ struct ltstr1
     return s1.ptr() < s2.ptr();
   }
 };
+
+//: Identifies a cached block (empty type) or data buffer.
+struct boxm2_lru_cache_key
+{
+  boxm2_scene* scene;
+  std::string type;
+  boxm2_block_id id;
+
+  boxm2_lru_cache_key(boxm2_scene* s, std::string const& t, boxm2_block_id const& i)
+    : scene(s), type(t), id(i) {}
+
+  bool operator<(boxm2_lru_cache_key const& o) const
+  {
+    if (scene != o.scene) return scene < o.scene;
+    if (id != o.id) return id < o.id;
+    return type < o.type;
+  }
+};
+
 //: A cache that keeps the most recently used blocks and data, while kicking out the least recently used blocks and data to make more room.
-//  Currently just stores blocks in a map, not caring about space
-//  \todo implement with timestamped maps.
+//  By default nothing is kicked out; set_max_bytes() sets a ceiling on the
+//  bytes of blocks and data held.  When a new block or data buffer takes the
+//  cache over the ceiling, the least recently used ones are removed, after
+//  writing back those that were opened for writing.  The blocks and data of
+//  the block being requested, and of pinned blocks, are never removed, so
+//  the cache may briefly exceed the ceiling.
+//
+//  All methods may be called from several threads.  Pointers returned by the
+//  cache stay valid until their entry is removed; with a ceiling set, a
+//  thread should pin_block() the blocks it is working on.
+//
+//  prefetch() loads blocks and data on a background thread (when compiled
+//  with C++11 support), in the order given, which is normally the
+//  visibility order of the blocks for the camera that will be rendered.
 class boxm2_lru_cache : public boxm2_cache
 {
   public:
@@ -64,6 +103,31 @@ class boxm2_lru_cache : public boxm2_cache
     //: return the list of scenes with any data in the cache
     virtual std::vector<boxm2_scene_sptr> get_scenes();
 
+    //: start loading blocks, and the given types of data, in the background
+    //  Blocks and data already in the cache, or not on disk, are skipped;
+    //  a load that would take the cache over its ceiling ends the prefetch.
+    //  Replaces any prefetch still pending.
+    virtual void prefetch(boxm2_scene_sptr & scene, std::vector<boxm2_block_id> const& ids,
+                          std::vector<std::string> const& types);
+
+    //: wait until all the prefetched blocks and data have been loaded
+    void wait_for_prefetch();
+
+    //: set the most bytes of blocks and data to keep; 0 means no limit
+    void set_max_bytes(std::size_t max_bytes);
+
+    //: the most bytes of blocks and data to keep; 0 means no limit
+    std::size_t max_bytes() const;
+
+    //: the bytes of blocks and data currently in the cache
+    std::size_t bytes() const;
+
+    //: keep the block and its data in the cache until unpin_block() (calls nest)
+    void pin_block(boxm2_scene_sptr & scene, boxm2_block_id id);
+
+    //: allow the block and its data to be removed again
+    void unpin_block(boxm2_scene_sptr & scene, boxm2_block_id id);
+
   private:
 
     //: hidden constructor (private so it cannot be called -- forces the class to be singleton)
@@ -78,6 +142,50 @@ class boxm2_lru_cache : public boxm2_cache
     //: keeps one copy of each type of cached data
     std::map< boxm2_scene_sptr, std::map<std::string, std::map<boxm2_block_id, boxm2_data_base*> >,ltstr1 > cached_data_;
 
+    //: cached blocks and data, most recently used first
+    std::list<boxm2_lru_cache_key> lru_;
+
+    //: position of each cached block and data in lru_
+    std::map<boxm2_lru_cache_key, std::list<boxm2_lru_cache_key>::iterator> lru_pos_;
+
+    //: bytes of cached blocks and data, and the ceiling (0 for none)
+    std::size_t bytes_;
+    std::size_t max_bytes_;
+
+    //: number of times each block is pinned
+    std::map<boxm2_lru_cache_key, unsigned> pins_;
+
+    //: a block, and its data, waiting to be prefetched
+    struct prefetch_request
+    {
+      boxm2_scene_sptr scene;
+      boxm2_block_id id;
+      std::vector<std::string> types;
+    };
+    std::deque<prefetch_request> prefetch_queue_;
+
+    //: blocks and data being loaded by the prefetch thread
+    std::set<boxm2_lru_cache_key> loading_;
+
+    //: incremented by clear_cache(), so prefetches started before are dropped
+    unsigned generation_;
+
+#if VXL_FULLCXX11SUPPORT
+    typedef std::unique_lock<std::mutex> lock_type;
+    mutable std::mutex mutex_;
+    //: signalled when the prefetch thread has work, or has loaded something
+    std::condition_variable prefetch_cond_;
+    std::thread prefetcher_;
+    bool stop_prefetcher_;
+    bool prefetching_;
+    void run_prefetcher();
+    //: the size the data of a cached block should have, or 0 if the block is not cached
+    std::size_t data_bytes(boxm2_scene_sptr const& scene, boxm2_block_id const& id, std::string const& type);
+#else
+    struct lock_type { explicit lock_type(int) {} void lock() {} void unlock() {} };
+    mutable int mutex_;
+#endif
+
 
     // ---------Helper Methods --------------------------------------------------
 
@@ -86,6 +194,27 @@ class boxm2_lru_cache : public boxm2_cache
 
     //: helper method determines if this block is
     bool is_valid_id(boxm2_scene_sptr & scene, boxm2_block_id);
+
+    //: the unlocked parts of get_block() and get_data_base()
+    boxm2_block* get_block(lock_type & lock, boxm2_scene_sptr & scene, boxm2_block_id id);
+    boxm2_data_base* get_data_base(lock_type & lock, boxm2_scene_sptr & scene, boxm2_block_id id,
+                                   std::string type, std::size_t num_bytes, bool read_only);
+
+    //: wait while the prefetch thread loads the block or data
+    void wait_for_load(lock_type & lock, boxm2_lru_cache_key const& key);
+
+    //: record that a block (empty type) or data was just used, or added with the given bytes
+    void touch(boxm2_lru_cache_key const& key);
+    void added(boxm2_lru_cache_key const& key, std::size_t bytes);
+
+    //: stop tracking a block or data that is being deleted
+    void removed(boxm2_lru_cache_key const& key, std::size_t bytes);
+
+    //: remove least recently used blocks and data until under the ceiling, except those of block keep
+    void evict(boxm2_lru_cache_key const& keep);
+
+    //: delete (after writing back, if writable) the least recently used entry; false if none can go
+    bool evict_one(boxm2_lru_cache_key const& keep);
     // --------------------------------------------------------------------------
 };
 
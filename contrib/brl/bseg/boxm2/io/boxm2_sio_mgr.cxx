@@ -1,7 +1,9 @@
 #include <iostream>
 #include <fstream>
+#include <cstdio>
 #include "boxm2_sio_mgr.h"
 #include <vcl_compiler.h>
+#include <vil/vil_mapped_memory_chunk.h>
 #include <sys/stat.h>  //for getting file sizes
 
 #if defined(HAS_HDFS) && HAS_HDFS
@@ -9,6 +11,30 @@
 #include <bhdfs/bhdfs_fstream.h>
 #endif
 
+bool boxm2_sio_mgr::use_mapped_files_ = false;
+
+vil_memory_chunk_sptr boxm2_sio_mgr::map_file(std::string const& filepath)
+{
+  vil_mapped_memory_chunk* mapping = new vil_mapped_memory_chunk(filepath.c_str(), VIL_PIXEL_FORMAT_BYTE);
+  vil_memory_chunk_sptr chunk = mapping;
+  if (!mapping->is_mapped())
+    return VXL_NULLPTR;
+  return chunk;
+}
+
+void boxm2_sio_mgr::write_file(std::string const& filepath, const char* bytes, std::size_t n)
+{
+  // Truncating the file would pull the pages out from under any mapping of
+  // it, in this or another process, so write a new file and move it into place.
+  std::string tmppath = filepath + ".tmp";
+  std::ofstream myFile (tmppath.c_str(), std::ios::out | std::ios::binary);
+  myFile.write(bytes, n);
+  myFile.close();
+  if (!myFile || (std::rename(tmppath.c_str(), filepath.c_str()) != 0 &&
+                  (std::remove(filepath.c_str()) != 0 || std::rename(tmppath.c_str(), filepath.c_str()) != 0)))
+    std::cerr << "boxm2_sio_mgr::write_file cannot write file " << filepath << '\n';
+}
+
 boxm2_block* boxm2_sio_mgr::load_block(std::string dir, boxm2_block_id block_id, BOXM2_IO_FS_TYPE fs_type)
 {
   std::string filepath = dir + block_id.to_string() + ".bin";
@@ -16,6 +42,12 @@ boxm2_block* boxm2_sio_mgr::load_block(std::string dir, boxm2_block_id block_id,
   char* bytes=VXL_NULLPTR;
 
   if (fs_type == LOCAL) {
+    if (use_mapped_files_) {
+      vil_memory_chunk_sptr mapping = map_file(filepath);
+      if (mapping)
+        return new boxm2_block(block_id, mapping);
+    }
+
     //get file size
     numBytes = vul_file::size(filepath);
 
@@ -57,6 +89,12 @@ boxm2_block* boxm2_sio_mgr::load_block(std::string dir, boxm2_block_id block_id,
   char* bytes=VXL_NULLPTR;
 
   if (fs_type == LOCAL) {
+    if (use_mapped_files_) {
+      vil_memory_chunk_sptr mapping = map_file(filepath);
+      if (mapping)
+        return new boxm2_block(block_id, data, mapping);
+    }
+
     //get file size
     numBytes = vul_file::size(filepath);
 
@@ -99,9 +137,7 @@ void boxm2_sio_mgr::save_block(std::string dir, boxm2_block* block)
   block->b_write(bytes);
 
   // synchronously write to disk
-  std::ofstream myFile (filepath.c_str(), std::ios::out | std::ios::binary);
-  myFile.write(bytes, block->byte_count());
-  myFile.close();
+  write_file(filepath, bytes, block->byte_count());
 }
 
 // loads a generic boxm2_data_base* from disk (given data_type string prefix)
@@ -112,6 +148,12 @@ boxm2_data_base* boxm2_sio_mgr::load_block_data_generic(std::string dir, boxm2_b
   unsigned long numBytes = 0;
   char* bytes=VXL_NULLPTR;
   if (fs_type == LOCAL) {
+    if (use_mapped_files_) {
+      vil_memory_chunk_sptr mapping = map_file(filename);
+      if (mapping)
+        return new boxm2_data_base(mapping, id);
+    }
+
     //get file size
     numBytes=vul_file::size(filename);
 
@@ -150,11 +192,7 @@ void boxm2_sio_mgr::save_block_data_base(std::string dir, boxm2_block_id block_i
 {
   std::string filename = dir + prefix + "_" + block_id.to_string() + ".bin";
 
-  char * bytes = data->data_buffer();
-  std::ofstream myFile (filename.c_str(), std::ios::out | std::ios::binary);
-  myFile.write(bytes, data->buffer_length());
-  myFile.close();
-  return;
+  write_file(filename, data->data_buffer(), data->buffer_length());
 }
 
 char* boxm2_sio_mgr::load_from_hdfs(std::string filepath, unsigned long &numBytes)
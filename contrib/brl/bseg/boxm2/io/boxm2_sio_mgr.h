@@ -4,6 +4,12 @@
 // \file
 // \brief Loads blocks and data from ID's and data_types with blocking.
 //  If file is not available, will return null.
+//
+//  Local files are normally read into memory owned by the loaded block or
+//  data.  With set_use_mapped_files(true) they are instead mapped into memory
+//  privately, so loading copies nothing, pages are read only when touched,
+//  and processes reading the same scene share the page cache.  Writes to
+//  mapped blocks and data only change this process's copy until saved.
 #include <iostream>
 #include <boxm2/boxm2_block.h>
 #include <boxm2/basic/boxm2_block_id.h>
@@ -47,8 +53,22 @@ class boxm2_sio_mgr
     // generically saves data_base * to disk (given prefix)
     static void save_block_data_base(std::string dir, boxm2_block_id block_id, boxm2_data_base* data, std::string prefix);
 
+    //: map local files into memory instead of reading them (default false)
+    static void set_use_mapped_files(bool use) { use_mapped_files_ = use; }
+    static bool use_mapped_files() { return use_mapped_files_; }
+
   private:
     static char* load_from_hdfs(std::string filepath, unsigned long &numBytes);
+
+    //: the file mapped into memory, or null if it cannot be mapped
+    static vil_memory_chunk_sptr map_file(std::string const& filepath);
+
+    //: write bytes to a file
+    //  The file is replaced rather than rewritten in place, so that any
+    //  mapping of it (possibly the source of the bytes) stays valid.
+    static void write_file(std::string const& filepath, const char* bytes, std::size_t n);
+
+    static bool use_mapped_files_;
 };
 
 template <boxm2_data_type data_type>
@@ -84,11 +104,7 @@ void boxm2_sio_mgr::save_block_data(std::string dir, boxm2_block_id block_id, bo
 {
     std::string filename = dir + boxm2_data_traits<data_type>::prefix() + "_" + block_id.to_string() + ".bin";
 
-    char * bytes = block_data->data_buffer();
-    std::ofstream myFile (filename.c_str(), std::ios::out | std::ios::binary);
-    myFile.write(bytes, block_data->buffer_length());
-    myFile.close();
-    return;
+    write_file(filename, block_data->data_buffer(), block_data->buffer_length());
 }
 
 #endif // boxm2_sio_mgr_h_
@@ -38,6 +38,7 @@ DECLARE_FUNC_CONS(boxm2_combine_expected_images_process);
 DECLARE_FUNC_CONS(boxm2_scene_from_box_cams_process);
 DECLARE_FUNC_CONS(boxm2_scene_from_nvm_txt_process);
 DECLARE_FUNC_CONS(boxm2_compactify_mog6_view_process);
+DECLARE_FUNC_CONS(boxm2_convert_data_layout_process);
 DECLARE_FUNC_CONS(boxm2_scene_statistics_process);
 
 #if HAS_GEOTIFF
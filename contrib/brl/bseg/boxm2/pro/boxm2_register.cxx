@@ -61,6 +61,7 @@ void boxm2_register::register_process()
 
   REG_PROCESS_FUNC_CONS(bprb_func_process, bprb_batch_process_manager, boxm2_load_mesh_process, "boxm2LoadMeshProcess");
   REG_PROCESS_FUNC_CONS(bprb_func_process, bprb_batch_process_manager, boxm2_compactify_mog6_view_process, "boxm2CompactifyMog6ViewProcess");
+  REG_PROCESS_FUNC_CONS(bprb_func_process, bprb_batch_process_manager, boxm2_convert_data_layout_process, "boxm2ConvertDataLayoutProcess");
   REG_PROCESS_FUNC_CONS(bprb_func_process, bprb_batch_process_manager, boxm2_scene_statistics_process, "boxm2SceneStatisticsProcess");
 
 
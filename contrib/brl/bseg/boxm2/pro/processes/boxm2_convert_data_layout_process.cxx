@@ -0,0 +1,79 @@
+// This is brl/bseg/boxm2/pro/processes/boxm2_convert_data_layout_process.cxx
+//:
+// \file
+// \brief A process to store a scene's data as a structure of arrays, or back.
+//
+//  Converting data "boxm2_mog3_grey" (to_soa true) creates "boxm2_mog3_grey_soa"
+//  in the cache; converting "boxm2_mog3_grey_soa" (to_soa false) creates
+//  "boxm2_mog3_grey".  Use boxm2WriteCacheProcess to save the result.
+
+#include <iostream>
+#include <bprb/bprb_func_process.h>
+
+#include <vcl_compiler.h>
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_data_soa.h>
+#include <boxm2/io/boxm2_cache.h>
+
+namespace boxm2_convert_data_layout_process_globals
+{
+  const unsigned n_inputs_ = 4;
+  const unsigned n_outputs_ = 0;
+}
+
+bool boxm2_convert_data_layout_process_cons(bprb_func_process& pro)
+{
+  using namespace boxm2_convert_data_layout_process_globals;
+
+  //process takes 4 inputs
+  std::vector<std::string> input_types_(n_inputs_);
+  input_types_[0] = "boxm2_scene_sptr";
+  input_types_[1] = "boxm2_cache_sptr";
+  input_types_[2] = "vcl_string"; // data type, with identifier if any
+  input_types_[3] = "bool";       // true to convert to a structure of arrays
+
+  // process has no outputs
+  std::vector<std::string>  output_types_(n_outputs_);
+  return pro.set_input_types(input_types_) && pro.set_output_types(output_types_);
+}
+
+bool boxm2_convert_data_layout_process(bprb_func_process& pro)
+{
+  using namespace boxm2_convert_data_layout_process_globals;
+
+  if ( pro.n_inputs() < n_inputs_ ){
+    std::cout << pro.name() << ": The input number should be " << n_inputs_<< std::endl;
+    return false;
+  }
+  //get the inputs
+  boxm2_scene_sptr scene = pro.get_input<boxm2_scene_sptr>(0);
+  if (!scene){
+    std::cout << " null scene in boxm2_convert_data_layout_process\n";
+    return false;
+  }
+  boxm2_cache_sptr  cache = pro.get_input<boxm2_cache_sptr>(1);
+  std::string data_type = pro.get_input<std::string>(2);
+  bool to_soa = pro.get_input<bool>(3);
+
+  if (boxm2_data_info::data_type(data_type) == BOXM2_UNKNOWN) {
+    std::cout << pro.name() << ": unknown data type " << data_type << std::endl;
+    return false;
+  }
+  if (boxm2_data_is_soa(data_type) == to_soa) {
+    std::cout << pro.name() << ": " << data_type << " is already "
+              << (to_soa ? "a structure of arrays" : "an array of structures") << std::endl;
+    return false;
+  }
+  std::string out_type = to_soa ? boxm2_data_soa_prefix(data_type)
+                                : data_type.substr(0, data_type.size() - boxm2_data_soa_prefix("").size());
+
+  std::map<boxm2_block_id, boxm2_block_metadata> blocks = scene->blocks();
+  std::map<boxm2_block_id, boxm2_block_metadata>::const_iterator iter;
+  for (iter = blocks.begin(); iter != blocks.end(); ++iter)
+  {
+    boxm2_data_base* in = cache->get_data_base(scene, iter->first, data_type);
+    boxm2_data_base* out = cache->get_data_base(scene, iter->first, out_type, in->buffer_length(), false);
+    boxm2_data_convert_layout(data_type, in->data_buffer(), out->data_buffer(), in->buffer_length(), to_soa);
+  }
+  return true;
+}
@@ -1007,6 +1007,16 @@ def write_cache(cache, do_clear=0):
     else:
         print "ERROR: Cache type needs to be boxm2_cache_sptr, not ", cache.type
 
+# store data as a structure of arrays ("<data_type>_soa"), or back;
+# write the cache to save the result
+def convert_data_layout(scene, cache, data_type, to_soa=True):
+    boxm2_batch.init_process("boxm2ConvertDataLayoutProcess")
+    boxm2_batch.set_input_from_db(0, scene)
+    boxm2_batch.set_input_from_db(1, cache)
+    boxm2_batch.set_input_string(2, data_type)
+    boxm2_batch.set_input_bool(3, to_soa)
+    return boxm2_batch.run_process()
+
 # generic clear cache
 
 
@@ -3,6 +3,7 @@
 // \author Andy Miller
 // \date 26-Oct-2010
 #include <iostream>
+#include <fstream>
 #include <cstdio>
 #include <boxm2/boxm2_scene.h>
 #include <boxm2/boxm2_block.h>
@@ -15,9 +16,183 @@
 
 // for stats
 #include <vul/vul_timer.h>
+#include <vul/vul_file.h>
+#include <vpl/vpl.h>
 #include <vcl_sys/time.h>
 #include <vcl_compiler.h>
 //#include <unistd.h>
+#if VXL_FULLCXX11SUPPORT
+#include <thread>
+#endif
+
+//: Number of mappings of files whose names contain name, or -1 if unknown
+static int count_mappings(std::string const& name)
+{
+  std::ifstream maps("/proc/self/maps");
+  if (!maps)
+    return -1;
+  int n = 0;
+  std::string line;
+  while (std::getline(maps, line))
+    if (line.find(name) != std::string::npos)
+      ++n;
+  return n;
+}
+
+static std::vector<boxm2_block_id> test_cache_ids()
+{
+  std::vector<boxm2_block_id> ids;
+  for (int i=0; i<2; ++i)
+    for (int j=0; j<2; ++j)
+      for (int k=0; k<2; ++k)
+        ids.push_back(boxm2_block_id(i,j,k));
+  return ids;
+}
+
+#if VXL_FULLCXX11SUPPORT
+//: Repeatedly use blocks and data while other threads do the same.
+static void test_cache_worker(boxm2_lru_cache* cache, boxm2_scene_sptr scene, unsigned seed, bool* ok)
+{
+  std::vector<boxm2_block_id> ids = test_cache_ids();
+  for (unsigned n=0; n<40; ++n)
+  {
+    boxm2_block_id id = ids[(seed + n*5) % ids.size()];
+    cache->pin_block(scene, id);
+    boxm2_block* blk = cache->get_block(scene, id);
+    boxm2_data_base* alpha = cache->get_data_base(scene, id, boxm2_data_traits<BOXM2_ALPHA>::prefix());
+    *ok = *ok && blk && blk->block_id() == id && alpha && alpha->block_id() == id &&
+          cache->get_block(scene, id) == blk;
+    cache->unpin_block(scene, id);
+  }
+}
+#endif
+
+//: Byte ceiling, write-back, pinning and prefetch of boxm2_lru_cache
+static void test_lru_cache_budget(boxm2_lru_cache* cache)
+{
+  const std::string dir = "boxm2_test_lru_cache";
+  vul_file::make_directory(dir);
+  vul_file::delete_file_glob(dir + "/*.bin");
+  boxm2_scene_sptr scene;
+  boxm2_test_utils::create_test_simple_scene(scene);
+  scene->set_data_path(dir);
+  std::vector<boxm2_block_id> ids = test_cache_ids();
+  const std::string alpha_type = boxm2_data_traits<BOXM2_ALPHA>::prefix();
+
+  // New blocks are writable, so are written back when removed
+  std::size_t before = cache->bytes();
+  for (unsigned b=0; b<ids.size(); ++b)
+    cache->get_block(scene, ids[b]);
+  const std::size_t block_bytes = (cache->bytes() - before) / ids.size();
+  TEST("Cache counts its bytes", block_bytes > 0, true);
+  cache->clear_cache();
+  TEST("Cleared cache is empty", cache->bytes(), 0);
+
+  for (unsigned b=0; b<ids.size(); ++b)
+    cache->get_block(scene, ids[b]);
+  cache->set_max_bytes(3 * block_bytes);
+  TEST("Ceiling is kept", cache->bytes() <= 3 * block_bytes, true);
+  TEST("Least recently used block was written back", vul_file::exists(scene->data_path() + ids[0].to_string() + ".bin"), true);
+  TEST("Most recently used block was kept", vul_file::exists(scene->data_path() + ids.back().to_string() + ".bin"), false);
+  boxm2_block* blk = cache->get_block(scene, ids[0]);
+  TEST("Removed block is read back", blk && blk->block_id() == ids[0] && blk->byte_count() == long(block_bytes), true);
+
+  // Pinned blocks stay while others come and go
+  cache->pin_block(scene, ids[0]);
+  for (unsigned b=1; b<ids.size(); ++b)
+    cache->get_block(scene, ids[b]);
+  TEST("Pinned block is kept", cache->get_block(scene, ids[0]), blk);
+  cache->unpin_block(scene, ids[0]);
+
+  // Data opened for writing is written back too
+  boxm2_data_base* alpha = cache->get_data_base(scene, ids[1], alpha_type, 0, false);
+  reinterpret_cast<float*>(alpha->data_buffer())[7] = 0.25f;
+  cache->set_max_bytes(1);
+  TEST("Tiny ceiling removes everything that is not pinned", cache->bytes(), 0);
+  cache->set_max_bytes(0);
+  alpha = cache->get_data_base(scene, ids[1], alpha_type);
+  TEST("Written back data is read back", reinterpret_cast<float*>(alpha->data_buffer())[7], 0.25f);
+
+  // Mapped blocks and data are unmapped when removed
+  std::size_t alpha_bytes = 0;
+  for (unsigned b=0; b<ids.size(); ++b)
+    alpha_bytes = cache->get_data_base(scene, ids[b], alpha_type)->buffer_length();
+  cache->write_to_disk(scene);
+  cache->clear_cache();
+  const int n_mapped = count_mappings(dir);
+  if (n_mapped >= 0) {
+    boxm2_sio_mgr::set_use_mapped_files(true);
+    cache->set_max_bytes(block_bytes + alpha_bytes);
+    int first_round = 0;
+    for (unsigned r=0; r<5; ++r) {
+      for (unsigned b=0; b<ids.size(); ++b) {
+        cache->get_block(scene, ids[b]);
+        cache->get_data_base(scene, ids[b], alpha_type);
+      }
+      if (r == 0)
+        first_round = count_mappings(dir);
+    }
+    boxm2_sio_mgr::set_use_mapped_files(false);
+    TEST("Blocks and data are mapped", first_round > n_mapped, true);
+    TEST("Removed blocks and data are unmapped", count_mappings(dir), first_round);
+    cache->set_max_bytes(0);
+    cache->clear_cache();
+    TEST("Cleared blocks and data are unmapped", count_mappings(dir), n_mapped);
+  }
+
+  // Prefetch
+  for (unsigned b=0; b<ids.size(); ++b)
+    cache->get_data_base(scene, ids[b], alpha_type);
+  cache->write_to_disk(scene);
+  cache->clear_cache();
+  cache->prefetch(scene, ids, std::vector<std::string>(1, alpha_type));
+  cache->wait_for_prefetch();
+#if VXL_FULLCXX11SUPPORT
+  const std::size_t prefetched = cache->bytes();
+  TEST("Blocks and data were prefetched", prefetched >= ids.size() * block_bytes, true);
+  for (unsigned b=0; b<ids.size(); ++b) {
+    cache->get_block(scene, ids[b]);
+    cache->get_data_base(scene, ids[b], alpha_type);
+  }
+  TEST("Prefetched blocks and data are used", cache->bytes(), prefetched);
+
+  // Prefetched data of the wrong size are not used
+  cache->clear_cache();
+  {
+    std::ofstream short_file((scene->data_path() + alpha_type + "_" + ids[0].to_string() + ".bin").c_str(),
+                             std::ios::out | std::ios::binary);
+    short_file.write("0123456789abcdef", 16);
+  }
+  cache->prefetch(scene, ids, std::vector<std::string>(1, alpha_type));
+  cache->wait_for_prefetch();
+  alpha = cache->get_data_base(scene, ids[0], alpha_type, alpha_bytes);
+  TEST("Prefetched data of the wrong size are replaced", alpha && alpha->buffer_length() == alpha_bytes, true);
+
+  // A prefetch stops at the ceiling
+  cache->clear_cache();
+  cache->set_max_bytes(2 * block_bytes + 1);
+  cache->prefetch(scene, ids, std::vector<std::string>());
+  cache->wait_for_prefetch();
+  TEST("Prefetch stays under the ceiling", cache->bytes(), 2 * block_bytes);
+
+  // Several threads
+  cache->set_max_bytes(3 * block_bytes);
+  bool ok[4] = { true, true, true, true };
+  std::vector<std::thread> threads;
+  for (unsigned t=0; t<4; ++t)
+    threads.push_back(std::thread(test_cache_worker, cache, scene, t, &ok[t]));
+  cache->prefetch(scene, ids, std::vector<std::string>(1, alpha_type));
+  for (unsigned t=0; t<4; ++t)
+    threads[t].join();
+  TEST("Concurrent use", ok[0] && ok[1] && ok[2] && ok[3], true);
+  cache->wait_for_prefetch();
+#endif
+
+  cache->set_max_bytes(0);
+  cache->clear_cache();
+  vul_file::delete_file_glob(dir + "/*.bin");
+  vpl_rmdir(dir.c_str());
+}
 
 void test_cache()
 {
@@ -34,6 +209,8 @@ void test_cache()
 
 
   TEST("checking block id",blk->block_id(), boxm2_block_id(0,0,0) );
+
+  test_lru_cache_budget(static_cast<boxm2_lru_cache*>(cache.ptr()));
 }
 
 
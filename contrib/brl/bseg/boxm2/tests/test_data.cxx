@@ -2,7 +2,9 @@
 // \file
 // \author vishal JAin
 // \date May 17, 2010
+#include <cstring>
 #include <boxm2/boxm2_data.h>
+#include <boxm2/boxm2_data_soa.h>
 #include <boxm2/boxm2_data_traits.h>
 #include <boxm2/basic/boxm2_block_id.h>
 #include <boxm2/io/boxm2_sio_mgr.h>
@@ -58,10 +60,55 @@ void test_data_sio()
     if(farray_bkup) delete[] farray_bkup;
 }
 
+static void test_data_soa()
+{
+    typedef boxm2_data_traits<BOXM2_MOG3_GREY>::datatype mog3_t;
+    const unsigned n = 1000;
+    const std::size_t length = n*sizeof(mog3_t);
+    mog3_t* cells = new mog3_t[n];
+    for (unsigned i=0; i<n; ++i)
+        for (unsigned k=0; k<8; ++k)
+            cells[i][k] = (unsigned char)((i*7 + k*31) % 256);
+    char* aos = reinterpret_cast<char*>(cells);
+
+    char* soa = new char[length];
+    TEST("Convert to structure of arrays", boxm2_data_convert_layout(boxm2_data_traits<BOXM2_MOG3_GREY>::prefix(), aos, soa, length, true), true);
+    boxm2_data<BOXM2_MOG3_GREY>* data = new boxm2_data<BOXM2_MOG3_GREY>(soa, length, boxm2_block_id(0,0,0));
+    boxm2_data_soa<BOXM2_MOG3_GREY> view = data->soa();
+    TEST("Number of cells", view.size(), n);
+    TEST("Component planes", view.component(2)[17] == cells[17][2] && view(999,7) == cells[999][7], true);
+    bool same = true;
+    for (unsigned i=0; i<n; ++i)
+        same = same && view.get(i) == cells[i];
+    TEST("Cells", same, true);
+    mog3_t masked = view.get(5, 0x6d);
+    TEST("Selected components", masked[0] == cells[5][0] && masked[1] == 0 && masked[6] == cells[5][6] && masked[7] == 0, true);
+
+    // Round trip, via the name of the converted data
+    std::string soa_prefix = boxm2_data_soa_prefix(boxm2_data_traits<BOXM2_MOG3_GREY>::prefix());
+    TEST("Name of converted data", boxm2_data_is_soa(soa_prefix) && !boxm2_data_is_soa("boxm2_mog3_grey"), true);
+    TEST("Type of converted data", boxm2_data_info::data_type(soa_prefix), BOXM2_MOG3_GREY);
+    TEST("Converted data rejected by processes reading arrays of structures",
+         boxm2_data_reject_soa(soa_prefix, "test_data") && !boxm2_data_reject_soa("boxm2_mog3_grey", "test_data"), true);
+    char* back = new char[length];
+    boxm2_data_convert_layout(soa_prefix, soa, back, length, false);
+    TEST("Round trip", std::memcmp(aos, back, length), 0);
+
+    // Single component types are unchanged
+    float alphas[3] = { 1.0f, 2.0f, 3.0f }, copied[3];
+    boxm2_data_convert_layout("alpha", reinterpret_cast<char*>(alphas), reinterpret_cast<char*>(copied), sizeof(alphas), true);
+    TEST("Alpha is unchanged", copied[0] == 1.0f && copied[2] == 3.0f, true);
+    TEST("Unknown type", boxm2_data_convert_layout("nonsense", aos, back, length, true), false);
+
+    delete data;
+    delete [] cells;
+    delete [] back;
+}
 
 static void test_data()
 {
     test_data_sio();
+    test_data_soa();
 }
 
 
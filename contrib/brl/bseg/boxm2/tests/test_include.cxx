@@ -3,6 +3,7 @@
 #include <boxm2/boxm2_bounding_box_parser.h>
 #include <boxm2/boxm2_data.h>
 #include <boxm2/boxm2_data_base.h>
+#include <boxm2/boxm2_data_soa.h>
 #include <boxm2/boxm2_data_traits.h>
 #include <boxm2/boxm2_feature_vector.h>
 #include <boxm2/boxm2_normal_albedo_array.h>
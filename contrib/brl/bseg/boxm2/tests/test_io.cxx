@@ -5,6 +5,7 @@
 #include <vector>
 #include <iostream>
 #include <map>
+#include <cstring>
 #include <boxm2/basic/boxm2_block_id.h>
 #include <boxm2/boxm2_block.h>
 #include <boxm2/io/boxm2_sio_mgr.h>
@@ -129,6 +130,68 @@ static void test_asio_blocks()
     delete block_list[i];
 }
 
+static bool same_bytes(boxm2_data_base* a, boxm2_data_base* b)
+{
+  return a->buffer_length() == b->buffer_length() &&
+         std::memcmp(a->data_buffer(), b->data_buffer(), a->buffer_length()) == 0;
+}
+
+static void test_mapped_io()
+{
+  std::map<boxm2_block_id,boxm2_block_metadata> mdata = boxm2_test_utils::generate_simple_metadata();
+  boxm2_block_id id(0,0,0);
+  std::string alpha = boxm2_data_traits<BOXM2_ALPHA>::prefix();
+
+  boxm2_block* heap_block = boxm2_sio_mgr::load_block("", id, mdata[id]);
+  boxm2_data_base* heap_data = boxm2_sio_mgr::load_block_data_generic("", id, alpha);
+  boxm2_sio_mgr::set_use_mapped_files(true);
+  boxm2_block* block = boxm2_sio_mgr::load_block("", id, mdata[id]);
+  boxm2_data_base* data = boxm2_sio_mgr::load_block_data_generic("", id, alpha);
+  TEST("Missing files are not loaded", boxm2_sio_mgr::load_block_data_generic("", id, "no_such_type"), VXL_NULLPTR);
+  boxm2_sio_mgr::set_use_mapped_files(false);
+
+  TEST("Heap loads are not mapped", !heap_block->is_mapped() && !heap_data->is_mapped(), true);
+  TEST("Block is mapped", block->is_mapped(), true);
+  TEST("Data is mapped", data->is_mapped(), true);
+  boxm2_test_utils::test_block_equivalence(*heap_block, *block);
+  TEST("Mapped data matches data read from file", same_bytes(heap_data, data), true);
+
+  // Changes stay in this process until the data are saved
+  float* alphas = reinterpret_cast<float*>(data->data_buffer());
+  alphas[0] = -1.0f;
+  alphas[data->buffer_length()/sizeof(float) - 1] = -2.0f;
+  boxm2_data_base* reread = boxm2_sio_mgr::load_block_data_generic("", id, alpha);
+  TEST("Changing mapped data leaves the file alone", same_bytes(heap_data, reread), true);
+  delete reread;
+
+  // Saving replaces the file the data are mapped from
+  boxm2_sio_mgr::save_block_data_base("", id, data, alpha);
+  boxm2_sio_mgr::save_block("", block);
+  reread = boxm2_sio_mgr::load_block_data_generic("", id, alpha);
+  TEST("Saved mapped data", same_bytes(data, reread), true);
+  TEST("Mapped data survive saving", alphas[0] == -1.0f && alphas[data->buffer_length()/sizeof(float) - 1] == -2.0f, true);
+  boxm2_block* reread_block = boxm2_sio_mgr::load_block("", id, mdata[id]);
+  boxm2_test_utils::test_block_equivalence(*heap_block, *reread_block);
+  delete reread;
+  delete reread_block;
+
+  // Saving data which are not mapped over a file which is mapped
+  boxm2_sio_mgr::set_use_mapped_files(true);
+  boxm2_data_base* mapped = boxm2_sio_mgr::load_block_data_generic("", id, alpha);
+  boxm2_sio_mgr::set_use_mapped_files(false);
+  TEST("Saved data are mapped", mapped->is_mapped() && same_bytes(data, mapped), true);
+  boxm2_sio_mgr::save_block_data_base("", id, heap_data, alpha);
+  TEST("Mapped data survive saving other data over their file", same_bytes(data, mapped), true);
+  reread = boxm2_sio_mgr::load_block_data_generic("", id, alpha);
+  TEST("Saved data which are not mapped", same_bytes(heap_data, reread), true);
+  delete reread;
+  delete mapped;
+
+  delete heap_block;
+  delete heap_data;
+  delete block;
+  delete data;
+}
 
 void test_io()
 {
@@ -138,6 +201,7 @@ void test_io()
   // run some aio tests on blocks
   test_asio_blocks();
   test_asio_data();
+  test_mapped_io();
 
   //delete those blocks
   boxm2_test_utils::delete_test_scene_from_disk();
@@ -5,6 +5,7 @@
 #include <vcl_compiler.h>
 #include <vnl/vnl_math.h>
 #include <vil/vil_math.h>
+#include <vil/algo/vil_fft.h>
 #include <vnl/vnl_random.h>
 #include <vil/vil_resample_bicub.h>
 #include <bsta/bsta_histogram.h>
@@ -23,7 +24,6 @@ brip_phase_correlation(vil_image_view<float> const&img0,
   peak_radius_(peak_radius),
   gauss_sigma_(gauss_sigma)
 {
-  float fill_value = 0.0f;
   int ni0 = img0.ni(), nj0 = img0.nj();
   int ni1 = img1.ni(), nj1 = img1.nj();
   //find smallest image colum
@@ -32,59 +32,61 @@ brip_phase_correlation(vil_image_view<float> const&img0,
   int nj = nj0;
   if(nj>nj1) nj = nj1;
 
-  //reduce to a power of two in each dimension, required by the FFT algorithm
-  double p2i = std::floor(std::log(static_cast<double>(ni))/vnl_math::ln2 + 0.5);
-  double p2j = std::floor(std::log(static_cast<double>(nj))/vnl_math::ln2 + 0.5);
-  int nip2 = static_cast<unsigned>(std::pow(2.0, p2i));
-  int njp2 = static_cast<unsigned>(std::pow(2.0, p2j));
-  nip2_margin0_ = (ni0-nip2)/2; njp2_margin0_ = (nj0-njp2)/2;
-  nip2_margin1_ = (ni1-nip2)/2; njp2_margin1_ = (nj1-njp2)/2;
-  // if source image is smaller than target, fill borders with the fill_value
-  img0_.set_size(nip2, njp2);
-  img1_.set_size(nip2, njp2);
-  for(int j = 0; j<njp2; ++j)
-    for(int i = 0; i<nip2; ++i){
-      int di0 = nip2_margin0_ + i, dj0 = njp2_margin0_ + j;
-      int di1 = nip2_margin1_ + i, dj1 = njp2_margin1_ + j;
-      if(di0<0||dj0<0||di0>=ni0||dj0>=nj0)
-        img0_(i,j) = fill_value;
-      else
-        img0_(i,j) = img0(di0, dj0);
-
-      if(di1<0||dj1<0||di1>=ni1||dj1>=nj1)
-        img1_(i,j) = fill_value;
-      else
-        img1_(i,j) = img1(di1, dj1);
+  // crop the centre of each image to the common size; the FFT takes any size
+  ni_margin0_ = (ni0-ni)/2; nj_margin0_ = (nj0-nj)/2;
+  ni_margin1_ = (ni1-ni)/2; nj_margin1_ = (nj1-nj)/2;
+  img0_.set_size(ni, nj);
+  img1_.set_size(ni, nj);
+  for(int j = 0; j<nj; ++j)
+    for(int i = 0; i<ni; ++i){
+      img0_(i,j) = img0(ni_margin0_ + i, nj_margin0_ + j);
+      img1_(i,j) = img1(ni_margin1_ + i, nj_margin1_ + j);
     }
+}
 
+// magnitude and phase of Fourier coefficients
+static void mag_phase(vil_image_view<std::complex<float> > const& f,
+                      vil_image_view<float>& mag, vil_image_view<float>& phase)
+{
+  mag.set_size(f.ni(), f.nj());
+  phase.set_size(f.ni(), f.nj());
+  for(unsigned j = 0; j<f.nj(); ++j)
+    for(unsigned i = 0; i<f.ni(); ++i){
+      mag(i,j) = std::abs(f(i,j));
+      phase(i,j) = std::arg(f(i,j));
+    }
 }
 
 bool brip_phase_correlation::compute_ffts(){
-  bool good = brip_vil_float_ops::fourier_transform(img0_, mag0_, phase0_);
-  if(!good) return false;
-  good =  brip_vil_float_ops::fourier_transform(img1_, mag1_, phase1_);
-  return good;
+  if(img0_.size() == 0 || img1_.size() == 0) return false;
+  vil_fft_2d_fwd(img0_, f0_);
+  vil_fft_2d_fwd(img1_, f1_);
+  mag_phase(f0_, mag0_, phase0_);
+  mag_phase(f1_, mag1_, phase1_);
+  return true;
 }
 
 bool brip_phase_correlation::compute_correlation_array(){
-  unsigned ni0 = phase0_.ni(), nj0 = phase0_.nj();
-  unsigned ni1 = phase1_.ni(), nj1 = phase1_.nj();
-  if(ni0 != ni1 || nj0 != nj1) return false;
-  // form complex conjugate product of phase terms, magnitude is set to 1
-  vil_image_view<float>  prod_mag(ni0, nj0), prod_phase(ni0, nj0);
-  prod_mag.fill(1.0f);
+  unsigned ni0 = f0_.ni(), nj0 = f0_.nj();
+  unsigned ni1 = f1_.ni(), nj1 = f1_.nj();
+  if(ni0 != ni1 || nj0 != nj1 || ni0 == 0 || nj0 == 0) return false;
+  // form complex conjugate product of the coefficients, magnitude is set to 1
+  vil_image_view<std::complex<float> > prod(ni0, nj0);
   for(unsigned j = 0; j<nj0; ++j)
-    for(unsigned i = 0; i<ni0; ++i)
-      prod_phase(i,j)=  phase0_(i,j) - phase1_(i,j);
-  //                                 ^---------------------complex conjugate (minus sign)
-  bool good = brip_vil_float_ops::inverse_fourier_transform(prod_mag, prod_phase, corr_);
-  if(good){
-    for(unsigned j = 0; j<corr_.nj(); ++j)
-      for(unsigned i = 0; i<corr_.ni(); ++i)
-        corr_(i,j) = std::fabs(corr_(i,j));
-  }
+    for(unsigned i = 0; i<ni0; ++i){
+      std::complex<float> p = f0_(i,j)*std::conj(f1_(i,j));
+      //                               ^---------------------complex conjugate
+      float m = std::abs(p);
+      prod(i,j) = m > 0.0f ? p/m : std::complex<float>(0.0f);
+    }
+  vil_fft_2d_bwd(prod, img0_.ni(), corr_);
+  // a perfect match gives a correlation of 1
+  float scale = 1.0f/static_cast<float>(corr_.ni()*corr_.nj());
+  for(unsigned j = 0; j<corr_.nj(); ++j)
+    for(unsigned i = 0; i<corr_.ni(); ++i)
+      corr_(i,j) = std::fabs(corr_(i,j))*scale;
   thresh_ = compute_threshold(corr_);
-  return good;
+  return true;
 }
 float brip_phase_correlation::compute_threshold(vil_image_view<float> const& img) const{
   float min0, max0;
@@ -163,14 +165,15 @@ bool brip_phase_correlation::extract_correlation_peaks(){
          sumv /= sumg;
          // fill the peak struct
          peak pk;
+         // the correlation peak of a translation t is at -t, modulo the image size
          if(sumu<(ni/2)) // positive tu is in the right half of the inverse transform
            pk.u_ = -sumu;
          else
-           pk.u_ = (ni-1)-sumu;
+           pk.u_ = ni-sumu;
          if(sumv<(nj/2)) // positive tv is in the lower half of the inverse transform
            pk.v_ = -sumv;
          else
-           pk.v_ = (nj-1)-sumv;
+           pk.v_ = nj-sumv;
          pk.score_ = cv;
          peaks_.push_back(pk);
        }
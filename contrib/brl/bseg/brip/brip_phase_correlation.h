@@ -46,9 +46,13 @@
 //          For the current setting of 0.5 a ratio of 3:1 corresponds to a
 //          confidence of 0.9.
 //
+// The images are cropped to their common size, which need not be a power
+// of 2.  Only half of the Fourier transform of a real image is needed, so
+// mag0() and phase0() have ni/2+1 columns.
 //
 #include <iostream>
 #include <vector>
+#include <complex>
 #include <vil/vil_image_view.h>
 #include <vcl_compiler.h>
 
@@ -94,15 +98,18 @@ class brip_phase_correlation
   // compute a threshold using the Otsu algorithm
   float compute_threshold(vil_image_view<float> const& img) const;
 
-  // input images ( ni and j are adjusted to be a power of 2)
+  // input images, cropped to the same size
   vil_image_view<float> img0_;
   vil_image_view<float> img1_;
-  // margins needed to pad input images to reach a power of 2
-  int nip2_margin0_;
-  int njp2_margin0_;
-  int nip2_margin1_;
-  int njp2_margin1_;
+  // margins cropped from the input images
+  int ni_margin0_;
+  int nj_margin0_;
+  int ni_margin1_;
+  int nj_margin1_;
 
+  // Fourier coefficients of img0_ and img1_, (ni/2+1) x nj as the images are real
+  vil_image_view<std::complex<float> > f0_;
+  vil_image_view<std::complex<float> > f1_;
   // Fourier transform of img0_
   vil_image_view<float> mag0_;
   vil_image_view<float> phase0_;
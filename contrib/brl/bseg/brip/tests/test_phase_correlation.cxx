@@ -159,7 +159,42 @@ static void test_phase_correlation_homography(){
         std::cout << "act_t_avg(" << act_tu<< ' ' << act_tv << '\n';
 #endif
 }
+//: an image and a copy shifted by (tu, tv), both cropped to ni x nj
+static void shifted_images(unsigned ni, unsigned nj, int tu, int tv,
+                           vil_image_view<float>& img0, vil_image_view<float>& img1)
+{
+  const unsigned border = 20;
+  vil_image_view<float> scene(ni+2*border, nj+2*border);
+  unsigned seed = 1234;
+  for (unsigned j = 0; j<scene.nj(); ++j)
+    for (unsigned i = 0; i<scene.ni(); ++i, seed = seed*16807+1)
+      scene(i,j) = float((seed>>8)%256);
+  img0.set_size(ni, nj);
+  img1.set_size(ni, nj);
+  for (unsigned j = 0; j<nj; ++j)
+    for (unsigned i = 0; i<ni; ++i) {
+      img0(i,j) = scene(i+border, j+border);
+      img1(i,j) = scene(i+border-tu, j+border-tv);
+    }
+}
+
+static void test_phase_correlation_shift(unsigned ni, unsigned nj, int tu, int tv)
+{
+  vil_image_view<float> img0, img1;
+  shifted_images(ni, nj, tu, tv, img0, img1);
+  brip_phase_correlation bpc(img0, img1);
+  float u = 0, v = 0, conf = 0;
+  bool good = bpc.compute() && bpc.translation(u, v, conf);
+  std::cout << ni << 'x' << nj << " shift (" << tu << ' ' << tv << ") -> (" << u << ' ' << v << ") conf " << conf << '\n';
+  TEST("phase correlation succeeds", good, true);
+  TEST_NEAR("translation in u", u, tu, 0.5);
+  TEST_NEAR("translation in v", v, tv, 0.5);
+}
+
 static void test_phase_correlation(){
+        test_phase_correlation_shift(64, 64, 5, 3);
+        test_phase_correlation_shift(64, 64, -4, 7);
+        test_phase_correlation_shift(75, 61, 6, -5);
         test_phase_correlation_ortho();
         test_phase_correlation_homography();
 }
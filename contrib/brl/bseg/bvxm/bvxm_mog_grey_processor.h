@@ -16,6 +16,7 @@
 //   to return the appropriate bin number from the lighting direction
 // \endverbatim
 
+#include <vector>
 #include "grid/bvxm_voxel_slab.h"
 
 #include <bsta/algo/bsta_adaptive_updater.h>
@@ -62,6 +63,12 @@ class  bvxm_mog_grey_processor
                bvxm_voxel_slab<float> const& obs,
                bvxm_voxel_slab<float> const& weight);
 
+  //: Update with several observations in turn, each with its weights.
+  //  The same as calling update() for each in order, but each voxel is visited once.
+  bool update( bvxm_voxel_slab<mix_gauss_type> &appear,
+               std::vector<bvxm_voxel_slab<float> > const& obs,
+               std::vector<bvxm_voxel_slab<float> > const& weight);
+
   bvxm_voxel_slab<float> expected_color( bvxm_voxel_slab<mix_gauss_type> const& appear);
   bvxm_voxel_slab<float> most_probable_mode_color(bvxm_voxel_slab<mix_gauss_type > const& appear);
 
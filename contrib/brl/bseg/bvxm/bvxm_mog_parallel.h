@@ -0,0 +1,128 @@
+// This is brl/bseg/bvxm/bvxm_mog_parallel.h
+#ifndef bvxm_mog_parallel_h_
+#define bvxm_mog_parallel_h_
+//:
+// \file
+// \brief Slab operations of the mixture of gaussian processors, split between threads
+//
+//  The voxels of a slab are split into ranges which vil_parallel_run() hands
+//  out to its threads.  Every voxel is computed by one thread, in the same way
+//  as by a serial loop, so the results do not depend on the number of threads.
+//
+//  bvxm_mog_update() takes several observations at once and applies them to
+//  each voxel in turn, so that each mixture is loaded once for all of them.
+
+#include <vector>
+#include <cstddef>
+#include <vil/vil_parallel.h>
+#include <vcl_compiler.h>
+#include "grid/bvxm_voxel_slab.h"
+
+//: Number of ranges into which to split n voxels
+inline unsigned bvxm_mog_n_ranges(std::size_t n)
+{
+  // enough ranges to balance the threads, but not so small that handing them out costs much
+  const std::size_t min_range_voxels = 4096;
+  std::size_t n_ranges = 4*std::size_t(vil_parallel_max_threads());
+  if (n_ranges > n/min_range_voxels)
+    n_ranges = n/min_range_voxels;
+  return n_ranges < 1 ? 1 : unsigned(n_ranges);
+}
+
+//: Updates each voxel of a range with each of the observations in turn.
+template <class UPDATER, class APM, class OBS>
+class bvxm_mog_update_job : public vil_parallel_job
+{
+ public:
+  bvxm_mog_update_job(UPDATER const& updater, APM* appear, std::size_t n,
+                      std::vector<OBS const*> const& obs, std::vector<float const*> const& weight,
+                      unsigned n_ranges)
+    : updater_(updater), appear_(appear), n_(n), obs_(obs), weight_(weight), n_ranges_(n_ranges) {}
+
+  virtual void run(unsigned k) VXL_OVERRIDE
+  {
+    const std::size_t b = n_*k/n_ranges_, e = n_*(k+1)/n_ranges_;
+    const std::size_t n_obs = obs_.size();
+    // see bsta_mg_adaptive_updater::init_gaussian_
+    const UPDATER updater(updater_);
+    for (std::size_t i = b; i < e; ++i)
+      for (std::size_t o = 0; o < n_obs; ++o)
+        if (weight_[o][i] > 0)
+          updater(appear_[i], obs_[o][i], weight_[o][i]);
+  }
+
+ private:
+  UPDATER const& updater_;
+  APM* appear_;
+  std::size_t n_;
+  std::vector<OBS const*> const& obs_;
+  std::vector<float const*> const& weight_;
+  unsigned n_ranges_;
+};
+
+//: Update the appearance with each observation, weighted by the matching weight, in turn.
+//  The same as updating with one observation after the other, but the voxels are
+//  split between threads.  Returns false if the slab sizes differ.
+template <class UPDATER, class APM, class OBS>
+bool bvxm_mog_update(UPDATER const& updater, bvxm_voxel_slab<APM>& appear,
+                     std::vector<bvxm_voxel_slab<OBS> > const& obs,
+                     std::vector<bvxm_voxel_slab<float> > const& weight)
+{
+  if (obs.size() != weight.size())
+    return false;
+  std::vector<OBS const*> obs_data(obs.size());
+  std::vector<float const*> weight_data(weight.size());
+  for (std::size_t o = 0; o < obs.size(); ++o) {
+    if (obs[o].size() != appear.size() || weight[o].size() != appear.size())
+      return false;
+    obs_data[o] = obs[o].first_voxel();
+    weight_data[o] = weight[o].first_voxel();
+  }
+  const unsigned n_ranges = bvxm_mog_n_ranges(appear.size());
+  bvxm_mog_update_job<UPDATER, APM, OBS> job(updater, appear.first_voxel(), appear.size(),
+                                             obs_data, weight_data, n_ranges);
+  vil_parallel_run(job, n_ranges);
+  return true;
+}
+
+//: Computes the probability densities of the observations for a range of voxels.
+template <class APM, class OBS>
+class bvxm_mog_prob_density_job : public vil_parallel_job
+{
+ public:
+  bvxm_mog_prob_density_job(APM const* appear, OBS const* obs, float* prob, std::size_t n, unsigned n_ranges)
+    : appear_(appear), obs_(obs), prob_(prob), n_(n), n_ranges_(n_ranges) {}
+
+  virtual void run(unsigned k) VXL_OVERRIDE
+  {
+    const std::size_t b = n_*k/n_ranges_, e = n_*(k+1)/n_ranges_;
+    for (std::size_t i = b; i < e; ++i) {
+      if (appear_[i].num_components() == 0)
+        prob_[i] = 1.00f;
+      else
+        prob_[i] = appear_[i].prob_density(obs_[i]);
+    }
+  }
+
+ private:
+  APM const* appear_;
+  OBS const* obs_;
+  float* prob_;
+  std::size_t n_;
+  unsigned n_ranges_;
+};
+
+//: Probability density of each observation; 1 where a mixture has no components.
+template <class APM, class OBS>
+bvxm_voxel_slab<float> bvxm_mog_prob_density(bvxm_voxel_slab<APM> const& appear,
+                                             bvxm_voxel_slab<OBS> const& obs)
+{
+  bvxm_voxel_slab<float> probabilities(appear.nx(), appear.ny(), appear.nz());
+  const unsigned n_ranges = bvxm_mog_n_ranges(appear.size());
+  bvxm_mog_prob_density_job<APM, OBS> job(appear.first_voxel(), obs.first_voxel(),
+                                          probabilities.first_voxel(), appear.size(), n_ranges);
+  vil_parallel_run(job, n_ranges);
+  return probabilities;
+}
+
+#endif // bvxm_mog_parallel_h_
@@ -4,6 +4,7 @@
 #include "grid/bvxm_voxel_slab.h"
 #include "grid/bvxm_voxel_slab.hxx"
 #include "grid/bvxm_voxel_slab_iterator.h"
+#include "bvxm_mog_parallel.h"
 #include <vcl_cassert.h>
 
 //: Return probability density of observing pixel values
@@ -11,23 +12,8 @@ bvxm_voxel_slab<float>
 bvxm_mog_rgb_processor::prob_density(bvxm_voxel_slab<apm_datatype> const& appear,
                   bvxm_voxel_slab<obs_datatype> const& obs)
 {
-  //the output
-  bvxm_voxel_slab<float> probabilities(appear.nx(), appear.ny(), appear.nz());
-
-  //the slab iterators
-  bvxm_voxel_slab<apm_datatype>::const_iterator appear_it;
-  bvxm_voxel_slab<obs_datatype>::const_iterator obs_it = obs.begin();
-  bvxm_voxel_slab<float>::iterator prob_it = probabilities.begin();
-
-  for (appear_it = appear.begin(); appear_it!= appear.end(); ++appear_it, ++obs_it, ++prob_it)
-  {
-    if ((*appear_it).num_components() ==0)
-      (*prob_it)= 1.00f;
-    else
-    (*prob_it) = (*appear_it).prob_density(*obs_it);
-   }
-
-  return probabilities;
+  // the voxels are split between threads
+  return bvxm_mog_prob_density(appear, obs);
 }
 
 //: Return probabilities that pixels are in range [min,max]
@@ -61,6 +47,21 @@ bvxm_mog_rgb_processor::prob_range(bvxm_voxel_slab<apm_datatype> const& appear,
 bool bvxm_mog_rgb_processor::update( bvxm_voxel_slab<apm_datatype> &appear,
             bvxm_voxel_slab<obs_datatype> const& obs,
             bvxm_voxel_slab<float> const& weight)
+{
+  //check dimensions match
+  assert(appear.nx() == obs.nx());
+  assert(appear.ny() == obs.ny());
+  assert(appear.nz() == obs.nz());
+
+  return this->update(appear, std::vector<bvxm_voxel_slab<obs_datatype> >(1, obs),
+                      std::vector<bvxm_voxel_slab<float> >(1, weight));
+}
+
+
+//: Update with several sample images in turn
+bool bvxm_mog_rgb_processor::update( bvxm_voxel_slab<apm_datatype> &appear,
+            std::vector<bvxm_voxel_slab<obs_datatype> > const& obs,
+            std::vector<bvxm_voxel_slab<float> > const& weight)
 {
   // the model
   float init_variance = 0.008f;
@@ -74,22 +75,8 @@ bool bvxm_mog_rgb_processor::update( bvxm_voxel_slab<apm_datatype> &appear,
   //bsta_mg_grimson_weighted_updater<mix_gauss> updater(init_gauss);
   bsta_mg_grimson_weighted_updater<mix_gauss> updater(init_gauss,this->n_gaussian_modes_,g_thresh,min_stddev);
 
-  //check dimensions match
-  assert(appear.nx() == obs.nx());
-  assert(appear.ny() == obs.ny());
-  assert(appear.nz() == obs.nz());
-
-  //the iterators
-  bvxm_voxel_slab<apm_datatype>::iterator appear_it;
-  bvxm_voxel_slab<obs_datatype>::const_iterator obs_it = obs.begin();
-  bvxm_voxel_slab<float>::const_iterator weight_it = weight.begin();
-
-  for (appear_it = appear.begin(); appear_it!= appear.end(); ++appear_it, ++obs_it, ++weight_it)
-  {
-    if (*weight_it > 0)
-      updater(*appear_it, *obs_it, *weight_it);
-  }
-  return true;
+  // each voxel is updated with the observations in order, the voxels split between threads
+  return bvxm_mog_update(updater, appear, obs, weight);
 }
 
 
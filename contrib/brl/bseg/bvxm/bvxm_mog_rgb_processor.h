@@ -13,6 +13,7 @@
 // \endverbatim
 //
 
+#include <vector>
 #include "grid/bvxm_voxel_slab.h"
 
 #include <bsta/algo/bsta_adaptive_updater.h>
@@ -54,6 +55,12 @@ class  bvxm_mog_rgb_processor
                bvxm_voxel_slab<obs_datatype> const& obs,
                bvxm_voxel_slab<float> const& weight);
 
+  //: Update with several observations in turn, each with its weights.
+  //  The same as calling update() for each in order, but each voxel is visited once.
+  bool update( bvxm_voxel_slab<apm_datatype> &appear,
+               std::vector<bvxm_voxel_slab<obs_datatype> > const& obs,
+               std::vector<bvxm_voxel_slab<float> > const& weight);
+
    bvxm_voxel_slab<obs_datatype> expected_color( bvxm_voxel_slab<mix_gauss_type> const& appear);
    bvxm_voxel_slab<obs_datatype> most_probable_mode_color(bvxm_voxel_slab<mix_gauss_type > const& appear);
 
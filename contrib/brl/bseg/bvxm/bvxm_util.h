@@ -46,6 +46,7 @@
 #include <vil/vil_image_view.h>
 #include <vil/vil_pixel_format.h>
 #include <vil/vil_save.h> // for debug saving
+#include <vil/vil_parallel.h>
 
 #include <vcl_compiler.h>
 #include <vcl_cassert.h>
@@ -154,6 +155,71 @@ class bvxm_util
                                vnl_matrix<float> &weights);
 };
 
+//: Warps the rows of one band of slab_out, for bvxm_util::warp_slab_bilinear.
+template <class T, class M>
+class bvxm_util_warp_bilinear_job : public vil_parallel_job
+{
+ public:
+  bvxm_util_warp_bilinear_job(bvxm_voxel_slab<M> const& slab_in, vnl_matrix_fixed<float,3,3> const& H,
+                              bvxm_voxel_slab<T> &slab_out, unsigned n_bands)
+    : slab_in_(slab_in), H_(H), slab_out_(slab_out), n_bands_(n_bands) {}
+
+  unsigned n_bands() const { return n_bands_; }
+
+  virtual void run(unsigned k) VXL_OVERRIDE
+  {
+    const unsigned y0 = slab_out_.ny()*k/n_bands_, y1 = slab_out_.ny()*(k+1)/n_bands_;
+    // if z > 1, it would be more efficient to put the z loop as the inner-most.
+    // z will probably be 1 most of the time though, so leave it here for now.
+    for (unsigned z=0; z<slab_out_.nz(); ++z)
+    {
+      for (unsigned y=y0; y<y1; ++y)
+      {
+        T* out_it = &slab_out_(0,y,z);
+        for (unsigned x=0; x<slab_out_.nx(); ++x, ++out_it)
+        {
+          *out_it = T(0.0); // this should work whether T is a vector_fixed or a scalar
+          vnl_vector_fixed<float,3> pix_in_homg = H_*vnl_vector_fixed<float,3>((float)x,(float)y,1.0f);
+          // normalize homogeneous coordinate
+
+          float pix_in_x = pix_in_homg[0] / pix_in_homg[2];
+          float pix_in_y = pix_in_homg[1] / pix_in_homg[2];
+          // calculate weights and pixel values
+          unsigned x0 = (unsigned)std::floor(pix_in_x);
+          unsigned x1 = (unsigned)std::ceil(pix_in_x);
+          float x0_weight = (float)x1 - pix_in_x;
+          float x1_weight = 1.0f - (float)x0_weight;
+          unsigned y0 = (unsigned)std::floor(pix_in_y);
+          unsigned y1 = (unsigned)std::ceil(pix_in_y);
+          float y0_weight = (float)y1 - pix_in_y;
+          float y1_weight = 1.0f - (float)y0_weight;
+          vnl_vector_fixed<unsigned,4>xvals(x0,x0,x1,x1);
+          vnl_vector_fixed<unsigned,4>yvals(y0,y1,y0,y1);
+          vnl_vector_fixed<float,4> weights(x0_weight*y0_weight,
+                                            x0_weight*y1_weight,
+                                            x1_weight*y0_weight,
+                                            x1_weight*y1_weight);
+
+          for (unsigned i=0; i<4; ++i) {
+            // check if input pixel is inbounds
+            if (xvals[i] < slab_in_.nx() &&
+                yvals[i] < slab_in_.ny()) {
+              // pixel is good
+              (*out_it) += slab_in_(xvals[i],yvals[i],z)*weights[i];
+            }
+          }
+        } //x
+      } // y
+    } // z
+  }
+
+ private:
+  bvxm_voxel_slab<M> const& slab_in_;
+  vnl_matrix_fixed<float,3,3> H_;
+  bvxm_voxel_slab<T> &slab_out_;
+  unsigned n_bands_;
+};
+
 template <class T, class M>
 void bvxm_util::warp_slab_bilinear(bvxm_voxel_slab<M> const& slab_in,
                                    vgl_h_matrix_2d<double> invH, bvxm_voxel_slab<T> &slab_out)
@@ -184,9 +250,16 @@ void bvxm_util::warp_slab_bilinear(bvxm_voxel_slab<M> const& slab_in,
   std::cout << "xsize = " << xsize << " ysize = " << ysize << std::endl;
 #endif // 0
 
+  // smoothing is a no-op when both deviations are zero, so only copy the
+  // input if it is to be smoothed, or if it is also the output
   bvxm_voxel_slab<M> slab_in_smooth;
-  slab_in_smooth.deep_copy(slab_in);
-  smooth_gaussian(slab_in_smooth, xstd, ystd);
+  if (xstd > 0 || ystd > 0 ||
+      static_cast<void const*>(slab_in.first_voxel()) == static_cast<void const*>(slab_out.first_voxel())) {
+    slab_in_smooth.deep_copy(slab_in);
+    smooth_gaussian(slab_in_smooth, xstd, ystd);
+  }
+  else
+    slab_in_smooth = slab_in;
 
   // perform bilinear interpolation.
   vnl_matrix_fixed<float,3,3> H;
@@ -196,50 +269,10 @@ void bvxm_util::warp_slab_bilinear(bvxm_voxel_slab<M> const& slab_in,
   for (; Hit != H.end(); ++Hit, ++Hdit)
     *Hit = (float)(*Hdit);
 
-  slab_out.fill(T(0.0)); // this should work whether T is a vector_fixed or a scalar
-
-  typename bvxm_voxel_slab<T>::iterator out_it = slab_out.begin();
-
-  // if z > 1, it would be more efficient to put the z loop as the inner-most.
-  // z will probably be 1 most of the time though, so leave it here for now.
-  for (unsigned z=0; z<slab_out.nz(); ++z)
-  {
-    for (unsigned y=0; y<slab_out.ny(); ++y)
-    {
-      for (unsigned x=0; x<slab_out.nx(); ++x, ++out_it)
-      {
-        vnl_vector_fixed<float,3> pix_in_homg = H*vnl_vector_fixed<float,3>((float)x,(float)y,1.0f);
-        // normalize homogeneous coordinate
-
-        float pix_in_x = pix_in_homg[0] / pix_in_homg[2];
-        float pix_in_y = pix_in_homg[1] / pix_in_homg[2];
-        // calculate weights and pixel values
-        unsigned x0 = (unsigned)std::floor(pix_in_x);
-        unsigned x1 = (unsigned)std::ceil(pix_in_x);
-        float x0_weight = (float)x1 - pix_in_x;
-        float x1_weight = 1.0f - (float)x0_weight;
-        unsigned y0 = (unsigned)std::floor(pix_in_y);
-        unsigned y1 = (unsigned)std::ceil(pix_in_y);
-        float y0_weight = (float)y1 - pix_in_y;
-        float y1_weight = 1.0f - (float)y0_weight;
-        vnl_vector_fixed<unsigned,4>xvals(x0,x0,x1,x1);
-        vnl_vector_fixed<unsigned,4>yvals(y0,y1,y0,y1);
-        vnl_vector_fixed<float,4> weights(x0_weight*y0_weight,
-                                          x0_weight*y1_weight,
-                                          x1_weight*y0_weight,
-                                          x1_weight*y1_weight);
-
-        for (unsigned i=0; i<4; ++i) {
-          // check if input pixel is inbounds
-          if (xvals[i] < slab_in_smooth.nx() &&
-              yvals[i] < slab_in_smooth.ny()) {
-            // pixel is good
-            (*out_it) += slab_in_smooth(xvals[i],yvals[i],z)*weights[i];
-          }
-        }
-      } //x
-    } // y
-  } // z
+  // each output voxel depends only on the input, so bands of rows are warped in parallel
+  bvxm_util_warp_bilinear_job<T,M> job(slab_in_smooth, H, slab_out,
+                                       vil_parallel_n_bands(slab_out.ny(), 0, vil_parallel_policy()));
+  vil_parallel_run(job, job.n_bands());
   return;
 }
 
@@ -87,6 +87,7 @@
 #include <vnl/vnl_math.h>
 
 #include <vil/vil_image_view.h>
+#include <vil/vil_parallel.h>
 #include <vpgl/vpgl_camera_double_sptr.h>
 
 #include "bvxm_image_metadata.h"
@@ -111,6 +112,46 @@
 #include <bsta/bsta_sampler.h>
 #include <vpgl/file_formats/vpgl_geo_camera.h>
 
+//: Computes the new occupancy probabilities of one band of rows of a slab, for update().
+class bvxm_update_occupancy_job : public vil_parallel_job
+{
+ public:
+  bvxm_update_occupancy_job(float* PX, float const* preX, float const* PIvisX,
+                            float const* preX_sum, float const* visX_sum,
+                            unsigned nx, unsigned ny, unsigned n_bands,
+                            float min_vox_prob, float max_vox_prob)
+    : PX_(PX), preX_(preX), PIvisX_(PIvisX), preX_sum_(preX_sum), visX_sum_(visX_sum),
+      nx_(nx), ny_(ny), n_bands_(n_bands), min_vox_prob_(min_vox_prob), max_vox_prob_(max_vox_prob) {}
+
+  virtual void run(unsigned k) VXL_OVERRIDE
+  {
+    const float preX_sum_thresh = 0.01f;
+    const std::size_t i0 = std::size_t(nx_)*(ny_*k/n_bands_), i1 = std::size_t(nx_)*(ny_*(k+1)/n_bands_);
+    for (std::size_t i = i0; i < i1; ++i) {
+      float& PX = PX_[i];
+      // if preX_sum is zero at the voxel, no ray passed through the voxel (out of image)
+      if (preX_sum_[i] > preX_sum_thresh) {
+        float multiplier = (PIvisX_[i] + preX_[i]) / preX_sum_[i];
+        float ray_norm = 1 - visX_sum_[i]; // normalize based on probability that a surface voxel is located along the ray. This was not part of the original Pollard + Mundy algorithm.
+        PX *= multiplier * ray_norm;
+      }
+      if (PX < min_vox_prob_)
+        PX = min_vox_prob_;
+      if (PX > max_vox_prob_)
+        PX = max_vox_prob_;
+    }
+  }
+
+ private:
+  float* PX_;
+  float const* preX_;
+  float const* PIvisX_;
+  float const* preX_sum_;
+  float const* visX_sum_;
+  unsigned nx_, ny_, n_bands_;
+  float min_vox_prob_, max_vox_prob_;
+};
+
 class bvxm_voxel_world: public vbl_ref_count
 {
  public:
@@ -694,26 +735,13 @@ bool bvxm_voxel_world::update_impl(bvxm_image_metadata const& metadata,
     // transform visX_sum to current level
     bvxm_util::warp_slab_bilinear(visX_accum, H_plane_to_img[z], visX_accum_vox);
 
-    const float preX_sum_thresh = 0.01f;
-
-    typename bvxm_voxel_slab<float>::const_iterator preX_it = preX_slab_it->begin(),
-                                                    PIvisX_it = PIvisX_slab_it->begin(),
-                                                    preX_sum_it = preX_accum_vox.begin(),
-                                                    visX_sum_it = visX_accum_vox.begin();
-    typename bvxm_voxel_slab<float>::iterator PX_it = ocp_slab_it2->begin();
-
-    for (; PX_it != ocp_slab_it2->end(); ++PX_it, ++preX_it, ++PIvisX_it, ++preX_sum_it, ++visX_sum_it) {
-      // if preX_sum is zero at the voxel, no ray passed through the voxel (out of image)
-      if (*preX_sum_it > preX_sum_thresh) {
-        float multiplier = (*PIvisX_it + *preX_it) / *preX_sum_it;
-        float ray_norm = 1 - *visX_sum_it; // normalize based on probability that a surface voxel is located along the ray. This was not part of the original Pollard + Mundy algorithm.
-        *PX_it *= multiplier * ray_norm;
-      }
-      if (*PX_it < min_vox_prob)
-        *PX_it = min_vox_prob;
-      if (*PX_it > max_vox_prob)
-        *PX_it = max_vox_prob;
-    }
+    // the voxels are independent, so bands of rows are updated in parallel
+    const unsigned n_bands = vil_parallel_n_bands(grid_size.y(), 0, vil_parallel_policy());
+    bvxm_update_occupancy_job job(ocp_slab_it2->first_voxel(), preX_slab_it->first_voxel(),
+                                  PIvisX_slab_it->first_voxel(), preX_accum_vox.first_voxel(),
+                                  visX_accum_vox.first_voxel(), grid_size.x(), grid_size.y(),
+                                  n_bands, min_vox_prob, max_vox_prob);
+    vil_parallel_run(job, n_bands);
   }
   std::cout << "\ndone." << std::endl;
 
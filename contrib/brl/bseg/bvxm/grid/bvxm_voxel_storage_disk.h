@@ -2,10 +2,26 @@
 #define bvxm_voxel_storage_disk_h_
 //:
 // \file
+// \brief Voxel storage in a file on disk, read and written one slab at a time
+//
+//  Slabs are read and written on a background thread where C++11 threads are
+//  available.  get_slab() starts reading the following slab as soon as it
+//  returns, and put_slab() only queues the write of a copy of the slab, so a
+//  caller that goes through the grid slab by slab (e.g. with
+//  bvxm_voxel_slab_iterator) works on one slab while the next is read and
+//  the previous one written, and may change a slab after putting it.  Each
+//  slab returned has its own buffer, which is reused once no slab refers to it.
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <vcl_compiler.h>
+#if VXL_FULLCXX11SUPPORT
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
 #ifdef BVXM_USE_FSTREAM64
 #include <vil/vil_stream_fstream64.h>
 #else
@@ -74,8 +90,51 @@ class bvxm_voxel_storage_disk : public bvxm_voxel_storage<T>
   //: convert slab start index to file position
   vil_streampos slab_filepos(unsigned slab_index);
 
-  // slab-sized buffer
+  // buffer of the currently active slab
   bvxm_memory_chunk_sptr slab_buffer_;
+
+  //: all the slab buffers; those referred to only from here are free
+  std::vector<bvxm_memory_chunk_sptr> buffers_;
+
+  //: a free buffer of the given size
+  bvxm_memory_chunk_sptr free_buffer(vxl_uint_64 size);
+
+  // slab being read ahead, if prefetch_buffer_ is not null
+  unsigned prefetch_start_;
+  unsigned prefetch_thickness_;
+  bvxm_memory_chunk_sptr prefetch_buffer_;
+  unsigned long prefetch_seq_;
+
+  //: a queued read or write of a buffer at a file position
+  struct io_request
+  {
+    bool write;
+    vil_streampos pos;
+    bvxm_memory_chunk_sptr buffer;
+  };
+
+  //: queue a read or write; returns its sequence number. Runs it at once without thread support.
+  unsigned long queue_io(bool write, vil_streampos pos, bvxm_memory_chunk_sptr const& buffer);
+  //: wait until the request with sequence number seq, and all before it, are done
+  void wait_for_io(unsigned long seq) const;
+  //: wait until all the queued requests are done
+  void flush_io() const { wait_for_io(queued_seq_); }
+  //: read or write on fio_
+  bool do_io(io_request const& request) const;
+
+  // number of requests queued, and done
+  unsigned long queued_seq_;
+  mutable unsigned long done_seq_;
+
+#if VXL_FULLCXX11SUPPORT
+  std::deque<io_request> io_queue_;
+  mutable std::mutex io_mutex_;
+  //: signalled when a request is queued or done
+  mutable std::condition_variable io_cond_;
+  std::thread io_thread_;
+  bool stop_io_;
+  void run_io();
+#endif
 };
 
 
@@ -4,6 +4,7 @@
 // \file
 
 #include <string>
+#include <cstring>
 #include <iostream>
 #include "bvxm_voxel_storage_disk.h"
 //
@@ -20,8 +21,12 @@
 
 template <class T>
 bvxm_voxel_storage_disk<T>::bvxm_voxel_storage_disk(std::string storage_filename)
-: bvxm_voxel_storage<T>(), storage_fname_(storage_filename), fio_(0), active_slab_start_(-1)
+: bvxm_voxel_storage<T>(), storage_fname_(storage_filename), fio_(0), active_slab_start_(-1),
+  prefetch_start_(0), prefetch_thickness_(0), prefetch_seq_(0), queued_seq_(0), done_seq_(0)
 {
+#if VXL_FULLCXX11SUPPORT
+  stop_io_ = false;
+#endif
   // check if file exsist already or not
   if (vul_file::exists(storage_fname_))  {
     // make sure filename is not a directory
@@ -49,9 +54,6 @@ bvxm_voxel_storage_disk<T>::bvxm_voxel_storage_disk(std::string storage_filename
     vgl_vector_3d<unsigned int> grid_size(header.nx_, header.ny_, header.nz_);
 
     this->grid_size_ = grid_size;
-
-     // assumes desired slab thickness is 1
-    slab_buffer_ = new bvxm_memory_chunk(grid_size.x()*grid_size.y()*sizeof(T));
   }
   else {
     // file does not yet exist.
@@ -61,11 +63,12 @@ bvxm_voxel_storage_disk<T>::bvxm_voxel_storage_disk(std::string storage_filename
 
 template <class T>
 bvxm_voxel_storage_disk<T>::bvxm_voxel_storage_disk(std::string storage_filename, vgl_vector_3d<unsigned int> grid_size)
-: bvxm_voxel_storage<T>(grid_size), storage_fname_(storage_filename), fio_(0), active_slab_start_(-1)
+: bvxm_voxel_storage<T>(grid_size), storage_fname_(storage_filename), fio_(0), active_slab_start_(-1),
+  prefetch_start_(0), prefetch_thickness_(0), prefetch_seq_(0), queued_seq_(0), done_seq_(0)
 {
-  // assumes desired slab thickness is 1
-  slab_buffer_ = new bvxm_memory_chunk(grid_size.x()*grid_size.y()*sizeof(T));
-
+#if VXL_FULLCXX11SUPPORT
+  stop_io_ = false;
+#endif
   // check if file exsist already or not
   if (vul_file::exists(storage_fname_))  {
     // make sure filename is not a directory
@@ -130,6 +133,17 @@ bvxm_voxel_storage_disk<T>::bvxm_voxel_storage_disk(std::string storage_filename
 template<class T>
 bvxm_voxel_storage_disk<T>::~bvxm_voxel_storage_disk()
 {
+  // finish the queued writes, then stop the I/O thread
+  flush_io();
+#if VXL_FULLCXX11SUPPORT
+  {
+    std::unique_lock<std::mutex> lock(io_mutex_);
+    stop_io_ = true;
+    io_cond_.notify_all();
+  }
+  if (io_thread_.joinable())
+    io_thread_.join();
+#endif
   // this will delete the stream object
   if (fio_) {
     fio_->ref();
@@ -160,7 +174,17 @@ bool bvxm_voxel_storage_disk<T>::initialize_data(T const& value)
       return false;
     }
   }
-  // everything looks ok. open file for write and fill with data
+  // everything looks ok. finish any pending I/O on the old file
+  flush_io();
+  prefetch_buffer_ = VXL_NULLPTR;
+  if (fio_) {
+    fio_->ref();
+    fio_->unref();
+    fio_ = 0;
+  }
+  slab_buffer_ = free_buffer(this->grid_size_.x()*this->grid_size_.y()*sizeof(T));
+
+  // open file for write and fill with data
 #ifdef BVXM_USE_FSTREAM64
     fio_ = new vil_stream_fstream64(storage_fname_.c_str(),"w");
 #else
@@ -221,17 +245,36 @@ bvxm_voxel_slab<T> bvxm_voxel_storage_disk<T>::get_slab(unsigned slice_idx, unsi
       return dummy_slab;
     }
   }
-  vil_streampos slice_pos = this->slab_filepos(slice_idx);
-  vil_streampos file_pos = fio_->tell();
-  if (slice_pos != file_pos) {
-    fio_->seek(slice_pos);
-  }
+  const vxl_uint_64 slab_size = this->grid_size_.x()* this->grid_size_.y() * slab_thickness *sizeof(T);
 
-  // check that buffer is the right size, if thickness >1
-  if ( slab_buffer_->size() != (this->grid_size_.x()* this->grid_size_.y() * slab_thickness *sizeof(T)))
-    slab_buffer_->set_size(this->grid_size_.x()* this->grid_size_.y() * slab_thickness *sizeof(T));
+  if (prefetch_buffer_ && prefetch_start_ == slice_idx && prefetch_thickness_ == slab_thickness) {
+    // the slab has been read ahead; the write of the previous slab may still be going on
+    wait_for_io(prefetch_seq_);
+    slab_buffer_ = prefetch_buffer_;
+  }
+  else {
+    // read it now, after anything still queued
+    flush_io();
+    slab_buffer_ = free_buffer(slab_size);
+    io_request request;
+    request.write = false;
+    request.pos = this->slab_filepos(slice_idx);
+    request.buffer = slab_buffer_;
+    do_io(request);
+  }
+  prefetch_buffer_ = VXL_NULLPTR;
+
+#if VXL_FULLCXX11SUPPORT
+  // start reading the next slab
+  const unsigned next_idx = slice_idx + slab_thickness;
+  if (next_idx + slab_thickness <= this->grid_size_.z()) {
+    prefetch_buffer_ = free_buffer(slab_size);
+    prefetch_start_ = next_idx;
+    prefetch_thickness_ = slab_thickness;
+    prefetch_seq_ = queue_io(false, this->slab_filepos(next_idx), prefetch_buffer_);
+  }
+#endif
 
-  fio_->read(reinterpret_cast<char*>(slab_buffer_->data()),slab_buffer_->size());
   bvxm_voxel_slab<T> slab(this->grid_size_.x(),this->grid_size_.y(),slab_thickness,slab_buffer_,reinterpret_cast<T*>(slab_buffer_->data()));
   active_slab_start_ = slice_idx;
   return slab;
@@ -250,18 +293,11 @@ void bvxm_voxel_storage_disk<T>::put_slab()
     std::cerr << "error: attempted to put_slice() with no active slab\n";
     return;
   }
-  vil_streampos slice_pos = slab_filepos(active_slab_start_);
-  vil_streampos file_pos = fio_->tell();
-  if (slice_pos != file_pos) {
-    fio_->seek(slice_pos);
-    file_pos = fio_->tell();
-    if (file_pos != slice_pos) {
-      std::cerr << "error seeking to file position " << slice_pos << std::endl;
-      return;
-    }
-  }
-  fio_->write(reinterpret_cast<char*>(slab_buffer_->data()),slab_buffer_->size());
-  //fio_->flush();
+  // written on the I/O thread, while the caller goes on to the next slab.
+  // The caller may still change the slab, so write a copy of it.
+  bvxm_memory_chunk_sptr copy = free_buffer(slab_buffer_->size());
+  std::memcpy(copy->data(), slab_buffer_->const_data(), std::size_t(slab_buffer_->size()));
+  queue_io(true, slab_filepos(active_slab_start_), copy);
 
   return;
 }
@@ -269,6 +305,9 @@ void bvxm_voxel_storage_disk<T>::put_slab()
 template <class T>
 unsigned bvxm_voxel_storage_disk<T>::num_observations() const
 {
+  // the header is read on this thread, so finish the queued I/O first
+  flush_io();
+
   // read header from disk
   // check to see if file is already open
   if (!fio_) {
@@ -300,6 +339,9 @@ unsigned bvxm_voxel_storage_disk<T>::num_observations() const
 template <class T>
 void bvxm_voxel_storage_disk<T>::increment_observations()
 {
+  // the header is read on this thread, so finish the queued I/O first
+  flush_io();
+
   // read header from disk
   // check to see if file is already open
   if (!fio_) {
@@ -344,6 +386,9 @@ void bvxm_voxel_storage_disk<T>::increment_observations()
 template <class T>
 void bvxm_voxel_storage_disk<T>::zero_observations()
 {
+  // the header is read on this thread, so finish the queued I/O first
+  flush_io();
+
   // read header from disk
   // check to see if file is already open
   if (!fio_) {
@@ -395,6 +440,106 @@ vil_streampos bvxm_voxel_storage_disk<T>::slab_filepos(unsigned slab_index)
   return pos;
 }
 
+//: a free buffer of the given size
+template<class T>
+bvxm_memory_chunk_sptr bvxm_voxel_storage_disk<T>::free_buffer(vxl_uint_64 size)
+{
+  // a buffer is free once no slab or queued request holds it
+  for (std::size_t i = 0; i < buffers_.size(); ++i) {
+    if (buffers_[i]->get_references() == 1) {
+      buffers_[i]->set_size(size);
+      return buffers_[i];
+    }
+  }
+  buffers_.push_back(new bvxm_memory_chunk(size));
+  return buffers_.back();
+}
+
+//: read or write on fio_
+template<class T>
+bool bvxm_voxel_storage_disk<T>::do_io(io_request const& request) const
+{
+  if (fio_->tell() != request.pos) {
+    fio_->seek(request.pos);
+    if (fio_->tell() != request.pos) {
+      std::cerr << "error seeking to file position " << request.pos << std::endl;
+      return false;
+    }
+  }
+  vil_streampos size = (vil_streampos)request.buffer->size();
+  char* data = reinterpret_cast<char*>(request.buffer->data());
+  if (request.write) {
+    if (fio_->write(data, size) != size) {
+      std::cerr << "error writing slab to " << storage_fname_ << std::endl;
+      return false;
+    }
+  }
+  else if (fio_->read(data, size) != size) {
+    std::cerr << "error reading slab from " << storage_fname_ << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//: queue a read or write; returns its sequence number
+template<class T>
+unsigned long bvxm_voxel_storage_disk<T>::queue_io(bool write, vil_streampos pos, bvxm_memory_chunk_sptr const& buffer)
+{
+  io_request request;
+  request.write = write;
+  request.pos = pos;
+  request.buffer = buffer;
+#if VXL_FULLCXX11SUPPORT
+  std::unique_lock<std::mutex> lock(io_mutex_);
+  io_queue_.push_back(request);
+  if (!io_thread_.joinable())
+    io_thread_ = std::thread(&bvxm_voxel_storage_disk<T>::run_io, this);
+  io_cond_.notify_all();
+  return ++queued_seq_;
+#else
+  do_io(request);
+  done_seq_ = ++queued_seq_;
+  return queued_seq_;
+#endif
+}
+
+//: wait until the request with sequence number seq, and all before it, are done
+template<class T>
+void bvxm_voxel_storage_disk<T>::wait_for_io(unsigned long seq) const
+{
+#if VXL_FULLCXX11SUPPORT
+  std::unique_lock<std::mutex> lock(io_mutex_);
+  while (done_seq_ < seq)
+    io_cond_.wait(lock);
+#else
+  (void)seq;
+#endif
+}
+
+#if VXL_FULLCXX11SUPPORT
+//: the I/O thread: does the queued requests in order
+template<class T>
+void bvxm_voxel_storage_disk<T>::run_io()
+{
+  std::unique_lock<std::mutex> lock(io_mutex_);
+  while (true)
+  {
+    while (!stop_io_ && io_queue_.empty())
+      io_cond_.wait(lock);
+    if (stop_io_)
+      return;
+    // the request stays queued, so its buffer is not reused, until it is done
+    io_request const& request = io_queue_.front();
+    lock.unlock();
+    do_io(request);
+    lock.lock();
+    io_queue_.pop_front();
+    ++done_seq_;
+    io_cond_.notify_all();
+  }
+}
+#endif
+
 #define BVXM_VOXEL_STORAGE_DISK_INSTANTIATE(T) \
 template class bvxm_voxel_storage_disk<T >
 
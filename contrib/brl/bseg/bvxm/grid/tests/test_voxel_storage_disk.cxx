@@ -79,6 +79,51 @@ static void test_voxel_storage_disk()
   }
   // end of block, storage should go out of scope here and files should close.
 
+  // slabs are read ahead and written behind; check out of order access,
+  // thicker slabs, and slabs held on to while others are read.
+  {
+    bvxm_voxel_storage_disk<float> storage(storage_fname,grid_size);
+    const unsigned slice_size = grid_size.x()*grid_size.y();
+
+    // add 1 to every voxel, two slices at a time
+    for (unsigned i=0; i+2 <= storage.nz(); i+=2) {
+      bvxm_voxel_slab<float> slab = storage.get_slab(i,2);
+      for (bvxm_voxel_slab<float>::iterator vit = slab.begin(); vit != slab.end(); ++vit)
+        *vit += 1.0f;
+      storage.put_slab();
+    }
+
+    // a slab keeps its values while later slabs are read
+    bvxm_voxel_slab<float> first = storage.get_slab(0,1);
+    bvxm_voxel_slab<float> second = storage.get_slab(1,1);
+    TEST("Held slab keeps its values", first(0,0) == 1.0f && second(0,0) == float(slice_size)+1.0f, true);
+
+    // going backwards, and reading a slice again after writing it
+    bool backward_check = true;
+    for (int i=int(storage.nz())-1; i >= 0; i-=7) {
+      bvxm_voxel_slab<float> slab = storage.get_slab(i,1);
+      if (slab(1,2) != float(i*slice_size + 2*grid_size.x() + 1) + 1.0f)
+        backward_check = false;
+      slab(1,2) = -1.0f;
+      storage.put_slab();
+      if (storage.get_slab(i,1)(1,2) != -1.0f)
+        backward_check = false;
+    }
+    TEST("Out of order reads and writes", backward_check, true);
+
+    // the values written are those of the slab when it was put
+    {
+      bvxm_voxel_slab<float> slab = storage.get_slab(3,1);
+      slab.fill(-5.0f);
+      storage.put_slab();
+      slab.fill(-6.0f);
+    }
+    TEST("Slab changed after it was put", storage.get_slab(3,1)(2,1), -5.0f);
+
+    storage.increment_observations();
+    TEST("Observations after slab writes", storage.num_observations(), 1);
+  }
+
   // remove temporary file
   vul_file::delete_file_glob(storage_fname.c_str());
 }
@@ -1,6 +1,7 @@
 #include <testlib/testlib_register.h>
 
 DECLARE( test_apm_processors );
+DECLARE( test_mog_parallel_update );
 DECLARE( test_lidar_processor );
 DECLARE( test_voxel_world );
 DECLARE( test_voxel_world_update );
@@ -11,6 +12,7 @@ DECLARE( test_illum );
 void register_tests()
 {
   REGISTER( test_apm_processors );
+  REGISTER( test_mog_parallel_update );
   REGISTER( test_lidar_processor );
   REGISTER( test_voxel_world );
   REGISTER( test_voxel_world_update );
@@ -7,6 +7,7 @@
 #include <bvxm/bvxm_lidar_processor.h>
 #include <bvxm/bvxm_mog_grey_processor.h>
 #include <bvxm/bvxm_mog_mc_processor.h>
+#include <bvxm/bvxm_mog_parallel.h>
 #include <bvxm/bvxm_mog_rgb_processor.h>
 #include <bvxm/bvxm_util.h>
 #include <bvxm/bvxm_von_mises_tangent_processor.h>
@@ -0,0 +1,139 @@
+#include <vector>
+#include <string>
+#include <sstream>
+#include <testlib/testlib_test.h>
+#include <bvxm/grid/bvxm_voxel_slab.h>
+#include <bvxm/bvxm_mog_grey_processor.h>
+#include <bvxm/bvxm_mog_rgb_processor.h>
+
+#include <bsta/bsta_gauss_sf1.h>
+#include <bsta/bsta_gauss_if3.h>
+#include <bsta/algo/bsta_adaptive_updater.h>
+#include <vil/vil_parallel.h>
+#include <vnl/vnl_random.h>
+
+// the parameters of the processors' updaters
+static const float init_variance = 0.008f;
+static const float min_stddev = 0.02f;
+static const float g_thresh = 2.5f;
+
+static void random_obs(float& v, vnl_random& rng) { v = (float)rng.drand32(); }
+
+static void random_obs(bvxm_mog_rgb_processor::obs_datatype& v, vnl_random& rng)
+{
+  for (unsigned k=0; k<3; ++k) v[k] = (float)rng.drand32();
+}
+
+//: random observations, and weights of which about a quarter are zero
+template <class OBS>
+static void random_slabs(std::vector<bvxm_voxel_slab<OBS> >& obs, std::vector<bvxm_voxel_slab<float> >& weight,
+                         unsigned n_obs, unsigned nx, unsigned ny, vnl_random& rng)
+{
+  for (unsigned o=0; o<n_obs; ++o) {
+    obs.push_back(bvxm_voxel_slab<OBS>(nx,ny,1));
+    weight.push_back(bvxm_voxel_slab<float>(nx,ny,1));
+    for (unsigned i=0; i<obs[o].size(); ++i) {
+      random_obs(obs[o].first_voxel()[i], rng);
+      weight[o].first_voxel()[i] = rng.drand32() < 0.25 ? 0.0f : (float)rng.drand32();
+    }
+  }
+}
+
+//: the update as a serial loop over the voxels, one observation at a time
+template <class MIX, class OBS, class G>
+static void serial_update(bvxm_voxel_slab<bsta_num_obs<MIX> >& appear,
+                          std::vector<bvxm_voxel_slab<OBS> > const& obs,
+                          std::vector<bvxm_voxel_slab<float> > const& weight,
+                          G const& init_gauss)
+{
+  bsta_mg_grimson_weighted_updater<MIX> updater(init_gauss, 3, g_thresh, min_stddev);
+  for (unsigned o=0; o<obs.size(); ++o)
+    for (unsigned i=0; i<appear.size(); ++i)
+      if (weight[o].first_voxel()[i] > 0)
+        updater(appear.first_voxel()[i], obs[o].first_voxel()[i], weight[o].first_voxel()[i]);
+}
+
+//: true if the mixtures in the slabs are exactly the same
+template <class M>
+static bool same_mixtures(bvxm_voxel_slab<M> const& a, bvxm_voxel_slab<M> const& b)
+{
+  for (unsigned i=0; i<a.size(); ++i) {
+    M const& ma = a.first_voxel()[i];
+    M const& mb = b.first_voxel()[i];
+    if (ma.num_observations != mb.num_observations || ma.num_components() != mb.num_components())
+      return false;
+    for (unsigned c=0; c<ma.num_components(); ++c)
+      if (ma.weight(c) != mb.weight(c) ||
+          ma.distribution(c).num_observations != mb.distribution(c).num_observations ||
+          !(ma.distribution(c).mean() == mb.distribution(c).mean()) ||
+          !(ma.distribution(c).covar() == mb.distribution(c).covar()))
+        return false;
+  }
+  return true;
+}
+
+template <class PROC, class G>
+static void test_processor(std::string const& name, G const& init_gauss)
+{
+  typedef typename PROC::apm_datatype apm_datatype;
+  typedef typename PROC::obs_datatype obs_datatype;
+  PROC processor;
+
+  const unsigned nx = 128, ny = 96, n_obs = 6;
+  vnl_random rng(1234);
+  std::vector<bvxm_voxel_slab<obs_datatype> > obs;
+  std::vector<bvxm_voxel_slab<float> > weight;
+  random_slabs(obs, weight, n_obs, nx, ny, rng);
+
+  bvxm_voxel_slab<apm_datatype> expected(nx,ny,1);
+  expected.fill(apm_datatype());
+  serial_update(expected, obs, weight, init_gauss);
+
+  const unsigned threads[] = { 1, 4 };
+  for (unsigned t=0; t<2; ++t)
+  {
+    vil_parallel_set_max_threads(threads[t]);
+    std::stringstream s;
+    s << name << ", " << threads[t] << " threads: ";
+
+    bvxm_voxel_slab<apm_datatype> appear(nx,ny,1);
+    appear.fill(apm_datatype());
+    bool ok = true;
+    for (unsigned o=0; o<n_obs; ++o)
+      ok = ok && processor.update(appear, obs[o], weight[o]);
+    TEST((s.str() + "update() one image at a time matches the serial loop").c_str(),
+         ok && same_mixtures(appear, expected), true);
+
+    bvxm_voxel_slab<apm_datatype> batch(nx,ny,1);
+    batch.fill(apm_datatype());
+    TEST((s.str() + "update() with all images at once matches the serial loop").c_str(),
+         processor.update(batch, obs, weight) && same_mixtures(batch, expected), true);
+
+    bool same_density = true;
+    bvxm_voxel_slab<float> prob = processor.prob_density(appear, obs[0]);
+    for (unsigned i=0; i<appear.size(); ++i) {
+      apm_datatype const& mix = expected.first_voxel()[i];
+      float p = mix.num_components() == 0 ? 1.0f : mix.prob_density(obs[0].first_voxel()[i]);
+      if (prob.first_voxel()[i] != p)
+        same_density = false;
+    }
+    TEST((s.str() + "prob_density() matches the serial loop").c_str(), same_density, true);
+  }
+
+  std::vector<bvxm_voxel_slab<float> > short_weight(weight.begin(), weight.end()-1);
+  bvxm_voxel_slab<apm_datatype> appear(nx,ny,1);
+  TEST((name + ": update() rejects unmatched observations and weights").c_str(),
+       processor.update(appear, obs, short_weight), false);
+
+  vil_parallel_set_max_threads(0);
+}
+
+static void test_mog_parallel_update()
+{
+  test_processor<bvxm_mog_grey_processor>("grey", bsta_gauss_sf1(0.0f, init_variance));
+
+  bsta_gaussian_indep<float,3>::covar_type init_covar(init_variance);
+  test_processor<bvxm_mog_rgb_processor>("rgb", bsta_gauss_if3(bvxm_mog_rgb_processor::obs_datatype(0.0f), init_covar));
+}
+
+TESTMAIN( test_mog_parallel_update );
@@ -7,6 +7,9 @@
 #include <vil/vil_crop.h>
 #include <vidl/vidl_config.h>
 #include <vidl/vidl_convert.h>
+#include <vidl/vidl_color.h>
+#include <vidl/vidl_frame_pool.h>
+#include <vil/vil_memory_pool.h>
 #include <vul/vul_timer.h>
 
 #if VIDL_HAS_FFMPEG
@@ -162,6 +165,104 @@ static void test_convert()
                << " format pairs\n";
   }
 
+  // optimized YUV conversions against the per pixel conversion
+  {
+    const unsigned ni = 38, nj = 6, n = ni*nj;
+    vxl_byte in[2*ni*nj], out[3*ni*nj];
+    for (unsigned k=0; k<2*n; ++k)
+      in[k] = vxl_byte((k*97 + (k*k)%251) & 0xff);
+
+    // 4:2:2, including an odd number of pixels
+    const vidl_pixel_format fmt422[2] = { VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_YUYV_422 };
+    const unsigned ni422[2] = { ni, 37 }, nj422[2] = { nj, 5 };
+    for (unsigned f=0; f<2; ++f) {
+      const unsigned y_off = f==0 ? 1 : 0;
+      for (unsigned s=0; s<2; ++s) {
+        const unsigned w = ni422[s], h = nj422[s], m = w*h;
+        vidl_shared_frame yuv(in, w, h, fmt422[f]);
+        bool rgb_ok = true, planar_ok = true, mono_ok = true;
+        vidl_shared_frame rgb(out, w, h, VIDL_PIXEL_FORMAT_RGB_24);
+        vidl_convert_frame(yuv, rgb);
+        for (unsigned k=0; k<m; ++k) {
+          const vxl_byte* p = in + 4*(k/2);
+          vxl_byte u = p[1-y_off], v = (k|1) < m ? p[3-y_off] : vxl_byte(128), r, g, b;
+          vidl_color_convert_yuv2rgb(in[2*k+y_off], u, v, r, g, b);
+          rgb_ok = rgb_ok && out[3*k] == r && out[3*k+1] == g && out[3*k+2] == b;
+        }
+        vidl_shared_frame rgbp(out, w, h, VIDL_PIXEL_FORMAT_RGB_24P);
+        vidl_convert_frame(yuv, rgbp);
+        for (unsigned k=0; k<m; ++k) {
+          const vxl_byte* p = in + 4*(k/2);
+          vxl_byte u = p[1-y_off], v = (k|1) < m ? p[3-y_off] : vxl_byte(128), r, g, b;
+          vidl_color_convert_yuv2rgb(in[2*k+y_off], u, v, r, g, b);
+          planar_ok = planar_ok && out[k] == r && out[m+k] == g && out[2*m+k] == b;
+        }
+        vidl_shared_frame mono(out, w, h, VIDL_PIXEL_FORMAT_MONO_8);
+        vidl_convert_frame(yuv, mono);
+        for (unsigned k=0; k<m; ++k)
+          mono_ok = mono_ok && out[k] == in[2*k+y_off];
+        std::cout << vidl_pixel_format_to_string(fmt422[f]) << ' ' << w << 'x' << h << std::endl;
+        TEST("4:2:2 to RGB_24", rgb_ok, true);
+        TEST("4:2:2 to RGB_24P", planar_ok, true);
+        TEST("4:2:2 to MONO_8", mono_ok, true);
+      }
+    }
+
+    // 4:2:0 planar
+    const vxl_byte* y = in;
+    const vxl_byte* u = in + n;
+    const vxl_byte* v = u + n/4;
+    bool rgb_ok = true, planar_ok = true, swap_ok = true, mono_ok = true;
+    vidl_shared_frame yuv(in, ni, nj, VIDL_PIXEL_FORMAT_YUV_420P);
+    vidl_shared_frame rgb(out, ni, nj, VIDL_PIXEL_FORMAT_RGB_24);
+    vidl_convert_frame(yuv, rgb);
+    for (unsigned j=0; j<nj; ++j)
+      for (unsigned i=0; i<ni; ++i) {
+        const unsigned k = j*ni+i, c = (j/2)*(ni/2)+i/2;
+        vxl_byte r, g, b;
+        vidl_color_convert_yuv2rgb(y[k], u[c], v[c], r, g, b);
+        rgb_ok = rgb_ok && out[3*k] == r && out[3*k+1] == g && out[3*k+2] == b;
+      }
+    vidl_shared_frame rgbp(out, ni, nj, VIDL_PIXEL_FORMAT_RGB_24P);
+    vidl_convert_frame(yuv, rgbp);
+    for (unsigned j=0; j<nj; ++j)
+      for (unsigned i=0; i<ni; ++i) {
+        const unsigned k = j*ni+i, c = (j/2)*(ni/2)+i/2;
+        vxl_byte r, g, b;
+        vidl_color_convert_yuv2rgb(y[k], u[c], v[c], r, g, b);
+        planar_ok = planar_ok && out[k] == r && out[n+k] == g && out[2*n+k] == b;
+      }
+    vidl_shared_frame yvu(in, ni, nj, VIDL_PIXEL_FORMAT_YVU_420P);
+    vidl_convert_frame(yvu, rgb);
+    for (unsigned j=0; j<nj; ++j)
+      for (unsigned i=0; i<ni; ++i) {
+        const unsigned k = j*ni+i, c = (j/2)*(ni/2)+i/2;
+        vxl_byte r, g, b;
+        vidl_color_convert_yuv2rgb(y[k], v[c], u[c], r, g, b);
+        swap_ok = swap_ok && out[3*k] == r && out[3*k+1] == g && out[3*k+2] == b;
+      }
+    vidl_shared_frame mono(out, ni, nj, VIDL_PIXEL_FORMAT_MONO_8);
+    vidl_convert_frame(yuv, mono);
+    for (unsigned k=0; k<n; ++k)
+      mono_ok = mono_ok && out[k] == y[k];
+    TEST("YUV_420P to RGB_24", rgb_ok, true);
+    TEST("YUV_420P to RGB_24P", planar_ok, true);
+    TEST("YVU_420P to RGB_24", swap_ok, true);
+    TEST("YUV_420P to MONO_8", mono_ok, true);
+
+    // frames converted into a pool reuse the buffers of released frames
+    vil_memory_pool pool_memory(std::size_t(1) << 20, 0);
+    vidl_frame_pool pool(&pool_memory);
+    vidl_frame_sptr src = new vidl_shared_frame(in, ni, nj, VIDL_PIXEL_FORMAT_UYVY_422);
+    vidl_frame_sptr conv = vidl_convert_frame(src, VIDL_PIXEL_FORMAT_RGB_24, pool);
+    TEST("vidl_convert_frame into a pool", conv && conv->pixel_format() == VIDL_PIXEL_FORMAT_RGB_24 &&
+                                           conv->size() >= 3*n, true);
+    const void* first = conv->data();
+    conv = VXL_NULLPTR;
+    conv = vidl_convert_frame(src, VIDL_PIXEL_FORMAT_RGB_24, pool);
+    TEST("pool buffer reused", conv->data() == first && pool_memory.stats().hits == 1, true);
+  }
+
   // timing tests
   {
     const int ni = 640, nj = 480;
@@ -4,6 +4,7 @@ DECLARE( test_pixel_format );
 DECLARE( test_pixel_iterator );
 DECLARE( test_color);
 DECLARE( test_convert);
+DECLARE( test_prefetch_istream );
 
 void
 register_tests()
@@ -12,6 +13,7 @@ register_tests()
   REGISTER( test_pixel_iterator );
   REGISTER( test_color );
   REGISTER( test_convert );
+  REGISTER( test_prefetch_istream );
 }
 
 DEFINE_MAIN;
@@ -5,12 +5,14 @@
 #include <vidl/vidl_exception.h>
 #include <vidl/vidl_frame.h>
 #include <vidl/vidl_frame_sptr.h>
+#include <vidl/vidl_frame_pool.h>
 #include <vidl/vidl_pixel_format.h>
 #include <vidl/vidl_pixel_iterator.h>
 #include <vidl/vidl_istream.h>
 #include <vidl/vidl_istream_sptr.h>
 #include <vidl/vidl_istream_image_resource.h>
 #include <vidl/vidl_image_list_istream.h>
+#include <vidl/vidl_prefetch_istream.h>
 #include <vidl/vidl_ostream.h>
 #include <vidl/vidl_ostream_sptr.h>
 #include <vidl/vidl_image_list_ostream.h>
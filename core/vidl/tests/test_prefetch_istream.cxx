@@ -0,0 +1,162 @@
+// This is core/vidl/tests/test_prefetch_istream.cxx
+#include <iostream>
+#include <vector>
+#include <testlib/testlib_test.h>
+#include <vcl_compiler.h>
+#include <vxl_config.h>
+#include <vidl/vidl_prefetch_istream.h>
+#include <vidl/vidl_frame.h>
+
+//: A seekable stream of small grey frames filled with their frame number.
+// Like many streams it reuses one buffer for every frame.  That buffer may
+// have padding bytes beyond the 4x2 pixels.
+class test_counting_istream : public vidl_istream
+{
+ public:
+  test_counting_istream(unsigned n, unsigned padding = 0)
+    : n_(n), index_(unsigned(-1)), open_(true),
+      buffer_(new vil_memory_chunk(8 + padding, VIL_PIXEL_FORMAT_BYTE))
+  { frame_ = new vidl_memory_chunk_frame(4, 2, VIDL_PIXEL_FORMAT_MONO_8, buffer_); }
+
+  virtual bool is_open() const { return open_; }
+  virtual bool is_valid() const { return open_ && index_ < n_; }
+  virtual bool is_seekable() const { return true; }
+  virtual int num_frames() const { return int(n_); }
+  virtual unsigned int frame_number() const { return index_; }
+  virtual unsigned int width() const { return 4; }
+  virtual unsigned int height() const { return 2; }
+  virtual vidl_pixel_format format() const { return VIDL_PIXEL_FORMAT_MONO_8; }
+  virtual double frame_rate() const { return 25.0; }
+  virtual double duration() const { return n_/25.0; }
+  virtual void close() { open_ = false; }
+  virtual bool advance()
+  {
+    if (index_ < n_ || index_ == unsigned(-1))
+      ++index_;
+    return is_valid();
+  }
+  virtual vidl_frame_sptr read_frame() { advance(); return current_frame(); }
+  virtual vidl_frame_sptr current_frame()
+  {
+    if (!is_valid())
+      return VXL_NULLPTR;
+    vxl_byte* data = static_cast<vxl_byte*>(buffer_->data());
+    for (unsigned i = 0; i < buffer_->size(); ++i)
+      data[i] = vxl_byte(index_);
+    return frame_;
+  }
+  virtual bool seek_frame(unsigned int frame_number)
+  {
+    if (!open_ || frame_number >= n_)
+      return false;
+    index_ = frame_number;
+    return true;
+  }
+
+ private:
+  unsigned n_;
+  unsigned index_;
+  bool open_;
+  vil_memory_chunk_sptr buffer_;
+  vidl_frame_sptr frame_;
+};
+
+//: True if frame is of size bytes, filled with the value n.
+static bool frame_is(const vidl_frame_sptr& frame, unsigned n, unsigned long size = 8)
+{
+  if (!frame || frame->size() != size)
+    return false;
+  const vxl_byte* data = static_cast<const vxl_byte*>(frame->data());
+  for (unsigned i = 0; i < size; ++i)
+    if (data[i] != vxl_byte(n))
+      return false;
+  return true;
+}
+
+static void test_prefetch_istream()
+{
+  std::cout << "*******************************\n"
+            << " Testing vidl_prefetch_istream\n"
+            << "*******************************\n";
+
+  const unsigned n = 20;
+  {
+    vidl_prefetch_istream is(new test_counting_istream(n), 4);
+    TEST("is_open", is.is_open(), true);
+    TEST("not valid before advance", is.is_valid(), false);
+    TEST("num_frames", is.num_frames(), int(n));
+    TEST("size", is.width() == 4 && is.height() == 2, true);
+    TEST("format", is.format(), VIDL_PIXEL_FORMAT_MONO_8);
+    TEST_NEAR("frame_rate", is.frame_rate(), 25.0, 1e-12);
+    TEST("buffer_size", is.buffer_size(), 4);
+
+    // frames must still hold their own data after later frames are read
+    std::vector<vidl_frame_sptr> frames;
+    bool in_order = true;
+    while (vidl_frame_sptr f = is.read_frame()) {
+      in_order = in_order && is.frame_number() == frames.size();
+      frames.push_back(f);
+    }
+    TEST("all frames read", frames.size(), n);
+    TEST("frame numbers in order", in_order, true);
+    bool data_ok = true;
+    for (unsigned k = 0; k < frames.size(); ++k)
+      data_ok = data_ok && frame_is(frames[k], k);
+    TEST("frame data kept", data_ok, true);
+    TEST("not valid at end", is.is_valid(), false);
+    TEST("no current frame at end", !is.current_frame(), true);
+    TEST("advance at end", is.advance(), false);
+
+    TEST("seek back", is.seek_frame(5), true);
+    TEST("valid after seek", is.is_valid(), true);
+    TEST("frame number after seek", is.frame_number(), 5);
+    TEST("frame after seek", frame_is(is.current_frame(), 5), true);
+    TEST("frame after seek read", frame_is(is.read_frame(), 6) && is.frame_number() == 6, true);
+
+    // a failed seek leaves the stream where it was
+    TEST("seek past end", is.seek_frame(n), false);
+    TEST("frame number kept", is.frame_number(), 6);
+    TEST("frame after failed seek", frame_is(is.read_frame(), 7) && is.frame_number() == 7, true);
+
+    // seek while frames ahead are buffered
+    is.read_frame();
+    TEST("seek forward", is.seek_frame(15) && frame_is(is.current_frame(), 15), true);
+    unsigned count = 0;
+    bool data_ok2 = true;
+    while (vidl_frame_sptr f = is.read_frame())
+      data_ok2 = data_ok2 && frame_is(f, 16 + count++);
+    TEST("frames after seek", count == n-16 && data_ok2, true);
+
+    is.close();
+    TEST("closed", is.is_open(), false);
+    TEST("advance when closed", is.advance(), false);
+    TEST("seek when closed", is.seek_frame(0), false);
+  }
+
+  {
+    // a stream advanced before it is wrapped continues from there
+    vidl_istream_sptr source = new test_counting_istream(n);
+    source->seek_frame(9);
+    vidl_prefetch_istream is(source, 1);
+    TEST("wrapped at frame", is.is_valid() && is.frame_number() == 9, true);
+    TEST("wrapped frame", frame_is(is.current_frame(), 9), true);
+    TEST("next frame", frame_is(is.read_frame(), 10), true);
+    // destroying the adaptor stops reading but leaves the source open
+  }
+
+  {
+    // padded frames are kept whole
+    vidl_prefetch_istream is(new test_counting_istream(n, 5), 2);
+    bool padded_ok = true;
+    for (unsigned i = 0; i < 4; ++i)
+      padded_ok = padded_ok && frame_is(is.read_frame(), i, 13);
+    TEST("padded frames", padded_ok, true);
+  }
+
+  {
+    vidl_prefetch_istream is(VXL_NULLPTR);
+    TEST("no stream", !is.is_open() && !is.advance() && !is.read_frame(), true);
+  }
+}
+
+TESTMAIN(test_prefetch_istream);
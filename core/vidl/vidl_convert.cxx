@@ -14,10 +14,12 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include "vidl_convert.h"
 #include "vidl_frame.h"
+#include "vidl_frame_pool.h"
 #include "vidl_pixel_format.h"
 #include "vidl_pixel_iterator.hxx"
 #include "vidl_color.h"
@@ -33,6 +35,14 @@
 #include <vcl_cassert.h>
 #include <vcl_compiler.h>
 
+// SSE2 is part of every x86-64 processor
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define VIDL_CONVERT_SSE2 1
+# include <emmintrin.h>
+#else
+# define VIDL_CONVERT_SSE2 0
+#endif
+
 //--------------------------------------------------------------------------------
 
 
@@ -151,65 +161,6 @@ struct convert<VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_UYVY_422>
 };
 
 
-// UYVY_422 to RGB_24
-template <>
-struct convert<VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_RGB_24>
-{
-  enum { defined = true };
-  static bool apply(vidl_frame const& in_frame,
-                    vidl_frame& out_frame)
-  {
-    assert(in_frame.pixel_format()==VIDL_PIXEL_FORMAT_UYVY_422);
-    assert(out_frame.pixel_format()==VIDL_PIXEL_FORMAT_RGB_24);
-    const vxl_byte* uyvy = reinterpret_cast<const vxl_byte*>(in_frame.data());
-    vxl_byte* rgb = reinterpret_cast<vxl_byte*>(out_frame.data());
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1)/2;
-    for (unsigned int c=0; c<num_half_pix; ++c) {
-      const vxl_byte& u1 = *(uyvy++);
-      const vxl_byte& y1 = *(uyvy++);
-      const vxl_byte& v1 = *(uyvy++);
-      const vxl_byte& y2 = *(uyvy++);
-      vxl_byte r,g,b;
-      vidl_color_convert_yuv2rgb(y1,u1,v1,r,g,b);
-      *(rgb++) = r;
-      *(rgb++) = g;
-      *(rgb++) = b;
-      vidl_color_convert_yuv2rgb(y2,u1,v1,r,g,b);
-      *(rgb++) = r;
-      *(rgb++) = g;
-      *(rgb++) = b;
-    }
-    return true;
-  }
-};
-
-
-// UYVY_422 to MONO_8
-template <>
-struct convert<VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_MONO_8>
-{
-  enum { defined = true };
-  static bool apply(vidl_frame const& in_frame,
-                    vidl_frame& out_frame)
-  {
-    assert(in_frame.pixel_format()==VIDL_PIXEL_FORMAT_UYVY_422);
-    assert(out_frame.pixel_format()==VIDL_PIXEL_FORMAT_MONO_8);
-    const vxl_byte* uyvy = reinterpret_cast<const vxl_byte*>(in_frame.data());
-    vxl_byte* mono = reinterpret_cast<vxl_byte*>(out_frame.data());
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1)/2;
-    for (unsigned int c=0; c<num_half_pix; ++c) {
-      ++uyvy;
-      const vxl_byte& y1 = *(uyvy++);
-      ++uyvy;
-      const vxl_byte& y2 = *(uyvy++);
-      *(mono++) = y1;
-      *(mono++) = y2;
-    }
-    return true;
-  }
-};
-
-
 // RGB_24 to YUYV_422
 template <>
 struct convert<VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_YUYV_422>
@@ -243,39 +194,6 @@ struct convert<VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_YUYV_422>
 };
 
 
-// YUYV_422 to RGB_24
-template <>
-struct convert<VIDL_PIXEL_FORMAT_YUYV_422, VIDL_PIXEL_FORMAT_RGB_24>
-{
-  enum { defined = true };
-  static bool apply(vidl_frame const& in_frame,
-                    vidl_frame& out_frame)
-  {
-    assert(in_frame.pixel_format()==VIDL_PIXEL_FORMAT_YUYV_422);
-    assert(out_frame.pixel_format()==VIDL_PIXEL_FORMAT_RGB_24);
-    const vxl_byte* yuyv = reinterpret_cast<const vxl_byte*>(in_frame.data());
-    vxl_byte* rgb = reinterpret_cast<vxl_byte*>(out_frame.data());
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1)/2;
-    for (unsigned int c=0; c<num_half_pix; ++c) {
-      const vxl_byte& y1 = *(yuyv++);
-      const vxl_byte& u1 = *(yuyv++);
-      const vxl_byte& y2 = *(yuyv++);
-      const vxl_byte& v1 = *(yuyv++);
-      vxl_byte r,g,b;
-      vidl_color_convert_yuv2rgb(y1,u1,v1,r,g,b);
-      *(rgb++) = r;
-      *(rgb++) = g;
-      *(rgb++) = b;
-      vidl_color_convert_yuv2rgb(y2,u1,v1,r,g,b);
-      *(rgb++) = r;
-      *(rgb++) = g;
-      *(rgb++) = b;
-    }
-    return true;
-  }
-};
-
-
 // RGB_24P to YUYV_422
 template <>
 struct convert<VIDL_PIXEL_FORMAT_RGB_24P, VIDL_PIXEL_FORMAT_YUYV_422>
@@ -310,36 +228,274 @@ struct convert<VIDL_PIXEL_FORMAT_RGB_24P, VIDL_PIXEL_FORMAT_YUYV_422>
   }
 };
 
-// YUYV_422 to RGB_24P
+//-----------------------------------------------------------------------------
+// YUV to RGB and mono
+//
+// These give exactly the results of the integer vidl_color_convert_yuv2rgb(),
+// but compute the chroma terms once for the pixels which share them, and
+// with SSE2 convert sixteen pixels at a time.  Packed 4:2:2 data is taken
+// as one run of pixels, as in the conversions above.
+
+//: Clamp to the range of a byte
+inline vxl_byte yuv_clamp(int x)
+{
+  return vxl_byte(x < 0 ? 0 : (x > 255 ? 255 : x));
+}
+
+//: The terms of vidl_color_convert_yuv2rgb() which depend on chroma
+struct yuv_chroma
+{
+  int r, g, b;
+  yuv_chroma(int u, int v)
+  {
+    const int iu = u-128, iv = v-128;
+    r = (iv*1436) >> 10;
+    g = (iu*352 + iv*731) >> 10;
+    b = (iu*1814) >> 10;
+  }
+};
+
+//: Write pixel k of luma y with chroma terms c, each output component being OS bytes apart
+template <int OS>
+inline void yuv_put_rgb(int y, const yuv_chroma& c, unsigned k,
+                        vxl_byte* r, vxl_byte* g, vxl_byte* b)
+{
+  r[k*OS] = yuv_clamp(y + c.r);
+  g[k*OS] = yuv_clamp(y - c.g);
+  b[k*OS] = yuv_clamp(y + c.b);
+}
+
+#if VIDL_CONVERT_SSE2
+//: Convert 16 pixels to RGB.
+// y0 and y1 hold the luma of pixels 0-7 and 8-15 as 16 bit values, and
+// uv0 and uv1 the chroma of pixel pairs 0-3 and 4-7 as 16 bit (u,v) pairs.
+// OS is 1 for separate planes, or 3 for interleaved RGB starting at r.
+template <int OS>
+inline void yuv16_to_rgb(__m128i y0, __m128i y1, __m128i uv0, __m128i uv1,
+                         vxl_byte* r, vxl_byte* g, vxl_byte* b)
+{
+  const __m128i c128 = _mm_set1_epi16(128);
+  uv0 = _mm_sub_epi16(uv0, c128);
+  uv1 = _mm_sub_epi16(uv1, c128);
+  // each 32 bit lane of a product is u*(low coefficient) + v*(high coefficient)
+  const __m128i kr = _mm_set1_epi32(1436 << 16);
+  const __m128i kg = _mm_set1_epi32(352 | (731 << 16));
+  const __m128i kb = _mm_set1_epi32(1814);
+  const __m128i dr = _mm_packs_epi32(_mm_srai_epi32(_mm_madd_epi16(uv0, kr), 10),
+                                     _mm_srai_epi32(_mm_madd_epi16(uv1, kr), 10));
+  const __m128i dg = _mm_packs_epi32(_mm_srai_epi32(_mm_madd_epi16(uv0, kg), 10),
+                                     _mm_srai_epi32(_mm_madd_epi16(uv1, kg), 10));
+  const __m128i db = _mm_packs_epi32(_mm_srai_epi32(_mm_madd_epi16(uv0, kb), 10),
+                                     _mm_srai_epi32(_mm_madd_epi16(uv1, kb), 10));
+  // one term per pair of pixels, and saturation to bytes clamps
+  const __m128i vr = _mm_packus_epi16(_mm_add_epi16(y0, _mm_unpacklo_epi16(dr, dr)),
+                                      _mm_add_epi16(y1, _mm_unpackhi_epi16(dr, dr)));
+  const __m128i vg = _mm_packus_epi16(_mm_sub_epi16(y0, _mm_unpacklo_epi16(dg, dg)),
+                                      _mm_sub_epi16(y1, _mm_unpackhi_epi16(dg, dg)));
+  const __m128i vb = _mm_packus_epi16(_mm_add_epi16(y0, _mm_unpacklo_epi16(db, db)),
+                                      _mm_add_epi16(y1, _mm_unpackhi_epi16(db, db)));
+  if (OS == 1) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(r), vr);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(g), vg);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(b), vb);
+  }
+  else {
+    // interleave to 0BGR words, four pixels to a vector, then close the
+    // gaps to 12 bytes: within each 64 bit half, then between the halves
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rg_lo = _mm_unpacklo_epi8(vr, vg), rg_hi = _mm_unpackhi_epi8(vr, vg);
+    const __m128i b_lo = _mm_unpacklo_epi8(vb, zero), b_hi = _mm_unpackhi_epi8(vb, zero);
+    __m128i px[4] = { _mm_unpacklo_epi16(rg_lo, b_lo), _mm_unpackhi_epi16(rg_lo, b_lo),
+                      _mm_unpacklo_epi16(rg_hi, b_hi), _mm_unpackhi_epi16(rg_hi, b_hi) };
+    const __m128i m_lo = _mm_set_epi32(0, 0x00ffffff, 0, 0x00ffffff);
+    const __m128i m_hi = _mm_set_epi32(0x0000ffff, int(0xff000000), 0x0000ffff, int(0xff000000));
+    const __m128i m_6 = _mm_set_epi32(0, 0, 0x0000ffff, -1);
+    vxl_byte* rgb = r;
+    for (unsigned q=0; q<4; ++q) {
+      __m128i x = _mm_or_si128(_mm_and_si128(px[q], m_lo),
+                               _mm_and_si128(_mm_srli_epi64(px[q], 8), m_hi));
+      x = _mm_or_si128(_mm_and_si128(x, m_6), _mm_andnot_si128(m_6, _mm_srli_si128(x, 2)));
+      if (q < 3) {
+        // the last 4 bytes are overwritten by the next pixels
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb + 12*q), x);
+      }
+      else {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(rgb + 36), x);
+        const int last = _mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+        std::memcpy(rgb + 44, &last, 4);
+      }
+    }
+    (void)g; (void)b;
+  }
+}
+#endif // VIDL_CONVERT_SSE2
+
+//: Convert n pixels of packed 4:2:2 data to RGB
+// Luma is at byte YOff of each pair of bytes, and chroma at the other.
+template <int YOff, int OS>
+void yuv422_to_rgb(const vxl_byte* in, unsigned n,
+                   vxl_byte* r, vxl_byte* g, vxl_byte* b)
+{
+  unsigned k = 0;
+#if VIDL_CONVERT_SSE2
+  const __m128i mask = _mm_set1_epi16(0x00ff);
+  for (; k+16 <= n; k += 16, in += 32) {
+    const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in+16));
+    if (YOff == 1)
+      yuv16_to_rgb<OS>(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8),
+                       _mm_and_si128(a0, mask), _mm_and_si128(a1, mask),
+                       r+k*OS, g+k*OS, b+k*OS);
+    else
+      yuv16_to_rgb<OS>(_mm_and_si128(a0, mask), _mm_and_si128(a1, mask),
+                       _mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8),
+                       r+k*OS, g+k*OS, b+k*OS);
+  }
+#endif
+  for (; k+2 <= n; k += 2, in += 4) {
+    const yuv_chroma c(in[1-YOff], in[3-YOff]);
+    yuv_put_rgb<OS>(in[YOff], c, k, r, g, b);
+    yuv_put_rgb<OS>(in[2+YOff], c, k+1, r, g, b);
+  }
+  // a last odd pixel has no V sample
+  if (k < n)
+    yuv_put_rgb<OS>(in[YOff], yuv_chroma(in[1-YOff], 128), k, r, g, b);
+}
+
+//: Extract the luma of n pixels of packed 4:2:2 data
+template <int YOff>
+void yuv422_to_mono(const vxl_byte* in, unsigned n, vxl_byte* mono)
+{
+  unsigned k = 0;
+#if VIDL_CONVERT_SSE2
+  const __m128i mask = _mm_set1_epi16(0x00ff);
+  for (; k+16 <= n; k += 16, in += 32) {
+    __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in+16));
+    if (YOff == 1) {
+      a0 = _mm_srli_epi16(a0, 8);
+      a1 = _mm_srli_epi16(a1, 8);
+    }
+    else {
+      a0 = _mm_and_si128(a0, mask);
+      a1 = _mm_and_si128(a1, mask);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(mono+k), _mm_packus_epi16(a0, a1));
+  }
+#endif
+  for (; k<n; ++k, in += 2)
+    mono[k] = in[YOff];
+}
+
+//: Convert one row of n pixels of planar 4:2:0 data to RGB (n even)
+template <int OS>
+void yuv420_row_to_rgb(const vxl_byte* y, const vxl_byte* u, const vxl_byte* v,
+                       unsigned n, vxl_byte* r, vxl_byte* g, vxl_byte* b)
+{
+  unsigned k = 0;
+#if VIDL_CONVERT_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for (; k+16 <= n; k += 16) {
+    const __m128i yy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y+k));
+    const __m128i uu = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(u+k/2)), zero);
+    const __m128i vv = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(v+k/2)), zero);
+    yuv16_to_rgb<OS>(_mm_unpacklo_epi8(yy, zero), _mm_unpackhi_epi8(yy, zero),
+                     _mm_unpacklo_epi16(uu, vv), _mm_unpackhi_epi16(uu, vv),
+                     r+k*OS, g+k*OS, b+k*OS);
+  }
+#endif
+  for (; k<n; k += 2) {
+    const yuv_chroma c(u[k/2], v[k/2]);
+    yuv_put_rgb<OS>(y[k], c, k, r, g, b);
+    yuv_put_rgb<OS>(y[k+1], c, k+1, r, g, b);
+  }
+}
+
+//: Convert a packed 4:2:2 frame to RGB_24 or RGB_24P
+template <int YOff>
+bool yuv422_frame_to_rgb(vidl_frame const& in_frame, vidl_frame& out_frame)
+{
+  const vxl_byte* in = reinterpret_cast<const vxl_byte*>(in_frame.data());
+  vxl_byte* out = reinterpret_cast<vxl_byte*>(out_frame.data());
+  const unsigned n = in_frame.ni() * in_frame.nj();
+  if (out_frame.pixel_format() == VIDL_PIXEL_FORMAT_RGB_24P)
+    yuv422_to_rgb<YOff,1>(in, n, out, out+n, out+2*n);
+  else
+    yuv422_to_rgb<YOff,3>(in, n, out, out+1, out+2);
+  return true;
+}
+
+//: Convert a planar 4:2:0 frame to RGB_24 or RGB_24P
+// The chroma planes are in the order U, V, or V, U if Swap is set.
+template <bool Swap>
+bool yuv420p_frame_to_rgb(vidl_frame const& in_frame, vidl_frame& out_frame)
+{
+  const unsigned ni = in_frame.ni(), nj = in_frame.nj();
+  // odd sizes are left to the pixel iterators
+  if (ni%2 != 0 || nj%2 != 0)
+    return convert_generic(in_frame, out_frame);
+
+  const unsigned n = ni*nj;
+  const vxl_byte* y = reinterpret_cast<const vxl_byte*>(in_frame.data());
+  const vxl_byte* u = y + n;
+  const vxl_byte* v = u + n/4;
+  if (Swap)
+    std::swap(u, v);
+  vxl_byte* out = reinterpret_cast<vxl_byte*>(out_frame.data());
+  const bool planar = out_frame.pixel_format() == VIDL_PIXEL_FORMAT_RGB_24P;
+  for (unsigned j=0; j<nj; ++j) {
+    const unsigned c = (j/2)*(ni/2);
+    if (planar) {
+      vxl_byte* r = out + j*ni;
+      yuv420_row_to_rgb<1>(y + j*ni, u+c, v+c, ni, r, r+n, r+2*n);
+    }
+    else {
+      vxl_byte* rgb = out + 3*j*ni;
+      yuv420_row_to_rgb<3>(y + j*ni, u+c, v+c, ni, rgb, rgb+1, rgb+2);
+    }
+  }
+  return true;
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define vidl_convert_yuv_macro(IN, OUT, FUNC) \
+template <> \
+struct convert<VIDL_PIXEL_FORMAT_##IN, VIDL_PIXEL_FORMAT_##OUT> \
+{ \
+  enum { defined = true }; \
+  static bool apply(vidl_frame const& in_frame, \
+                    vidl_frame& out_frame) \
+  { \
+    assert(in_frame.pixel_format()==VIDL_PIXEL_FORMAT_##IN); \
+    assert(out_frame.pixel_format()==VIDL_PIXEL_FORMAT_##OUT); \
+    return FUNC(in_frame, out_frame); \
+  } \
+}
+
+vidl_convert_yuv_macro(UYVY_422, RGB_24,  yuv422_frame_to_rgb<1>);
+vidl_convert_yuv_macro(UYVY_422, RGB_24P, yuv422_frame_to_rgb<1>);
+vidl_convert_yuv_macro(YUYV_422, RGB_24,  yuv422_frame_to_rgb<0>);
+vidl_convert_yuv_macro(YUYV_422, RGB_24P, yuv422_frame_to_rgb<0>);
+vidl_convert_yuv_macro(YUV_420P, RGB_24,  yuv420p_frame_to_rgb<false>);
+vidl_convert_yuv_macro(YUV_420P, RGB_24P, yuv420p_frame_to_rgb<false>);
+vidl_convert_yuv_macro(YVU_420P, RGB_24,  yuv420p_frame_to_rgb<true>);
+vidl_convert_yuv_macro(YVU_420P, RGB_24P, yuv420p_frame_to_rgb<true>);
+#undef vidl_convert_yuv_macro
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+// UYVY_422 to MONO_8
 template <>
-struct convert<VIDL_PIXEL_FORMAT_YUYV_422, VIDL_PIXEL_FORMAT_RGB_24P>
+struct convert<VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_MONO_8>
 {
   enum { defined = true };
   static bool apply(vidl_frame const& in_frame,
                     vidl_frame& out_frame)
   {
-    assert(in_frame.pixel_format()==VIDL_PIXEL_FORMAT_YUYV_422);
-    assert(out_frame.pixel_format()==VIDL_PIXEL_FORMAT_RGB_24P);
-    const vxl_byte* yuyv = reinterpret_cast<const vxl_byte*>(in_frame.data());
-    vxl_byte* red = reinterpret_cast<vxl_byte*>(out_frame.data());
-    vxl_byte* green = red+out_frame.ni()*out_frame.nj();
-    vxl_byte* blue = green+out_frame.ni()*out_frame.nj();
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1)/2;
-    for (unsigned int c=0; c<num_half_pix; ++c) {
-      const vxl_byte& y1 = *(yuyv++);
-      const vxl_byte& u1 = *(yuyv++);
-      const vxl_byte& y2 = *(yuyv++);
-      const vxl_byte& v1 = *(yuyv++);
-      vxl_byte r,g,b;
-      vidl_color_convert_yuv2rgb(y1,u1,v1,r,g,b);
-      *(red++) = r;
-      *(green++) = g;
-      *(blue++) = b;
-      vidl_color_convert_yuv2rgb(y2,u1,v1,r,g,b);
-      *(red++) = r;
-      *(green++) = g;
-      *(blue++) = b;
-    }
+    assert(in_frame.pixel_format()==VIDL_PIXEL_FORMAT_UYVY_422);
+    assert(out_frame.pixel_format()==VIDL_PIXEL_FORMAT_MONO_8);
+    yuv422_to_mono<1>(reinterpret_cast<const vxl_byte*>(in_frame.data()),
+                      in_frame.ni() * in_frame.nj(),
+                      reinterpret_cast<vxl_byte*>(out_frame.data()));
     return true;
   }
 };
@@ -354,21 +510,41 @@ struct convert<VIDL_PIXEL_FORMAT_YUYV_422, VIDL_PIXEL_FORMAT_MONO_8>
   {
     assert(in_frame.pixel_format()==VIDL_PIXEL_FORMAT_YUYV_422);
     assert(out_frame.pixel_format()==VIDL_PIXEL_FORMAT_MONO_8);
-    const vxl_byte* yuyv = reinterpret_cast<const vxl_byte*>(in_frame.data());
-    vxl_byte* mono = reinterpret_cast<vxl_byte*>(out_frame.data());
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1)/2;
-    for (unsigned int c=0; c<num_half_pix; ++c) {
-      const vxl_byte& y1 = *(yuyv++);
-      ++yuyv;
-      const vxl_byte& y2 = *(yuyv++);
-      ++yuyv;
-      *(mono++) = y1;
-      *(mono++) = y2;
-    }
+    yuv422_to_mono<0>(reinterpret_cast<const vxl_byte*>(in_frame.data()),
+                      in_frame.ni() * in_frame.nj(),
+                      reinterpret_cast<vxl_byte*>(out_frame.data()));
     return true;
   }
 };
 
+// YUV_420P and YVU_420P to MONO_8 - the luma plane comes first
+template <>
+struct convert<VIDL_PIXEL_FORMAT_YUV_420P, VIDL_PIXEL_FORMAT_MONO_8>
+{
+  enum { defined = true };
+  static bool apply(vidl_frame const& in_frame,
+                    vidl_frame& out_frame)
+  {
+    assert(in_frame.pixel_format()==VIDL_PIXEL_FORMAT_YUV_420P);
+    assert(out_frame.pixel_format()==VIDL_PIXEL_FORMAT_MONO_8);
+    std::memcpy(out_frame.data(), in_frame.data(), in_frame.ni() * in_frame.nj());
+    return true;
+  }
+};
+
+template <>
+struct convert<VIDL_PIXEL_FORMAT_YVU_420P, VIDL_PIXEL_FORMAT_MONO_8>
+{
+  enum { defined = true };
+  static bool apply(vidl_frame const& in_frame,
+                    vidl_frame& out_frame)
+  {
+    assert(in_frame.pixel_format()==VIDL_PIXEL_FORMAT_YVU_420P);
+    assert(out_frame.pixel_format()==VIDL_PIXEL_FORMAT_MONO_8);
+    std::memcpy(out_frame.data(), in_frame.data(), in_frame.ni() * in_frame.nj());
+    return true;
+  }
+};
 
 // End of pixel conversion specializations
 //=============================================================================
@@ -528,6 +704,21 @@ vidl_frame_sptr vidl_convert_frame(const vidl_frame_sptr& in_frame,
   return NULL;
 }
 
+//: Convert the pixel format of a frame into a buffer from \p pool
+vidl_frame_sptr vidl_convert_frame(const vidl_frame_sptr& in_frame,
+                                   vidl_pixel_format format,
+                                   const vidl_frame_pool& pool)
+{
+  if (format == VIDL_PIXEL_FORMAT_UNKNOWN)
+    return NULL;
+
+  vidl_frame_sptr out_frame = pool.new_frame(in_frame->ni(), in_frame->nj(), format);
+  if (vidl_convert_frame(*in_frame, *out_frame))
+    return out_frame;
+
+  return NULL;
+}
+
 
 //: Convert the image view to a frame
 // Will wrap the memory if possible, if not the image is converted to
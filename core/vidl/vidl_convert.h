@@ -19,6 +19,8 @@
 #include "vidl_frame.h"
 #include <vil/vil_image_view_base.h>
 
+class vidl_frame_pool;
+
 
 //: Convert the frame into an image view
 // possibly converts the pixel data type
@@ -48,6 +50,13 @@ bool vidl_convert_frame(const vidl_frame& in_frame,
 vidl_frame_sptr vidl_convert_frame(const vidl_frame_sptr& in_frame,
                                    vidl_pixel_format format);
 
+//: Convert the pixel format of a frame
+// Convert \p in_frame to a \p format in a frame buffer from \p pool,
+// which is recycled when the frame is released
+vidl_frame_sptr vidl_convert_frame(const vidl_frame_sptr& in_frame,
+                                   vidl_pixel_format format,
+                                   const vidl_frame_pool& pool);
+
 //: Convert the image view smart pointer to a frame
 // Will wrap the memory if possible, if not the image is converted to
 // the closest vidl_pixel_format
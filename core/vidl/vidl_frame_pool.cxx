@@ -0,0 +1,27 @@
+// This is core/vidl/vidl_frame_pool.cxx
+#ifdef VCL_NEEDS_PRAGMA_INTERFACE
+#pragma implementation
+#endif
+//:
+// \file
+
+#include "vidl_frame_pool.h"
+#include "vidl_frame.h"
+#include <vil/vil_memory_chunk.h>
+#include <vil/vil_memory_pool.h>
+
+//: Constructor - take buffers from \p allocator
+vidl_frame_pool::vidl_frame_pool(vil_memory_allocator* allocator)
+  : allocator_(allocator ? allocator : &vil_memory_pool::instance())
+{
+}
+
+
+//: Make a frame of \p ni x \p nj pixels in format \p fmt
+vidl_frame_sptr
+vidl_frame_pool::new_frame(unsigned ni, unsigned nj, vidl_pixel_format fmt) const
+{
+  const unsigned long size = vidl_pixel_format_buffer_size(ni, nj, fmt);
+  vil_memory_chunk_sptr memory = new vil_memory_chunk(size, VIL_PIXEL_FORMAT_BYTE, allocator_);
+  return new vidl_memory_chunk_frame(ni, nj, fmt, memory);
+}
@@ -0,0 +1,51 @@
+// This is core/vidl/vidl_frame_pool.h
+#ifndef vidl_frame_pool_h_
+#define vidl_frame_pool_h_
+#ifdef VCL_NEEDS_PRAGMA_INTERFACE
+#pragma interface
+#endif
+//:
+// \file
+// \brief A source of frame buffers which are recycled when frames are released
+//
+// Converting or copying every frame of a video into a new buffer means
+// asking the system for, and page-faulting in, several megabytes per frame.
+// A vidl_frame_pool makes vidl_memory_chunk_frame objects whose buffers come
+// from a vil_memory_allocator, by default the shared vil_memory_pool, so that
+// a buffer freed with one frame is handed out again for the next:
+// \code
+//   vidl_frame_pool pool;
+//   while (vidl_frame_sptr frame = istream->read_frame())
+//   {
+//     vidl_frame_sptr rgb = vidl_convert_frame(frame, VIDL_PIXEL_FORMAT_RGB_24, pool);
+//     ...
+//   }
+// \endcode
+
+#include "vidl_frame_sptr.h"
+#include "vidl_pixel_format.h"
+#include <vcl_compiler.h>
+
+class vil_memory_allocator;
+
+//: A source of frame buffers which are recycled when frames are released
+class vidl_frame_pool
+{
+ public:
+  //: Constructor - take buffers from \p allocator
+  // The allocator must outlive every frame made from it.  If it is null,
+  // vil_memory_pool::instance() is used, which is never destroyed.
+  explicit vidl_frame_pool(vil_memory_allocator* allocator = VXL_NULLPTR);
+
+  //: Make a frame of \p ni x \p nj pixels in format \p fmt
+  // The contents of the buffer are undefined.
+  vidl_frame_sptr new_frame(unsigned ni, unsigned nj, vidl_pixel_format fmt) const;
+
+  //: The allocator providing the buffers
+  vil_memory_allocator* allocator() const { return allocator_; }
+
+ private:
+  vil_memory_allocator* allocator_;
+};
+
+#endif // vidl_frame_pool_h_
@@ -0,0 +1,267 @@
+// This is core/vidl/vidl_prefetch_istream.cxx
+#ifdef VCL_NEEDS_PRAGMA_INTERFACE
+#pragma implementation
+#endif
+//:
+// \file
+//
+//-----------------------------------------------------------------------------
+
+#include <cstring>
+#include "vidl_prefetch_istream.h"
+#include "vidl_frame.h"
+#include "vidl_frame_pool.h"
+#include <vcl_compiler.h>
+
+//--------------------------------------------------------------------------------
+
+
+//: The frame to keep of a frame read from the wrapped stream
+// When reading ahead this is a copy, since the wrapped stream may reuse its
+// buffer, and since frames are not reference counted safely across threads.
+static vidl_frame_sptr vidl_prefetch_own(const vidl_frame_sptr& frame)
+{
+#if VXL_FULLCXX11SUPPORT
+  if (!frame)
+    return VXL_NULLPTR;
+  // the buffers of released frames are reused, unless the frame is padded
+  // or otherwise not of the usual size for its format
+  vidl_frame_sptr copy;
+  if (frame->size() == vidl_pixel_format_buffer_size(frame->ni(), frame->nj(), frame->pixel_format()))
+    copy = vidl_frame_pool().new_frame(frame->ni(), frame->nj(), frame->pixel_format());
+  else
+    copy = new vidl_memory_chunk_frame(frame->ni(), frame->nj(), frame->pixel_format(),
+                                       new vil_memory_chunk(frame->size(), VIL_PIXEL_FORMAT_BYTE));
+  if (frame->size() > 0)
+    std::memcpy(copy->data(), frame->data(), frame->size());
+  return copy;
+#else
+  return frame;
+#endif
+}
+
+
+//: Constructor - read ahead up to \p buffer_size frames of \p stream
+vidl_prefetch_istream::
+vidl_prefetch_istream(const vidl_istream_sptr& stream, unsigned int buffer_size)
+  : stream_(stream),
+    buffer_size_(buffer_size > 0 ? buffer_size : 1),
+    end_of_stream_(false),
+    current_frame_(VXL_NULLPTR),
+    frame_number_(static_cast<unsigned int>(-1)),
+    is_valid_(false)
+#if VXL_FULLCXX11SUPPORT
+    , stop_(false)
+#endif
+{
+  update_metadata();
+  if (is_open_) {
+    frame_number_ = stream_->frame_number();
+    is_valid_ = stream_->is_valid();
+    if (is_valid_)
+      current_frame_ = vidl_prefetch_own(stream_->current_frame());
+  }
+  start();
+}
+
+
+//: Close the stream, and the wrapped stream
+void
+vidl_prefetch_istream::
+close()
+{
+  stop();
+  buffer_.clear();
+  end_of_stream_ = false;
+  current_frame_ = VXL_NULLPTR;
+  frame_number_ = static_cast<unsigned int>(-1);
+  is_valid_ = false;
+  if (stream_)
+    stream_->close();
+  update_metadata();
+}
+
+
+//: Advance to the next frame
+bool
+vidl_prefetch_istream::
+advance()
+{
+  if (!is_open_)
+    return false;
+
+  entry e;
+#if VXL_FULLCXX11SUPPORT
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (buffer_.empty() && !end_of_stream_)
+    changed_.wait(lock);
+  const bool found = !buffer_.empty();
+  if (found) {
+    e = buffer_.front();
+    buffer_.pop_front();
+    changed_.notify_all();
+  }
+#else
+  const bool found = fetch(e);
+  update_metadata();
+#endif
+
+  if (found) {
+    current_frame_ = e.frame;
+    frame_number_ = e.number;
+  }
+  else {
+    current_frame_ = VXL_NULLPTR;
+    if (is_valid_)
+      ++frame_number_;
+  }
+  is_valid_ = found;
+  return found;
+}
+
+
+//: Read the next frame from the stream
+vidl_frame_sptr
+vidl_prefetch_istream::read_frame()
+{
+  advance();
+  return current_frame();
+}
+
+
+//: Return the current frame in the stream
+vidl_frame_sptr
+vidl_prefetch_istream::current_frame()
+{
+  return is_valid() ? current_frame_ : vidl_frame_sptr(VXL_NULLPTR);
+}
+
+
+//: Seek to the given frame number
+// \returns true if successful
+bool
+vidl_prefetch_istream::
+seek_frame(unsigned int frame_nr)
+{
+  if (!is_open_ || !is_seekable_)
+    return false;
+
+  stop();
+  // The frames read ahead still follow on from the wrapped stream if it
+  // did not move, so keep them.
+  if (!stream_->seek_frame(frame_nr)) {
+    start();
+    return false;
+  }
+
+  buffer_.clear();
+  end_of_stream_ = false;
+  frame_number_ = stream_->frame_number();
+  vidl_frame_sptr frame = stream_->current_frame();
+  is_valid_ = frame && stream_->is_valid();
+  current_frame_ = is_valid_ ? vidl_prefetch_own(frame) : vidl_frame_sptr(VXL_NULLPTR);
+  update_metadata();
+  start();
+  return true;
+}
+
+
+//: Read the next frame of the wrapped stream into \p e
+bool
+vidl_prefetch_istream::
+fetch(entry& e)
+{
+  vidl_frame_sptr frame = stream_->read_frame();
+  if (!frame || !stream_->is_valid())
+    return false;
+  e.frame = vidl_prefetch_own(frame);
+  e.number = stream_->frame_number();
+  return true;
+}
+
+
+//: Take the metadata of the wrapped stream
+void
+vidl_prefetch_istream::
+update_metadata()
+{
+  is_open_ = stream_ && stream_->is_open();
+  if (!is_open_) {
+    is_seekable_ = false;
+    num_frames_ = -1;
+    ni_ = nj_ = 0;
+    format_ = VIDL_PIXEL_FORMAT_UNKNOWN;
+    frame_rate_ = duration_ = 0.0;
+    return;
+  }
+  is_seekable_ = stream_->is_seekable();
+  num_frames_ = stream_->num_frames();
+  ni_ = stream_->width();
+  nj_ = stream_->height();
+  format_ = stream_->format();
+  frame_rate_ = stream_->frame_rate();
+  duration_ = stream_->duration();
+}
+
+
+//: Start reading ahead
+void
+vidl_prefetch_istream::
+start()
+{
+#if VXL_FULLCXX11SUPPORT
+  if (!is_open_)
+    return;
+  stop_ = false;
+  thread_ = std::thread(&vidl_prefetch_istream::run, this);
+#endif
+}
+
+
+//: Stop reading ahead, and wait until the wrapped stream is not in use
+void
+vidl_prefetch_istream::
+stop()
+{
+#if VXL_FULLCXX11SUPPORT
+  if (!thread_.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  changed_.notify_all();
+  thread_.join();
+#endif
+}
+
+
+//: Read frames ahead until stopped
+void
+vidl_prefetch_istream::
+run()
+{
+#if VXL_FULLCXX11SUPPORT
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    while (!stop_ && (end_of_stream_ || buffer_.size() >= buffer_size_))
+      changed_.wait(lock);
+    if (stop_)
+      return;
+
+    lock.unlock();
+    entry e;
+    const bool found = fetch(e);
+    lock.lock();
+
+    // A frame read when asked to stop is kept all the same, as the wrapped
+    // stream has moved past it.  Frames change hands only under the lock.
+    if (found)
+      buffer_.push_back(e);
+    else
+      end_of_stream_ = true;
+    e.frame = VXL_NULLPTR;
+    changed_.notify_all();
+  }
+#endif
+}
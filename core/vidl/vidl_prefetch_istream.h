@@ -0,0 +1,167 @@
+// This is core/vidl/vidl_prefetch_istream.h
+#ifndef vidl_prefetch_istream_h_
+#define vidl_prefetch_istream_h_
+#ifdef VCL_NEEDS_PRAGMA_INTERFACE
+#pragma interface
+#endif
+//:
+// \file
+// \brief An input stream which reads frames from another stream ahead of time
+//
+// Decoding a video frame or loading an image from disk can take as long as
+// processing it.  vidl_prefetch_istream wraps any other input stream and
+// reads its frames on a background thread into a buffer of a fixed number
+// of frames, so that advance() and read_frame() usually only take the next
+// frame from the buffer while the following ones are being decoded.
+//
+// Each frame is copied as it is read, since many streams reuse the same
+// buffer for every frame.  The wrapped stream must not be used directly
+// while it is wrapped.  Seeking empties the buffer and continues reading
+// from the new position.
+//
+// Without C++11 threads the frames are read when they are asked for, as if
+// the stream were not wrapped.
+
+#include <deque>
+#include "vidl_istream.h"
+#include "vidl_istream_sptr.h"
+#include "vidl_frame_sptr.h"
+#include <vcl_compiler.h>
+#include <vxl_config.h>
+
+#if VXL_FULLCXX11SUPPORT
+# include <condition_variable>
+# include <mutex>
+# include <thread>
+#endif
+
+//: An input stream which reads frames from another stream ahead of time
+class vidl_prefetch_istream
+  : public vidl_istream
+{
+ public:
+  //: Constructor - read ahead up to \p buffer_size frames of \p stream
+  vidl_prefetch_istream(const vidl_istream_sptr& stream, unsigned int buffer_size = 8);
+
+  //: Destructor
+  // Stops reading ahead, but leaves the wrapped stream open
+  virtual ~vidl_prefetch_istream() { stop(); }
+
+  //: Return true if the stream is open for reading
+  virtual bool is_open() const { return is_open_; }
+
+  //: Return true if the stream is in a valid state
+  virtual bool is_valid() const { return is_open_ && is_valid_; }
+
+  //: Return true if the stream supports seeking
+  virtual bool is_seekable() const { return is_seekable_; }
+
+  //: Return the number of frames if known
+  //  returns -1 for non-seekable streams
+  virtual int num_frames() const { return num_frames_; }
+
+  //: Return the current frame number
+  virtual unsigned int frame_number() const { return frame_number_; }
+
+  //: Return the width of each frame
+  virtual unsigned int width() const { return ni_; }
+
+  //: Return the height of each frame
+  virtual unsigned int height() const { return nj_; }
+
+  //: Return the pixel format
+  virtual vidl_pixel_format format() const { return format_; }
+
+  //: Return the frame rate (FPS, 0.0 if unspecified)
+  virtual double frame_rate() const { return frame_rate_; }
+
+  //: Return the duration in seconds (0.0 if unknown)
+  virtual double duration() const { return duration_; }
+
+  //: Close the stream, and the wrapped stream
+  virtual void close();
+
+  //: Advance to the next frame
+  // The frame has usually been read already.
+  virtual bool advance();
+
+  //: Read the next frame from the stream
+  virtual vidl_frame_sptr read_frame();
+
+  //: Return the current frame in the stream
+  virtual vidl_frame_sptr current_frame();
+
+  //: Seek to the given frame number
+  // Frames read ahead are discarded, and the frame sought is read at once.
+  // \returns true if successful
+  virtual bool seek_frame(unsigned int frame_number);
+
+  //: The maximum number of frames read ahead
+  unsigned int buffer_size() const { return buffer_size_; }
+
+ private:
+  //: A frame read ahead, and its number in the wrapped stream
+  struct entry
+  {
+    vidl_frame_sptr frame;
+    unsigned int number;
+  };
+
+  //: Read the next frame of the wrapped stream into \p e
+  // \returns false at the end of the wrapped stream
+  bool fetch(entry& e);
+
+  //: Take the metadata of the wrapped stream
+  void update_metadata();
+
+  //: Start reading ahead
+  void start();
+
+  //: Stop reading ahead, and wait until the wrapped stream is not in use
+  void stop();
+
+  //: Read frames ahead until stopped
+  void run();
+
+  //: The wrapped stream
+  vidl_istream_sptr stream_;
+
+  //: The maximum number of frames read ahead
+  unsigned int buffer_size_;
+
+  //: Frames read ahead
+  std::deque<entry> buffer_;
+
+  //: True once the wrapped stream has no more frames
+  bool end_of_stream_;
+
+  //: The current frame
+  vidl_frame_sptr current_frame_;
+  //: The current frame number
+  unsigned int frame_number_;
+  //: True if the current frame is valid
+  bool is_valid_;
+
+  // Metadata of the wrapped stream, which may not be asked while frames are read
+  bool is_open_;
+  bool is_seekable_;
+  int num_frames_;
+  unsigned int ni_;
+  unsigned int nj_;
+  vidl_pixel_format format_;
+  double frame_rate_;
+  double duration_;
+
+#if VXL_FULLCXX11SUPPORT
+  //: The thread reading ahead
+  std::thread thread_;
+  //: Guards buffer_, end_of_stream_ and stop_
+  std::mutex mutex_;
+  //: Signalled when a frame is added to or taken from buffer_, or on stop
+  std::condition_variable changed_;
+  //: True when the thread should stop reading
+  bool stop_;
+#endif
+};
+
+#endif // vidl_prefetch_istream_h_
@@ -7,6 +7,7 @@
 #include <vil/vil_new.h>
 #include <vil/vil_crop.h>
 #include <vil/algo/vil_convolve_1d.h>
+#include <vnl/vnl_cpu_features.h>
 
 
 inline void print_vector(const std::vector<double> & v)
@@ -306,9 +307,69 @@ static void test_algo_convolve_1d_double()
                                     vil_image_view<vxl_byte>(conv->get_view(n-4,4,n-4,4))), true);
 }
 
+//: Compare the vectorised inner loop at every instruction set level with the plain loop.
+template <class srcT, class kernelT, class accumT>
+static void test_algo_convolve_1d_simd(const char* name, double src_max)
+{
+  const unsigned widths[] = { 7, 8, 9, 12, 15, 16, 17, 23, 24, 31, 40, 257 };
+  const std::ptrdiff_t k_ranges[][2] = { {0,0}, {-1,1}, {-2,4}, {-6,5} };
+  const vnl_cpu_features::level best = vnl_cpu_features::best();
+  unsigned seed = 17;
+  bool ok = true;
+  for (unsigned w = 0; w < sizeof(widths)/sizeof(widths[0]); ++w)
+  {
+    vil_image_view<srcT> src(widths[w], 3);
+    for (unsigned j = 0; j < src.nj(); ++j)
+      for (unsigned i = 0; i < src.ni(); ++i)
+      {
+        seed = seed * 1664525u + 1013904223u;
+        src(i,j) = srcT(src_max * ((seed >> 8) / double(1u << 24)) - (src_max < 1000 ? src_max/2 : 0));
+      }
+    for (unsigned r = 0; r < sizeof(k_ranges)/sizeof(k_ranges[0]); ++r)
+    {
+      const std::ptrdiff_t k_lo = k_ranges[r][0], k_hi = k_ranges[r][1];
+      if (k_hi - k_lo >= std::ptrdiff_t(widths[w])) continue;
+      std::vector<kernelT> kernel(k_hi - k_lo + 1);
+      for (unsigned k = 0; k < kernel.size(); ++k)
+        kernel[k] = kernelT(0.1 + 0.37*k - 0.05*k*k);
+      for (int b = vil_convolve_ignore_edge; b <= vil_convolve_trim; ++b)
+      {
+        const vil_convolve_boundary_option option = vil_convolve_boundary_option(b);
+        vnl_cpu_features::set_max_level(vnl_cpu_features::scalar);
+        vil_image_view<float> ref(widths[w], 3);
+        ref.fill(-1.0f);
+        vil_convolve_1d(src, ref, &kernel[-k_lo], k_lo, k_hi, accumT(), option, option);
+        for (int l = vnl_cpu_features::sse2; l <= best; ++l)
+        {
+          vnl_cpu_features::set_max_level(vnl_cpu_features::level(l));
+          vil_image_view<float> dest(widths[w], 3);
+          dest.fill(-1.0f);
+          vil_convolve_1d(src, dest, &kernel[-k_lo], k_lo, k_hi, accumT(), option, option);
+          ok = ok && vil_image_view_deep_equality(ref, dest);
+        }
+      }
+    }
+  }
+  vnl_cpu_features::set_max_level(best);
+  TEST(name, ok, true);
+}
+
 static void test_algo_convolve_1d()
 {
   test_algo_convolve_1d_double();
+
+  std::cout << "Vectorised vil_convolve_1d, up to " << vnl_cpu_features::name(vnl_cpu_features::best()) << '\n';
+  test_algo_convolve_1d_simd<vxl_byte, float, float>("byte, float kernel, float sum", 255.0);
+  test_algo_convolve_1d_simd<vxl_byte, double, float>("byte, double kernel, float sum", 255.0);
+  test_algo_convolve_1d_simd<vxl_byte, double, double>("byte, double kernel, double sum", 255.0);
+  test_algo_convolve_1d_simd<vxl_byte, float, double>("byte, float kernel, double sum", 255.0);
+  test_algo_convolve_1d_simd<vxl_uint_16, float, float>("uint16, float kernel, float sum", 65535.0);
+  test_algo_convolve_1d_simd<vxl_uint_16, double, float>("uint16, double kernel, float sum", 65535.0);
+  test_algo_convolve_1d_simd<vxl_uint_16, double, double>("uint16, double kernel, double sum", 65535.0);
+  test_algo_convolve_1d_simd<float, float, float>("float, float kernel, float sum", 100.0);
+  test_algo_convolve_1d_simd<float, double, float>("float, double kernel, float sum", 100.0);
+  test_algo_convolve_1d_simd<float, double, double>("float, double kernel, double sum", 100.0);
+  test_algo_convolve_1d_simd<float, float, double>("float, float kernel, double sum", 100.0);
 }
 
 TESTMAIN(test_algo_convolve_1d);
@@ -1,9 +1,16 @@
 // This is core/vil/algo/tests/test_algo_correlate_2d.cxx
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <testlib/testlib_test.h>
 #include <vcl_compiler.h>
 #include <vxl_config.h> // for vxl_byte
 #include <vil/algo/vil_correlate_2d.h>
+#include <vil/algo/vil_convolve_2d.h>
+#include <vil/algo/vil_normalised_correlation_2d.h>
+#include <vnl/vnl_math.h>
+#include <vnl/vnl_random.h>
 
 static void test_algo_correlate_2d_byte()
 {
@@ -67,9 +74,97 @@ static void test_algo_correlate_2d_byte()
   TEST_NEAR("dest_im(0,1)", dest_im(0,1), 0.5*m*(m+1)*6 +14*m*n, 1e-6);
 }
 
+//: largest difference between dest and the direct sums, relative to the largest of those
+template <class destT, class kernelT>
+static double direct_difference(const vil_image_view<float>& src_im,
+                                const vil_image_view<destT>& dest_im,
+                                const vil_image_view<kernelT>& kernel,
+                                bool normalised)
+{
+  double max_diff = 0, max_val = 0;
+  for (unsigned j=0;j<dest_im.nj();++j)
+    for (unsigned i=0;i<dest_im.ni();++i)
+    {
+      const float* sp = &src_im(i,j);
+      double v = normalised ?
+        vil_norm_corr_2d_at_pt(sp,src_im.istep(),src_im.jstep(),src_im.planestep(),kernel,double()) :
+        vil_correlate_2d_at_pt(sp,src_im.istep(),src_im.jstep(),src_im.planestep(),kernel,double());
+      max_diff = std::max(max_diff, std::fabs(v-dest_im(i,j)));
+      max_val = std::max(max_val, std::fabs(v));
+    }
+  return max_diff/max_val;
+}
+
+static void test_algo_correlate_2d_fft()
+{
+  std::cout << "*********************************\n"
+           << " Testing vil_correlate_2d by FFT\n"
+           << "*********************************\n";
+
+  vnl_random rng(1234);
+  vil_image_view<float> src_im(157,131,2);
+  for (unsigned p=0;p<src_im.nplanes();++p)
+    for (unsigned j=0;j<src_im.nj();++j)
+      for (unsigned i=0;i<src_im.ni();++i)
+        src_im(i,j,p) = float(rng.drand32(0,255));
+
+  // a kernel of zero mean and unit variance
+  vil_image_view<double> kernel(31,23,2);
+  for (unsigned p=0;p<kernel.nplanes();++p)
+    for (unsigned j=0;j<kernel.nj();++j)
+      for (unsigned i=0;i<kernel.ni();++i)
+        kernel(i,j,p) = rng.normal();
+
+  TEST("FFT is faster for a 31x23 kernel",
+       vil_correlate_2d_fft_is_faster(src_im.ni(),src_im.nj(),kernel.ni(),kernel.nj(),2), true);
+  TEST("FFT is not faster for a 3x3 kernel",
+       vil_correlate_2d_fft_is_faster(src_im.ni(),src_im.nj(),3,3,1), false);
+
+  vil_image_view<double> dest_d;
+  vil_correlate_2d_fft<double>(src_im,dest_d,kernel);
+  TEST("Destination size", dest_d.ni()==1+src_im.ni()-kernel.ni() && dest_d.nj()==1+src_im.nj()-kernel.nj(), true);
+  TEST_NEAR("FFT in double precision", direct_difference(src_im,dest_d,kernel,false), 0.0, 1e-12);
+
+  vil_image_view<float> dest_f;
+  vil_correlate_2d(src_im,dest_f,kernel,float());
+  TEST_NEAR("vil_correlate_2d with float accumulator", direct_difference(src_im,dest_f,kernel,false), 0.0, 1e-5);
+
+  // a NaN only spoils the outputs whose sums include it
+  vil_image_view<float> nan_im;
+  nan_im.deep_copy(src_im);
+  nan_im(40,30,1) = std::numeric_limits<float>::quiet_NaN();
+  vil_correlate_2d(nan_im,dest_f,kernel,double());
+  TEST("NaN spoils the outputs including it", vnl_math::isnan(dest_f(20,20)), true);
+  TEST("NaN leaves the other outputs", vnl_math::isfinite(dest_f(0,0)), true);
+
+  vil_image_view<double> dest_c;
+  vil_convolve_2d(src_im,dest_c,kernel,double());
+  vil_image_view<double> flipped = vil_flip_ud(vil_flip_lr(kernel));
+  TEST_NEAR("vil_convolve_2d with double accumulator", direct_difference(src_im,dest_c,flipped,false), 0.0, 1e-12);
+
+  // a kernel wider than the largest tile, and a single plane
+  vil_image_view<float> wide(101,5,1);
+  for (unsigned j=0;j<wide.nj();++j)
+    for (unsigned i=0;i<wide.ni();++i)
+      wide(i,j) = float(rng.normal());
+  vil_correlate_2d_fft<double>(src_im,dest_d,wide);
+  TEST_NEAR("FFT with a 101x5 kernel", direct_difference(src_im,dest_d,wide,false), 0.0, 1e-12);
+
+  vil_image_view<float> norm;
+  vil_normalised_correlation_2d(src_im,norm,kernel,double());
+  TEST_NEAR("vil_normalised_correlation_2d", direct_difference(src_im,norm,kernel,true), 0.0, 1e-5);
+
+  // constant regions have no variance, so give 0
+  vil_image_view<float> flat(40,40,2);
+  flat.fill(7.0f);
+  vil_normalised_correlation_2d(flat,norm,kernel,double());
+  TEST_NEAR("vil_normalised_correlation_2d of a constant image", norm(3,4), 0.0, 1e-12);
+}
+
 static void test_algo_correlate_2d()
 {
   test_algo_correlate_2d_byte();
+  test_algo_correlate_2d_fft();
 }
 
 TESTMAIN(test_algo_correlate_2d);
@@ -1,12 +1,118 @@
 // This is core/vil/algo/tests/test_algo_fft.cxx
 #include <complex>
 #include <ctime>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
 #include <testlib/testlib_test.h>
+#include <vil/vil_flip.h>
 #include <vil/vil_math.h>
 #include <vil/vil_image_view.h>
+#include <vil/vil_parallel.h>
 #include <vil/algo/vil_fft.h>
 #include <vcl_compiler.h>
 
+//: largest difference between two images
+template <class T>
+static double max_diff(vil_image_view<T> const& a, vil_image_view<T> const& b)
+{
+  double d = 0;
+  for (unsigned p=0; p<a.nplanes(); ++p)
+    for (unsigned j=0; j<a.nj(); ++j)
+      for (unsigned i=0; i<a.ni(); ++i)
+        if (std::abs(a(i,j,p) - b(i,j,p)) > d)
+          d = std::abs(a(i,j,p) - b(i,j,p));
+  return d;
+}
+
+//: transforms of a real image of a size which is not of the form 2^p 3^q 5^r
+static void test_algo_fft_real(unsigned ni, unsigned nj)
+{
+  std::cout << "real image " << ni << 'x' << nj << '\n';
+  vil_image_view<double> img(ni, nj, 2);
+  vil_image_view<std::complex<double> > cimg(ni, nj, 2);
+  unsigned int seed = 12345;
+  for (unsigned p=0; p<img.nplanes(); ++p)
+    for (unsigned j=0; j<img.nj(); ++j)
+      for (unsigned i=0; i<img.ni(); ++i, seed = seed*16807+1)
+        cimg(i,j,p) = img(i,j,p) = (seed % 1000) * 1e-3 - 0.5;
+
+  vil_image_view<std::complex<double> > coeffs;
+  vil_fft_2d_fwd(img, coeffs);
+  TEST("size of coefficients", coeffs.ni() == ni/2+1 && coeffs.nj() == nj && coeffs.nplanes() == 2, true);
+
+  vil_fft_2d_fwd(cimg);
+  double d = 0;
+  for (unsigned p=0; p<coeffs.nplanes(); ++p)
+    for (unsigned j=0; j<coeffs.nj(); ++j)
+      for (unsigned i=0; i<coeffs.ni(); ++i)
+        if (std::abs(coeffs(i,j,p) - cimg(i,j,p)) > d)
+          d = std::abs(coeffs(i,j,p) - cimg(i,j,p));
+  TEST_NEAR("real FFT gives coefficients of complex FFT", d, 0.0, 1e-12);
+
+  vil_image_view<double> back;
+  vil_fft_2d_bwd(coeffs, ni, back);
+  TEST_NEAR("real inverse FFT recovers image", max_diff(back, img), 0.0, 1e-12);
+
+  vil_fft_2d_bwd(cimg);
+  double im = 0;
+  for (unsigned p=0; p<cimg.nplanes(); ++p)
+    for (unsigned j=0; j<cimg.nj(); ++j)
+      for (unsigned i=0; i<cimg.ni(); ++i)
+        im = std::max(im, std::abs(cimg(i,j,p) - img(i,j,p)));
+  TEST_NEAR("complex FFT of odd size recovers image", im, 0.0, 1e-12);
+}
+
+//: the result must not depend on the number of threads
+static void test_algo_fft_threads()
+{
+  vil_image_view<std::complex<float> > img(150, 130, 1);
+  for (unsigned j=0; j<img.nj(); ++j)
+    for (unsigned i=0; i<img.ni(); ++i)
+      img(i,j) = std::complex<float>(float((i*7+j*3)%11), float((i+j*5)%13));
+  vil_image_view<std::complex<float> > serial, parallel;
+  serial.deep_copy(img);
+  parallel.deep_copy(img);
+
+  vil_parallel_set_max_threads(1);
+  vil_fft_2d_fwd(serial);
+  vil_parallel_set_max_threads(4);
+  vil_fft_2d_fwd(parallel);
+  TEST_NEAR("forward FFT with 4 threads", max_diff(serial, parallel), 0.0, 1e-6);
+  vil_fft_2d_bwd(parallel);
+  TEST_NEAR("forward and backward FFT with 4 threads", max_diff(parallel, img), 0.0, 1e-3);
+  vil_parallel_set_max_threads(0);
+}
+
+//: transforms of views with negative steps
+static void test_algo_fft_flipped(unsigned ni, unsigned nj)
+{
+  std::cout << "flipped views of " << ni << 'x' << nj << '\n';
+  vil_image_view<std::complex<double> > img(ni, nj, 2);
+  unsigned int seed = 54321;
+  for (unsigned p=0; p<img.nplanes(); ++p)
+    for (unsigned j=0; j<img.nj(); ++j)
+      for (unsigned i=0; i<img.ni(); ++i, seed = seed*16807+1)
+        img(i,j,p) = std::complex<double>((seed % 1000) * 1e-3, (seed % 997) * 1e-3);
+
+  vil_image_view<std::complex<double> > views[2];
+  views[0].deep_copy(img);
+  views[0] = vil_flip_lr(views[0]);
+  views[1].deep_copy(img);
+  views[1] = vil_flip_ud(vil_flip_lr(views[1]));
+  for (unsigned v=0; v<2; ++v)
+  {
+    vil_image_view<std::complex<double> > copy;
+    copy.deep_copy(views[v]);
+    vil_fft_2d_fwd(views[v]);
+    vil_fft_2d_fwd(copy);
+    TEST_NEAR("FFT of a flipped view", max_diff(views[v], copy), 0.0, 1e-12);
+    vil_fft_2d_bwd(views[v]);
+    vil_fft_2d_bwd(copy);
+    TEST_NEAR("inverse FFT of a flipped view", max_diff(views[v], copy), 0.0, 1e-12);
+  }
+}
+
 static void test_algo_fft()
 {
   vil_image_view<std::complex<double> > img0(4, 8, 2);
@@ -45,6 +151,12 @@ static void test_algo_fft()
     if (i==0 && j==0) i=1;
     TEST_NEAR("any other FFT coeff. is 0", img0(i,j,p), 0.0, 1e-9);
   }
+
+  test_algo_fft_real(12, 9);
+  test_algo_fft_real(13, 11);
+  test_algo_fft_threads();
+  test_algo_fft_flipped(8, 6);
+  test_algo_fft_flipped(7, 6);
 }
 
 TESTMAIN(test_algo_fft);
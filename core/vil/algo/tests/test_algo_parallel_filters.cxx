@@ -0,0 +1,161 @@
+// This is core/vil/algo/tests/test_algo_parallel_filters.cxx
+#include <iostream>
+#include <vcl_compiler.h>
+#include <vxl_config.h> // for vxl_byte
+#include <testlib/testlib_test.h>
+#include <vil/vil_image_view.h>
+#include <vil/vil_transpose.h>
+#include <vil/algo/vil_parallel_filters.h>
+//:
+// \file
+// \brief Check that the parallel filters give exactly the same output as the serial ones.
+
+static void fill_random(vil_image_view<vxl_byte>& im, unsigned& seed)
+{
+  for (unsigned p = 0; p < im.nplanes(); ++p)
+    for (unsigned j = 0; j < im.nj(); ++j)
+      for (unsigned i = 0; i < im.ni(); ++i)
+      {
+        seed = seed * 1664525u + 1013904223u;
+        im(i,j,p) = vxl_byte(seed >> 24);
+      }
+}
+
+//: Image sizes, including ones too small to split and ones with a prime number of rows.
+static const unsigned test_sizes[][2] = { {1,1}, {3,40}, {7,5}, {40,3}, {20,17}, {64,97}, {131,256} };
+static const unsigned n_test_sizes = sizeof(test_sizes)/sizeof(test_sizes[0]);
+
+//: Thread counts and minimum band heights, from one row per band to the defaults.
+static vil_parallel_policy test_policy(unsigned k)
+{
+  const unsigned threads[] = { 2, 3, 7, 0 };
+  const unsigned rows[] = { 1, 2, 5, 32 };
+  return vil_parallel_policy(threads[k], rows[k]);
+}
+static const unsigned n_test_policies = 4;
+
+static void test_gauss_5tap()
+{
+  unsigned seed = 1;
+  vil_gauss_filter_5tap_params params(1.0);
+  bool ok_byte = true, ok_float = true, ok_view = true;
+  for (unsigned s = 0; s < n_test_sizes; ++s)
+  {
+    const unsigned ni = test_sizes[s][0], nj = test_sizes[s][1];
+    // The serial code only handles several planes when ni>4 and nj>4.
+    vil_image_view<vxl_byte> src(ni, nj, ni > 4 && nj > 4 ? 2 : 1);
+    fill_random(src, seed);
+    vil_image_view<vxl_byte> b0, b1;
+    vil_image_view<float> f0, f1, t0, t1;
+    vil_gauss_filter_5tap(src, b0, params);
+    vil_gauss_filter_5tap(src, f0, params);
+    vil_gauss_filter_5tap(vil_transpose(src), t0, params);
+    for (unsigned k = 0; k < n_test_policies; ++k)
+    {
+      vil_gauss_filter_5tap(src, b1, params, test_policy(k));
+      vil_gauss_filter_5tap(src, f1, params, test_policy(k));
+      vil_gauss_filter_5tap(vil_transpose(src), t1, params, test_policy(k));
+      ok_byte = ok_byte && vil_image_view_deep_equality(b0, b1);
+      ok_float = ok_float && vil_image_view_deep_equality(f0, f1);
+      ok_view = ok_view && vil_image_view_deep_equality(t0, t1);
+    }
+  }
+  TEST("vil_gauss_filter_5tap byte->byte", ok_byte, true);
+  TEST("vil_gauss_filter_5tap byte->float", ok_float, true);
+  TEST("vil_gauss_filter_5tap of a transposed view", ok_view, true);
+}
+
+static void test_convolve_1d()
+{
+  unsigned seed = 2;
+  const double kernel[] = { 0.1, 0.2, 0.4, 0.2, 0.1 };
+  bool ok = true;
+  for (unsigned s = 0; s < n_test_sizes; ++s)
+  {
+    if (test_sizes[s][0] < 5) continue; // the kernel must fit in a row
+    vil_image_view<vxl_byte> src(test_sizes[s][0], test_sizes[s][1], 3);
+    fill_random(src, seed);
+    for (int b = vil_convolve_no_extend; b <= vil_convolve_trim; ++b)
+    {
+      const vil_convolve_boundary_option option = vil_convolve_boundary_option(b);
+      vil_image_view<float> d0, d1;
+      vil_convolve_1d(src, d0, kernel+2, -2, 2, double(), option, option);
+      for (unsigned k = 0; k < n_test_policies; ++k)
+      {
+        vil_convolve_1d(src, d1, kernel+2, -2, 2, double(), option, option, test_policy(k));
+        ok = ok && vil_image_view_deep_equality(d0, d1);
+      }
+    }
+  }
+  TEST("vil_convolve_1d with every boundary option", ok, true);
+}
+
+static void test_sobel_3x3()
+{
+  unsigned seed = 3;
+  bool ok_separate = true, ok_planes = true;
+  for (unsigned s = 0; s < n_test_sizes; ++s)
+  {
+    vil_image_view<vxl_byte> src(test_sizes[s][0], test_sizes[s][1], 2);
+    fill_random(src, seed);
+    vil_image_view<float> gi0, gj0, gi1, gj1, gij0, gij1;
+    vil_sobel_3x3(src, gi0, gj0);
+    vil_sobel_3x3(src, gij0);
+    for (unsigned k = 0; k < n_test_policies; ++k)
+    {
+      vil_sobel_3x3(src, gi1, gj1, test_policy(k));
+      vil_sobel_3x3(src, gij1, test_policy(k));
+      ok_separate = ok_separate && vil_image_view_deep_equality(gi0, gi1)
+                                && vil_image_view_deep_equality(gj0, gj1);
+      ok_planes = ok_planes && vil_image_view_deep_equality(gij0, gij1);
+    }
+  }
+  TEST("vil_sobel_3x3 into grad_i and grad_j", ok_separate, true);
+  TEST("vil_sobel_3x3 into grad_ij", ok_planes, true);
+}
+
+static void test_morphology()
+{
+  unsigned seed = 4;
+  vil_structuring_element elements[3];
+  elements[0].set_to_disk(2.5);
+  elements[1].set_to_line_j(-4, 1);
+  elements[2].set_to_line_i(-1, 1);
+  bool ok_dilate = true, ok_erode = true, ok_median = true;
+  for (unsigned s = 0; s < n_test_sizes; ++s)
+  {
+    // The serial code needs the image to be at least as large as the element.
+    if (test_sizes[s][0] < 5 || test_sizes[s][1] < 5) continue;
+    vil_image_view<vxl_byte> src(test_sizes[s][0], test_sizes[s][1]);
+    fill_random(src, seed);
+    for (unsigned e = 0; e < 3; ++e)
+    {
+      vil_image_view<vxl_byte> d0, d1, e0, e1, m0, m1;
+      vil_greyscale_dilate(src, d0, elements[e]);
+      vil_greyscale_erode(src, e0, elements[e]);
+      vil_median(src, m0, elements[e]);
+      for (unsigned k = 0; k < n_test_policies; ++k)
+      {
+        vil_greyscale_dilate(src, d1, elements[e], test_policy(k));
+        vil_greyscale_erode(src, e1, elements[e], test_policy(k));
+        vil_median(src, m1, elements[e], test_policy(k));
+        ok_dilate = ok_dilate && vil_image_view_deep_equality(d0, d1);
+        ok_erode = ok_erode && vil_image_view_deep_equality(e0, e1);
+        ok_median = ok_median && vil_image_view_deep_equality(m0, m1);
+      }
+    }
+  }
+  TEST("vil_greyscale_dilate", ok_dilate, true);
+  TEST("vil_greyscale_erode", ok_erode, true);
+  TEST("vil_median", ok_median, true);
+}
+
+static void test_algo_parallel_filters()
+{
+  test_gauss_5tap();
+  test_convolve_1d();
+  test_sobel_3x3();
+  test_morphology();
+}
+
+TESTMAIN(test_algo_parallel_filters);
@@ -8,6 +8,7 @@
 #include <vil/algo/vil_checker_board.h>
 #include <vil/algo/vil_colour_space.h>
 #include <vil/algo/vil_convolve_1d.h>
+#include <vil/algo/vil_convolve_1d_simd.h>
 #include <vil/algo/vil_convolve_2d.h>
 #include <vil/algo/vil_corners.h>
 #include <vil/algo/vil_correlate_1d.h>
@@ -35,7 +36,9 @@
 #include <vil/algo/vil_line_filter.h>
 #include <vil/algo/vil_median.h>
 #include <vil/algo/vil_normalised_correlation_2d.h>
+#include <vil/algo/vil_correlate_2d_fft.h>
 #include <vil/algo/vil_orientations.h>
+#include <vil/algo/vil_parallel_filters.h>
 #include <vil/algo/vil_quad_distance_function.h>
 #include <vil/algo/vil_region_finder.h>
 #include <vil/algo/vil_sobel_1x3.h>
@@ -23,6 +23,7 @@
 #include <vil/vil_image_view.h>
 #include <vil/vil_image_resource.h>
 #include <vil/vil_property.h>
+#include <vil/algo/vil_convolve_1d_simd.h>
 
 
 //: Available options for boundary behavior
@@ -217,6 +218,9 @@ inline void vil_convolve_1d(const srcT* src0, unsigned nx, std::ptrdiff_t s_step
   assert(k_rbegin >= k_rend);
   const srcT* src = src0;
 
+  // Use SSE/AVX for the common pixel types, when the rows are contiguous
+  if (s_step!=1 || d_step!=1 ||
+      !vil_convolve_1d_simd(src0, unsigned(int(nx)+k_lo-k_hi), dest0+k_hi, kernel, k_lo, k_hi, ac))
   for (destT       * dest = dest0 + d_step*k_hi,
        * const   end_dest = dest0 + d_step*(int(nx)+k_lo);
        dest!=end_dest;
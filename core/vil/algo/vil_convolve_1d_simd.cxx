@@ -0,0 +1,150 @@
+// This is core/vil/algo/vil_convolve_1d_simd.cxx
+//:
+// \file
+// \brief Register wrappers and run-time selection for vil_convolve_1d_simd
+//
+// The kernel is written once, in vil_convolve_1d_simd_kernels.h, and
+// included once per instruction set, each time inside its own namespace
+// and with its own target attribute, as is done for vnl_sse_dispatch.
+
+#include <cstring>
+#include "vil_convolve_1d_simd.h"
+#include <vcl_compiler.h>
+#include <vnl/vnl_config.h>
+#include <vnl/vnl_cpu_features.h>
+
+#if VNL_CPU_X86 && VNL_CONFIG_ENABLE_SIMD_DISPATCH
+# define VIL_CONVOLVE_1D_SIMD 1
+# include <immintrin.h>
+#else
+# define VIL_CONVOLVE_1D_SIMD 0
+#endif
+
+#if VIL_CONVOLVE_1D_SIMD
+
+// Not VNL_CPU_TARGET_AVX2, which also enables FMA.
+#if defined(__GNUC__) || defined(__clang__)
+# define VIL_CONVOLVE_1D_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+# define VIL_CONVOLVE_1D_TARGET_AVX2
+#endif
+
+//----------------------------------------------------------------------
+// SSE2: 4 floats, or 2 x 2 doubles, per step.
+
+namespace vil_convolve_1d_simd_sse2
+{
+#define VIL_SIMD_TARGET VNL_CPU_TARGET_SSE2
+
+struct simd
+{
+  typedef __m128 F; typedef __m128d D; enum { W = 4 };
+  VIL_SIMD_TARGET static inline F zero_f() { return _mm_setzero_ps(); }
+  VIL_SIMD_TARGET static inline F set1_f(float a) { return _mm_set1_ps(a); }
+  VIL_SIMD_TARGET static inline F add_f(F a, F b) { return _mm_add_ps(a, b); }
+  VIL_SIMD_TARGET static inline F mul_f(F a, F b) { return _mm_mul_ps(a, b); }
+  VIL_SIMD_TARGET static inline void store_f(float* p, F a) { _mm_storeu_ps(p, a); }
+  VIL_SIMD_TARGET static inline D zero_d() { return _mm_setzero_pd(); }
+  VIL_SIMD_TARGET static inline D set1_d(double a) { return _mm_set1_pd(a); }
+  VIL_SIMD_TARGET static inline D add_d(D a, D b) { return _mm_add_pd(a, b); }
+  VIL_SIMD_TARGET static inline D mul_d(D a, D b) { return _mm_mul_pd(a, b); }
+  VIL_SIMD_TARGET static inline D lo_d(F a) { return _mm_cvtps_pd(a); }
+  VIL_SIMD_TARGET static inline D hi_d(F a) { return _mm_cvtps_pd(_mm_movehl_ps(a, a)); }
+  VIL_SIMD_TARGET static inline F to_f(D lo, D hi) { return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)); }
+  VIL_SIMD_TARGET static inline F load(const float* p) { return _mm_loadu_ps(p); }
+  VIL_SIMD_TARGET static inline F load(const vxl_byte* p)
+  {
+    int v; std::memcpy(&v, p, 4);
+    const __m128i z = _mm_setzero_si128();
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), z), z));
+  }
+  VIL_SIMD_TARGET static inline F load(const vxl_uint_16* p)
+  {
+    const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, _mm_setzero_si128()));
+  }
+};
+
+#include "vil_convolve_1d_simd_kernels.h"
+#undef VIL_SIMD_TARGET
+}
+
+//----------------------------------------------------------------------
+// AVX2: 8 floats, or 2 x 4 doubles, per step.
+
+namespace vil_convolve_1d_simd_avx2
+{
+#define VIL_SIMD_TARGET VIL_CONVOLVE_1D_TARGET_AVX2
+
+struct simd
+{
+  typedef __m256 F; typedef __m256d D; enum { W = 8 };
+  VIL_SIMD_TARGET static inline F zero_f() { return _mm256_setzero_ps(); }
+  VIL_SIMD_TARGET static inline F set1_f(float a) { return _mm256_set1_ps(a); }
+  VIL_SIMD_TARGET static inline F add_f(F a, F b) { return _mm256_add_ps(a, b); }
+  VIL_SIMD_TARGET static inline F mul_f(F a, F b) { return _mm256_mul_ps(a, b); }
+  VIL_SIMD_TARGET static inline void store_f(float* p, F a) { _mm256_storeu_ps(p, a); }
+  VIL_SIMD_TARGET static inline D zero_d() { return _mm256_setzero_pd(); }
+  VIL_SIMD_TARGET static inline D set1_d(double a) { return _mm256_set1_pd(a); }
+  VIL_SIMD_TARGET static inline D add_d(D a, D b) { return _mm256_add_pd(a, b); }
+  VIL_SIMD_TARGET static inline D mul_d(D a, D b) { return _mm256_mul_pd(a, b); }
+  VIL_SIMD_TARGET static inline D lo_d(F a) { return _mm256_cvtps_pd(_mm256_castps256_ps128(a)); }
+  VIL_SIMD_TARGET static inline D hi_d(F a) { return _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)); }
+  VIL_SIMD_TARGET static inline F to_f(D lo, D hi)
+  { return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1); }
+  VIL_SIMD_TARGET static inline F load(const float* p) { return _mm256_loadu_ps(p); }
+  VIL_SIMD_TARGET static inline F load(const vxl_byte* p)
+  { return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)))); }
+  VIL_SIMD_TARGET static inline F load(const vxl_uint_16* p)
+  { return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)))); }
+};
+
+#include "vil_convolve_1d_simd_kernels.h"
+#undef VIL_SIMD_TARGET
+}
+
+#endif // VIL_CONVOLVE_1D_SIMD
+
+//: Run the widest kernel which the processor supports and which fits in n.
+template <class srcT, class kernelT, class accumT>
+static bool vil_convolve_1d_simd_run(const srcT* src, unsigned n, float* dest,
+                                     const kernelT* kernel, std::ptrdiff_t k_lo, std::ptrdiff_t k_hi)
+{
+#if VIL_CONVOLVE_1D_SIMD
+  const unsigned m = unsigned(k_hi - k_lo + 1);
+  const vnl_cpu_features::level level = vnl_cpu_features::best();
+  if (level >= vnl_cpu_features::avx2 && n >= 8)
+  {
+    vil_convolve_1d_simd_avx2::convolve<srcT, kernelT, accumT>(src, n, dest, kernel + k_hi, m);
+    return true;
+  }
+  if (level >= vnl_cpu_features::sse2 && n >= 4)
+  {
+    vil_convolve_1d_simd_sse2::convolve<srcT, kernelT, accumT>(src, n, dest, kernel + k_hi, m);
+    return true;
+  }
+#else
+  (void)src; (void)n; (void)dest; (void)kernel; (void)k_lo; (void)k_hi;
+#endif
+  return false;
+}
+
+#define VIL_CONVOLVE_1D_SIMD_DEFINE(srcT, kernelT, accumT) \
+bool vil_convolve_1d_simd(const srcT* src, unsigned n, float* dest, \
+                          const kernelT* kernel, std::ptrdiff_t k_lo, std::ptrdiff_t k_hi, accumT) \
+{ \
+  return vil_convolve_1d_simd_run<srcT, kernelT, accumT >(src, n, dest, kernel, k_lo, k_hi); \
+}
+
+VIL_CONVOLVE_1D_SIMD_DEFINE(vxl_byte, float, float)
+VIL_CONVOLVE_1D_SIMD_DEFINE(vxl_byte, float, double)
+VIL_CONVOLVE_1D_SIMD_DEFINE(vxl_byte, double, float)
+VIL_CONVOLVE_1D_SIMD_DEFINE(vxl_byte, double, double)
+VIL_CONVOLVE_1D_SIMD_DEFINE(vxl_uint_16, float, float)
+VIL_CONVOLVE_1D_SIMD_DEFINE(vxl_uint_16, float, double)
+VIL_CONVOLVE_1D_SIMD_DEFINE(vxl_uint_16, double, float)
+VIL_CONVOLVE_1D_SIMD_DEFINE(vxl_uint_16, double, double)
+VIL_CONVOLVE_1D_SIMD_DEFINE(float, float, float)
+VIL_CONVOLVE_1D_SIMD_DEFINE(float, float, double)
+VIL_CONVOLVE_1D_SIMD_DEFINE(float, double, float)
+VIL_CONVOLVE_1D_SIMD_DEFINE(float, double, double)
@@ -0,0 +1,58 @@
+// This is core/vil/algo/vil_convolve_1d_simd.h
+#ifndef vil_convolve_1d_simd_h_
+#define vil_convolve_1d_simd_h_
+//:
+// \file
+// \brief SSE2/AVX2 versions of the inner loop of vil_convolve_1d
+//
+// vil_convolve_1d() hands the part of each row away from the edges to
+// vil_convolve_1d_simd().  For a float destination, a vxl_byte, vxl_uint_16
+// or float source, float or double kernel and float or double accumulator,
+// and unit steps in source and destination, this computes several output
+// pixels at a time with SSE2 or AVX2, chosen at run time.  Each output
+// pixel goes through exactly the same sequence of multiplications, additions
+// and conversions as in the plain loop, so the results are identical.
+// For every other combination vil_convolve_1d_simd() does nothing and
+// returns false, and the plain loop is used.
+//
+// The vectorised code is left out when VNL_CONFIG_ENABLE_SIMD_DISPATCH is set
+// to 0, and skipped at run time by VNL_CPU_FEATURES_DISABLE (see vnl_cpu_features).
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <cstddef>
+#include <vcl_compiler.h>
+#include <vxl_config.h>
+
+//: Set dest[x] = sum_t kernel[k_hi-t]*src[x+t], t=0..k_hi-k_lo, for x in [0,n).
+// This is the generic case, which is not vectorised: it does nothing and returns false.
+template <class srcT, class destT, class kernelT, class accumT>
+inline bool vil_convolve_1d_simd(const srcT*, unsigned, destT*,
+                                 const kernelT*, std::ptrdiff_t, std::ptrdiff_t, accumT)
+{
+  return false;
+}
+
+// The vectorised cases.  Return false if the instruction sets are unavailable.
+#define VIL_CONVOLVE_1D_SIMD_DECLARE(srcT, kernelT, accumT) \
+bool vil_convolve_1d_simd(const srcT* src, unsigned n, float* dest, \
+                          const kernelT* kernel, std::ptrdiff_t k_lo, std::ptrdiff_t k_hi, accumT)
+
+VIL_CONVOLVE_1D_SIMD_DECLARE(vxl_byte, float, float);
+VIL_CONVOLVE_1D_SIMD_DECLARE(vxl_byte, float, double);
+VIL_CONVOLVE_1D_SIMD_DECLARE(vxl_byte, double, float);
+VIL_CONVOLVE_1D_SIMD_DECLARE(vxl_byte, double, double);
+VIL_CONVOLVE_1D_SIMD_DECLARE(vxl_uint_16, float, float);
+VIL_CONVOLVE_1D_SIMD_DECLARE(vxl_uint_16, float, double);
+VIL_CONVOLVE_1D_SIMD_DECLARE(vxl_uint_16, double, float);
+VIL_CONVOLVE_1D_SIMD_DECLARE(vxl_uint_16, double, double);
+VIL_CONVOLVE_1D_SIMD_DECLARE(float, float, float);
+VIL_CONVOLVE_1D_SIMD_DECLARE(float, float, double);
+VIL_CONVOLVE_1D_SIMD_DECLARE(float, double, float);
+VIL_CONVOLVE_1D_SIMD_DECLARE(float, double, double);
+
+#undef VIL_CONVOLVE_1D_SIMD_DECLARE
+
+#endif // vil_convolve_1d_simd_h_
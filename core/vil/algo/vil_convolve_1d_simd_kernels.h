@@ -0,0 +1,116 @@
+// This is core/vil/algo/vil_convolve_1d_simd_kernels.h
+// No include guard: this file is deliberately included several times.
+//:
+// \file
+// \brief Instruction set independent body of the vil_convolve_1d_simd kernel
+//
+// For internal use by vil_convolve_1d_simd.cxx only.  Before each inclusion
+// VIL_SIMD_TARGET must be defined as the function attribute selecting the
+// instruction set, and the inclusion must be wrapped in its own namespace
+// which also defines the register wrapper "simd", providing
+//   typedef F (W floats), typedef D (W/2 doubles), enum { W },
+//   zero_f(), set1_f(), add_f(), mul_f(), store_f(),
+//   zero_d(), set1_d(), add_d(), mul_d(),
+//   lo_d() and hi_d() (the low and high halves of an F as doubles),
+//   to_f() (two D rounded to floats and joined), and
+//   load() of W consecutive vxl_byte, vxl_uint_16 or float values as an F.
+// The instruction sets must not include FMA, or the compiler could fuse
+// the multiplications and additions and so change the results.
+
+//: Sums of products for W output pixels, in accumulator type A, with kernel type K.
+// step() adds k*s to each lane in exactly the way the plain loop does:
+// the product is formed in type K, converted to A, then added.
+template <class S, class K, class A> struct acc;
+
+template <class S> struct acc<S, float, float>
+{
+  typedef typename S::F T;
+  VIL_SIMD_TARGET static inline T zero() { return S::zero_f(); }
+  VIL_SIMD_TARGET static inline T step(T a, float k, typename S::F s)
+  { return S::add_f(a, S::mul_f(S::set1_f(k), s)); }
+  VIL_SIMD_TARGET static inline void store(float* d, T a) { S::store_f(d, a); }
+};
+
+template <class S> struct acc<S, double, float>
+{
+  typedef typename S::F T;
+  VIL_SIMD_TARGET static inline T zero() { return S::zero_f(); }
+  VIL_SIMD_TARGET static inline T step(T a, double k, typename S::F s)
+  {
+    const typename S::D kk = S::set1_d(k);
+    return S::add_f(a, S::to_f(S::mul_d(kk, S::lo_d(s)), S::mul_d(kk, S::hi_d(s))));
+  }
+  VIL_SIMD_TARGET static inline void store(float* d, T a) { S::store_f(d, a); }
+};
+
+template <class S> struct acc<S, double, double>
+{
+  struct T { typename S::D lo, hi; };
+  VIL_SIMD_TARGET static inline T zero() { T a; a.lo = a.hi = S::zero_d(); return a; }
+  VIL_SIMD_TARGET static inline T step(T a, double k, typename S::F s)
+  {
+    const typename S::D kk = S::set1_d(k);
+    a.lo = S::add_d(a.lo, S::mul_d(kk, S::lo_d(s)));
+    a.hi = S::add_d(a.hi, S::mul_d(kk, S::hi_d(s)));
+    return a;
+  }
+  VIL_SIMD_TARGET static inline void store(float* d, T a) { S::store_f(d, S::to_f(a.lo, a.hi)); }
+};
+
+template <class S> struct acc<S, float, double>
+{
+  struct T { typename S::D lo, hi; };
+  VIL_SIMD_TARGET static inline T zero() { T a; a.lo = a.hi = S::zero_d(); return a; }
+  VIL_SIMD_TARGET static inline T step(T a, float k, typename S::F s)
+  {
+    const typename S::F p = S::mul_f(S::set1_f(k), s);
+    a.lo = S::add_d(a.lo, S::lo_d(p));
+    a.hi = S::add_d(a.hi, S::hi_d(p));
+    return a;
+  }
+  VIL_SIMD_TARGET static inline void store(float* d, T a) { S::store_f(d, S::to_f(a.lo, a.hi)); }
+};
+
+//: dest[x] = sum_t k_rbegin[-t]*src[x+t], t=0..m-1, for x in [0,n).
+// Two registers of outputs are computed at a time to hide the latency of
+// the additions, then one, then the remaining pixels one by one.
+template <class srcT, class K, class A> VIL_SIMD_TARGET
+static void convolve(const srcT* src, unsigned n, float* dest, const K* k_rbegin, unsigned m)
+{
+  typedef simd S;
+  typedef acc<S, K, A> ops;
+  typedef typename ops::T T;
+  const unsigned W = S::W;
+  unsigned x = 0;
+  for (; x + 2*W <= n; x += 2*W)
+  {
+    T a0 = ops::zero(), a1 = ops::zero();
+    const srcT* s = src + x;
+    const K* k = k_rbegin;
+    for (unsigned t = 0; t < m; ++t, ++s, --k)
+    {
+      a0 = ops::step(a0, *k, S::load(s));
+      a1 = ops::step(a1, *k, S::load(s + W));
+    }
+    ops::store(dest + x, a0);
+    ops::store(dest + x + W, a1);
+  }
+  for (; x + W <= n; x += W)
+  {
+    T a = ops::zero();
+    const srcT* s = src + x;
+    const K* k = k_rbegin;
+    for (unsigned t = 0; t < m; ++t, ++s, --k)
+      a = ops::step(a, *k, S::load(s));
+    ops::store(dest + x, a);
+  }
+  for (; x < n; ++x)
+  {
+    A sum = 0;
+    const srcT* s = src + x;
+    const K* k = k_rbegin;
+    for (unsigned t = 0; t < m; ++t, ++s, --k)
+      sum += (A)((*k)*(*s));
+    dest[x] = float(sum);
+  }
+}
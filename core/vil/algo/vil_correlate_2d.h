@@ -9,6 +9,7 @@
 #include <vcl_compiler.h>
 #include <vcl_cassert.h>
 #include <vil/vil_image_view.h>
+#include <vil/algo/vil_correlate_2d_fft.h>
 
 //: Evaluate dot product between kernel and src_im
 // Returns  sum_ijp src_im[i*istep+j*jstep+p*pstep]*kernel(i,j,p)
@@ -49,6 +50,10 @@ inline accumT vil_correlate_2d_at_pt(const srcT *src_im, std::ptrdiff_t s_istep,
 // dest is resized to (1+src_im.ni()-kernel.ni())x(1+src_im.nj()-kernel.nj())
 // (a one plane image).
 // On exit dest(x,y) = sum_ij src_im(x+i,y+j)*kernel(i,j)
+//
+// If accumT and destT are floating point and the kernel is large, the
+// result is computed by FFT (see vil_correlate_2d_fft.h), which is much
+// faster and equal up to rounding errors.
 // \relatesalso vil_image_view
 template <class srcT, class destT, class kernelT, class accumT>
 inline void vil_correlate_2d(const vil_image_view<srcT>& src_im,
@@ -56,6 +61,9 @@ inline void vil_correlate_2d(const vil_image_view<srcT>& src_im,
                              const vil_image_view<kernelT>& kernel,
                              accumT ac)
 {
+  if (vil_correlate_2d_try_fft(src_im, dest_im, kernel, ac))
+    return;
+
   int ni = 1+src_im.ni()-kernel.ni(); assert(ni >= 0);
   int nj = 1+src_im.nj()-kernel.nj(); assert(nj >= 0);
   std::ptrdiff_t s_istep = src_im.istep(), s_jstep = src_im.jstep();
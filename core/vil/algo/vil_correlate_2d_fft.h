@@ -0,0 +1,190 @@
+// This is core/vil/algo/vil_correlate_2d_fft.h
+#ifndef vil_correlate_2d_fft_h_
+#define vil_correlate_2d_fft_h_
+//:
+// \file
+// \brief 2D correlation by overlap-save FFT, for large kernels
+//
+// Correlating an image directly with a kernel of K x K pixels costs K^2
+// multiplications per output pixel.  Here the image is cut into tiles
+// which overlap by the size of the kernel less one, and each tile is
+// correlated with the kernel by multiplying their Fourier transforms, at a
+// cost of about log(N) per pixel for tiles of N x N.  The parts of each
+// result which wrap around the tile are discarded (overlap-save).
+//
+// vil_correlate_2d() uses this automatically when the accumulator and the
+// destination are floating point and the kernel is large enough for it to
+// be faster.  The results are the same up to rounding errors.  A NaN or
+// infinity would spread to every output of its tile rather than just those
+// whose sums include it, so images or kernels holding any are correlated directly.
+
+#include <complex>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vcl_compiler.h>
+#include <vcl_cassert.h>
+#include <vil/vil_image_view.h>
+#include <vil/algo/vil_fft.h>
+#include <vnl/vnl_math.h>
+#include <vnl/algo/vnl_fft_plan.h>
+
+//: Size of the FFT tiles along a side of n pixels, for a kernel of k pixels.
+// About 4k, so that most of each tile is output, but no more than covers the image.
+inline unsigned vil_correlate_2d_fft_tile_size(unsigned n, unsigned k)
+{
+  unsigned t = 4*k < 64 ? 64 : 4*k;
+  if (t > n) t = n;
+  return vnl_fft_plan<double>::next_smooth(t);
+}
+
+//: True if correlating an ni x nj image with a kni x knj x np kernel is expected to be faster by FFT.
+inline bool vil_correlate_2d_fft_is_faster(unsigned ni, unsigned nj,
+                                           unsigned kni, unsigned knj, unsigned np)
+{
+  if (kni > ni || knj > nj || kni*knj == 0)
+    return false;
+  const double ti = vil_correlate_2d_fft_tile_size(ni, kni);
+  const double tj = vil_correlate_2d_fft_tile_size(nj, knj);
+  // multiply-adds per output pixel of the direct sum
+  const double direct = double(kni)*knj*np;
+  // np forward and one backward real transforms per tile, each about
+  // fft_cost*n*log2(n) multiply-adds, shared by the outputs of the tile
+  const double fft_cost = 1.5;
+  const double fft = fft_cost*(np+1)*ti*tj*std::log(ti*tj)/std::log(2.0)
+                     / ((ti-kni+1)*(tj-knj+1));
+  return fft < direct;
+}
+
+//: Correlate kernel with src_im by overlap-save FFT, computing in T (float or double).
+// dest is resized to (1+src_im.ni()-kernel.ni())x(1+src_im.nj()-kernel.nj())
+// (a one plane image).
+// On exit dest(x,y) = sum_ijp src_im(x+i,y+j,p)*kernel(i,j,p), up to rounding errors.
+// \relatesalso vil_image_view
+template <class T, class srcT, class destT, class kernelT>
+void vil_correlate_2d_fft(const vil_image_view<srcT>& src_im,
+                          vil_image_view<destT>& dest_im,
+                          const vil_image_view<kernelT>& kernel)
+{
+  const unsigned kni = kernel.ni(), knj = kernel.nj(), np = kernel.nplanes();
+  assert(src_im.ni() >= kni && src_im.nj() >= knj && src_im.nplanes() >= np);
+  const unsigned ni = 1+src_im.ni()-kni, nj = 1+src_im.nj()-knj;
+  dest_im.set_size(ni,nj,1);
+  if (ni*nj == 0 || kni*knj*np == 0)
+  {
+    dest_im.fill(destT(0));
+    return;
+  }
+
+  const unsigned ti = vil_correlate_2d_fft_tile_size(src_im.ni(), kni);
+  const unsigned tj = vil_correlate_2d_fft_tile_size(src_im.nj(), knj);
+  const unsigned bi = ti-kni+1, bj = tj-knj+1; // valid outputs of a tile
+
+  // Correlation is multiplication by the conjugate transform of the kernel.
+  // vil_fft_2d_fwd() divides by the number of pixels, so undo one of those.
+  const T scale = T(ti)*T(tj);
+  std::vector<vil_image_view<std::complex<T> > > kernel_f(np);
+  vil_image_view<T> tile(ti,tj);
+  for (unsigned p=0;p<np;++p)
+  {
+    tile.fill(T(0));
+    for (unsigned j=0;j<knj;++j)
+      for (unsigned i=0;i<kni;++i)
+        tile(i,j) = T(kernel(i,j,p));
+    vil_fft_2d_fwd(tile, kernel_f[p]);
+    vil_image_view<std::complex<T> >& kf = kernel_f[p];
+    for (unsigned j=0;j<kf.nj();++j)
+      for (unsigned i=0;i<kf.ni();++i)
+        kf(i,j) = std::conj(kf(i,j))*scale;
+  }
+
+  vil_image_view<std::complex<T> > tile_f, sum_f(ti/2+1,tj);
+  vil_image_view<T> result;
+  for (unsigned j0=0;j0<nj;j0+=bj)
+    for (unsigned i0=0;i0<ni;i0+=bi)
+    {
+      // tiles at the right and bottom edges are padded with zeros
+      const unsigned si = std::min(ti, src_im.ni()-i0), sj = std::min(tj, src_im.nj()-j0);
+      sum_f.fill(std::complex<T>(0));
+      for (unsigned p=0;p<np;++p)
+      {
+        if (si < ti || sj < tj)
+          tile.fill(T(0));
+        for (unsigned j=0;j<sj;++j)
+          for (unsigned i=0;i<si;++i)
+            tile(i,j) = T(src_im(i0+i,j0+j,p));
+        vil_fft_2d_fwd(tile, tile_f);
+        vil_image_view<std::complex<T> > const& kf = kernel_f[p];
+        for (unsigned j=0;j<tj;++j)
+          for (unsigned i=0;i<sum_f.ni();++i)
+            sum_f(i,j) += tile_f(i,j)*kf(i,j);
+      }
+      vil_fft_2d_bwd(sum_f, ti, result);
+
+      const unsigned ei = std::min(bi, ni-i0), ej = std::min(bj, nj-j0);
+      for (unsigned j=0;j<ej;++j)
+        for (unsigned i=0;i<ei;++i)
+          dest_im(i0+i,j0+j) = destT(result(i,j));
+    }
+}
+
+//: True if no pixel of im is a NaN or infinite.
+template <class T>
+inline bool vil_correlate_2d_all_finite(const vil_image_view<T>& im)
+{
+  if (std::numeric_limits<T>::is_integer)
+    return true;
+  for (unsigned p=0;p<im.nplanes();++p)
+    for (unsigned j=0;j<im.nj();++j)
+      for (unsigned i=0;i<im.ni();++i)
+        if (!vnl_math::isfinite(im(i,j,p)))
+          return false;
+  return true;
+}
+
+//: Correlate by FFT if the accumulator type allows it and it is expected to be faster.
+// Returns false, having done nothing, otherwise.
+template <class srcT, class destT, class kernelT, class accumT>
+inline bool vil_correlate_2d_try_fft(const vil_image_view<srcT>& /*src_im*/,
+                                     vil_image_view<destT>& /*dest_im*/,
+                                     const vil_image_view<kernelT>& /*kernel*/,
+                                     accumT)
+{
+  return false;
+}
+
+//: Correlate by FFT in single precision if it is expected to be faster.
+template <class srcT, class destT, class kernelT>
+inline bool vil_correlate_2d_try_fft(const vil_image_view<srcT>& src_im,
+                                     vil_image_view<destT>& dest_im,
+                                     const vil_image_view<kernelT>& kernel,
+                                     float)
+{
+  // rounding errors could change the result of conversion to an integer type
+  if (std::numeric_limits<destT>::is_integer ||
+      !vil_correlate_2d_fft_is_faster(src_im.ni(), src_im.nj(),
+                                      kernel.ni(), kernel.nj(), kernel.nplanes()) ||
+      !vil_correlate_2d_all_finite(kernel) || !vil_correlate_2d_all_finite(src_im))
+    return false;
+  vil_correlate_2d_fft<float>(src_im, dest_im, kernel);
+  return true;
+}
+
+//: Correlate by FFT in double precision if it is expected to be faster.
+template <class srcT, class destT, class kernelT>
+inline bool vil_correlate_2d_try_fft(const vil_image_view<srcT>& src_im,
+                                     vil_image_view<destT>& dest_im,
+                                     const vil_image_view<kernelT>& kernel,
+                                     double)
+{
+  if (std::numeric_limits<destT>::is_integer ||
+      !vil_correlate_2d_fft_is_faster(src_im.ni(), src_im.nj(),
+                                      kernel.ni(), kernel.nj(), kernel.nplanes()) ||
+      !vil_correlate_2d_all_finite(kernel) || !vil_correlate_2d_all_finite(src_im))
+    return false;
+  vil_correlate_2d_fft<double>(src_im, dest_im, kernel);
+  return true;
+}
+
+#endif // vil_correlate_2d_fft_h_
@@ -5,6 +5,10 @@
 //  \file
 //  \brief Functions to apply the FFT to an image.
 // \author Fred Wheeler
+//
+// The images may have any size; see vnl_fft_plan.  The rows, and then the
+// columns, are split into bands which are transformed in parallel, see
+// vil_parallel.h.
 
 #include <complex>
 #include <vcl_compiler.h>
@@ -27,4 +31,23 @@ template<class T>
 void
 vil_fft_2d_bwd (vil_image_view<std::complex<T> > & img);
 
+//: Perform forward FFT of a real image.
+// Only the coefficients (u,v) with u <= ni/2 are computed, as
+// coefficient (ni-u,nj-v) is the complex conjugate of (u,v), so coeffs
+// is resized to (ni/2+1) x nj.  The scaling is that of vil_fft_2d_fwd().
+// \relatesalso vil_image_view
+template<class T>
+void
+vil_fft_2d_fwd (vil_image_view<T> const& img,
+                vil_image_view<std::complex<T> > & coeffs);
+
+//: Perform backward FFT of coefficients computed from a real image.
+// ni is the width of the real image, which cannot be recovered from the
+// width of coeffs, ni/2+1.  img is resized to ni x coeffs.nj().
+// \relatesalso vil_image_view
+template<class T>
+void
+vil_fft_2d_bwd (vil_image_view<std::complex<T> > const& coeffs, unsigned ni,
+                vil_image_view<T> & img);
+
 #endif // vil_fft_h_
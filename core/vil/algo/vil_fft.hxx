@@ -11,9 +11,75 @@
 #include "vil_fft.h"
 #include <vcl_compiler.h>
 #include <vil/vil_image_view.h>
-#include <vnl/algo/vnl_fft_1d.h>
+#include <vil/vil_parallel.h>
+#include <vnl/algo/vnl_fft_plan.h>
+#include <vcl_cassert.h>
+
+//: Transforms the signals of a band of n1 indices, for every n2 index.
+template<class T>
+class vil_fft_1d_job : public vil_parallel_job
+{
+ public:
+  vil_fft_1d_job(std::complex<T> * data,
+                 unsigned n0, std::ptrdiff_t step0,
+                 unsigned n1, std::ptrdiff_t step1,
+                 unsigned n2, std::ptrdiff_t step2,
+                 int dir, unsigned n_bands)
+    : data_(data), n0_(n0), step0_(step0), n1_(n1), step1_(step1),
+      n2_(n2), step2_(step2), dir_(dir), n_bands_(n_bands),
+      plan_(vnl_fft_plan<T>::get(n0)) {}
+
+  virtual void run(unsigned k) VXL_OVERRIDE
+  {
+    const unsigned b = n1_*k/n_bands_, e = n1_*(k+1)/n_bands_;
+    if (b == e)
+      return;
+    const T factor = T(1)/static_cast<T>(n0_);
+    std::vector<std::complex<T> > signal;
+    for (unsigned i2=0; i2<n2_; i2++)
+    {
+      std::complex<T> * d = data_ + b*step1_ + i2*step2_;
+      if (step0_ > 0)
+      {
+        // all the signals of the band at once, so the FFT loops run across
+        // them; the plan needs positive steps, so start from the lowest address
+        if (step1_ < 0)
+          plan_.transform(d + std::ptrdiff_t(e-b-1)*step1_, dir_, step0_, -step1_, e-b);
+        else
+          plan_.transform(d, dir_, step0_, step1_, e-b);
+      }
+      else // must copy the signals to contiguous memory
+      {
+        signal.resize(n0_);
+        std::complex<T> * s = d;
+        for (unsigned i1=b; i1<e; i1++, s+=step1_)
+        {
+          for (unsigned i0=0; i0<n0_; ++i0)
+            signal[i0] = s[i0*step0_];
+          plan_.transform(&signal[0], dir_);
+          for (unsigned i0=0; i0<n0_; ++i0)
+            s[i0*step0_] = signal[i0];
+        }
+      }
+      if (dir_ >= 0) // proper scaling for forward FFT
+        for (unsigned i1=b; i1<e; i1++, d+=step1_)
+          for (unsigned i0=0; i0<n0_; ++i0)
+            d[i0*step0_] *= factor;
+    }
+  }
+
+ private:
+  std::complex<T> * data_;
+  unsigned n0_; std::ptrdiff_t step0_;
+  unsigned n1_; std::ptrdiff_t step1_;
+  unsigned n2_; std::ptrdiff_t step2_;
+  int dir_;
+  unsigned n_bands_;
+  vnl_fft_plan<T> const& plan_;
+};
 
 //: Perform in place FFT in one dimension.
+// The signals are split into bands, which are transformed in parallel.
 template<class T>
 static void
 vil_fft_2d_base(std::complex<T> * data,
@@ -22,39 +88,85 @@ vil_fft_2d_base(std::complex<T> * data,
                 unsigned n2, std::ptrdiff_t step2, // nplanes, planestep
                 int dir)
 {
-  vnl_fft_1d<T> fft_1d(n0);
-  T factor = dir<0 ? T(1) : T(1)/static_cast<T>(n0);
+  if (n0 == 0 || n1 == 0 || n2 == 0)
+    return;
+  const unsigned n_bands = vil_parallel_n_bands(n1, 0, vil_parallel_policy());
+  vil_fft_1d_job<T> job(data, n0, step0, n1, step1, n2, step2, dir, n_bands);
+  vil_parallel_run(job, n_bands);
+}
 
-  if (1 == step0) // use contiguous data memory directly
+//: Transforms the real rows of a band of an image into their non-redundant coefficients.
+template<class T>
+class vil_fft_real_rows_fwd_job : public vil_parallel_job
+{
+ public:
+  vil_fft_real_rows_fwd_job(vil_image_view<T> const& img,
+                            vil_image_view<std::complex<T> >& coeffs, unsigned n_bands)
+    : img_(img), coeffs_(coeffs), n_bands_(n_bands),
+      plan_(vnl_fft_real_plan<T>::get(img.ni())) {}
+
+  virtual void run(unsigned k) VXL_OVERRIDE
   {
-    // FFT every pixel row (or column) in every colour band:
-    for (unsigned i1=0; i1<n1; i1++)
-    for (unsigned i2=0; i2<n2; i2++)
-    {
-      std::complex<T> * d = data + i1*step1 + i2*step2;
-      fft_1d.transform(d, dir);
-      if (dir >= 0)
-        for (unsigned i0=0; i0<n0; ++i0)
-          d[i0] *= factor; // proper scaling for forward FFT
-    }
+    const unsigned ni = img_.ni(), nj = img_.nj();
+    const unsigned b = nj*k/n_bands_, e = nj*(k+1)/n_bands_;
+    const T factor = T(1)/static_cast<T>(ni);
+    std::vector<T> row(ni);
+    for (unsigned p=0; p<img_.nplanes(); ++p)
+      for (unsigned j=b; j<e; ++j)
+      {
+        T const* src = &img_(0,j,p);
+        if (img_.istep() != 1) // must copy non-contiguous data memory to a std::vector
+        {
+          for (unsigned i=0; i<ni; ++i, src+=img_.istep())
+            row[i] = *src;
+          src = &row[0];
+        }
+        std::complex<T> * dst = &coeffs_(0,j,p);
+        plan_.real_to_complex(src, dst, +1);
+        for (unsigned i=0; i<plan_.n_coeffs(); ++i)
+          dst[i] *= factor; // proper scaling for forward FFT
+      }
   }
-  else // must copy non-contiguous data memory to a std::vector
+
+ private:
+  vil_image_view<T> const& img_;
+  vil_image_view<std::complex<T> >& coeffs_;
+  unsigned n_bands_;
+  vnl_fft_real_plan<T> const& plan_;
+};
+
+//: Transforms the non-redundant coefficients of a band of rows back into real rows.
+template<class T>
+class vil_fft_real_rows_bwd_job : public vil_parallel_job
+{
+ public:
+  vil_fft_real_rows_bwd_job(vil_image_view<std::complex<T> > const& coeffs,
+                            vil_image_view<T>& img, unsigned n_bands)
+    : coeffs_(coeffs), img_(img), n_bands_(n_bands),
+      plan_(vnl_fft_real_plan<T>::get(img.ni())) {}
+
+  virtual void run(unsigned k) VXL_OVERRIDE
   {
-    std::vector<std::complex<T> > v(n0);
-    for (unsigned i1=0; i1<n1; i1++)
-    for (unsigned i2=0; i2<n2; i2++)
-    {
-      std::complex<T> * d = data + i1*step1 + i2*step2;
-      for (unsigned i0=0; i0<n0; i0++, d+=step0)
-        v[i0] = *d;
-      fft_1d.transform(v, dir);
-      // copy std::vector back to non-contiguous data memory
-      d = data + i1*step1 + i2*step2;
-      for (unsigned i0=0; i0<n0; i0++, d+=step0)
-        *d = v[i0]*factor; // proper scaling for forward FFT
-    }
+    const unsigned ni = img_.ni(), nj = img_.nj();
+    const unsigned b = nj*k/n_bands_, e = nj*(k+1)/n_bands_;
+    std::vector<T> row(ni);
+    for (unsigned p=0; p<img_.nplanes(); ++p)
+      for (unsigned j=b; j<e; ++j)
+      {
+        T * dst = img_.istep() == 1 ? &img_(0,j,p) : &row[0];
+        plan_.complex_to_real(&coeffs_(0,j,p), dst, -1);
+        if (img_.istep() != 1) // copy std::vector back to non-contiguous data memory
+          for (unsigned i=0; i<ni; ++i)
+            img_(i,j,p) = row[i];
+      }
   }
-}
+
+ private:
+  vil_image_view<std::complex<T> > const& coeffs_;
+  vil_image_view<T>& img_;
+  unsigned n_bands_;
+  vnl_fft_real_plan<T> const& plan_;
+};
 
 template<class T>
 void
@@ -88,6 +200,45 @@ vil_fft_2d_bwd(vil_image_view<std::complex<T> >& img)
                   -1);
 }
 
+template<class T>
+void
+vil_fft_2d_fwd(vil_image_view<T> const& img,
+               vil_image_view<std::complex<T> >& coeffs)
+{
+  coeffs.set_size(img.ni()/2+1, img.nj(), img.nplanes());
+  if (img.size() == 0)
+    return;
+  const unsigned n_bands = vil_parallel_n_bands(img.nj(), 0, vil_parallel_policy());
+  vil_fft_real_rows_fwd_job<T> job(img, coeffs, n_bands);
+  vil_parallel_run(job, n_bands);
+  vil_fft_2d_base(coeffs.top_left_ptr(),
+                  coeffs.nj(), coeffs.jstep(),
+                  coeffs.ni(), coeffs.istep(),
+                  coeffs.nplanes(), coeffs.planestep(),
+                  1);
+}
+
+template<class T>
+void
+vil_fft_2d_bwd(vil_image_view<std::complex<T> > const& coeffs, unsigned ni,
+               vil_image_view<T>& img)
+{
+  assert(coeffs.ni() == ni/2+1);
+  img.set_size(ni, coeffs.nj(), coeffs.nplanes());
+  if (img.size() == 0)
+    return;
+  vil_image_view<std::complex<T> > tmp;
+  tmp.deep_copy(coeffs);
+  vil_fft_2d_base(tmp.top_left_ptr(),
+                  tmp.nj(), tmp.jstep(),
+                  tmp.ni(), tmp.istep(),
+                  tmp.nplanes(), tmp.planestep(),
+                  -1);
+  const unsigned n_bands = vil_parallel_n_bands(img.nj(), 0, vil_parallel_policy());
+  vil_fft_real_rows_bwd_job<T> job(tmp, img, n_bands);
+  vil_parallel_run(job, n_bands);
+}
+
 #undef VIL_FFT_INSTANTIATE
 #define VIL_FFT_INSTANTIATE(T) \
 template void vil_fft_2d_base(std::complex<T >* data, \
@@ -96,6 +247,10 @@ template void vil_fft_2d_base(std::complex<T >* data, \
                               unsigned n2, std::ptrdiff_t step2, \
                               int dir); \
 template void vil_fft_2d_fwd(vil_image_view<std::complex<T > >& img); \
-template void vil_fft_2d_bwd(vil_image_view<std::complex<T > >& img)
+template void vil_fft_2d_bwd(vil_image_view<std::complex<T > >& img); \
+template void vil_fft_2d_fwd(vil_image_view<T > const& img, \
+                             vil_image_view<std::complex<T > >& coeffs); \
+template void vil_fft_2d_bwd(vil_image_view<std::complex<T > > const& coeffs, unsigned ni, \
+                             vil_image_view<T >& img)
 
 #endif // vil_fft_hxx_
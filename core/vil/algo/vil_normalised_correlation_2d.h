@@ -8,7 +8,10 @@
 
 #include <cmath>
 #include <cstddef>
+#include <limits>
 #include <vil/vil_image_view.h>
+#include <vil/vil_math.h>
+#include <vil/algo/vil_correlate_2d.h>
 #include <vcl_compiler.h>
 #include <vcl_cassert.h>
 #include <vcl_compiler.h>
@@ -58,6 +61,60 @@ inline accumT vil_norm_corr_2d_at_pt(const srcT *src_im, std::ptrdiff_t s_istep,
   return var<=0 ? 0 : sum/std::sqrt(var);
 }
 
+//: Normalised cross-correlation, with the variance under the kernel from summed area tables.
+// The correlation is computed by vil_correlate_2d(), so by FFT for large
+// kernels, and the sums of the source values and of their squares under
+// the kernel in constant time per pixel.  The tables are kept in double
+// precision, which is exact for integer pixel types.
+// \relatesalso vil_image_view
+template <class srcT, class destT, class kernelT, class accumT>
+inline void vil_normalised_correlation_2d_sat(const vil_image_view<srcT>& src_im,
+                                              vil_image_view<destT>& dest_im,
+                                              const vil_image_view<kernelT>& kernel,
+                                              accumT ac)
+{
+  const unsigned kni = kernel.ni(), knj = kernel.nj(), np = kernel.nplanes();
+  assert(src_im.ni() >= kni && src_im.nj() >= knj && src_im.nplanes() >= np);
+  const unsigned ni = 1+src_im.ni()-kni, nj = 1+src_im.nj()-knj;
+
+  vil_image_view<accumT> corr;
+  vil_correlate_2d(src_im, corr, kernel, ac);
+
+  // the source values and their squares, summed over the planes of the kernel
+  vil_image_view<double> src_sum(src_im.ni(),src_im.nj()), src_sum_sq(src_im.ni(),src_im.nj());
+  for (unsigned j=0;j<src_im.nj();++j)
+    for (unsigned i=0;i<src_im.ni();++i)
+    {
+      double s=0, s2=0;
+      for (unsigned p=0;p<np;++p)
+      {
+        double v = double(src_im(i,j,p));
+        s += v; s2 += v*v;
+      }
+      src_sum(i,j) = s; src_sum_sq(i,j) = s2;
+    }
+  vil_image_view<double> sum, sum_sq;
+  vil_math_integral_image(src_sum, sum);
+  vil_math_integral_image(src_sum_sq, sum_sq);
+
+  // differences of large sums have rounding errors of about eps times the
+  // largest sum, so smaller variances are taken to be 0 as for constant regions
+  const double n = double(kni)*knj*np;
+  const double min_var = 16*std::numeric_limits<double>::epsilon()
+                         * sum_sq(src_im.ni(),src_im.nj())/n;
+
+  dest_im.set_size(ni,nj,1);
+  for (unsigned j=0;j<nj;++j)
+    for (unsigned i=0;i<ni;++i)
+    {
+      double s  = sum(i,j)+sum(i+kni,j+knj)-sum(i+kni,j)-sum(i,j+knj);
+      double s2 = sum_sq(i,j)+sum_sq(i+kni,j+knj)-sum_sq(i+kni,j)-sum_sq(i,j+knj);
+      double mean = s/n;
+      double var = s2/n - mean*mean;
+      dest_im(i,j) = var<=min_var ? destT(0) : destT(corr(i,j)/std::sqrt(var));
+    }
+}
+
 //: Normalised cross-correlation of (pre-normalised) kernel with srcT.
 // dest is resized to (1+src_im.ni()-kernel.ni())x(1+src_im.nj()-kernel.nj())
 // (a one plane image).
@@ -65,6 +122,9 @@ inline accumT vil_norm_corr_2d_at_pt(const srcT *src_im, std::ptrdiff_t s_istep,
 //
 // Assumes that the kernel has been normalised to have zero mean
 // and unit variance
+//
+// With a floating point accumT this uses vil_normalised_correlation_2d_sat(),
+// which gives the same result up to rounding errors.
 // \relatesalso vil_image_view
 template <class srcT, class destT, class kernelT, class accumT>
 inline void vil_normalised_correlation_2d(const vil_image_view<srcT>& src_im,
@@ -72,6 +132,12 @@ inline void vil_normalised_correlation_2d(const vil_image_view<srcT>& src_im,
                                           const vil_image_view<kernelT>& kernel,
                                           accumT ac)
 {
+  if (!std::numeric_limits<accumT>::is_integer)
+  {
+    vil_normalised_correlation_2d_sat(src_im, dest_im, kernel, ac);
+    return;
+  }
+
   unsigned ni = 1+src_im.ni()-kernel.ni(); assert(1+src_im.ni() >= kernel.ni());
   unsigned nj = 1+src_im.nj()-kernel.nj(); assert(1+src_im.nj() >= kernel.nj());
   std::ptrdiff_t s_istep = src_im.istep(), s_jstep = src_im.jstep();
@@ -0,0 +1,293 @@
+// This is core/vil/algo/vil_parallel_filters.h
+#ifndef vil_parallel_filters_h_
+#define vil_parallel_filters_h_
+//:
+// \file
+// \brief Multi-threaded versions of some common filters
+//
+// Each function here is an overload of a serial filter with an extra
+// vil_parallel_policy argument, and gives exactly the same output:
+// \code
+//   vil_gauss_filter_5tap(src, dest, params, vil_parallel_policy());
+//   vil_median(src, dest, element, vil_parallel_policy(8));
+// \endcode
+// The image is split into bands of rows, one per thread.  Each band is
+// filtered by the serial code from a crop of the source which includes the
+// rows above and below needed by the filter (the halo).  The rows of the
+// result which are affected by the edges of the crop, rather than the edges
+// of the image, are computed by the neighbouring band and discarded here.
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <vcl_compiler.h>
+#include <vcl_cassert.h>
+#include <vil/vil_image_view.h>
+#include <vil/vil_crop.h>
+#include <vil/vil_parallel.h>
+#include <vil/algo/vil_convolve_1d.h>
+#include <vil/algo/vil_gauss_filter.h>
+#include <vil/algo/vil_sobel_3x3.h>
+#include <vil/algo/vil_greyscale_dilate.h>
+#include <vil/algo/vil_greyscale_erode.h>
+#include <vil/algo/vil_median.h>
+
+//: Copy rows [j0,j1) of dest from rows [from_j0,from_j0+j1-j0) of src.
+template <class T>
+inline void vil_parallel_copy_rows(const vil_image_view<T>& src, unsigned from_j0,
+                                   vil_image_view<T>& dest, unsigned j0, unsigned j1)
+{
+  const unsigned ni = dest.ni();
+  for (unsigned p = 0; p < dest.nplanes(); ++p)
+    for (unsigned j = j0; j < j1; ++j)
+    {
+      const T* s = &src(0, from_j0 + j - j0, p);
+      T* d = &dest(0, j, p);
+      const std::ptrdiff_t s_istep = src.istep(), d_istep = dest.istep();
+      for (unsigned i = 0; i < ni; ++i, s += s_istep, d += d_istep)
+        *d = *s;
+    }
+}
+
+//: Applies filter f to the bands of rows of src in parallel.
+// f(src_band, dest_bands) must filter src_band into the n_dest images
+// dest_bands[0..n_dest-1], such that output row j depends only on source
+// rows j-halo..j+halo.  All the images in dest must already have the size
+// and number of planes that f gives them.
+template <class srcT, class destT, class F>
+class vil_parallel_band_job : public vil_parallel_job
+{
+ public:
+  vil_parallel_band_job(const vil_image_view<srcT>& src, vil_image_view<destT>* dest,
+                        unsigned n_dest, const F& f, const std::vector<vil_parallel_band>& bands)
+    : src_(src), dest_(dest), n_dest_(n_dest), f_(f), bands_(bands) {}
+
+  void run(unsigned k) VXL_OVERRIDE
+  {
+    const vil_parallel_band& b = bands_[k];
+    const vil_image_view<srcT> src_band = vil_crop(src_, 0, src_.ni(), b.c0, b.c1 - b.c0);
+    std::vector<vil_image_view<destT> > out(n_dest_);
+    // Without a halo the band can be written in place.
+    const bool direct = b.c0 == b.j0 && b.c1 == b.j1;
+    if (direct)
+      for (unsigned d = 0; d < n_dest_; ++d)
+        out[d] = vil_crop(dest_[d], 0, dest_[d].ni(), b.j0, b.j1 - b.j0);
+    f_(src_band, &out[0]);
+    if (!direct)
+      for (unsigned d = 0; d < n_dest_; ++d)
+        vil_parallel_copy_rows(out[d], b.j0 - b.c0, dest_[d], b.j0, b.j1);
+  }
+
+ private:
+  const vil_image_view<srcT>& src_;
+  vil_image_view<destT>* dest_;
+  unsigned n_dest_;
+  const F& f_;
+  const std::vector<vil_parallel_band>& bands_;
+};
+
+//: Apply filter f to src, a band of rows per thread.
+// See vil_parallel_band_job for the requirements on f and dest.
+template <class srcT, class destT, class F>
+inline void vil_parallel_filter_rows(const vil_image_view<srcT>& src,
+                                     vil_image_view<destT>* dest, unsigned n_dest,
+                                     unsigned halo, const F& f,
+                                     const vil_parallel_policy& policy)
+{
+  const unsigned n_bands = vil_parallel_n_bands(src.nj(), halo, policy);
+  if (n_bands <= 1)
+  {
+    f(src, dest);
+    return;
+  }
+  std::vector<vil_parallel_band> bands;
+  vil_parallel_row_bands(src.nj(), halo, n_bands, bands);
+  vil_parallel_band_job<srcT, destT, F> job(src, dest, n_dest, f, bands);
+  vil_parallel_run(job, unsigned(bands.size()), policy.n_threads);
+}
+
+//: Number of rows above and below each pixel covered by element.
+inline unsigned vil_parallel_halo(const vil_structuring_element& element)
+{
+  return unsigned(std::max(0, std::max(-element.min_j(), element.max_j())));
+}
+
+template <class srcT, class destT>
+struct vil_parallel_gauss_filter_5tap_op
+{
+  const vil_gauss_filter_5tap_params& params;
+  explicit vil_parallel_gauss_filter_5tap_op(const vil_gauss_filter_5tap_params& p) : params(p) {}
+  void operator()(const vil_image_view<srcT>& src, vil_image_view<destT>* dest) const
+  { vil_gauss_filter_5tap(src, dest[0], params); }
+};
+
+//: Smooth a src_im to produce dest_im, using several threads.
+//  Gives the same result as vil_gauss_filter_5tap(src_im,dest_im,params).
+template <class srcT, class destT>
+inline void vil_gauss_filter_5tap(const vil_image_view<srcT>& src_im,
+                                  vil_image_view<destT>& dest_im,
+                                  const vil_gauss_filter_5tap_params& params,
+                                  const vil_parallel_policy& policy)
+{
+  const vil_parallel_gauss_filter_5tap_op<srcT, destT> op(params);
+  // Narrow images take a different path, which cannot be split into bands.
+  if (src_im.ni() <= 3)
+  {
+    op(src_im, &dest_im);
+    return;
+  }
+  dest_im.set_size(src_im.ni(), src_im.nj(), src_im.nplanes());
+  vil_parallel_filter_rows(src_im, &dest_im, 1, 2, op, policy);
+}
+
+template <class srcT, class destT, class kernelT, class accumT>
+struct vil_parallel_convolve_1d_op
+{
+  const kernelT* kernel;
+  std::ptrdiff_t k_lo, k_hi;
+  vil_convolve_boundary_option start_option, end_option;
+  void operator()(const vil_image_view<srcT>& src, vil_image_view<destT>* dest) const
+  { vil_convolve_1d(src, dest[0], kernel, k_lo, k_hi, accumT(), start_option, end_option); }
+};
+
+//: Convolve kernel[i] (i in [k_lo,k_hi]) with src_im in i-direction, using several threads.
+//  Gives the same result as the serial vil_convolve_1d() with the same arguments.
+// \relatesalso vil_image_view
+template <class srcT, class destT, class kernelT, class accumT>
+inline void vil_convolve_1d(const vil_image_view<srcT>& src_im,
+                            vil_image_view<destT>& dest_im,
+                            const kernelT* kernel,
+                            std::ptrdiff_t k_lo, std::ptrdiff_t k_hi,
+                            accumT,
+                            vil_convolve_boundary_option start_option,
+                            vil_convolve_boundary_option end_option,
+                            const vil_parallel_policy& policy)
+{
+  vil_parallel_convolve_1d_op<srcT, destT, kernelT, accumT> op;
+  op.kernel = kernel; op.k_lo = k_lo; op.k_hi = k_hi;
+  op.start_option = start_option; op.end_option = end_option;
+  dest_im.set_size(src_im.ni(), src_im.nj(), src_im.nplanes());
+  vil_parallel_filter_rows(src_im, &dest_im, 1, 0, op, policy);
+}
+
+template <class srcT, class destT>
+struct vil_parallel_sobel_3x3_op
+{
+  bool separate; // grad_i and grad_j in two images, rather than interleaved planes of one
+  explicit vil_parallel_sobel_3x3_op(bool s) : separate(s) {}
+  void operator()(const vil_image_view<srcT>& src, vil_image_view<destT>* dest) const
+  {
+    if (separate)
+      vil_sobel_3x3(src, dest[0], dest[1]);
+    else
+      vil_sobel_3x3(src, dest[0]);
+  }
+};
+
+//: Compute gradients of an image using 3x3 Sobel filters, using several threads.
+//  Gives the same result as vil_sobel_3x3(src,grad_i,grad_j).
+// \relatesalso vil_image_view
+template <class srcT, class destT>
+inline void vil_sobel_3x3(const vil_image_view<srcT>& src,
+                          vil_image_view<destT>& grad_i,
+                          vil_image_view<destT>& grad_j,
+                          const vil_parallel_policy& policy)
+{
+  grad_i.set_size(src.ni(), src.nj(), src.nplanes());
+  grad_j.set_size(src.ni(), src.nj(), src.nplanes());
+  vil_image_view<destT> grad[2] = { grad_i, grad_j };
+  vil_parallel_filter_rows(src, grad, 2, 1, vil_parallel_sobel_3x3_op<srcT, destT>(true), policy);
+}
+
+//: Compute gradients of an image using 3x3 Sobel filters, using several threads.
+//  Gives the same result as vil_sobel_3x3(src,grad_ij).
+// \relatesalso vil_image_view
+template <class srcT, class destT>
+inline void vil_sobel_3x3(const vil_image_view<srcT>& src,
+                          vil_image_view<destT>& grad_ij,
+                          const vil_parallel_policy& policy)
+{
+  grad_ij.set_size(src.ni(), src.nj(), 2*src.nplanes());
+  vil_parallel_filter_rows(src, &grad_ij, 1, 1, vil_parallel_sobel_3x3_op<srcT, destT>(false), policy);
+}
+
+template <class T>
+struct vil_parallel_greyscale_dilate_op
+{
+  const vil_structuring_element& element;
+  explicit vil_parallel_greyscale_dilate_op(const vil_structuring_element& e) : element(e) {}
+  void operator()(const vil_image_view<T>& src, vil_image_view<T>* dest) const
+  { vil_greyscale_dilate(src, dest[0], element); }
+};
+
+//: Dilates src_image to produce dest_image (assumed single plane), using several threads.
+//  Gives the same result as vil_greyscale_dilate(src_image,dest_image,element).
+// \relatesalso vil_image_view
+// \relatesalso vil_structuring_element
+template <class T>
+inline void vil_greyscale_dilate(const vil_image_view<T>& src_image,
+                                 vil_image_view<T>& dest_image,
+                                 const vil_structuring_element& element,
+                                 const vil_parallel_policy& policy)
+{
+  assert(src_image.nplanes()==1);
+  dest_image.set_size(src_image.ni(), src_image.nj(), 1);
+  vil_parallel_filter_rows(src_image, &dest_image, 1, vil_parallel_halo(element),
+                           vil_parallel_greyscale_dilate_op<T>(element), policy);
+}
+
+template <class T>
+struct vil_parallel_greyscale_erode_op
+{
+  const vil_structuring_element& element;
+  explicit vil_parallel_greyscale_erode_op(const vil_structuring_element& e) : element(e) {}
+  void operator()(const vil_image_view<T>& src, vil_image_view<T>* dest) const
+  { vil_greyscale_erode(src, dest[0], element); }
+};
+
+//: Erodes src_image to produce dest_image (assumed single plane), using several threads.
+//  Gives the same result as vil_greyscale_erode(src_image,dest_image,element).
+// \relatesalso vil_image_view
+// \relatesalso vil_structuring_element
+template <class T>
+inline void vil_greyscale_erode(const vil_image_view<T>& src_image,
+                                vil_image_view<T>& dest_image,
+                                const vil_structuring_element& element,
+                                const vil_parallel_policy& policy)
+{
+  assert(src_image.nplanes()==1);
+  dest_image.set_size(src_image.ni(), src_image.nj(), 1);
+  vil_parallel_filter_rows(src_image, &dest_image, 1, vil_parallel_halo(element),
+                           vil_parallel_greyscale_erode_op<T>(element), policy);
+}
+
+template <class T>
+struct vil_parallel_median_op
+{
+  const vil_structuring_element& element;
+  explicit vil_parallel_median_op(const vil_structuring_element& e) : element(e) {}
+  void operator()(const vil_image_view<T>& src, vil_image_view<T>* dest) const
+  { vil_median(src, dest[0], element); }
+};
+
+//: Computes median value of pixels under structuring element, using several threads.
+//  Gives the same result as vil_median(src_image,dest_image,element).
+// \relatesalso vil_image_view
+// \relatesalso vil_structuring_element
+template <class T>
+inline void vil_median(const vil_image_view<T>& src_image,
+                       vil_image_view<T>& dest_image,
+                       const vil_structuring_element& element,
+                       const vil_parallel_policy& policy)
+{
+  assert(src_image.nplanes()==1);
+  dest_image.set_size(src_image.ni(), src_image.nj(), 1);
+  vil_parallel_filter_rows(src_image, &dest_image, 1, vil_parallel_halo(element),
+                           vil_parallel_median_op<T>(element), policy);
+}
+
+#endif // vil_parallel_filters_h_
@@ -13,6 +13,7 @@
 #include <vil/vil_stream.h>
 #include <vil/vil_property.h>
 #include <vil/vil_memory_chunk.h>
+#include <vil/vil_mapped_image_resource.h>
 #include <vil/vil_image_view.h>
 #include <vil/vil_exception.h>
 
@@ -78,6 +79,35 @@ bool vil_bmp_image::get_property(char const * tag, void * value) const
     return true;
   }
 
+  if (std::strcmp(vil_property_file_layout, tag)==0)
+  {
+    // 32 bit BGRA pixels are reordered by get_copy_view, so cannot be mapped.
+    if (core_hdr.bitsperpixel != 8 && core_hdr.bitsperpixel != 24)
+      return false;
+    if (value)
+    {
+      std::ptrdiff_t const bytes_per_pixel = core_hdr.bitsperpixel / 8;
+      std::ptrdiff_t const bytes_per_raster = ((bytes_per_pixel * core_hdr.width + 3)/4)*4;
+      vil_file_layout& layout = *static_cast<vil_file_layout*>(value);
+      layout.format = VIL_PIXEL_FORMAT_BYTE;
+      layout.ni = ni();
+      layout.nj = nj();
+      layout.nplanes = nplanes();
+      layout.istep = bytes_per_pixel;
+      // Plane 0 is the last byte of each BB GG RR pixel.
+      layout.planestep = bytes_per_pixel == 3 ? -1 : 1;
+      layout.offset = bit_map_start + (bytes_per_pixel == 3 ? 2 : 0);
+      if (core_hdr.height > 0) // bottom-up
+      {
+        layout.offset += bytes_per_raster * (nj()-1);
+        layout.jstep = -bytes_per_raster;
+      }
+      else
+        layout.jstep = bytes_per_raster;
+    }
+    return true;
+  }
+
   return false;
 }
 
@@ -15,7 +15,9 @@
 #include <vil/vil_stream_fstream.h>
 #include <vil/vil_image_view.h>
 #include <vil/vil_property.h>
+#include <vil/vil_mapped_image_resource.h>
 #include <vil/vil_config.h>
+#include <vxl_config.h>
 #include "vil_nitf2_data_mask_table.h"
 #include "vil_nitf2_des.h"
 
@@ -837,6 +839,10 @@ bool vil_nitf2_image::get_property (char const *tag, void *property_value) const
       *static_cast<unsigned*>(property_value) = this->size_block_j();
     return true;
   }
+
+  if (std::strcmp(vil_property_file_layout, tag)==0)
+    return file_layout(static_cast<vil_file_layout*>(property_value));
+
   std::string result;
   if (m_file_header.get_property(tag, result) ||
       (current_image_header() && current_image_header()->get_property(tag, result)))
@@ -848,6 +854,67 @@ bool vil_nitf2_image::get_property (char const *tag, void *property_value) const
   return false;
  }
 
+//: The position of the pixels in the file, if they can be mapped.
+// That is, for uncompressed images held in a single block, with samples of
+// a whole number of bytes in the host's byte order (so bytes, on little
+// endian machines) which need no justification.
+bool vil_nitf2_image::file_layout(vil_file_layout* layout) const
+{
+  const vil_pixel_format fmt = pixel_format();
+  if (!current_image_header() || fmt == VIL_PIXEL_FORMAT_UNKNOWN || fmt == VIL_PIXEL_FORMAT_BOOL ||
+      vil_pixel_format_num_components(fmt) != 1 || n_block_i() != 1 || n_block_j() != 1)
+    return false;
+  std::string compression_type, image_mode_type;
+  int bits_per_pixel_per_band, actual_bits_per_pixel_per_band;
+  if (!current_image_header()->get_property("IC", compression_type) || compression_type != "NC" ||
+      !current_image_header()->get_property("IMODE", image_mode_type) ||
+      !current_image_header()->get_property("NBPP", bits_per_pixel_per_band) ||
+      !current_image_header()->get_property("ABPP", actual_bits_per_pixel_per_band))
+    return false;
+  const unsigned size = vil_pixel_format_sizeof_components(fmt);
+  if (bits_per_pixel_per_band != int(8*size) || actual_bits_per_pixel_per_band != bits_per_pixel_per_band)
+    return false;
+#if VXL_LITTLE_ENDIAN
+  if (size > 1)
+    return false; // NITF is big endian
+#endif
+
+  const std::ptrdiff_t bi = size_block_i(), bj = size_block_j(), np = nplanes();
+  const vil_streampos offset = get_offset_to_image_data_block_band(m_current_image_index, 0, 0, 0);
+  if (offset == 0)
+    return false; // blank block, not in the file
+  std::ptrdiff_t istep, jstep, planestep;
+  if (image_mode_type == "B" || image_mode_type == "S") {
+    istep = 1; jstep = bi; planestep = bi*bj;
+    if (image_mode_type == "S") // each band is found separately
+      for (unsigned p = 1; p < nplanes(); ++p)
+        if (get_offset_to_image_data_block_band(m_current_image_index, 0, 0, p) !=
+            offset + vil_streampos(p) * planestep * size)
+          return false;
+  }
+  else if (image_mode_type == "P") {
+    istep = np; jstep = np*bi; planestep = 1;
+  }
+  else if (image_mode_type == "R") {
+    istep = 1; jstep = np*bi; planestep = bi;
+  }
+  else
+    return false;
+
+  if (layout)
+  {
+    layout->offset = offset;
+    layout->format = fmt;
+    layout->ni = ni();
+    layout->nj = nj();
+    layout->nplanes = nplanes();
+    layout->istep = istep;
+    layout->jstep = jstep;
+    layout->planestep = planestep;
+  }
+  return true;
+}
+
 vil_nitf2_field::field_tree* vil_nitf2_image::get_tree( ) const
 {
   vil_nitf2_field::field_tree* t = new vil_nitf2_field::field_tree;
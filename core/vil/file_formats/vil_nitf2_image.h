@@ -21,6 +21,7 @@
 #include <vil/vil_file_format.h>
 
 class vil_nitf2_des;
+struct vil_file_layout;
 
 class vil_nitf2_file_format : public vil_file_format
 {
@@ -209,6 +210,9 @@ class vil_nitf2_image : public vil_blocked_image_resource
                                                      unsigned int blockIndexY,
                                                      int bandIndex ) const;
 
+  //: Where the pixels are in the file, for vil_property_file_layout.
+  bool file_layout(vil_file_layout* layout) const;
+
   //main file header
   vil_nitf2_header m_file_header;
   //image header(s)
@@ -22,6 +22,7 @@
 #include <vil/vil_image_resource.h>
 #include <vil/vil_image_view.h>
 #include <vil/vil_memory_chunk.h>
+#include <vil/vil_mapped_image_resource.h>
 #include <vil/vil_exception.h>
 
 #if 0 // see comment below
@@ -87,6 +88,30 @@ bool vil_pnm_image::get_property(char const * tag, void * value) const
     return true;
   }
 
+  if (std::strcmp(vil_property_file_layout, tag)==0)
+  {
+    // Only raw pgm and ppm files, whose samples are bytes or big-endian words.
+    if (magic_ < 5 || bits_per_component_ <= 1 || bits_per_component_ > 16)
+      return false;
+#if VXL_LITTLE_ENDIAN
+    if (bits_per_component_ > 8)
+      return false;
+#endif
+    if (value)
+    {
+      vil_file_layout& layout = *static_cast<vil_file_layout*>(value);
+      layout.offset = start_of_data_;
+      layout.format = bits_per_component_ <= 8 ? VIL_PIXEL_FORMAT_BYTE : VIL_PIXEL_FORMAT_UINT_16;
+      layout.ni = ni_;
+      layout.nj = nj_;
+      layout.nplanes = ncomponents_;
+      layout.istep = ncomponents_;
+      layout.jstep = std::ptrdiff_t(ni_) * ncomponents_;
+      layout.planestep = 1;
+    }
+    return true;
+  }
+
   return false;
 }
 
@@ -120,15 +120,14 @@ vil_pyramid_image_resource_sptr vil_pyramid_image_list_format::
     if (!blk_base)
       return VXL_NULLPTR;
   }
-  //Create the other pyramid levels
+  //Create the other pyramid levels, reading the base image only once
+  if (nlevels>1)
   { //program scope to close resource files
-    vil_image_resource_sptr image = blk_base.ptr();
+    std::vector<std::string> filenames;
     for (unsigned int L = 1; L<nlevels; ++L)
-    {
-      std::cout << "Decimating Level " << L << std::endl;
-      full_filename = level_filename(d, fn, float(L)) + '.'+ level_file_format;
-      image = vil_pyramid_image_resource::decimate(image,full_filename.c_str());
-    }
+      filenames.push_back(level_filename(d, fn, float(L)) + '.'+ level_file_format);
+    std::cout << "Decimating Levels 1 to " << nlevels-1 << std::endl;
+    vil_pyramid_image_resource::decimate_levels(blk_base.ptr(), filenames);
   } //end program scope to close resource files
   vil_image_list il(directory);
   std::vector<vil_image_resource_sptr> rescs = il.resources();
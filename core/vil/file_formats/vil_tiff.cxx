@@ -3,6 +3,7 @@
 #include <iostream>
 #include <algorithm>
 #include <sstream>
+#include <fcntl.h> // O_RDONLY, the mode returned by TIFFGetMode()
 #include "vil_tiff.h"
 //:
 // \file
@@ -15,20 +16,29 @@
 //   2001-11-09 K.Y.McGaul  Use dflt value for orientation when it can't be read
 //   2005-12-xx J.L. Mundy  Essentially a complete rewrite to support blocking.
 //                          Cleaner struct: hdr params moved to vil_tiff_header
+//   get_blocks() and put_view() decode and compress blocks on several threads
 // \endverbatim
 
 #include <vcl_cassert.h>
 #include <vcl_compiler.h>
+#include <vxl_config.h>
 #include <vil/vil_stream.h>
+#include <vil/vil_stream_core.h>
+#include <vil/vil_parallel.h>
 #include <vil/vil_property.h>
 #include <vil/vil_image_view.h>
 #include <vil/vil_memory_chunk.h>
+#include <vil/vil_mapped_image_resource.h>
 #include <vil/vil_copy.h>
 #include <vil/vil_image_list.h>
 #include "vil_tiff_header.h"
 #include <vil/vil_exception.h>
 //#define DEBUG
 
+#if VXL_FULLCXX11SUPPORT
+# include <mutex>
+#endif
+
 // Constants
 char const* vil_tiff_format_tag = "tiff";
 
@@ -190,6 +200,185 @@ static TIFF* open_tiff(tif_stream_structures* tss, const char* mode)
     return tiff;
 }
 
+static void close_tiff(TIFF* tif)
+{
+#if HAS_GEOTIFF
+  XTIFFClose(tif);
+#else
+  TIFFClose(tif);
+#endif // HAS_GEOTIFF
+}
+
+#if VXL_FULLCXX11SUPPORT
+//: Extra handles for reading a TIFF file, so that blocks can be decoded on several threads.
+struct vil_tiff_decoders
+{
+  ~vil_tiff_decoders()
+  {
+    for (unsigned k = 0; k < idle.size(); ++k)
+      close_tiff(idle[k]);
+  }
+  //: Handles not in use.
+  std::vector<TIFF*> idle;
+  //: Guards idle.
+  std::mutex mutex;
+  //: Held while reading from a vil_stream shared by several handles.
+  std::mutex io;
+};
+
+//: A vil_stream shared by several TIFF handles, each with its own position.
+struct vil_tiff_shared_stream
+{
+  vil_tiff_shared_stream(vil_stream* s, std::mutex* m) : vs(s), pos(0), io(m)
+  { vs->ref(); }
+  ~vil_tiff_shared_stream() { vs->unref(); }
+
+  vil_stream* vs;
+  vil_streampos pos;
+  std::mutex* io;
+};
+
+static tsize_t vil_tiff_shared_readproc(thandle_t h, tdata_t buf, tsize_t n)
+{
+  vil_tiff_shared_stream* p = (vil_tiff_shared_stream*)h;
+  std::lock_guard<std::mutex> lock(*p->io);
+  p->vs->seek(p->pos);
+  tsize_t ret = (tsize_t)p->vs->read(buf, n);
+  p->pos += ret;
+  return ret;
+}
+
+static tsize_t vil_tiff_shared_writeproc(thandle_t, tdata_t, tsize_t)
+{
+  return 0; // read only
+}
+
+static toff_t vil_tiff_shared_seekproc(thandle_t h, toff_t offset, int whence)
+{
+  vil_tiff_shared_stream* p = (vil_tiff_shared_stream*)h;
+  if      (whence == SEEK_SET) p->pos = offset;
+  else if (whence == SEEK_CUR) p->pos += offset;
+  else if (whence == SEEK_END) p->pos = p->vs->file_size() + offset;
+  return (toff_t)p->pos;
+}
+
+static int vil_tiff_shared_closeproc(thandle_t h)
+{
+  delete (vil_tiff_shared_stream*)h;
+  return 0;
+}
+
+static toff_t vil_tiff_shared_sizeproc(thandle_t h)
+{
+  return (toff_t)((vil_tiff_shared_stream*)h)->vs->file_size();
+}
+
+//: Open another handle for reading the file of tif.
+// If tif reads from a vil_stream the new handle shares it, otherwise the
+// file is opened again by name.
+static TIFF* vil_tiff_open_decoder(TIFF* tif, vil_tiff_decoders& d)
+{
+  if (TIFFGetReadProc(tif) != vil_tiff_readproc)
+  {
+#if HAS_GEOTIFF
+    return XTIFFOpen(TIFFFileName(tif), "rC");
+#else
+    return TIFFOpen(TIFFFileName(tif), "rC");
+#endif // HAS_GEOTIFF
+  }
+  tif_stream_structures* tss = (tif_stream_structures*)TIFFClientdata(tif);
+  vil_tiff_shared_stream* s = new vil_tiff_shared_stream(tss->vs, &d.io);
+#if HAS_GEOTIFF
+  TIFF* dec = XTIFFClientOpen(TIFFFileName(tif), "rC", (thandle_t)s,
+#else
+  TIFF* dec = TIFFClientOpen(TIFFFileName(tif), "rC", (thandle_t)s,
+#endif // HAS_GEOTIFF
+                             vil_tiff_shared_readproc, vil_tiff_shared_writeproc,
+                             vil_tiff_shared_seekproc, vil_tiff_shared_closeproc,
+                             vil_tiff_shared_sizeproc,
+                             vil_tiff_mapfileproc, vil_tiff_unmapfileproc);
+  if (!dec)
+    delete s; // not closed by libtiff on failure
+  return dec;
+}
+#else
+struct vil_tiff_decoders {};
+#endif // VXL_FULLCXX11SUPPORT
+
+//: The tags needed to compress a block on its own, as it would be in the file.
+struct vil_tiff_block_encoding
+{
+  bool tiled;
+  bool big_endian;
+  vxl_uint_32 size_block_i, size_block_j;
+  vxl_uint_16 bits_per_sample, samples_per_pixel, photometric;
+  vxl_uint_16 planar_config, sample_format, compression, predictor;
+  int zip_quality;
+};
+
+//: Compress a block as the single tile or strip of an image in memory.
+// The compressed bytes are appended to out.  The image has the tags of the
+// file the block belongs to, so the bytes can be written to that file with
+// TIFFWriteRawTile() or TIFFWriteRawStrip().
+static bool vil_tiff_compress_block(vil_tiff_block_encoding const& enc,
+                                    vxl_byte* block_buf, unsigned bytes_per_block,
+                                    std::vector<vxl_byte>& out)
+{
+  vil_stream* vs = new vil_stream_core;
+  vs->ref();
+  tif_stream_structures* tss = new tif_stream_structures(vs);
+  tss->tif = open_tiff(tss, enc.big_endian ? "wb" : "wl");
+  if (!tss->tif)
+  {
+    delete tss;
+    vs->unref();
+    return false;
+  }
+  TIFF* tif = tss->tif;
+  TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, enc.size_block_i);
+  TIFFSetField(tif, TIFFTAG_IMAGELENGTH, enc.size_block_j);
+  TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, enc.bits_per_sample);
+  TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, enc.samples_per_pixel);
+  TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, enc.photometric);
+  TIFFSetField(tif, TIFFTAG_PLANARCONFIG, enc.planar_config);
+  TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, enc.sample_format);
+  TIFFSetField(tif, TIFFTAG_COMPRESSION, enc.compression);
+  if (enc.compression != COMPRESSION_PACKBITS)
+    TIFFSetField(tif, TIFFTAG_PREDICTOR, enc.predictor);
+  if (enc.zip_quality >= 0)
+    TIFFSetField(tif, TIFFTAG_ZIPQUALITY, enc.zip_quality);
+  bool good = false;
+  toff_t* offsets = VXL_NULLPTR;
+  toff_t* byte_counts = VXL_NULLPTR;
+  if (enc.tiled)
+  {
+    TIFFSetField(tif, TIFFTAG_TILEWIDTH, enc.size_block_i);
+    TIFFSetField(tif, TIFFTAG_TILELENGTH, enc.size_block_j);
+    good = TIFFWriteEncodedTile(tif, 0, block_buf, bytes_per_block) > 0 &&
+           TIFFGetField(tif, TIFFTAG_TILEOFFSETS, &offsets) &&
+           TIFFGetField(tif, TIFFTAG_TILEBYTECOUNTS, &byte_counts);
+  }
+  else
+  {
+    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, enc.size_block_j);
+    good = TIFFWriteEncodedStrip(tif, 0, block_buf, bytes_per_block) > 0 &&
+           TIFFGetField(tif, TIFFTAG_STRIPOFFSETS, &offsets) &&
+           TIFFGetField(tif, TIFFTAG_STRIPBYTECOUNTS, &byte_counts);
+  }
+  if (good && byte_counts[0] > 0)
+  {
+    std::size_t n = out.size();
+    out.resize(n + std::size_t(byte_counts[0]));
+    vs->seek(vil_streampos(offsets[0]));
+    good = vs->read(&out[n], vil_streampos(byte_counts[0])) == vil_streampos(byte_counts[0]);
+  }
+  else
+    good = false;
+  close_tiff(tif);
+  vs->unref();
+  return good;
+}
+
 vil_image_resource_sptr vil_tiff_file_format::make_input_image(vil_stream* is)
 {
   if (!vil_tiff_file_format_probe(is))
@@ -262,18 +451,16 @@ make_pyramid_image_from_base(char const* file,
   {//scope for writing the resources
     vil_pyramid_image_resource_sptr pyr = make_pyramid_output_image(file);
     pyr->put_resource(base_image);
-    //Create the other pyramid levels
+    //Create the other pyramid levels, reading the base image only once
+    if (nlevels>1)
     {//scope for resource files
       std::string d = temp_dir;
       std::string fn = "tempR";
-      vil_image_resource_sptr image = base_image;
+      std::vector<std::string> filenames;
       for (unsigned L = 1; L<nlevels; ++L)
-      {
-        std::cout << "Decimating Level " << L << std::endl;
-        std::string full_filename = level_filename(d, fn, L) + ".tif";
-        image =
-          vil_pyramid_image_resource::decimate(image, full_filename.c_str());
-      }
+        filenames.push_back(level_filename(d, fn, L) + ".tif");
+      std::cout << "Decimating Levels 1 to " << nlevels-1 << std::endl;
+      vil_pyramid_image_resource::decimate_levels(base_image, filenames);
     }//end program scope to close resource files
 
     //reopen them for reading
@@ -377,7 +564,7 @@ char const* vil_tiff_file_format::tag() const
 
 vil_tiff_image::vil_tiff_image(tif_smart_ptr const& tif_sptr,
                                vil_tiff_header* th, const unsigned nimages):
-    t_(tif_sptr), h_(th), index_(0), nimages_(nimages)
+    t_(tif_sptr), h_(th), index_(0), nimages_(nimages), decoders_(VXL_NULLPTR)
 {
 }
 
@@ -407,9 +594,57 @@ bool vil_tiff_image::get_property(char const * tag, void * value) const
     return true;
   }
 
+  if (std::strcmp(vil_property_file_layout, tag)==0)
+    return file_layout(value ? static_cast<vil_file_layout*>(value) : VXL_NULLPTR);
+
   return false;
 }
 
+//: The position of the pixels in the file, if they can be mapped.
+// That is, for uncompressed, interleaved, striped images with whole-byte
+// samples in the host's byte order, whose strips follow one another in the file.
+bool vil_tiff_image::file_layout(vil_file_layout* layout) const
+{
+  const vil_pixel_format fmt = h_->pix_fmt;
+  if (!h_->format_supported || h_->is_tiled() || !h_->is_striped() ||
+      !h_->compression.valid || h_->compression.val != COMPRESSION_NONE ||
+      vil_pixel_format_num_components(fmt) != 1 || fmt == VIL_PIXEL_FORMAT_BOOL ||
+      h_->bits_per_sample.val != 8*vil_pixel_format_sizeof_components(fmt) ||
+      h_->samples_per_pixel.val != h_->nplanes ||
+      (h_->nplanes > 1 && h_->planar_config.val != PLANARCONFIG_CONTIG) ||
+      (h_->bits_per_sample.val > 8 && TIFFIsByteSwapped(t_.tif())) ||
+      !h_->image_width.valid || !h_->image_length.valid)
+    return false;
+
+  // The header only reads the strip offsets in debug builds, and toff_t is
+  // the element type libtiff uses for them whatever its version.
+  toff_t* strip_offsets = VXL_NULLPTR;
+  if (TIFFGetField(t_.tif(), TIFFTAG_STRIPOFFSETS, &strip_offsets) <= 0 || !strip_offsets)
+    return false;
+
+  const vxl_uint_32 bytes_per_line = h_->bytes_per_line();
+  const vxl_uint_32 rows_per_strip = h_->rows_per_strip.valid ? h_->rows_per_strip.val : h_->image_length.val;
+  const vxl_uint_32 n_strips = h_->strips_per_image();
+  for (vxl_uint_32 s = 1; s < n_strips; ++s)
+    if (vil_streampos(strip_offsets[s]) !=
+        vil_streampos(strip_offsets[0]) + vil_streampos(s) * rows_per_strip * bytes_per_line)
+      return false;
+
+  if (layout)
+  {
+    const unsigned size = vil_pixel_format_sizeof_components(fmt);
+    layout->offset = vil_streampos(strip_offsets[0]);
+    layout->format = fmt;
+    layout->ni = h_->image_width.val;
+    layout->nj = h_->image_length.val;
+    layout->nplanes = h_->nplanes;
+    layout->istep = h_->nplanes;
+    layout->jstep = bytes_per_line / size;
+    layout->planestep = 1;
+  }
+  return true;
+}
+
 bool vil_tiff_image::set_compression_method(compression_methods cm)
 {
   TIFF* const tif = t_.tif();
@@ -454,6 +689,7 @@ vil_pixel_format vil_tiff_image::pixel_format() const
 
 vil_tiff_image::~vil_tiff_image()
 {
+  delete decoders_;
   delete h_;
 }
 
@@ -703,29 +939,41 @@ view_from_buffer(vil_pixel_format& fmt, vil_memory_chunk_sptr const& buf,
   return view;
 }
 
-// this internal block accessor is used for both tiled and
-// striped encodings
-vil_image_view_base_sptr
-vil_tiff_image::get_block( unsigned block_index_i,
-                           unsigned block_index_j ) const
+//: If there are multiple images in the file it is
+// necessary to set the TIFF directory and file header corresponding to
+// this resource according to the index
+bool vil_tiff_image::select_image() const
 {
-  // the only two possibilities
-  assert(h_->is_tiled() || h_->is_striped());
-  //
-  // If there are multiple images in the file it is
-  // necessary to set the TIFF directory and file header corresponding to
-  // this resource according to the index
-  //
   if (nimages_>1)
   {
     if (TIFFSetDirectory(t_.tif(), index_)<=0)
-      return VXL_NULLPTR;
+      return false;
     vil_tiff_header* h = new vil_tiff_header(t_.tif());
     //Cast away const
     vil_tiff_image* ti = (vil_tiff_image*)this;
     delete h_;
     ti->h_=h;
   }
+  return true;
+}
+
+vil_image_view_base_sptr
+vil_tiff_image::get_block( unsigned block_index_i,
+                           unsigned block_index_j ) const
+{
+  if (!this->select_image())
+    return VXL_NULLPTR;
+  return this->read_block(t_.tif(), block_index_i, block_index_j);
+}
+
+// this internal block accessor is used for both tiled and
+// striped encodings
+vil_image_view_base_sptr
+vil_tiff_image::read_block( TIFF* tif, unsigned block_index_i,
+                            unsigned block_index_j ) const
+{
+  // the only two possibilities
+  assert(h_->is_tiled() || h_->is_striped());
 
   vil_image_view_base_sptr view = VXL_NULLPTR;
 
@@ -749,7 +997,7 @@ vil_tiff_image::get_block( unsigned block_index_i,
 
   if (h_->is_tiled())
   {
-    if (TIFFReadEncodedTile(t_.tif(), blk_indx, data, (tsize_t) -1)<=0)
+    if (TIFFReadEncodedTile(tif, blk_indx, data, (tsize_t) -1)<=0)
     {
       delete [] data;
       return view;
@@ -765,7 +1013,7 @@ vil_tiff_image::get_block( unsigned block_index_i,
 
   if (h_->is_striped())
   {
-    if (TIFFReadEncodedStrip(t_.tif(), blk_indx, data, (tsize_t) -1)<=0)
+    if (TIFFReadEncodedStrip(tif, blk_indx, data, (tsize_t) -1)<=0)
     {
       delete [] data;
       return view;
@@ -782,6 +1030,109 @@ vil_tiff_image::get_block( unsigned block_index_i,
   return view;
 }
 
+//: Decoding is worth sharing out if the image is compressed.
+// Uncompressed blocks are read faster by a single thread.
+bool vil_tiff_image::parallel_decoding() const
+{
+#if VXL_FULLCXX11SUPPORT
+  if (vil_parallel_max_threads() < 2 || !t_.tif() ||
+      TIFFGetMode(t_.tif()) != O_RDONLY)
+    return false;
+  vxl_uint_16 compression = COMPRESSION_NONE;
+  TIFFGetFieldDefaulted(t_.tif(), TIFFTAG_COMPRESSION, &compression);
+  return compression != COMPRESSION_NONE;
+#else
+  return false;
+#endif
+}
+
+#if VXL_FULLCXX11SUPPORT
+//: Decodes block k of a range on any thread, with a handle of its own.
+class vil_tiff_decode_job : public vil_parallel_job
+{
+ public:
+  typedef vil_image_view_base_sptr (vil_tiff_image::*read_fn)(TIFF*, unsigned, unsigned) const;
+
+  vil_tiff_decode_job(vil_tiff_image const& im, read_fn read, vil_tiff_decoders& d,
+                      TIFF* tif, unsigned directory,
+                      unsigned bi0, unsigned bj0, unsigned nbi,
+                      std::vector<vil_image_view_base_sptr>& blocks)
+  : im_(im), read_(read), d_(d), tif_(tif), dir_(directory),
+    bi0_(bi0), bj0_(bj0), nbi_(nbi), blocks_(blocks) {}
+
+  virtual void run(unsigned k)
+  {
+    TIFF* dec = VXL_NULLPTR;
+    {
+      std::lock_guard<std::mutex> lock(d_.mutex);
+      if (!d_.idle.empty())
+      {
+        dec = d_.idle.back();
+        d_.idle.pop_back();
+      }
+    }
+    if (!dec)
+      dec = vil_tiff_open_decoder(tif_, d_);
+    if (!dec)
+      return;
+    if (TIFFCurrentDirectory(dec) == dir_ || TIFFSetDirectory(dec, dir_) > 0)
+      blocks_[k] = (im_.*read_)(dec, bi0_ + k % nbi_, bj0_ + k / nbi_);
+    std::lock_guard<std::mutex> lock(d_.mutex);
+    d_.idle.push_back(dec);
+  }
+
+ private:
+  vil_tiff_image const& im_;
+  read_fn read_;
+  vil_tiff_decoders& d_;
+  TIFF* tif_;
+  unsigned dir_;
+  unsigned bi0_, bj0_, nbi_;
+  std::vector<vil_image_view_base_sptr>& blocks_;
+};
+#endif // VXL_FULLCXX11SUPPORT
+
+bool vil_tiff_image::
+get_blocks( unsigned start_block_i, unsigned end_block_i,
+            unsigned start_block_j, unsigned end_block_j,
+            std::vector< std::vector< vil_image_view_base_sptr > >& blocks ) const
+{
+  const unsigned nbi = end_block_i - start_block_i + 1;
+  const unsigned nbj = end_block_j - start_block_j + 1;
+  if (end_block_i < start_block_i || end_block_j < start_block_j ||
+      nbi*nbj < 2 || !this->parallel_decoding())
+    return vil_blocked_image_resource::get_blocks(start_block_i, end_block_i,
+                                                  start_block_j, end_block_j,
+                                                  blocks);
+#if VXL_FULLCXX11SUPPORT
+  if (!this->select_image())
+    return false;
+  if (!decoders_)
+    decoders_ = new vil_tiff_decoders;
+  // decoded row by row, so that the handles read the file in order
+  std::vector<vil_image_view_base_sptr> decoded(nbi*nbj);
+  vil_tiff_decode_job job(*this, &vil_tiff_image::read_block, *decoders_,
+                          t_.tif(), index_, start_block_i, start_block_j, nbi,
+                          decoded);
+  vil_parallel_run(job, nbi*nbj);
+  for (unsigned i = 0; i < nbi; ++i)
+  {
+    std::vector< vil_image_view_base_sptr > jblocks(nbj);
+    for (unsigned j = 0; j < nbj; ++j)
+    {
+      jblocks[j] = decoded[i + j*nbi];
+      // e.g. if no other handle could be opened
+      if (!jblocks[j])
+        jblocks[j] = this->read_block(t_.tif(), start_block_i + i, start_block_j + j);
+      if (!jblocks[j])
+        return false;
+    }
+    blocks.push_back(jblocks);
+  }
+#endif
+  return true;
+}
+
 //decode tiles: the tile is a contiguous raster scan of potentially
 //interleaved samples. This is an easy case since the tile is a
 //contiguous raster scan.
@@ -1076,6 +1427,20 @@ void vil_tiff_image::bitpack_block(unsigned bytes_per_block,
 //fill in the missing image data.
 bool vil_tiff_image::put_block(unsigned bi, unsigned bj, unsigned i0,
                                unsigned j0, const vil_image_view_base& im)
+{
+  unsigned bytes_per_block = 0;
+  vxl_byte* block_buf = this->block_buffer(bi, bj, i0, j0, im, bytes_per_block);
+  if (!block_buf)
+    return false;
+  //write the block to the tiff file
+  bool good_write = write_block_to_file(bi, bj, bytes_per_block, block_buf);
+  delete [] block_buf;
+  return good_write;
+}
+
+vxl_byte* vil_tiff_image::block_buffer(unsigned bi, unsigned bj, unsigned i0,
+                                       unsigned j0, const vil_image_view_base& im,
+                                       unsigned& bytes_per_block)
 {
   //Get the block offset and clipping parameters
 
@@ -1086,11 +1451,11 @@ bool vil_tiff_image::put_block(unsigned bi, unsigned bj, unsigned i0,
   //column offset into block. fill [0->ioff-1]
   if (bi*sbi<i0&&(bi+1)*sbi>i0)
     if (!block_i_offset(bi, i0, ioff))
-      return false;
+      return VXL_NULLPTR;
   //row offset into block fill [0->joff-1]
   if (bj*sbj<j0&&(bj+1)*sbj>j0)
     if (!block_j_offset(bj, j0, joff))
-      return false;
+      return VXL_NULLPTR;
 
   //iclip and jclip are the start of invalid data at the right and
   //bottom of partially filled blocks
@@ -1100,7 +1465,7 @@ bool vil_tiff_image::put_block(unsigned bi, unsigned bj, unsigned i0,
   {
     iclip = (i0+im.ni())-bi*sbi;
     if (iclip > sbi)
-      return false;
+      return VXL_NULLPTR;
   }
 
   //bottom block margin to be padded [jclip -> size_block_j()-1]
@@ -1108,16 +1473,17 @@ bool vil_tiff_image::put_block(unsigned bi, unsigned bj, unsigned i0,
   {
     jclip = (j0+im.nj())-bj*sbj;
     if (jclip > sbj)
-      return false;
+      return VXL_NULLPTR;
   }
   unsigned bps = h_->bytes_per_sample();
   unsigned bytes_per_pixel = bps*nplanes();
 
-  unsigned bytes_per_block = bytes_per_pixel*sbi*sbj;
+  bytes_per_block = bytes_per_pixel*sbi*sbj;
 
 
-  //the data buffer for the block
-  vxl_byte* block_buf = new vxl_byte[bytes_per_block];
+  //the data buffer for the block, zeroed so that the whole padding is
+  //deterministic (pad_block_with_zeros does not reach all of it)
+  vxl_byte* block_buf = new vxl_byte[bytes_per_block]();
 
   this->pad_block_with_zeros(ioff, joff, iclip, jclip,
                              bytes_per_pixel, block_buf);
@@ -1125,10 +1491,121 @@ bool vil_tiff_image::put_block(unsigned bi, unsigned bj, unsigned i0,
 
   this->fill_block_from_view(bi, bj, i0, j0, ioff, joff, iclip, jclip,
                              im, block_buf);
-  //write the block to the tiff file
-  bool good_write = write_block_to_file(bi, bj, bytes_per_block, block_buf);
-  delete [] block_buf;
-  return good_write;
+  return block_buf;
+}
+
+//: Compressing is worth sharing out for the codecs which need no shared state.
+// JPEG is left out since its tables are written with the directory.
+bool vil_tiff_image::parallel_encoding(vil_tiff_block_encoding& enc) const
+{
+  TIFF* tif = t_.tif();
+  if (vil_parallel_max_threads() < 2 || !tif || TIFFGetMode(tif) == O_RDONLY ||
+      this->pixel_format() == VIL_PIXEL_FORMAT_BOOL ||
+      !(h_->is_tiled() || h_->is_striped()))
+    return false;
+  vxl_uint_16 compression = COMPRESSION_NONE;
+  TIFFGetFieldDefaulted(tif, TIFFTAG_COMPRESSION, &compression);
+  if (compression != COMPRESSION_LZW && compression != COMPRESSION_DEFLATE &&
+      compression != COMPRESSION_ADOBE_DEFLATE && compression != COMPRESSION_PACKBITS)
+    return false;
+  enc.tiled = h_->is_tiled();
+  enc.big_endian = TIFFIsBigEndian(tif) != 0;
+  enc.size_block_i = size_block_i();
+  enc.size_block_j = size_block_j();
+  enc.compression = compression;
+  enc.predictor = PREDICTOR_NONE;
+  enc.zip_quality = -1;
+  enc.photometric = PHOTOMETRIC_MINISBLACK;
+  if (!TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &enc.bits_per_sample) ||
+      !TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &enc.samples_per_pixel) ||
+      !TIFFGetFieldDefaulted(tif, TIFFTAG_PLANARCONFIG, &enc.planar_config) ||
+      !TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLEFORMAT, &enc.sample_format) ||
+      !TIFFGetField(tif, TIFFTAG_PHOTOMETRIC, &enc.photometric))
+    return false;
+  if (compression != COMPRESSION_PACKBITS)
+    TIFFGetFieldDefaulted(tif, TIFFTAG_PREDICTOR, &enc.predictor);
+  if (compression != COMPRESSION_LZW && compression != COMPRESSION_PACKBITS)
+    TIFFGetField(tif, TIFFTAG_ZIPQUALITY, &enc.zip_quality);
+  return enc.size_block_i > 0 && enc.size_block_j > 0;
+}
+
+//: Compresses a batch of blocks of a view on any thread.
+class vil_tiff_encode_job : public vil_parallel_job
+{
+ public:
+  typedef vxl_byte* (vil_tiff_image::*buffer_fn)(unsigned, unsigned, unsigned, unsigned,
+                                                 const vil_image_view_base&, unsigned&);
+
+  vil_tiff_encode_job(vil_tiff_image& im, buffer_fn buffer,
+                      vil_tiff_block_encoding const& enc,
+                      const vil_image_view_base& view, unsigned i0, unsigned j0,
+                      std::vector<unsigned> const& bi, std::vector<unsigned> const& bj,
+                      std::vector<std::vector<vxl_byte> >& out, std::vector<char>& ok)
+  : im_(im), buffer_(buffer), enc_(enc), view_(view), i0_(i0), j0_(j0),
+    bi_(bi), bj_(bj), out_(out), ok_(ok) {}
+
+  virtual void run(unsigned k)
+  {
+    out_[k].clear();
+    unsigned bytes_per_block = 0;
+    vxl_byte* block_buf = (im_.*buffer_)(bi_[k], bj_[k], i0_, j0_, view_, bytes_per_block);
+    ok_[k] = block_buf &&
+             vil_tiff_compress_block(enc_, block_buf, bytes_per_block, out_[k]);
+    delete [] block_buf;
+  }
+
+ private:
+  vil_tiff_image& im_;
+  buffer_fn buffer_;
+  vil_tiff_block_encoding const& enc_;
+  const vil_image_view_base& view_;
+  unsigned i0_, j0_;
+  std::vector<unsigned> const& bi_;
+  std::vector<unsigned> const& bj_;
+  std::vector<std::vector<vxl_byte> >& out_;
+  std::vector<char>& ok_;
+};
+
+bool vil_tiff_image::put_view_in_parallel(vil_tiff_block_encoding const& enc,
+                                          const vil_image_view_base& im,
+                                          unsigned i0, unsigned j0)
+{
+  unsigned tw = size_block_i(), tl = size_block_j();
+  unsigned  bi_start = i0/tw, bi_end = (i0+im.ni()-1)/tw;
+  unsigned  bj_start = j0/tl, bj_end = (j0+im.nj()-1)/tl;
+  // A few blocks per thread at a time, so that only those are held compressed.
+  const unsigned batch = 4*vil_parallel_max_threads();
+  std::vector<unsigned> bis, bjs;
+  std::vector<std::vector<vxl_byte> > out(batch);
+  std::vector<char> ok(batch);
+  for (unsigned bj = bj_start; bj<=bj_end; ++bj)
+    for (unsigned bi = bi_start; bi<=bi_end; ++bi)
+    {
+      bis.push_back(bi);
+      bjs.push_back(bj);
+      if (bis.size() < batch && !(bi == bi_end && bj == bj_end))
+        continue;
+      vil_tiff_encode_job job(*this, &vil_tiff_image::block_buffer, enc, im, i0, j0,
+                              bis, bjs, out, ok);
+      vil_parallel_run(job, unsigned(bis.size()));
+      // the blocks are written in turn, in the order they were taken
+      for (unsigned k = 0; k < bis.size(); ++k)
+      {
+        unsigned blk_indx = this->block_index(bis[k], bjs[k]);
+        bool good = false;
+        if (ok[k] && enc.tiled)
+          good = TIFFWriteRawTile(t_.tif(), blk_indx, &out[k][0], tmsize_t(out[k].size())) > 0;
+        else if (ok[k])
+          good = TIFFWriteRawStrip(t_.tif(), blk_indx, &out[k][0], tmsize_t(out[k].size())) > 0;
+        else
+          good = this->put_block(bis[k], bjs[k], i0, j0, im);
+        if (!good)
+          return false;
+      }
+      bis.clear();
+      bjs.clear();
+    }
+  return true;
 }
 
 bool vil_tiff_image::put_view(const vil_image_view_base& im,
@@ -1145,6 +1622,9 @@ bool vil_tiff_image::put_view(const vil_image_view_base& im,
     return false;
   unsigned  bi_start = i0/tw, bi_end = (i0+im.ni()-1)/tw;
   unsigned  bj_start = j0/tl, bj_end = (j0+im.nj()-1)/tl;
+  vil_tiff_block_encoding enc;
+  if ((bi_end-bi_start+1)*(bj_end-bj_start+1) > 1 && this->parallel_encoding(enc))
+    return this->put_view_in_parallel(enc, im, i0, j0);
   for (unsigned bi = bi_start; bi<=bi_end; ++bi)
     for (unsigned bj = bj_start; bj<=bj_end; ++bj)
       if (!this->put_block(bi, bj, i0, j0, im))
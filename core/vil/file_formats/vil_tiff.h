@@ -21,6 +21,8 @@
 //       compression schemes. Tiff files with separate color bands are not handled
 //   24 Mar 2007 J.L. Mundy - added smart pointer on TIFF handle to support
 //       multiple resources from a single tiff file; required for pyramid
+//   Blocks of compressed images are decoded, and encoded by put_view(), on
+//       several threads at once (see vil_parallel.h)
 //   KNOWN BUG - 24bit samples for both nplanes = 1 and nplanes = 3
 //   KNOWN BUG - bool pixel format write - crashes due to incorrect block size
 // \endverbatim
@@ -88,7 +90,10 @@ class vil_tiff_file_format : public vil_file_format
 };
 
 struct tif_stream_structures;
+struct vil_tiff_decoders;
+struct vil_tiff_block_encoding;
 class vil_tiff_header;
+struct vil_file_layout;
 //Need to create a smartpointer mechanism for the tiff
 //file in order to handle multiple images, e.g. for pyramid
 //resource
@@ -207,10 +212,19 @@ class vil_tiff_image : public vil_blocked_image_resource
   virtual vil_image_view_base_sptr get_block( unsigned  block_index_i,
                                               unsigned  block_index_j ) const;
 
+  //: Get the blocks in the given range.
+  // The blocks of a compressed image opened for reading are decoded on
+  // several threads, each with its own handle on the file.
+  virtual bool get_blocks( unsigned start_block_i, unsigned end_block_i,
+                           unsigned start_block_j, unsigned end_block_j,
+                           std::vector< std::vector< vil_image_view_base_sptr > >& blocks ) const;
+
   virtual bool put_block( unsigned  block_index_i, unsigned  block_index_j,
                           const vil_image_view_base& blk );
 
   //: Put the data in this view back into the image source.
+  // If the image is LZW, deflate or packbits compressed, the blocks are
+  // compressed on several threads and then written in turn.
   virtual bool put_view(const vil_image_view_base& im, unsigned i0, unsigned j0);
 
   //: Return true if the property given in the first argument has been set.
@@ -254,6 +268,8 @@ class vil_tiff_image : public vil_blocked_image_resource
   unsigned int index_;
   //: number of images in the file
   unsigned int nimages_;
+  //: extra handles on the file, for decoding blocks on several threads
+  mutable vil_tiff_decoders* decoders_;
 #if 0
   //to keep the tiff file open during reuse of multiple tiff resources
   //in a single file otherwise the resource destructor would close the file
@@ -279,6 +295,24 @@ class vil_tiff_image : public vil_blocked_image_resource
 
   vil_image_view_base_sptr fill_block_from_strip(vil_memory_chunk_sptr const & buf) const;
 
+  //: make the image of this resource the current directory of a multi-image file
+  bool select_image() const;
+
+  //: read and decode a block using the given handle on the file
+  vil_image_view_base_sptr read_block(TIFF* tif, unsigned block_index_i,
+                                      unsigned block_index_j) const;
+
+  //: true if blocks can be decoded on several threads
+  bool parallel_decoding() const;
+
+  //: true if blocks can be compressed on several threads, and how
+  bool parallel_encoding(vil_tiff_block_encoding& enc) const;
+
+  //: put_view() with the blocks compressed on several threads
+  bool put_view_in_parallel(vil_tiff_block_encoding const& enc,
+                            const vil_image_view_base& im,
+                            unsigned i0, unsigned j0);
+
 #if 0
   vil_image_view_base_sptr get_block_internal( unsigned block_index_i,
                                                unsigned block_index_j ) const;
@@ -292,8 +326,18 @@ class vil_tiff_image : public vil_blocked_image_resource
   bool put_block(unsigned bi, unsigned bj, unsigned i0,
                  unsigned j0, const vil_image_view_base& im);
 
+  //: the data of block (bi, bj) of a view placed at (i0, j0), as written to file
+  // Returns 0 if the block does not overlap the view properly.
+  // The caller deletes the buffer.
+  vxl_byte* block_buffer(unsigned bi, unsigned bj, unsigned i0,
+                         unsigned j0, const vil_image_view_base& im,
+                         unsigned& bytes_per_block);
+
   unsigned block_index(unsigned block_i, unsigned block_j) const;
 
+  //: Where the pixels are in the file, for vil_property_file_layout.
+  bool file_layout(vil_file_layout* layout) const;
+
   //: fill out the block with leading zeros or trailing zeros if necessary
   void pad_block_with_zeros(unsigned ioff, unsigned joff,
                             unsigned iclip, unsigned jclip,
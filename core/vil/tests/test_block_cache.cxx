@@ -0,0 +1,189 @@
+// This is core/vil/tests/test_block_cache.cxx
+#include <iostream>
+#include <vector>
+#include <testlib/testlib_test.h>
+#include <vcl_compiler.h>
+#include <vxl_config.h>
+#include <vil/vil_new.h>
+#include <vil/vil_image_view.h>
+#include <vil/vil_block_cache.h>
+#include <vil/vil_cached_image_resource.h>
+
+#if VXL_FULLCXX11SUPPORT
+# include <chrono>
+# include <thread>
+#endif
+
+//:
+// \file
+// \brief Test vil_block_cache, and vil_cached_image_resource used from several threads.
+
+static vil_image_view_base_sptr test_block_cache_block(unsigned value)
+{
+  vil_image_view<vxl_byte>* v = new vil_image_view<vxl_byte>(16, 16);
+  v->fill(vxl_byte(value));
+  return v;
+}
+
+static void test_block_cache_lru()
+{
+  std::cout << "Least recently used blocks are discarded first\n";
+  vil_block_cache cache(3);
+  TEST("small cache has one shard", cache.n_shards(), 1);
+  for (unsigned bi = 0; bi < 3; ++bi)
+    cache.add_block(bi, 0, test_block_cache_block(bi));
+  vil_image_view_base_sptr blk;
+  TEST("get block 0", cache.get_block(0, 0, blk), true); // 1 is now the oldest
+  cache.add_block(3, 0, test_block_cache_block(3));
+  TEST("block 1 discarded", cache.contains(1, 0), false);
+  TEST("block 0 kept", cache.contains(0, 0), true);
+  TEST("block 2 kept", cache.contains(2, 0), true);
+  TEST("block 3 kept", cache.contains(3, 0), true);
+
+  cache.add_block(2, 0, test_block_cache_block(7));
+  TEST("replaced block", cache.get_block(2, 0, blk) &&
+       vil_image_view<vxl_byte>(blk)(0,0) == 7, true);
+  TEST("still 3 blocks", cache.stats().n_blocks, 3);
+
+  vil_block_cache_stats s = cache.stats();
+  TEST("hits", s.hits, 2);
+  TEST("misses", s.misses, 0);
+  TEST("evictions", s.evictions, 1);
+  cache.get_block(1, 0, blk);
+  TEST("miss counted", cache.stats().misses, 1);
+  TEST("peek is not counted", cache.peek_block(0, 0, blk) && cache.stats().hits == 2, true);
+  cache.reset_stats();
+  TEST("reset_stats", cache.stats().hits + cache.stats().misses, 0);
+
+  TEST("remove_block", cache.remove_block(0, 0) && !cache.contains(0, 0), true);
+  cache.clear();
+  TEST("clear", cache.stats().n_blocks == 0 && cache.stats().n_bytes == 0, true);
+}
+
+static void test_block_cache_bytes()
+{
+  std::cout << "A byte limit on the cache\n";
+  const std::size_t block_bytes = 16*16;
+  vil_block_cache cache(100, 4*block_bytes + 10, 1);
+  for (unsigned bi = 0; bi < 10; ++bi)
+    cache.add_block(bi, 0, test_block_cache_block(bi));
+  vil_block_cache_stats s = cache.stats();
+  TEST("block_bytes", vil_block_cache::block_bytes(*test_block_cache_block(0)), block_bytes);
+  TEST("4 blocks fit", s.n_blocks, 4);
+  TEST("bytes held", s.n_bytes, 4*block_bytes);
+  TEST("evictions", s.evictions, 6);
+  TEST("newest kept", cache.contains(9, 0) && cache.contains(6, 0) && !cache.contains(5, 0), true);
+
+  std::cout << "Several shards\n";
+  vil_block_cache sharded(64, 0, 4);
+  TEST("n_shards", sharded.n_shards(), 4);
+  for (unsigned bj = 0; bj < 16; ++bj)
+    for (unsigned bi = 0; bi < 16; ++bi)
+      sharded.add_block(bi, bj, test_block_cache_block(bi));
+  TEST("no more than the capacity", sharded.stats().n_blocks <= 64, true);
+  TEST("most recent kept", sharded.contains(15, 15), true);
+  TEST("oldest discarded", sharded.contains(0, 0), false);
+}
+
+//: Check that a block of the cached resource has the original pixels.
+static bool test_block_cache_check(vil_blocked_image_resource_sptr const& r,
+                                   vil_image_view<vxl_byte> const& image,
+                                   unsigned bi, unsigned bj)
+{
+  vil_image_view<vxl_byte> blk = r->get_block(bi, bj);
+  if (!blk) return false;
+  const unsigned i0 = bi*r->size_block_i(), j0 = bj*r->size_block_j();
+  for (unsigned j = 0; j < blk.nj(); ++j)
+    for (unsigned i = 0; i < blk.ni(); ++i)
+      if (i0+i < image.ni() && j0+j < image.nj() && blk(i,j) != image(i0+i, j0+j))
+        return false;
+  return true;
+}
+
+static void test_block_cache_resource()
+{
+  std::cout << "Cached image resource\n";
+  vil_image_view<vxl_byte> image(256, 192);
+  for (unsigned j = 0; j < image.nj(); ++j)
+    for (unsigned i = 0; i < image.ni(); ++i)
+      image(i,j) = vxl_byte(i*3 + j*7);
+  vil_blocked_image_resource_sptr facade =
+    vil_new_blocked_image_facade(vil_new_image_resource_of_view(image), 32, 32);
+  vil_cached_image_resource* cached = new vil_cached_image_resource(facade, 16, 12*32*32);
+  vil_blocked_image_resource_sptr r = cached;
+
+  bool ok = true;
+  for (unsigned bj = 0; bj < r->n_block_j(); ++bj)
+    for (unsigned bi = 0; bi < r->n_block_i(); ++bi)
+      ok = ok && test_block_cache_check(r, image, bi, bj);
+  TEST("blocks correct", ok, true);
+  vil_block_cache_stats s = cached->cache_stats();
+  TEST("byte limit kept", s.n_bytes <= 12*32*32 && s.n_blocks <= 12, true);
+  TEST("every block missed once", s.misses, r->n_block_i()*r->n_block_j());
+
+  vil_image_view<vxl_byte> patch(32, 32);
+  patch.fill(5);
+  r->put_block(r->n_block_i()-1, r->n_block_j()-1, patch);
+  vil_image_view<vxl_byte> blk = r->get_block(r->n_block_i()-1, r->n_block_j()-1);
+  TEST("put_block replaces the cached block", blk && blk(0,0) == 5, true);
+  // so that the checks below still hold
+  for (unsigned j = image.nj()-32; j < image.nj(); ++j)
+    for (unsigned i = image.ni()-32; i < image.ni(); ++i)
+      image(i,j) = 5;
+
+  std::cout << "Read ahead\n";
+  vil_cached_image_resource* ahead = new vil_cached_image_resource(facade, 32);
+  vil_blocked_image_resource_sptr ra = ahead;
+  ahead->set_read_ahead(3);
+  TEST("read_ahead", ahead->read_ahead(), 3);
+  test_block_cache_check(ra, image, 0, 1);
+#if VXL_FULLCXX11SUPPORT
+  for (unsigned k = 0; k < 1000 && ahead->cache_stats().n_blocks < 4; ++k)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+  TEST("following blocks read ahead", ahead->cache_stats().n_blocks, 4);
+  const unsigned long hits = ahead->cache_stats().hits;
+  ok = test_block_cache_check(ra, image, 1, 1) && test_block_cache_check(ra, image, 3, 1);
+  TEST("read ahead blocks correct", ok, true);
+  TEST("read ahead blocks are hits", ahead->cache_stats().hits - hits, 2);
+
+#if VXL_FULLCXX11SUPPORT
+  std::cout << "Several threads sharing a small cache\n";
+  cached->set_read_ahead(2);
+  const unsigned n_threads = 4;
+  std::vector<int> good(n_threads, 1);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < n_threads; ++t)
+    threads.push_back(std::thread([&, t]() {
+      for (unsigned pass = 0; pass < 20; ++pass)
+        for (unsigned bj = 0; bj < r->n_block_j(); ++bj)
+          for (unsigned bi = 0; bi < r->n_block_i(); ++bi)
+          {
+            // each thread walks the blocks in a different order
+            const unsigned i = (bi + t*3) % r->n_block_i();
+            const unsigned j = (bj + t + pass) % r->n_block_j();
+            if (!test_block_cache_check(r, image, i, j))
+              good[t] = 0;
+          }
+    }));
+  for (unsigned t = 0; t < n_threads; ++t)
+    threads[t].join();
+  ok = true;
+  for (unsigned t = 0; t < n_threads; ++t)
+    ok = ok && good[t] != 0;
+  TEST("blocks correct in every thread", ok, true);
+  s = cached->cache_stats();
+  TEST("limits kept", s.n_blocks <= 16 && s.n_bytes <= 12*32*32, true);
+  std::cout << "hits " << s.hits << " misses " << s.misses
+            << " evictions " << s.evictions << '\n';
+#endif
+}
+
+static void test_block_cache()
+{
+  test_block_cache_lru();
+  test_block_cache_bytes();
+  test_block_cache_resource();
+}
+
+TESTMAIN(test_block_cache);
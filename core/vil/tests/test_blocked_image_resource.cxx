@@ -11,10 +11,97 @@
 #include <vil/vil_image_view.h>
 #include <vil/vil_blocked_image_resource.h>
 #include <vil/vil_block_cache.h>
+#include <vil/vil_parallel.h>
+#include <vil/file_formats/vil_tiff.h>
 #include <vul/vul_file.h>
 
 static std::string image_file;
 static bool exists;
+
+//: Write image to a compressed tiff file using n_threads, tiled unless sbi==0.
+template <class T>
+static bool test_compressed_tiff_write(std::string const& path,
+                                       vil_image_view<T> const& image,
+                                       vil_tiff_image::compression_methods cm,
+                                       unsigned sbi, unsigned sbj,
+                                       unsigned n_threads)
+{
+  vil_parallel_set_max_threads(n_threads);
+  vil_image_resource_sptr r;
+  if (sbi == 0) // strips
+    r = vil_new_image_resource(path.c_str(), image.ni(), image.nj(), image.nplanes(),
+                               image.pixel_format(), "tiff");
+  else
+    r = vil_new_blocked_image_resource(path.c_str(), image.ni(), image.nj(), image.nplanes(),
+                                       image.pixel_format(), sbi, sbj, "tiff").ptr();
+  if (!r || std::string(r->file_format()) != "tiff")
+    return false;
+  vil_tiff_image* ti = static_cast<vil_tiff_image*>(r.ptr());
+  return ti->set_compression_method(cm) && r->put_view(image);
+}
+
+//: Read a whole tiff file using n_threads, and compare it with image.
+template <class T>
+static bool test_compressed_tiff_read(std::string const& path,
+                                      vil_image_view<T> const& image,
+                                      unsigned n_threads)
+{
+  vil_parallel_set_max_threads(n_threads);
+  vil_image_resource_sptr r = vil_load_image_resource(path.c_str());
+  if (!r)
+    return false;
+  vil_image_view<T> v = r->get_view();
+  if (!v || v.ni() != image.ni() || v.nj() != image.nj() || v.nplanes() != image.nplanes())
+    return false;
+  for (unsigned p = 0; p<image.nplanes(); ++p)
+    for (unsigned j = 0; j<image.nj(); ++j)
+      for (unsigned i = 0; i<image.ni(); ++i)
+        if (v(i,j,p) != image(i,j,p))
+          return false;
+  return true;
+}
+
+//: Compressed blocks written and read on one thread and on several.
+template <class T>
+static void test_compressed_tiff(vil_image_view<T> const& image,
+                                 vil_tiff_image::compression_methods cm,
+                                 unsigned sbi, unsigned sbj, char const* name)
+{
+  std::cout << "Compressed tiff, " << name << '\n';
+  std::string path1("test_compressed_tiff1.tif"), path4("test_compressed_tiff4.tif");
+  TEST("write on one thread",
+       test_compressed_tiff_write(path1, image, cm, sbi, sbj, 1), true);
+  TEST("write on four threads",
+       test_compressed_tiff_write(path4, image, cm, sbi, sbj, 4), true);
+  TEST("read on one thread what was written on one",
+       test_compressed_tiff_read(path1, image, 1), true);
+  TEST("read on one thread what was written on four",
+       test_compressed_tiff_read(path4, image, 1), true);
+  TEST("read on four threads what was written on one",
+       test_compressed_tiff_read(path1, image, 4), true);
+  TEST("same compressed size",
+       vul_file::size(path1) == vul_file::size(path4), true);
+  vil_parallel_set_max_threads(0);
+  vpl_unlink(path1.c_str());
+  vpl_unlink(path4.c_str());
+}
+
+static void test_compressed_tiffs()
+{
+  vil_image_view<unsigned short> grey(300, 170);
+  for (unsigned j = 0; j<grey.nj(); ++j)
+    for (unsigned i = 0; i<grey.ni(); ++i)
+      grey(i,j) = (unsigned short)((i*i + 37*j) % 4099);
+  vil_image_view<vxl_byte> rgb(211, 130, 1, 3); // interleaved
+  for (unsigned p = 0; p<rgb.nplanes(); ++p)
+    for (unsigned j = 0; j<rgb.nj(); ++j)
+      for (unsigned i = 0; i<rgb.ni(); ++i)
+        rgb(i,j,p) = vxl_byte((i/8 + j/4)*(p+1));
+  test_compressed_tiff(grey, vil_tiff_image::DEFLATE, 64, 32, "deflate tiles");
+  test_compressed_tiff(rgb, vil_tiff_image::LZW, 32, 48, "LZW rgb tiles");
+  test_compressed_tiff(rgb, vil_tiff_image::PACKBITS, 64, 64, "packbits rgb tiles");
+  test_compressed_tiff(grey, vil_tiff_image::ADOBE_DEFLATE, 0, 0, "deflate strips");
+}
 static void test_blocked_image_resource()
 {
   std::cout << "************************************\n"
@@ -358,6 +445,7 @@ test_blocked_image_resource_main( int argc, char* argv[] )
   image_file += "/";
   std::cout << "Start test process\n";
   test_blocked_image_resource();
+  test_compressed_tiffs();
   return 0;
 }
 
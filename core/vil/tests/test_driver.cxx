@@ -25,14 +25,17 @@ DECLARE( test_rotate_image );
 DECLARE( test_warp );
 DECLARE( test_math_value_range );
 DECLARE( test_blocked_image_resource );
+DECLARE( test_block_cache );
 DECLARE( test_pyramid_image_resource );
 DECLARE( test_image_list );
 DECLARE( test_border );
 DECLARE( test_4_plane_tiff );
+DECLARE( test_mapped_image_resource );
 DECLARE( test_math_median );
 DECLARE( test_round );
 DECLARE( test_pyramid_image_view );
 DECLARE( test_na );
+DECLARE( test_parallel );
 
 void
 register_tests()
@@ -62,14 +65,17 @@ register_tests()
   REGISTER( test_warp );
   REGISTER( test_math_value_range );
   REGISTER( test_blocked_image_resource );
+  REGISTER( test_block_cache );
   REGISTER( test_pyramid_image_resource );
   REGISTER( test_image_list );
   REGISTER( test_border );
   REGISTER( test_4_plane_tiff );
+  REGISTER( test_mapped_image_resource );
   REGISTER( test_math_median );
   REGISTER( test_round );
   REGISTER( test_pyramid_image_view );
   REGISTER( test_na );
+  REGISTER( test_parallel );
 }
 
 DEFINE_MAIN;
@@ -29,13 +29,18 @@
 #include <vil/vil_image_view.h>
 #include <vil/vil_image_view_base.h>
 #include <vil/vil_load.h>
+#include <vil/vil_mapped_image_resource.h>
+#include <vil/vil_mapped_memory_chunk.h>
 #include <vil/vil_math.h>
+#include <vil/vil_memory_allocator.h>
 #include <vil/vil_memory_chunk.h>
 #include <vil/vil_memory_image.h>
+#include <vil/vil_memory_pool.h>
 #include <vil/vil_nearest_interp.h>
 #include <vil/vil_new.h>
 #include <vil/vil_na.h>
 #include <vil/vil_open.h>
+#include <vil/vil_parallel.h>
 #include <vil/vil_pixel_format.h>
 #include <vil/vil_plane.h>
 #include <vil/vil_print.h>
@@ -0,0 +1,219 @@
+// This is core/vil/tests/test_mapped_image_resource.cxx
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <vcl_compiler.h>
+#include <vxl_config.h>
+#include <testlib/testlib_test.h>
+#include <testlib/testlib_root_dir.h>
+#include <vul/vul_file.h>
+#include <vul/vul_temp_filename.h>
+#include <vpl/vpl.h>
+#include <vil/vil_load.h>
+#include <vil/vil_save.h>
+#include <vil/vil_image_view.h>
+#include <vil/vil_mapped_image_resource.h>
+#include <vil/vil_mapped_memory_chunk.h>
+#include <vil/vil_property.h>
+//:
+// \file
+// \brief Check that mapped image resources see the same pixels as the ordinary ones.
+
+template <class T>
+static vil_image_view<T> test_mapped_image(unsigned ni, unsigned nj, unsigned nplanes)
+{
+  vil_image_view<T> im(ni, nj, nplanes);
+  for (unsigned p = 0; p < nplanes; ++p)
+    for (unsigned j = 0; j < nj; ++j)
+      for (unsigned i = 0; i < ni; ++i)
+        im(i,j,p) = T((i*7 + j*13 + p*51) % 200 + 1);
+  return im;
+}
+
+//: Load filename both ways, and compare.
+template <class T>
+static void test_mapped_file(std::string const& filename, char const* name, bool expect_mapped)
+{
+  std::cout << name << '\n';
+  vil_image_resource_sptr ref = vil_load_image_resource(filename.c_str());
+  vil_image_resource_sptr mapped = vil_load_image_resource_mapped(filename.c_str());
+  if (!ref || !mapped)
+  {
+    TEST("loaded", false, true);
+    return;
+  }
+  const bool is_mapped = dynamic_cast<vil_mapped_image_resource*>(mapped.ptr()) != VXL_NULLPTR;
+  TEST("mapped if uncompressed and in host byte order", is_mapped, expect_mapped);
+  TEST("same file format", std::string(mapped->file_format()), std::string(ref->file_format()));
+
+  vil_image_view<T> a = ref->get_view();
+  vil_image_view<T> b = mapped->get_view();
+  TEST("whole image the same", vil_image_view_deep_equality(a, b), true);
+
+  const unsigned i0 = ref->ni()/3, j0 = ref->nj()/4;
+  const unsigned ni = ref->ni()/2, nj = ref->nj()/2;
+  vil_image_view<T> wa = ref->get_view(i0, ni, j0, nj);
+  vil_image_view<T> wb = mapped->get_view(i0, ni, j0, nj);
+  vil_image_view<T> wc = mapped->get_copy_view(i0, ni, j0, nj);
+  TEST("window the same", vil_image_view_deep_equality(wa, wb), true);
+  TEST("copied window the same", vil_image_view_deep_equality(wa, wc), true);
+  if (!is_mapped)
+    return;
+
+  TEST("read only", mapped->get_property(vil_property_read_only), true);
+  TEST("view is of the mapped file",
+       dynamic_cast<vil_mapped_memory_chunk*>(b.memory_chunk().ptr()) != VXL_NULLPTR, true);
+  TEST("copied view is not", wc.memory_chunk() == b.memory_chunk(), false);
+  TEST("put_view refused", mapped->put_view(a, 0, 0), false);
+
+  // Writing into the view must not change the file.
+  b.fill(T(0));
+  vil_image_view<T> again = vil_load_image_resource(filename.c_str())->get_view();
+  TEST("file unchanged by writing to the view", vil_image_view_deep_equality(a, again), true);
+}
+
+template <class T>
+static void test_mapped_save_load(vil_image_view<T> const& im, char const* extension,
+                                  char const* name, bool expect_mapped)
+{
+  std::string filename = vul_temp_filename() + extension;
+  if (!vil_save(im, filename.c_str()))
+  {
+    std::cout << "Could not save " << filename << '\n';
+    TEST("saved", false, true);
+    return;
+  }
+  test_mapped_file<T>(filename, name, expect_mapped);
+  vpl_unlink(filename.c_str());
+}
+
+//: Append the size lowest bytes of v to b, in the given byte order.
+static void put_bytes(std::vector<unsigned char>& b, vxl_uint_32 v, unsigned size, bool little_endian)
+{
+  for (unsigned k = 0; k < size; ++k)
+    b.push_back(static_cast<unsigned char>(v >> (8*(little_endian ? k : size-1-k))));
+}
+
+//: Write a one-strip 16 bit TIFF, in the host's byte order, whose pixels start at an odd offset.
+static bool write_odd_offset_tiff(std::string const& filename, vil_image_view<vxl_uint_16> const& im)
+{
+  const bool little_endian = VXL_LITTLE_ENDIAN != 0;
+  const unsigned n_entries = 10;
+  const vxl_uint_32 data_offset = 8 + 2 + n_entries*12 + 4 + 1;
+  std::vector<unsigned char> bytes;
+  bytes.push_back(little_endian ? 'I' : 'M');
+  bytes.push_back(little_endian ? 'I' : 'M');
+  put_bytes(bytes, 42, 2, little_endian);
+  put_bytes(bytes, 8, 4, little_endian);
+  put_bytes(bytes, n_entries, 2, little_endian);
+  const vxl_uint_32 tags[n_entries][3] = { // tag, type (3 short, 4 long), value
+    { 256, 4, im.ni() }, { 257, 4, im.nj() }, { 258, 3, 16 }, { 259, 3, 1 },
+    { 262, 3, 1 }, { 273, 4, data_offset }, { 277, 3, 1 }, { 278, 4, im.nj() },
+    { 279, 4, 2*im.ni()*im.nj() }, { 284, 3, 1 } };
+  for (unsigned e = 0; e < n_entries; ++e)
+  {
+    put_bytes(bytes, tags[e][0], 2, little_endian);
+    put_bytes(bytes, tags[e][1], 2, little_endian);
+    put_bytes(bytes, 1, 4, little_endian);
+    put_bytes(bytes, tags[e][2], tags[e][1] == 3 ? 2 : 4, little_endian);
+    if (tags[e][1] == 3)
+      put_bytes(bytes, 0, 2, little_endian);
+  }
+  put_bytes(bytes, 0, 4, little_endian);
+  bytes.push_back(0);
+  for (unsigned j = 0; j < im.nj(); ++j)
+    for (unsigned i = 0; i < im.ni(); ++i)
+      put_bytes(bytes, im(i,j), 2, little_endian);
+
+  std::ofstream os(filename.c_str(), std::ios::out | std::ios::binary);
+  os.write(reinterpret_cast<const char*>(&bytes[0]), bytes.size());
+  return bool(os);
+}
+
+//: Number of mappings of files whose names contain name, or -1 if unknown.
+static int count_mappings(std::string const& name)
+{
+  std::ifstream maps("/proc/self/maps");
+  if (!maps)
+    return -1;
+  int n = 0;
+  std::string line;
+  while (std::getline(maps, line))
+    if (line.find(name) != std::string::npos)
+      ++n;
+  return n;
+}
+
+//: Check that mappings are released with the last reference to them.
+static void test_mapped_release()
+{
+  vil_image_view<vxl_byte> im = test_mapped_image<vxl_byte>(37, 23, 1);
+  std::string filename = vul_temp_filename() + ".pgm";
+  vil_save(im, filename.c_str());
+  const std::string name = vul_file::strip_directory(filename);
+  if (count_mappings(name) < 0)
+  {
+    std::cout << "Cannot count mappings on this platform\n";
+    vpl_unlink(filename.c_str());
+    return;
+  }
+  {
+    std::vector<vil_memory_chunk_sptr> chunks;
+    for (unsigned k = 0; k < 3; ++k)
+      chunks.push_back(new vil_mapped_memory_chunk(filename.c_str(), VIL_PIXEL_FORMAT_BYTE));
+    vil_image_resource_sptr mapped = vil_load_image_resource_mapped(filename.c_str());
+    vil_image_view<vxl_byte> view = mapped->get_view();
+    TEST("file mapped once for each chunk and resource", count_mappings(name), 4);
+  }
+  TEST("mappings released", count_mappings(name), 0);
+  vpl_unlink(filename.c_str());
+}
+
+static void test_mapped_image_resource(int argc, char* argv[])
+{
+  const bool little_endian = VXL_LITTLE_ENDIAN != 0;
+
+  test_mapped_save_load(test_mapped_image<vxl_byte>(37, 23, 1), ".pgm", "pgm, bytes", true);
+  test_mapped_save_load(test_mapped_image<vxl_byte>(37, 23, 3), ".ppm", "ppm, bytes", true);
+  test_mapped_save_load(test_mapped_image<vxl_uint_16>(37, 23, 1), ".pgm", "pgm, 16 bit", !little_endian);
+  test_mapped_save_load(test_mapped_image<vxl_byte>(37, 23, 1), ".bmp", "bmp, 8 bit", true);
+  test_mapped_save_load(test_mapped_image<vxl_byte>(37, 23, 3), ".bmp", "bmp, 24 bit", true);
+  test_mapped_save_load(test_mapped_image<vxl_byte>(37, 23, 3), ".tif", "tiff, bytes", true);
+  test_mapped_save_load(test_mapped_image<vxl_uint_16>(37, 23, 1), ".tif", "tiff, 16 bit", true);
+  test_mapped_save_load(test_mapped_image<float>(37, 23, 1), ".tif", "tiff, float", true);
+  test_mapped_save_load(test_mapped_image<vxl_byte>(37, 23, 3), ".jpg", "jpeg (not mapped)", false);
+
+  // Pixels which are not aligned in the file are read rather than used in place.
+  {
+    vil_image_view<vxl_uint_16> im = test_mapped_image<vxl_uint_16>(37, 23, 1);
+    std::string filename = vul_temp_filename() + ".tif";
+    TEST("write tiff with odd pixel offset", write_odd_offset_tiff(filename, im), true);
+    test_mapped_file<vxl_uint_16>(filename, "tiff, 16 bit at an odd offset", false);
+    vil_image_resource_sptr mapped = vil_load_image_resource_mapped(filename.c_str());
+    TEST("pixels at an odd offset", mapped && vil_image_view_deep_equality(
+           vil_image_view<vxl_uint_16>(mapped->get_view()), im), true);
+    vpl_unlink(filename.c_str());
+  }
+
+  test_mapped_release();
+
+  std::string image_base;
+  if (argc >= 2)
+    image_base = argv[1];
+  else
+    image_base = testlib_root_dir() + "/core/vil/tests/file_read_data";
+  if (!vul_file::is_directory(image_base))
+    return;
+  image_base += "/";
+  // Images in several blocks have no single regular layout.
+  test_mapped_file<vxl_byte>(image_base + "ff_nitf_8bit_p.nitf", "nitf, IMODE=P, 2x2 blocks", false);
+  test_mapped_file<vxl_byte>(image_base + "ff_nitf_8bit_b.nitf", "nitf, IMODE=B, 2x2 blocks", false);
+  // NITF stores its pixels big-endian.
+  test_mapped_file<vxl_uint_16>(image_base + "ff_grey16bit_uncompressed.nitf", "nitf, 16 bit", !little_endian);
+  test_mapped_file<float>(image_base + "ff_nitf_float.nitf", "nitf, float", !little_endian);
+  // Compressed.
+  test_mapped_file<vxl_byte>(image_base + "p0_12a.ntf", "nitf, compressed", false);
+}
+
+TESTMAIN_ARGS(test_mapped_image_resource);
@@ -3,8 +3,10 @@
 #include <testlib/testlib_test.h>
 #include <vcl_compiler.h>
 #include <vil/vil_memory_chunk.h>
+#include <vil/vil_memory_pool.h>
+#include <vil/vil_image_view.h>
 
-static void test_memory_chunk()
+static void test_memory_chunk_basics()
 {
   std::cout << "**************************\n"
            << " Testing vil_memory_chunk\n"
@@ -28,4 +30,78 @@ static void test_memory_chunk()
   TEST_NEAR("Deep Copy",data1[3],data2[3],1e-8);
 }
 
+static void test_memory_pool()
+{
+  std::cout << "*************************\n"
+           << " Testing vil_memory_pool\n"
+           << "*************************\n";
+
+  vil_memory_pool pool(1<<20, 1024, 64);
+  TEST("block_size of a small request", pool.block_size(100), 100);
+  TEST("block_size rounds up to a size class", pool.block_size(5000), 5120);
+  TEST("block_size of an exact class", pool.block_size(4096), 4096);
+
+  void* p = pool.allocate(5000);
+  TEST("aligned", reinterpret_cast<std::size_t>(p) % 64, 0);
+  pool.deallocate(p, 5000);
+  void* q = pool.allocate(4900); // same size class
+  TEST("block reused", q, p);
+  vil_memory_pool_stats stats = pool.stats();
+  TEST("hits", stats.hits, 1);
+  TEST("misses", stats.misses, 1);
+  TEST("returns", stats.returns, 1);
+  TEST("bytes_in_use", stats.bytes_in_use, 5120);
+  TEST("bytes_cached", stats.bytes_cached, 0);
+  pool.deallocate(q, 4900);
+
+  void* small = pool.allocate(100);
+  pool.deallocate(small, 100);
+  stats = pool.stats();
+  TEST("small blocks not kept", stats.returns == 2 && stats.misses == 2, true);
+
+  // Blocks beyond the budget are returned to the system.
+  void* big[3];
+  for (unsigned i = 0; i < 3; ++i)
+    big[i] = pool.allocate(400000);
+  for (unsigned i = 0; i < 3; ++i)
+    pool.deallocate(big[i], 400000);
+  stats = pool.stats();
+  TEST("budget respected", stats.bytes_cached <= (1<<20), true);
+  TEST("excess discarded", stats.discards > 0, true);
+  pool.set_max_cached_bytes(0);
+  TEST("set_max_cached_bytes(0) empties the pool", pool.stats().bytes_cached, 0);
+  pool.set_max_cached_bytes(1<<20);
+
+  // Images of the same size, made one after another, share their storage.
+  pool.reset_stats();
+  vil_memory_chunk::set_default_allocator(&pool);
+  const void* first = VXL_NULLPTR;
+  bool same = true;
+  for (unsigned frame = 0; frame < 5; ++frame)
+  {
+    vil_image_view<float> im(64, 48, 3);
+    im.fill(float(frame));
+    if (frame == 0) first = im.top_left_ptr();
+    same = same && im.top_left_ptr() == first;
+  }
+  TEST("image storage recycled", same, true);
+  stats = pool.stats();
+  TEST("frames after the first are hits", stats.hits == 4 && stats.misses == 1, true);
+  TEST("all returned", stats.bytes_in_use, 0);
+
+  vil_memory_chunk chunk(2000, VIL_PIXEL_FORMAT_BYTE);
+  TEST("chunk records its allocator", chunk.allocator(), &pool);
+  const std::size_t cached = pool.stats().bytes_cached;
+  vil_memory_chunk::set_default_allocator(VXL_NULLPTR);
+  chunk.set_size(3000, VIL_PIXEL_FORMAT_BYTE);
+  TEST("resized chunk uses the new default", chunk.allocator() == &pool, false);
+  TEST("old block went back to its pool", pool.stats().bytes_cached, cached + pool.block_size(2000));
+}
+
+static void test_memory_chunk()
+{
+  test_memory_chunk_basics();
+  test_memory_pool();
+}
+
 TESTMAIN(test_memory_chunk);
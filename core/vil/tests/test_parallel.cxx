@@ -0,0 +1,88 @@
+// This is core/vil/tests/test_parallel.cxx
+#include <iostream>
+#include <vector>
+#include <vcl_compiler.h>
+#include <testlib/testlib_test.h>
+#include <vil/vil_parallel.h>
+
+//: Counts how often each index is run.  An outer job also runs an inner job from some indices.
+class test_parallel_count_job : public vil_parallel_job
+{
+ public:
+  std::vector<int> count;
+  std::vector<int> inner_total;
+  bool outer;
+  test_parallel_count_job(unsigned n, bool is_outer) : count(n, 0), inner_total(n, 0), outer(is_outer) {}
+  void run(unsigned k) VXL_OVERRIDE
+  {
+    ++count[k];
+    if (outer && k % 7 == 0)
+    {
+      test_parallel_count_job inner(5, false);
+      vil_parallel_run(inner, 5);
+      for (unsigned i = 0; i < 5; ++i)
+        inner_total[k] += inner.count[i];
+    }
+  }
+};
+
+static void test_run(unsigned n, unsigned n_threads)
+{
+  test_parallel_count_job job(n, true);
+  vil_parallel_run(job, n, n_threads);
+  bool once = true, nested = true;
+  for (unsigned k = 0; k < n; ++k)
+  {
+    once = once && job.count[k] == 1;
+    nested = nested && job.inner_total[k] == (k % 7 == 0 ? 5 : 0);
+  }
+  std::cout << n << " indices on " << n_threads << " threads\n";
+  TEST("each index run once", once, true);
+  TEST("nested jobs run in full", nested, true);
+}
+
+static void test_bands(unsigned nj, unsigned halo, unsigned n_bands)
+{
+  std::vector<vil_parallel_band> bands;
+  vil_parallel_row_bands(nj, halo, n_bands, bands);
+  bool ok = bands.size() == (n_bands < nj ? n_bands : nj);
+  unsigned next = 0;
+  for (unsigned b = 0; b < bands.size(); ++b)
+  {
+    const vil_parallel_band& band = bands[b];
+    ok = ok && band.j0 == next && band.j1 > band.j0
+            && band.c0 == (band.j0 > halo ? band.j0 - halo : 0)
+            && band.c1 == (band.j1 + halo < nj ? band.j1 + halo : nj);
+    next = band.j1;
+  }
+  std::cout << nj << " rows, halo " << halo << ", " << n_bands << " bands\n";
+  TEST("bands cover the rows in order", ok && next == nj, true);
+}
+
+static void test_parallel()
+{
+  test_run(0, 4);
+  test_run(1, 4);
+  test_run(100, 1);
+  test_run(100, 3);
+  test_run(1000, 8);
+  test_run(1000, 0);
+
+  test_bands(100, 0, 1);
+  test_bands(100, 2, 3);
+  test_bands(101, 5, 8);
+  test_bands(3, 1, 8);
+
+  TEST("bands no smaller than min_band_rows", vil_parallel_n_bands(100, 0, vil_parallel_policy(8, 30)), 3);
+  TEST("bands no smaller than 2*halo+1", vil_parallel_n_bands(100, 10, vil_parallel_policy(8, 1)), 4);
+  TEST("no more bands than threads", vil_parallel_n_bands(1000, 1, vil_parallel_policy(8, 1)), 8);
+  TEST("at least one band", vil_parallel_n_bands(5, 3, vil_parallel_policy(8, 1)), 1);
+
+  const unsigned max_threads = vil_parallel_max_threads();
+  vil_parallel_set_max_threads(3);
+  TEST("set_max_threads", vil_parallel_max_threads(), 3);
+  vil_parallel_set_max_threads(0);
+  TEST("set_max_threads(0) restores the default", vil_parallel_max_threads(), max_threads);
+}
+
+TESTMAIN(test_parallel);
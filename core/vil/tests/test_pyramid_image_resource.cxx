@@ -5,6 +5,7 @@
 //
 #include <iostream>
 #include <string>
+#include <vector>
 #include <testlib/testlib_test.h>
 #include <testlib/testlib_root_dir.h>
 #include <vcl_compiler.h>
@@ -32,6 +33,108 @@
 #endif
 #define DEBUG
 
+//: Make levels 1 to nlevels of brsc both level by level and all at once, and compare.
+template <class T>
+static void test_pyramid_decimate_levels(vil_blocked_image_resource_sptr const& brsc,
+                                         unsigned nlevels, std::string const& name)
+{
+  std::vector<vil_blocked_image_resource_sptr> one_by_one, all_at_once;
+  unsigned ni = brsc->ni(), nj = brsc->nj();
+  for (unsigned L = 0; L<nlevels; ++L)
+  {
+    ni = (ni+1)/2; nj = (nj+1)/2;
+    for (unsigned k = 0; k<2; ++k)
+    {
+      vil_image_resource_sptr mem =
+        vil_new_image_resource(ni, nj, brsc->nplanes(), brsc->pixel_format());
+      (k ? all_at_once : one_by_one).push_back(
+        vil_new_blocked_image_facade(mem, brsc->size_block_i(), brsc->size_block_j()));
+    }
+  }
+  bool good = true;
+  vil_blocked_image_resource_sptr above = brsc;
+  for (unsigned L = 0; L<nlevels; ++L)
+  {
+    good = good && vil_pyramid_image_resource::blocked_decimate(above, one_by_one[L]);
+    above = one_by_one[L];
+  }
+  good = good && vil_pyramid_image_resource::blocked_decimate_levels(brsc, all_at_once);
+  TEST(("decimate levels at once, " + name).c_str(), good, true);
+  for (unsigned L = 0; L<nlevels && good; ++L)
+  {
+    vil_image_view<T> a = one_by_one[L]->get_view(), b = all_at_once[L]->get_view();
+    good = vil_image_view_deep_equality(a, b);
+  }
+  TEST(("same levels as one by one, " + name).c_str(), good, true);
+}
+
+static void test_pyramid_decimate_levels()
+{
+  vil_image_view<vxl_byte> rgb(256, 192, 3);
+  for (unsigned p = 0; p<3; ++p)
+    for (unsigned j = 0; j<rgb.nj(); ++j)
+      for (unsigned i = 0; i<rgb.ni(); ++i)
+        rgb(i,j,p) = static_cast<vxl_byte>((i*i + 3*j + 50*p) % 251);
+  test_pyramid_decimate_levels<vxl_byte>(
+    vil_new_blocked_image_facade(vil_new_image_resource_of_view(rgb), 16, 16), 4, "rgb bytes");
+
+  vil_image_view<unsigned short> grey(320, 64);
+  for (unsigned j = 0; j<grey.nj(); ++j)
+    for (unsigned i = 0; i<grey.ni(); ++i)
+      grey(i,j) = static_cast<unsigned short>(i*j + 7*i);
+  test_pyramid_decimate_levels<unsigned short>(
+    vil_new_blocked_image_facade(vil_new_image_resource_of_view(grey), 32, 16), 3, "grey");
+
+  {
+    std::vector<vil_blocked_image_resource_sptr> odd_blocks(1,
+      vil_new_blocked_image_facade(vil_new_image_resource(160, 32, 1, VIL_PIXEL_FORMAT_UINT_16), 15, 16));
+    TEST("odd block size rejected",
+         vil_pyramid_image_resource::blocked_decimate_levels(
+           vil_new_blocked_image_facade(vil_new_image_resource_of_view(grey), 15, 16), odd_blocks),
+         false);
+  }
+
+  // Levels of odd size: 144x80 gives 9x5 and then 5x3, whose last column
+  // and row come from beyond the edge of the 9x5 image.  The tiff files
+  // keep whole blocks, so that agrees too.
+  vil_image_view<unsigned short> odd(144, 80);
+  for (unsigned j = 0; j<odd.nj(); ++j)
+    for (unsigned i = 0; i<odd.ni(); ++i)
+      odd(i,j) = static_cast<unsigned short>(i*3 + j*j);
+  vil_image_resource_sptr base =
+    new vil_blocked_image_facade(vil_new_image_resource_of_view(odd), 16, 16);
+  const unsigned nlevels = 5;
+  std::vector<std::string> files, files1;
+  for (unsigned L = 1; L<=nlevels; ++L)
+  {
+    files.push_back("dec_levels_" + std::string(1, char('0'+L)) + ".tif");
+    files1.push_back("dec_level_" + std::string(1, char('0'+L)) + ".tif");
+  }
+  bool good = true;
+  {
+    std::vector<vil_image_resource_sptr> levels =
+      vil_pyramid_image_resource::decimate_levels(base, files);
+    good = levels.size() == nlevels;
+    vil_image_resource_sptr above = base;
+    for (unsigned L = 0; L<nlevels && good; ++L)
+    {
+      above = vil_pyramid_image_resource::decimate(above, files1[L].c_str());
+      good = above && above->ni() == levels[L]->ni() && above->nj() == levels[L]->nj();
+      if (good)
+      {
+        vil_image_view<unsigned short> a = above->get_view(), b = levels[L]->get_view();
+        good = vil_image_view_deep_equality(a, b);
+      }
+    }
+  }
+  TEST("decimate_levels files same as decimate, odd sizes", good, true);
+  for (unsigned L = 0; L<files.size(); ++L)
+  {
+    vpl_unlink(files[L].c_str());
+    vpl_unlink(files1[L].c_str());
+  }
+}
+
 static void test_pyramid_image_resource( int argc, char* argv[] )
 {
   std::string image_base; // = "core/vil/tests/file_read_data/";
@@ -46,6 +149,7 @@ static void test_pyramid_image_resource( int argc, char* argv[] )
   std::cout << "************************************\n"
            << " Testing vil_pyramid_image_resource\n"
            << "************************************\n";
+  test_pyramid_decimate_levels();
   //Test Resource
   const unsigned int ni = 73, nj = 43;
 
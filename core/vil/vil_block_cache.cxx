@@ -1,20 +1,131 @@
-#include <algorithm>
-#include "vil_block_cache.h"
+// This is core/vil/vil_block_cache.cxx
+#ifdef VCL_NEEDS_PRAGMA_INTERFACE
+#pragma implementation
+#endif
 //:
 // \file
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <utility>
+#include "vil_block_cache.h"
 #include <vcl_compiler.h>
 #include <vcl_cassert.h>
+#include <vxl_config.h>
+#include <vil/vil_pixel_format.h>
 
-unsigned long bcell::time_ = 0;
+#if VXL_FULLCXX11SUPPORT
+# include <mutex>
+#endif
 
-vil_block_cache::~vil_block_cache()
+typedef std::pair<unsigned, unsigned> vil_block_cache_key;
+
+//: A block, and its indices.
+struct vil_block_cache_entry
+{
+  vil_block_cache_entry(vil_block_cache_key const& k,
+                        vil_image_view_base_sptr const& b, std::size_t n)
+  : key(k), blk(b), bytes(n) {}
+
+  vil_block_cache_key key;
+  vil_image_view_base_sptr blk;
+  std::size_t bytes;
+};
+
+//: Part of the cache, with its own lock, limits and LRU order.
+struct vil_block_cache_shard
+{
+  typedef std::list<vil_block_cache_entry> lru_list;
+  typedef std::map<vil_block_cache_key, lru_list::iterator> index_map;
+
+  vil_block_cache_shard() : max_blocks(0), max_bytes(0) {}
+
+  //: Most recently used at the front.
+  lru_list lru;
+  index_map index;
+  unsigned max_blocks;
+  std::size_t max_bytes;
+  vil_block_cache_stats stats;
+#if VXL_FULLCXX11SUPPORT
+  std::mutex mutex;
+#endif
+
+  void erase(index_map::iterator it)
+  {
+    stats.n_bytes -= it->second->bytes;
+    --stats.n_blocks;
+    lru.erase(it->second);
+    index.erase(it);
+  }
+
+  //: Discard least recently used blocks until another of this size fits.
+  // A block larger than the byte limit empties the shard, and is then held alone.
+  void make_room(std::size_t bytes)
+  {
+    while (!lru.empty() &&
+           (stats.n_blocks >= max_blocks ||
+            (max_bytes > 0 && stats.n_bytes + bytes > max_bytes)))
+    {
+      index_map::iterator it = index.find(lru.back().key);
+      assert(it != index.end());
+      erase(it);
+      ++stats.evictions;
+    }
+  }
+};
+
+//: Holds the lock of a shard for the lifetime of the object.
+class vil_block_cache_lock
+{
+ public:
+#if VXL_FULLCXX11SUPPORT
+  explicit vil_block_cache_lock(vil_block_cache_shard& s) : s_(s) { s_.mutex.lock(); }
+  ~vil_block_cache_lock() { s_.mutex.unlock(); }
+ private:
+  vil_block_cache_shard& s_;
+#else
+  explicit vil_block_cache_lock(vil_block_cache_shard&) {}
+#endif
+};
+
+vil_block_cache::vil_block_cache(const unsigned block_capacity,
+                                 const std::size_t byte_capacity,
+                                 const unsigned n_shards)
+: nblocks_(block_capacity), nbytes_(byte_capacity), nshards_(n_shards)
 {
-  for(std::vector<bcell*>::iterator bit = blocks_.begin();
-      bit != blocks_.end(); ++bit){
-    delete *bit;
-    *bit = VXL_NULLPTR;
+  // A shard per 8 blocks, up to 16, so that small caches are exactly LRU
+  // and no shard is so small that it thrashes.
+  if (nshards_ == 0)
+    nshards_ = std::min(16u, std::max(1u, nblocks_ / 8));
+  nshards_ = std::max(1u, std::min(nshards_, std::max(1u, nblocks_)));
+  shards_ = new vil_block_cache_shard[nshards_];
+  for (unsigned s = 0; s < nshards_; ++s)
+  {
+    // Share the limits out, rounding up.
+    shards_[s].max_blocks = (nblocks_ + nshards_ - 1) / nshards_;
+    shards_[s].max_bytes = (nbytes_ + nshards_ - 1) / nshards_;
   }
-  blocks_.clear();//empty the index
+}
+
+vil_block_cache::~vil_block_cache()
+{
+  delete [] shards_;
+}
+
+std::size_t vil_block_cache::block_bytes(vil_image_view_base const& blk)
+{
+  const vil_pixel_format f = blk.pixel_format();
+  return std::size_t(blk.ni()) * blk.nj() * blk.nplanes() *
+         vil_pixel_format_num_components(f) * vil_pixel_format_sizeof_components(f);
+}
+
+vil_block_cache_shard& vil_block_cache::shard(unsigned block_index_i,
+                                              unsigned block_index_j) const
+{
+  // Neighbouring blocks, in either direction, go to different shards.
+  const unsigned long h = block_index_i * 0x9E3779B1ul + block_index_j * 0x85EBCA77ul;
+  return shards_[(h ^ (h >> 16)) % nshards_];
 }
 
 //:add a block to the buffer.
@@ -22,14 +133,20 @@ bool vil_block_cache::add_block(const unsigned& block_index_i,
                                 const unsigned& block_index_j,
                                 vil_image_view_base_sptr const& blk)
 {
-  //create a cell
-
-  bcell* cell = new bcell(block_index_i, block_index_j, blk);
-  if (blocks_.size()>=nblocks_)
-    if (!this->remove_block())
-      return false;
-  blocks_.push_back(cell);
-  std::sort(blocks_.begin(), blocks_.end(), bcell_less());
+  if (!blk || nblocks_ == 0)
+    return false;
+  const vil_block_cache_key key(block_index_i, block_index_j);
+  const std::size_t bytes = block_bytes(*blk);
+  vil_block_cache_shard& s = shard(block_index_i, block_index_j);
+  vil_block_cache_lock lock(s);
+  vil_block_cache_shard::index_map::iterator it = s.index.find(key);
+  if (it != s.index.end())
+    s.erase(it);
+  s.make_room(bytes);
+  s.lru.push_front(vil_block_cache_entry(key, blk, bytes));
+  s.index[key] = s.lru.begin();
+  ++s.stats.n_blocks;
+  s.stats.n_bytes += bytes;
   return true;
 }
 
@@ -37,31 +154,92 @@ bool vil_block_cache::get_block(const unsigned& block_index_i,
                                 const unsigned& block_index_j,
                                 vil_image_view_base_sptr& blk) const
 {
-  bool found = false;
-  for (std::vector<bcell*>::const_iterator bit=blocks_.begin(); bit!= blocks_.end()&&!found; ++bit)
+  vil_block_cache_shard& s = shard(block_index_i, block_index_j);
+  vil_block_cache_lock lock(s);
+  vil_block_cache_shard::index_map::iterator it =
+    s.index.find(vil_block_cache_key(block_index_i, block_index_j));
+  if (it == s.index.end())
   {
-    if ((*bit)->bindex_i_!=block_index_i||(*bit)->bindex_j_!=block_index_j)
-      continue;
-    else
-    {
-      found = true;
-      blk = (*bit)->blk_;
-      (*bit)->touch();//block is in demand so update the age to zero
-    }
+    ++s.stats.misses;
+    return false;
   }
-  return found;
+  ++s.stats.hits;
+  blk = it->second->blk;
+  // block is in demand so move it to the front
+  s.lru.splice(s.lru.begin(), s.lru, it->second);
+  return true;
 }
 
-//:remove the oldest priority block
-bool vil_block_cache::remove_block()
+bool vil_block_cache::peek_block(const unsigned& block_index_i,
+                                 const unsigned& block_index_j,
+                                 vil_image_view_base_sptr& blk) const
 {
-  if(!blocks_.size()){
-    std::cerr << "warning: attempt to remove block from empty cache\n";
+  vil_block_cache_shard& s = shard(block_index_i, block_index_j);
+  vil_block_cache_lock lock(s);
+  vil_block_cache_shard::index_map::iterator it =
+    s.index.find(vil_block_cache_key(block_index_i, block_index_j));
+  if (it == s.index.end())
     return false;
-  }
-  // queue should already be sorted
-  // remove oldest
-  std::vector<bcell*>::iterator bit = blocks_.begin();
-  blocks_.erase(bit);
+  blk = it->second->blk;
+  return true;
+}
+
+bool vil_block_cache::contains(const unsigned& block_index_i,
+                               const unsigned& block_index_j) const
+{
+  vil_block_cache_shard& s = shard(block_index_i, block_index_j);
+  vil_block_cache_lock lock(s);
+  return s.index.find(vil_block_cache_key(block_index_i, block_index_j)) != s.index.end();
+}
+
+bool vil_block_cache::remove_block(const unsigned& block_index_i,
+                                   const unsigned& block_index_j)
+{
+  vil_block_cache_shard& s = shard(block_index_i, block_index_j);
+  vil_block_cache_lock lock(s);
+  vil_block_cache_shard::index_map::iterator it =
+    s.index.find(vil_block_cache_key(block_index_i, block_index_j));
+  if (it == s.index.end())
+    return false;
+  s.erase(it);
   return true;
 }
+
+void vil_block_cache::clear()
+{
+  for (unsigned k = 0; k < nshards_; ++k)
+  {
+    vil_block_cache_shard& s = shards_[k];
+    vil_block_cache_lock lock(s);
+    s.lru.clear();
+    s.index.clear();
+    s.stats.n_blocks = 0;
+    s.stats.n_bytes = 0;
+  }
+}
+
+vil_block_cache_stats vil_block_cache::stats() const
+{
+  vil_block_cache_stats total;
+  for (unsigned k = 0; k < nshards_; ++k)
+  {
+    vil_block_cache_shard& s = shards_[k];
+    vil_block_cache_lock lock(s);
+    total.hits += s.stats.hits;
+    total.misses += s.stats.misses;
+    total.evictions += s.stats.evictions;
+    total.n_blocks += s.stats.n_blocks;
+    total.n_bytes += s.stats.n_bytes;
+  }
+  return total;
+}
+
+void vil_block_cache::reset_stats()
+{
+  for (unsigned k = 0; k < nshards_; ++k)
+  {
+    vil_block_cache_shard& s = shards_[k];
+    vil_block_cache_lock lock(s);
+    s.stats.hits = s.stats.misses = s.stats.evictions = 0;
+  }
+}
@@ -6,79 +6,119 @@
 #endif
 //:
 // \file
-// \brief A block cache with block population prioritized by age
+// \brief A thread-safe cache of image blocks, discarding the least recently used
 // \author J. L. Mundy
 //
-#include <iostream>
-#include <queue>
-#include <vector>
-#include <vcl_compiler.h>
-#include <vil/vil_image_view_base.h>
-
+// The cache holds at most a given number of blocks and, optionally, at most
+// a given number of bytes of pixel data.  When adding a block would exceed
+// either limit, the blocks used least recently are discarded.
+//
+// The blocks are spread over several shards, each with its own lock, so
+// that many threads can look up blocks at the same time.  Each shard keeps
+// its own share of the limits and its own least-recently-used order, so a
+// cache with several shards only approximates a global LRU policy.  Small
+// caches use a single shard, and are then exactly LRU.
+//
 // \verbatim
 //  Modifications
 //   J.L. Mundy replaced priority queue with sort on block vector
 //   container for simplicity, January 01, 2012
+//   Made thread-safe: blocks are now held in locked shards, each with an
+//   LRU list and a map from block index, and the cache can be limited in
+//   bytes as well as in blocks.  Added hit and miss statistics.
 // \endverbatim
 
-//container for blocks to maintain a timestamp
-//note that the larger value of time corresponds to the newest block
-struct bcell
-{
-  bcell(const unsigned bindex_i, const unsigned bindex_j,
-        vil_image_view_base_sptr const& blk) :
-    bindex_i_(bindex_i), bindex_j_(bindex_j), birthdate_(time_++), blk_(blk)
-  {}
-
-  //:block indices
-  unsigned bindex_i_;  unsigned bindex_j_;
-  //:the time of insertion into the queue
-  unsigned long birthdate_;
-  //:the block itself
-  vil_image_view_base_sptr blk_;
-  //:update the age of a block
-  void touch(){birthdate_=time_++;}
-  //: for debug
-  void print() const { std::cout << '[' << bindex_i_ << ' ' << bindex_j_
-                                << "](" << birthdate_ << ")\n"; }
- private:
-  static unsigned long time_; //static timekeeper
-};
-// the ordering predicate for block birthdate. Oldest block is at
-// blocks_.begin()
-class bcell_less
+#include <cstddef>
+#include <vcl_compiler.h>
+#include <vil/vil_image_view_base.h>
+
+struct vil_block_cache_shard;
+
+//: Counts of what a vil_block_cache has done, and what it holds.
+struct vil_block_cache_stats
 {
- public:
-  bcell_less(){}
-  //the predicate function
-  bool operator()(bcell* const& ba, bcell* const& bb) const
-  {
-    return ba->birthdate_ < bb->birthdate_;
-  }
+  //: Calls of get_block() which found the block.
+  unsigned long hits;
+  //: Calls of get_block() which did not find the block.
+  unsigned long misses;
+  //: Blocks discarded to make room for others.
+  unsigned long evictions;
+  //: Blocks currently held.
+  unsigned long n_blocks;
+  //: Bytes of pixel data currently held.
+  std::size_t n_bytes;
+
+  vil_block_cache_stats()
+  : hits(0), misses(0), evictions(0), n_blocks(0), n_bytes(0) {}
 };
+
 class vil_block_cache
 {
  public:
-  vil_block_cache(const unsigned block_capacity):nblocks_(block_capacity){}
+  //: Make a cache holding at most block_capacity blocks.
+  // If byte_capacity is non-zero the blocks held will also not have more
+  // than byte_capacity bytes of pixel data between them (but a single
+  // block larger than that is still held).  n_shards==0 chooses a number of
+  // shards from the capacity.
+  vil_block_cache(const unsigned block_capacity,
+                  const std::size_t byte_capacity = 0,
+                  const unsigned n_shards = 0);
   ~vil_block_cache();
 
   //:add a block to the buffer
+  // Replaces any block already held with the same indices.
   bool add_block(const unsigned& block_index_i, const unsigned& block_index_j,
                  vil_image_view_base_sptr const& blk);
 
   //:retrieve a block from the buffer
+  // The block becomes the most recently used.
   bool get_block(const unsigned& block_index_i, const unsigned& block_index_j,
                  vil_image_view_base_sptr& blk) const;
 
+  //: Like get_block(), but not counted in the statistics nor as a use of the block.
+  bool peek_block(const unsigned& block_index_i, const unsigned& block_index_j,
+                  vil_image_view_base_sptr& blk) const;
+
+  //: True if the block is held; does not count as a use of the block.
+  bool contains(const unsigned& block_index_i, const unsigned& block_index_j) const;
+
+  //: Discard a block, if it is held.
+  bool remove_block(const unsigned& block_index_i, const unsigned& block_index_j);
+
+  //: Discard all the blocks.
+  void clear();
+
   //:block capacity
   unsigned block_size() const{return nblocks_;}
+
+  //: Limit on bytes of pixel data held, or 0 if there is none.
+  std::size_t byte_capacity() const { return nbytes_; }
+
+  //: Number of independently locked shards.
+  unsigned n_shards() const { return nshards_; }
+
+  //: Counts summed over all the shards.
+  vil_block_cache_stats stats() const;
+
+  //: Set the hit, miss and eviction counts to zero.
+  void reset_stats();
+
+  //: Bytes of pixel data in a block.
+  static std::size_t block_bytes(vil_image_view_base const& blk);
+
  private:
-  //:block index member
-  std::vector<bcell*> blocks_;
+  // Not copyable.
+  vil_block_cache(const vil_block_cache&);
+  vil_block_cache& operator=(const vil_block_cache&);
+
+  vil_block_cache_shard& shard(unsigned block_index_i, unsigned block_index_j) const;
+
   //:capacity in blocks
   unsigned nblocks_;
-  //:remove the lowest priority block
-  bool remove_block();
+  //:capacity in bytes, or 0
+  std::size_t nbytes_;
+  unsigned nshards_;
+  vil_block_cache_shard* shards_;
 };
 
 #endif // vil_block_cache_h_
@@ -4,8 +4,116 @@
 #endif
 
 #include "vil_cached_image_resource.h"
+#include <vcl_compiler.h>
+#include <vxl_config.h>
 #include <vil/vil_image_view_base.h>
 
+#if VXL_FULLCXX11SUPPORT
+# include <atomic>
+# include <condition_variable>
+# include <deque>
+# include <mutex>
+# include <thread>
+# include <utility>
+#endif
+
+//: Locks, and the queue of blocks to be read ahead.
+struct vil_cached_image_resource_state
+{
+  vil_cached_image_resource_state() : read_ahead(0)
+#if VXL_FULLCXX11SUPPORT
+    , stop(false)
+#endif
+  {}
+
+  //: May be changed while other threads are reading blocks.
+#if VXL_FULLCXX11SUPPORT
+  std::atomic<unsigned> read_ahead;
+#else
+  unsigned read_ahead;
+#endif
+
+#if VXL_FULLCXX11SUPPORT
+  //: Held while reading from the underlying resource.
+  std::mutex io;
+  //: Guards the members below.
+  std::mutex queue_mutex;
+  std::condition_variable queue_cv;
+  std::deque<std::pair<unsigned, unsigned> > queue;
+  bool stop;
+  std::thread worker;
+
+  //: Read the queued blocks until told to stop.
+  static void run(vil_cached_image_resource const* r)
+  {
+    vil_cached_image_resource_state& s = *r->state_;
+    for (;;)
+    {
+      std::pair<unsigned, unsigned> b;
+      {
+        std::unique_lock<std::mutex> lock(s.queue_mutex);
+        while (!s.stop && s.queue.empty())
+          s.queue_cv.wait(lock);
+        if (s.stop)
+          return;
+        b = s.queue.front();
+        s.queue.pop_front();
+      }
+      r->load_block(b.first, b.second);
+    }
+  }
+#endif
+};
+
+vil_cached_image_resource::vil_cached_image_resource(vil_blocked_image_resource_sptr bir,
+                                                     const unsigned cache_size,
+                                                     const std::size_t byte_capacity)
+: bir_(bir), cache_(cache_size, byte_capacity),
+  state_(new vil_cached_image_resource_state)
+{
+}
+
+vil_cached_image_resource::~vil_cached_image_resource()
+{
+#if VXL_FULLCXX11SUPPORT
+  {
+    std::lock_guard<std::mutex> lock(state_->queue_mutex);
+    state_->stop = true;
+  }
+  state_->queue_cv.notify_all();
+  if (state_->worker.joinable())
+    state_->worker.join();
+#endif
+  delete state_;
+}
+
+void vil_cached_image_resource::set_read_ahead(unsigned n)
+{
+  state_->read_ahead = n;
+}
+
+unsigned vil_cached_image_resource::read_ahead() const
+{
+  return state_->read_ahead;
+}
+
+vil_image_view_base_sptr
+vil_cached_image_resource::load_block(unsigned block_index_i,
+                                      unsigned block_index_j) const
+{
+  vil_image_view_base_sptr blk;
+#if VXL_FULLCXX11SUPPORT
+  std::lock_guard<std::mutex> lock(state_->io);
+  // another thread may have read it while this one waited
+  if (cache_.peek_block(block_index_i, block_index_j, blk))
+    return blk;
+#endif
+  blk = bir_->get_block(block_index_i, block_index_j);
+  if (blk)
+    cache_.add_block(block_index_i, block_index_j, blk);
+  return blk;
+}
+
 // Get a view that is the size of a block.
 // Uses the cache to retrieve frequently used blocks
 vil_image_view_base_sptr
@@ -13,16 +121,56 @@ vil_cached_image_resource::get_block( unsigned  block_index_i,
                                       unsigned  block_index_j ) const
 {
   // check if the block is already in the buffer
-   vil_image_view_base_sptr blk;
+  vil_image_view_base_sptr blk;
   if (cache_.get_block(block_index_i, block_index_j, blk))
     return blk;
   // no - so get the block from the resource
-  blk = bir_->get_block(block_index_i, block_index_j);
+  blk = load_block(block_index_i, block_index_j);
   if (!blk)
     return blk; // get block failed
-  // put the block in the cache (cast away const since we are just caching)
-  vil_cached_image_resource* non_const = (vil_cached_image_resource*)this;
-  non_const->cache_.add_block(block_index_i, block_index_j, blk);
+
+  // and the blocks which are likely to be wanted next
+  const unsigned n = state_->read_ahead;
+  const unsigned nbi = bir_->n_block_i();
+  if (n == 0 || block_index_i + 1 >= nbi)
+    return blk;
+#if VXL_FULLCXX11SUPPORT
+  {
+    std::lock_guard<std::mutex> lock(state_->queue_mutex);
+    // Older requests are for blocks which are no longer wanted so soon.
+    state_->queue.clear();
+    for (unsigned bi = block_index_i + 1; bi < nbi && bi <= block_index_i + n; ++bi)
+      if (!cache_.contains(bi, block_index_j))
+        state_->queue.push_back(std::make_pair(bi, block_index_j));
+    if (!state_->worker.joinable())
+      state_->worker = std::thread(&vil_cached_image_resource_state::run, this);
+  }
+  state_->queue_cv.notify_one();
+#else
+  for (unsigned bi = block_index_i + 1; bi < nbi && bi <= block_index_i + n; ++bi)
+    if (!cache_.contains(bi, block_index_j))
+      load_block(bi, block_index_j);
+#endif
   return blk;
 }
 
+bool vil_cached_image_resource::put_block(unsigned block_index_i,
+                                          unsigned block_index_j,
+                                          const vil_image_view_base& view)
+{
+#if VXL_FULLCXX11SUPPORT
+  std::lock_guard<std::mutex> lock(state_->io);
+#endif
+  cache_.remove_block(block_index_i, block_index_j);
+  return bir_->put_block(block_index_i, block_index_j, view);
+}
+
+bool vil_cached_image_resource::put_view(const vil_image_view_base& im,
+                                         unsigned i0, unsigned j0)
+{
+#if VXL_FULLCXX11SUPPORT
+  std::lock_guard<std::mutex> lock(state_->io);
+#endif
+  cache_.clear();
+  return bir_->put_view(im, i0, j0);
+}
@@ -8,19 +8,36 @@
 // \file
 // \brief A cached and blocked representation of the image_resource
 // \author J. L. Mundy
+//
+// Blocks are kept in a vil_block_cache, so several threads may call
+// get_block() and get_view() on the same cached resource at once.  Reads
+// from the underlying resource, which need not be thread-safe, are done one
+// at a time.
+//
+// \verbatim
+//  Modifications
+//   Thread-safe access; optional byte limit on the cache; read-ahead of the
+//   blocks following one which was not in the cache.
+// \endverbatim
 
+#include <cstddef>
 #include <vil/vil_blocked_image_resource.h>
 #include <vil/vil_block_cache.h>
 
+struct vil_cached_image_resource_state;
+
 class vil_cached_image_resource : public vil_blocked_image_resource
 {
  public:
 
+  //: Cache at most cache_size blocks of bir.
+  // If byte_capacity is non-zero the cached blocks will also not hold more
+  // than that many bytes of pixel data between them.
   vil_cached_image_resource(vil_blocked_image_resource_sptr bir,
-                            const unsigned cache_size):
-    bir_(bir), cache_(vil_block_cache(cache_size)){}
+                            const unsigned cache_size,
+                            const std::size_t byte_capacity = 0);
 
-  virtual ~vil_cached_image_resource(){}
+  virtual ~vil_cached_image_resource();
 
  inline virtual unsigned nplanes() const
     {return bir_->nplanes();}
@@ -44,26 +61,49 @@ class vil_cached_image_resource : public vil_blocked_image_resource
  inline virtual enum vil_pixel_format pixel_format() const
     {return bir_->pixel_format();}
 
- inline virtual bool put_view(const vil_image_view_base& im, unsigned i0, unsigned j0) {return bir_->put_view(im, i0, j0);}
+  //: Write into the resource, discarding the cached blocks.
+  virtual bool put_view(const vil_image_view_base& im, unsigned i0, unsigned j0);
 
   //: Block access
   virtual vil_image_view_base_sptr get_block( unsigned  block_index_i,
                                               unsigned  block_index_j ) const;
 
   //: put the block into the resource at the indicated location
+  // Any cached copy of the block is discarded.
   virtual bool put_block(unsigned  block_index_i,
                          unsigned  block_index_j,
-                         const vil_image_view_base& view)
-    {return bir_->put_block(block_index_i, block_index_j, view);}
+                         const vil_image_view_base& view);
 
 
   //: Extra property information
  inline virtual bool get_property(char const* tag, void* property_value = 0) const
     {return bir_->get_property(tag, property_value);}
 
+  //: Read up to n blocks ahead.
+  // When get_block() has to read a block from the underlying resource, the
+  // following n blocks of the same row are also read into the cache: by a
+  // background thread if threads are supported, or else straight away.
+  // The default, 0, reads no blocks ahead.
+  void set_read_ahead(unsigned n);
+
+  //: Number of blocks read ahead.
+  unsigned read_ahead() const;
+
+  //: Hit and miss counts of the cache.
+  vil_block_cache_stats cache_stats() const { return cache_.stats(); }
+
  protected:
+  //: Read a block from bir_ into the cache, unless it is there already.
+  vil_image_view_base_sptr load_block(unsigned block_index_i,
+                                      unsigned block_index_j) const;
+
   vil_blocked_image_resource_sptr bir_;
-  vil_block_cache cache_;
+  mutable vil_block_cache cache_;
+
+ private:
+  friend struct vil_cached_image_resource_state;
+  //: Locks and the read-ahead thread.
+  vil_cached_image_resource_state* state_;
 };
 
 #endif // vil_cached_image_resource_h_
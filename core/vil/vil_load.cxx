@@ -6,6 +6,7 @@
 // \file
 
 #include <iostream>
+#include <cstddef>
 #include "vil_load.h"
 #include <vcl_compiler.h>
 #include <vil/vil_open.h>
@@ -16,6 +17,9 @@
 #include <vil/vil_image_resource_plugin.h>
 #include <vil/vil_image_view.h>
 #include <vil/vil_exception.h>
+#include <vil/vil_mapped_image_resource.h>
+#include <vil/vil_mapped_memory_chunk.h>
+#include <vil/vil_property.h>
 
 vil_image_resource_sptr vil_load_image_resource_raw(vil_stream *is,
                                                     bool verbose)
@@ -81,6 +85,29 @@ vil_image_resource_sptr vil_load_image_resource(char const* filename,
 }
 
 
+vil_image_resource_sptr vil_load_image_resource_mapped(char const* filename,
+                                                       bool verbose)
+{
+  vil_image_resource_sptr im = vil_load_image_resource(filename, verbose);
+  vil_file_layout layout;
+  if (!im || !im->get_property(vil_property_file_layout, &layout))
+    return im;
+
+  vil_mapped_memory_chunk* chunk = new vil_mapped_memory_chunk(filename, layout.format);
+  vil_memory_chunk_sptr chunk_sptr = chunk;
+  vil_streampos begin, end;
+  layout.byte_range(begin, end);
+  if (!chunk->is_mapped() || begin < 0 || end > vil_streampos(chunk->size()))
+    return im;
+  // The steps are in components, but the pixels must also start on a
+  // component boundary to be used in place.
+  const std::size_t component_size = vil_pixel_format_sizeof_components(layout.format);
+  const std::size_t top_left = reinterpret_cast<std::size_t>(chunk->data()) + std::size_t(layout.offset);
+  if (component_size == 0 || top_left % component_size != 0)
+    return im;
+  return new vil_mapped_image_resource(chunk_sptr, layout, im);
+}
+
 vil_image_resource_sptr vil_load_image_resource_plugin(char const* filename)
 {
   vil_image_resource_plugin im_resource_plugin;
@@ -47,6 +47,16 @@ vil_image_resource_sptr vil_load_image_resource_raw(vil_stream *,
 vil_image_resource_sptr vil_load_image_resource_raw(char const*,
                                                     bool verbose = true);
 
+//: Load an image resource whose views point into the file mapped into memory.
+// For uncompressed PNM, BMP, TIFF and NITF images stored in the host's byte
+// order, whose pixels start at a multiple of the component size in the
+// file, the file is memory-mapped and get_view() returns views of it
+// without copying or reading anything until the pixels are used.  Other
+// images are loaded by vil_load_image_resource().  The resource is read-only.
+// \relatesalso vil_image_resource
+vil_image_resource_sptr vil_load_image_resource_mapped(char const* filename,
+                                                       bool verbose = true);
+
 //: Load from a filename with a plugin.
 // \relatesalso vil_image_resource
 vil_image_resource_sptr vil_load_image_resource_plugin(char const*);
@@ -0,0 +1,153 @@
+// This is core/vil/vil_mapped_image_resource.cxx
+//:
+// \file
+
+#include <complex>
+#include <cstring>
+#include "vil_mapped_image_resource.h"
+#include <vcl_compiler.h>
+#include <vcl_cassert.h>
+#include <vil/vil_copy.h>
+#include <vil/vil_image_view.h>
+#include <vil/vil_property.h>
+
+void vil_file_layout::byte_range(vil_streampos& begin, vil_streampos& end) const
+{
+  const std::ptrdiff_t steps[3] = { istep, jstep, planestep };
+  const unsigned counts[3] = { ni, nj, nplanes };
+  vil_streampos lo = 0, hi = 0;
+  for (unsigned d = 0; d < 3; ++d)
+  {
+    const vil_streampos extent = vil_streampos(steps[d]) * (counts[d] > 0 ? counts[d]-1 : 0);
+    if (extent < 0) lo += extent; else hi += extent;
+  }
+  const vil_streampos size = vil_pixel_format_sizeof_components(format);
+  begin = offset + lo*size;
+  end = offset + hi*size + size;
+}
+
+vil_mapped_image_resource::vil_mapped_image_resource(vil_memory_chunk_sptr const& chunk,
+                                                     vil_file_layout const& layout,
+                                                     vil_image_resource_sptr const& src)
+: src_(src)
+{
+#ifndef NDEBUG
+  vil_streampos begin, end;
+  layout.byte_range(begin, end);
+  assert(begin >= 0 && end <= vil_streampos(chunk->size()));
+#endif
+  void* top_left = static_cast<char*>(chunk->data()) + layout.offset;
+  switch (layout.format)
+  {
+#define macro( F , T ) \
+   case F : \
+    view_ = new vil_image_view< T >(chunk, static_cast< T *>(top_left), \
+                                    layout.ni, layout.nj, layout.nplanes, \
+                                    layout.istep, layout.jstep, layout.planestep); \
+    break;
+   macro(VIL_PIXEL_FORMAT_BYTE , vxl_byte )
+   macro(VIL_PIXEL_FORMAT_SBYTE , vxl_sbyte )
+#if VXL_HAS_INT_64
+   macro(VIL_PIXEL_FORMAT_UINT_64 , vxl_uint_64 )
+   macro(VIL_PIXEL_FORMAT_INT_64 , vxl_int_64 )
+#endif
+   macro(VIL_PIXEL_FORMAT_UINT_32 , vxl_uint_32 )
+   macro(VIL_PIXEL_FORMAT_INT_32 , vxl_int_32 )
+   macro(VIL_PIXEL_FORMAT_UINT_16 , vxl_uint_16 )
+   macro(VIL_PIXEL_FORMAT_INT_16 , vxl_int_16 )
+   macro(VIL_PIXEL_FORMAT_FLOAT , float )
+   macro(VIL_PIXEL_FORMAT_DOUBLE , double )
+   macro(VIL_PIXEL_FORMAT_COMPLEX_FLOAT , std::complex<float>)
+   macro(VIL_PIXEL_FORMAT_COMPLEX_DOUBLE , std::complex<double>)
+#undef macro
+   default:
+    assert(!"vil_mapped_image_resource: unsupported pixel format");
+    view_ = new vil_image_view<vxl_byte>();
+  }
+}
+
+vil_mapped_image_resource::~vil_mapped_image_resource()
+{
+}
+
+vil_image_view_base_sptr vil_mapped_image_resource::get_view(unsigned i0, unsigned n_i,
+                                                             unsigned j0, unsigned n_j) const
+{
+  if (i0 + n_i > view_->ni() || j0 + n_j > view_->nj()) return VXL_NULLPTR;
+
+  switch (view_->pixel_format())
+  {
+#define macro( F , T ) \
+   case F : { \
+    const vil_image_view< T > &v = static_cast<const vil_image_view< T > &>(*view_); \
+    return new vil_image_view< T >(v.memory_chunk(), &v(i0,j0), \
+                                   n_i, n_j, v.nplanes(), \
+                                   v.istep(), v.jstep(), v.planestep()); }
+   macro(VIL_PIXEL_FORMAT_BYTE , vxl_byte )
+   macro(VIL_PIXEL_FORMAT_SBYTE , vxl_sbyte )
+#if VXL_HAS_INT_64
+   macro(VIL_PIXEL_FORMAT_UINT_64 , vxl_uint_64 )
+   macro(VIL_PIXEL_FORMAT_INT_64 , vxl_int_64 )
+#endif
+   macro(VIL_PIXEL_FORMAT_UINT_32 , vxl_uint_32 )
+   macro(VIL_PIXEL_FORMAT_INT_32 , vxl_int_32 )
+   macro(VIL_PIXEL_FORMAT_UINT_16 , vxl_uint_16 )
+   macro(VIL_PIXEL_FORMAT_INT_16 , vxl_int_16 )
+   macro(VIL_PIXEL_FORMAT_FLOAT , float )
+   macro(VIL_PIXEL_FORMAT_DOUBLE , double )
+   macro(VIL_PIXEL_FORMAT_COMPLEX_FLOAT , std::complex<float>)
+   macro(VIL_PIXEL_FORMAT_COMPLEX_DOUBLE , std::complex<double>)
+#undef macro
+   default:
+    return VXL_NULLPTR;
+  }
+}
+
+vil_image_view_base_sptr vil_mapped_image_resource::get_copy_view(unsigned i0, unsigned n_i,
+                                                                  unsigned j0, unsigned n_j) const
+{
+  vil_image_view_base_sptr v = get_view(i0, n_i, j0, n_j);
+  if (!v) return VXL_NULLPTR;
+
+  switch (v->pixel_format())
+  {
+#define macro( F , T ) \
+   case F : \
+    return new vil_image_view< T >(vil_copy_deep(static_cast<const vil_image_view< T > &>(*v)));
+   macro(VIL_PIXEL_FORMAT_BYTE , vxl_byte )
+   macro(VIL_PIXEL_FORMAT_SBYTE , vxl_sbyte )
+#if VXL_HAS_INT_64
+   macro(VIL_PIXEL_FORMAT_UINT_64 , vxl_uint_64 )
+   macro(VIL_PIXEL_FORMAT_INT_64 , vxl_int_64 )
+#endif
+   macro(VIL_PIXEL_FORMAT_UINT_32 , vxl_uint_32 )
+   macro(VIL_PIXEL_FORMAT_INT_32 , vxl_int_32 )
+   macro(VIL_PIXEL_FORMAT_UINT_16 , vxl_uint_16 )
+   macro(VIL_PIXEL_FORMAT_INT_16 , vxl_int_16 )
+   macro(VIL_PIXEL_FORMAT_FLOAT , float )
+   macro(VIL_PIXEL_FORMAT_DOUBLE , double )
+   macro(VIL_PIXEL_FORMAT_COMPLEX_FLOAT , std::complex<float>)
+   macro(VIL_PIXEL_FORMAT_COMPLEX_DOUBLE , std::complex<double>)
+#undef macro
+   default:
+    return VXL_NULLPTR;
+  }
+}
+
+bool vil_mapped_image_resource::put_view(const vil_image_view_base& /*im*/,
+                                         unsigned /*i0*/, unsigned /*j0*/)
+{
+  return false;
+}
+
+char const* vil_mapped_image_resource::file_format() const
+{
+  return src_ ? src_->file_format() : VXL_NULLPTR;
+}
+
+bool vil_mapped_image_resource::get_property(char const* tag, void* value) const
+{
+  if (std::strcmp(tag, vil_property_read_only) == 0)
+    return value ? (*static_cast<bool*>(value)) = true : true;
+  return src_ ? src_->get_property(tag, value) : false;
+}
@@ -0,0 +1,92 @@
+// This is core/vil/vil_mapped_image_resource.h
+#ifndef vil_mapped_image_resource_h_
+#define vil_mapped_image_resource_h_
+//:
+// \file
+// \brief An image resource whose views point straight into a memory-mapped file
+//
+// File images whose pixels are stored uncompressed, in the host's byte
+// order and with a regular layout, describe where the pixels lie through
+// the vil_property_file_layout property.  vil_load_image_resource_mapped()
+// (see vil_load.h) uses it to map the file into memory with a
+// vil_mapped_memory_chunk and wrap it in a vil_mapped_image_resource, whose
+// get_view() returns views of the mapped file without copying anything.
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <cstddef>
+#include <vcl_compiler.h>
+#include <vil/vil_image_resource.h>
+#include <vil/vil_image_view_base.h>
+#include <vil/vil_memory_chunk.h>
+#include <vil/vil_pixel_format.h>
+#include <vil/vil_stream.h>
+
+//: Position of the pixels of an uncompressed image in its file.
+// The component of pixel (i,j) in plane p is the one at byte
+// offset + (i*istep + j*jstep + p*planestep)*sizeof(component).
+struct vil_file_layout
+{
+  //: Position in the file of the component of pixel (0,0) in plane 0, in bytes.
+  vil_streampos offset;
+  //: Scalar type of each component, stored in the host's byte order.
+  vil_pixel_format format;
+  unsigned ni, nj, nplanes;
+  //: Steps in components (not bytes).
+  std::ptrdiff_t istep, jstep, planestep;
+
+  vil_file_layout()
+  : offset(0), format(VIL_PIXEL_FORMAT_UNKNOWN), ni(0), nj(0), nplanes(0),
+    istep(0), jstep(0), planestep(0) {}
+
+  //: Smallest and one past the largest byte offsets of the components.
+  void byte_range(vil_streampos& begin, vil_streampos& end) const;
+};
+
+//: Read-only image resource with its pixels in a mapped file.
+// The views from get_view() share the mapped memory: writing into them
+// changes the process's private copy of the page, never the file.
+class vil_mapped_image_resource : public vil_image_resource
+{
+ public:
+  //: Wrap a chunk holding a whole file with the given layout.
+  // src is the ordinary resource for the file, which supplies the file
+  // format and other properties.  The layout must lie within the chunk.
+  vil_mapped_image_resource(vil_memory_chunk_sptr const& chunk,
+                            vil_file_layout const& layout,
+                            vil_image_resource_sptr const& src);
+
+  ~vil_mapped_image_resource() VXL_OVERRIDE;
+
+  unsigned nplanes() const VXL_OVERRIDE { return view_->nplanes(); }
+  unsigned ni() const VXL_OVERRIDE { return view_->ni(); }
+  unsigned nj() const VXL_OVERRIDE { return view_->nj(); }
+  enum vil_pixel_format pixel_format() const VXL_OVERRIDE { return view_->pixel_format(); }
+
+  //: Create a view of the mapped file, without copying the pixels.
+  // \return 0 if the window is outside the image.
+  vil_image_view_base_sptr get_view(unsigned i0, unsigned ni,
+                                    unsigned j0, unsigned nj) const VXL_OVERRIDE;
+
+  //: Create a view of a copy of the pixels, on the heap.
+  vil_image_view_base_sptr get_copy_view(unsigned i0, unsigned ni,
+                                         unsigned j0, unsigned nj) const VXL_OVERRIDE;
+
+  //: The file cannot be written: always returns false.
+  bool put_view(const vil_image_view_base& im, unsigned i0, unsigned j0) VXL_OVERRIDE;
+
+  char const* file_format() const VXL_OVERRIDE;
+
+  //: Read-only; other properties are those of the file image.
+  bool get_property(char const* tag, void* property_value = VXL_NULLPTR) const VXL_OVERRIDE;
+
+ private:
+  //: The whole image.
+  vil_image_view_base_sptr view_;
+  //: The ordinary resource for the same file.
+  vil_image_resource_sptr src_;
+};
+
+#endif // vil_mapped_image_resource_h_
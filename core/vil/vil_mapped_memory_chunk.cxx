@@ -0,0 +1,95 @@
+// This is core/vil/vil_mapped_memory_chunk.cxx
+//:
+// \file
+
+#include "vil_mapped_memory_chunk.h"
+#include <vcl_compiler.h>
+#include <vxl_config.h>
+
+#if defined(_WIN32)
+# include <windows.h>
+# define VIL_MAPPED_MEMORY_CHUNK_WIN32 1
+#elif defined(__unix__) || defined(__unix) || defined(__APPLE__)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+# define VIL_MAPPED_MEMORY_CHUNK_POSIX 1
+#endif
+
+vil_mapped_memory_chunk::vil_mapped_memory_chunk(char const* filename,
+                                                 vil_pixel_format pixel_form)
+: mapped_(false)
+{
+  allocator_ = VXL_NULLPTR; // data_ belongs to the mapping
+  pixel_format_ = pixel_form;
+#if VIL_MAPPED_MEMORY_CHUNK_POSIX
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && st.st_size > 0 &&
+      vxl_uint_64(st.st_size) <= vxl_uint_64(std::size_t(-1)))
+  {
+    const std::size_t n = std::size_t(st.st_size);
+    void* p = ::mmap(VXL_NULLPTR, n, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED)
+    {
+      data_ = p;
+      size_ = n;
+      mapped_ = true;
+    }
+  }
+  ::close(fd); // the mapping keeps the file open
+#elif VIL_MAPPED_MEMORY_CHUNK_WIN32
+  HANDLE file = ::CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, VXL_NULLPTR,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, VXL_NULLPTR);
+  if (file == INVALID_HANDLE_VALUE)
+    return;
+  LARGE_INTEGER file_size;
+  if (::GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 &&
+      vxl_uint_64(file_size.QuadPart) <= vxl_uint_64(std::size_t(-1)))
+  {
+    HANDLE mapping = ::CreateFileMappingA(file, VXL_NULLPTR, PAGE_WRITECOPY, 0, 0, VXL_NULLPTR);
+    if (mapping)
+    {
+      void* p = ::MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+      if (p)
+      {
+        data_ = p;
+        size_ = std::size_t(file_size.QuadPart);
+        mapped_ = true;
+      }
+      ::CloseHandle(mapping); // the view keeps the mapping open
+    }
+  }
+  ::CloseHandle(file);
+#else
+  (void)filename;
+#endif
+}
+
+vil_mapped_memory_chunk::~vil_mapped_memory_chunk()
+{
+  unmap();
+}
+
+void vil_mapped_memory_chunk::unmap()
+{
+  if (!mapped_)
+    return;
+#if VIL_MAPPED_MEMORY_CHUNK_POSIX
+  ::munmap(data_, size_);
+#elif VIL_MAPPED_MEMORY_CHUNK_WIN32
+  ::UnmapViewOfFile(data_);
+#endif
+  data_ = VXL_NULLPTR;
+  mapped_ = false;
+}
+
+void vil_mapped_memory_chunk::set_size(unsigned long n, vil_pixel_format pixel_form)
+{
+  if (size_ == n) return;
+  unmap();
+  vil_memory_chunk::set_size(n, pixel_form);
+}
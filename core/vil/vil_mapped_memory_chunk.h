@@ -0,0 +1,52 @@
+// This is core/vil/vil_mapped_memory_chunk.h
+#ifndef vil_mapped_memory_chunk_h_
+#define vil_mapped_memory_chunk_h_
+//:
+// \file
+// \brief A vil_memory_chunk whose data is a file mapped into memory
+//
+// The file is mapped privately: pages are read from the file only when
+// they are first touched, and writing to the data changes this process's
+// copy of the page, never the file.  So image views of a mapped chunk
+// behave exactly like views of a chunk on the heap, but opening even a huge
+// file takes no time, and the operating system's page cache does the work.
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <cstddef>
+#include <vcl_compiler.h>
+#include <vil/vil_memory_chunk.h>
+
+//: A vil_memory_chunk whose data is a whole file mapped into memory.
+class vil_mapped_memory_chunk : public vil_memory_chunk
+{
+ public:
+  //: Map the named file.
+  // If this fails (e.g. the file does not exist, is empty, or the platform
+  // cannot map files) the chunk is left empty: check is_mapped().
+  vil_mapped_memory_chunk(char const* filename, vil_pixel_format pixel_format);
+
+  //: Unmap the file.
+  ~vil_mapped_memory_chunk() VXL_OVERRIDE;
+
+  //: True if the file was mapped.
+  bool is_mapped() const { return mapped_; }
+
+  //: Create space for n bytes.
+  // Unless n is the size of the file, the mapping is dropped and the chunk
+  // then holds ordinary memory from the default allocator.
+  void set_size(unsigned long n, vil_pixel_format pixel_format) VXL_OVERRIDE;
+
+ private:
+  // Not copyable: use the vil_memory_chunk copy constructor for a deep copy.
+  vil_mapped_memory_chunk(const vil_mapped_memory_chunk&);
+  vil_mapped_memory_chunk& operator=(const vil_mapped_memory_chunk&);
+
+  void unmap();
+
+  bool mapped_;
+};
+
+#endif // vil_mapped_memory_chunk_h_
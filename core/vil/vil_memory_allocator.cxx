@@ -0,0 +1,23 @@
+// This is core/vil/vil_memory_allocator.cxx
+//:
+// \file
+
+#include "vil_memory_allocator.h"
+#include <vcl_compiler.h>
+
+void* vil_memory_allocator_new::allocate(std::size_t n)
+{
+  return new char[n];
+}
+
+void vil_memory_allocator_new::deallocate(void* p, std::size_t /*n*/)
+{
+  delete [] static_cast<char*>(p);
+}
+
+vil_memory_allocator_new* vil_memory_allocator_new::instance()
+{
+  // Never destroyed, so chunks in static objects can still free their data.
+  static vil_memory_allocator_new* the_instance = new vil_memory_allocator_new;
+  return the_instance;
+}
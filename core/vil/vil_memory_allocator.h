@@ -0,0 +1,47 @@
+// This is core/vil/vil_memory_allocator.h
+#ifndef vil_memory_allocator_h_
+#define vil_memory_allocator_h_
+//:
+// \file
+// \brief Source of the pixel storage of vil_memory_chunk
+//
+// A vil_memory_chunk obtains its data from a vil_memory_allocator, and
+// gives it back to the same allocator when it is freed or resized.  By
+// default this is vil_memory_allocator_new, which uses new char[] exactly
+// as vil_memory_chunk always has.  vil_memory_pool keeps freed blocks for
+// reuse instead.  See vil_memory_chunk::set_default_allocator().
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <cstddef>
+#include <vcl_compiler.h>
+
+//: Source of the pixel storage of vil_memory_chunk.
+// An allocator must outlive every block it has handed out.
+// Implementations must be thread safe.
+class vil_memory_allocator
+{
+ public:
+  virtual ~vil_memory_allocator() {}
+
+  //: Return a block of at least n bytes (n may be 0).  Throws std::bad_alloc on failure.
+  virtual void* allocate(std::size_t n) = 0;
+
+  //: Free a block from allocate(n).  n must be the size requested.  p may be 0.
+  virtual void deallocate(void* p, std::size_t n) = 0;
+};
+
+//: Allocate with new char[n], and free with delete [].
+class vil_memory_allocator_new : public vil_memory_allocator
+{
+ public:
+  void* allocate(std::size_t n) VXL_OVERRIDE;
+  void deallocate(void* p, std::size_t n) VXL_OVERRIDE;
+
+  //: The one instance, which exists for the whole run of the program.
+  static vil_memory_allocator_new* instance();
+};
+
+#endif // vil_memory_allocator_h_
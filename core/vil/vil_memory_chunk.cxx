@@ -1,4 +1,5 @@
 // This is core/vil/vil_memory_chunk.cxx
+#include <cstdlib>
 #include <cstring>
 #include "vil_memory_chunk.h"
 //:
@@ -7,31 +8,80 @@
 // \author Tim Cootes
 #include <vcl_compiler.h>
 #include <vcl_cassert.h>
+#include <vil/vil_memory_pool.h>
+
+//: The allocator to use when none has been set.
+static vil_memory_allocator* vil_memory_chunk_initial_allocator()
+{
+  const char* env = std::getenv("VIL_MEMORY_POOL");
+  if (env && std::atoi(env) > 0)
+    return &vil_memory_pool::instance();
+  return vil_memory_allocator_new::instance();
+}
+
+static vil_memory_allocator* vil_memory_chunk_allocator_setting = VXL_NULLPTR;
+
+vil_memory_allocator* vil_memory_chunk::default_allocator()
+{
+  if (vil_memory_chunk_allocator_setting)
+    return vil_memory_chunk_allocator_setting;
+  static vil_memory_allocator* const initial = vil_memory_chunk_initial_allocator();
+  return initial;
+}
+
+void vil_memory_chunk::set_default_allocator(vil_memory_allocator* allocator)
+{
+  vil_memory_chunk_allocator_setting = allocator;
+}
+
+//: Give data_ back to allocator_.
+static void vil_memory_chunk_free(void*& data, std::size_t size, vil_memory_allocator* allocator)
+{
+  if (data && allocator)
+    allocator->deallocate(data, size);
+  data = VXL_NULLPTR;
+}
 
 //: Dflt ctor
 vil_memory_chunk::vil_memory_chunk()
-: data_(VXL_NULLPTR), size_(0), pixel_format_(VIL_PIXEL_FORMAT_UNKNOWN), ref_count_(0)
+: data_(VXL_NULLPTR), size_(0), pixel_format_(VIL_PIXEL_FORMAT_UNKNOWN), ref_count_(0),
+  allocator_(default_allocator())
 {
 }
 
 //: Allocate n bytes of memory
 vil_memory_chunk::vil_memory_chunk(std::size_t n, vil_pixel_format pixel_form)
-: data_(new char[n]), size_(n), pixel_format_(pixel_form), ref_count_(0)
+: data_(VXL_NULLPTR), size_(n), pixel_format_(pixel_form), ref_count_(0),
+  allocator_(default_allocator())
+{
+  assert(vil_pixel_format_num_components(pixel_form)==1
+         || pixel_form==VIL_PIXEL_FORMAT_UNKNOWN );
+  data_ = allocator_->allocate(n);
+}
+
+//: Allocate n bytes of memory from the given allocator
+vil_memory_chunk::vil_memory_chunk(std::size_t n, vil_pixel_format pixel_form,
+                                   vil_memory_allocator* allocator)
+: data_(VXL_NULLPTR), size_(n), pixel_format_(pixel_form), ref_count_(0),
+  allocator_(allocator ? allocator : default_allocator())
 {
   assert(vil_pixel_format_num_components(pixel_form)==1
          || pixel_form==VIL_PIXEL_FORMAT_UNKNOWN );
+  data_ = allocator_->allocate(n);
 }
 
 //: Destructor
 vil_memory_chunk::~vil_memory_chunk()
 {
-  delete [] reinterpret_cast<char*>(data_);
+  vil_memory_chunk_free(data_, size_, allocator_);
 }
 
 //: Copy ctor
 vil_memory_chunk::vil_memory_chunk(const vil_memory_chunk& d)
-: data_(new char[d.size()]), size_(d.size()), pixel_format_(d.pixel_format_), ref_count_(0)
+: data_(VXL_NULLPTR), size_(d.size()), pixel_format_(d.pixel_format_), ref_count_(0),
+  allocator_(default_allocator())
 {
+  data_ = allocator_->allocate(size_);
   std::memcpy(data_,d.data_,size_);
 }
 
@@ -52,11 +102,10 @@ void vil_memory_chunk::unref()
   // Note: refcount decrement and zero comparison need to happen in the same
   // statement for this to be thread safe.  Otherwise a race condition can
   // lead to multiple smart pointers deleting the memory.
+  // The destructors release the memory, so that derived chunks can
+  // release theirs in their own way.
   if (--ref_count_==0)
-  {
-    delete [] reinterpret_cast<char*>(data_); data_=VXL_NULLPTR;
     delete this;
-  }
 }
 
 //: Pointer to first element of data
@@ -70,10 +119,11 @@ void* vil_memory_chunk::const_data() const { return data_;}
 void vil_memory_chunk::set_size(unsigned long n, vil_pixel_format pixel_form)
 {
   if (size_==n) return;
-  delete [] reinterpret_cast<char*>(data_);
-  data_ = VXL_NULLPTR;
+  vil_memory_chunk_free(data_, size_, allocator_);
+  size_ = 0;
+  allocator_ = default_allocator();
   if (n>0)
-    data_ = new char[n];
+    data_ = allocator_->allocate(n);
   size_ = n;
   pixel_format_ = pixel_form;
 }
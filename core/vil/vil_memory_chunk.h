@@ -10,6 +10,7 @@
 #include <vcl_atomic_count.h>
 #include <vcl_compiler.h>
 #include <vil/vil_smart_ptr.h>
+#include <vil/vil_memory_allocator.h>
 #include <vil/vil_pixel_format.h>
 
 //: Ref. counted block of data on the heap.
@@ -30,6 +31,10 @@ class vil_memory_chunk
     //: Reference count
     vcl_atomic_count ref_count_;
 
+    //: Source of data_, to which it is returned.
+    // Null if data_ does not belong to an allocator (e.g. in derived classes).
+    vil_memory_allocator* allocator_;
+
  public:
     //: Dflt ctor
     vil_memory_chunk();
@@ -39,6 +44,11 @@ class vil_memory_chunk
     // and should always be a scalar type.
     vil_memory_chunk(std::size_t n, vil_pixel_format pixel_format);
 
+    //: Allocate n bytes of memory from the given allocator.
+    // The allocator must outlive the chunk.
+    vil_memory_chunk(std::size_t n, vil_pixel_format pixel_format,
+                     vil_memory_allocator* allocator);
+
     //: Copy ctor
     vil_memory_chunk(const vil_memory_chunk&);
 
@@ -72,6 +82,19 @@ class vil_memory_chunk
     //: Create space for n bytes
     //  pixel_format indicates what format to be used for binary IO
     virtual void set_size(unsigned long n, vil_pixel_format pixel_format);
+
+    //: Allocator which provided the data, or null if there is none.
+    vil_memory_allocator* allocator() const { return allocator_; }
+
+    //: Allocator used for the data of new chunks, and when a chunk is resized.
+    // Initially vil_memory_allocator_new, or vil_memory_pool::instance() if
+    // the environment variable VIL_MEMORY_POOL is set.
+    static vil_memory_allocator* default_allocator();
+
+    //: Set the allocator used for new chunks; null restores the initial one.
+    // The allocator must outlive every chunk using it.  Set this before
+    // other threads start creating images.
+    static void set_default_allocator(vil_memory_allocator* allocator);
 };
 
 typedef vil_smart_ptr<vil_memory_chunk> vil_memory_chunk_sptr;
@@ -0,0 +1,265 @@
+// This is core/vil/vil_memory_pool.cxx
+//:
+// \file
+
+#include <cstdlib>
+#include <new>
+#include "vil_memory_pool.h"
+#include <vcl_compiler.h>
+#include <vcl_cassert.h>
+#include <vxl_config.h>
+
+#if VXL_FULLCXX11SUPPORT
+# include <mutex>
+#endif
+
+#if defined(_WIN32)
+# include <malloc.h>
+#elif defined(__linux__)
+# include <sys/mman.h>
+#endif
+
+#if VXL_FULLCXX11SUPPORT
+class vil_memory_pool_mutex : public std::mutex {};
+#else
+// No portable threads: nothing to lock.
+class vil_memory_pool_mutex
+{
+ public:
+  void lock() {}
+  void unlock() {}
+};
+#endif
+
+//: Holds a vil_memory_pool_mutex for the lifetime of the object.
+class vil_memory_pool_lock
+{
+ public:
+  explicit vil_memory_pool_lock(vil_memory_pool_mutex* m) : m_(m) { m_->lock(); }
+  ~vil_memory_pool_lock() { m_->unlock(); }
+ private:
+  vil_memory_pool_mutex* m_;
+};
+
+//: Blocks of at least this size are candidates for huge pages.
+static const std::size_t vil_memory_pool_huge_page = std::size_t(2) << 20;
+
+//: Size class of a request for n>0 bytes: four classes per power of two.
+// For 2^k < n <= 2^(k+1) the classes hold 5, 6, 7 or 8 times 2^(k-2) bytes.
+static unsigned vil_memory_pool_class(std::size_t n)
+{
+  if (n <= 4)
+    return 0;
+  const std::size_t b = n - 1;
+  const unsigned bits = unsigned(sizeof(std::size_t))*8;
+  unsigned k = 2;
+  while (k+1 < bits && (b >> (k+1)) != 0) ++k; // k = floor(log2(b))
+  return (k-2)*4 + unsigned((b >> (k-2)) & 3) + 1;
+}
+
+static std::size_t vil_memory_pool_class_bytes(unsigned c)
+{
+  if (c == 0)
+    return 4;
+  const unsigned k = 2 + (c-1)/4;
+  return std::size_t(5 + (c-1)%4) << (k-2);
+}
+
+vil_memory_pool::vil_memory_pool(std::size_t max_cached_bytes,
+                                 std::size_t min_block_bytes,
+                                 std::size_t alignment,
+                                 bool huge_pages)
+: max_cached_bytes_(max_cached_bytes),
+  min_block_bytes_(min_block_bytes),
+  alignment_(alignment < sizeof(void*) ? sizeof(void*) : alignment),
+  huge_pages_(huge_pages),
+  free_(vil_memory_pool_class(~std::size_t(0)) + 1),
+  mutex_(new vil_memory_pool_mutex)
+{
+  assert((alignment_ & (alignment_-1)) == 0);
+}
+
+vil_memory_pool::~vil_memory_pool()
+{
+  release();
+  delete mutex_;
+}
+
+std::size_t vil_memory_pool::block_size(std::size_t n) const
+{
+  if (n < min_block_bytes_)
+    return n;
+  return vil_memory_pool_class_bytes(vil_memory_pool_class(n));
+}
+
+//: Obtain n>0 suitably aligned bytes from the system.
+void* vil_memory_pool::system_allocate(std::size_t n) const
+{
+  std::size_t align = alignment_;
+  const bool huge = huge_pages_ && n >= vil_memory_pool_huge_page;
+  if (huge && align < vil_memory_pool_huge_page)
+    align = vil_memory_pool_huge_page;
+#if defined(_WIN32)
+  void* p = _aligned_malloc(n, align);
+#else
+  void* p = VXL_NULLPTR;
+  if (posix_memalign(&p, align, n) != 0)
+    p = VXL_NULLPTR;
+#endif
+  if (!p)
+    throw std::bad_alloc();
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (huge)
+    madvise(p, n, MADV_HUGEPAGE); // only advice: ignore failure
+#endif
+  return p;
+}
+
+void vil_memory_pool::system_deallocate(void* p) const
+{
+#if defined(_WIN32)
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+void* vil_memory_pool::allocate(std::size_t n)
+{
+  if (n < min_block_bytes_)
+  {
+    void* p = system_allocate(n > 0 ? n : 1);
+    vil_memory_pool_lock lock(mutex_);
+    ++stats_.misses;
+    stats_.bytes_in_use += n;
+    return p;
+  }
+  const unsigned c = vil_memory_pool_class(n);
+  const std::size_t size = vil_memory_pool_class_bytes(c);
+  {
+    vil_memory_pool_lock lock(mutex_);
+    if (!free_[c].empty())
+    {
+      void* p = free_[c].back();
+      free_[c].pop_back();
+      ++stats_.hits;
+      stats_.bytes_cached -= size;
+      stats_.bytes_in_use += size;
+      return p;
+    }
+  }
+  void* p = system_allocate(size);
+  vil_memory_pool_lock lock(mutex_);
+  ++stats_.misses;
+  stats_.bytes_in_use += size;
+  return p;
+}
+
+void vil_memory_pool::deallocate(void* p, std::size_t n)
+{
+  if (!p)
+    return;
+  if (n < min_block_bytes_)
+  {
+    {
+      vil_memory_pool_lock lock(mutex_);
+      stats_.bytes_in_use -= n;
+    }
+    system_deallocate(p);
+    return;
+  }
+  const unsigned c = vil_memory_pool_class(n);
+  const std::size_t size = vil_memory_pool_class_bytes(c);
+  std::vector<void*> to_free;
+  {
+    vil_memory_pool_lock lock(mutex_);
+    stats_.bytes_in_use -= size;
+    if (size > max_cached_bytes_)
+    {
+      ++stats_.discards;
+      to_free.push_back(p);
+    }
+    else
+    {
+      // Keep the block just freed in preference to older ones.
+      trim(max_cached_bytes_ - size, to_free);
+      free_[c].push_back(p);
+      stats_.bytes_cached += size;
+      ++stats_.returns;
+    }
+  }
+  for (unsigned i = 0; i < to_free.size(); ++i)
+    system_deallocate(to_free[i]);
+}
+
+void vil_memory_pool::trim(std::size_t n, std::vector<void*>& to_free)
+{
+  for (unsigned c = unsigned(free_.size()); c-- > 0 && stats_.bytes_cached > n; )
+  {
+    const std::size_t size = vil_memory_pool_class_bytes(c);
+    while (!free_[c].empty() && stats_.bytes_cached > n)
+    {
+      to_free.push_back(free_[c].back());
+      free_[c].pop_back();
+      stats_.bytes_cached -= size;
+      ++stats_.discards;
+    }
+  }
+}
+
+void vil_memory_pool::release()
+{
+  std::vector<void*> to_free;
+  {
+    vil_memory_pool_lock lock(mutex_);
+    for (unsigned c = 0; c < free_.size(); ++c)
+    {
+      to_free.insert(to_free.end(), free_[c].begin(), free_[c].end());
+      free_[c].clear();
+    }
+    stats_.bytes_cached = 0;
+  }
+  for (unsigned i = 0; i < to_free.size(); ++i)
+    system_deallocate(to_free[i]);
+}
+
+void vil_memory_pool::set_max_cached_bytes(std::size_t n)
+{
+  std::vector<void*> to_free;
+  {
+    vil_memory_pool_lock lock(mutex_);
+    max_cached_bytes_ = n;
+    trim(n, to_free);
+  }
+  for (unsigned i = 0; i < to_free.size(); ++i)
+    system_deallocate(to_free[i]);
+}
+
+vil_memory_pool_stats vil_memory_pool::stats() const
+{
+  vil_memory_pool_lock lock(mutex_);
+  return stats_;
+}
+
+void vil_memory_pool::reset_stats()
+{
+  vil_memory_pool_lock lock(mutex_);
+  stats_.hits = stats_.misses = stats_.returns = stats_.discards = 0;
+}
+
+//: The pool behind vil_memory_pool::instance().
+static vil_memory_pool* vil_memory_pool_create_instance()
+{
+  std::size_t megabytes = 256;
+  if (const char* env = std::getenv("VIL_MEMORY_POOL"))
+    if (std::atoi(env) > 0)
+      megabytes = std::size_t(std::atoi(env));
+  return new vil_memory_pool(megabytes << 20);
+}
+
+vil_memory_pool& vil_memory_pool::instance()
+{
+  // Never destroyed, so chunks in static objects can still free their data.
+  static vil_memory_pool* the_pool = vil_memory_pool_create_instance();
+  return *the_pool;
+}
@@ -0,0 +1,118 @@
+// This is core/vil/vil_memory_pool.h
+#ifndef vil_memory_pool_h_
+#define vil_memory_pool_h_
+//:
+// \file
+// \brief A vil_memory_allocator which recycles freed image buffers
+//
+// Pipelines which create and drop images of the same size for every frame
+// spend much of their time having the system find, and the processor
+// page-fault in, fresh multi-megabyte buffers.  vil_memory_pool keeps the
+// freed blocks instead, sorted into size classes (four per power of two,
+// so at most a fifth of a block is wasted), and hands them out again.
+//
+// To use a pool for every new image:
+// \code
+//   vil_memory_chunk::set_default_allocator(&vil_memory_pool::instance());
+// \endcode
+// or set the environment variable VIL_MEMORY_POOL to the number of
+// megabytes the pool may keep, e.g. VIL_MEMORY_POOL=512.
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <cstddef>
+#include <vector>
+#include <vcl_compiler.h>
+#include <vil/vil_memory_allocator.h>
+
+class vil_memory_pool_mutex;
+
+//: Counters of a vil_memory_pool.
+struct vil_memory_pool_stats
+{
+  //: Allocations served from the pool.
+  std::size_t hits;
+  //: Allocations passed to the system, including those too small to pool.
+  std::size_t misses;
+  //: Freed blocks kept for reuse.
+  std::size_t returns;
+  //: Freed blocks given back to the system because the pool was full.
+  std::size_t discards;
+  //: Bytes in blocks held for reuse.
+  std::size_t bytes_cached;
+  //: Bytes in blocks currently handed out.
+  std::size_t bytes_in_use;
+
+  vil_memory_pool_stats()
+  : hits(0), misses(0), returns(0), discards(0), bytes_cached(0), bytes_in_use(0) {}
+};
+
+//: A vil_memory_allocator which recycles freed blocks.
+// All member functions are thread safe when built with C++11 threads.
+class vil_memory_pool : public vil_memory_allocator
+{
+ public:
+  //: Create an empty pool.
+  // \param max_cached_bytes  Most bytes kept in freed blocks.  A block which
+  //        would take the pool over this is returned to the system.
+  // \param min_block_bytes  Requests smaller than this are not pooled.
+  // \param alignment  Alignment of every block; a power of two.
+  // \param huge_pages  Where supported (Linux), align blocks of 2MB or more
+  //        to 2MB and ask for them to be backed by transparent huge pages.
+  explicit vil_memory_pool(std::size_t max_cached_bytes = std::size_t(256) << 20,
+                           std::size_t min_block_bytes = 4096,
+                           std::size_t alignment = 64,
+                           bool huge_pages = false);
+
+  //: Frees the cached blocks.  Blocks still in use must not be freed later.
+  ~vil_memory_pool() VXL_OVERRIDE;
+
+  void* allocate(std::size_t n) VXL_OVERRIDE;
+  void deallocate(void* p, std::size_t n) VXL_OVERRIDE;
+
+  //: Give all cached blocks back to the system.
+  void release();
+
+  //: Change the most bytes kept in freed blocks, releasing blocks if necessary.
+  void set_max_cached_bytes(std::size_t n);
+  std::size_t max_cached_bytes() const { return max_cached_bytes_; }
+
+  //: Current counters.
+  vil_memory_pool_stats stats() const;
+
+  //: Set the hit, miss, return and discard counters to zero.
+  void reset_stats();
+
+  //: Number of bytes actually reserved for a request of n bytes.
+  std::size_t block_size(std::size_t n) const;
+
+  //: A pool shared by the whole program, which is never destroyed.
+  // Its budget is VIL_MEMORY_POOL megabytes if that is set, and 256MB otherwise.
+  static vil_memory_pool& instance();
+
+ private:
+  // Not copyable.
+  vil_memory_pool(const vil_memory_pool&);
+  vil_memory_pool& operator=(const vil_memory_pool&);
+
+  void* system_allocate(std::size_t n) const;
+  void system_deallocate(void* p) const;
+  //: Free cached blocks, largest classes first, until at most n bytes are cached.  Mutex held.
+  void trim(std::size_t n, std::vector<void*>& to_free);
+
+  std::size_t max_cached_bytes_;
+  std::size_t min_block_bytes_;
+  std::size_t alignment_;
+  bool huge_pages_;
+
+  //: Freed blocks of each size class.
+  std::vector<std::vector<void*> > free_;
+  vil_memory_pool_stats stats_;
+
+  //: Protects free_ and stats_.
+  vil_memory_pool_mutex* mutex_;
+};
+
+#endif // vil_memory_pool_h_
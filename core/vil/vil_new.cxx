@@ -205,9 +205,10 @@ vil_new_blocked_image_facade(const vil_image_resource_sptr& src,
 
 vil_blocked_image_resource_sptr
 vil_new_cached_image_resource(const vil_blocked_image_resource_sptr& bir,
-                              const unsigned cache_size)
+                              const unsigned cache_size,
+                              const std::size_t byte_capacity)
 {
-  return new vil_cached_image_resource(bir, cache_size);
+  return new vil_cached_image_resource(bir, cache_size, byte_capacity);
 }
 
 vil_pyramid_image_resource_sptr
@@ -23,6 +23,7 @@
 //   30 Mar 2007 Peter Vanroose- Removed deprecated vil_new_image_view_j_i_plane
 // \endverbatim
 
+#include <cstddef>
 #include <vil/vil_fwd.h>
 #include <vil/vil_image_resource.h>
 #include <vil/vil_blocked_image_resource.h>
@@ -114,9 +115,12 @@ vil_new_blocked_image_facade(const vil_image_resource_sptr& src,
                              const unsigned size_block_i=0,
                              const unsigned size_block_j=0);
 //: Make a new cached resource
+// If byte_capacity is non-zero the cache also holds no more than that many
+// bytes of pixel data.
 vil_blocked_image_resource_sptr
 vil_new_cached_image_resource(const vil_blocked_image_resource_sptr& bir,
-                              const unsigned cache_size = 100);
+                              const unsigned cache_size = 100,
+                              const std::size_t byte_capacity = 0);
 
 
 //: Make a new pyramid image resource for writing.
@@ -0,0 +1,221 @@
+// This is core/vil/vil_parallel.cxx
+//:
+// \file
+
+#include <algorithm>
+#include <cstdlib>
+#include "vil_parallel.h"
+#include <vcl_compiler.h>
+#include <vxl_config.h>
+
+#if VXL_FULLCXX11SUPPORT
+# include <atomic>
+# include <condition_variable>
+# include <mutex>
+# include <thread>
+#endif
+
+//: Value of VIL_NUM_THREADS, or the number of hardware threads.
+static unsigned vil_parallel_default_threads()
+{
+#if VXL_FULLCXX11SUPPORT
+  if (const char* env = std::getenv("VIL_NUM_THREADS"))
+  {
+    const int n = std::atoi(env);
+    if (n > 0)
+      return unsigned(n);
+  }
+  const unsigned n = std::thread::hardware_concurrency();
+  return n > 0 ? n : 1;
+#else
+  return 1;
+#endif
+}
+
+// Read and set from any thread; 0 until first used.
+#if VXL_FULLCXX11SUPPORT
+static std::atomic<unsigned> vil_parallel_threads_setting(0);
+#else
+static unsigned vil_parallel_threads_setting = 0;
+#endif
+
+unsigned vil_parallel_max_threads()
+{
+  unsigned n = vil_parallel_threads_setting;
+  if (n == 0)
+  {
+    n = vil_parallel_default_threads();
+#if VXL_FULLCXX11SUPPORT
+    // keep a value set by another thread meanwhile
+    unsigned unset = 0;
+    if (!vil_parallel_threads_setting.compare_exchange_strong(unset, n))
+      n = unset;
+#else
+    vil_parallel_threads_setting = n;
+#endif
+  }
+  return n;
+}
+
+void vil_parallel_set_max_threads(unsigned n)
+{
+#if VXL_FULLCXX11SUPPORT
+  vil_parallel_threads_setting = n;
+#else
+  (void)n;
+#endif
+}
+
+static void vil_parallel_run_serial(vil_parallel_job& job, unsigned n)
+{
+  for (unsigned k = 0; k < n; ++k)
+    job.run(k);
+}
+
+#if VXL_FULLCXX11SUPPORT
+
+//: True on the pool's worker threads, and on a thread while it runs a job.
+static thread_local bool vil_parallel_in_job = false;
+
+//: Worker threads waiting for jobs.
+// Only one job runs at a time.  The indices of the job are handed out
+// through an atomic counter, so faster threads simply take more of them.
+class vil_parallel_pool
+{
+ public:
+  vil_parallel_pool() : job_(VXL_NULLPTR), n_(0), n_helpers_(0), n_finished_(0),
+                        generation_(0), stop_(false), next_(0) {}
+
+  ~vil_parallel_pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (unsigned t = 0; t < workers_.size(); ++t)
+      workers_[t].join();
+  }
+
+  //: Run the job using the calling thread and n_helpers workers.
+  // Returns false, having done nothing, if the pool is already in use.
+  bool run(vil_parallel_job& job, unsigned n, unsigned n_helpers)
+  {
+    std::unique_lock<std::mutex> busy(busy_, std::try_to_lock);
+    if (!busy.owns_lock())
+      return false;
+    while (workers_.size() < n_helpers)
+      workers_.push_back(std::thread(&vil_parallel_pool::work, this, unsigned(workers_.size())));
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job_ = &job;
+      n_ = n;
+      next_ = 0;
+      n_helpers_ = n_helpers;
+      n_finished_ = 0;
+      ++generation_;
+    }
+    wake_.notify_all();
+
+    vil_parallel_in_job = true;
+    take_indices(job, n);
+    vil_parallel_in_job = false;
+
+    // The job must stay alive until every helper has stopped using it.
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (n_finished_ < n_helpers_)
+      done_.wait(lock);
+    job_ = VXL_NULLPTR;
+    return true;
+  }
+
+ private:
+  void take_indices(vil_parallel_job& job, unsigned n)
+  {
+    for (unsigned k = next_++; k < n; k = next_++)
+      job.run(k);
+  }
+
+  void work(unsigned id)
+  {
+    vil_parallel_in_job = true;
+    unsigned seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+      while (!stop_ && generation_ == seen)
+        wake_.wait(lock);
+      if (stop_)
+        return;
+      seen = generation_;
+      if (id >= n_helpers_)
+        continue;
+      vil_parallel_job* job = job_;
+      const unsigned n = n_;
+      lock.unlock();
+      take_indices(*job, n);
+      lock.lock();
+      if (++n_finished_ == n_helpers_)
+        done_.notify_one();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex busy_;   // held while a job runs
+  std::mutex mutex_;  // guards the members below
+  std::condition_variable wake_, done_;
+  vil_parallel_job* job_;
+  unsigned n_;
+  unsigned n_helpers_;
+  unsigned n_finished_;
+  unsigned generation_;
+  bool stop_;
+  std::atomic<unsigned> next_;
+};
+
+static vil_parallel_pool& vil_parallel_the_pool()
+{
+  static vil_parallel_pool pool;
+  return pool;
+}
+
+void vil_parallel_run(vil_parallel_job& job, unsigned n, unsigned n_threads)
+{
+  if (n_threads == 0)
+    n_threads = vil_parallel_max_threads();
+  const unsigned n_helpers = std::min(n_threads, n) - (n > 0 ? 1 : 0);
+  if (n_helpers == 0 || vil_parallel_in_job || !vil_parallel_the_pool().run(job, n, n_helpers))
+    vil_parallel_run_serial(job, n);
+}
+
+#else // VXL_FULLCXX11SUPPORT
+
+void vil_parallel_run(vil_parallel_job& job, unsigned n, unsigned)
+{
+  vil_parallel_run_serial(job, n);
+}
+
+#endif // VXL_FULLCXX11SUPPORT
+
+unsigned vil_parallel_n_bands(unsigned nj, unsigned halo, const vil_parallel_policy& policy)
+{
+  const unsigned n_threads = policy.n_threads > 0 ? policy.n_threads : vil_parallel_max_threads();
+  const unsigned min_rows = std::max(policy.min_band_rows, 2*halo+1);
+  return std::max(1u, std::min(n_threads, nj / min_rows));
+}
+
+void vil_parallel_row_bands(unsigned nj, unsigned halo, unsigned n_bands,
+                            std::vector<vil_parallel_band>& bands)
+{
+  n_bands = std::min(std::max(1u, n_bands), nj);
+  bands.resize(n_bands);
+  for (unsigned b = 0; b < n_bands; ++b)
+  {
+    vil_parallel_band& band = bands[b];
+    band.j0 = unsigned(vxl_uint_64(nj) * b / n_bands);
+    band.j1 = unsigned(vxl_uint_64(nj) * (b+1) / n_bands);
+    band.c0 = band.j0 > halo ? band.j0 - halo : 0;
+    band.c1 = std::min(nj, band.j1 + halo);
+  }
+}
@@ -0,0 +1,83 @@
+// This is core/vil/vil_parallel.h
+#ifndef vil_parallel_h_
+#define vil_parallel_h_
+//:
+// \file
+// \brief A small thread pool for running image operations on several cores
+//
+// vil_parallel_run() spreads the calls job.run(0) ... job.run(n-1) over a
+// pool of worker threads which is created on first use and kept for the
+// rest of the program.  The calling thread takes part as well.
+//
+// Image operations are usually split into bands of whole rows.
+// vil_parallel_row_bands() computes such bands, and for each band the
+// rows which have to be read, including the "halo" of rows above and below
+// needed by a filter of finite support.
+// See vil/algo/vil_parallel_filters.h for filters built on top of this.
+//
+// Without C++11 thread support everything runs serially on the calling thread.
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <vector>
+#include <vcl_compiler.h>
+
+//: Work which may be split between threads.
+// run(k) is called exactly once for every k in [0,n), in no particular
+// order and possibly concurrently, so different k must not write to the
+// same data.
+class vil_parallel_job
+{
+ public:
+  virtual ~vil_parallel_job() {}
+  virtual void run(unsigned k) = 0;
+};
+
+//: How to split an operation between threads.
+struct vil_parallel_policy
+{
+  //: Maximum number of threads to use; 0 means vil_parallel_max_threads().
+  unsigned n_threads;
+  //: Do not make bands with fewer rows than this.
+  unsigned min_band_rows;
+
+  explicit vil_parallel_policy(unsigned threads = 0, unsigned min_rows = 32)
+    : n_threads(threads), min_band_rows(min_rows) {}
+};
+
+//: A band of output rows [j0,j1), which is computed from input rows [c0,c1).
+struct vil_parallel_band
+{
+  unsigned j0, j1;
+  unsigned c0, c1;
+};
+
+//: Number of threads used when not told otherwise.
+// Initially the value of the environment variable VIL_NUM_THREADS, if set,
+// otherwise the number of hardware threads.  Always 1 without thread support.
+unsigned vil_parallel_max_threads();
+
+//: Set the number of threads used when not told otherwise.
+// 0 restores the initial value.
+void vil_parallel_set_max_threads(unsigned n);
+
+//: Call job.run(k) for k=0..n-1 using up to n_threads threads.
+// n_threads==0 means vil_parallel_max_threads().  Returns when all the calls
+// have finished.  Calls made from inside a job, or while another thread is
+// using the pool, are run serially on the calling thread.
+void vil_parallel_run(vil_parallel_job& job, unsigned n, unsigned n_threads = 0);
+
+//: Number of bands into which to split nj rows.
+// Each band is given at least policy.min_band_rows rows, and at least
+// 2*halo+1 so that the rows read twice never outnumber the rows computed.
+unsigned vil_parallel_n_bands(unsigned nj, unsigned halo, const vil_parallel_policy& policy);
+
+//: Split rows [0,nj) into n_bands bands of nearly equal height.
+// The input rows of each band are extended by halo rows either side,
+// clipped to [0,nj).  There are never more bands than rows.
+void vil_parallel_row_bands(unsigned nj, unsigned halo, unsigned n_bands,
+                            std::vector<vil_parallel_band>& bands);
+
+#endif // vil_parallel_h_
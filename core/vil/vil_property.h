@@ -81,5 +81,11 @@
 //: true if image resource is a pyramid image
 #define vil_property_pyramid "pyramid"
 
+//: Position of the pixels in the file, for images which can be memory-mapped.
+// Only file images whose pixels are stored uncompressed, in the host's
+// byte order and with a regular layout implement this property.
+// Type is vil_file_layout (see vil_mapped_image_resource.h).
+#define vil_property_file_layout "file_layout"
+
 
 #endif // vil_property_h_
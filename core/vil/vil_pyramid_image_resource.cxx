@@ -2,7 +2,10 @@
 #ifdef VCL_NEEDS_PRAGMA_INTERFACE
 #pragma implementation
 #endif
+#include <algorithm>
 #include <cstring>
+#include <iostream>
+#include <string>
 #include <vector>
 #include "vil_pyramid_image_resource.h"
 //:
@@ -16,6 +19,7 @@
 #include <vil/vil_image_view.h>
 #include <vil/vil_new.h>
 #include <vil/vil_load.h>
+#include <vil/vil_parallel.h>
 
 
 vil_pyramid_image_resource::vil_pyramid_image_resource()
@@ -297,61 +301,251 @@ blocked_decimate(vil_blocked_image_resource_sptr const& brsc,
   }
 }
 
+//: Decimate a 2x2 neighbourhood of blocks into a block of the same size.
+// Each component is averaged in float and cast back, as in blocked_decimate().
+template <class T>
+static vil_image_view_base_sptr
+vil_pyramid_decimate_blocks(vil_image_view_base_sptr const nbrhd[2][2])
+{
+  vil_image_view<T> b[2][2];
+  for (unsigned int r = 0; r<2; ++r)
+    for (unsigned int c = 0; c<2; ++c)
+      b[r][c] = nbrhd[r][c];
+  const unsigned int sbi = b[0][0].ni(), sbj = b[0][0].nj(), np = b[0][0].nplanes();
+  // Each output pixel averages a 2x2 patch of a single input block.
+  assert(sbi>=2 && sbj>=2 && sbi%2==0 && sbj%2==0);
+  for (unsigned int r = 0; r<2; ++r)
+    for (unsigned int c = 0; c<2; ++c)
+      assert(b[r][c].ni()==sbi && b[r][c].nj()==sbj && b[r][c].nplanes()==np);
+  vil_image_view<T>* dec = new vil_image_view<T>(sbi, sbj, np);
+  for (unsigned int p = 0; p<np; ++p)
+    for (unsigned int dj = 0; dj<sbj; ++dj)
+    {
+      const unsigned int r = 2*dj>=sbj ? 1 : 0, j0 = 2*dj - r*sbj;
+      for (unsigned int di = 0; di<sbi; ++di)
+      {
+        const unsigned int c = 2*di>=sbi ? 1 : 0, i0 = 2*di - c*sbi;
+        const vil_image_view<T>& blk = b[r][c];
+        float v = 0.25f*(float(blk(i0,j0,p))+float(blk(i0+1,j0,p))+
+                         float(blk(i0,j0+1,p))+float(blk(i0+1,j0+1,p)));
+        (*dec)(di,dj,p) = static_cast<T>(v);
+      }
+    }
+  return dec;
+}
+
+typedef vil_image_view_base_sptr (*vil_pyramid_decimate_fn)(vil_image_view_base_sptr const nbrhd[2][2]);
+
+//: The decimation function for a pixel format, or 0 if it is not supported.
+static vil_pyramid_decimate_fn vil_pyramid_decimate_function(vil_pixel_format fmt)
+{
+  switch (fmt)
+  {
+   case VIL_PIXEL_FORMAT_BYTE:   return &vil_pyramid_decimate_blocks<vxl_byte>;
+   case VIL_PIXEL_FORMAT_UINT_16: return &vil_pyramid_decimate_blocks<vxl_uint_16>;
+   case VIL_PIXEL_FORMAT_UINT_32: return &vil_pyramid_decimate_blocks<vxl_uint_32>;
+#if VXL_HAS_INT_64
+   case VIL_PIXEL_FORMAT_UINT_64: return &vil_pyramid_decimate_blocks<vxl_uint_64>;
+#endif
+   case VIL_PIXEL_FORMAT_FLOAT:  return &vil_pyramid_decimate_blocks<float>;
+   case VIL_PIXEL_FORMAT_DOUBLE: return &vil_pyramid_decimate_blocks<double>;
+   default: return VXL_NULLPTR;
+  }
+}
+
+//: Decimate a pair of rows of blocks, each output block on its own thread.
+class vil_pyramid_decimate_row_job : public vil_parallel_job
+{
+ public:
+  vil_pyramid_decimate_row_job(vil_pyramid_decimate_fn f,
+                               std::vector<vil_image_view_base_sptr> const& upper,
+                               std::vector<vil_image_view_base_sptr> const& lower,
+                               std::vector<vil_image_view_base_sptr>& out)
+  : f_(f), upper_(upper), lower_(lower), out_(out) {}
+
+  void run(unsigned k) VXL_OVERRIDE
+  {
+    const unsigned int nbi = (unsigned int)(upper_.size());
+    vil_image_view_base_sptr nbrhd[2][2];
+    for (unsigned int c = 0; c<2; ++c)
+    {
+      const unsigned int ki = std::min(2*k+c, nbi-1); // repeat the last block
+      nbrhd[0][c] = upper_[ki];
+      nbrhd[1][c] = lower_[ki];
+    }
+    out_[k] = f_(nbrhd);
+  }
+
+ private:
+  vil_pyramid_decimate_fn f_;
+  std::vector<vil_image_view_base_sptr> const& upper_;
+  std::vector<vil_image_view_base_sptr> const& lower_;
+  std::vector<vil_image_view_base_sptr>& out_;
+};
+
+//: Passes rows of blocks down the levels of a pyramid as they become available.
+// Level L receives rows of the image at scale 1/2^L; each pair of them
+// makes a row of blocks of dec_rescs[L], which is then passed to level L+1.
+class vil_pyramid_row_pipeline
+{
+ public:
+  vil_pyramid_row_pipeline(vil_pyramid_decimate_fn f,
+                           std::vector<vil_blocked_image_resource_sptr> const& dec_rescs)
+  : f_(f), dec_rescs_(dec_rescs), upper_(dec_rescs.size()), rows_out_(dec_rescs.size(), 0) {}
+
+  //: Add the next row of blocks of level L.
+  bool push(unsigned int L, std::vector<vil_image_view_base_sptr> const& row)
+  {
+    if (upper_[L].empty())
+    {
+      upper_[L] = row;
+      return true;
+    }
+    std::vector<vil_image_view_base_sptr> upper;
+    upper.swap(upper_[L]);
+    return decimate(L, upper, row);
+  }
+
+  //: Finish levels with an odd number of rows by repeating the last one.
+  bool flush()
+  {
+    for (unsigned int L = 0; L<upper_.size(); ++L)
+      if (!upper_[L].empty())
+      {
+        std::vector<vil_image_view_base_sptr> upper;
+        upper.swap(upper_[L]);
+        if (!decimate(L, upper, upper))
+          return false;
+      }
+    return true;
+  }
+
+ private:
+  bool decimate(unsigned int L,
+                std::vector<vil_image_view_base_sptr> const& upper,
+                std::vector<vil_image_view_base_sptr> const& lower)
+  {
+    const unsigned int n_out = ((unsigned int)(upper.size())+1)/2;
+    std::vector<vil_image_view_base_sptr> out(n_out);
+    vil_pyramid_decimate_row_job job(f_, upper, lower, out);
+    vil_parallel_run(job, n_out);
+    // The output resource need not be thread-safe, so write serially.
+    const unsigned int bj = rows_out_[L]++;
+    for (unsigned int bi = 0; bi<n_out; ++bi)
+      if (!out[bi] || !dec_rescs_[L]->put_block(bi, bj, *out[bi]))
+        return false;
+    return L+1 >= upper_.size() || push(L+1, out);
+  }
+
+  vil_pyramid_decimate_fn f_;
+  std::vector<vil_blocked_image_resource_sptr> const& dec_rescs_;
+  //: The first row of an incomplete pair, for each level.
+  std::vector<std::vector<vil_image_view_base_sptr> > upper_;
+  //: Rows written to each output resource.
+  std::vector<unsigned int> rows_out_;
+};
+
+bool vil_pyramid_image_resource::
+blocked_decimate_levels(vil_blocked_image_resource_sptr const& brsc,
+                        std::vector<vil_blocked_image_resource_sptr> const& dec_rescs)
+{
+  if (!brsc || dec_rescs.empty())
+    return false;
+  const unsigned int nbi = brsc->n_block_i(), nbj = brsc->n_block_j();
+  if (nbi==0||nbj==0)
+    return false;
+  vil_pyramid_decimate_fn f = vil_pyramid_decimate_function(brsc->pixel_format());
+  if (!f)
+    return false;
+  //check for consistent block structure
+  const unsigned int sbi = brsc->size_block_i(), sbj = brsc->size_block_j();
+  for (unsigned int L = 0; L<dec_rescs.size(); ++L)
+    if (!dec_rescs[L] || dec_rescs[L]->size_block_i()!=sbi ||
+        dec_rescs[L]->size_block_j()!=sbj)
+      return false;
+  // The blocks are decimated in 2x2 pixel patches.
+  if (sbi<2 || sbj<2 || sbi%2 || sbj%2)
+    return false;
+
+  vil_pyramid_row_pipeline pipeline(f, dec_rescs);
+  std::vector<vil_image_view_base_sptr> row(nbi);
+  for (unsigned int bj = 0; bj<nbj; ++bj)
+  {
+    for (unsigned int bi = 0; bi<nbi; ++bi)
+      if (!(row[bi] = brsc->get_block(bi, bj)))
+        return false;
+    if (!pipeline.push(0, row))
+      return false;
+  }
+  return pipeline.flush();
+}
+
 vil_image_resource_sptr vil_pyramid_image_resource::
 decimate(vil_image_resource_sptr const& resc, char const* filename,
          char const* format)
 {
-  if (!resc)
-    return VXL_NULLPTR;
+  std::vector<std::string> filenames(1, filename);
+  std::vector<vil_image_resource_sptr> levels =
+    decimate_levels(resc, filenames, format);
+  return levels.empty() ? VXL_NULLPTR : levels[0];
+}
+
+std::vector<vil_image_resource_sptr> vil_pyramid_image_resource::
+decimate_levels(vil_image_resource_sptr const& resc,
+                std::vector<std::string> const& filenames,
+                char const* format)
+{
+  std::vector<vil_image_resource_sptr> levels;
+  if (!resc || filenames.empty())
+    return levels;
   vil_pixel_format fmt = resc->pixel_format();
-  switch (fmt)
+  if (!vil_pyramid_decimate_function(fmt))
   {
-    case VIL_PIXEL_FORMAT_BYTE:
-      break;
-    case VIL_PIXEL_FORMAT_UINT_16:
-      break;
-    case VIL_PIXEL_FORMAT_UINT_32:
-      break;
-#if VXL_HAS_INT_64
-    case VIL_PIXEL_FORMAT_UINT_64:
-      break;
-#endif
-    case VIL_PIXEL_FORMAT_FLOAT:
-      break;
-    case VIL_PIXEL_FORMAT_DOUBLE:
-      break;
-    default:
-      std::cout << "unrecognized pixel format in vil_pyramid_image_resource::decimate()\n";
-      return VXL_NULLPTR;
+    std::cout << "unrecognized pixel format in vil_pyramid_image_resource::decimate()\n";
+    return levels;
   }
   //first determine if the resource is blocked, if not create a facade
   vil_blocked_image_resource_sptr brsc = blocked_image_resource(resc);
   if (brsc&&(brsc->size_block_i()%2!=0||brsc->size_block_j()%2!=0))
   {
     std::cout << "Blocked pyramid images must have even block sizes\n";
-    return VXL_NULLPTR;
+    return levels;
   }
   if (!brsc)
     brsc = new vil_blocked_image_facade(resc);
 
-  // create the output decimated resource
-  { //file scope to close resource
-    unsigned int rni = resc->ni(), rnj = resc->nj();
-    unsigned int np = resc->nplanes();
-    //if source image has even dimensions then just divide by 2
-    unsigned int dni = rni/2, dnj = rnj/2;
-    //else if the dimension is odd, increase the output size by 1.
-    dni += rni%2; dnj += rnj%2;
-    vil_blocked_image_resource_sptr dec_resc =
-      vil_new_blocked_image_resource(filename, dni, dnj, np,
-                                     fmt, brsc->size_block_i(),
-                                     brsc->size_block_j(),
-                                     format);
-    //fill the resource with decimated blocks.
-    if (!blocked_decimate(brsc, dec_resc))
-      return VXL_NULLPTR;
-  } //file scope to close resource
-  //reopen resource for reading
-  vil_image_resource_sptr temp = vil_load_image_resource(filename);
-  return temp;
+  // create the output decimated resources
+  { //file scope to close resources
+    std::vector<vil_blocked_image_resource_sptr> dec_rescs;
+    unsigned int dni = resc->ni(), dnj = resc->nj();
+    for (unsigned int L = 0; L<filenames.size(); ++L)
+    {
+      //if the dimension is odd, increase the output size by 1.
+      dni = (dni+1)/2; dnj = (dnj+1)/2;
+      vil_blocked_image_resource_sptr dec_resc =
+        vil_new_blocked_image_resource(filenames[L].c_str(), dni, dnj,
+                                       resc->nplanes(), fmt,
+                                       brsc->size_block_i(),
+                                       brsc->size_block_j(),
+                                       format);
+      if (!dec_resc)
+        return levels;
+      dec_rescs.push_back(dec_resc);
+    }
+    //fill the resources with decimated blocks.
+    if (!blocked_decimate_levels(brsc, dec_rescs))
+      return levels;
+  } //file scope to close resources
+  //reopen resources for reading
+  for (unsigned int L = 0; L<filenames.size(); ++L)
+  {
+    vil_image_resource_sptr level = vil_load_image_resource(filenames[L].c_str());
+    if (!level)
+    {
+      levels.clear();
+      break;
+    }
+    levels.push_back(level);
+  }
+  return levels;
 }
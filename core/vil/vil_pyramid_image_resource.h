@@ -11,6 +11,7 @@
 // \author J. L. Mundy
 // \date 19 March 2006
 
+#include <string>
 #include <vector>
 #include <vcl_compiler.h>
 #include <vil/vil_image_view_base.h>
@@ -126,6 +127,27 @@ class vil_pyramid_image_resource : public vil_image_resource
                                           char const* filename,
                                           char const* format="tiff");
 
+  //: Decimate a blocked resource into several levels at once.
+  // dec_rescs[k] receives the image at scale 1/2^(k+1) of brsc, and must
+  // have the same block size as brsc.  Each block of brsc is read once, and
+  // only two rows of blocks are held for each level, whatever the size of
+  // the image.  The blocks of each row are decimated on several threads
+  // (see vil_parallel.h).  The result is the same as that of calling
+  // blocked_decimate() on each level in turn, except where it depends on
+  // the undefined pixels beyond the edge of the image in a block of the
+  // level above: there the decimated blocks are used as they were written.
+  static bool
+    blocked_decimate_levels(vil_blocked_image_resource_sptr const& brsc,
+                            std::vector<vil_blocked_image_resource_sptr> const& dec_rescs);
+
+  //: Create several decimated levels of a resource at once.
+  // filenames[k] receives the image at scale 1/2^(k+1) of resc.  The new
+  // files are reopened for reading; an empty vector is returned on failure.
+  static std::vector<vil_image_resource_sptr>
+    decimate_levels(vil_image_resource_sptr const& resc,
+                    std::vector<std::string> const& filenames,
+                    char const* format="tiff");
+
   //: for debug purposes
   virtual void print(const unsigned level) = 0;
 
@@ -0,0 +1,2 @@
+#include <vnl/algo/vnl_fft_plan.hxx>
+VNL_FFT_PLAN_INSTANTIATE(float);
@@ -3,15 +3,20 @@
   fsm
 */
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 #include <vcl_compiler.h>
 
 #include <vnl/vnl_vector.h>
 #include <vnl/vnl_matrix.h>
 #include <vnl/vnl_matlab_print.h>
 #include <vnl/vnl_random.h>
+#include <vnl/vnl_math.h>
 
 #include <vnl/algo/vnl_fft_1d.h>
 #include <vnl/algo/vnl_fft_2d.h>
+#include <vnl/algo/vnl_fft_plan.h>
 
 #include <testlib/testlib_test.h>
 
@@ -61,10 +66,110 @@ void test_fft_2d(unsigned int M, unsigned int N)
   TEST_NEAR("test fwd-bwd", err, 0.0, 1e-10);
 }
 
+//: X_k = sum_j x_j exp(dir i 2 pi jk/n), computed directly.
+static std::vector<std::complex<double> > direct_dft(std::vector<std::complex<double> > const& x, int dir)
+{
+  const unsigned n = x.size();
+  std::vector<std::complex<double> > X(n);
+  for (unsigned k=0; k<n; ++k)
+    for (unsigned j=0; j<n; ++j) {
+      double a = dir * vnl_math::twopi * double((j*k) % n) / n;
+      X[k] += x[j] * std::complex<double>(std::cos(a), std::sin(a));
+    }
+  return X;
+}
+
+static double max_diff(std::vector<std::complex<double> > const& a, std::vector<std::complex<double> > const& b)
+{
+  double d = 0;
+  for (unsigned i=0; i<a.size(); ++i)
+    d = std::max(d, std::abs(a[i] - b[i]));
+  return d;
+}
+
+//: compare the plan of length N with a direct DFT, in both directions and on strided signals.
+void test_fft_plan(unsigned int N)
+{
+  std::cout << "length " << N << (vnl_fft_plan<double>::is_smooth(N) ? " (smooth)" : "") << '\n';
+  vnl_random rng;
+  std::vector<std::complex<double> > signal(N);
+  test_util_fill_random(&signal[0], &signal[0] + N, rng);
+
+  vnl_fft_plan<double> const& plan = vnl_fft_plan<double>::get(N);
+  TEST("plan size", plan.size(), N);
+  TEST("plan is shared", &vnl_fft_plan<double>::get(N), &plan);
+  for (int dir=-1; dir<=1; dir+=2) {
+    std::vector<std::complex<double> > tmp = signal;
+    plan.transform(&tmp[0], dir);
+    TEST_NEAR("transform matches direct DFT", max_diff(tmp, direct_dft(signal, dir)), 0.0, 1e-10*N);
+  }
+
+  // three signals, interleaved
+  const unsigned lot = 3;
+  std::vector<std::complex<double> > lots(N*lot);
+  for (unsigned l=0; l<lot; ++l)
+    for (unsigned i=0; i<N; ++i)
+      lots[i*lot+l] = signal[i] * double(l+1);
+  plan.transform(&lots[0], +1, lot, 1, lot);
+  std::vector<std::complex<double> > expected = direct_dft(signal, +1);
+  double err = 0;
+  for (unsigned l=0; l<lot; ++l)
+    for (unsigned i=0; i<N; ++i)
+      err = std::max(err, std::abs(lots[i*lot+l] - expected[i] * double(l+1)));
+  TEST_NEAR("interleaved signals match direct DFT", err, 0.0, 1e-10*N);
+}
+
+//: compare real transforms of length N with the complex ones.
+template <class T>
+void test_fft_real(unsigned int N, double tol)
+{
+  std::cout << "real length " << N << '\n';
+  vnl_random rng;
+  std::vector<T> signal(N);
+  std::vector<std::complex<T> > full(N);
+  for (unsigned i=0; i<N; ++i)
+    full[i] = signal[i] = T(rng.drand64(-1, 1));
+
+  vnl_fft_real_plan<T> const& plan = vnl_fft_real_plan<T>::get(N);
+  TEST("number of coefficients", plan.n_coeffs(), N/2+1);
+  for (int dir=-1; dir<=1; dir+=2) {
+    std::vector<std::complex<T> > expected = full;
+    vnl_fft_plan<T>::get(N).transform(&expected[0], dir);
+    std::vector<std::complex<T> > coeffs(plan.n_coeffs());
+    plan.real_to_complex(&signal[0], &coeffs[0], dir);
+    double err = 0;
+    for (unsigned k=0; k<coeffs.size(); ++k)
+      err = std::max(err, double(std::abs(coeffs[k] - expected[k])));
+    TEST_NEAR("real_to_complex matches complex transform", err, 0.0, tol*N);
+
+    std::vector<T> back(N);
+    plan.complex_to_real(&coeffs[0], &back[0], -dir);
+    err = 0;
+    for (unsigned i=0; i<N; ++i)
+      err = std::max(err, double(std::abs(back[i]/T(N) - signal[i])));
+    TEST_NEAR("complex_to_real inverts real_to_complex", err, 0.0, tol*N);
+  }
+}
+
 void test_fft()
 {
   test_fft_1d(24);
+  test_fft_1d(97);
   test_fft_2d(25, 30);
+  test_fft_2d(17, 22);
+
+  test_fft_plan(1);
+  test_fft_plan(24);
+  test_fft_plan(25);
+  test_fft_plan(97);
+  test_fft_plan(14);
+  TEST("next_smooth", vnl_fft_plan<double>::next_smooth(97), 100u);
+
+  const unsigned real_sizes[] = { 1, 2, 3, 16, 17, 30, 97, 98 };
+  for (unsigned i=0; i<sizeof(real_sizes)/sizeof(real_sizes[0]); ++i) {
+    test_fft_real<double>(real_sizes[i], 1e-12);
+    test_fft_real<float>(real_sizes[i], 1e-5);
+  }
 }
 
 TESTMAIN (test_fft);
@@ -49,5 +49,6 @@
 
 #include <vnl/algo/vnl_fft_base.h>
 #include <vnl/algo/vnl_fft_prime_factors.h>
+#include <vnl/algo/vnl_fft_plan.h>
 
 int main() { return 0; }
@@ -28,11 +28,11 @@ struct vnl_fft_1d : public vnl_fft_base<1, T>
 
   //: constructor takes length of signal.
   vnl_fft_1d(int N) {
-    base::factors_[0].resize(N);
+    base::set_size(0, N);
   }
 
   //: return length of signal.
-  unsigned int size() const { return base::factors_[0].number(); }
+  unsigned int size() const { return base::size(0); }
 
   //: dir = +1/-1 according to direction of transform.
   void transform(std::vector<std::complex<T> > &signal, int dir)
@@ -21,8 +21,8 @@ struct vnl_fft_2d : public vnl_fft_base<2, T>
 
   //: constructor takes size of signal.
   vnl_fft_2d(int M, int N) {
-    base::factors_[0].resize(M);
-    base::factors_[1].resize(N);
+    base::set_size(0, M);
+    base::set_size(1, N);
   }
 
   //: dir = +1/-1 according to direction of transform.
@@ -38,8 +38,8 @@ struct vnl_fft_2d : public vnl_fft_base<2, T>
   { transform(signal, -1); }
 
   //: return size of signal.
-  unsigned rows() const { return base::factors_[0].number(); }
-  unsigned cols() const { return base::factors_[1].number(); }
+  unsigned rows() const { return base::size(0); }
+  unsigned cols() const { return base::size(1); }
 };
 
 #endif // vnl_fft_2d_h_
@@ -12,21 +12,28 @@
 #include <complex>
 #include <vcl_compiler.h>
 #include <vnl/algo/vnl_algo_export.h>
-#include <vnl/algo/vnl_fft_prime_factors.h>
+#include <vnl/algo/vnl_fft_plan.h>
 
 //: Base class for in-place ND fast Fourier transform.
+// The signal dimensions may have any length; see vnl_fft_plan.
 
 VCL_TEMPLATE_EXPORT template <int D, class T>
 struct vnl_fft_base
 {
-  vnl_fft_base() { }
+  vnl_fft_base() { for (int i=0; i<D; ++i) plans_[i] = VXL_NULLPTR; }
 
   //: dir = +1/-1 according to direction of transform.
   void transform(std::complex<T> *signal, int dir);
 
  protected:
-  //: prime factorizations of signal dimensions.
-  vnl_fft_prime_factors<T> factors_[D];
+  //: shared plans for the signal dimensions.
+  vnl_fft_plan<T> const* plans_[D];
+
+  //: set the length of dimension i.
+  void set_size(int i, int N) { plans_[i] = &vnl_fft_plan<T>::get(N); }
+
+  //: length of dimension i.
+  unsigned size(int i) const { return plans_[i] ? plans_[i]->size() : 0; }
 };
 
 #endif // vnl_fft_base_h_
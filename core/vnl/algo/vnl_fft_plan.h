@@ -0,0 +1,122 @@
+// This is core/vnl/algo/vnl_fft_plan.h
+#ifndef vnl_fft_plan_h_
+#define vnl_fft_plan_h_
+//:
+// \file
+// \brief Cached plans for 1D fast Fourier transforms of any length
+//
+// A plan holds everything which depends only on the length of the signal,
+// so that it is computed once per length and shared by all transforms of
+// that length.  Lengths of the form $2^P 3^Q 5^R$ use the prime factor
+// algorithm directly.  Other lengths use Bluestein's algorithm, which turns
+// the transform into a circular convolution of a length which does factor,
+// so that signals need not be padded.
+//
+// Plans are obtained with get(), which may be called from several threads
+// at once.  The transform functions are const and may be too.
+//
+// The sign convention is that of vnl_fft_1d: a transform in direction +1
+// followed by one in direction -1 multiplies the signal by its length.
+
+#include <complex>
+#include <vector>
+#include <cstddef>
+#include <vcl_compiler.h>
+#include <vnl/algo/vnl_algo_export.h>
+#include <vnl/algo/vnl_fft_prime_factors.h>
+
+//: Plan for complex 1D transforms of a given length.
+VCL_TEMPLATE_EXPORT template <class T>
+class vnl_fft_plan
+{
+ public:
+  //: The shared plan for signals of length n > 0.
+  static vnl_fft_plan<T> const& get(unsigned n);
+
+  //: True if n is of the form 2^p 3^q 5^r.
+  static bool is_smooth(unsigned n);
+
+  //: The smallest number of the form 2^p 3^q 5^r which is at least n.
+  static unsigned next_smooth(unsigned n);
+
+  //: Length of the signals.
+  unsigned size() const { return n_; }
+
+  //: Transform lot signals in place; dir = +1/-1 according to direction of transform.
+  // Element i of signal l is data[l*jump + i*inc], where inc > 0 and
+  // jump >= 0.  Several signals at once let the inner loops of the prime
+  // factor algorithm run across signals.
+  void transform(std::complex<T>* data, int dir,
+                 std::ptrdiff_t inc = 1, std::ptrdiff_t jump = 0, unsigned lot = 1) const;
+
+  ~vnl_fft_plan() {}
+
+ private:
+  explicit vnl_fft_plan(unsigned n);
+
+  unsigned n_;
+
+  //: prime factorization, if n_ is smooth.
+  vnl_fft_prime_factors<T> factors_;
+
+  //: plan of the convolution used by Bluestein's algorithm, otherwise.
+  vnl_fft_plan<T> const* conv_;
+
+  //: chirp exp(i pi m^2/n), for direction +1 and -1.
+  std::vector<std::complex<T> > chirp_[2];
+
+  //: transform of the convolution kernel divided by its length, for direction +1 and -1.
+  std::vector<std::complex<T> > kernel_[2];
+
+  void bluestein(std::complex<T>* data, int dir, std::ptrdiff_t inc,
+                 std::vector<std::complex<T> >& work) const;
+
+  // disallow copying
+  vnl_fft_plan(vnl_fft_plan<T> const&);
+  vnl_fft_plan<T>& operator=(vnl_fft_plan<T> const&);
+};
+
+//: Plan for transforms of real signals of a given length.
+// Of the transform of n real values only the first n/2+1 coefficients are
+// stored, as the others are their complex conjugates in reverse order.
+// Even lengths are computed with a complex transform of half the length.
+VCL_TEMPLATE_EXPORT template <class T>
+class vnl_fft_real_plan
+{
+ public:
+  //: The shared plan for signals of length n > 0.
+  static vnl_fft_real_plan<T> const& get(unsigned n);
+
+  //: Length of the real signals.
+  unsigned size() const { return n_; }
+
+  //: Number of complex coefficients stored, n/2+1.
+  unsigned n_coeffs() const { return n_/2 + 1; }
+
+  //: Transform n real values in direction dir into n/2+1 coefficients.
+  void real_to_complex(T const* in, std::complex<T>* out, int dir) const;
+
+  //: Transform n/2+1 coefficients of a conjugate symmetric signal in direction dir into n real values.
+  // real_to_complex() in one direction followed by complex_to_real() in the
+  // other multiplies the signal by n.  The input is not modified.
+  void complex_to_real(std::complex<T> const* in, T* out, int dir) const;
+
+  ~vnl_fft_real_plan() {}
+
+ private:
+  explicit vnl_fft_real_plan(unsigned n);
+
+  unsigned n_;
+
+  //: complex plan of length n/2 if n is even, or of length n if it is odd.
+  vnl_fft_plan<T> const* plan_;
+
+  //: twiddle factors for direction +1, used if n is even.
+  std::vector<std::complex<T> > twiddle_;
+
+  // disallow copying
+  vnl_fft_real_plan(vnl_fft_real_plan<T> const&);
+  vnl_fft_real_plan<T>& operator=(vnl_fft_real_plan<T> const&);
+};
+
+#endif // vnl_fft_plan_h_
@@ -0,0 +1,280 @@
+// This is core/vnl/algo/vnl_fft_plan.hxx
+#ifndef vnl_fft_plan_hxx_
+#define vnl_fft_plan_hxx_
+//:
+// \file
+
+#include <map>
+#include <cmath>
+#include "vnl_fft_plan.h"
+#include <vnl/algo/vnl_fft.h>
+#include <vnl/vnl_math.h>
+#include <vcl_cassert.h>
+#include <vcl_compiler.h>
+
+#if VXL_FULLCXX11SUPPORT
+# include <mutex>
+#endif
+
+//: The plans built so far, by length.
+// Plans are built outside the lock, as building one may need another, and
+// if two threads build the same plan the second one is thrown away.
+template <class P>
+class vnl_fft_plan_cache
+{
+ public:
+  ~vnl_fft_plan_cache()
+  {
+    for (typename std::map<unsigned, P*>::iterator it = plans_.begin(); it != plans_.end(); ++it)
+      delete it->second;
+  }
+
+  //: The plan of length n, or null if there is none yet.
+  P const* find(unsigned n)
+  {
+#if VXL_FULLCXX11SUPPORT
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    typename std::map<unsigned, P*>::const_iterator it = plans_.find(n);
+    return it == plans_.end() ? VXL_NULLPTR : it->second;
+  }
+
+  //: Take ownership of plan p of length n, unless there is one already, and return the plan kept.
+  P const* insert(unsigned n, P* p)
+  {
+#if VXL_FULLCXX11SUPPORT
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    std::pair<typename std::map<unsigned, P*>::iterator, bool> r = plans_.insert(std::make_pair(n, p));
+    if (!r.second)
+      delete p;
+    return r.first->second;
+  }
+
+ private:
+  std::map<unsigned, P*> plans_;
+#if VXL_FULLCXX11SUPPORT
+  std::mutex mutex_;
+#endif
+};
+
+// In direction +1 the prime factor algorithm computes sum_j x_j exp(i 2 pi j k/n).
+static const double vnl_fft_plan_sign = 1.0;
+
+//: exp(i sign 2 pi m/d), computed in double precision.
+template <class T>
+static std::complex<T> vnl_fft_plan_root(unsigned long long m, unsigned long long d)
+{
+  double a = vnl_fft_plan_sign * vnl_math::twopi * double(m % d) / double(d);
+  return std::complex<T>(T(std::cos(a)), T(std::sin(a)));
+}
+
+template <class T>
+vnl_fft_plan<T> const& vnl_fft_plan<T>::get(unsigned n)
+{
+  assert(n > 0);
+  static vnl_fft_plan_cache<vnl_fft_plan<T> > cache;
+  vnl_fft_plan<T> const* p = cache.find(n);
+  if (!p)
+    p = cache.insert(n, new vnl_fft_plan<T>(n));
+  return *p;
+}
+
+template <class T>
+bool vnl_fft_plan<T>::is_smooth(unsigned n)
+{
+  if (n == 0)
+    return false;
+  while (n%2 == 0) n /= 2;
+  while (n%3 == 0) n /= 3;
+  while (n%5 == 0) n /= 5;
+  return n == 1;
+}
+
+template <class T>
+unsigned vnl_fft_plan<T>::next_smooth(unsigned n)
+{
+  while (!is_smooth(n))
+    ++n;
+  return n;
+}
+
+template <class T>
+vnl_fft_plan<T>::vnl_fft_plan(unsigned n)
+  : n_(n)
+  , conv_(VXL_NULLPTR)
+{
+  if (is_smooth(n)) {
+    if (n > 1)
+      factors_.resize(n);
+    return;
+  }
+
+  // Bluestein: with c_m = exp(i pi m^2/n), jk = (j^2 + k^2 - (k-j)^2)/2 turns
+  // X_k = sum_j x_j exp(i 2 pi jk/n) into X_k = c_k sum_j (x_j c_j) conj(c_{k-j}),
+  // a convolution which is done circularly with a length of at least 2n-1.
+  conv_ = &get(next_smooth(2*n-1));
+  const unsigned M = conv_->size();
+  chirp_[0].resize(n);
+  for (unsigned m = 0; m < n; ++m)
+    chirp_[0][m] = vnl_fft_plan_root<T>((unsigned long long)m*m, 2ull*n);
+  chirp_[1].resize(n);
+  for (unsigned m = 0; m < n; ++m)
+    chirp_[1][m] = std::conj(chirp_[0][m]);
+
+  for (unsigned d = 0; d < 2; ++d) {
+    std::vector<std::complex<T> >& kernel = kernel_[d];
+    kernel.assign(M, std::complex<T>(0));
+    kernel[0] = std::conj(chirp_[d][0]);
+    for (unsigned m = 1; m < n; ++m)
+      kernel[m] = kernel[M-m] = std::conj(chirp_[d][m]);
+    conv_->transform(&kernel[0], +1);
+    for (unsigned m = 0; m < M; ++m)
+      kernel[m] /= T(M);
+  }
+}
+
+template <class T>
+void vnl_fft_plan<T>::transform(std::complex<T>* data, int dir,
+                                std::ptrdiff_t inc, std::ptrdiff_t jump, unsigned lot) const
+{
+  assert((dir == +1) || (dir == -1));
+  // gpfa wraps its indices around on the assumption that the steps are positive
+  assert(inc > 0 && jump >= 0);
+  if (n_ == 1 || lot == 0)
+    return;
+
+  if (factors_) {
+    // This relies on the assumption that std::complex<T> is layout
+    // compatible with "struct { T real; T imag; }".
+    T* a = reinterpret_cast<T*>(data);
+    long info = 0;
+    vnl_fft_gpfa(a, a + 1, factors_.trigs(), 2*inc, 2*jump, n_, lot, dir, factors_.pqr(), &info);
+    assert(info != -1);
+  }
+  else {
+    std::vector<std::complex<T> > work(conv_->size());
+    for (unsigned l = 0; l < lot; ++l)
+      bluestein(data + l*jump, dir, inc, work);
+  }
+}
+
+template <class T>
+void vnl_fft_plan<T>::bluestein(std::complex<T>* data, int dir, std::ptrdiff_t inc,
+                                std::vector<std::complex<T> >& work) const
+{
+  const unsigned d = dir > 0 ? 0 : 1;
+  std::complex<T> const* chirp = &chirp_[d][0];
+  std::complex<T> const* kernel = &kernel_[d][0];
+  const unsigned M = conv_->size();
+
+  for (unsigned j = 0; j < n_; ++j)
+    work[j] = data[j*inc] * chirp[j];
+  for (unsigned j = n_; j < M; ++j)
+    work[j] = std::complex<T>(0);
+  conv_->transform(&work[0], +1);
+  for (unsigned m = 0; m < M; ++m)
+    work[m] *= kernel[m];
+  conv_->transform(&work[0], -1);
+  for (unsigned k = 0; k < n_; ++k)
+    data[k*inc] = work[k] * chirp[k];
+}
+
+//----------------------------------------------------------------------
+
+template <class T>
+vnl_fft_real_plan<T> const& vnl_fft_real_plan<T>::get(unsigned n)
+{
+  assert(n > 0);
+  static vnl_fft_plan_cache<vnl_fft_real_plan<T> > cache;
+  vnl_fft_real_plan<T> const* p = cache.find(n);
+  if (!p)
+    p = cache.insert(n, new vnl_fft_real_plan<T>(n));
+  return *p;
+}
+
+template <class T>
+vnl_fft_real_plan<T>::vnl_fft_real_plan(unsigned n)
+  : n_(n)
+{
+  if (n%2 == 1) {
+    plan_ = &vnl_fft_plan<T>::get(n);
+    return;
+  }
+  const unsigned h = n/2;
+  plan_ = &vnl_fft_plan<T>::get(h);
+  twiddle_.resize(h+1);
+  for (unsigned k = 0; k <= h; ++k)
+    twiddle_[k] = vnl_fft_plan_root<T>(k, n);
+}
+
+template <class T>
+void vnl_fft_real_plan<T>::real_to_complex(T const* in, std::complex<T>* out, int dir) const
+{
+  assert((dir == +1) || (dir == -1));
+  if (n_%2 == 1) {
+    std::vector<std::complex<T> > work(in, in + n_);
+    plan_->transform(&work[0], dir);
+    for (unsigned k = 0; k < n_coeffs(); ++k)
+      out[k] = work[k];
+    return;
+  }
+
+  // Transform z_j = x_2j + i x_2j+1 in the first n/2 outputs.  Its
+  // coefficients give those of the even and odd samples,
+  //   E_k = (Z_k + conj(Z_h-k))/2  and  O_k = (Z_k - conj(Z_h-k))/2i,
+  // and X_k = E_k + w^k O_k.  Pairs k, h-k are done together in place.
+  const unsigned h = n_/2;
+  for (unsigned j = 0; j < h; ++j)
+    out[j] = std::complex<T>(in[2*j], in[2*j+1]);
+  plan_->transform(out, dir);
+  out[h] = out[0];
+
+  const std::complex<T> half_i(0, T(0.5));
+  for (unsigned k = 0; 2*k <= h; ++k) {
+    const unsigned kk = h - k;
+    const std::complex<T> a = out[k], b = out[kk];
+    const std::complex<T> tw_k = dir > 0 ? twiddle_[k] : std::conj(twiddle_[k]);
+    const std::complex<T> tw_kk = dir > 0 ? twiddle_[kk] : std::conj(twiddle_[kk]);
+    out[k] = T(0.5)*(a + std::conj(b)) - half_i*tw_k*(a - std::conj(b));
+    if (kk != k)
+      out[kk] = T(0.5)*(b + std::conj(a)) - half_i*tw_kk*(b - std::conj(a));
+  }
+}
+
+template <class T>
+void vnl_fft_real_plan<T>::complex_to_real(std::complex<T> const* in, T* out, int dir) const
+{
+  assert((dir == +1) || (dir == -1));
+  if (n_%2 == 1) {
+    std::vector<std::complex<T> > work(n_);
+    work[0] = in[0];
+    for (unsigned k = 1; k < n_coeffs(); ++k) {
+      work[k] = in[k];
+      work[n_-k] = std::conj(in[k]);
+    }
+    plan_->transform(&work[0], dir);
+    for (unsigned j = 0; j < n_; ++j)
+      out[j] = work[j].real();
+    return;
+  }
+
+  // The reverse of real_to_complex(): form 2E_k + 2i O_k, whose transform of
+  // half the length is 2h (x_2j + i x_2j+1), directly in the output.
+  const unsigned h = n_/2;
+  std::complex<T>* z = reinterpret_cast<std::complex<T>*>(out);
+  const std::complex<T> i(0, 1);
+  for (unsigned k = 0; k < h; ++k) {
+    const std::complex<T> a = in[k], b = std::conj(in[h-k]);
+    const std::complex<T> tw = dir > 0 ? twiddle_[k] : std::conj(twiddle_[k]);
+    z[k] = (a + b) + i*tw*(a - b);
+  }
+  plan_->transform(z, dir);
+}
+
+#undef VNL_FFT_PLAN_INSTANTIATE
+#define VNL_FFT_PLAN_INSTANTIATE(T) \
+template class VNL_ALGO_EXPORT vnl_fft_plan<T >; \
+template class VNL_ALGO_EXPORT vnl_fft_real_plan<T >
+
+#endif // vnl_fft_plan_hxx_
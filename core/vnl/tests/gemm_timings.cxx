@@ -0,0 +1,105 @@
+//:
+// \file
+// \brief Tool to compare vnl_gemm with the plain triple loop matrix product.
+//
+// For each size the plain i-j-k loop formerly used by vnl_matrix::operator*
+// is timed against vnl_gemm at every instruction set level available on
+// this machine, and (if more than one core is present) with all cores.
+// Usage: vnl_gemm_timings [max_size]
+
+#include <vector>
+#include <iostream>
+#include <ctime>
+#include <cstdlib>
+#include <algorithm>
+#include <vnl/vnl_matrix.h>
+#include <vnl/vnl_random.h>
+#include <vnl/vnl_gemm.h>
+#include <vnl/vnl_cpu_features.h>
+#include <vcl_compiler.h>
+
+template <class T>
+void naive_product(const vnl_matrix<T>& A, const vnl_matrix<T>& B, vnl_matrix<T>& C)
+{
+  const unsigned l = A.rows(), m = A.cols(), n = B.cols();
+  for (unsigned i=0; i<l; ++i)
+    for (unsigned k=0; k<n; ++k)
+    {
+      T sum(0);
+      for (unsigned j=0; j<m; ++j)
+        sum += A[i][j] * B[j][k];
+      C[i][k] = sum;
+    }
+}
+
+template <class T>
+void blocked_product(const vnl_matrix<T>& A, const vnl_matrix<T>& B, vnl_matrix<T>& C)
+{
+  vnl_gemm::gemm(false, false, A.rows(), B.cols(), A.cols(), T(1), A.data_block(), A.cols(),
+                 B.data_block(), B.cols(), T(0), C.data_block(), C.cols());
+}
+
+//: Wall-clock-independent time in seconds per call of f, best of several runs.
+template <class T>
+double time_product(void (*f)(const vnl_matrix<T>&, const vnl_matrix<T>&, vnl_matrix<T>&),
+                    const vnl_matrix<T>& A, const vnl_matrix<T>& B, vnl_matrix<T>& C)
+{
+  const double flops = 2.0 * A.rows() * A.cols() * B.cols();
+  const int n_loops = std::max(1, int(2e8 / flops));
+  double best = 1e30;
+  for (int st=0; st<3; ++st)
+  {
+    std::clock_t t0=std::clock();
+    for (int l=0; l<n_loops; ++l)
+      f(A, B, C);
+    std::clock_t t1=std::clock();
+    best = std::min(best, (double(t1)-double(t0))/(double(n_loops)*CLOCKS_PER_SEC));
+  }
+  return best;
+}
+
+template <class T>
+void run_for_size(unsigned n, const char* type, vnl_random& rng)
+{
+  vnl_matrix<T> A(n,n), B(n,n), C(n,n);
+  for (unsigned i=0; i<n; ++i)
+    for (unsigned j=0; j<n; ++j)
+      A(i,j) = T(rng.drand64(-1,1)), B(i,j) = T(rng.drand64(-1,1));
+  const double gflop = 2.0 * n * n * n * 1e-9;
+
+  std::cout << type << ' ' << n << 'x' << n << "\n  naive loop     "
+            << gflop / time_product(&naive_product<T>, A, B, C) << " GFlop/s\n";
+
+  const vnl_cpu_features::level best = vnl_cpu_features::best();
+  for (int l = vnl_cpu_features::scalar; l <= best; ++l)
+  {
+    vnl_cpu_features::set_max_level(vnl_cpu_features::level(l));
+    std::cout << "  vnl_gemm " << vnl_cpu_features::name(vnl_cpu_features::level(l)) << "\t "
+              << gflop / time_product(&blocked_product<T>, A, B, C) << " GFlop/s\n";
+  }
+  vnl_cpu_features::set_max_level(best);
+
+  vnl_gemm::set_num_threads(0);
+  if (vnl_gemm::num_threads() > 1)
+  {
+    // std::clock measures CPU time of all threads, so time a fixed number of calls by wall clock.
+    std::time_t t0 = std::time(VXL_NULLPTR);
+    int calls = 0;
+    do { blocked_product(A, B, C); ++calls; } while (std::time(VXL_NULLPTR) - t0 < 2);
+    std::cout << "  vnl_gemm " << vnl_gemm::num_threads() << " threads "
+              << gflop * calls / double(std::time(VXL_NULLPTR) - t0) << " GFlop/s (approx)\n";
+  }
+  vnl_gemm::set_num_threads(1);
+}
+
+int main(int argc, char* argv[])
+{
+  const unsigned max_size = argc > 1 ? unsigned(std::atoi(argv[1])) : 256;
+  vnl_random rng(9667566ul);
+  for (unsigned n = 32; n <= max_size; n *= 2)
+  {
+    run_for_size<double>(n, "double", rng);
+    run_for_size<float>(n, "float", rng);
+  }
+  return 0;
+}
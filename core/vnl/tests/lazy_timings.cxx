@@ -0,0 +1,89 @@
+//:
+// \file
+// \brief Tool to compare vnl_lazy expressions with the ordinary vnl_vector operators.
+//
+// Times three update steps typical of iterative optimisers,
+// \verbatim
+//   x1 = x + alpha*d                  (line search trial point)
+//   d  = -g + beta*d                  (conjugate gradient direction)
+//   x  = x - rate*(g + decay*x)       (gradient step with weight decay)
+// \endverbatim
+// written with the ordinary operators, which allocate a temporary for every
+// operator, and with vnl_lazy, evaluated into a new vector and in place.
+// Usage: vnl_lazy_timings [max_size]
+
+#include <iostream>
+#include <ctime>
+#include <cstdlib>
+#include <algorithm>
+#include <vnl/vnl_vector.h>
+#include <vnl/vnl_lazy.h>
+#include <vnl/vnl_random.h>
+#include <vcl_compiler.h>
+
+struct state
+{
+  vnl_vector<double> x, x1, d, g;
+  double alpha, beta, rate, decay;
+};
+
+static void eager_steps(state& s)
+{
+  s.x1 = s.x + s.alpha*s.d;
+  s.d = -s.g + s.beta*s.d;
+  s.x = s.x - s.rate*(s.g + s.decay*s.x);
+}
+
+static void lazy_new_steps(state& s)
+{
+  s.x1 = vnl_lazy(s.x) + s.alpha*vnl_lazy(s.d);
+  s.d = -vnl_lazy(s.g) + s.beta*vnl_lazy(s.d);
+  s.x = vnl_lazy(s.x) - s.rate*(vnl_lazy(s.g) + s.decay*vnl_lazy(s.x));
+}
+
+static void lazy_in_place_steps(state& s)
+{
+  vnl_lazy(s.x1) = vnl_lazy(s.x) + s.alpha*vnl_lazy(s.d);
+  vnl_lazy(s.d) = -vnl_lazy(s.g) + s.beta*vnl_lazy(s.d);
+  vnl_lazy(s.x) = vnl_lazy(s.x) - s.rate*(vnl_lazy(s.g) + s.decay*vnl_lazy(s.x));
+}
+
+//: Nanoseconds per element for one set of the three updates, best of three runs.
+static double time_steps(void (*f)(state&), state& s)
+{
+  const unsigned n = unsigned(s.x.size());
+  const int n_loops = std::max(1, int(2e7 / n));
+  double best = 1e30;
+  for (int st=0; st<3; ++st)
+  {
+    std::clock_t t0=std::clock();
+    for (int l=0; l<n_loops; ++l)
+      f(s);
+    std::clock_t t1=std::clock();
+    best = std::min(best, (double(t1)-double(t0))/(double(n_loops)*CLOCKS_PER_SEC));
+  }
+  return best * 1e9 / n;
+}
+
+int main(int argc, char* argv[])
+{
+  const unsigned max_size = argc > 1 ? unsigned(std::atoi(argv[1])) : 100000;
+  vnl_random rng(9667566ul);
+  std::cout << "ns per element for three optimiser updates\n"
+            << "      size    operators  lazy (new)  lazy (in place)\n";
+  for (unsigned n = 10; n <= max_size; n *= 10)
+  {
+    state s;
+    s.x.set_size(n); s.x1.set_size(n); s.d.set_size(n); s.g.set_size(n);
+    for (unsigned i = 0; i < n; ++i)
+      s.x[i] = rng.drand64(-1,1), s.d[i] = rng.drand64(-1,1), s.g[i] = rng.drand64(-1,1);
+    // Keep the values bounded over many iterations.
+    s.alpha = 0.5; s.beta = 0.5; s.rate = 1e-3; s.decay = 0.1;
+
+    std::cout.width(10); std::cout << n << ' ';
+    std::cout.width(12); std::cout << time_steps(&eager_steps, s) << ' ';
+    std::cout.width(11); std::cout << time_steps(&lazy_new_steps, s) << ' ';
+    std::cout.width(16); std::cout << time_steps(&lazy_in_place_steps, s) << '\n';
+  }
+  return 0;
+}
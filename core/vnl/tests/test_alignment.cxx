@@ -12,7 +12,12 @@
 #include <vnl/vnl_math.h>
 #include <vnl/vnl_random.h>
 #include <vnl/vnl_sse.h>
+#include <vnl/vnl_alloc.h>
 #include <testlib/testlib_test.h>
+#if VXL_FULLCXX11SUPPORT
+# include <thread>
+# include <vector>
+#endif
 
 inline bool test_element_product(const vnl_vector<float> &vec, const vnl_vector<float> &vec2,
                                  vnl_vector<float> &result)
@@ -269,10 +274,75 @@ static void test_alignment_type()
   }
 }
 
+static bool is_aligned(const void* p)
+{
+  return reinterpret_cast<std::size_t>(p) % VNL_ALLOC_DATA_ALIGN == 0;
+}
+
+#if VXL_FULLCXX11SUPPORT
+static void churn_aligned_blocks(bool* ok)
+{
+  for (unsigned i = 0; i < 2000; ++i)
+  {
+    const std::size_t n = 8 + (i * 37) % 5000;
+    char* p = static_cast<char*>(vnl_alloc::allocate_aligned(n));
+    p[0] = p[n-1] = char(i);
+    *ok = *ok && is_aligned(p) && p[0] == char(i);
+    vnl_alloc::deallocate_aligned(p, n);
+  }
+}
+#endif
+
+static void test_aligned_storage()
+{
+  bool ok = true;
+  for (unsigned n = 1; n < 300; ++n)
+  {
+    vnl_vector<double> v(n);
+    vnl_matrix<float> m(n, 3);
+    ok = ok && is_aligned(v.data_block()) && is_aligned(m.data_block());
+  }
+  TEST("vnl_vector and vnl_matrix storage is aligned", ok, true);
+
+  // Size classes: never smaller than requested, less than 25% slack above 64 bytes.
+  ok = true;
+  for (std::size_t n = 0; n <= VNL_ALLOC_POOL_MAX_BYTES + 10; n += (n < 4096 ? 1 : 997))
+  {
+    const std::size_t b = vnl_alloc::aligned_block_size(n);
+    ok = ok && b >= n && (n <= 64 || 4*b <= 5*n + 4*64);
+  }
+  TEST("aligned_block_size is tight", ok, true);
+
+  // A freed block is handed out again for a request of the same size class.
+  vnl_alloc::release_thread_cache();
+  void* p = vnl_alloc::allocate_aligned(1000);
+  vnl_alloc::deallocate_aligned(p, 1000);
+  void* q = vnl_alloc::allocate_aligned(990);
+  TEST("freed block is recycled", p == q, true);
+  vnl_alloc::deallocate_aligned(q, 990);
+  void* big = vnl_alloc::allocate_aligned(3*VNL_ALLOC_POOL_MAX_BYTES);
+  TEST("large blocks are aligned", is_aligned(big), true);
+  vnl_alloc::deallocate_aligned(big, 3*VNL_ALLOC_POOL_MAX_BYTES);
+  vnl_alloc::deallocate_aligned(VXL_NULLPTR, 10);
+  vnl_alloc::release_thread_cache();
+
+#if VXL_FULLCXX11SUPPORT
+  bool thread_ok[4] = { true, true, true, true };
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < 4; ++t)
+    threads.push_back(std::thread(churn_aligned_blocks, &thread_ok[t]));
+  for (unsigned t = 0; t < 4; ++t)
+    threads[t].join();
+  TEST("concurrent use from several threads",
+       thread_ok[0] && thread_ok[1] && thread_ok[2] && thread_ok[3], true);
+#endif
+}
+
 static
 void test_alignment()
 {
   test_alignment_type();
+  test_aligned_storage();
 }
 
 TESTMAIN(test_alignment);
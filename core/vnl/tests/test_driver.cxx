@@ -43,6 +43,9 @@ DECLARE( test_sparse_lst_sqr_function );
 DECLARE( test_sparse_matrix );
 DECLARE( test_pow_log );
 DECLARE( test_vnl_index_sort );
+DECLARE( test_gemm );
+DECLARE( test_sse_dispatch );
+DECLARE( test_lazy );
 
 void
 register_tests()
@@ -89,6 +92,9 @@ register_tests()
   REGISTER( test_sparse_matrix );
   REGISTER( test_pow_log );
   REGISTER( test_vnl_index_sort );
+  REGISTER( test_gemm );
+  REGISTER( test_sse_dispatch );
+  REGISTER( test_lazy );
 }
 
 DEFINE_MAIN;
@@ -0,0 +1,135 @@
+// This is core/vnl/tests/test_gemm.cxx
+#include <iostream>
+#include <limits>
+#include <vcl_compiler.h>
+#include <testlib/testlib_test.h>
+//:
+// \file
+// \brief Compare the blocked vnl_gemm kernels against a plain triple loop.
+
+#include <vnl/vnl_gemm.h>
+#include <vnl/vnl_cpu_features.h>
+#include <vnl/vnl_matrix.h>
+#include <vnl/vnl_fastops.h>
+#include <vnl/vnl_random.h>
+
+template <class T>
+static vnl_matrix<T> random_matrix(unsigned r, unsigned c, vnl_random& rng)
+{
+  vnl_matrix<T> m(r, c);
+  for (unsigned i = 0; i < r; ++i)
+    for (unsigned j = 0; j < c; ++j)
+      m(i,j) = T(rng.drand64(-1.0, 1.0));
+  return m;
+}
+
+//: Reference op(A) op(B), computed in double.
+template <class T>
+static vnl_matrix<T> naive_product(vnl_matrix<T> const& A, bool ta, vnl_matrix<T> const& B, bool tb)
+{
+  const unsigned m = ta ? A.cols() : A.rows();
+  const unsigned k = ta ? A.rows() : A.cols();
+  const unsigned n = tb ? B.rows() : B.cols();
+  vnl_matrix<T> C(m, n);
+  for (unsigned i = 0; i < m; ++i)
+    for (unsigned j = 0; j < n; ++j)
+    {
+      double s = 0;
+      for (unsigned p = 0; p < k; ++p)
+        s += double(ta ? A(p,i) : A(i,p)) * double(tb ? B(j,p) : B(p,j));
+      C(i,j) = T(s);
+    }
+  return C;
+}
+
+template <class T>
+static void test_gemm_type(char const* type, double tol)
+{
+  vnl_random rng(9667566ul);
+  // Sizes chosen to exercise partial micro-tiles and more than one KC slice.
+  const unsigned sizes[][3] = { {1,1,1}, {5,3,7}, {37,41,29}, {64,64,64}, {97,13,300}, {150,130,70} };
+  for (unsigned s = 0; s < sizeof sizes / sizeof sizes[0]; ++s)
+  {
+    const unsigned m = sizes[s][0], n = sizes[s][1], k = sizes[s][2];
+    for (int t = 0; t < 4; ++t)
+    {
+      const bool ta = (t & 1) != 0, tb = (t & 2) != 0;
+      vnl_matrix<T> A = ta ? random_matrix<T>(k, m, rng) : random_matrix<T>(m, k, rng);
+      vnl_matrix<T> B = tb ? random_matrix<T>(n, k, rng) : random_matrix<T>(k, n, rng);
+      vnl_matrix<T> C0 = random_matrix<T>(m, n, rng);
+      vnl_matrix<T> C = C0;
+      vnl_gemm::gemm(ta, tb, m, n, k, T(2), A.data_block(), A.cols(),
+                     B.data_block(), B.cols(), T(-0.5), C.data_block(), n);
+      vnl_matrix<T> expected = naive_product(A, ta, B, tb) * T(2) - C0 * T(0.5);
+      std::cout << type << ' ' << m << 'x' << n << 'x' << k << " ta=" << ta << " tb=" << tb << '\n';
+      TEST_NEAR("gemm matches reference", (C - expected).absolute_value_max(), 0.0, tol * k);
+    }
+  }
+
+  // operator* goes through the blocked kernel for large matrices
+  vnl_matrix<T> A = random_matrix<T>(123, 77, rng);
+  vnl_matrix<T> B = random_matrix<T>(77, 95, rng);
+  TEST_NEAR("operator* matches reference",
+            (A * B - naive_product(A, false, B, false)).absolute_value_max(), 0.0, tol * 77);
+
+  // beta == 0 must overwrite C even if it holds NaN
+  vnl_matrix<T> C(123, 95, T(0));
+  C(3,4) = std::numeric_limits<T>::quiet_NaN();
+  vnl_gemm::gemm(false, false, 123, 95, 77, T(1), A.data_block(), 77, B.data_block(), 95, T(0), C.data_block(), 95);
+  TEST_NEAR("beta == 0 ignores old C", (C - A * B).absolute_value_max(), 0.0, tol * 77);
+
+  // Results must not depend on the number of threads
+  vnl_matrix<T> D = random_matrix<T>(300, 200, rng);
+  vnl_matrix<T> E = random_matrix<T>(200, 250, rng);
+  vnl_gemm::set_num_threads(1);
+  vnl_matrix<T> P1 = D * E;
+  vnl_gemm::set_num_threads(4);
+  vnl_matrix<T> P4 = D * E;
+  vnl_gemm::set_num_threads(1);
+  TEST("threaded product is bit-identical", P1 == P4, true);
+}
+
+static void test_gemm_all_levels()
+{
+  const vnl_cpu_features::level best = vnl_cpu_features::best();
+  std::cout << "Best available instruction set: " << vnl_cpu_features::name(best) << '\n';
+  for (int l = vnl_cpu_features::scalar; l <= best; ++l)
+  {
+    vnl_cpu_features::set_max_level(vnl_cpu_features::level(l));
+    std::cout << "=== Kernel level " << vnl_cpu_features::name(vnl_cpu_features::level(l)) << " ===\n";
+    test_gemm_type<double>("double", 1e-14);
+    test_gemm_type<float>("float", 1e-5);
+  }
+  vnl_cpu_features::set_max_level(vnl_cpu_features::avx512);
+}
+
+static void test_gemm_fastops()
+{
+  vnl_random rng(1234ul);
+  vnl_matrix<double> A = random_matrix<double>(90, 60, rng);
+  vnl_matrix<double> B = random_matrix<double>(90, 70, rng);
+  vnl_matrix<double> C = random_matrix<double>(60, 70, rng);
+  vnl_matrix<double> out;
+
+  vnl_fastops::AtA(out, A);
+  TEST_NEAR("vnl_fastops::AtA", (out - naive_product(A, true, A, false)).absolute_value_max(), 0.0, 1e-12);
+  vnl_fastops::AtB(out, A, B);
+  TEST_NEAR("vnl_fastops::AtB", (out - naive_product(A, true, B, false)).absolute_value_max(), 0.0, 1e-12);
+  vnl_fastops::AB(out, A, C);
+  TEST_NEAR("vnl_fastops::AB", (out - naive_product(A, false, C, false)).absolute_value_max(), 0.0, 1e-12);
+  vnl_fastops::ABt(out, C, C);
+  TEST_NEAR("vnl_fastops::ABt", (out - naive_product(C, false, C, true)).absolute_value_max(), 0.0, 1e-12);
+
+  vnl_matrix<double> X = random_matrix<double>(60, 70, rng), X0 = X;
+  vnl_fastops::inc_X_by_AtB(X, A, B);
+  vnl_fastops::dec_X_by_AtB(X, A, B);
+  TEST_NEAR("inc_X_by_AtB then dec_X_by_AtB", (X - X0).absolute_value_max(), 0.0, 1e-12);
+}
+
+void test_gemm()
+{
+  test_gemm_all_levels();
+  test_gemm_fastops();
+}
+
+TESTMAIN(test_gemm);
@@ -17,6 +17,7 @@
 #include <vnl/vnl_cross.h>
 #include <vnl/vnl_crs_index.h>
 #include <vnl/vnl_cost_function.h>
+#include <vnl/vnl_cpu_features.h>
 #include <vnl/vnl_cross_product_matrix.h>
 #include <vnl/vnl_decnum.h>
 #include <vnl/vnl_decnum_traits.h>
@@ -61,6 +62,7 @@
 #include <vnl/vnl_fortran_copy.h>
 #include <vnl/vnl_fortran_copy_fixed.h>
 #include <vnl/vnl_gamma.h>
+#include <vnl/vnl_gemm.h>
 #include <vnl/vnl_hungarian_algorithm.h>
 #include <vnl/vnl_identity.h>
 #include <vnl/vnl_identity_3x3.h>
@@ -74,6 +76,7 @@
 #include <vnl/vnl_int_matrix.h>
 #include <vnl/vnl_integrant_fnct.h>
 #include <vnl/vnl_inverse.h>
+#include <vnl/vnl_lazy.h>
 #include <vnl/vnl_least_squares_cost_function.h>
 #include <vnl/vnl_least_squares_function.h>
 #include <vnl/vnl_linear_operators_3.h>
@@ -114,6 +117,7 @@
 #include <vnl/vnl_sparse_matrix.h>
 #include <vnl/vnl_sparse_matrix_linear_system.h>
 #include <vnl/vnl_sse.h>
+#include <vnl/vnl_sse_dispatch.h>
 #include <vnl/vnl_sym_matrix.h>
 #include <vnl/vnl_tag.h>
 #include <vnl/vnl_trace.h>
@@ -0,0 +1,94 @@
+// This is core/vnl/tests/test_lazy.cxx
+#include <iostream>
+#include <vcl_compiler.h>
+#include <testlib/testlib_test.h>
+//:
+// \file
+// \brief Check that vnl_lazy expressions give the same results as the ordinary operators.
+
+#include <vnl/vnl_lazy.h>
+#include <vnl/vnl_vector.h>
+#include <vnl/vnl_matrix.h>
+#include <vnl/vnl_random.h>
+
+// Compilers may contract a*b+c into a fused multiply-add in the single
+// lazy loop, so compare with a tolerance rather than exactly.
+template <class T>
+static bool same(vnl_vector<T> const& a, vnl_vector<T> const& b)
+{
+  return a.size() == b.size() && (a - b).inf_norm() <= 1e-12;
+}
+
+template <class T>
+static bool same(vnl_matrix<T> const& a, vnl_matrix<T> const& b)
+{
+  return a.rows() == b.rows() && a.cols() == b.cols() && (a - b).absolute_value_max() <= 1e-12;
+}
+
+static void test_lazy_vector()
+{
+  vnl_random rng(9667566ul);
+  const unsigned n = 37;
+  vnl_vector<double> a(n), b(n), c(n);
+  for (unsigned i = 0; i < n; ++i)
+    a[i] = rng.drand64(-1,1), b[i] = rng.drand64(-1,1), c[i] = rng.drand64(0.5,2);
+  const double s = 1.75;
+
+  vnl_vector<double> r = vnl_lazy(a) + vnl_lazy(b)*s - vnl_lazy(c);
+  TEST("a + b*s - c", same(r, a + b*s - c), true);
+
+  r = vnl_lazy(a) / 2.0 - 3.0 * (vnl_lazy(b) + 1.0);
+  TEST("a/2 - 3*(b+1)", same(r, a/2.0 - 3.0*(b + 1.0)), true);
+
+  r = -vnl_lazy(a) + (2.0 - vnl_lazy(c));
+  TEST("-a + (2-c)", same(r, -a + (2.0 - c)), true);
+
+  r = element_product(vnl_lazy(a), vnl_lazy(b)) + element_quotient(vnl_lazy(a), vnl_lazy(c));
+  TEST("element_product + element_quotient", same(r, element_product(a, b) + element_quotient(a, c)), true);
+
+  // Assignment through vnl_lazy() writes in place and may read the target.
+  vnl_vector<double> x = a;
+  const double* storage = x.data_block();
+  vnl_lazy(x) = vnl_lazy(x) - s*vnl_lazy(b);
+  TEST("x = x - s*b", same(x, a - s*b), true);
+  TEST("x = x - s*b does not reallocate", x.data_block() == storage, true);
+  vnl_lazy(x) += s*vnl_lazy(b);
+  vnl_lazy(x) -= vnl_lazy(c);
+  TEST("x += s*b; x -= c", same(x, a - s*b + s*b - c), true);
+
+  // Assigning to a vector of a different size resizes it.
+  vnl_vector<double> y;
+  vnl_lazy(y) = vnl_lazy(a) * 2.0;
+  TEST("resize on assignment", same(y, a * 2.0), true);
+  vnl_lazy(y) = vnl_lazy(b);
+  TEST("plain copy", same(y, b), true);
+
+  vnl_vector<float> f(5, 1.0f), g(5, 2.0f);
+  vnl_vector<float> h = 0.5 * vnl_lazy(f) + vnl_lazy(g) * 2;
+  TEST("float with double and int scalars", same(h, vnl_vector<float>(5, 4.5f)), true);
+}
+
+static void test_lazy_matrix()
+{
+  vnl_random rng(1234ul);
+  vnl_matrix<double> A(7, 5), B(7, 5);
+  for (unsigned i = 0; i < 7; ++i)
+    for (unsigned j = 0; j < 5; ++j)
+      A(i,j) = rng.drand64(-1,1), B(i,j) = rng.drand64(-1,1);
+
+  vnl_matrix<double> C = vnl_lazy(A)*0.5 - vnl_lazy(B) + 1.0;
+  TEST("matrix A*0.5 - B + 1", same(C, A*0.5 - B + 1.0), true);
+  TEST("matrix shape", C.rows() == 7 && C.cols() == 5, true);
+
+  vnl_matrix<double> D = A;
+  vnl_lazy(D) += element_product(vnl_lazy(A), vnl_lazy(B));
+  TEST("matrix += element_product", same(D, A + element_product(A, B)), true);
+}
+
+void test_lazy()
+{
+  test_lazy_vector();
+  test_lazy_matrix();
+}
+
+TESTMAIN(test_lazy);
@@ -0,0 +1,119 @@
+// This is core/vnl/tests/test_sse_dispatch.cxx
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <vcl_compiler.h>
+#include <testlib/testlib_test.h>
+//:
+// \file
+// \brief Compare every instruction set level of vnl_sse_dispatch with the plain loops.
+
+#include <vnl/vnl_sse.h>
+#include <vnl/vnl_sse_dispatch.h>
+#include <vnl/vnl_cpu_features.h>
+#include <vnl/vnl_random.h>
+#include <vnl/vnl_vector.h>
+#include <vnl/vnl_matrix.h>
+
+// Integer data is kept small so that the exact sums cannot overflow.
+static void fill(std::vector<double>& v, vnl_random& rng) { for (unsigned i=0; i<v.size(); ++i) v[i] = rng.drand64(-1,1); }
+static void fill(std::vector<float>& v, vnl_random& rng) { for (unsigned i=0; i<v.size(); ++i) v[i] = float(rng.drand64(-1,1)); }
+static void fill(std::vector<int>& v, vnl_random& rng) { for (unsigned i=0; i<v.size(); ++i) v[i] = int(rng.lrand32(0,200)) - 100; }
+
+static double abs_diff(double a, double b) { return std::fabs(a - b); }
+
+//: True if a and b agree to within rounding of n terms of size up to |a|.
+static bool rounding_close(double a, double b, double eps, unsigned n)
+{
+  return abs_diff(a, b) <= 4 * eps * n * (1.0 + std::fabs(a));
+}
+
+template <class T>
+static bool all_close(std::vector<T> const& a, std::vector<T> const& b, double tol)
+{
+  for (unsigned i = 0; i < a.size(); ++i)
+    if (abs_diff(a[i], b[i]) > tol) return false;
+  return true;
+}
+
+template <class T>
+static void test_type(char const* type, double eps)
+{
+  typedef vnl_sse_generic<T> ref;
+  typedef vnl_sse_dispatch<T> simd;
+  vnl_random rng(1234ul);
+  // Lengths around every multiple of the register widths, plus some longer ones.
+  const unsigned sizes[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 1000, 1031 };
+  bool ok_ep = true, ok_dot = true, ok_ssd = true, ok_sum = true, ok_max = true, ok_min = true,
+       ok_argmax = true, ok_argmin = true;
+  for (unsigned s = 0; s < sizeof sizes / sizeof sizes[0]; ++s)
+  {
+    const unsigned n = sizes[s];
+    std::vector<T> x(n), y(n), r0(n), r1(n);
+    fill(x, rng); fill(y, rng);
+    // Plant a repeated extremum so that first occurrence matters.
+    if (n > 3) { x[n/3] = x[n-1] = T(1000); y[n/2] = y[n-2] = T(-1000); }
+
+    ref::element_product(&x[0], &y[0], &r0[0], n);
+    simd::element_product(&x[0], &y[0], &r1[0], n);
+    ok_ep = ok_ep && all_close(r0, r1, 0.0);
+    ok_dot = ok_dot && rounding_close(ref::dot_product(&x[0], &y[0], n), simd::dot_product(&x[0], &y[0], n), eps, n);
+    ok_ssd = ok_ssd && rounding_close(ref::euclid_dist_sq(&x[0], &y[0], n), simd::euclid_dist_sq(&x[0], &y[0], n), eps, n);
+    ok_sum = ok_sum && rounding_close(ref::sum(&x[0], n), simd::sum(&x[0], n), eps, n);
+    ok_max = ok_max && ref::max(&x[0], n) == simd::max(&x[0], n) && ref::max(&y[0], n) == simd::max(&y[0], n);
+    ok_min = ok_min && ref::min(&x[0], n) == simd::min(&x[0], n) && ref::min(&y[0], n) == simd::min(&y[0], n);
+    ok_argmax = ok_argmax && ref::arg_max(&x[0], n) == simd::arg_max(&x[0], n)
+                          && ref::arg_max(&y[0], n) == simd::arg_max(&y[0], n);
+    ok_argmin = ok_argmin && ref::arg_min(&x[0], n) == simd::arg_min(&x[0], n)
+                          && ref::arg_min(&y[0], n) == simd::arg_min(&y[0], n);
+  }
+  std::cout << type << ":\n";
+  TEST("element_product", ok_ep, true);
+  TEST("dot_product", ok_dot, true);
+  TEST("euclid_dist_sq", ok_ssd, true);
+  TEST("sum", ok_sum, true);
+  TEST("max", ok_max, true);
+  TEST("min", ok_min, true);
+  TEST("arg_max returns first maximum", ok_argmax, true);
+  TEST("arg_min returns first minimum", ok_argmin, true);
+
+  const unsigned shapes[][2] = { {1,1}, {3,17}, {17,3}, {40,33}, {64,64}, {5,1000} };
+  bool ok_mv = true, ok_vm = true;
+  for (unsigned s = 0; s < sizeof shapes / sizeof shapes[0]; ++s)
+  {
+    const unsigned rows = shapes[s][0], cols = shapes[s][1];
+    std::vector<T> m(rows*cols), v(cols), w(rows), r0(rows), r1(rows), c0(cols), c1(cols);
+    fill(m, rng); fill(v, rng); fill(w, rng);
+    ref::matrix_x_vector(&m[0], &v[0], &r0[0], rows, cols);
+    simd::matrix_x_vector(&m[0], &v[0], &r1[0], rows, cols);
+    ok_mv = ok_mv && all_close(r0, r1, 4*eps*cols);
+    ref::vector_x_matrix(&w[0], &m[0], &c0[0], rows, cols);
+    simd::vector_x_matrix(&w[0], &m[0], &c1[0], rows, cols);
+    ok_vm = ok_vm && all_close(c0, c1, 4*eps*rows);
+  }
+  TEST("matrix_x_vector", ok_mv, true);
+  TEST("vector_x_matrix", ok_vm, true);
+}
+
+void test_sse_dispatch()
+{
+  const vnl_cpu_features::level best = vnl_cpu_features::best();
+  for (int l = vnl_cpu_features::scalar; l <= best; ++l)
+  {
+    vnl_cpu_features::set_max_level(vnl_cpu_features::level(l));
+    std::cout << "=== Level " << vnl_cpu_features::name(vnl_cpu_features::level(l)) << " ===\n";
+    test_type<double>("double", 2.3e-16);
+    test_type<float>("float", 1.2e-7);
+    test_type<int>("int", 0.0);
+  }
+  vnl_cpu_features::set_max_level(best);
+
+  // The dispatched code is reached through the usual vnl_vector interface.
+  vnl_vector<double> a(101), b(101);
+  for (unsigned i = 0; i < 101; ++i) a[i] = double(i), b[i] = 1.0;
+  TEST_NEAR("vnl_vector dot_product", dot_product(a, b), 5050.0, 1e-12);
+  TEST("vnl_vector arg_max", a.arg_max(), 100);
+  TEST_NEAR("vnl_matrix * vnl_vector", (vnl_matrix<double>(3, 101, 1.0) * a)[2], 5050.0, 1e-12);
+}
+
+TESTMAIN(test_sse_dispatch);
@@ -6,9 +6,18 @@
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
+#include <new>
 #include "vnl_alloc.h"
 
 #include <vcl_compiler.h>
+#include <vxl_config.h>
+#include <vnl/vnl_config.h>
+
+#if VXL_HAS_MM_MALLOC
+# include <emmintrin.h>
+#elif VXL_HAS_ALIGNED_MALLOC || VXL_HAS_MINGW_ALIGNED_MALLOC
+# include <malloc.h>
+#endif
 
 char*
 vnl_alloc::chunk_alloc(std::size_t size, int& nobjs)
@@ -129,6 +138,175 @@ std::size_t vnl_alloc::heap_size = 0;
 vnl_alloc::obj *
 vnl_alloc::free_list[VNL_ALLOC_NFREELISTS] = { VXL_NULLPTR };
 
+//----------------------------------------------------------------------
+// Aligned, pooled storage for vnl_vector and vnl_matrix
+
+//: Obtain n bytes aligned to VNL_ALLOC_DATA_ALIGN from the system.
+static void* vnl_alloc_system_allocate(std::size_t n)
+{
+#if VXL_HAS_MM_MALLOC
+  void* p = _mm_malloc(n, VNL_ALLOC_DATA_ALIGN);
+#elif VXL_HAS_ALIGNED_MALLOC
+  void* p = _aligned_malloc(n, VNL_ALLOC_DATA_ALIGN);
+#elif VXL_HAS_MINGW_ALIGNED_MALLOC
+  void* p = __mingw_aligned_malloc(n, VNL_ALLOC_DATA_ALIGN);
+#else
+  // Over-allocate and keep the pointer malloc gave us just before the block.
+  void* p = VXL_NULLPTR;
+  if (char* raw = static_cast<char*>(std::malloc(n + VNL_ALLOC_DATA_ALIGN + sizeof(void*))))
+  {
+    std::size_t a = reinterpret_cast<std::size_t>(raw + sizeof(void*));
+    a = (a + VNL_ALLOC_DATA_ALIGN - 1) & ~(VNL_ALLOC_DATA_ALIGN - 1);
+    p = reinterpret_cast<void*>(a);
+    static_cast<void**>(p)[-1] = raw;
+  }
+#endif
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+static void vnl_alloc_system_deallocate(void* p)
+{
+#if VXL_HAS_MM_MALLOC
+  _mm_free(p);
+#elif VXL_HAS_ALIGNED_MALLOC
+  _aligned_free(p);
+#elif VXL_HAS_MINGW_ALIGNED_MALLOC
+  __mingw_aligned_free(p);
+#else
+  std::free(static_cast<void**>(p)[-1]);
+#endif
+}
+
+// Size class 0 holds blocks of up to 64 bytes.  Above that there are four
+// classes per power of two, e.g. 80, 96, 112, 128, 160, 192, 224, 256, ...,
+// so no more than a fifth of a pooled block is wasted.
+static const unsigned vnl_alloc_nclasses = 57; // up to VNL_ALLOC_POOL_MAX_BYTES = 2^20
+
+static unsigned vnl_alloc_size_class(std::size_t n)
+{
+  if (n <= 64)
+    return 0;
+  const std::size_t b = n - 1;
+  unsigned k = 6;
+  while ((b >> (k+1)) != 0) ++k; // k = floor(log2(b))
+  return (k-6)*4 + unsigned((b >> (k-2)) & 3) + 1;
+}
+
+static std::size_t vnl_alloc_class_bytes(unsigned c)
+{
+  if (c == 0)
+    return 64;
+  const unsigned k = 6 + (c-1)/4;
+  return std::size_t(5 + (c-1)%4) << (k-2);
+}
+
+//: The free lists of one thread.  The link to the next free block is kept in the block itself.
+// This is plain data, so it needs no construction and stays usable while
+// other thread-local and static objects are being destroyed.
+struct vnl_alloc_thread_cache
+{
+  void* head[vnl_alloc_nclasses];
+  std::size_t bytes;
+  bool registered; // cleanup object created
+  bool closed;     // thread is exiting: bypass the cache
+};
+
+static void vnl_alloc_cache_release(vnl_alloc_thread_cache& cache)
+{
+  for (unsigned c = 0; c < vnl_alloc_nclasses; ++c)
+    while (void* p = cache.head[c])
+    {
+      cache.head[c] = *static_cast<void**>(p);
+      vnl_alloc_system_deallocate(p);
+    }
+  cache.bytes = 0;
+}
+
+#if VXL_FULLCXX11SUPPORT
+static thread_local vnl_alloc_thread_cache vnl_alloc_cache_data;
+
+//: Frees the calling thread's cached blocks when the thread exits.
+struct vnl_alloc_thread_cache_cleanup
+{
+  ~vnl_alloc_thread_cache_cleanup()
+  {
+    vnl_alloc_cache_release(vnl_alloc_cache_data);
+    vnl_alloc_cache_data.closed = true;
+  }
+};
+static thread_local vnl_alloc_thread_cache_cleanup vnl_alloc_cache_cleanup;
+
+static vnl_alloc_thread_cache* vnl_alloc_cache()
+{
+  vnl_alloc_thread_cache& cache = vnl_alloc_cache_data;
+  if (cache.closed)
+    return VXL_NULLPTR;
+  if (!cache.registered)
+  {
+    cache.registered = true;
+    (void)&vnl_alloc_cache_cleanup; // first use constructs it, registering its destructor
+  }
+  return &cache;
+}
+#elif !VNL_CONFIG_THREAD_SAFE
+// Single threaded use only: one cache for the whole program.
+static vnl_alloc_thread_cache vnl_alloc_cache_data;
+static vnl_alloc_thread_cache* vnl_alloc_cache() { return &vnl_alloc_cache_data; }
+#else
+// No portable thread-local storage: every block comes from the system.
+static vnl_alloc_thread_cache* vnl_alloc_cache() { return VXL_NULLPTR; }
+#endif
+
+std::size_t vnl_alloc::aligned_block_size(std::size_t n)
+{
+  if (n > VNL_ALLOC_POOL_MAX_BYTES)
+    return n;
+  return vnl_alloc_class_bytes(vnl_alloc_size_class(n));
+}
+
+void* vnl_alloc::allocate_aligned(std::size_t n)
+{
+  if (n > VNL_ALLOC_POOL_MAX_BYTES)
+    return vnl_alloc_system_allocate(n);
+  const unsigned c = vnl_alloc_size_class(n);
+  if (vnl_alloc_thread_cache* cache = vnl_alloc_cache())
+    if (void* p = cache->head[c])
+    {
+      cache->head[c] = *static_cast<void**>(p);
+      cache->bytes -= vnl_alloc_class_bytes(c);
+      return p;
+    }
+  return vnl_alloc_system_allocate(vnl_alloc_class_bytes(c));
+}
+
+void vnl_alloc::deallocate_aligned(void* p, std::size_t n)
+{
+  if (!p)
+    return;
+  if (n <= VNL_ALLOC_POOL_MAX_BYTES)
+  {
+    const unsigned c = vnl_alloc_size_class(n);
+    const std::size_t bytes = vnl_alloc_class_bytes(c);
+    vnl_alloc_thread_cache* cache = vnl_alloc_cache();
+    if (cache && cache->bytes + bytes <= VNL_ALLOC_THREAD_CACHE_BYTES)
+    {
+      *static_cast<void**>(p) = cache->head[c];
+      cache->head[c] = p;
+      cache->bytes += bytes;
+      return;
+    }
+  }
+  vnl_alloc_system_deallocate(p);
+}
+
+void vnl_alloc::release_thread_cache()
+{
+  if (vnl_alloc_thread_cache* cache = vnl_alloc_cache())
+    vnl_alloc_cache_release(*cache);
+}
+
 #ifdef TEST
 int main()
 {
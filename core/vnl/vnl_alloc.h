@@ -33,6 +33,13 @@
 //
 // Note that containers built on different allocator instances have
 // different types, limiting the utility of this approach.
+//
+// allocate_aligned() and deallocate_aligned() form a second, independent
+// pool used for the element storage of vnl_vector and vnl_matrix.  Blocks
+// are aligned to VNL_ALLOC_DATA_ALIGN bytes, so SIMD code never straddles a
+// cache line at the start of a vector, and freed blocks are kept on per-thread
+// free lists, one per size class, so that repeatedly creating temporaries of
+// the same size does not go back to the system heap.
 
 #include <cstddef>
 #include <vcl_compiler.h>
@@ -42,6 +49,13 @@ VXL_CONSTEXPR_VAR int VNL_ALLOC_ALIGN = 8;
 VXL_CONSTEXPR_VAR std::size_t VNL_ALLOC_MAX_BYTES = 256;
 VXL_CONSTEXPR_VAR std::size_t VNL_ALLOC_NFREELISTS = VNL_ALLOC_MAX_BYTES/VNL_ALLOC_ALIGN;
 
+//: Alignment of blocks from vnl_alloc::allocate_aligned(): a cache line, and enough for AVX-512.
+VXL_CONSTEXPR_VAR std::size_t VNL_ALLOC_DATA_ALIGN = 64;
+//: Largest block recycled by allocate_aligned(); larger ones go straight to the system.
+VXL_CONSTEXPR_VAR std::size_t VNL_ALLOC_POOL_MAX_BYTES = 1 << 20;
+//: Most bytes each thread keeps on its free lists.
+VXL_CONSTEXPR_VAR std::size_t VNL_ALLOC_THREAD_CACHE_BYTES = 8 << 20;
+
 class VNL_EXPORT vnl_alloc
 {
   static std::size_t ROUND_UP(std::size_t bytes) {
@@ -123,6 +137,23 @@ class VNL_EXPORT vnl_alloc
   }
 
   static void * reallocate(void *p, std::size_t old_sz, std::size_t new_sz);
+
+  //: Allocate n bytes aligned to VNL_ALLOC_DATA_ALIGN.
+  // Requests up to VNL_ALLOC_POOL_MAX_BYTES are rounded up to one of four
+  // size classes per power of two and served from the calling thread's free
+  // list when possible.  This is thread safe, and a block may be freed by a
+  // different thread than the one which allocated it.  n may be 0.
+  static void * allocate_aligned(std::size_t n);
+
+  //: Free a block from allocate_aligned(); n must be the size requested.  p may be 0.
+  static void deallocate_aligned(void *p, std::size_t n);
+
+  //: Give the blocks cached by the calling thread back to the system.
+  // This happens automatically when a thread exits.
+  static void release_thread_cache();
+
+  //: Number of bytes actually reserved for a request of n bytes by allocate_aligned().
+  static std::size_t aligned_block_size(std::size_t n);
 };
 
 # endif // vnl_alloc_h_
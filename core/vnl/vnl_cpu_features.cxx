@@ -0,0 +1,127 @@
+// This is core/vnl/vnl_cpu_features.cxx
+//:
+// \file
+
+#include <cstdlib>
+#include <cstring>
+#include "vnl_cpu_features.h"
+
+#if VXL_FULLCXX11SUPPORT
+# include <atomic>
+#endif
+
+#if VNL_CPU_X86
+# if defined(_MSC_VER)
+#  include <intrin.h>
+# else
+#  include <cpuid.h>
+# endif
+#endif
+
+#if VNL_CPU_X86
+static void vnl_cpu_features_cpuid(unsigned leaf, unsigned subleaf, unsigned r[4])
+{
+# if defined(_MSC_VER)
+  int regs[4];
+  __cpuidex(regs, int(leaf), int(subleaf));
+  for (int i = 0; i < 4; ++i) r[i] = unsigned(regs[i]);
+# else
+  __cpuid_count(leaf, subleaf, r[0], r[1], r[2], r[3]);
+# endif
+}
+
+//: Extended control register 0, which tells which register sets the OS saves.
+static unsigned long long vnl_cpu_features_xgetbv()
+{
+# if defined(_MSC_VER)
+  return _xgetbv(0);
+# else
+  unsigned eax, edx;
+  __asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<unsigned long long>(edx) << 32) | eax;
+# endif
+}
+#endif // VNL_CPU_X86
+
+static vnl_cpu_features::level vnl_cpu_features_detect()
+{
+  vnl_cpu_features::level l = vnl_cpu_features::scalar;
+#if VNL_CPU_X86
+  unsigned r[4];
+  vnl_cpu_features_cpuid(0, 0, r);
+  const unsigned max_leaf = r[0];
+  if (max_leaf < 1)
+    return l;
+  vnl_cpu_features_cpuid(1, 0, r);
+  const unsigned ecx1 = r[2], edx1 = r[3];
+  if (!(edx1 & (1u<<26))) // SSE2
+    return l;
+  l = vnl_cpu_features::sse2;
+
+  const bool osxsave = (ecx1 & (1u<<27)) != 0;
+  const bool fma     = (ecx1 & (1u<<12)) != 0;
+  const bool avx     = (ecx1 & (1u<<28)) != 0;
+  if (!osxsave || !avx || !fma || max_leaf < 7)
+    return l;
+  const unsigned long long xcr0 = vnl_cpu_features_xgetbv();
+  if ((xcr0 & 0x6) != 0x6) // XMM and YMM state
+    return l;
+  vnl_cpu_features_cpuid(7, 0, r);
+  const unsigned ebx7 = r[1];
+  if (!(ebx7 & (1u<<5))) // AVX2
+    return l;
+  l = vnl_cpu_features::avx2;
+
+  if ((ebx7 & (1u<<16)) && (xcr0 & 0xe0) == 0xe0) // AVX-512F, opmask and ZMM state
+    l = vnl_cpu_features::avx512;
+#endif
+  return l;
+}
+
+//: Lowest level named in VNL_CPU_FEATURES_DISABLE, minus one.
+static vnl_cpu_features::level vnl_cpu_features_env_cap()
+{
+  char const* s = std::getenv("VNL_CPU_FEATURES_DISABLE");
+  if (!s) return vnl_cpu_features::avx512;
+  if (std::strstr(s, "sse2"))   return vnl_cpu_features::scalar;
+  if (std::strstr(s, "avx2"))   return vnl_cpu_features::sse2;
+  if (std::strstr(s, "avx512")) return vnl_cpu_features::avx2;
+  return vnl_cpu_features::avx512;
+}
+
+static vnl_cpu_features::level vnl_cpu_features_available()
+{
+  const vnl_cpu_features::level hw = vnl_cpu_features_detect();
+  const vnl_cpu_features::level cap = vnl_cpu_features_env_cap();
+  return hw < cap ? hw : cap;
+}
+
+// May be set while other threads are dispatching.
+#if VXL_FULLCXX11SUPPORT
+static std::atomic<vnl_cpu_features::level> vnl_cpu_features_cap(vnl_cpu_features::avx512);
+#else
+static vnl_cpu_features::level vnl_cpu_features_cap = vnl_cpu_features::avx512;
+#endif
+
+vnl_cpu_features::level vnl_cpu_features::best()
+{
+  static const level detected = vnl_cpu_features_available();
+  const level cap = vnl_cpu_features_cap;
+  return detected < cap ? detected : cap;
+}
+
+void vnl_cpu_features::set_max_level(level l)
+{
+  vnl_cpu_features_cap = l;
+}
+
+char const* vnl_cpu_features::name(level l)
+{
+  switch (l)
+  {
+    case sse2:   return "sse2";
+    case avx2:   return "avx2";
+    case avx512: return "avx512";
+    default:     return "scalar";
+  }
+}
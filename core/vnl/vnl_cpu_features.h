@@ -0,0 +1,69 @@
+// This is core/vnl/vnl_cpu_features.h
+#ifndef vnl_cpu_features_h_
+#define vnl_cpu_features_h_
+//:
+// \file
+// \brief Run-time detection of the SIMD instruction sets supported by the host CPU
+//
+// The vnl kernels which have hand-vectorised variants (vnl_gemm, vnl_sse)
+// are compiled for several instruction sets in the same binary, and choose
+// between them on first use by querying this class.  This means one build
+// can be shipped to machines with and without AVX2 or AVX-512.
+//
+// Detection uses CPUID (and XGETBV, to check that the operating system saves
+// the wide registers) on x86 and x86-64 with gcc, clang or Visual C++.  On
+// all other platforms every query returns false and the portable code paths
+// are used.
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <vcl_compiler.h>
+#include "vnl/vnl_export.h"
+
+// Determine whether this compiler lets us emit code for instruction sets
+// beyond those enabled on the command line, one function at a time.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(__INTEL_COMPILER) && \
+    (defined(__x86_64__) || defined(__i386__))
+# define VNL_CPU_X86 1
+# define VNL_CPU_TARGET_SSE2   __attribute__((target("sse2")))
+# define VNL_CPU_TARGET_AVX2   __attribute__((target("avx2,fma")))
+# define VNL_CPU_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#elif defined(_MSC_VER) && _MSC_VER >= 1910 && (defined(_M_X64) || defined(_M_IX86))
+# define VNL_CPU_X86 1
+# define VNL_CPU_TARGET_SSE2
+# define VNL_CPU_TARGET_AVX2
+# define VNL_CPU_TARGET_AVX512
+#else
+# define VNL_CPU_X86 0
+#endif
+
+//: Run-time query of the SIMD features of the host processor.
+// The result of the detection is computed once and cached.
+// Setting the environment variable VNL_CPU_FEATURES_DISABLE to "avx512",
+// "avx2" or "sse2" disables that instruction set and everything above it,
+// which is useful for testing the fallback code paths.
+class VNL_EXPORT vnl_cpu_features
+{
+ public:
+  //: Instruction set levels, in increasing order of capability.
+  enum level { scalar = 0, sse2, avx2, avx512 };
+
+  //: The best instruction set level usable on this machine.
+  static level best();
+
+  static bool has_sse2()   { return best() >= sse2; }
+  //: True if AVX2 and FMA3 are both available.
+  static bool has_avx2()   { return best() >= avx2; }
+  static bool has_avx512() { return best() >= avx512; }
+
+  //: Restrict the level used by the dispatching kernels (for testing and benchmarking).
+  // The level can only be lowered below what the hardware provides.
+  static void set_max_level(level l);
+
+  //: Human readable name of a level, e.g. "avx2".
+  static char const* name(level l);
+};
+
+#endif // vnl_cpu_features_h_
@@ -13,6 +13,7 @@
 #include <cstring>
 #include <iostream>
 #include "vnl_fastops.h"
+#include <vnl/vnl_gemm.h>
 
 #include <vcl_compiler.h>
 
@@ -29,6 +30,11 @@ void vnl_fastops::AtA(vnl_matrix<double>& out, const vnl_matrix<double>& A)
   double const* const* a = A.data_array();
   double** ata = out.data_array();
 
+  if (vnl_gemm::use_blocked(n, n, m)) {
+    vnl_gemm::gemm(true, false, n, n, m, 1.0, a[0], n, a[0], n, 0.0, ata[0], n);
+    return;
+  }
+
 /* Simple Implementation for reference:
     for (unsigned int i = 0; i < n; ++i)
       for (unsigned int j = i; j < n; ++j) {
@@ -77,6 +83,11 @@ void vnl_fastops::AB(vnl_matrix<double>& out, const vnl_matrix<double>& A, const
   double const* const* b = B.data_array();
   double** outdata = out.data_array();
 
+  if (vnl_gemm::use_blocked(ma, nb, na)) {
+    vnl_gemm::gemm(false, false, ma, nb, na, 1.0, a[0], na, b[0], nb, 0.0, outdata[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < ma; ++i)
     for (unsigned int j = 0; j < nb; ++j) {
       double accum = 0;
@@ -109,6 +120,11 @@ void vnl_fastops::AtB(vnl_matrix<double>& out, const vnl_matrix<double>& A, cons
   double const* const* b = B.data_array();
   double** outdata = out.data_array();
 
+  if (vnl_gemm::use_blocked(na, nb, ma)) {
+    vnl_gemm::gemm(true, false, na, nb, ma, 1.0, a[0], na, b[0], nb, 0.0, outdata[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < na; ++i)
     for (unsigned int j = 0; j < nb; ++j) {
       double accum = 0;
@@ -201,6 +217,11 @@ void vnl_fastops::ABt(vnl_matrix<double>& out, const vnl_matrix<double>& A, cons
   double const* const* b = B.data_array();
   double** outdata = out.data_array();
 
+  if (vnl_gemm::use_blocked(ma, mb, na)) {
+    vnl_gemm::gemm(false, true, ma, mb, na, 1.0, a[0], na, b[0], nb, 0.0, outdata[0], mb);
+    return;
+  }
+
   for (unsigned int i = 0; i < ma; ++i)
     for (unsigned int j = 0; j < mb; ++j) {
       double accum = 0;
@@ -301,6 +322,11 @@ void vnl_fastops::inc_X_by_AtA(vnl_matrix<double>& X, const vnl_matrix<double>&
   double const* const* a = A.data_array();
   double** x = X.data_array();
 
+  if (vnl_gemm::use_blocked(n, n, l)) {
+    vnl_gemm::gemm(true, false, n, n, l, 1.0, a[0], n, a[0], n, 1.0, x[0], n);
+    return;
+  }
+
   if (l == 2) {
     for (unsigned int i = 0; i < n; ++i) {
       x[i][i] += (a[0][i] * a[0][i] + a[1][i] * a[1][i]);
@@ -350,6 +376,11 @@ void vnl_fastops::inc_X_by_AB(vnl_matrix<double>& X, const vnl_matrix<double>& A
   double const* const* b = B.data_array();
   double** x = X.data_array();
 
+  if (vnl_gemm::use_blocked(ma, nb, na)) {
+    vnl_gemm::gemm(false, false, ma, nb, na, 1.0, a[0], na, b[0], nb, 1.0, x[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < ma; ++i)
     for (unsigned int j = 0; j < nb; ++j)
       for (unsigned int k = 0; k < na; ++k)
@@ -383,6 +414,11 @@ void vnl_fastops::dec_X_by_AB(vnl_matrix<double>& X, const vnl_matrix<double>& A
   double const* const* b = B.data_array();
   double** x = X.data_array();
 
+  if (vnl_gemm::use_blocked(ma, nb, na)) {
+    vnl_gemm::gemm(false, false, ma, nb, na, -1.0, a[0], na, b[0], nb, 1.0, x[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < ma; ++i)
     for (unsigned int j = 0; j < nb; ++j)
       for (unsigned int k = 0; k < na; ++k)
@@ -416,6 +452,11 @@ void vnl_fastops::inc_X_by_AtB(vnl_matrix<double>& X, const vnl_matrix<double>&
   double const* const* b = B.data_array();
   double** x = X.data_array();
 
+  if (vnl_gemm::use_blocked(na, nb, ma)) {
+    vnl_gemm::gemm(true, false, na, nb, ma, 1.0, a[0], na, b[0], nb, 1.0, x[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < na; ++i)
     for (unsigned int j = 0; j < nb; ++j) {
       double accum = 0;
@@ -452,6 +493,11 @@ void vnl_fastops::dec_X_by_AtB(vnl_matrix<double>& X, const vnl_matrix<double>&
   double const* const* b = B.data_array();
   double** x = X.data_array();
 
+  if (vnl_gemm::use_blocked(na, nb, ma)) {
+    vnl_gemm::gemm(true, false, na, nb, ma, -1.0, a[0], na, b[0], nb, 1.0, x[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < na; ++i)
     for (unsigned int j = 0; j < nb; ++j) {
       double accum = 0;
@@ -544,6 +590,11 @@ void vnl_fastops::dec_X_by_AtA(vnl_matrix<double>& X, const vnl_matrix<double>&
   double const* const* a = A.data_array();
   double** x = X.data_array();
 
+  if (vnl_gemm::use_blocked(n, n, l)) {
+    vnl_gemm::gemm(true, false, n, n, l, -1.0, a[0], n, a[0], n, 1.0, x[0], n);
+    return;
+  }
+
   if (l == 2) {
     for (unsigned int i = 0; i < n; ++i) {
       x[i][i] -= (a[0][i] * a[0][i] + a[1][i] * a[1][i]);
@@ -620,6 +671,11 @@ void vnl_fastops::inc_X_by_ABt(vnl_matrix<double>& X, const vnl_matrix<double>&
   double const* const* b = B.data_array();
   double** x = X.data_array();
 
+  if (vnl_gemm::use_blocked(ma, mb, na)) {
+    vnl_gemm::gemm(false, true, ma, mb, na, 1.0, a[0], na, b[0], nb, 1.0, x[0], mb);
+    return;
+  }
+
   if (na == 3) {
     for (unsigned int i = 0; i < mb; ++i)
       for (unsigned int j = 0; j < ma; ++j)
@@ -669,6 +725,11 @@ void vnl_fastops::dec_X_by_ABt(vnl_matrix<double>& X, const vnl_matrix<double>&
   double const* const* b = B.data_array();
   double** x = X.data_array();
 
+  if (vnl_gemm::use_blocked(ma, mb, na)) {
+    vnl_gemm::gemm(false, true, ma, mb, na, -1.0, a[0], na, b[0], nb, 1.0, x[0], mb);
+    return;
+  }
+
   if (na == 3) {
     for (unsigned int i = 0; i < mb; ++i)
       for (unsigned int j = 0; j < ma; ++j)
@@ -0,0 +1,442 @@
+// This is core/vnl/vnl_gemm.cxx
+//:
+// \file
+// \brief Packed, register-tiled matrix multiply kernels
+//
+// The structure follows the well known Goto/BLIS decomposition:
+// \verbatim
+//   for each NC wide column panel of B and C
+//     for each KC deep slice of A and B          -> pack B slice (KC x NC)
+//       for each MC high row panel of A and C    -> pack A panel (MC x KC)
+//         for each NR wide column strip of C
+//           for each MR high row strip of C      -> MR x NR micro-kernel
+// \endverbatim
+// The packed A panel is laid out as consecutive MR x KC strips stored
+// column by column, and the packed B slice as consecutive KC x NR strips
+// stored row by row, so that the micro-kernel streams through both
+// with unit stride.  Partial strips at the edges are padded with zeros.
+
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+#include "vnl_gemm.h"
+#include <vnl/vnl_cpu_features.h>
+
+#include <vcl_compiler.h>
+
+#if VXL_FULLCXX11SUPPORT
+# include <atomic>
+# include <functional>
+# include <thread>
+#endif
+
+#if VNL_CPU_X86
+# include <immintrin.h>
+#endif
+
+//: Micro-kernel: c[i*ldc+j] += alpha * sum_p a[p*mr+i] b[p*nr+j], 0<=i<mr, 0<=j<nr.
+template <class T>
+struct vnl_gemm_kernel
+{
+  unsigned mr;
+  unsigned nr;
+  void (*fn)(unsigned kc, T const* a, T const* b, T alpha, T* c, std::size_t ldc);
+};
+
+// Panel sizes.  MC must be a multiple of every kernel's MR, and NC of every NR.
+static const unsigned vnl_gemm_kc = 256;
+static const unsigned vnl_gemm_nc = 4096;
+static inline unsigned vnl_gemm_mc(double const*) { return 72; }
+static inline unsigned vnl_gemm_mc(float const*) { return 144; }
+
+// The largest micro-tile, used to size the edge buffer.
+static const unsigned vnl_gemm_max_tile = 6*16;
+
+//----------------------------------------------------------------------
+// Portable kernel
+
+template <class T, unsigned MR, unsigned NR>
+static void vnl_gemm_kernel_generic(unsigned kc, T const* a, T const* b, T alpha, T* c, std::size_t ldc)
+{
+  T acc[MR*NR];
+  for (unsigned i = 0; i < MR*NR; ++i)
+    acc[i] = T(0);
+  for (unsigned p = 0; p < kc; ++p, a += MR, b += NR)
+    for (unsigned i = 0; i < MR; ++i)
+    {
+      const T ai = a[i];
+      for (unsigned j = 0; j < NR; ++j)
+        acc[i*NR+j] += ai * b[j];
+    }
+  for (unsigned i = 0; i < MR; ++i)
+    for (unsigned j = 0; j < NR; ++j)
+      c[i*ldc+j] += alpha * acc[i*NR+j];
+}
+
+#if VNL_CPU_X86
+
+//----------------------------------------------------------------------
+// SSE2 kernels: 4x4 doubles and 4x8 floats, 8 accumulator registers.
+
+#define VNL_GEMM_SSE2_ROW(i, set1, add, mul) \
+  { const a_t ai = set1(a[i]); \
+    c##i##0 = add(c##i##0, mul(ai, b0)); \
+    c##i##1 = add(c##i##1, mul(ai, b1)); }
+
+#define VNL_GEMM_STORE_ROW(i, off, load, store, add, mul) \
+  { T* ci = c + i*ldc; \
+    store(ci, add(load(ci), mul(al, c##i##0))); \
+    store(ci+off, add(load(ci+off), mul(al, c##i##1))); }
+
+VNL_CPU_TARGET_SSE2
+static void vnl_gemm_kernel_sse2(unsigned kc, double const* a, double const* b, double alpha, double* c, std::size_t ldc)
+{
+  typedef double T;
+  typedef __m128d a_t;
+  __m128d c00 = _mm_setzero_pd(), c01 = c00, c10 = c00, c11 = c00,
+          c20 = c00, c21 = c00, c30 = c00, c31 = c00;
+  for (unsigned p = 0; p < kc; ++p, a += 4, b += 4)
+  {
+    const __m128d b0 = _mm_loadu_pd(b), b1 = _mm_loadu_pd(b+2);
+    VNL_GEMM_SSE2_ROW(0, _mm_set1_pd, _mm_add_pd, _mm_mul_pd)
+    VNL_GEMM_SSE2_ROW(1, _mm_set1_pd, _mm_add_pd, _mm_mul_pd)
+    VNL_GEMM_SSE2_ROW(2, _mm_set1_pd, _mm_add_pd, _mm_mul_pd)
+    VNL_GEMM_SSE2_ROW(3, _mm_set1_pd, _mm_add_pd, _mm_mul_pd)
+  }
+  const __m128d al = _mm_set1_pd(alpha);
+  VNL_GEMM_STORE_ROW(0, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, _mm_mul_pd)
+  VNL_GEMM_STORE_ROW(1, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, _mm_mul_pd)
+  VNL_GEMM_STORE_ROW(2, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, _mm_mul_pd)
+  VNL_GEMM_STORE_ROW(3, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, _mm_mul_pd)
+}
+
+VNL_CPU_TARGET_SSE2
+static void vnl_gemm_kernel_sse2(unsigned kc, float const* a, float const* b, float alpha, float* c, std::size_t ldc)
+{
+  typedef float T;
+  typedef __m128 a_t;
+  __m128 c00 = _mm_setzero_ps(), c01 = c00, c10 = c00, c11 = c00,
+         c20 = c00, c21 = c00, c30 = c00, c31 = c00;
+  for (unsigned p = 0; p < kc; ++p, a += 4, b += 8)
+  {
+    const __m128 b0 = _mm_loadu_ps(b), b1 = _mm_loadu_ps(b+4);
+    VNL_GEMM_SSE2_ROW(0, _mm_set1_ps, _mm_add_ps, _mm_mul_ps)
+    VNL_GEMM_SSE2_ROW(1, _mm_set1_ps, _mm_add_ps, _mm_mul_ps)
+    VNL_GEMM_SSE2_ROW(2, _mm_set1_ps, _mm_add_ps, _mm_mul_ps)
+    VNL_GEMM_SSE2_ROW(3, _mm_set1_ps, _mm_add_ps, _mm_mul_ps)
+  }
+  const __m128 al = _mm_set1_ps(alpha);
+  VNL_GEMM_STORE_ROW(0, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_mul_ps)
+  VNL_GEMM_STORE_ROW(1, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_mul_ps)
+  VNL_GEMM_STORE_ROW(2, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_mul_ps)
+  VNL_GEMM_STORE_ROW(3, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_mul_ps)
+}
+
+//----------------------------------------------------------------------
+// AVX2+FMA kernels: 6x8 doubles and 6x16 floats, 12 accumulator registers.
+
+#define VNL_GEMM_AVX2_ROW(i, bcast, fmadd) \
+  { const a_t ai = bcast(a+i); \
+    c##i##0 = fmadd(ai, b0, c##i##0); \
+    c##i##1 = fmadd(ai, b1, c##i##1); }
+
+#define VNL_GEMM_AVX2_STORE_ROW(i, off, load, store, fmadd) \
+  { T* ci = c + i*ldc; \
+    store(ci, fmadd(al, c##i##0, load(ci))); \
+    store(ci+off, fmadd(al, c##i##1, load(ci+off))); }
+
+VNL_CPU_TARGET_AVX2
+static void vnl_gemm_kernel_avx2(unsigned kc, double const* a, double const* b, double alpha, double* c, std::size_t ldc)
+{
+  typedef double T;
+  typedef __m256d a_t;
+  __m256d c00 = _mm256_setzero_pd(), c01 = c00, c10 = c00, c11 = c00, c20 = c00, c21 = c00,
+          c30 = c00, c31 = c00, c40 = c00, c41 = c00, c50 = c00, c51 = c00;
+  for (unsigned p = 0; p < kc; ++p, a += 6, b += 8)
+  {
+    const __m256d b0 = _mm256_loadu_pd(b), b1 = _mm256_loadu_pd(b+4);
+    VNL_GEMM_AVX2_ROW(0, _mm256_broadcast_sd, _mm256_fmadd_pd)
+    VNL_GEMM_AVX2_ROW(1, _mm256_broadcast_sd, _mm256_fmadd_pd)
+    VNL_GEMM_AVX2_ROW(2, _mm256_broadcast_sd, _mm256_fmadd_pd)
+    VNL_GEMM_AVX2_ROW(3, _mm256_broadcast_sd, _mm256_fmadd_pd)
+    VNL_GEMM_AVX2_ROW(4, _mm256_broadcast_sd, _mm256_fmadd_pd)
+    VNL_GEMM_AVX2_ROW(5, _mm256_broadcast_sd, _mm256_fmadd_pd)
+  }
+  const __m256d al = _mm256_set1_pd(alpha);
+  VNL_GEMM_AVX2_STORE_ROW(0, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_fmadd_pd)
+  VNL_GEMM_AVX2_STORE_ROW(1, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_fmadd_pd)
+  VNL_GEMM_AVX2_STORE_ROW(2, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_fmadd_pd)
+  VNL_GEMM_AVX2_STORE_ROW(3, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_fmadd_pd)
+  VNL_GEMM_AVX2_STORE_ROW(4, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_fmadd_pd)
+  VNL_GEMM_AVX2_STORE_ROW(5, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_fmadd_pd)
+}
+
+VNL_CPU_TARGET_AVX2
+static void vnl_gemm_kernel_avx2(unsigned kc, float const* a, float const* b, float alpha, float* c, std::size_t ldc)
+{
+  typedef float T;
+  typedef __m256 a_t;
+  __m256 c00 = _mm256_setzero_ps(), c01 = c00, c10 = c00, c11 = c00, c20 = c00, c21 = c00,
+         c30 = c00, c31 = c00, c40 = c00, c41 = c00, c50 = c00, c51 = c00;
+  for (unsigned p = 0; p < kc; ++p, a += 6, b += 16)
+  {
+    const __m256 b0 = _mm256_loadu_ps(b), b1 = _mm256_loadu_ps(b+8);
+    VNL_GEMM_AVX2_ROW(0, _mm256_broadcast_ss, _mm256_fmadd_ps)
+    VNL_GEMM_AVX2_ROW(1, _mm256_broadcast_ss, _mm256_fmadd_ps)
+    VNL_GEMM_AVX2_ROW(2, _mm256_broadcast_ss, _mm256_fmadd_ps)
+    VNL_GEMM_AVX2_ROW(3, _mm256_broadcast_ss, _mm256_fmadd_ps)
+    VNL_GEMM_AVX2_ROW(4, _mm256_broadcast_ss, _mm256_fmadd_ps)
+    VNL_GEMM_AVX2_ROW(5, _mm256_broadcast_ss, _mm256_fmadd_ps)
+  }
+  const __m256 al = _mm256_set1_ps(alpha);
+  VNL_GEMM_AVX2_STORE_ROW(0, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_fmadd_ps)
+  VNL_GEMM_AVX2_STORE_ROW(1, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_fmadd_ps)
+  VNL_GEMM_AVX2_STORE_ROW(2, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_fmadd_ps)
+  VNL_GEMM_AVX2_STORE_ROW(3, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_fmadd_ps)
+  VNL_GEMM_AVX2_STORE_ROW(4, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_fmadd_ps)
+  VNL_GEMM_AVX2_STORE_ROW(5, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_fmadd_ps)
+}
+
+#undef VNL_GEMM_SSE2_ROW
+#undef VNL_GEMM_STORE_ROW
+#undef VNL_GEMM_AVX2_ROW
+#undef VNL_GEMM_AVX2_STORE_ROW
+
+#endif // VNL_CPU_X86
+
+//: Choose the widest micro-kernel the CPU supports.
+template <class T>
+static vnl_gemm_kernel<T> vnl_gemm_select_kernel()
+{
+  vnl_gemm_kernel<T> k;
+#if VNL_CPU_X86
+  if (vnl_cpu_features::has_avx2())
+  {
+    k.mr = 6; k.nr = 32/sizeof(T)*2; k.fn = &vnl_gemm_kernel_avx2;
+    return k;
+  }
+  if (vnl_cpu_features::has_sse2())
+  {
+    k.mr = 4; k.nr = 16/sizeof(T)*2; k.fn = &vnl_gemm_kernel_sse2;
+    return k;
+  }
+#endif
+  k.mr = 4; k.nr = 4; k.fn = &vnl_gemm_kernel_generic<T,4,4>;
+  return k;
+}
+
+//----------------------------------------------------------------------
+// Packing
+
+//: Pack the mc x kc block of A starting at a, element (i,p) at a[i*rs+p*cs].
+template <class T>
+static void vnl_gemm_pack_a(unsigned mc, unsigned kc, T const* a, std::ptrdiff_t rs, std::ptrdiff_t cs,
+                            unsigned mr, T* buf)
+{
+  for (unsigned i0 = 0; i0 < mc; i0 += mr)
+  {
+    const unsigned mi = std::min(mr, mc - i0);
+    T const* ai0 = a + i0*rs;
+    for (unsigned p = 0; p < kc; ++p)
+    {
+      T const* ap = ai0 + p*cs;
+      unsigned i = 0;
+      for (; i < mi; ++i) *buf++ = ap[i*rs];
+      for (; i < mr; ++i) *buf++ = T(0);
+    }
+  }
+}
+
+//: Pack the kc x nc block of B starting at b, element (p,j) at b[p*rs+j*cs].
+template <class T>
+static void vnl_gemm_pack_b(unsigned kc, unsigned nc, T const* b, std::ptrdiff_t rs, std::ptrdiff_t cs,
+                            unsigned nr, T* buf)
+{
+  for (unsigned j0 = 0; j0 < nc; j0 += nr)
+  {
+    const unsigned nj = std::min(nr, nc - j0);
+    T const* bj0 = b + j0*cs;
+    for (unsigned p = 0; p < kc; ++p)
+    {
+      T const* bp = bj0 + p*rs;
+      unsigned j = 0;
+      if (cs == 1)
+        for (; j < nj; ++j) *buf++ = bp[j];
+      else
+        for (; j < nj; ++j) *buf++ = bp[j*cs];
+      for (; j < nr; ++j) *buf++ = T(0);
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+// Drivers
+
+//: Single threaded C += alpha A B on strided operands.
+template <class T>
+static void vnl_gemm_serial(vnl_gemm_kernel<T> const& kern,
+                            unsigned m, unsigned n, unsigned k, T alpha,
+                            T const* a, std::ptrdiff_t rsa, std::ptrdiff_t csa,
+                            T const* b, std::ptrdiff_t rsb, std::ptrdiff_t csb,
+                            T* c, std::size_t ldc)
+{
+  const unsigned mr = kern.mr, nr = kern.nr;
+  const unsigned mc_max = vnl_gemm_mc(a);
+  const unsigned kc_max = std::min(vnl_gemm_kc, k);
+  const unsigned nc_max = std::min(vnl_gemm_nc, (n + nr - 1) / nr * nr);
+
+  std::vector<T> abuf(std::size_t(std::min(mc_max, (m + mr - 1) / mr * mr)) * kc_max);
+  std::vector<T> bbuf(std::size_t(nc_max) * kc_max);
+  T edge[vnl_gemm_max_tile];
+
+  for (unsigned jc = 0; jc < n; jc += vnl_gemm_nc)
+  {
+    const unsigned nc = std::min(vnl_gemm_nc, n - jc);
+    for (unsigned pc = 0; pc < k; pc += vnl_gemm_kc)
+    {
+      const unsigned kc = std::min(vnl_gemm_kc, k - pc);
+      vnl_gemm_pack_b(kc, nc, b + pc*rsb + jc*csb, rsb, csb, nr, &bbuf[0]);
+      for (unsigned ic = 0; ic < m; ic += mc_max)
+      {
+        const unsigned mc = std::min(mc_max, m - ic);
+        vnl_gemm_pack_a(mc, kc, a + ic*rsa + pc*csa, rsa, csa, mr, &abuf[0]);
+        for (unsigned jr = 0; jr < nc; jr += nr)
+        {
+          const unsigned nj = std::min(nr, nc - jr);
+          T const* bp = &bbuf[0] + std::size_t(jr) * kc;
+          for (unsigned ir = 0; ir < mc; ir += mr)
+          {
+            const unsigned mi = std::min(mr, mc - ir);
+            T const* ap = &abuf[0] + std::size_t(ir) * kc;
+            T* cij = c + std::size_t(ic + ir) * ldc + jc + jr;
+            if (mi == mr && nj == nr)
+              kern.fn(kc, ap, bp, alpha, cij, ldc);
+            else
+            {
+              std::fill(edge, edge + mr*nr, T(0));
+              kern.fn(kc, ap, bp, alpha, edge, nr);
+              for (unsigned i = 0; i < mi; ++i)
+                for (unsigned j = 0; j < nj; ++j)
+                  cij[i*ldc+j] += edge[i*nr+j];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// May be set while other threads are multiplying.
+#if VXL_FULLCXX11SUPPORT
+static std::atomic<unsigned> vnl_gemm_threads(1);
+#else
+static unsigned vnl_gemm_threads = 1;
+#endif
+
+template <class T>
+static void vnl_gemm_impl(bool trans_a, bool trans_b,
+                          unsigned m, unsigned n, unsigned k,
+                          T alpha, T const* a, unsigned lda,
+                          T const* b, unsigned ldb,
+                          T beta, T* c, unsigned ldc)
+{
+  if (m == 0 || n == 0)
+    return;
+
+  if (beta == T(0))
+    for (unsigned i = 0; i < m; ++i)
+      std::fill(c + std::size_t(i)*ldc, c + std::size_t(i)*ldc + n, T(0));
+  else if (beta != T(1))
+    for (unsigned i = 0; i < m; ++i)
+      for (T* ci = c + std::size_t(i)*ldc, *cend = ci + n; ci != cend; ++ci)
+        *ci *= beta;
+
+  if (k == 0 || alpha == T(0))
+    return;
+
+  // Strides of the logical (possibly transposed) operands.
+  const std::ptrdiff_t rsa = trans_a ? 1 : std::ptrdiff_t(lda);
+  const std::ptrdiff_t csa = trans_a ? std::ptrdiff_t(lda) : 1;
+  const std::ptrdiff_t rsb = trans_b ? 1 : std::ptrdiff_t(ldb);
+  const std::ptrdiff_t csb = trans_b ? std::ptrdiff_t(ldb) : 1;
+
+  const vnl_gemm_kernel<T> kern = vnl_gemm_select_kernel<T>();
+
+#if VXL_FULLCXX11SUPPORT
+  // Split the rows of C into bands, each a whole number of micro-tiles.
+  // Each element of C still sees the same sequence of operations.
+  unsigned nthreads = vnl_gemm::num_threads();
+  const double flops = double(m) * double(n) * double(k);
+  if (flops < 4.0e6)
+    nthreads = 1;
+  nthreads = std::min(nthreads, (m + kern.mr - 1) / kern.mr);
+  if (nthreads > 1)
+  {
+    const unsigned tiles = (m + kern.mr - 1) / kern.mr;
+    std::vector<std::thread> workers;
+    unsigned row = 0;
+    for (unsigned t = 0; t < nthreads; ++t)
+    {
+      const unsigned band = (tiles * (t+1) / nthreads - tiles * t / nthreads) * kern.mr;
+      const unsigned rows = std::min(band, m - row);
+      if (t + 1 == nthreads)
+        vnl_gemm_serial(kern, rows, n, k, alpha, a + row*rsa, rsa, csa, b, rsb, csb,
+                        c + std::size_t(row)*ldc, ldc);
+      else
+        workers.push_back(std::thread(&vnl_gemm_serial<T>, std::cref(kern), rows, n, k, alpha,
+                                      a + row*rsa, rsa, csa, b, rsb, csb,
+                                      c + std::size_t(row)*ldc, std::size_t(ldc)));
+      row += rows;
+    }
+    for (std::size_t t = 0; t < workers.size(); ++t)
+      workers[t].join();
+    return;
+  }
+#endif
+  vnl_gemm_serial(kern, m, n, k, alpha, a, rsa, csa, b, rsb, csb, c, ldc);
+}
+
+//----------------------------------------------------------------------
+
+void vnl_gemm::gemm(bool trans_a, bool trans_b, unsigned m, unsigned n, unsigned k,
+                    double alpha, double const* a, unsigned lda,
+                    double const* b, unsigned ldb,
+                    double beta, double* c, unsigned ldc)
+{
+  vnl_gemm_impl(trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+void vnl_gemm::gemm(bool trans_a, bool trans_b, unsigned m, unsigned n, unsigned k,
+                    float alpha, float const* a, unsigned lda,
+                    float const* b, unsigned ldb,
+                    float beta, float* c, unsigned ldc)
+{
+  vnl_gemm_impl(trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+bool vnl_gemm::use_blocked(unsigned m, unsigned n, unsigned k)
+{
+  // Below about 32x32x32 the packing overhead outweighs the gain.
+  return m >= 4 && n >= 4 && k >= 4 &&
+         double(m) * double(n) * double(k) >= 32768.0;
+}
+
+void vnl_gemm::set_num_threads(unsigned n)
+{
+  vnl_gemm_threads = n;
+}
+
+unsigned vnl_gemm::num_threads()
+{
+#if VXL_FULLCXX11SUPPORT
+  const unsigned n = vnl_gemm_threads;
+  if (n == 0)
+  {
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw ? hw : 1;
+  }
+  return n;
+#else
+  return 1;
+#endif
+}
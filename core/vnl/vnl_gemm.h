@@ -0,0 +1,65 @@
+// This is core/vnl/vnl_gemm.h
+#ifndef vnl_gemm_h_
+#define vnl_gemm_h_
+//:
+// \file
+// \brief Cache-blocked general matrix-matrix multiply for float and double
+//
+// vnl_gemm computes C = alpha op(A) op(B) + beta C for dense row-major
+// matrices, where op(X) is X or its transpose.  The operands are split into
+// panels that fit in the caches, each panel is packed into a contiguous buffer,
+// and the product of the packed panels is computed by a small register-tiled
+// kernel.  Kernels exist for plain C++, SSE2 and AVX2+FMA; the best one
+// supported by the host CPU is chosen at run time (see vnl_cpu_features).
+//
+// The outer loop may optionally be split across several threads.  The
+// summation order of each element of C depends only on the kernel used,
+// not on the number of threads, so threaded and unthreaded results are
+// bit-identical.
+//
+// This is the engine behind vnl_matrix<float|double>::operator*() and
+// vnl_fastops::AB(), AtB(), ABt(), AtA() for all but small matrices.
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <vcl_compiler.h>
+#include "vnl/vnl_export.h"
+
+//: Cache-blocked general matrix-matrix multiply.
+class VNL_EXPORT vnl_gemm
+{
+ public:
+  //: C = alpha op(A) op(B) + beta C.
+  // op(A) is m x k, op(B) is k x n and C is m x n.  All three are stored
+  // row-major; \a lda, \a ldb and \a ldc are the distances between
+  // consecutive rows of the \e stored matrices.  If \a beta is zero,
+  // C need not be initialised.  C must not overlap A or B.
+  static void gemm(bool trans_a, bool trans_b,
+                   unsigned m, unsigned n, unsigned k,
+                   double alpha, double const* a, unsigned lda,
+                   double const* b, unsigned ldb,
+                   double beta, double* c, unsigned ldc);
+
+  //: C = alpha op(A) op(B) + beta C.
+  static void gemm(bool trans_a, bool trans_b,
+                   unsigned m, unsigned n, unsigned k,
+                   float alpha, float const* a, unsigned lda,
+                   float const* b, unsigned ldb,
+                   float beta, float* c, unsigned ldc);
+
+  //: True if an m x k by k x n product is large enough for blocking to pay off.
+  // Smaller products are faster with a straightforward triple loop.
+  static bool use_blocked(unsigned m, unsigned n, unsigned k);
+
+  //: Set the number of threads used for large products.
+  // The default is 1.  0 means one thread per hardware core.
+  // Has no effect if vxl is built without C++11 thread support.
+  static void set_num_threads(unsigned n);
+
+  //: The number of threads that will be used for large products.
+  static unsigned num_threads();
+};
+
+#endif // vnl_gemm_h_
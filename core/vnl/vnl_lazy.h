@@ -0,0 +1,265 @@
+// This is core/vnl/vnl_lazy.h
+#ifndef vnl_lazy_h_
+#define vnl_lazy_h_
+//:
+// \file
+// \brief Opt-in expression templates for element-wise vnl_vector and vnl_matrix arithmetic
+//
+// With the ordinary operators an expression such as a + b*s - c creates a
+// new vnl_vector for every operator.  Wrapping the operands in vnl_lazy()
+// instead builds a small description of the whole expression, which is
+// evaluated in a single loop, with at most one allocation, when it is
+// assigned:
+// \code
+//   vnl_vector<double> r = vnl_lazy(a) + vnl_lazy(b)*s - vnl_lazy(c);
+//   vnl_lazy(x) = vnl_lazy(x) - step*vnl_lazy(g);  // in place: no allocation
+//   vnl_lazy(x) += step*vnl_lazy(d);
+// \endcode
+// The same works for vnl_matrix.  Only element-wise operations are
+// provided: + and - between expressions of the same shape, unary -,
+// * and / by a scalar, + and - with a scalar, element_product() and
+// element_quotient().  Products with matrices are not fused; evaluate
+// them normally and wrap the result.
+//
+// Element i of the result depends only on element i of each operand, so
+// the target may also appear on the right hand side.  Expressions refer to
+// their operands by pointer: they must be used in the statement which
+// creates them and not stored.
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <cstddef>
+#include <vcl_compiler.h>
+#include <vnl/vnl_vector.h>
+#include <vnl/vnl_matrix.h>
+#include <vnl/vnl_error.h>
+
+//: Leaf node: the elements of an existing vector or matrix.
+template <class T>
+struct vnl_lazy_ref
+{
+  T const* p;
+  explicit vnl_lazy_ref(T const* data) : p(data) {}
+  T operator[](std::size_t i) const { return p[i]; }
+};
+
+//: Leaf node: a scalar, the same for every element.
+template <class T>
+struct vnl_lazy_scalar
+{
+  T s;
+  explicit vnl_lazy_scalar(T v) : s(v) {}
+  T operator[](std::size_t) const { return s; }
+};
+
+struct vnl_lazy_op_add { template <class T> static T apply(T a, T b) { return a + b; } };
+struct vnl_lazy_op_sub { template <class T> static T apply(T a, T b) { return a - b; } };
+struct vnl_lazy_op_mul { template <class T> static T apply(T a, T b) { return a * b; } };
+struct vnl_lazy_op_div { template <class T> static T apply(T a, T b) { return a / b; } };
+
+//: Interior node: Op applied to corresponding elements of A and B.
+template <class T, class A, class B, class Op>
+struct vnl_lazy_binary
+{
+  A a;
+  B b;
+  vnl_lazy_binary(A const& x, B const& y) : a(x), b(y) {}
+  T operator[](std::size_t i) const { return Op::apply(T(a[i]), T(b[i])); }
+};
+
+//: Interior node: element-wise negation.
+template <class T, class A>
+struct vnl_lazy_negate
+{
+  A a;
+  explicit vnl_lazy_negate(A const& x) : a(x) {}
+  T operator[](std::size_t i) const { return -a[i]; }
+};
+
+template <class T> inline unsigned vnl_lazy_rows(vnl_vector<T> const& v) { return unsigned(v.size()); }
+template <class T> inline unsigned vnl_lazy_cols(vnl_vector<T> const&) { return 1; }
+template <class T> inline unsigned vnl_lazy_rows(vnl_matrix<T> const& m) { return m.rows(); }
+template <class T> inline unsigned vnl_lazy_cols(vnl_matrix<T> const& m) { return m.cols(); }
+template <class T> inline void vnl_lazy_set_size(vnl_vector<T>& v, unsigned r, unsigned) { v.set_size(r); }
+template <class T> inline void vnl_lazy_set_size(vnl_matrix<T>& m, unsigned r, unsigned c) { m.set_size(r, c); }
+
+//: An element-wise expression whose value is of type R (a vnl_vector or vnl_matrix).
+// E is the root node of the expression tree.  A vector of length n has shape n x 1.
+template <class R, class E>
+class vnl_lazy_expr
+{
+ public:
+  typedef typename R::element_type element_type;
+
+  vnl_lazy_expr(E const& node, unsigned r, unsigned c) : node_(node), rows_(r), cols_(c) {}
+
+  E const& node() const { return node_; }
+  unsigned rows() const { return rows_; }
+  unsigned cols() const { return cols_; }
+  std::size_t size() const { return std::size_t(rows_) * cols_; }
+  element_type operator[](std::size_t i) const { return node_[i]; }
+
+  //: Write the value of the expression into dst, which must hold size() elements.
+  // This is the single loop into which the whole expression is fused.
+  void evaluate_into(element_type* dst) const
+  {
+    const std::size_t n = size();
+    for (std::size_t i = 0; i < n; ++i)
+      dst[i] = node_[i];
+  }
+
+  //: Evaluate into a newly allocated vector or matrix.
+  R eval() const
+  {
+    R r;
+    vnl_lazy_set_size(r, rows_, cols_);
+    evaluate_into(r.data_block());
+    return r;
+  }
+
+  operator R() const { return eval(); }
+
+ protected:
+  E node_;
+  unsigned rows_;
+  unsigned cols_;
+};
+
+//: A vector or matrix which may be assigned an expression.
+// Returned by vnl_lazy() for a non-const argument; it can also be used as an operand.
+template <class R>
+class vnl_lazy_target : public vnl_lazy_expr<R, vnl_lazy_ref<typename R::element_type> >
+{
+  typedef typename R::element_type T;
+  typedef vnl_lazy_expr<R, vnl_lazy_ref<T> > base;
+  R& target_;
+
+  void check_shape(unsigned r, unsigned c) const
+  {
+    if (r != this->rows_ || c != this->cols_)
+      vnl_error_matrix_dimension("vnl_lazy_target", this->rows_, this->cols_, r, c);
+  }
+
+ public:
+  explicit vnl_lazy_target(R& r)
+    : base(vnl_lazy_ref<T>(r.data_block()), vnl_lazy_rows(r), vnl_lazy_cols(r)), target_(r) {}
+
+  //: Evaluate e into the target, resizing it if needed.
+  template <class E>
+  vnl_lazy_target& operator=(vnl_lazy_expr<R, E> const& e)
+  {
+    if (e.rows() != this->rows_ || e.cols() != this->cols_)
+    {
+      vnl_lazy_set_size(target_, e.rows(), e.cols());
+      this->node_ = vnl_lazy_ref<T>(target_.data_block());
+      this->rows_ = e.rows(); this->cols_ = e.cols();
+    }
+    e.evaluate_into(target_.data_block());
+    return *this;
+  }
+
+  vnl_lazy_target& operator=(vnl_lazy_target const& e) { return operator=(static_cast<base const&>(e)); }
+
+  template <class E>
+  vnl_lazy_target& operator+=(vnl_lazy_expr<R, E> const& e)
+  {
+    check_shape(e.rows(), e.cols());
+    typedef vnl_lazy_binary<T, vnl_lazy_ref<T>, E, vnl_lazy_op_add> node;
+    vnl_lazy_expr<R, node>(node(this->node_, e.node()), this->rows_, this->cols_).evaluate_into(target_.data_block());
+    return *this;
+  }
+
+  template <class E>
+  vnl_lazy_target& operator-=(vnl_lazy_expr<R, E> const& e)
+  {
+    check_shape(e.rows(), e.cols());
+    typedef vnl_lazy_binary<T, vnl_lazy_ref<T>, E, vnl_lazy_op_sub> node;
+    vnl_lazy_expr<R, node>(node(this->node_, e.node()), this->rows_, this->cols_).evaluate_into(target_.data_block());
+    return *this;
+  }
+};
+
+//: Wrap a vector or matrix for use in a lazily evaluated expression.
+template <class T>
+inline vnl_lazy_expr<vnl_vector<T>, vnl_lazy_ref<T> > vnl_lazy(vnl_vector<T> const& v)
+{
+  return vnl_lazy_expr<vnl_vector<T>, vnl_lazy_ref<T> >(vnl_lazy_ref<T>(v.data_block()), unsigned(v.size()), 1);
+}
+
+template <class T>
+inline vnl_lazy_expr<vnl_matrix<T>, vnl_lazy_ref<T> > vnl_lazy(vnl_matrix<T> const& m)
+{
+  return vnl_lazy_expr<vnl_matrix<T>, vnl_lazy_ref<T> >(vnl_lazy_ref<T>(m.data_block()), m.rows(), m.cols());
+}
+
+//: Wrap a vector or matrix so that an expression can be assigned to it.
+template <class T>
+inline vnl_lazy_target<vnl_vector<T> > vnl_lazy(vnl_vector<T>& v) { return vnl_lazy_target<vnl_vector<T> >(v); }
+
+template <class T>
+inline vnl_lazy_target<vnl_matrix<T> > vnl_lazy(vnl_matrix<T>& m) { return vnl_lazy_target<vnl_matrix<T> >(m); }
+
+// Operators between two expressions of the same shape.
+#define VNL_LAZY_BINARY_OPERATOR(FN, OP) \
+template <class R, class A, class B> \
+inline vnl_lazy_expr<R, vnl_lazy_binary<typename R::element_type, A, B, OP> > \
+FN(vnl_lazy_expr<R, A> const& a, vnl_lazy_expr<R, B> const& b) \
+{ \
+  if (a.rows() != b.rows() || a.cols() != b.cols()) \
+    vnl_error_matrix_dimension(#FN, a.rows(), a.cols(), b.rows(), b.cols()); \
+  typedef vnl_lazy_binary<typename R::element_type, A, B, OP > node; \
+  return vnl_lazy_expr<R, node >(node(a.node(), b.node()), a.rows(), a.cols()); \
+}
+
+VNL_LAZY_BINARY_OPERATOR(operator+, vnl_lazy_op_add)
+VNL_LAZY_BINARY_OPERATOR(operator-, vnl_lazy_op_sub)
+VNL_LAZY_BINARY_OPERATOR(element_product, vnl_lazy_op_mul)
+VNL_LAZY_BINARY_OPERATOR(element_quotient, vnl_lazy_op_div)
+
+#undef VNL_LAZY_BINARY_OPERATOR
+
+// Operators between an expression and a scalar, in either order.
+#define VNL_LAZY_SCALAR_OPERATOR(OPERATOR, OP) \
+template <class R, class A> \
+inline vnl_lazy_expr<R, vnl_lazy_binary<typename R::element_type, A, vnl_lazy_scalar<typename R::element_type>, OP> > \
+OPERATOR(vnl_lazy_expr<R, A> const& a, typename R::element_type s) \
+{ \
+  typedef typename R::element_type T; \
+  typedef vnl_lazy_binary<T, A, vnl_lazy_scalar<T>, OP > node; \
+  return vnl_lazy_expr<R, node >(node(a.node(), vnl_lazy_scalar<T>(s)), a.rows(), a.cols()); \
+} \
+template <class R, class A> \
+inline vnl_lazy_expr<R, vnl_lazy_binary<typename R::element_type, vnl_lazy_scalar<typename R::element_type>, A, OP> > \
+OPERATOR(typename R::element_type s, vnl_lazy_expr<R, A> const& a) \
+{ \
+  typedef typename R::element_type T; \
+  typedef vnl_lazy_binary<T, vnl_lazy_scalar<T>, A, OP > node; \
+  return vnl_lazy_expr<R, node >(node(vnl_lazy_scalar<T>(s), a.node()), a.rows(), a.cols()); \
+}
+
+VNL_LAZY_SCALAR_OPERATOR(operator+, vnl_lazy_op_add)
+VNL_LAZY_SCALAR_OPERATOR(operator-, vnl_lazy_op_sub)
+VNL_LAZY_SCALAR_OPERATOR(operator*, vnl_lazy_op_mul)
+
+#undef VNL_LAZY_SCALAR_OPERATOR
+
+template <class R, class A>
+inline vnl_lazy_expr<R, vnl_lazy_binary<typename R::element_type, A, vnl_lazy_scalar<typename R::element_type>, vnl_lazy_op_div> >
+operator/(vnl_lazy_expr<R, A> const& a, typename R::element_type s)
+{
+  typedef typename R::element_type T;
+  typedef vnl_lazy_binary<T, A, vnl_lazy_scalar<T>, vnl_lazy_op_div> node;
+  return vnl_lazy_expr<R, node>(node(a.node(), vnl_lazy_scalar<T>(s)), a.rows(), a.cols());
+}
+
+template <class R, class A>
+inline vnl_lazy_expr<R, vnl_lazy_negate<typename R::element_type, A> >
+operator-(vnl_lazy_expr<R, A> const& a)
+{
+  typedef vnl_lazy_negate<typename R::element_type, A> node;
+  return vnl_lazy_expr<R, node>(node(a.node()), a.rows(), a.cols());
+}
+
+#endif // vnl_lazy_h_
@@ -93,6 +93,7 @@
 #include <vnl/vnl_vector.h>
 #include <vnl/vnl_c_vector.h>
 #include <vnl/vnl_numeric_traits.h>
+#include <vnl/vnl_gemm.h>
 //--------------------------------------------------------------------------------
 
 #if VCL_HAS_SLICED_DESTRUCTOR_BUG
@@ -331,6 +332,40 @@ vnl_matrix<T>::vnl_matrix (vnl_matrix<T> const &M, T s, vnl_tag_sub)
     dst[i] = T(m[i] - s);
 }
 
+//: Set the l x n matrix c to the product of the l x m matrix a and the m x n matrix b.
+template <class T>
+inline void vnl_matrix_multiply(T const* const* a, T const* const* b, T** c,
+                                unsigned int l, unsigned int m, unsigned int n)
+{
+  for (unsigned int i=0; i<l; ++i) {
+    for (unsigned int k=0; k<n; ++k) {
+      T sum(0);
+      for (unsigned int j=0; j<m; ++j)
+        sum += T(a[i][j] * b[j][k]);
+      c[i][k] = sum;
+    }
+  }
+}
+
+// Large float and double products use the cache-blocked kernel.
+inline void vnl_matrix_multiply(double const* const* a, double const* const* b, double** c,
+                                unsigned int l, unsigned int m, unsigned int n)
+{
+  if (vnl_gemm::use_blocked(l, n, m))
+    vnl_gemm::gemm(false, false, l, n, m, 1.0, a[0], m, b[0], n, 0.0, c[0], n);
+  else
+    vnl_matrix_multiply<double>(a, b, c, l, m, n);
+}
+
+inline void vnl_matrix_multiply(float const* const* a, float const* const* b, float** c,
+                                unsigned int l, unsigned int m, unsigned int n)
+{
+  if (vnl_gemm::use_blocked(l, n, m))
+    vnl_gemm::gemm(false, false, l, n, m, 1.0f, a[0], m, b[0], n, 0.0f, c[0], n);
+  else
+    vnl_matrix_multiply<float>(a, b, c, l, m, n);
+}
+
 template <class T>
 vnl_matrix<T>::vnl_matrix (vnl_matrix<T> const &A, vnl_matrix<T> const &B, vnl_tag_mul)
 : num_rows(A.num_rows), num_cols(B.num_cols)
@@ -347,14 +382,7 @@ vnl_matrix<T>::vnl_matrix (vnl_matrix<T> const &A, vnl_matrix<T> const &B, vnl_t
   vnl_matrix_construct_hack();
   vnl_matrix_alloc_blah();
 
-  for (unsigned int i=0; i<l; ++i) {
-    for (unsigned int k=0; k<n; ++k) {
-      T sum(0);
-      for (unsigned int j=0; j<m; ++j)
-        sum += T(A.data[i][j] * B.data[j][k]);
-      this->data[i][k] = sum;
-    }
-  }
+  vnl_matrix_multiply(A.data, B.data, this->data, l, m, n);
 }
 
 //------------------------------------------------------------
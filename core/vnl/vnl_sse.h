@@ -8,6 +8,8 @@
 // \verbatim
 //  Modifications
 //   2009-03-30 Peter Vanroose - Added arg_min() & arg_max() and reimplemented min() & max()
+//   Run-time dispatched SSE2/AVX2/AVX-512 specialisations (VNL_CONFIG_ENABLE_SIMD_DISPATCH)
+//   Storage always from vnl_alloc::allocate_aligned(), 64 byte aligned and pooled
 // \endverbatim
 
 #include <vcl_compiler.h> // for macro decisions based on compiler type
@@ -16,11 +18,12 @@
 
 #include <vnl/vnl_config.h> // is SSE enabled
 #include <vnl/vnl_alloc.h>  // is SSE enabled
+#include <vnl/vnl_sse_dispatch.h>
 #include "vnl/vnl_export.h"
 
 // some caveats...
-// - Due to the way vnl_matrix is represented in memory cannot guarantee 16-byte alignment,
-//   therefore have to use slower unaligned loading intrinsics for matrices.
+// - The storage of vnl_vector and of the whole of vnl_matrix is 64-byte aligned, but
+//   individual matrix rows are not, therefore have to use unaligned loading intrinsics for matrices.
 // - The GCC 3.4 intrinsics seem to be horrendously slow...
 
 // - On Mac OS X, in order to support Universal Binaries, we do not consider it a hard
@@ -56,33 +59,16 @@
 #endif
 
 
-// SSE operates faster with 16 byte aligned memory addresses.
-// Check what memory alignment function is supported
-#if VNL_CONFIG_ENABLE_SSE2 && VXL_HAS_MM_MALLOC
-# define VNL_SSE_ALLOC(n,s,a) _mm_malloc(n*s,a)
-# define VNL_SSE_FREE(v,n,s) _mm_free(v)
-#elif VNL_CONFIG_ENABLE_SSE2 && VXL_HAS_ALIGNED_MALLOC
-# include <malloc.h>
-# define VNL_SSE_ALLOC(n,s,a) _aligned_malloc(n*s,a)
-# define VNL_SSE_FREE(v,n,s) _aligned_free(v)
-#elif VNL_CONFIG_ENABLE_SSE2 && VXL_HAS_MINGW_ALIGNED_MALLOC
-# include <malloc.h>
-# define VNL_SSE_ALLOC(n,s,a) __mingw_aligned_malloc(n*s,a)
-# define VNL_SSE_FREE(v,n,s) __mingw_aligned_free(v)
-#elif VNL_CONFIG_ENABLE_SSE2 && VXL_HAS_POSIX_MEMALIGN
-# include <vcl_cstdlib.h>
-# define VNL_SSE_ALLOC(n,s,a) memalign(a,n*s)
-# define VNL_SSE_FREE(v,n,s) std::free(v)
-#else // sse2 disabled or could not get memory alignment support, use slower unaligned based intrinsics
+// SSE operates faster with aligned memory addresses.  All vnl_vector and
+// vnl_matrix storage comes from vnl_alloc's aligned pool, which guarantees
+// VNL_ALLOC_DATA_ALIGN (64) byte alignment and recycles freed blocks.
+// Only the compile-time SSE2 code relies on this for aligned loads, as
+// vnl_vector_ref and vnl_matrix_ref may wrap unaligned user memory.
+#define VNL_SSE_ALLOC(n,s,a) vnl_alloc::allocate_aligned((n)*(s))
+#define VNL_SSE_FREE(v,n,s) vnl_alloc::deallocate_aligned(v, (n)*(s))
+#if !VNL_CONFIG_ENABLE_SSE2
 # define VNL_SSE_HEAP_STORE(pf) _mm_storeu_##pf
 # define VNL_SSE_HEAP_LOAD(pf) _mm_loadu_##pf
-# if VNL_CONFIG_THREAD_SAFE
-#   define VNL_SSE_ALLOC(n,s,a) new char[n*s]
-#   define VNL_SSE_FREE(v,n,s) delete [] static_cast<char*>(v)
-# else
-#   define VNL_SSE_ALLOC(n,s,a) vnl_alloc::allocate((n == 0) ? 8 : (n * s));
-#   define VNL_SSE_FREE(v,n,s) if (v) vnl_alloc::deallocate(v, (n == 0) ? 8 : (n * s));
-# endif
 #endif
 
 
@@ -97,13 +83,13 @@
 # define VNL_SSE_HEAP_LOAD(pf) _mm_load_##pf
 #endif
 
-//: Custom memory allocation function to force 16 byte alignment of data
+//: Custom memory allocation function to force VNL_ALLOC_DATA_ALIGN byte alignment of data
 VNL_SSE_FORCE_INLINE void* vnl_sse_alloc(std::size_t n, unsigned size)
 {
-  return VNL_SSE_ALLOC(n,size,16);
+  return VNL_SSE_ALLOC(n,size,VNL_ALLOC_DATA_ALIGN);
 }
 
-//: Custom memory deallocation function to free 16 byte aligned of data
+//: Custom memory deallocation function to free VNL_ALLOC_DATA_ALIGN byte aligned data
 VNL_SSE_FORCE_INLINE void vnl_sse_dealloc(void* mem, std::size_t n, unsigned size)
 {
   // Variables n and size are not used in all versions of the VNL_SSE_FREE macro.
@@ -150,8 +136,9 @@ public:
 #endif // VNL_CONFIG_ENABLE_SSE2
 
 //: Bog standard (no sse) implementation for non sse enabled hardware and any type which doesn't have a template specialisation.
+// This is also the small vector path and the scalar fallback of the run-time dispatched specialisations.
 template <class T>
-class VNL_EXPORT vnl_sse
+class VNL_EXPORT vnl_sse_generic
 {
  public:
   static VNL_SSE_FORCE_INLINE void element_product(const T* x, const T* y, T* r, unsigned n)
@@ -254,6 +241,83 @@ class VNL_EXPORT vnl_sse
   }
 };
 
+template <class T>
+class VNL_EXPORT vnl_sse : public vnl_sse_generic<T> {};
+
+#if !VNL_CONFIG_ENABLE_SSE2 && VNL_CONFIG_ENABLE_SIMD_DISPATCH
+
+//: Below this many elements the plain loops win over an indirect call.
+#define VNL_SSE_DISPATCH_MIN_SIZE 16
+
+//: Run-time dispatched implementation, choosing SSE2, AVX2 or AVX-512 on first use.
+// See vnl_sse_dispatch.h.  Short vectors (such as those of vnl_vector_fixed)
+// are handled inline by vnl_sse_generic.
+template <class T>
+class VNL_EXPORT vnl_sse_dispatched : public vnl_sse_generic<T>
+{
+  typedef vnl_sse_generic<T> generic;
+  typedef vnl_sse_dispatch<T> simd;
+ public:
+  static VNL_SSE_FORCE_INLINE void element_product(const T* x, const T* y, T* r, unsigned n)
+  {
+    if (n < VNL_SSE_DISPATCH_MIN_SIZE) generic::element_product(x, y, r, n);
+    else simd::element_product(x, y, r, n);
+  }
+
+  static VNL_SSE_FORCE_INLINE T dot_product(const T* x, const T* y, unsigned n)
+  {
+    return n < VNL_SSE_DISPATCH_MIN_SIZE ? generic::dot_product(x, y, n) : simd::dot_product(x, y, n);
+  }
+
+  static VNL_SSE_FORCE_INLINE T euclid_dist_sq(const T* x, const T* y, unsigned n)
+  {
+    return n < VNL_SSE_DISPATCH_MIN_SIZE ? generic::euclid_dist_sq(x, y, n) : simd::euclid_dist_sq(x, y, n);
+  }
+
+  static VNL_SSE_FORCE_INLINE void vector_x_matrix(const T* v, const T* m, T* r, unsigned rows, unsigned cols)
+  {
+    if (cols < VNL_SSE_DISPATCH_MIN_SIZE) generic::vector_x_matrix(v, m, r, rows, cols);
+    else simd::vector_x_matrix(v, m, r, rows, cols);
+  }
+
+  static VNL_SSE_FORCE_INLINE void matrix_x_vector(const T* m, const T* v, T* r, unsigned rows, unsigned cols)
+  {
+    if (cols < VNL_SSE_DISPATCH_MIN_SIZE) generic::matrix_x_vector(m, v, r, rows, cols);
+    else simd::matrix_x_vector(m, v, r, rows, cols);
+  }
+
+  static VNL_SSE_FORCE_INLINE T sum(const T* v, unsigned n)
+  {
+    return n < VNL_SSE_DISPATCH_MIN_SIZE ? generic::sum(v, n) : simd::sum(v, n);
+  }
+
+  static VNL_SSE_FORCE_INLINE T max(const T* v, unsigned n)
+  {
+    return n < VNL_SSE_DISPATCH_MIN_SIZE ? generic::max(v, n) : simd::max(v, n);
+  }
+
+  static VNL_SSE_FORCE_INLINE T min(const T* v, unsigned n)
+  {
+    return n < VNL_SSE_DISPATCH_MIN_SIZE ? generic::min(v, n) : simd::min(v, n);
+  }
+
+  static VNL_SSE_FORCE_INLINE unsigned arg_max(const T* v, unsigned n)
+  {
+    return n < VNL_SSE_DISPATCH_MIN_SIZE ? generic::arg_max(v, n) : simd::arg_max(v, n);
+  }
+
+  static VNL_SSE_FORCE_INLINE unsigned arg_min(const T* v, unsigned n)
+  {
+    return n < VNL_SSE_DISPATCH_MIN_SIZE ? generic::arg_min(v, n) : simd::arg_min(v, n);
+  }
+};
+
+template <> class VNL_EXPORT vnl_sse<double> : public vnl_sse_dispatched<double> {};
+template <> class VNL_EXPORT vnl_sse<float>  : public vnl_sse_dispatched<float>  {};
+template <> class VNL_EXPORT vnl_sse<int>    : public vnl_sse_dispatched<int>    {};
+
+#endif // VNL_CONFIG_ENABLE_SIMD_DISPATCH
+
 #if VNL_CONFIG_ENABLE_SSE2
 
 //: SSE2 implementation for double precision floating point (64 bit)
@@ -0,0 +1,313 @@
+// This is core/vnl/vnl_sse_dispatch.cxx
+//:
+// \file
+// \brief Register wrappers and dispatch tables for vnl_sse_dispatch
+//
+// The kernels themselves are written once, in vnl_sse_dispatch_kernels.h, as
+// templates over a small wrapper class for the SIMD registers of each
+// instruction set.  That file is included once per instruction set, each
+// time inside its own namespace and with its own target attribute, so that
+// the compiler is free to use e.g. AVX2 in one copy and not in another
+// without any special command line flags.
+
+#include <cstddef>
+#include "vnl_sse_dispatch.h"
+#include <vnl/vnl_cpu_features.h>
+#include <vnl/vnl_sse.h>
+
+#include <vcl_compiler.h>
+
+#if VNL_CPU_X86
+# include <immintrin.h>
+#endif
+
+//: Pointers to one instruction set's implementation of each operation.
+template <class T>
+struct vnl_sse_dispatch_table
+{
+  void (*element_product)(const T* x, const T* y, T* r, unsigned n);
+  T (*dot_product)(const T* x, const T* y, unsigned n);
+  T (*euclid_dist_sq)(const T* x, const T* y, unsigned n);
+  void (*vector_x_matrix)(const T* v, const T* m, T* r, unsigned rows, unsigned cols);
+  void (*matrix_x_vector)(const T* m, const T* v, T* r, unsigned rows, unsigned cols);
+  T (*sum)(const T* v, unsigned n);
+  T (*max)(const T* v, unsigned n);
+  T (*min)(const T* v, unsigned n);
+  unsigned (*arg_max)(const T* v, unsigned n);
+  unsigned (*arg_min)(const T* v, unsigned n);
+};
+
+//: The plain C++ loops of vnl_sse_generic, unchanged.
+template <class T>
+static vnl_sse_dispatch_table<T> vnl_sse_dispatch_scalar_table()
+{
+  vnl_sse_dispatch_table<T> t;
+  t.element_product = &vnl_sse_generic<T>::element_product;
+  t.dot_product     = &vnl_sse_generic<T>::dot_product;
+  t.euclid_dist_sq  = &vnl_sse_generic<T>::euclid_dist_sq;
+  t.vector_x_matrix = &vnl_sse_generic<T>::vector_x_matrix;
+  t.matrix_x_vector = &vnl_sse_generic<T>::matrix_x_vector;
+  t.sum             = &vnl_sse_generic<T>::sum;
+  t.max             = &vnl_sse_generic<T>::max;
+  t.min             = &vnl_sse_generic<T>::min;
+  t.arg_max         = &vnl_sse_generic<T>::arg_max;
+  t.arg_min         = &vnl_sse_generic<T>::arg_min;
+  return t;
+}
+
+#if VNL_CPU_X86
+
+//----------------------------------------------------------------------
+// SSE2: 2 doubles, 4 floats or 4 ints per register.
+
+namespace vnl_sse_dispatch_sse2
+{
+#define VNL_SIMD_TARGET VNL_CPU_TARGET_SSE2
+
+template <class T> struct simd;
+
+template <> struct simd<double>
+{
+  typedef double T; typedef __m128d V; enum { W = 2 };
+  VNL_SIMD_TARGET static inline V zero() { return _mm_setzero_pd(); }
+  VNL_SIMD_TARGET static inline V set1(T a) { return _mm_set1_pd(a); }
+  VNL_SIMD_TARGET static inline V load(T const* p) { return _mm_loadu_pd(p); }
+  VNL_SIMD_TARGET static inline void store(T* p, V a) { _mm_storeu_pd(p, a); }
+  VNL_SIMD_TARGET static inline V add(V a, V b) { return _mm_add_pd(a, b); }
+  VNL_SIMD_TARGET static inline V sub(V a, V b) { return _mm_sub_pd(a, b); }
+  VNL_SIMD_TARGET static inline V mul(V a, V b) { return _mm_mul_pd(a, b); }
+  VNL_SIMD_TARGET static inline V fmadd(V a, V b, V c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+  VNL_SIMD_TARGET static inline V min(V a, V b) { return _mm_min_pd(a, b); }
+  VNL_SIMD_TARGET static inline V max(V a, V b) { return _mm_max_pd(a, b); }
+  VNL_SIMD_TARGET static inline unsigned eq_mask(V a, V b) { return unsigned(_mm_movemask_pd(_mm_cmpeq_pd(a, b))); }
+};
+
+template <> struct simd<float>
+{
+  typedef float T; typedef __m128 V; enum { W = 4 };
+  VNL_SIMD_TARGET static inline V zero() { return _mm_setzero_ps(); }
+  VNL_SIMD_TARGET static inline V set1(T a) { return _mm_set1_ps(a); }
+  VNL_SIMD_TARGET static inline V load(T const* p) { return _mm_loadu_ps(p); }
+  VNL_SIMD_TARGET static inline void store(T* p, V a) { _mm_storeu_ps(p, a); }
+  VNL_SIMD_TARGET static inline V add(V a, V b) { return _mm_add_ps(a, b); }
+  VNL_SIMD_TARGET static inline V sub(V a, V b) { return _mm_sub_ps(a, b); }
+  VNL_SIMD_TARGET static inline V mul(V a, V b) { return _mm_mul_ps(a, b); }
+  VNL_SIMD_TARGET static inline V fmadd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+  VNL_SIMD_TARGET static inline V min(V a, V b) { return _mm_min_ps(a, b); }
+  VNL_SIMD_TARGET static inline V max(V a, V b) { return _mm_max_ps(a, b); }
+  VNL_SIMD_TARGET static inline unsigned eq_mask(V a, V b) { return unsigned(_mm_movemask_ps(_mm_cmpeq_ps(a, b))); }
+};
+
+template <> struct simd<int>
+{
+  typedef int T; typedef __m128i V; enum { W = 4 };
+  VNL_SIMD_TARGET static inline V zero() { return _mm_setzero_si128(); }
+  VNL_SIMD_TARGET static inline V set1(T a) { return _mm_set1_epi32(a); }
+  VNL_SIMD_TARGET static inline V load(T const* p) { return _mm_loadu_si128(reinterpret_cast<V const*>(p)); }
+  VNL_SIMD_TARGET static inline void store(T* p, V a) { _mm_storeu_si128(reinterpret_cast<V*>(p), a); }
+  VNL_SIMD_TARGET static inline V add(V a, V b) { return _mm_add_epi32(a, b); }
+  VNL_SIMD_TARGET static inline V sub(V a, V b) { return _mm_sub_epi32(a, b); }
+  // SSE2 has no 32 bit multiply, min or max (they came with SSE4.1).
+  VNL_SIMD_TARGET static inline V mul(V a, V b)
+  {
+    V even = _mm_mul_epu32(a, b);
+    V odd  = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0,0,2,0)));
+  }
+  VNL_SIMD_TARGET static inline V fmadd(V a, V b, V c) { return _mm_add_epi32(mul(a, b), c); }
+  VNL_SIMD_TARGET static inline V min(V a, V b)
+  {
+    V mask = _mm_cmplt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+  }
+  VNL_SIMD_TARGET static inline V max(V a, V b)
+  {
+    V mask = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+  }
+  VNL_SIMD_TARGET static inline unsigned eq_mask(V a, V b)
+  { return unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)))); }
+};
+
+#include "vnl_sse_dispatch_kernels.h"
+#undef VNL_SIMD_TARGET
+}
+
+//----------------------------------------------------------------------
+// AVX2 + FMA: 4 doubles, 8 floats or 8 ints per register.
+
+namespace vnl_sse_dispatch_avx2
+{
+#define VNL_SIMD_TARGET VNL_CPU_TARGET_AVX2
+
+template <class T> struct simd;
+
+template <> struct simd<double>
+{
+  typedef double T; typedef __m256d V; enum { W = 4 };
+  VNL_SIMD_TARGET static inline V zero() { return _mm256_setzero_pd(); }
+  VNL_SIMD_TARGET static inline V set1(T a) { return _mm256_set1_pd(a); }
+  VNL_SIMD_TARGET static inline V load(T const* p) { return _mm256_loadu_pd(p); }
+  VNL_SIMD_TARGET static inline void store(T* p, V a) { _mm256_storeu_pd(p, a); }
+  VNL_SIMD_TARGET static inline V add(V a, V b) { return _mm256_add_pd(a, b); }
+  VNL_SIMD_TARGET static inline V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+  VNL_SIMD_TARGET static inline V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+  VNL_SIMD_TARGET static inline V fmadd(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+  VNL_SIMD_TARGET static inline V min(V a, V b) { return _mm256_min_pd(a, b); }
+  VNL_SIMD_TARGET static inline V max(V a, V b) { return _mm256_max_pd(a, b); }
+  VNL_SIMD_TARGET static inline unsigned eq_mask(V a, V b)
+  { return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ))); }
+};
+
+template <> struct simd<float>
+{
+  typedef float T; typedef __m256 V; enum { W = 8 };
+  VNL_SIMD_TARGET static inline V zero() { return _mm256_setzero_ps(); }
+  VNL_SIMD_TARGET static inline V set1(T a) { return _mm256_set1_ps(a); }
+  VNL_SIMD_TARGET static inline V load(T const* p) { return _mm256_loadu_ps(p); }
+  VNL_SIMD_TARGET static inline void store(T* p, V a) { _mm256_storeu_ps(p, a); }
+  VNL_SIMD_TARGET static inline V add(V a, V b) { return _mm256_add_ps(a, b); }
+  VNL_SIMD_TARGET static inline V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+  VNL_SIMD_TARGET static inline V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+  VNL_SIMD_TARGET static inline V fmadd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+  VNL_SIMD_TARGET static inline V min(V a, V b) { return _mm256_min_ps(a, b); }
+  VNL_SIMD_TARGET static inline V max(V a, V b) { return _mm256_max_ps(a, b); }
+  VNL_SIMD_TARGET static inline unsigned eq_mask(V a, V b)
+  { return unsigned(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ))); }
+};
+
+template <> struct simd<int>
+{
+  typedef int T; typedef __m256i V; enum { W = 8 };
+  VNL_SIMD_TARGET static inline V zero() { return _mm256_setzero_si256(); }
+  VNL_SIMD_TARGET static inline V set1(T a) { return _mm256_set1_epi32(a); }
+  VNL_SIMD_TARGET static inline V load(T const* p) { return _mm256_loadu_si256(reinterpret_cast<V const*>(p)); }
+  VNL_SIMD_TARGET static inline void store(T* p, V a) { _mm256_storeu_si256(reinterpret_cast<V*>(p), a); }
+  VNL_SIMD_TARGET static inline V add(V a, V b) { return _mm256_add_epi32(a, b); }
+  VNL_SIMD_TARGET static inline V sub(V a, V b) { return _mm256_sub_epi32(a, b); }
+  VNL_SIMD_TARGET static inline V mul(V a, V b) { return _mm256_mullo_epi32(a, b); }
+  VNL_SIMD_TARGET static inline V fmadd(V a, V b, V c) { return _mm256_add_epi32(_mm256_mullo_epi32(a, b), c); }
+  VNL_SIMD_TARGET static inline V min(V a, V b) { return _mm256_min_epi32(a, b); }
+  VNL_SIMD_TARGET static inline V max(V a, V b) { return _mm256_max_epi32(a, b); }
+  VNL_SIMD_TARGET static inline unsigned eq_mask(V a, V b)
+  { return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)))); }
+};
+
+#include "vnl_sse_dispatch_kernels.h"
+#undef VNL_SIMD_TARGET
+}
+
+//----------------------------------------------------------------------
+// AVX-512F: 8 doubles, 16 floats or 16 ints per register.
+
+namespace vnl_sse_dispatch_avx512
+{
+#define VNL_SIMD_TARGET VNL_CPU_TARGET_AVX512
+
+template <class T> struct simd;
+
+template <> struct simd<double>
+{
+  typedef double T; typedef __m512d V; enum { W = 8 };
+  VNL_SIMD_TARGET static inline V zero() { return _mm512_setzero_pd(); }
+  VNL_SIMD_TARGET static inline V set1(T a) { return _mm512_set1_pd(a); }
+  VNL_SIMD_TARGET static inline V load(T const* p) { return _mm512_loadu_pd(p); }
+  VNL_SIMD_TARGET static inline void store(T* p, V a) { _mm512_storeu_pd(p, a); }
+  VNL_SIMD_TARGET static inline V add(V a, V b) { return _mm512_add_pd(a, b); }
+  VNL_SIMD_TARGET static inline V sub(V a, V b) { return _mm512_sub_pd(a, b); }
+  VNL_SIMD_TARGET static inline V mul(V a, V b) { return _mm512_mul_pd(a, b); }
+  VNL_SIMD_TARGET static inline V fmadd(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+  VNL_SIMD_TARGET static inline V min(V a, V b) { return _mm512_min_pd(a, b); }
+  VNL_SIMD_TARGET static inline V max(V a, V b) { return _mm512_max_pd(a, b); }
+  VNL_SIMD_TARGET static inline unsigned eq_mask(V a, V b)
+  { return unsigned(_mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ)); }
+};
+
+template <> struct simd<float>
+{
+  typedef float T; typedef __m512 V; enum { W = 16 };
+  VNL_SIMD_TARGET static inline V zero() { return _mm512_setzero_ps(); }
+  VNL_SIMD_TARGET static inline V set1(T a) { return _mm512_set1_ps(a); }
+  VNL_SIMD_TARGET static inline V load(T const* p) { return _mm512_loadu_ps(p); }
+  VNL_SIMD_TARGET static inline void store(T* p, V a) { _mm512_storeu_ps(p, a); }
+  VNL_SIMD_TARGET static inline V add(V a, V b) { return _mm512_add_ps(a, b); }
+  VNL_SIMD_TARGET static inline V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+  VNL_SIMD_TARGET static inline V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+  VNL_SIMD_TARGET static inline V fmadd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+  VNL_SIMD_TARGET static inline V min(V a, V b) { return _mm512_min_ps(a, b); }
+  VNL_SIMD_TARGET static inline V max(V a, V b) { return _mm512_max_ps(a, b); }
+  VNL_SIMD_TARGET static inline unsigned eq_mask(V a, V b)
+  { return unsigned(_mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ)); }
+};
+
+template <> struct simd<int>
+{
+  typedef int T; typedef __m512i V; enum { W = 16 };
+  VNL_SIMD_TARGET static inline V zero() { return _mm512_setzero_si512(); }
+  VNL_SIMD_TARGET static inline V set1(T a) { return _mm512_set1_epi32(a); }
+  VNL_SIMD_TARGET static inline V load(T const* p) { return _mm512_loadu_si512(p); }
+  VNL_SIMD_TARGET static inline void store(T* p, V a) { _mm512_storeu_si512(p, a); }
+  VNL_SIMD_TARGET static inline V add(V a, V b) { return _mm512_add_epi32(a, b); }
+  VNL_SIMD_TARGET static inline V sub(V a, V b) { return _mm512_sub_epi32(a, b); }
+  VNL_SIMD_TARGET static inline V mul(V a, V b) { return _mm512_mullo_epi32(a, b); }
+  VNL_SIMD_TARGET static inline V fmadd(V a, V b, V c) { return _mm512_add_epi32(_mm512_mullo_epi32(a, b), c); }
+  VNL_SIMD_TARGET static inline V min(V a, V b) { return _mm512_min_epi32(a, b); }
+  VNL_SIMD_TARGET static inline V max(V a, V b) { return _mm512_max_epi32(a, b); }
+  VNL_SIMD_TARGET static inline unsigned eq_mask(V a, V b)
+  { return unsigned(_mm512_cmpeq_epi32_mask(a, b)); }
+};
+
+#include "vnl_sse_dispatch_kernels.h"
+#undef VNL_SIMD_TARGET
+}
+
+#endif // VNL_CPU_X86
+
+//: The kernels for the best instruction set currently allowed by vnl_cpu_features.
+template <class T>
+static vnl_sse_dispatch_table<T> const& vnl_sse_dispatch_get()
+{
+  // Filled once, on first use; the level is looked up on every call so that
+  // vnl_cpu_features::set_max_level() takes effect straight away.
+  static const vnl_sse_dispatch_table<T> tables[4] =
+  {
+    vnl_sse_dispatch_scalar_table<T>(),
+#if VNL_CPU_X86
+    vnl_sse_dispatch_sse2::make_table<T>(),
+    vnl_sse_dispatch_avx2::make_table<T>(),
+    vnl_sse_dispatch_avx512::make_table<T>()
+#else
+    vnl_sse_dispatch_scalar_table<T>(),
+    vnl_sse_dispatch_scalar_table<T>(),
+    vnl_sse_dispatch_scalar_table<T>()
+#endif
+  };
+  return tables[vnl_cpu_features::best()];
+}
+
+#define VNL_SSE_DISPATCH_INSTANTIATE(T) \
+void vnl_sse_dispatch<T >::element_product(const T* x, const T* y, T* r, unsigned n) \
+{ vnl_sse_dispatch_get<T >().element_product(x, y, r, n); } \
+T vnl_sse_dispatch<T >::dot_product(const T* x, const T* y, unsigned n) \
+{ return vnl_sse_dispatch_get<T >().dot_product(x, y, n); } \
+T vnl_sse_dispatch<T >::euclid_dist_sq(const T* x, const T* y, unsigned n) \
+{ return vnl_sse_dispatch_get<T >().euclid_dist_sq(x, y, n); } \
+void vnl_sse_dispatch<T >::vector_x_matrix(const T* v, const T* m, T* r, unsigned rows, unsigned cols) \
+{ vnl_sse_dispatch_get<T >().vector_x_matrix(v, m, r, rows, cols); } \
+void vnl_sse_dispatch<T >::matrix_x_vector(const T* m, const T* v, T* r, unsigned rows, unsigned cols) \
+{ vnl_sse_dispatch_get<T >().matrix_x_vector(m, v, r, rows, cols); } \
+T vnl_sse_dispatch<T >::sum(const T* v, unsigned n) \
+{ return vnl_sse_dispatch_get<T >().sum(v, n); } \
+T vnl_sse_dispatch<T >::max(const T* v, unsigned n) \
+{ return vnl_sse_dispatch_get<T >().max(v, n); } \
+T vnl_sse_dispatch<T >::min(const T* v, unsigned n) \
+{ return vnl_sse_dispatch_get<T >().min(v, n); } \
+unsigned vnl_sse_dispatch<T >::arg_max(const T* v, unsigned n) \
+{ return vnl_sse_dispatch_get<T >().arg_max(v, n); } \
+unsigned vnl_sse_dispatch<T >::arg_min(const T* v, unsigned n) \
+{ return vnl_sse_dispatch_get<T >().arg_min(v, n); }
+
+VNL_SSE_DISPATCH_INSTANTIATE(double)
+VNL_SSE_DISPATCH_INSTANTIATE(float)
+VNL_SSE_DISPATCH_INSTANTIATE(int)
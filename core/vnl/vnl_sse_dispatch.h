@@ -0,0 +1,52 @@
+// This is core/vnl/vnl_sse_dispatch.h
+#ifndef vnl_sse_dispatch_h_
+#define vnl_sse_dispatch_h_
+//:
+// \file
+// \brief Run-time dispatched SIMD kernels behind vnl_sse<double|float|int>
+//
+// Each operation of vnl_sse is compiled into the library several times:
+// plain C++, SSE2, AVX2+FMA and AVX-512, and the variant matching
+// vnl_cpu_features::best() is called.  Unlike the compile-time SSE2 code in
+// vnl_sse.h this needs no special compiler flags, makes no assumptions about
+// alignment, and uses the widest registers the machine really has.
+//
+// Floating point sums and dot products are accumulated in several partial
+// sums, so they may differ from the plain loop in the last bits.  max(),
+// min(), arg_max() and arg_min() give exactly the same result as the plain
+// loop for data without NaNs; in particular arg_max() and arg_min() return
+// the first index at which the extremum occurs.  Integer results are exact.
+//
+// \verbatim
+//  Modifications
+// \endverbatim
+
+#include <vcl_compiler.h>
+#include "vnl/vnl_export.h"
+
+template <class T> class vnl_sse_dispatch;
+
+#define VNL_SSE_DISPATCH_DECLARE(T) \
+template <> \
+class VNL_EXPORT vnl_sse_dispatch<T > \
+{ \
+ public: \
+  static void element_product(const T* x, const T* y, T* r, unsigned n); \
+  static T dot_product(const T* x, const T* y, unsigned n); \
+  static T euclid_dist_sq(const T* x, const T* y, unsigned n); \
+  static void vector_x_matrix(const T* v, const T* m, T* r, unsigned rows, unsigned cols); \
+  static void matrix_x_vector(const T* m, const T* v, T* r, unsigned rows, unsigned cols); \
+  static T sum(const T* v, unsigned n); \
+  static T max(const T* v, unsigned n); \
+  static T min(const T* v, unsigned n); \
+  static unsigned arg_max(const T* v, unsigned n); \
+  static unsigned arg_min(const T* v, unsigned n); \
+}
+
+VNL_SSE_DISPATCH_DECLARE(double);
+VNL_SSE_DISPATCH_DECLARE(float);
+VNL_SSE_DISPATCH_DECLARE(int);
+
+#undef VNL_SSE_DISPATCH_DECLARE
+
+#endif // vnl_sse_dispatch_h_
@@ -0,0 +1,250 @@
+// This is core/vnl/vnl_sse_dispatch_kernels.h
+// No include guard: this file is deliberately included several times.
+//:
+// \file
+// \brief Instruction set independent bodies of the vnl_sse_dispatch kernels
+//
+// For internal use by vnl_sse_dispatch.cxx only.  Before each inclusion
+// VNL_SIMD_TARGET must be defined as the function attribute selecting the
+// instruction set, and the inclusion must be wrapped in its own namespace
+// which also defines the register wrappers simd<T>, each providing
+//   typedef T (scalar), typedef V (register), enum { W } (lanes),
+//   zero(), set1(), load(), store(), add(), sub(), mul(), fmadd(a,b,c)=a*b+c,
+//   min(), max() and eq_mask() (bit i set if lane i of the arguments is equal).
+// The kernels are templates over such a wrapper S.
+// Memory is always accessed with unaligned loads and stores.
+
+template <class S> VNL_SIMD_TARGET
+static inline typename S::T lanes_sum(typename S::V v)
+{
+  typename S::T buf[S::W];
+  S::store(buf, v);
+  typename S::T r = buf[0];
+  for (unsigned i = 1; i < S::W; ++i) r += buf[i];
+  return r;
+}
+
+template <class S> VNL_SIMD_TARGET
+static inline typename S::T lanes_max(typename S::V v)
+{
+  typename S::T buf[S::W];
+  S::store(buf, v);
+  typename S::T r = buf[0];
+  for (unsigned i = 1; i < S::W; ++i) if (buf[i] > r) r = buf[i];
+  return r;
+}
+
+template <class S> VNL_SIMD_TARGET
+static inline typename S::T lanes_min(typename S::V v)
+{
+  typename S::T buf[S::W];
+  S::store(buf, v);
+  typename S::T r = buf[0];
+  for (unsigned i = 1; i < S::W; ++i) if (buf[i] < r) r = buf[i];
+  return r;
+}
+
+template <class S> VNL_SIMD_TARGET
+static void element_product(const typename S::T* x, const typename S::T* y, typename S::T* r, unsigned n)
+{
+  unsigned i = 0;
+  for (; i + S::W <= n; i += S::W)
+    S::store(r+i, S::mul(S::load(x+i), S::load(y+i)));
+  for (; i < n; ++i)
+    r[i] = x[i] * y[i];
+}
+
+template <class S> VNL_SIMD_TARGET
+static typename S::T dot_product(const typename S::T* x, const typename S::T* y, unsigned n)
+{
+  // Four independent accumulators hide the latency of the multiply-adds.
+  typename S::V s0 = S::zero(), s1 = S::zero(), s2 = S::zero(), s3 = S::zero();
+  unsigned i = 0;
+  for (; i + 4*S::W <= n; i += 4*S::W)
+  {
+    s0 = S::fmadd(S::load(x+i),        S::load(y+i),        s0);
+    s1 = S::fmadd(S::load(x+i+S::W),   S::load(y+i+S::W),   s1);
+    s2 = S::fmadd(S::load(x+i+2*S::W), S::load(y+i+2*S::W), s2);
+    s3 = S::fmadd(S::load(x+i+3*S::W), S::load(y+i+3*S::W), s3);
+  }
+  for (; i + S::W <= n; i += S::W)
+    s0 = S::fmadd(S::load(x+i), S::load(y+i), s0);
+  typename S::T r = lanes_sum<S>(S::add(S::add(s0, s1), S::add(s2, s3)));
+  for (; i < n; ++i)
+    r += x[i] * y[i];
+  return r;
+}
+
+template <class S> VNL_SIMD_TARGET
+static typename S::T euclid_dist_sq(const typename S::T* x, const typename S::T* y, unsigned n)
+{
+  typename S::V s0 = S::zero(), s1 = S::zero();
+  unsigned i = 0;
+  for (; i + 2*S::W <= n; i += 2*S::W)
+  {
+    typename S::V d0 = S::sub(S::load(x+i), S::load(y+i));
+    typename S::V d1 = S::sub(S::load(x+i+S::W), S::load(y+i+S::W));
+    s0 = S::fmadd(d0, d0, s0);
+    s1 = S::fmadd(d1, d1, s1);
+  }
+  for (; i + S::W <= n; i += S::W)
+  {
+    typename S::V d0 = S::sub(S::load(x+i), S::load(y+i));
+    s0 = S::fmadd(d0, d0, s0);
+  }
+  typename S::T r = lanes_sum<S>(S::add(s0, s1));
+  for (; i < n; ++i)
+  {
+    const typename S::T d = x[i] - y[i];
+    r += d * d;
+  }
+  return r;
+}
+
+template <class S> VNL_SIMD_TARGET
+static typename S::T sum(const typename S::T* v, unsigned n)
+{
+  typename S::V s0 = S::zero(), s1 = S::zero();
+  unsigned i = 0;
+  for (; i + 2*S::W <= n; i += 2*S::W)
+  {
+    s0 = S::add(s0, S::load(v+i));
+    s1 = S::add(s1, S::load(v+i+S::W));
+  }
+  for (; i + S::W <= n; i += S::W)
+    s0 = S::add(s0, S::load(v+i));
+  typename S::T r = lanes_sum<S>(S::add(s0, s1));
+  for (; i < n; ++i)
+    r += v[i];
+  return r;
+}
+
+template <class S> VNL_SIMD_TARGET
+static typename S::T max(const typename S::T* v, unsigned n)
+{
+  if (n==0) return typename S::T(0); // the maximum of an empty set is undefined
+  unsigned i = 0;
+  typename S::T r = v[0];
+  if (n >= S::W)
+  {
+    typename S::V m = S::load(v);
+    for (i = S::W; i + S::W <= n; i += S::W)
+      m = S::max(m, S::load(v+i));
+    r = lanes_max<S>(m);
+  }
+  for (; i < n; ++i)
+    if (v[i] > r) r = v[i];
+  return r;
+}
+
+template <class S> VNL_SIMD_TARGET
+static typename S::T min(const typename S::T* v, unsigned n)
+{
+  if (n==0) return typename S::T(0); // the minimum of an empty set is undefined
+  unsigned i = 0;
+  typename S::T r = v[0];
+  if (n >= S::W)
+  {
+    typename S::V m = S::load(v);
+    for (i = S::W; i + S::W <= n; i += S::W)
+      m = S::min(m, S::load(v+i));
+    r = lanes_min<S>(m);
+  }
+  for (; i < n; ++i)
+    if (v[i] < r) r = v[i];
+  return r;
+}
+
+//: Index of the first element equal to value, or n if there is none.
+template <class S> VNL_SIMD_TARGET
+static unsigned find_first(const typename S::T* v, unsigned n, typename S::T value)
+{
+  const typename S::V t = S::set1(value);
+  unsigned i = 0;
+  for (; i + S::W <= n; i += S::W)
+  {
+    unsigned mask = S::eq_mask(S::load(v+i), t);
+    if (mask)
+    {
+      while (!(mask & 1u)) mask >>= 1, ++i;
+      return i;
+    }
+  }
+  for (; i < n; ++i)
+    if (v[i] == value) return i;
+  return n;
+}
+
+template <class S> VNL_SIMD_TARGET
+static unsigned arg_max(const typename S::T* v, unsigned n)
+{
+  if (n==0) return unsigned(-1); // the maximum of an empty set is undefined
+  unsigned i = find_first<S>(v, n, max<S>(v, n));
+  if (i < n) return i;
+  // Only possible with NaNs: fall back to the sequential definition.
+  typename S::T tmp = v[0];
+  unsigned idx = 0;
+  for (i = 1; i < n; ++i)
+    if (v[i] > tmp) tmp = v[i], idx = i;
+  return idx;
+}
+
+template <class S> VNL_SIMD_TARGET
+static unsigned arg_min(const typename S::T* v, unsigned n)
+{
+  if (n==0) return unsigned(-1); // the minimum of an empty set is undefined
+  unsigned i = find_first<S>(v, n, min<S>(v, n));
+  if (i < n) return i;
+  typename S::T tmp = v[0];
+  unsigned idx = 0;
+  for (i = 1; i < n; ++i)
+    if (v[i] < tmp) tmp = v[i], idx = i;
+  return idx;
+}
+
+template <class S> VNL_SIMD_TARGET
+static void matrix_x_vector(const typename S::T* m, const typename S::T* v, typename S::T* r,
+                            unsigned rows, unsigned cols)
+{
+  for (unsigned i = 0; i < rows; ++i)
+    r[i] = dot_product<S>(m + std::size_t(i)*cols, v, cols);
+}
+
+//: r = v^T m, computed as a sum of scaled rows so that m is read sequentially.
+template <class S> VNL_SIMD_TARGET
+static void vector_x_matrix(const typename S::T* v, const typename S::T* m, typename S::T* r,
+                            unsigned rows, unsigned cols)
+{
+  for (unsigned j = 0; j < cols; ++j)
+    r[j] = typename S::T(0);
+  for (unsigned i = 0; i < rows; ++i)
+  {
+    const typename S::T* row = m + std::size_t(i)*cols;
+    const typename S::T a = v[i];
+    const typename S::V va = S::set1(a);
+    unsigned j = 0;
+    for (; j + S::W <= cols; j += S::W)
+      S::store(r+j, S::fmadd(va, S::load(row+j), S::load(r+j)));
+    for (; j < cols; ++j)
+      r[j] += a * row[j];
+  }
+}
+
+//: The table of kernels for scalar type T.
+template <class T>
+static vnl_sse_dispatch_table<T> make_table()
+{
+  typedef simd<T> S;
+  vnl_sse_dispatch_table<T> t;
+  t.element_product = &element_product<S>;
+  t.dot_product     = &dot_product<S>;
+  t.euclid_dist_sq  = &euclid_dist_sq<S>;
+  t.vector_x_matrix = &vector_x_matrix<S>;
+  t.matrix_x_vector = &matrix_x_vector<S>;
+  t.sum             = &sum<S>;
+  t.max             = &max<S>;
+  t.min             = &min<S>;
+  t.arg_max         = &arg_max<S>;
+  t.arg_min         = &arg_min<S>;
+  return t;
+}
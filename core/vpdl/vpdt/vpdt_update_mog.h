@@ -82,6 +82,7 @@ class vpdt_mog_updater
   }
 
   //: A model for new Gaussians inserted
+  //  Set for each sample inserted, so give each thread its own updater
   mutable gaussian_type init_gaussian_;
   //: The maximum number of components in the mixture
   unsigned int max_components_;
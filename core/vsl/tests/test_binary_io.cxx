@@ -2,8 +2,11 @@
 #include <iostream>
 #include <cstring>
 #include <cstddef>
+#include <sstream>
+#include <vector>
 #include <vcl_compiler.h>
 #include <vsl/vsl_binary_io.h>
+#include <vsl/vsl_block_binary.h>
 #include <vsl/vsl_quick_file.h>
 #include <testlib/testlib_root_dir.h>
 #include <testlib/testlib_test.h>
@@ -236,6 +239,135 @@ void test_binary_io()
   TEST("Golden std::ptrdiff_t out == std::ptrdiff_t in", ptrdiff_t_out, ptrdiff_t_in2);
 
 
+  std::cout << "**********************************\n"
+           << "Testing golden data, memory mapped\n"
+           << "**********************************\n";
+  {
+    vsl_b_imapped_fstream bfs_in3(gold_path);
+    TEST("Opened golden_test_binary_io.bvl mapped", (!bfs_in3), false);
+#if defined(__unix__) || defined(__unix) || defined(__APPLE__) || defined(_WIN32)
+    TEST("File is mapped", bfs_in3.is_mapped(), true);
+#endif
+    bool b_in3 = false;
+    char c_in3 = '?';
+    int i_in3 = 99;
+    long long_in3 = 99;
+    double d_in3 = 99.9;
+    std::string string_in3;
+    char c_string_in3[80];
+    std::ptrdiff_t ptrdiff_t_in3 = 99;
+    vsl_b_read(bfs_in3, b_in3);
+    vsl_b_read(bfs_in3, c_in3);
+    vsl_b_read(bfs_in3, sc_in2);
+    vsl_b_read(bfs_in3, uc_in2);
+    vsl_b_read(bfs_in3, i_in3);
+    vsl_b_read(bfs_in3, ui_in2);
+    vsl_b_read(bfs_in3, short_in2);
+    vsl_b_read(bfs_in3, ushort_in2);
+    vsl_b_read(bfs_in3, long_in3);
+    vsl_b_read(bfs_in3, ulong_in2);
+    vsl_b_read(bfs_in3, f_in2);
+    vsl_b_read(bfs_in3, d_in3);
+    vsl_b_read(bfs_in3, string_in3);
+    vsl_b_read(bfs_in3, c_string_in3);
+    vsl_b_read(bfs_in3, size_t_in2);
+    vsl_b_read(bfs_in3, ptrdiff_t_in3);
+    TEST("Finished reading mapped file successfully", (!bfs_in3), false);
+    TEST("Mapped bool", b_out, b_in3);
+    TEST("Mapped char", c_out, c_in3);
+    TEST("Mapped int", i_out, i_in3);
+    TEST("Mapped long", long_out, long_in3);
+    TEST("Mapped double", d_out, d_in3);
+    TEST("Mapped string", string_out, string_in3);
+    TEST("Mapped C string", std::string(c_string_out), std::string(c_string_in3));
+    TEST("Mapped std::ptrdiff_t", ptrdiff_t_out, ptrdiff_t_in3);
+
+    // go back to the first item, after the header
+    bfs_in3.is().seekg(vsl_b_ostream::header_length);
+    vsl_b_read(bfs_in3, b_in3);
+    vsl_b_read(bfs_in3, c_in3);
+    TEST("Seek in mapped file", (!bfs_in3) == false && b_in3 == b_out && c_in3 == c_out, true);
+    bfs_in3.is().seekg(0, std::ios::end);
+    vsl_b_read(bfs_in3, i_in3);
+    TEST("Reading past the end fails", (!bfs_in3) && bfs_in3.is().eof(), true);
+    bfs_in3.close();
+  }
+  {
+    vsl_b_imapped_fstream none("Some_non_existant_file");
+    TEST("Mapping a missing file fails", (!none) && !none.is_mapped(), true);
+  }
+
+  std::cout << "***************************\n"
+           << " Testing many large blocks\n"
+           << "***************************\n";
+  {
+    const unsigned n = 100000;
+    std::vector<double> d(n);
+    std::vector<int> v(n);
+    for (unsigned k = 0; k < n; ++k)
+    {
+      d[k] = 0.5 * k - 17.25;
+      v[k] = int(k * 7919u % 100003u) - 50000;
+    }
+    {
+      vsl_b_ofstream bfs_out2("vsl_binary_io_blocks.bvl.tmp");
+      for (unsigned k = 0; k < n; k += 10)
+        vsl_b_write(bfs_out2, v[k]); // scalars
+      vsl_block_binary_write(bfs_out2, &d[0], n);
+      vsl_block_binary_write(bfs_out2, &v[0], n);
+      vsl_b_write(bfs_out2, string_out);
+    }
+    for (unsigned mapped = 0; mapped < 2; ++mapped)
+    {
+      vsl_b_istream* bfs = mapped ?
+        (vsl_b_istream*) new vsl_b_imapped_fstream("vsl_binary_io_blocks.bvl.tmp") :
+        (vsl_b_istream*) new vsl_b_ifstream("vsl_binary_io_blocks.bvl.tmp");
+      bool ok = true;
+      for (unsigned k = 0; k < n; k += 10)
+      {
+        int x = 0;
+        vsl_b_read(*bfs, x);
+        ok = ok && x == v[k];
+      }
+      std::vector<double> d_in(n);
+      std::vector<int> v_in(n);
+      vsl_block_binary_read(*bfs, &d_in[0], n);
+      vsl_block_binary_read(*bfs, &v_in[0], n);
+      std::string s_in;
+      vsl_b_read(*bfs, s_in);
+      TEST(mapped ? "Read blocks mapped" : "Read blocks",
+           ok && !(!*bfs) && d_in == d && v_in == v && s_in == string_out, true);
+      delete bfs;
+    }
+    vpl_unlink("vsl_binary_io_blocks.bvl.tmp");
+  }
+
+  std::cout << "****************************\n"
+           << " Testing serialisation records\n"
+           << "****************************\n";
+  {
+    std::ostringstream oss;
+    vsl_b_ostream bos(&oss);
+    std::vector<int> objects(1000);
+    bool ok = true;
+    for (unsigned k = 0; k < objects.size(); ++k)
+      ok = ok && bos.add_serialisation_record(&objects[k], int(k)) == k+1;
+    for (unsigned k = 0; k < objects.size(); ++k)
+      ok = ok && bos.get_serial_number(&objects[k]) == k+1 &&
+           bos.get_serialisation_other_data(&objects[k]) == int(k);
+    TEST("Output records", ok && bos.get_serial_number(&i_out) == 0, true);
+
+    std::istringstream iss(oss.str());
+    vsl_b_istream bis(&iss);
+    for (unsigned k = 0; k < objects.size(); ++k)
+      bis.add_serialisation_record(k+1, &objects[k], int(k));
+    ok = true;
+    for (unsigned k = 0; k < objects.size(); ++k)
+      ok = ok && bis.get_serialisation_pointer(k+1) == &objects[k] &&
+           bis.get_serialisation_other_data(k+1) == int(k);
+    TEST("Input records", ok && bis.get_serialisation_pointer(5000) == VXL_NULLPTR, true);
+  }
+
   std::cout << "****************************\n"
            << " Testing magic number check\n"
            << "****************************\n";
@@ -0,0 +1,208 @@
+// This is core/vsl/tests/test_block_compress_io.cxx
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <vcl_compiler.h>
+#include <vsl/vsl_binary_io.h>
+#include <vsl/vsl_block_binary.h>
+#include <vsl/vsl_block_compress.h>
+#include <testlib/testlib_test.h>
+
+//: Write the values raw and compressed, and check both read back.
+template <class T>
+static void test_round_trip(const char* type_name, const std::vector<T>& v, bool expect_smaller)
+{
+  std::ostringstream raw_ss, lz_ss;
+  {
+    vsl_b_ostream raw_os(&raw_ss);
+    vsl_b_ostream lz_os(&lz_ss);
+    lz_os.set_block_format(vsl_b_block_lz);
+    vsl_block_binary_write(raw_os, &v[0], v.size());
+    vsl_block_binary_write(lz_os, &v[0], v.size());
+    vsl_b_write(lz_os, 12345); // something after the block
+  }
+  std::cout << type_name << " x " << v.size() << ": raw " << raw_ss.str().size()
+            << " bytes, compressed " << lz_ss.str().size() << " bytes\n";
+
+  std::istringstream lz_is_ss(lz_ss.str());
+  vsl_b_istream lz_is(&lz_is_ss);
+  std::vector<T> w(v.size());
+  vsl_block_binary_read(lz_is, &w[0], w.size());
+  int after = 0;
+  vsl_b_read(lz_is, after);
+  std::string msg = std::string("Compressed round trip of ") + type_name;
+  TEST(msg.c_str(), !lz_is || w != v || after != 12345, false);
+  if (expect_smaller)
+  {
+    msg = std::string("Compression shrinks ") + type_name;
+    TEST(msg.c_str(), lz_ss.str().size() < raw_ss.str().size() / 2, true);
+  }
+}
+
+static void test_lz_codec()
+{
+  std::cout << "Testing vsl_lz_compress/decompress\n";
+
+  unsigned seed = 12345;
+  std::vector<unsigned char> in(200000);
+  for (unsigned i = 0; i < in.size(); ++i)
+  {
+    seed = seed * 1103515245u + 12345u;
+    // noise, runs and repeated phrases
+    if (i < 50000) in[i] = (unsigned char)(seed >> 16);
+    else if (i < 100000) in[i] = (unsigned char)(i / 1000);
+    else in[i] = (unsigned char)("abcdefg"[(i * 7) % 5]);
+  }
+
+  bool ok = true;
+  std::size_t sizes[] = { 0, 1, 4, 5, 13, 100, 65536, 70000, 200000 };
+  for (unsigned s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+  {
+    for (unsigned start = 0; start + sizes[s] <= in.size() && start < 150000; start += 49999)
+    {
+      const std::size_t n = sizes[s];
+      std::vector<unsigned char> packed(vsl_lz_compress_bound(n));
+      std::size_t m = vsl_lz_compress(&in[start], n, &packed[0], packed.size());
+      std::vector<unsigned char> out(n + 1, 0);
+      ok = ok && m > 0 && vsl_lz_decompress(&packed[0], m, &out[0], n) &&
+           std::equal(out.begin(), out.begin() + n, in.begin() + start);
+      // Too small or too large an output must fail.
+      if (n > 0)
+        ok = ok && !vsl_lz_decompress(&packed[0], m, &out[0], n - 1);
+      ok = ok && !vsl_lz_decompress(&packed[0], m, &out[0], n + 1);
+    }
+  }
+  TEST("Round trips", ok, true);
+
+  std::vector<unsigned char> packed(vsl_lz_compress_bound(in.size()));
+  std::size_t m = vsl_lz_compress(&in[0], in.size(), &packed[0], packed.size());
+  TEST("Compresses repeated data", m < in.size() / 2, true);
+  TEST("Fails when out of space", vsl_lz_compress(&in[0], in.size(), &packed[0], m / 2), 0);
+
+  // Corrupt the stream in many ways; decoding must stay in bounds.
+  // There is no checksum, so damaged literals still decode.
+  std::vector<unsigned char> out(in.size());
+  for (unsigned i = 0; i < 200; ++i)
+  {
+    std::vector<unsigned char> bad(packed.begin(), packed.begin() + m);
+    bad[(i * 7919u) % m] ^= (unsigned char)(1 + i);
+    vsl_lz_decompress(&bad[0], m, &out[0], out.size());
+  }
+  bool all_failed = true;
+  for (unsigned t = 1; t < 100; ++t)
+    all_failed = all_failed && !vsl_lz_decompress(&packed[0], m - t, &out[0], out.size());
+  TEST("Truncated streams are rejected", all_failed, true);
+
+  std::vector<unsigned char> s(12), u(12);
+  for (unsigned i = 0; i < 12; ++i) s[i] = (unsigned char)i;
+  vsl_byte_shuffle(&s[0], &u[0], 4, 3);
+  TEST("Shuffle", u[0] == 0 && u[1] == 4 && u[2] == 8 && u[3] == 1 && u[11] == 11, true);
+  std::vector<unsigned char> t(12);
+  vsl_byte_unshuffle(&u[0], &t[0], 4, 3);
+  TEST("Unshuffle", t == s, true);
+}
+
+void test_block_compress_io()
+{
+  std::cout << "***********************************\n"
+           << " Testing compressed vsl block io\n"
+           << "***********************************\n";
+
+  test_lz_codec();
+
+  // Large enough for several chunks
+  const unsigned n = 700000;
+  std::vector<float> vf(n);
+  std::vector<double> vd(n);
+  std::vector<int> vi(n);
+  std::vector<unsigned short> vus(n);
+  std::vector<long> vl(n);
+  std::vector<unsigned char> vuc(n);
+  std::vector<signed char> vsc(n);
+  for (unsigned i = 0; i < n; ++i)
+  {
+    vf[i] = (i % 1000 < 600) ? 0.0f : 0.25f * (i % 37);
+    vd[i] = 1.0 + (i / 5000) * 0.5;
+    vi[i] = int(i / 100) - 3000;
+    vus[i] = (unsigned short)(i / 64);
+    vl[i] = (i % 3 == 0) ? -long(i / 1000) : 7;
+    vuc[i] = (unsigned char)((i / 256) & 0x0f);
+    vsc[i] = (signed char)(-(int)(i % 5));
+  }
+  test_round_trip("float", vf, true);
+  test_round_trip("double", vd, true);
+  test_round_trip("int", vi, true);
+  test_round_trip("unsigned short", vus, true);
+  test_round_trip("long", vl, true);
+  test_round_trip("unsigned char", vuc, true);
+  test_round_trip("signed char", vsc, true);
+
+  // Incompressible data is stored, and small blocks are left raw.
+  std::vector<unsigned> noise(100000);
+  unsigned seed = 1;
+  for (unsigned i = 0; i < noise.size(); ++i)
+    noise[i] = seed = seed * 1664525u + 1013904223u;
+  test_round_trip("random unsigned", noise, false);
+  std::vector<double> tiny(10, 3.5);
+  test_round_trip("small double", tiny, false);
+
+  // Damaged compressed blocks set the stream's error state.
+  {
+    std::ostringstream ss;
+    {
+      vsl_b_ostream os(&ss);
+      os.set_block_format(vsl_b_block_lz);
+      vsl_block_binary_write(os, &vi[0], n);
+    }
+    std::string data = ss.str();
+    std::cout << "Corrupting compressed data, expect error messages\n";
+    // flag, version, then codec
+    data[std::size_t(vsl_b_ostream::header_length) + 2] = 7;
+    std::istringstream iss(data);
+    vsl_b_istream is(&iss);
+    std::vector<int> w(n);
+    vsl_block_binary_read(is, &w[0], n);
+    TEST("Unknown codec is detected", !is, true);
+
+    std::istringstream iss2(ss.str().substr(0, ss.str().size() / 2));
+    vsl_b_istream is2(&iss2);
+    vsl_block_binary_read(is2, &w[0], n);
+    TEST("Truncated compressed block is detected", !is2, true);
+
+    std::istringstream iss3(ss.str());
+    vsl_b_istream is3(&iss3);
+    std::vector<int> w3(n - 1);
+    vsl_block_binary_read(is3, &w3[0], n - 1);
+    TEST("Wrong length is detected", !is3, true);
+  }
+
+  // Chunk sizes in a damaged header must not be trusted for allocation.
+  {
+    std::ostringstream ss;
+    {
+      vsl_b_ostream os(&ss);
+      vsl_b_write(os, (signed char)2); // compressed block marker
+      vsl_b_write(os, (short)1);
+      vsl_b_write(os, (unsigned char)1);
+      vsl_b_write(os, std::size_t(1000));             // values
+      vsl_b_write(os, std::size_t(-1) / 4);           // values per chunk
+      vsl_b_write(os, std::size_t(-1) / 2);           // raw chunk length
+      vsl_b_write(os, std::size_t(-1) / 2);           // stored chunk length
+    }
+    std::cout << "Reading huge chunk lengths, expect error messages\n";
+    std::vector<double> wd(1000);
+    std::istringstream iss(ss.str());
+    vsl_b_istream is(&iss);
+    vsl_block_binary_read(is, &wd[0], wd.size());
+    TEST("Huge chunk of doubles is rejected", !is, true);
+
+    std::vector<int> wi(1000);
+    std::istringstream iss2(ss.str());
+    vsl_b_istream is2(&iss2);
+    vsl_block_binary_read(is2, &wi[0], wi.size());
+    TEST("Huge chunk of ints is rejected", !is2, true);
+  }
+}
+
+TESTMAIN(test_block_compress_io);
@@ -15,6 +15,7 @@ DECLARE(test_string_io);
 DECLARE(test_vector_io);
 DECLARE(test_vlarge_block_io);
 DECLARE(test_block_rle_io);
+DECLARE(test_block_compress_io);
 
 void
 register_tests()
@@ -34,6 +35,7 @@ register_tests()
   REGISTER(test_vector_io);
   REGISTER(test_vlarge_block_io);
   REGISTER(test_block_rle_io);
+  REGISTER(test_block_compress_io);
 }
 
 DEFINE_MAIN;
@@ -0,0 +1,74 @@
+// This is core/vsl/tests/vsl_test_io_timings.cxx
+// \brief Compare read speeds of the vsl binary input streams.
+//
+// Writes a file of many small scalars followed by a large block of doubles,
+// then reads it back through a plain std::ifstream wrapped in a vsl_b_istream,
+// through vsl_b_ifstream and through vsl_b_imapped_fstream.
+//
+// Usage: vsl_test_io_timings [n_scalars [n_doubles]]
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <ctime>
+#include <cstdlib>
+#include <vcl_compiler.h>
+#include <vsl/vsl_binary_io.h>
+#include <vsl/vsl_block_binary.h>
+#include <vpl/vpl.h>
+
+static const char* filename = "vsl_test_io_timings.bvl.tmp";
+
+static double read_all(vsl_b_istream& bfs, unsigned n_scalars, unsigned n_doubles)
+{
+  std::clock_t t0 = std::clock();
+  long sum = 0;
+  for (unsigned k = 0; k < n_scalars; ++k)
+  {
+    int x = 0;
+    vsl_b_read(bfs, x);
+    sum += x;
+  }
+  std::vector<double> d(n_doubles);
+  vsl_block_binary_read(bfs, &d[0], n_doubles);
+  double t = double(std::clock() - t0) / CLOCKS_PER_SEC;
+  if (!bfs || sum == 42)
+    std::cerr << "Read failed\n";
+  return t;
+}
+
+int main(int argc, char** argv)
+{
+  unsigned n_scalars = argc > 1 ? std::atoi(argv[1]) : 4000000;
+  unsigned n_doubles = argc > 2 ? std::atoi(argv[2]) : 8000000;
+
+  std::clock_t t0 = std::clock();
+  {
+    vsl_b_ofstream bfs(filename);
+    for (unsigned k = 0; k < n_scalars; ++k)
+      vsl_b_write(bfs, int(k * 2654435761u));
+    std::vector<double> d(n_doubles, 1.5);
+    vsl_block_binary_write(bfs, &d[0], n_doubles);
+  }
+  std::cout << "Write (vsl_b_ofstream):            "
+            << double(std::clock() - t0) / CLOCKS_PER_SEC << "s\n";
+
+  {
+    std::ifstream ifs(filename, std::ios::in | std::ios::binary);
+    vsl_b_istream bfs(&ifs);
+    std::cout << "Read  (std::ifstream):             "
+              << read_all(bfs, n_scalars, n_doubles) << "s\n";
+  }
+  {
+    vsl_b_ifstream bfs(filename);
+    std::cout << "Read  (vsl_b_ifstream):            "
+              << read_all(bfs, n_scalars, n_doubles) << "s\n";
+  }
+  {
+    vsl_b_imapped_fstream bfs(filename);
+    std::cout << "Read  (vsl_b_imapped_fstream" << (bfs.is_mapped() ? "):     " : ", unmapped):")
+              << read_all(bfs, n_scalars, n_doubles) << "s\n";
+  }
+
+  vpl_unlink(filename);
+  return 0;
+}
@@ -7,18 +7,70 @@
 // \file
 // \brief Functions to perform consistent binary IO within vsl
 // \author Tim Cootes and Ian Scott
+//
+// Scalars are read and written straight from the stream buffer, rather than
+// with std::istream::get() and std::ostream::write().  Those construct a
+// sentry on every call, which for a value of a few bytes costs more than
+// the copy itself.
 
 #include <vcl_cassert.h>
 #include <vcl_compiler.h>
 #include <vsl/vsl_binary_explicit_io.h>
 
+#if defined(_WIN32)
+# include <windows.h>
+# define VSL_MAPPED_FILE_WIN32 1
+#elif defined(__unix__) || defined(__unix) || defined(__APPLE__)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+# define VSL_MAPPED_FILE_POSIX 1
+#endif
+
+//: Write n bytes to the stream buffer of os.
+static inline void vsl_b_write_bytes(vsl_b_ostream& os, const void* p, std::streamsize n)
+{
+  std::ostream& s = os.os();
+  if (!s.good())
+    s.setstate(std::ios::failbit);
+  else if (s.rdbuf()->sputn(static_cast<const char*>(p), n) != n)
+    s.setstate(std::ios::badbit);
+}
+
+//: Read n bytes from the stream buffer of is.
+// Sets failbit and eofbit if there are fewer, as std::istream::read() would.
+static inline void vsl_b_read_bytes(vsl_b_istream& is, void* p, std::streamsize n)
+{
+  std::istream& s = is.is();
+  if (!s.good())
+    s.setstate(std::ios::failbit);
+  else if (s.rdbuf()->sgetn(static_cast<char*>(p), n) != n)
+    s.setstate(std::ios::failbit | std::ios::eofbit);
+}
+
+//: Read a byte from the stream buffer of is, as std::istream::get() would.
+static inline int vsl_b_read_byte(vsl_b_istream& is)
+{
+  std::istream& s = is.is();
+  if (!s.good())
+  {
+    s.setstate(std::ios::failbit);
+    return std::char_traits<char>::eof();
+  }
+  const int c = s.rdbuf()->sbumpc();
+  if (c == std::char_traits<char>::eof())
+    s.setstate(std::ios::failbit | std::ios::eofbit);
+  return c;
+}
+
 template <typename TYPE>
 void  local_vsl_b_write(vsl_b_ostream& os, const TYPE n)
 {
   const size_t MAX_INT_BUFFER_LENGTH = VSL_MAX_ARBITRARY_INT_BUFFER_LENGTH(sizeof(TYPE));
   unsigned char buf[ MAX_INT_BUFFER_LENGTH ] = {0};
   const std::size_t nbytes = (std::size_t)vsl_convert_to_arbitrary_length(&n, buf);
-  os.os().write((char*)buf, nbytes );
+  vsl_b_write_bytes(os, buf, nbytes);
 }
 
 template <typename TYPE>
@@ -29,7 +81,7 @@ void local_vsl_b_read(vsl_b_istream &is,TYPE & n)
   unsigned char *ptr=buf;
   do
   {
-    vsl_b_read(is, *ptr);
+    *ptr = static_cast<unsigned char>(vsl_b_read_byte(is));
     const std::ptrdiff_t ptr_offset_from_begin = ptr-buf;
     if (ptr_offset_from_begin >= (std::ptrdiff_t)MAX_INT_BUFFER_LENGTH)
     {
@@ -79,57 +131,55 @@ MACRO_MAKE_INTEGER_READ_WRITE(std::size_t);
 
 void vsl_b_write(vsl_b_ostream& os, char n )
 {
-  os.os().write( reinterpret_cast<char *>(&n), sizeof( n ) );
+  vsl_b_write_bytes(os, &n, sizeof( n ) );
 }
 
 void vsl_b_read(vsl_b_istream &is, char& n )
 {
-  const int value = is.is().get();
+  const int value = vsl_b_read_byte(is);
   n = static_cast<signed char>(value);
 }
 
 void vsl_b_write(vsl_b_ostream& os, signed char n )
 {
-  os.os().write( reinterpret_cast<char *>(&n), sizeof( n ) );
+  vsl_b_write_bytes(os, &n, sizeof( n ) );
 }
 
 void vsl_b_read(vsl_b_istream &is, signed char& n )
 {
-  const int value = is.is().get();
+  const int value = vsl_b_read_byte(is);
   n = static_cast<signed char>(value);
 }
 
 
 void vsl_b_write(vsl_b_ostream& os,unsigned char n )
 {
-  os.os().write( reinterpret_cast<char *>(&n), 1 );
+  vsl_b_write_bytes(os, &n, 1 );
 }
 
 void vsl_b_read(vsl_b_istream &is,unsigned char& n )
 {
-  const int value = is.is().get();
+  const int value = vsl_b_read_byte(is);
   n = static_cast<unsigned char>(value);
 }
 
 
+// The characters are stored one byte each, so are copied in one go.
 void vsl_b_write(vsl_b_ostream& os, const std::string& str )
 {
-    std::string::const_iterator          it;
-
     vsl_b_write(os,(short)str.length());
-    for ( it = str.begin(); it != str.end(); ++it )
-        vsl_b_write(os,*it);
+    if (!str.empty())
+        vsl_b_write_bytes(os, str.data(), str.length());
 }
 
 void vsl_b_read(vsl_b_istream &is, std::string& str )
 {
-    std::string::iterator                it;
     std::string::size_type               length;
 
     vsl_b_read(is,length);
     str.resize( length );
-    for ( it = str.begin(); it != str.end(); ++it )
-        vsl_b_read(is,*it);
+    if (length > 0)
+        vsl_b_read_bytes(is, &str[0], length);
 }
 
 // deprecated in favour of std::string version.
@@ -173,24 +223,24 @@ void vsl_b_read(vsl_b_istream &is,bool& b)
 void vsl_b_write(vsl_b_ostream& os,float n )
 {
   vsl_swap_bytes(reinterpret_cast<char *>(&n), sizeof( n ) );
-  os.os().write( reinterpret_cast<char *>(&n), sizeof( n ) );
+  vsl_b_write_bytes(os, &n, sizeof( n ) );
 }
 
 void vsl_b_read(vsl_b_istream &is,float& n )
 {
-  is.is().read( reinterpret_cast<char *>(&n), sizeof( n ) );
+  vsl_b_read_bytes(is, &n, sizeof( n ) );
   vsl_swap_bytes(reinterpret_cast<char *>(&n), sizeof( n ) );
 }
 
 void vsl_b_write(vsl_b_ostream& os,double n )
 {
   vsl_swap_bytes(reinterpret_cast<char *>(&n), sizeof( n ) );
-  os.os().write( reinterpret_cast<char *>(&n), sizeof( n ) );
+  vsl_b_write_bytes(os, &n, sizeof( n ) );
 }
 
 void vsl_b_read(vsl_b_istream &is,double& n )
 {
-  is.is().read( reinterpret_cast<char *>(&n), sizeof( n ) );
+  vsl_b_read_bytes(is, &n, sizeof( n ) );
   vsl_swap_bytes(reinterpret_cast<char *>(&n), sizeof( n ) );
 }
 
@@ -205,7 +255,7 @@ static const unsigned short vsl_magic_number_part_2=0x472b;
 // The stream (os) must be open (i.e. ready to be written to) so that the
 // IO version number can be written by this constructor.
 // User is responsible for deleting os after deleting the adaptor
-vsl_b_ostream::vsl_b_ostream(std::ostream *o_s): os_(o_s)
+vsl_b_ostream::vsl_b_ostream(std::ostream *o_s): os_(o_s), block_format_(vsl_b_block_raw)
 {
   assert(os_ != 0);
   vsl_b_write_uint_16(*this, version_no_);
@@ -306,6 +356,49 @@ int vsl_b_ostream::set_serialisation_other_data
 }
 
 
+const std::size_t vsl_b_fstream_buffer_size = 1 << 20;
+
+//: A std::ofstream writing through a buffer of vsl_b_fstream_buffer_size bytes.
+class vsl_b_ofstream_file : public std::ofstream
+{
+ public:
+  vsl_b_ofstream_file(const char *filename, std::ios::openmode mode)
+  : buf_(new char[vsl_b_fstream_buffer_size])
+  {
+    // must be done before the file is opened
+    rdbuf()->pubsetbuf(buf_, vsl_b_fstream_buffer_size);
+    open(filename, mode);
+  }
+
+  // Flush the buffer before deleting it.
+  ~vsl_b_ofstream_file() { close(); delete [] buf_; }
+
+ private:
+  char* buf_;
+};
+
+//: A std::ifstream reading through a buffer of vsl_b_fstream_buffer_size bytes.
+class vsl_b_ifstream_file : public std::ifstream
+{
+ public:
+  vsl_b_ifstream_file(const char *filename, std::ios::openmode mode)
+  : buf_(new char[vsl_b_fstream_buffer_size])
+  {
+    rdbuf()->pubsetbuf(buf_, vsl_b_fstream_buffer_size);
+    open(filename, mode);
+  }
+
+  ~vsl_b_ifstream_file() { close(); delete [] buf_; }
+
+ private:
+  char* buf_;
+};
+
+std::ofstream* vsl_b_ofstream::open(const char *filename, std::ios::openmode mode)
+{
+  return new vsl_b_ofstream_file(filename, mode | std::ios::binary);
+}
+
 //: destructor.
 vsl_b_ofstream::~vsl_b_ofstream()
 {
@@ -449,6 +542,11 @@ int vsl_b_istream::set_serialisation_other_data
 }
 
 
+std::ifstream* vsl_b_ifstream::open(const char *filename, std::ios::openmode mode)
+{
+  return new vsl_b_ifstream_file(filename, mode | std::ios::binary);
+}
+
 //: destructor.so that it can be overloaded
 vsl_b_ifstream::~vsl_b_ifstream()
 {
@@ -463,6 +561,167 @@ void vsl_b_ifstream::close()
   clear_serialisation_records();
 }
 
+//: A read-only stream buffer whose get area is the whole of a mapped file.
+class vsl_mapped_streambuf : public std::streambuf
+{
+ public:
+  vsl_mapped_streambuf() : data_(VXL_NULLPTR), size_(0) {}
+  ~vsl_mapped_streambuf() { unmap(); }
+
+  //: Map the file. Returns false if it cannot be mapped.
+  bool map(const char *filename);
+  void unmap();
+  bool is_mapped() const { return data_ != VXL_NULLPTR; }
+
+ protected:
+  virtual pos_type seekoff(off_type off, std::ios::seekdir dir,
+                           std::ios::openmode which = std::ios::in);
+  virtual pos_type seekpos(pos_type pos, std::ios::openmode which = std::ios::in)
+  { return seekoff(off_type(pos), std::ios::beg, which); }
+
+ private:
+  char* data_;
+  std::size_t size_;
+};
+
+bool vsl_mapped_streambuf::map(const char *filename)
+{
+  unmap();
+#if VSL_MAPPED_FILE_POSIX
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && st.st_size > 0 &&
+      vxl_uint_64(st.st_size) <= vxl_uint_64(std::size_t(-1)))
+  {
+    const std::size_t n = std::size_t(st.st_size);
+    void* p = ::mmap(VXL_NULLPTR, n, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED)
+    {
+#ifdef MADV_SEQUENTIAL
+      ::madvise(p, n, MADV_SEQUENTIAL);
+#endif
+      data_ = static_cast<char*>(p);
+      size_ = n;
+    }
+  }
+  ::close(fd); // the mapping keeps the file open
+#elif VSL_MAPPED_FILE_WIN32
+  HANDLE file = ::CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, VXL_NULLPTR,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, VXL_NULLPTR);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER file_size;
+  if (::GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 &&
+      vxl_uint_64(file_size.QuadPart) <= vxl_uint_64(std::size_t(-1)))
+  {
+    HANDLE mapping = ::CreateFileMappingA(file, VXL_NULLPTR, PAGE_READONLY, 0, 0, VXL_NULLPTR);
+    if (mapping)
+    {
+      void* p = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      if (p)
+      {
+        data_ = static_cast<char*>(p);
+        size_ = std::size_t(file_size.QuadPart);
+      }
+      ::CloseHandle(mapping); // the view keeps the mapping open
+    }
+  }
+  ::CloseHandle(file);
+#else
+  (void)filename;
+#endif
+  // The data is never written, since there is no put area and putback
+  // is only allowed of the character already there.
+  if (data_)
+    setg(data_, data_, data_ + size_);
+  return data_ != VXL_NULLPTR;
+}
+
+void vsl_mapped_streambuf::unmap()
+{
+  if (!data_)
+    return;
+#if VSL_MAPPED_FILE_POSIX
+  ::munmap(data_, size_);
+#elif VSL_MAPPED_FILE_WIN32
+  ::UnmapViewOfFile(data_);
+#endif
+  data_ = VXL_NULLPTR;
+  size_ = 0;
+  setg(VXL_NULLPTR, VXL_NULLPTR, VXL_NULLPTR);
+}
+
+std::streambuf::pos_type
+vsl_mapped_streambuf::seekoff(off_type off, std::ios::seekdir dir,
+                              std::ios::openmode which)
+{
+  if (!data_ || !(which & std::ios::in))
+    return pos_type(off_type(-1));
+  off_type base = 0;
+  if (dir == std::ios::cur)
+    base = off_type(gptr() - eback());
+  else if (dir == std::ios::end)
+    base = off_type(size_);
+  const off_type pos = base + off;
+  if (pos < 0 || pos > off_type(size_))
+    return pos_type(off_type(-1));
+  setg(data_, data_ + pos, data_ + size_);
+  return pos_type(pos);
+}
+
+//: A std::istream reading a mapped file.
+class vsl_mapped_istream : public std::istream
+{
+ public:
+  vsl_mapped_istream() : std::istream(VXL_NULLPTR) {}
+
+  bool map(const char *filename)
+  {
+    if (!buf_.map(filename))
+      return false;
+    rdbuf(&buf_); // also clears the state
+    return true;
+  }
+
+  void unmap() { buf_.unmap(); }
+
+ private:
+  vsl_mapped_streambuf buf_;
+};
+
+std::istream* vsl_b_imapped_fstream::open(const char *filename)
+{
+  vsl_mapped_istream* s = new vsl_mapped_istream;
+  if (s->map(filename))
+    return s;
+  delete s;
+  return new vsl_b_ifstream_file(filename, std::ios::in | std::ios::binary);
+}
+
+vsl_b_imapped_fstream::~vsl_b_imapped_fstream()
+{
+  if (is_) delete is_;
+}
+
+bool vsl_b_imapped_fstream::is_mapped() const
+{
+  return dynamic_cast<vsl_mapped_istream*>(is_) != VXL_NULLPTR;
+}
+
+//: Unmap (or close) the file
+void vsl_b_imapped_fstream::close()
+{
+  assert(is_ != 0);
+  vsl_mapped_istream* ms = dynamic_cast<vsl_mapped_istream*>(is_);
+  if (ms)
+    ms->unmap();
+  else
+    ((std::ifstream *)is_)->close();
+  clear_serialisation_records();
+}
+
 
 
 //: Test to see if a stream really is a binary vsl file.
@@ -12,7 +12,16 @@
 // vsl_print_summary(std::ostream& os, bool b)
 // for basic types to ensure that templated classes
 // vsl_print_summaries can work with all types
-
+//
+// \verbatim
+//  Modifications
+//   Scalars are read and written straight from the stream buffer; file
+//   streams have a large buffer; vsl_b_imapped_fstream reads a mapped file;
+//   serialisation records are hashed when C++11 is available.
+//   vsl_b_ostream::set_block_format() selects compressed block output.
+// \endverbatim
+
+#include <cstddef>
 #include <iosfwd>
 #include <string>
 #include <fstream>
@@ -21,6 +30,22 @@
 #include <vcl_compiler.h>
 #include <vxl_config.h>
 #include <vsl/vsl_export.h>
+#if VXL_FULLCXX11SUPPORT
+# include <unordered_map>
+#endif
+
+//: How vsl_block_binary_write() stores blocks of fundamental types.
+// Readers recognise both formats, so this only needs setting on output.
+// Streams containing compressed blocks cannot be read by versions of vsl
+// that predate the compressed format.
+enum vsl_b_block_format
+{
+  //: Store the values uncompressed (the default.)
+  vsl_b_block_raw = 0,
+  //: Compress large blocks in independent chunks, using vsl_lz_compress().
+  vsl_b_block_lz = 1
+};
+
 //: A binary output adaptor for any std::ostream
 // Currently the main use of this is to encourage streams to be opened
 // in binary mode (ie. without CR/LF conversion)
@@ -90,10 +115,19 @@ class vsl_b_ostream
   // the first real data item.
   static VSL_EXPORT const std::streamoff header_length;
 
+  //: Set how vsl_block_binary_write() stores blocks of fundamental types.
+  void set_block_format(vsl_b_block_format f) { block_format_ = f; }
+
+  //: How vsl_block_binary_write() stores blocks of fundamental types.
+  vsl_b_block_format block_format() const { return block_format_; }
+
  protected:
   //: The member stream
   std::ostream *os_;
 
+  //: How blocks of fundamental types are stored.
+  vsl_b_block_format block_format_;
+
   // Design notes: IMS
   // I used to think that a pointer and class name were needed to identify an
   // object. This is true if class your_class{my_class A}; your_class B;
@@ -106,8 +140,13 @@ class vsl_b_ostream
   // different pointer sizes.
 
   //: The type of the serialisation records
+#if VXL_FULLCXX11SUPPORT
+  typedef std::unordered_map<void *, std::pair<unsigned long, int> >
+    serialisation_records_type;
+#else
   typedef std::map<void *, std::pair<unsigned long, int>, std::less<void *> >
     serialisation_records_type;
+#endif
 
   //: The serialisation records
   // Records a pointer, a unique identifier, and an integer
@@ -120,6 +159,7 @@ class vsl_b_ostream
 
 
 //: An adapter for a std::ofstream to make it suitable for binary IO
+// The file is written through a buffer of vsl_b_fstream_buffer_size bytes.
 class vsl_b_ofstream: public vsl_b_ostream
 {
  public:
@@ -127,13 +167,13 @@ class vsl_b_ofstream: public vsl_b_ostream
   // The adapter will delete the internal stream automatically on destruction.
   vsl_b_ofstream(const std::string &filename,
                  std::ios::openmode mode = std::ios::out | std::ios::trunc):
-    vsl_b_ostream(new std::ofstream(filename.c_str(), mode | std::ios::binary)) {}
+    vsl_b_ostream(open(filename.c_str(), mode)) {}
 
   //: Create this adaptor from a file.
   // The adapter will delete the internal stream automatically on destruction.
   vsl_b_ofstream(const char *filename,
                  std::ios::openmode mode = std::ios::out | std::ios::trunc) :
-    vsl_b_ostream(new std::ofstream(filename, mode | std::ios::binary)) {}
+    vsl_b_ostream(open(filename, mode)) {}
 
   //: Virtual destructor.
   virtual ~vsl_b_ofstream();
@@ -141,8 +181,15 @@ class vsl_b_ofstream: public vsl_b_ostream
 
   //: Close the stream
   void close();
+
+ private:
+  //: A std::ofstream with a large buffer, open on the file in binary mode.
+  static std::ofstream* open(const char *filename, std::ios::openmode mode);
 };
 
+//: Size of the buffers of vsl_b_ofstream and vsl_b_ifstream, in bytes.
+extern VSL_EXPORT const std::size_t vsl_b_fstream_buffer_size;
+
 
 
 
@@ -218,8 +265,13 @@ class vsl_b_istream
   std::istream *is_;
 
   //: The type of the serialisation records.
+#if VXL_FULLCXX11SUPPORT
+  typedef std::unordered_map<unsigned long, std::pair<void *, int> >
+    serialisation_records_type;
+#else
   typedef std::map<unsigned long, std::pair<void *, int>, std::less<unsigned long> >
     serialisation_records_type;
+#endif
 
   //: The serialisation records,
   // The record takes a unique identifier of the object (which would be
@@ -239,19 +291,53 @@ class vsl_b_ifstream: public vsl_b_istream
   //: Create this adaptor from a file.
   // The adapter will delete the stream automatically on destruction.
   vsl_b_ifstream(const std::string &filename, std::ios::openmode mode = std::ios::in):
-    vsl_b_istream(new std::ifstream(filename.c_str(),
-    mode | std::ios::binary)) {}
+    vsl_b_istream(open(filename.c_str(), mode)) {}
 
   //: Create this adaptor from a file.
   // The adapter will delete the stream automatically on destruction.
   vsl_b_ifstream(const char *filename, std::ios::openmode mode = std::ios::in):
-    vsl_b_istream(new std::ifstream(filename, mode | std::ios::binary)) {}
+    vsl_b_istream(open(filename, mode)) {}
 
   //: Virtual destructor.so that it can be overloaded
   virtual ~vsl_b_ifstream();
 
   //: Close the stream
   void close();
+
+ private:
+  //: A std::ifstream with a large buffer, open on the file in binary mode.
+  static std::ifstream* open(const char *filename, std::ios::openmode mode);
+};
+
+//: An adapter reading a binary IO file through a memory mapping.
+// Every read is a copy from the mapped file, without a system call per
+// buffer full, which makes loading large files faster.  The file may be
+// seeked in like any other.  If the file cannot be mapped it is read
+// like a vsl_b_ifstream.
+class vsl_b_imapped_fstream: public vsl_b_istream
+{
+ public:
+  //: Create this adaptor from a file.
+  // The adapter will delete the stream automatically on destruction.
+  vsl_b_imapped_fstream(const std::string &filename):
+    vsl_b_istream(open(filename.c_str())) {}
+
+  //: Create this adaptor from a file.
+  // The adapter will delete the stream automatically on destruction.
+  vsl_b_imapped_fstream(const char *filename):
+    vsl_b_istream(open(filename)) {}
+
+  virtual ~vsl_b_imapped_fstream();
+
+  //: True if the file is mapped, rather than read through a buffer.
+  bool is_mapped() const;
+
+  //: Unmap (or close) the file
+  void close();
+
+ private:
+  //: A stream reading the mapped file, or else a std::ifstream.
+  static std::istream* open(const char *filename);
 };
 
 //: Write bool to vsl_b_ostream
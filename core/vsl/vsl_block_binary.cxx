@@ -5,12 +5,21 @@
 // \author Ian Scott, ISBE Manchester, Feb 2003
 
 #include <cstddef>
+#include <cstring>
 #include <new>
 #include <algorithm>
 #include <cstdlib>
+#include <vector>
 #include "vsl_block_binary.h"
+#include "vsl_block_compress.h"
 #include <vcl_compiler.h>
 #include <vcl_cassert.h>
+#if VXL_FULLCXX11SUPPORT
+# include <atomic>
+# include <condition_variable>
+# include <mutex>
+# include <thread>
+#endif
 
 struct vsl_block_t
 {
@@ -42,6 +51,19 @@ vsl_block_t allocate_up_to(std::size_t nbytes)
 }
 
 
+static void vsl_block_binary_specialisation_error(vsl_b_istream &is, bool specialised)
+{
+  std::cerr << "I/O ERROR: vsl_block_binary_read()\n";
+  if (specialised)
+    std::cerr << "           Data was saved using unspecialised slow form and is being loaded\n"
+             << "           using specialised fast form.\n\n";
+  else
+    std::cerr << "           Data was saved using specialised fast form and is being loaded\n"
+             << "           using unspecialised slow form.\n\n";
+
+  is.is().clear(std::ios::badbit); // Set an unrecoverable IO error on stream
+}
+
 //: Error checking.
 void vsl_block_binary_read_confirm_specialisation(vsl_b_istream &is, bool specialised)
 {
@@ -49,19 +71,435 @@ void vsl_block_binary_read_confirm_specialisation(vsl_b_istream &is, bool specia
   bool b;
   vsl_b_read(is, b);
   if (b != specialised)
+    vsl_block_binary_specialisation_error(is, specialised);
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+// Compressed blocks.
+//
+// The flag that normally says whether a block was written by the specialised
+// functions takes the value vsl_block_lz_marker instead, and is followed by
+//   short version, unsigned char codec, std::size_t nelems,
+//   std::size_t elements per chunk,
+// and then for each chunk
+//   std::size_t raw size, std::size_t stored size, stored bytes.
+// The raw bytes of a chunk are the swapped and byte-shuffled values for
+// floating point types, the arbitrary length encoding for integer types,
+// and the values themselves for bytes. A chunk whose stored size equals its
+// raw size did not compress and is stored as is.
+//
+// Chunks are independent, so they are compressed and decompressed on
+// several threads, a few chunks per thread at a time.
+
+//: Flag value marking a compressed block (true is stored as -1.)
+static const signed char vsl_block_lz_marker = 2;
+
+//: Blocks smaller than this are never compressed.
+static const std::size_t vsl_block_lz_min_bytes = 4096;
+
+//: Aim for chunks of about this many values' bytes.
+static const std::size_t vsl_block_lz_chunk_bytes = 1 << 20;
+
+static const unsigned char vsl_block_lz_codec = 1;
+
+// Tags selecting how values are converted to and from raw chunk bytes.
+struct vsl_block_float_tag {};
+struct vsl_block_int_tag {};
+struct vsl_block_byte_tag {};
+
+template <class T>
+static void vsl_block_encode(vsl_block_float_tag, const T* src, std::size_t n,
+                             std::vector<unsigned char>& raw, std::vector<unsigned char>& tmp)
+{
+  raw.resize(sizeof(T) * n);
+  tmp.resize(sizeof(T) * n);
+  vsl_swap_bytes_to_buffer((const char *)src, (char *)&tmp[0], sizeof(T), n);
+  vsl_byte_shuffle(&tmp[0], &raw[0], sizeof(T), n);
+}
+
+template <class T>
+static bool vsl_block_decode(vsl_block_float_tag, const unsigned char* raw, std::size_t raw_len,
+                             T* dst, std::size_t n)
+{
+  if (raw_len != sizeof(T) * n) return false;
+  vsl_byte_unshuffle(raw, (unsigned char *)dst, sizeof(T), n);
+  vsl_swap_bytes((char *)dst, sizeof(T), n);
+  return true;
+}
+
+//: True if n values could have been encoded as raw_len bytes.
+template <class T>
+static bool vsl_block_raw_len_ok(vsl_block_float_tag, const T*, std::size_t raw_len, std::size_t n)
+{
+  return raw_len == sizeof(T) * n;
+}
+
+template <class T>
+static void vsl_block_encode(vsl_block_int_tag, const T* src, std::size_t n,
+                             std::vector<unsigned char>& raw, std::vector<unsigned char>& )
+{
+  raw.resize(VSL_MAX_ARBITRARY_INT_BUFFER_LENGTH(sizeof(T)) * n);
+  raw.resize(vsl_convert_to_arbitrary_length(src, &raw[0], n));
+}
+
+template <class T>
+static bool vsl_block_decode(vsl_block_int_tag, const unsigned char* raw, std::size_t raw_len,
+                             T* dst, std::size_t n)
+{
+  // The last byte of each value has its top bit set.
+  std::size_t elems = 0;
+  for (std::size_t i = 0; i < raw_len; ++i)
+    elems += raw[i] >> 7;
+  return elems == n && raw[raw_len-1] >> 7 &&
+         vsl_convert_from_arbitrary_length(raw, dst, n) == raw_len;
+}
+
+//: True if n values could have been encoded as raw_len bytes.
+template <class T>
+static bool vsl_block_raw_len_ok(vsl_block_int_tag, const T*, std::size_t raw_len, std::size_t n)
+{
+  return raw_len >= n && raw_len <= VSL_MAX_ARBITRARY_INT_BUFFER_LENGTH(sizeof(T)) * n;
+}
+
+template <class T>
+static void vsl_block_encode(vsl_block_byte_tag, const T* src, std::size_t n,
+                             std::vector<unsigned char>& raw, std::vector<unsigned char>& )
+{
+  raw.resize(n);
+  std::memcpy(&raw[0], src, n);
+}
+
+template <class T>
+static bool vsl_block_decode(vsl_block_byte_tag, const unsigned char* raw, std::size_t raw_len,
+                             T* dst, std::size_t n)
+{
+  if (raw_len != n) return false;
+  std::memcpy(dst, raw, n);
+  return true;
+}
+
+//: True if n values could have been encoded as raw_len bytes.
+template <class T>
+static bool vsl_block_raw_len_ok(vsl_block_byte_tag, const T*, std::size_t raw_len, std::size_t n)
+{
+  return raw_len == n;
+}
+
+//: One chunk of a compressed block.
+struct vsl_block_chunk
+{
+  std::vector<unsigned char> raw;
+  std::vector<unsigned char> stored;
+  std::vector<unsigned char> tmp;
+  std::size_t raw_len;
+  bool ok;
+};
+
+//: Work on chunk k of the current group.
+struct vsl_block_job
+{
+  virtual ~vsl_block_job() {}
+  virtual void run(std::size_t k) = 0;
+};
+
+//: Number of threads worth using on the chunks of a block.
+static std::size_t vsl_block_n_threads()
+{
+#if VXL_FULLCXX11SUPPORT
+  unsigned n = std::thread::hardware_concurrency();
+  return n > 0 ? n : 1;
+#else
+  return 1;
+#endif
+}
+
+#if VXL_FULLCXX11SUPPORT
+//: Worker threads kept for the groups of chunks of every block.
+// Only one job runs at a time.  The chunks are handed out through an atomic
+// counter, so faster threads simply take more of them.
+class vsl_block_pool
+{
+ public:
+  vsl_block_pool() : job_(VXL_NULLPTR), n_(0), n_helpers_(0), n_finished_(0),
+                     generation_(0), stop_(false), next_(0) {}
+
+  ~vsl_block_pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::size_t t = 0; t < workers_.size(); ++t)
+      workers_[t].join();
+  }
+
+  //: Run the job using the calling thread and n_helpers workers.
+  // Returns false, having done nothing, if the pool is already in use.
+  bool run(vsl_block_job& job, std::size_t n, std::size_t n_helpers)
+  {
+    std::unique_lock<std::mutex> busy(busy_, std::try_to_lock);
+    if (!busy.owns_lock())
+      return false;
+    while (workers_.size() < n_helpers)
+      workers_.push_back(std::thread(&vsl_block_pool::work, this,
+                                     workers_.size(), generation_));
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job_ = &job;
+      n_ = n;
+      next_ = 0;
+      n_helpers_ = n_helpers;
+      n_finished_ = 0;
+      ++generation_;
+    }
+    wake_.notify_all();
+
+    take_chunks(job, n);
+
+    // The job must stay alive until every helper has stopped using it.
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (n_finished_ < n_helpers_)
+      done_.wait(lock);
+    job_ = VXL_NULLPTR;
+    return true;
+  }
+
+ private:
+  void take_chunks(vsl_block_job& job, std::size_t n)
   {
-    std::cerr << "I/O ERROR: vsl_block_binary_read()\n";
-    if (specialised)
-      std::cerr << "           Data was saved using unspecialised slow form and is being loaded\n"
-               << "           using specialised fast form.\n\n";
+    for (std::size_t k = next_++; k < n; k = next_++)
+      job.run(k);
+  }
+
+  //: Help with each job started after generation seen.
+  void work(std::size_t id, unsigned long seen)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+      while (!stop_ && generation_ == seen)
+        wake_.wait(lock);
+      if (stop_)
+        return;
+      seen = generation_;
+      if (id >= n_helpers_)
+        continue;
+      vsl_block_job* job = job_;
+      const std::size_t n = n_;
+      lock.unlock();
+      take_chunks(*job, n);
+      lock.lock();
+      if (++n_finished_ == n_helpers_)
+        done_.notify_one();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex busy_;   // held while a job runs
+  std::mutex mutex_;  // guards the members below
+  std::condition_variable wake_, done_;
+  vsl_block_job* job_;
+  std::size_t n_;
+  std::size_t n_helpers_;
+  std::size_t n_finished_;
+  unsigned long generation_;
+  bool stop_;
+  std::atomic<std::size_t> next_;
+};
+#endif
+
+//: Call job.run(k) for k in [0,n), on several threads if possible.
+static void vsl_block_run(vsl_block_job& job, std::size_t n)
+{
+#if VXL_FULLCXX11SUPPORT
+  static vsl_block_pool pool;
+  std::size_t n_threads = std::min(n, vsl_block_n_threads());
+  if (n_threads > 1 && pool.run(job, n, n_threads - 1))
+    return;
+#endif
+  for (std::size_t k = 0; k < n; ++k)
+    job.run(k);
+}
+
+template <class T, class Tag>
+struct vsl_block_encode_job : public vsl_block_job
+{
+  const T* begin;
+  std::size_t nelems;
+  std::size_t per_chunk;
+  std::size_t first_chunk;
+  std::vector<vsl_block_chunk>* chunks;
+
+  virtual void run(std::size_t k) VXL_OVERRIDE
+  {
+    vsl_block_chunk& c = (*chunks)[k];
+    std::size_t i0 = (first_chunk + k) * per_chunk;
+    vsl_block_encode(Tag(), begin + i0, std::min(per_chunk, nelems - i0), c.raw, c.tmp);
+    c.raw_len = c.raw.size();
+    c.stored.resize(vsl_lz_compress_bound(c.raw_len));
+    std::size_t n = vsl_lz_compress(&c.raw[0], c.raw_len, &c.stored[0], c.stored.size());
+    if (n == 0 || n >= c.raw_len)
+      c.stored.swap(c.raw);
     else
-      std::cerr << "           Data was saved using specialised fast form and is being loaded\n"
-               << "           using unspecialised slow form.\n\n";
+      c.stored.resize(n);
+  }
+};
+
+template <class T, class Tag>
+struct vsl_block_decode_job : public vsl_block_job
+{
+  T* begin;
+  std::size_t nelems;
+  std::size_t per_chunk;
+  std::size_t first_chunk;
+  std::vector<vsl_block_chunk>* chunks;
+
+  virtual void run(std::size_t k) VXL_OVERRIDE
+  {
+    vsl_block_chunk& c = (*chunks)[k];
+    std::size_t i0 = (first_chunk + k) * per_chunk;
+    const unsigned char* raw = &c.stored[0];
+    if (c.stored.size() != c.raw_len)
+    {
+      c.raw.resize(c.raw_len);
+      c.ok = vsl_lz_decompress(&c.stored[0], c.stored.size(), &c.raw[0], c.raw_len);
+      if (!c.ok) return;
+      raw = &c.raw[0];
+    }
+    c.ok = vsl_block_decode(Tag(), raw, c.raw_len, begin + i0, std::min(per_chunk, nelems - i0));
+  }
+};
+
+//: Write a block of values in compressed chunks.
+template <class T, class Tag>
+static void vsl_block_binary_write_lz(vsl_b_ostream &os, const T* begin, std::size_t nelems, Tag)
+{
+  vsl_b_write(os, vsl_block_lz_marker);
+  short version = 1;
+  vsl_b_write(os, version);
+  vsl_b_write(os, vsl_block_lz_codec);
+  vsl_b_write(os, nelems);
+  const std::size_t per_chunk = std::max<std::size_t>(1, vsl_block_lz_chunk_bytes / sizeof(T));
+  vsl_b_write(os, per_chunk);
+
+  const std::size_t n_chunks = (nelems + per_chunk - 1) / per_chunk;
+  const std::size_t group = 2 * vsl_block_n_threads();
+  std::vector<vsl_block_chunk> chunks(std::min(group, n_chunks));
+
+  vsl_block_encode_job<T, Tag> job;
+  job.begin = begin;
+  job.nelems = nelems;
+  job.per_chunk = per_chunk;
+  job.chunks = &chunks;
+  for (job.first_chunk = 0; job.first_chunk < n_chunks; job.first_chunk += chunks.size())
+  {
+    std::size_t n = std::min(chunks.size(), n_chunks - job.first_chunk);
+    vsl_block_run(job, n);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      vsl_b_write(os, chunks[k].raw_len);
+      vsl_b_write(os, chunks[k].stored.size());
+      os.os().write((const char *)&chunks[k].stored[0], chunks[k].stored.size());
+    }
+  }
+}
+
+static void vsl_block_binary_lz_corrupt(vsl_b_istream &is)
+{
+  std::cerr << "\nI/O ERROR: vsl_block_binary_read()"
+           << " Corrupted compressed data stream\n";
+  is.is().clear(std::ios::badbit); // Set an unrecoverable IO error on stream
+}
 
+//: Read a block of values written by vsl_block_binary_write_lz(), after its marker.
+template <class T, class Tag>
+static void vsl_block_binary_read_lz(vsl_b_istream &is, T* begin, std::size_t nelems, Tag)
+{
+  short ver;
+  vsl_b_read(is, ver);
+  if (!is) return;
+  if (ver != 1)
+  {
+    std::cerr << "I/O ERROR: vsl_block_binary_read()\n"
+             << "           Unknown compressed block version number "<< ver << '\n';
     is.is().clear(std::ios::badbit); // Set an unrecoverable IO error on stream
+    return;
+  }
+  unsigned char codec;
+  std::size_t n, per_chunk;
+  vsl_b_read(is, codec);
+  vsl_b_read(is, n);
+  vsl_b_read(is, per_chunk);
+  if (!is) return;
+  if (codec != vsl_block_lz_codec || n != nelems || per_chunk == 0)
+  {
+    vsl_block_binary_lz_corrupt(is);
+    return;
+  }
+
+  const std::size_t n_chunks = nelems / per_chunk + (nelems % per_chunk ? 1 : 0);
+  const std::size_t group = 2 * vsl_block_n_threads();
+  std::vector<vsl_block_chunk> chunks(std::min(group, n_chunks));
+
+  vsl_block_decode_job<T, Tag> job;
+  job.begin = begin;
+  job.nelems = nelems;
+  job.per_chunk = per_chunk;
+  job.chunks = &chunks;
+  for (job.first_chunk = 0; job.first_chunk < n_chunks; job.first_chunk += chunks.size())
+  {
+    std::size_t n = std::min(chunks.size(), n_chunks - job.first_chunk);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      std::size_t stored_len;
+      vsl_b_read(is, chunks[k].raw_len);
+      vsl_b_read(is, stored_len);
+      if (!is) return;
+      // Check the lengths against the values this chunk holds before
+      // allocating anything, since a corrupt header could ask for any size.
+      const std::size_t i0 = (job.first_chunk + k) * per_chunk;
+      if (!vsl_block_raw_len_ok(Tag(), begin, chunks[k].raw_len, std::min(per_chunk, nelems - i0)) ||
+          stored_len == 0 || stored_len > chunks[k].raw_len)
+      {
+        vsl_block_binary_lz_corrupt(is);
+        return;
+      }
+      chunks[k].stored.resize(stored_len);
+      is.is().read((char *)&chunks[k].stored[0], stored_len);
+      if (!is) return;
+    }
+    vsl_block_run(job, n);
+    for (std::size_t k = 0; k < n; ++k)
+      if (!chunks[k].ok)
+      {
+        vsl_block_binary_lz_corrupt(is);
+        return;
+      }
   }
 }
 
+//: Read the flag at the start of a specialised block.
+// \return true if the block is compressed.
+static bool vsl_block_binary_read_is_lz(vsl_b_istream &is)
+{
+  if (!is) return false;
+  signed char flag;
+  vsl_b_read(is, flag);
+  if (!is) return false;
+  if (flag == 0)
+    vsl_block_binary_specialisation_error(is, true);
+  return flag == vsl_block_lz_marker;
+}
+
+//: True if this block should be written compressed.
+static inline bool vsl_block_binary_use_lz(const vsl_b_ostream &os, std::size_t nbytes)
+{
+  return os.block_format() == vsl_b_block_lz && nbytes >= vsl_block_lz_min_bytes;
+}
+
 
 /////////////////////////////////////////////////////////////////////////
 
@@ -69,8 +507,17 @@ void vsl_block_binary_read_confirm_specialisation(vsl_b_istream &is, bool specia
 template <class T>
 void vsl_block_binary_write_float_impl(vsl_b_ostream &os, const T* begin, std::size_t nelems)
 {
+  if (vsl_block_binary_use_lz(os, sizeof(T) * nelems))
+  {
+    vsl_block_binary_write_lz(os, begin, nelems, vsl_block_float_tag());
+    return;
+  }
   vsl_b_write(os, true); // Error check that this is a specialised version
 
+#if VXL_LITTLE_ENDIAN
+  // The data is already in the stored byte order, so needs no copy.
+  os.os().write((const char *)begin, sizeof(T) * nelems);
+#else
   const std::size_t wanted = sizeof(T) * nelems;
   vsl_block_t block = allocate_up_to(wanted);
 
@@ -92,6 +539,7 @@ void vsl_block_binary_write_float_impl(vsl_b_ostream &os, const T* begin, std::s
 #else
   std::free(block.ptr);
 #endif
+#endif // VXL_LITTLE_ENDIAN
 }
 
 //: Read a block of floats from a vsl_b_ostream
@@ -100,7 +548,11 @@ void vsl_block_binary_read_float_impl(vsl_b_istream &is, T* begin, std::size_t n
 {
   // There are no complications here, to deal with low memory,
   // because the byte swapping can be done in place.
-  vsl_block_binary_read_confirm_specialisation(is, true);
+  if (vsl_block_binary_read_is_lz(is))
+  {
+    vsl_block_binary_read_lz(is, begin, nelems, vsl_block_float_tag());
+    return;
+  }
   if (!is) return;
   is.is().read((char*) begin, nelems*sizeof(T));
   vsl_swap_bytes((char *)begin, sizeof(T), nelems);
@@ -111,6 +563,11 @@ void vsl_block_binary_read_float_impl(vsl_b_istream &is, T* begin, std::size_t n
 template <class T>
 void vsl_block_binary_write_int_impl(vsl_b_ostream &os, const T* begin, std::size_t nelems)
 {
+  if (vsl_block_binary_use_lz(os, sizeof(T) * nelems))
+  {
+    vsl_block_binary_write_lz(os, begin, nelems, vsl_block_int_tag());
+    return;
+  }
 
   vsl_b_write(os, true); // Error check that this is a specialised version
 
@@ -171,7 +628,11 @@ void vsl_block_binary_write_int_impl(vsl_b_ostream &os, const T* begin, std::siz
 template <class T>
 void vsl_block_binary_read_int_impl(vsl_b_istream &is, T* begin, std::size_t nelems)
 {
-  vsl_block_binary_read_confirm_specialisation(is, true);
+  if (vsl_block_binary_read_is_lz(is))
+  {
+    vsl_block_binary_read_lz(is, begin, nelems, vsl_block_int_tag());
+    return;
+  }
   if (!is) return;
   std::size_t nbytes;
   vsl_b_read(is, nbytes);
@@ -256,6 +717,11 @@ void vsl_block_binary_read_int_impl(vsl_b_istream &is, T* begin, std::size_t nel
 template <class T>
 void vsl_block_binary_write_byte_impl(vsl_b_ostream &os, const T* begin, std::size_t nelems)
 {
+  if (vsl_block_binary_use_lz(os, nelems))
+  {
+    vsl_block_binary_write_lz(os, begin, nelems, vsl_block_byte_tag());
+    return;
+  }
   vsl_b_write(os, true); // Error check that this is a specialised version
   os.os().write((char*) begin, nelems);
 }
@@ -266,7 +732,11 @@ void vsl_block_binary_read_byte_impl(vsl_b_istream &is, T* begin, std::size_t ne
 {
   // There are no complications here, to deal with low memory,
   // because the load is done in place.
-  vsl_block_binary_read_confirm_specialisation(is, true);
+  if (vsl_block_binary_read_is_lz(is))
+  {
+    vsl_block_binary_read_lz(is, begin, nelems, vsl_block_byte_tag());
+    return;
+  }
   if (!is) return;
   is.is().read((char*) begin, nelems);
 }
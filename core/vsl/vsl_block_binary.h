@@ -5,6 +5,11 @@
 // \file
 // \brief Set of functions to do binary IO on a block of values.
 // \author Ian Scott, ISBE Manchester, Feb 2003
+//
+// Blocks of fundamental types larger than a few kilobytes are compressed,
+// in chunks that are handled on several threads, when the output stream
+// has vsl_b_ostream::set_block_format(vsl_b_block_lz). Readers detect
+// compressed blocks automatically.
 
 #include <vsl/vsl_binary_io.h>
 #include <vsl/vsl_binary_explicit_io.h>
@@ -0,0 +1,211 @@
+// This is core/vsl/vsl_block_compress.cxx
+//:
+// \file
+// \brief Fast lossless compression of byte buffers, used for compressed blocks.
+
+#include <cstring>
+#include <vector>
+#include "vsl_block_compress.h"
+#include <vcl_compiler.h>
+#include <vxl_config.h>
+
+static const unsigned vsl_lz_hash_bits = 14;
+static const std::size_t vsl_lz_min_match = 4;
+static const std::size_t vsl_lz_max_offset = 65535;
+
+static inline vxl_uint_32 vsl_lz_read32(const unsigned char* p)
+{
+  vxl_uint_32 v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+static inline unsigned vsl_lz_hash(vxl_uint_32 v)
+{
+  return (v * 2654435761u) >> (32 - vsl_lz_hash_bits);
+}
+
+//: Write the extra bytes of a length that did not fit in its 4-bit token field.
+static inline unsigned char* vsl_lz_put_length(unsigned char* op, std::size_t v)
+{
+  for (; v >= 255; v -= 255)
+    *op++ = 255;
+  *op++ = (unsigned char)v;
+  return op;
+}
+
+//: Write one sequence of literals, followed by a match unless match_len is 0.
+// \return VXL_NULLPTR if the sequence does not fit before oend.
+static unsigned char* vsl_lz_put_sequence(unsigned char* op, unsigned char* oend,
+                                          const unsigned char* literals, std::size_t lit_len,
+                                          std::size_t offset, std::size_t match_len)
+{
+  std::size_t ml = match_len ? match_len - vsl_lz_min_match : 0;
+  std::size_t worst = 1 + lit_len + lit_len/255 + 1 + (match_len ? 2 + ml/255 + 1 : 0);
+  if (std::size_t(oend - op) < worst)
+    return VXL_NULLPTR;
+
+  unsigned char* token = op++;
+  *token = (unsigned char)((lit_len < 15 ? lit_len : 15) << 4);
+  if (lit_len >= 15)
+    op = vsl_lz_put_length(op, lit_len - 15);
+  std::memcpy(op, literals, lit_len);
+  op += lit_len;
+  if (!match_len)
+    return op;
+
+  *op++ = (unsigned char)(offset & 0xff);
+  *op++ = (unsigned char)(offset >> 8);
+  *token |= (unsigned char)(ml < 15 ? ml : 15);
+  if (ml >= 15)
+    op = vsl_lz_put_length(op, ml - 15);
+  return op;
+}
+
+std::size_t vsl_lz_compress(const unsigned char* src, std::size_t n,
+                            unsigned char* dst, std::size_t capacity)
+{
+  unsigned char* op = dst;
+  unsigned char* const oend = dst + capacity;
+  const unsigned char* ip = src;
+  const unsigned char* anchor = src;
+  const unsigned char* const iend = src + n;
+
+  if (n > vsl_lz_min_match)
+  {
+    std::vector<vxl_uint_32> table(std::size_t(1) << vsl_lz_hash_bits, 0);
+    const unsigned char* const ilimit = iend - vsl_lz_min_match;
+    unsigned misses = 0;
+    ++ip;
+    while (ip <= ilimit)
+    {
+      vxl_uint_32 v = vsl_lz_read32(ip);
+      unsigned h = vsl_lz_hash(v);
+      const unsigned char* ref = src + table[h];
+      table[h] = vxl_uint_32(ip - src);
+      if (ref >= ip || std::size_t(ip - ref) > vsl_lz_max_offset || vsl_lz_read32(ref) != v)
+      {
+        // Skip ahead faster through data that does not compress.
+        ip += 1 + (misses++ >> 6);
+        continue;
+      }
+      misses = 0;
+
+      while (ip > anchor && ref > src && ip[-1] == ref[-1])
+      {
+        --ip;
+        --ref;
+      }
+      std::size_t len = vsl_lz_min_match;
+      while (ip + len < iend && ip[len] == ref[len])
+        ++len;
+
+      op = vsl_lz_put_sequence(op, oend, anchor, ip - anchor, ip - ref, len);
+      if (!op) return 0;
+      ip += len;
+      anchor = ip;
+      if (ip <= ilimit)
+        table[vsl_lz_hash(vsl_lz_read32(ip - 2))] = vxl_uint_32(ip - 2 - src);
+    }
+  }
+
+  op = vsl_lz_put_sequence(op, oend, anchor, iend - anchor, 0, 0);
+  return op ? std::size_t(op - dst) : 0;
+}
+
+//: Read the extra bytes of a length, adding them to len.
+static inline bool vsl_lz_get_length(const unsigned char*& ip, const unsigned char* iend,
+                                     std::size_t& len)
+{
+  unsigned char b;
+  do
+  {
+    if (ip >= iend) return false;
+    b = *ip++;
+    len += b;
+  } while (b == 255);
+  return true;
+}
+
+bool vsl_lz_decompress(const unsigned char* src, std::size_t n,
+                       unsigned char* dst, std::size_t dst_size)
+{
+  const unsigned char* ip = src;
+  const unsigned char* const iend = src + n;
+  unsigned char* op = dst;
+  unsigned char* const oend = dst + dst_size;
+
+  while (true)
+  {
+    if (ip >= iend) return false;
+    unsigned token = *ip++;
+
+    std::size_t lit_len = token >> 4;
+    if (lit_len == 15 && !vsl_lz_get_length(ip, iend, lit_len))
+      return false;
+    if (lit_len > std::size_t(iend - ip) || lit_len > std::size_t(oend - op))
+      return false;
+    std::memcpy(op, ip, lit_len);
+    op += lit_len;
+    ip += lit_len;
+
+    // The last sequence has no match.
+    if (ip == iend)
+      return op == oend;
+
+    if (iend - ip < 2) return false;
+    std::size_t offset = ip[0] | (std::size_t(ip[1]) << 8);
+    ip += 2;
+    if (offset == 0 || offset > std::size_t(op - dst))
+      return false;
+
+    std::size_t len = token & 15;
+    if (len == 15 && !vsl_lz_get_length(ip, iend, len))
+      return false;
+    len += vsl_lz_min_match;
+    if (len > std::size_t(oend - op))
+      return false;
+
+    const unsigned char* match = op - offset;
+    if (offset >= len)
+      std::memcpy(op, match, len);
+    else // overlapping copy repeats the last offset bytes
+      for (std::size_t i = 0; i < len; ++i)
+        op[i] = match[i];
+    op += len;
+  }
+}
+
+void vsl_byte_shuffle(const unsigned char* src, unsigned char* dst,
+                      unsigned elem_size, std::size_t nelems)
+{
+  if (elem_size == 1)
+  {
+    std::memcpy(dst, src, nelems);
+    return;
+  }
+  for (unsigned b = 0; b < elem_size; ++b)
+  {
+    const unsigned char* s = src + b;
+    unsigned char* d = dst + b * nelems;
+    for (std::size_t i = 0; i < nelems; ++i, s += elem_size)
+      d[i] = *s;
+  }
+}
+
+void vsl_byte_unshuffle(const unsigned char* src, unsigned char* dst,
+                        unsigned elem_size, std::size_t nelems)
+{
+  if (elem_size == 1)
+  {
+    std::memcpy(dst, src, nelems);
+    return;
+  }
+  for (unsigned b = 0; b < elem_size; ++b)
+  {
+    const unsigned char* s = src + b * nelems;
+    unsigned char* d = dst + b;
+    for (std::size_t i = 0; i < nelems; ++i, d += elem_size)
+      *d = s[i];
+  }
+}
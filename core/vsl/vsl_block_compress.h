@@ -0,0 +1,50 @@
+// This is core/vsl/vsl_block_compress.h
+#ifndef vsl_block_compress_h_
+#define vsl_block_compress_h_
+//:
+// \file
+// \brief Fast lossless compression of byte buffers, used for compressed blocks.
+//
+// vsl_lz_compress() produces a stream of LZ77 sequences in the same layout
+// as an LZ4 block: a token byte holding the literal and match lengths,
+// extra length bytes, the literals, and a 16-bit little-endian offset.
+// It trades compression ratio for speed, and is mainly useful on data with
+// repeated values, such as sparse volumes or images with flat regions.
+//
+// vsl_byte_shuffle() groups the n-th bytes of each element together, which
+// makes arrays of slowly varying floats much more compressible.
+//
+// These functions operate on plain memory; see vsl_b_ostream::set_block_format()
+// for how to use them when serialising blocks of values.
+
+#include <cstddef>
+#include <vcl_compiler.h>
+
+//: The largest compressed size of n bytes.
+inline std::size_t vsl_lz_compress_bound(std::size_t n)
+{
+  return n + n/255 + 16;
+}
+
+//: Compress n bytes from src into dst.
+// \return the compressed size, or 0 if it would exceed capacity.
+// A capacity of vsl_lz_compress_bound(n) is always sufficient.
+std::size_t vsl_lz_compress(const unsigned char* src, std::size_t n,
+                            unsigned char* dst, std::size_t capacity);
+
+//: Decompress n bytes from src into exactly dst_size bytes at dst.
+// \return false if the input is corrupt, or does not decode to dst_size bytes.
+// Never reads or writes outside the given buffers.
+bool vsl_lz_decompress(const unsigned char* src, std::size_t n,
+                       unsigned char* dst, std::size_t dst_size);
+
+//: Copy nelems elements of elem_size bytes from src to dst, grouped by byte position.
+// All the first bytes come first, then all the second bytes, etc.
+void vsl_byte_shuffle(const unsigned char* src, unsigned char* dst,
+                      unsigned elem_size, std::size_t nelems);
+
+//: Undo vsl_byte_shuffle().
+void vsl_byte_unshuffle(const unsigned char* src, unsigned char* dst,
+                        unsigned elem_size, std::size_t nelems);
+
+#endif // vsl_block_compress_h_